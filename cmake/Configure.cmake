@@ -107,6 +107,10 @@ if (ZLIB_FOUND)
     set(HAVE_LIBZ 1)
 endif()
 
+if (CMAKE_USE_PTHREADS_INIT)
+    set(HAVE_LIBPTHREAD 1)
+endif()
+
 file(APPEND ${AUTOCONFIG_SRC} "
 /* Define to 1 if you have the ANSI C header files. */
 #cmakedefine STDC_HEADERS 1
@@ -123,6 +127,9 @@ file(APPEND ${AUTOCONFIG_SRC} "
 /* Define to 1 if you have libpng. */
 #cmakedefine HAVE_LIBPNG 1
 
+/* Define to 1 if you have libpthread. */
+#cmakedefine HAVE_LIBPTHREAD 1
+
 /* Define to 1 if you have libtiff. */
 #cmakedefine HAVE_LIBTIFF 1
 
@@ -48,6 +48,7 @@
 static const char *tests[] = {
                               "alphaops_reg",
                               "alphaxform_reg",
+                              "bandio_reg",
                               "bilateral2_reg",
                               "binarize_reg",
                               "blackwhite_reg",
@@ -59,19 +60,26 @@ static const char *tests[] = {
                               "colorize_reg",
                               "colormask_reg",
                               "colorquant_reg",
+                              "colorquantpar_reg",
                               "colorspace_reg",
+                              "colorspacepar_reg",
                               "compare_reg",
+                              "conncomp2_reg",
                               "convolve_reg",
+                              "convolvepar_reg",
+                              "correlscore_reg",
                               "dewarp_reg",
                          /*   "distance_reg", */
                               "dna_reg",
                               "dwamorph1_reg",
+                              "dwaplan_reg",
                               "enhance_reg",
                          /*   "files_reg",  */
                               "findcorners_reg",
                               "findpattern_reg",
                               "fpix1_reg",
                               "fpix2_reg",
+                              "g4codec_reg",
                               "genfonts_reg",
 #if HAVE_LIBGIF
                               "gifio_reg",
@@ -80,6 +88,7 @@ static const char *tests[] = {
                               "hardlight_reg",
                               "insert_reg",
                               "ioformats_reg",
+                              "jbclass_reg",
 #if HAVE_LIBJP2K
                               "jp2kio_reg",
 #endif  /* HAVE_LIBJP2K */
@@ -87,6 +96,8 @@ static const char *tests[] = {
                               "kernel_reg",
                               "label_reg",
                               "maze_reg",
+                              "morphseqband_reg",
+                              "multipage_reg",
                               "multitype_reg",
                               "nearline_reg",
                               "newspaper_reg",
@@ -95,7 +106,9 @@ static const char *tests[] = {
                               "paintmask_reg",
                               "pdfseg_reg",
                               "pixa2_reg",
+                              "pixarena_reg",
                               "pixserial_reg",
+                              "pixview_reg",
                               "pngio_reg",
                               "pnmio_reg",
                               "projection_reg",
@@ -103,21 +116,26 @@ static const char *tests[] = {
                               "psioseg_reg",
                               "pta_reg",
                               "rankbin_reg",
+                              "rankfilter_reg",
                               "rankhisto_reg",
                               "rasteropip_reg",
+                              "refcount_reg",
                               "rotateorth_reg",
                               "rotate1_reg",
                               "rotate2_reg",
+                              "rotatepar_reg",
                               "scale_reg",
                               "seedspread_reg",
                               "selio_reg",
                               "shear1_reg",
                               "shear2_reg",
                               "skew_reg",
+                              "skewscore_reg",
                               "splitcomp_reg",
                               "subpixel_reg",
                               "texturefill_reg",
                               "threshnorm_reg",
+                              "tileparallel_reg",
                               "translate_reg",
                               "warper_reg",
 #if HAVE_LIBWEBP
@@ -0,0 +1,295 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   bandio_reg.c
+ *
+ *   Tests the band reader and writer:
+ *     (1) Each band, including its overlap rows, must be identical
+ *         to the same rows of the image read by pixRead().  This is
+ *         tested for png and jpeg of all depths, with and without
+ *         colormaps, and for several band heights and overlaps.
+ *     (2) Operations done band by band and written with the band
+ *         writer must give the same result as on the whole image.
+ *     (3) Images read and written by bands must be unchanged.
+ */
+
+#include "allheaders.h"
+
+static const char *FileNames[] = {"rabi.png",          /* 1 bpp */
+                                  "weasel2.4c.png",    /* 2 bpp cmap */
+                                  "weasel4.png",       /* 4 bpp gray */
+                                  "dreyfus8.png",      /* 8 bpp cmap */
+                                  "test16.png",        /* 16 bpp gray */
+                                  "church.png",        /* rgb */
+                                  "books_logo.png",    /* rgba */
+                                  "test-gray-alpha.png",  /* gray + alpha */
+                                  "/tmp/lept/bandio/cmap1.png",  /* 1 bpp cmap */
+                                  "karen8.jpg",        /* 8 bpp jpeg */
+                                  "test24.jpg"};       /* rgb jpeg */
+
+static const l_int32  BandHeights[] = {1, 37, 64};
+static const l_int32  Overlaps[] = {2, 0, 9};
+
+static l_int32 CompareBands(const char *fname, l_int32 bandh,
+                            l_int32 overlap);
+static PIX *ProcessByBands(const char *filein, const char *fileout,
+                           l_int32 format, l_int32 bandh, l_int32 overlap,
+                           l_int32 hout, l_int32 type);
+static PIX *ProcessBand(PIX *pixs, l_int32 type);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, nfiles, nbad;
+PIX          *pixs, *pix1, *pix2;
+PIXCMAP      *cmap;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    lept_mkdir("lept/bandio");
+
+        /* Make a 1 bpp png with a colormap */
+    pix1 = pixRead("rabi.png");
+    pixs = pixScaleToSize(pix1, 400, 0);
+    pixDestroy(&pix1);
+    cmap = pixcmapCreate(1);
+    pixcmapAddColor(cmap, 255, 255, 255);
+    pixcmapAddColor(cmap, 0, 0, 0);
+    pixSetColormap(pixs, cmap);
+    pixWrite("/tmp/lept/bandio/cmap1.png", pixs, IFF_PNG);
+    pixDestroy(&pixs);
+
+        /* Bands must match the image read in one piece */
+    nfiles = sizeof(FileNames) / sizeof(char *);
+    for (i = 0; i < nfiles; i++) {
+        for (j = 0; j < 3; j++) {
+            nbad = CompareBands(FileNames[i], BandHeights[j], Overlaps[j]);
+            regTestCompareValues(rp, 0, nbad, 0.0);  /* 0 - 32 */
+        }
+    }
+
+        /* Threshold by bands */
+    pixs = pixRead("karen8.jpg");
+    pix1 = pixThresholdToBinary(pixs, 128);
+    pix2 = ProcessByBands("karen8.jpg", "/tmp/lept/bandio/thresh.png",
+                          IFF_PNG, 50, 0, pixGetHeight(pixs), 0);
+    regTestComparePix(rp, pix1, pix2);  /* 33 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Block convolution by bands, with enough overlap */
+    pix1 = pixBlockconv(pixs, 5, 5);
+    pix2 = ProcessByBands("karen8.jpg", "/tmp/lept/bandio/conv.png",
+                          IFF_PNG, 40, 6, pixGetHeight(pixs), 1);
+    regTestComparePix(rp, pix1, pix2);  /* 34 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pixs);
+
+        /* Reduction by 4 to gray, with band height a multiple of 4 */
+    pixs = pixRead("rabi.png");
+    pix1 = pixScaleToGray4(pixs);
+    pix2 = ProcessByBands("rabi.png", "/tmp/lept/bandio/scale.png",
+                          IFF_PNG, 256, 0, pixGetHeight(pixs) / 4, 2);
+    regTestComparePix(rp, pix1, pix2);  /* 35 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Copy by bands: the png writer must be lossless */
+    pix1 = ProcessByBands("rabi.png", "/tmp/lept/bandio/copy1.png",
+                          IFF_PNG, 100, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pixs, pix1);  /* 36 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+    pixs = pixRead("dreyfus8.png");
+    pix1 = ProcessByBands("dreyfus8.png", "/tmp/lept/bandio/copy8.png",
+                          IFF_PNG, 33, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pixs, pix1);  /* 37 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+    pixs = pixRead("books_logo.png");
+    pix1 = ProcessByBands("books_logo.png", "/tmp/lept/bandio/copy32.png",
+                          IFF_PNG, 17, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pixs, pix1);  /* 38 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+
+        /* The jpeg written by bands must be the same as the
+         * jpeg written from the whole image */
+    pixs = pixRead("test24.jpg");
+    pixSetText(pixs, NULL);
+    pixWriteJpeg("/tmp/lept/bandio/whole24.jpg", pixs, 75, 0);
+    pix1 = pixRead("/tmp/lept/bandio/whole24.jpg");
+    pix2 = ProcessByBands("test24.jpg", "/tmp/lept/bandio/copy24.jpg",
+                          IFF_JFIF_JPEG, 64, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pix1, pix2);  /* 39 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pixs);
+
+        /* The writer rejects rows beyond the image height */
+    pixs = pixRead("weasel8.png");
+    pix1 = ProcessByBands("weasel8.png", "/tmp/lept/bandio/short.png",
+                          IFF_PNG, 10, 0, pixGetHeight(pixs) - 5, 3);
+    regTestCompareValues(rp, 1, (pix1 == NULL), 0.0);  /* 40 */
+    pixDestroy(&pixs);
+
+#if  HAVE_LIBTIFF
+        /* Write g4 tiff by bands, and read it back by bands */
+    pixs = pixRead("rabi.png");
+    pix1 = ProcessByBands("rabi.png", "/tmp/lept/bandio/copy1.tif",
+                          IFF_TIFF_G4, 100, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pixs, pix1);  /* 41 */
+    nbad = CompareBands("/tmp/lept/bandio/copy1.tif", 64, 9);
+    regTestCompareValues(rp, 0, nbad, 0.0);  /* 42 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+    pixs = pixRead("church.png");
+    pix1 = ProcessByBands("church.png", "/tmp/lept/bandio/copy32.tif",
+                          IFF_TIFF_ZIP, 20, 0, pixGetHeight(pixs), 3);
+    regTestComparePix(rp, pixs, pix1);  /* 43 */
+    nbad = CompareBands("/tmp/lept/bandio/copy32.tif", 37, 0);
+    regTestCompareValues(rp, 0, nbad, 0.0);  /* 44 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+#endif  /* HAVE_LIBTIFF */
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Returns the number of bands that differ from the image read
+     * by pixRead(), or that have the wrong position or overlap. */
+static l_int32
+CompareBands(const char  *fname,
+             l_int32      bandh,
+             l_int32      overlap)
+{
+l_int32        w, h, d, nbands, n, y, top, bot, ynext, same, nbad;
+BOX           *box;
+L_BANDREADER  *br;
+PIX           *pixs, *pixb, *pixc;
+
+    pixs = pixRead(fname);
+    if ((br = bandReaderCreate(fname, bandh, overlap)) == NULL) {
+        fprintf(stderr, "Failure to open band reader for %s\n", fname);
+        pixDestroy(&pixs);
+        return 1;
+    }
+    bandReaderGetInfo(br, &w, &h, &d, &nbands);
+    nbad = 0;
+    if (w != pixGetWidth(pixs) || h != pixGetHeight(pixs) ||
+        d != pixGetDepth(pixs))
+        nbad++;
+
+    n = 0;
+    ynext = 0;
+    while ((pixb = bandReaderNext(br, &y, &top, &bot)) != NULL) {
+        box = boxCreate(0, y - top, w, pixGetHeight(pixb));
+        pixc = pixClipRectangle(pixs, box, NULL);
+        pixEqual(pixb, pixc, &same);
+        if (!same || y != ynext || top != L_MIN(y, overlap) ||
+            bot != L_MAX(0, L_MIN(overlap, h - y - bandh))) {
+            fprintf(stderr, "Band at y = %d of %s (bandh = %d, overlap = %d)"
+                    " is wrong\n", y, fname, bandh, overlap);
+            nbad++;
+        }
+        ynext = y + bandh;
+        n++;
+        boxDestroy(&box);
+        pixDestroy(&pixb);
+        pixDestroy(&pixc);
+    }
+    if (n != nbands)
+        nbad++;
+
+    bandReaderDestroy(&br);
+    pixDestroy(&pixs);
+    return nbad;
+}
+
+
+    /* Reads @filein by bands, processes each band, writes the results
+     * to @fileout by bands, and returns the image read from @fileout.
+     * Returns null if any band could not be written. */
+static PIX *
+ProcessByBands(const char  *filein,
+               const char  *fileout,
+               l_int32      format,
+               l_int32      bandh,
+               l_int32      overlap,
+               l_int32      hout,
+               l_int32      type)
+{
+l_int32        w, top, bot, ret;
+BOX           *box;
+L_BANDREADER  *br;
+L_BANDWRITER  *bw;
+PIX           *pixb, *pix1, *pix2;
+
+    br = bandReaderCreate(filein, bandh, overlap);
+    bw = bandWriterCreate(fileout, format, hout, 75);
+    ret = 0;
+    while ((pixb = bandReaderNext(br, NULL, &top, &bot)) != NULL) {
+        pix1 = ProcessBand(pixb, type);
+        if (overlap > 0) {  /* remove the overlap */
+            w = pixGetWidth(pix1);
+            box = boxCreate(0, top, w, pixGetHeight(pix1) - top - bot);
+            pix2 = pixClipRectangle(pix1, box, NULL);
+            boxDestroy(&box);
+        } else {
+            pix2 = pixClone(pix1);
+        }
+        ret += bandWriterWrite(bw, pix2);
+        pixDestroy(&pixb);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    bandWriterDestroy(&bw);
+    bandReaderDestroy(&br);
+    if (ret)
+        return NULL;
+    return pixRead(fileout);
+}
+
+
+static PIX *
+ProcessBand(PIX     *pixs,
+            l_int32  type)
+{
+    if (type == 0)
+        return pixThresholdToBinary(pixs, 128);
+    else if (type == 1)
+        return pixBlockconv(pixs, 5, 5);
+    else if (type == 2)
+        return pixScaleToGray4(pixs);
+    else
+        return pixClone(pixs);
+}
@@ -0,0 +1,121 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   colorquantpar_reg.c
+ *
+ *   Tests that octree and median cut color quantization, and the
+ *   octcube histogram, give the same results on several threads,
+ *   and with each of the vector kernels, as on one thread without
+ *   them.  Dithered quantization is also run, because it uses
+ *   the same histograms and colormaps.
+ */
+
+#include "allheaders.h"
+
+static const char *FileNames[] = {"test24.jpg", "marge.jpg"};
+
+static PIXA *QuantizeAll(PIX *pixs, NUMA **pna);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, k, n, nthreads, same;
+NUMA         *na1, *na2;
+PIX          *pixs, *pix1, *pix2;
+PIXA         *pixa1, *pixa2;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    nthreads = l_getParallelThreads();
+    for (i = 0; i < 2; i++) {
+        pixs = pixRead(FileNames[i]);
+
+            /* The reference, on one thread without vector kernels */
+        l_setParallelThreads(1);
+        l_setSimdMode(L_SIMD_NONE);
+        pixa1 = QuantizeAll(pixs, &na1);
+        n = pixaGetCount(pixa1);
+        if (i == 0) {
+            for (j = 0; j < n; j++) {
+                pix1 = pixaGetPix(pixa1, j, L_CLONE);
+                regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 0 - 5 */
+                pixDestroy(&pix1);
+            }
+        }
+
+            /* On four threads, with each of the vector kernels */
+        l_setParallelThreads(4);
+        for (k = L_SIMD_NONE; k <= L_SIMD_NEON; k++) {
+            if (!l_simdSupported(k))
+                continue;
+            l_setSimdMode(k);
+            pixa2 = QuantizeAll(pixs, &na2);
+            for (j = 0; j < n; j++) {
+                pix1 = pixaGetPix(pixa1, j, L_CLONE);
+                pix2 = pixaGetPix(pixa2, j, L_CLONE);
+                regTestComparePix(rp, pix1, pix2);
+                pixDestroy(&pix1);
+                pixDestroy(&pix2);
+            }
+            numaSimilar(na1, na2, 0.0, &same);
+            regTestCompareValues(rp, 1, same, 0.0);
+            pixaDestroy(&pixa2);
+            numaDestroy(&na2);
+        }
+        l_setParallelThreads(nthreads);
+        l_setSimdMode(L_SIMD_AUTO);
+        pixaDestroy(&pixa1);
+        numaDestroy(&na1);
+        pixDestroy(&pixs);
+    }
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Quantizes with and without dithering, and to 4 bpp from a
+     * subsampled histogram, and makes an octcube histogram. */
+static PIXA *
+QuantizeAll(PIX    *pixs,
+            NUMA  **pna)
+{
+PIXA  *pixa;
+
+    pixa = pixaCreate(6);
+    pixaAddPix(pixa, pixOctreeColorQuant(pixs, 240, 0), L_INSERT);
+    pixaAddPix(pixa, pixOctreeColorQuant(pixs, 240, 1), L_INSERT);
+    pixaAddPix(pixa, pixMedianCutQuant(pixs, 0), L_INSERT);
+    pixaAddPix(pixa, pixMedianCutQuant(pixs, 1), L_INSERT);
+    pixaAddPix(pixa, pixMedianCutQuantGeneral(pixs, 0, 4, 16, 6, 3, 0),
+               L_INSERT);
+    pixaAddPix(pixa, pixOctreeQuantNumColors(pixs, 128, 0), L_INSERT);
+    *pna = pixOctcubeHistogram(pixs, 6, NULL);
+    return pixa;
+}
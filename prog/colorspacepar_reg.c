@@ -0,0 +1,136 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   colorspacepar_reg.c
+ *
+ *   Tests that the forward conversions from rgb to gray, hsv, yuv,
+ *   xyz and lab give the same results on several threads, and with
+ *   each of the vector kernels, as on one thread without them.
+ *   Besides two photographs, a synthetic image is used, with an odd
+ *   width and with many gray pixels and pixels with two equal
+ *   components, which are the special cases for the hue.
+ */
+
+#include "allheaders.h"
+
+static PIX *MakeHueTestImage(l_int32 w, l_int32 h);
+static PIXA *ConvertAll(PIX *pixs, void *data, FPIXA **pfpixa);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, n;
+PIX          *pixs, *pix1;
+PIXA         *pixa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    for (i = 0; i < 3; i++) {
+        if (i == 0)
+            pixs = MakeHueTestImage(253, 131);
+        else if (i == 1)
+            pixs = pixRead("test24.jpg");
+        else
+            pixs = pixRead("marge.jpg");
+
+            /* Compare on four threads, with each of the vector kernels,
+             * with the results on one thread without them */
+        regTestCompareParallel(rp, ConvertAll, pixs, NULL, 4, &pixa);
+        if (i == 1) {
+            n = pixaGetCount(pixa);
+            for (j = 0; j < n; j++) {
+                pix1 = pixaGetPix(pixa, j, L_CLONE);
+                regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 96 - 99 */
+                pixDestroy(&pix1);
+            }
+        }
+        pixaDestroy(&pixa);
+        pixDestroy(&pixs);
+    }
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Pseudo-random rgb pixels, where every third pixel is gray, and
+     * every fifth has its two largest components equal. */
+static PIX *
+MakeHueTestImage(l_int32  w,
+                 l_int32  h)
+{
+l_int32  i, j, rval, gval, bval;
+PIX     *pix;
+
+    pix = regTestMakeRandomPix(w, h, 32, 12345);
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            pixGetRGBPixel(pix, j, i, &rval, &gval, &bval);
+            if ((i * w + j) % 3 == 0) {
+                gval = bval = rval;
+            } else if ((i * w + j) % 5 == 0) {
+                if (rval < gval)
+                    rval = gval;
+                else
+                    gval = rval;
+            } else {
+                continue;
+            }
+            pixSetRGBPixel(pix, j, i, rval, gval, bval);
+        }
+    }
+    return pix;
+}
+
+
+    /* Converts to gray with two sets of weights, to hsv and to yuv,
+     * and returns these in a pixa; also converts to xyz and lab, and
+     * returns the six components in an fpixa. */
+static PIXA *
+ConvertAll(PIX     *pixs,
+           void    *data,
+           FPIXA  **pfpixa)
+{
+l_int32  i;
+FPIXA   *fpixa;
+PIXA    *pixa;
+
+    pixa = pixaCreate(4);
+    pixaAddPix(pixa, pixConvertRGBToLuminance(pixs), L_INSERT);
+    pixaAddPix(pixa, pixConvertRGBToGray(pixs, 0.5, 0.3, 0.2), L_INSERT);
+    pixaAddPix(pixa, pixConvertRGBToHSV(NULL, pixs), L_INSERT);
+    pixaAddPix(pixa, pixConvertRGBToYUV(NULL, pixs), L_INSERT);
+    *pfpixa = pixConvertRGBToXYZ(pixs);
+    fpixa = pixConvertRGBToLAB(pixs);
+    for (i = 0; i < 3; i++)
+        fpixaAddFPix(*pfpixa, fpixaGetFPix(fpixa, i, L_CLONE), L_INSERT);
+    fpixaDestroy(&fpixa);
+    return pixa;
+}
@@ -0,0 +1,225 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   conncomp2_reg.c
+ *
+ *   Tests that the union-find labeling in pixConnComp() gives the same
+ *   boxes and images, in the same order, as erasing the components
+ *   one at a time with seedfill, for 4 and 8 connectivity.
+ *
+ *   The labeling is done both serially and on strips in parallel,
+ *   which must give identical results.
+ */
+
+#include "allheaders.h"
+
+static BOXA *SeedfillConnComp(PIX *pixs, PIXA **ppixa,
+                              l_int32 connectivity);
+static l_int32 SameConnComp(BOXA *boxa1, PIXA *pixa1, BOXA *boxa2,
+                            PIXA *pixa2);
+static PIX *MakeNoisePix(l_int32 w, l_int32 h, l_int32 seed);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, k, nthreads, conn, count;
+BOX          *box;
+BOXA         *boxa1, *boxa2, *boxa3;
+PIX          *pix1, *pix2, *pixs[4];
+PIXA         *pixa1, *pixa2;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pix1 = pixRead("rabi.png");
+    box = boxCreate(450, 1000, 1013, 1181);  /* odd width */
+    pixs[0] = pixClipRectangle(pix1, box, NULL);
+    pixs[1] = pixRead("test1.png");
+    pixs[2] = MakeNoisePix(301, 277, 17);  /* dense, with merging */
+    pixDestroy(&pix1);
+    pix1 = pixRead("lucasta-frag.jpg");
+    pixs[3] = pixConvertTo1(pix1, 128);
+    pixDestroy(&pix1);
+    boxDestroy(&box);
+
+        /* Compare with seedfill, serially and in parallel (0 - 47) */
+    nthreads = l_getParallelThreads();
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 2; j++) {
+            conn = (j == 0) ? 4 : 8;
+            boxa1 = SeedfillConnComp(pixs[i], &pixa1, conn);
+            for (k = 0; k < 2; k++) {
+                l_setParallelThreads((k == 0) ? 1 : 3);
+                boxa2 = pixConnComp(pixs[i], &pixa2, conn);
+                boxa3 = pixConnComp(pixs[i], NULL, conn);
+                pixCountConnComp(pixs[i], conn, &count);
+                regTestCompareValues(rp, 1,
+                    SameConnComp(boxa1, pixa1, boxa2, pixa2), 0.0);
+                regTestCompareValues(rp, 1,
+                    SameConnComp(boxa1, NULL, boxa3, NULL), 0.0);
+                regTestCompareValues(rp, boxaGetCount(boxa1), count, 0.0);
+                boxaDestroy(&boxa2);
+                boxaDestroy(&boxa3);
+                pixaDestroy(&pixa2);
+            }
+            boxaDestroy(&boxa1);
+            pixaDestroy(&pixa1);
+        }
+    }
+    l_setParallelThreads(nthreads);
+
+        /* The components rebuild the image */
+    boxa1 = pixConnComp(pixs[0], &pixa1, 8);
+    pix1 = pixaDisplay(pixa1, pixGetWidth(pixs[0]), pixGetHeight(pixs[0]));
+    regTestComparePix(rp, pixs[0], pix1);  /* 48 */
+    pix2 = pixaDisplayRandomCmap(pixa1, pixGetWidth(pixs[0]),
+                                 pixGetHeight(pixs[0]));
+    pixDisplayWithTitle(pix2, 100, 100, "components", rp->display);
+    boxaDestroy(&boxa1);
+    pixaDestroy(&pixa1);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Empty and full images */
+    pix1 = pixCreate(100, 80, 1);
+    boxa1 = pixConnComp(pix1, &pixa1, 8);
+    regTestCompareValues(rp, 0, boxaGetCount(boxa1), 0.0);  /* 49 */
+    boxaDestroy(&boxa1);
+    pixaDestroy(&pixa1);
+    pixSetAll(pix1);
+    boxa1 = pixConnComp(pix1, NULL, 4);
+    regTestCompareValues(rp, 1, boxaGetCount(boxa1), 0.0);  /* 50 */
+    box = boxaGetBox(boxa1, 0, L_CLONE);
+    regTestCompareValues(rp, 100, box->w, 0.0);  /* 51 */
+    regTestCompareValues(rp, 80, box->h, 0.0);  /* 52 */
+    boxDestroy(&box);
+    boxaDestroy(&boxa1);
+    pixDestroy(&pix1);
+
+    for (i = 0; i < 4; i++)
+        pixDestroy(&pixs[i]);
+    return regTestCleanup(rp);
+}
+
+
+    /* Finds the components by erasing them one at a time */
+static BOXA *
+SeedfillConnComp(PIX     *pixs,
+                 PIXA   **ppixa,
+                 l_int32  connectivity)
+{
+l_int32   x, y, xstart, ystart;
+BOX      *box;
+BOXA     *boxa;
+L_STACK  *stack;
+PIX      *pix1, *pix2, *pix3, *pix4;
+PIXA     *pixa;
+
+    pix1 = pixCopy(NULL, pixs);
+    pix2 = pixCopy(NULL, pixs);
+    stack = lstackCreate(pixGetHeight(pixs));
+    stack->auxstack = lstackCreate(0);
+    boxa = boxaCreate(0);
+    pixa = pixaCreate(0);
+    xstart = ystart = 0;
+    while (nextOnPixelInRaster(pix1, xstart, ystart, &x, &y)) {
+        box = pixSeedfillBB(pix1, stack, x, y, connectivity);
+        pix3 = pixClipRectangle(pix1, box, NULL);
+        pix4 = pixClipRectangle(pix2, box, NULL);
+        pixXor(pix3, pix3, pix4);
+        pixRasterop(pix2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
+                    pix3, 0, 0);
+        pixaAddPix(pixa, pix3, L_INSERT);
+        boxaAddBox(boxa, box, L_INSERT);
+        pixDestroy(&pix4);
+        xstart = x;
+        ystart = y;
+    }
+    lstackDestroy(&stack, TRUE);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    *ppixa = pixa;
+    return boxa;
+}
+
+
+    /* Returns 1 if the boxes, and the images if given, are the same */
+static l_int32
+SameConnComp(BOXA  *boxa1,
+             PIXA  *pixa1,
+             BOXA  *boxa2,
+             PIXA  *pixa2)
+{
+l_int32  i, n, x1, y1, w1, h1, x2, y2, w2, h2, same;
+PIX     *pix1, *pix2;
+
+    n = boxaGetCount(boxa1);
+    if (boxaGetCount(boxa2) != n)
+        return 0;
+    for (i = 0; i < n; i++) {
+        boxaGetBoxGeometry(boxa1, i, &x1, &y1, &w1, &h1);
+        boxaGetBoxGeometry(boxa2, i, &x2, &y2, &w2, &h2);
+        if (x1 != x2 || y1 != y2 || w1 != w2 || h1 != h2)
+            return 0;
+        if (!pixa1) continue;
+        pix1 = pixaGetPix(pixa1, i, L_CLONE);
+        pix2 = pixaGetPix(pixa2, i, L_CLONE);
+        pixEqual(pix1, pix2, &same);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        if (!same) return 0;
+    }
+    return 1;
+}
+
+
+    /* Makes a random image that is about half ON */
+static PIX *
+MakeNoisePix(l_int32  w,
+             l_int32  h,
+             l_int32  seed)
+{
+l_int32    i, j;
+l_uint32   val;
+l_uint32  *line;
+PIX       *pix;
+
+    pix = pixCreate(w, h, 1);
+    val = seed;
+    for (i = 0; i < h; i++) {
+        line = pixGetData(pix) + i * pixGetWpl(pix);
+        for (j = 0; j < w; j++) {
+            val = 1664525 * val + 1013904223;
+            if (val & 0x80000000)
+                SET_DATA_BIT(line, j);
+        }
+    }
+    return pix;
+}
@@ -0,0 +1,206 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   convolvepar_reg.c
+ *
+ *   Tests that generic convolution of pix and fpix, with one kernel
+ *   and with separable kernels, and with and without subsampling,
+ *   gives the same results on several threads, and with each of the
+ *   vector kernels, as on one thread without them.  The image has an
+ *   odd width, and one of the kernels has its origin off center.
+ *
+ *   Also tests finding the factors of separable kernels, and that
+ *   convolution with these factors is close to that with the full
+ *   kernel.
+ */
+
+#include "allheaders.h"
+
+static PIXA *ConvolveAll(PIX *pixs, void *data, FPIXA **pfpixa);
+static l_float32 FPixMaxDiff(FPIX *fpix1, FPIX *fpix2);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, n, maxdiff;
+l_float32     fmaxdiff;
+FPIX         *fpixs, *fpix1, *fpix2;
+L_KERNEL     *kel1, *kel2, *kel3, *kel4, *kelx, *kely;
+L_KERNEL     *kels[2];
+PIX          *pixg, *pixs, *pix1, *pix2, *pix3;
+PIXA         *pixa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pixg = pixRead("test8.jpg");
+    pixs = pixScale(pixg, 0.37, 0.41);
+    pixDestroy(&pixg);
+
+        /* A gaussian kernel, and an asymmetric one off center */
+    kel1 = makeGaussianKernel(4, 5, 3.0, 1.0);
+    kel2 = kernelCreate(3, 7);
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 7; j++)
+            kernelSetElement(kel2, i, j, 0.3 * (i - 1) + 0.7 * (j - 3) -
+                             0.2 * i * j);
+    }
+    kernelSetOrigin(kel2, 0, 5);
+
+    kels[0] = kel1;
+    kels[1] = kel2;
+    for (i = 0; i < 2; i++) {
+        if (i == 0)
+            l_setConvolveSampling(1, 1);
+        else
+            l_setConvolveSampling(2, 3);
+
+            /* Compare on four threads, with each of the vector kernels,
+             * with the results on one thread without them */
+        regTestCompareParallel(rp, ConvolveAll, pixs, kels, 4, &pixa);
+        if (i == 0) {
+            n = pixaGetCount(pixa);
+            for (j = 0; j < n; j++) {
+                pix1 = pixaGetPix(pixa, j, L_CLONE);
+                regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 48 - 53 */
+                pixDestroy(&pix1);
+            }
+        }
+        pixaDestroy(&pixa);
+    }
+    l_setConvolveSampling(1, 1);
+
+        /* The gaussian kernel is separable, but kel2 is not */
+    kernelGetSeparable(kel1, &kelx, &kely);
+    regTestCompareValues(rp, 1, (kelx && kely) ? 1 : 0, 0.0);
+    kernelGetSeparable(kel2, &kel3, &kel4);
+    regTestCompareValues(rp, 1, (!kel3 && !kel4) ? 1 : 0, 0.0);
+
+        /* Convolution with the factors is close to that with kel1 */
+    pix1 = pixConvolve(pixs, kel1, 8, 1);
+    pix2 = pixConvolveSep(pixs, kelx, kely, 8, 1);
+    pix3 = pixAbsDifference(pix1, pix2);
+    pixGetExtremeValue(pix3, 1, L_SELECT_MAX, NULL, NULL, NULL, &maxdiff);
+    regTestCompareValues(rp, 0, maxdiff, 1.0);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+        /* And it is used by pixConvolve() if requested */
+    l_setConvolveSeparable(1);
+    pix2 = pixConvolve(pixs, kel1, 8, 1);
+    l_setConvolveSeparable(0);
+    pix3 = pixAbsDifference(pix1, pix2);
+    pixGetExtremeValue(pix3, 1, L_SELECT_MAX, NULL, NULL, NULL, &maxdiff);
+    regTestCompareValues(rp, 0, maxdiff, 1.0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+    fpixs = pixConvertToFPix(pixs, 1);
+    fpix1 = fpixConvolve(fpixs, kel1, 1);
+    l_setConvolveSeparable(1);
+    fpix2 = fpixConvolve(fpixs, kel1, 1);
+    l_setConvolveSeparable(0);
+    fmaxdiff = FPixMaxDiff(fpix1, fpix2);
+    regTestCompareValues(rp, 0.0, fmaxdiff, 0.001);
+    fpixDestroy(&fpixs);
+    fpixDestroy(&fpix1);
+    fpixDestroy(&fpix2);
+
+    kernelDestroy(&kel1);
+    kernelDestroy(&kel2);
+    kernelDestroy(&kelx);
+    kernelDestroy(&kely);
+    pixDestroy(&pixs);
+    return regTestCleanup(rp);
+}
+
+
+    /* Convolves pixs at 8, 16 and 32 bpp with the two kernels in data,
+     * kel1 and kel2, and with the separable kernels made from kel1 and
+     * from kel2 and kel1; returns these in a pixa, and the same for
+     * fpix in an fpixa. */
+static PIXA *
+ConvolveAll(PIX     *pixs,
+            void    *data,
+            FPIXA  **pfpixa)
+{
+FPIX      *fpixs;
+FPIXA     *fpixa;
+L_KERNEL  *kel1, *kel2, *kelx, *kely;
+PIX       *pix16, *pix32;
+PIXA      *pixa;
+
+    kel1 = ((L_KERNEL **)data)[0];
+    kel2 = ((L_KERNEL **)data)[1];
+    pix16 = pixConvert8To16(pixs, 8);
+    pix32 = pixConvert8To32(pixs);
+    pixMultConstantGray(pix32, 1000.0);
+    kelx = makeGaussianKernel(0, 6, 2.0, 1.0);
+    kely = makeGaussianKernel(3, 0, 1.5, 1.0);
+    pixa = pixaCreate(6);
+    pixaAddPix(pixa, pixConvolve(pixs, kel1, 8, 1), L_INSERT);
+    pixaAddPix(pixa, pixConvolve(pixs, kel2, 16, 0), L_INSERT);
+    pixaAddPix(pixa, pixConvolve(pix16, kel1, 16, 1), L_INSERT);
+    pixaAddPix(pixa, pixConvolve(pix32, kel2, 32, 0), L_INSERT);
+    pixaAddPix(pixa, pixConvolveSep(pix32, kelx, kely, 32, 1), L_INSERT);
+    pixaAddPix(pixa, pixConvolveSep(pixs, kel2, kel1, 8, 1), L_INSERT);
+
+    fpixs = pixConvertToFPix(pixs, 1);
+    fpixa = fpixaCreate(4);
+    fpixaAddFPix(fpixa, fpixConvolve(fpixs, kel1, 1), L_INSERT);
+    fpixaAddFPix(fpixa, fpixConvolve(fpixs, kel2, 0), L_INSERT);
+    fpixaAddFPix(fpixa, fpixConvolveSep(fpixs, kelx, kely, 1), L_INSERT);
+    fpixaAddFPix(fpixa, fpixConvolveSep(fpixs, kel2, kel1, 0), L_INSERT);
+    *pfpixa = fpixa;
+
+    fpixDestroy(&fpixs);
+    kernelDestroy(&kelx);
+    kernelDestroy(&kely);
+    pixDestroy(&pix16);
+    pixDestroy(&pix32);
+    return pixa;
+}
+
+
+    /* Returns the largest absolute difference between two fpix */
+static l_float32
+FPixMaxDiff(FPIX  *fpix1,
+            FPIX  *fpix2)
+{
+l_float32  minval, maxval;
+FPIX      *fpix;
+
+    fpix = fpixLinearCombination(NULL, fpix1, fpix2, 1.0, -1.0);
+    fpixGetMin(fpix, &minval, NULL, NULL);
+    fpixGetMax(fpix, &maxval, NULL, NULL);
+    fpixDestroy(&fpix);
+    return L_MAX(-minval, maxval);
+}
@@ -0,0 +1,249 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   correlscore_reg.c
+ *
+ *   Tests the batch correlator pixCorrelationScoreBatch(), which
+ *   scores one pix against many over a range of shifts.
+ *
+ *   The best scores and shifts must be the same as those found by
+ *   pixCorrelationScoreSimple() at each shift, with each vector
+ *   kernel (see simd.c), and with the exemplars given as views.
+ *   Also tests that pixBestCorrelation() finds the same alignment
+ *   as pixCorrelationScoreShifted() at each shift.
+ */
+
+#include "allheaders.h"
+
+static l_int32 CompareWithSimple(PIX *pix1, l_int32 area1, PIXA *pixa2,
+                                 NUMA *na2, PTA *pta2, l_int32 maxshift,
+                                 NUMA *nascore, PTA *ptashift, l_int32 *tab);
+
+    /* Number of exemplars and of test components */
+static const l_int32  NExemplars = 40;
+static const l_int32  NTests = 6;
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, n, mode, nbad, area1, area2, x, y;
+l_int32       delx, dely, bestdelx, bestdely;
+l_int32      *tab, *centtab;
+l_float32     x1, y1, x2, y2, score, maxscore;
+BOXA         *boxa;
+NUMA         *na2, *nascore, *nascorev;
+PIX          *pixs, *pix1, *pix2;
+BOX          *box;
+PIXA         *pixa, *pixac, *pixa2, *pixav;
+PTA          *pta2, *pta3, *ptashift, *ptashiftv;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    tab = makePixelSumTab8();
+    centtab = makePixelCentroidTab8();
+    pixs = pixRead("italic.png");
+    boxa = pixConnComp(pixs, &pixac, 8);
+    n = pixaGetCount(pixac);
+
+        /* The exemplars: connected components, and views of their
+         * bounding boxes in pixs (copies for the boxes that do not
+         * start on a word boundary).  The views include parts of
+         * neighboring components, so they are compared with clipped
+         * copies, which are also used for the areas and centroids. */
+    pixa2 = pixaCreate(NExemplars);
+    pixav = pixaCreate(NExemplars);
+    na2 = numaCreate(NExemplars);
+    for (i = 0; i < NExemplars; i++) {
+        pix1 = pixaGetPix(pixac, (7 * i) % n, L_CLONE);
+        pixaAddPix(pixa2, pix1, L_INSERT);
+        box = boxaGetBox(boxa, (7 * i) % n, L_CLONE);
+        pixaAddPix(pixav, pixCreateView(pixs, box), L_INSERT);
+        boxDestroy(&box);
+    }
+
+        /* Compare the batch scores with the simple correlator, for
+         * each vector kernel.  The offsets are the centroid differences,
+         * and then half-integers, to check the rounding.  If a mode is
+         * not supported, the portable code is tested again. */
+    for (j = 0; j < 2; j++) {
+        pixa = (j == 0) ? pixa2 : pixaCreate(NExemplars);
+        if (j == 1) {  /* clipped copies of the views */
+            for (i = 0; i < NExemplars; i++) {
+                pix2 = pixaGetPix(pixav, i, L_CLONE);
+                pixaAddPix(pixa, pixCopy(NULL, pix2), L_INSERT);
+                pixDestroy(&pix2);
+            }
+        }
+        numaEmpty(na2);
+        for (i = 0; i < NExemplars; i++) {
+            pix2 = pixaGetPix(pixa, i, L_CLONE);
+            pixCountPixels(pix2, &area2, tab);
+            numaAddNumber(na2, area2);
+            pixDestroy(&pix2);
+        }
+
+        for (mode = L_SIMD_NONE; mode <= L_SIMD_NEON; mode++) {
+            l_setSimdMode(l_simdSupported(mode) ? mode : L_SIMD_NONE);
+            nbad = 0;
+            for (i = 0; i < NTests; i++) {
+                pix1 = pixaGetPix(pixa, 5 * i, L_CLONE);
+                pixCountPixels(pix1, &area1, tab);
+                pixCentroid(pix1, centtab, tab, &x1, &y1);
+                pta2 = ptaCreate(NExemplars);
+                pta3 = ptaCreate(NExemplars);
+                for (x = 0; x < NExemplars; x++) {
+                    pix2 = pixaGetPix(pixa, x, L_CLONE);
+                    pixCentroid(pix2, centtab, tab, &x2, &y2);
+                    ptaAddPt(pta2, x1 - x2, y1 - y2);
+                    ptaAddPt(pta3, 0.5 * (x % 7) - 1.5, 0.5 * (x % 5) - 1.0);
+                    pixDestroy(&pix2);
+                }
+                pixCorrelationScoreBatch(pix1, area1, pixa, na2, pta2, 2, 5,
+                                         5, &nascore, &ptashift);
+                nbad += CompareWithSimple(pix1, area1, pixa, na2, pta2, 2,
+                                          nascore, ptashift, tab);
+                if (j == 1) {  /* the views must give the same results */
+                    pixCorrelationScoreBatch(pix1, area1, pixav, na2, pta2,
+                                             2, 5, 5, &nascorev, &ptashiftv);
+                    nbad += CompareWithSimple(pix1, area1, pixa, na2, pta2,
+                                              2, nascorev, ptashiftv, tab);
+                    numaDestroy(&nascorev);
+                    ptaDestroy(&ptashiftv);
+                }
+                numaDestroy(&nascore);
+                ptaDestroy(&ptashift);
+                pixCorrelationScoreBatch(pix1, area1, pixa, na2, pta3, 1, 8,
+                                         8, &nascore, &ptashift);
+                nbad += CompareWithSimple(pix1, area1, pixa, na2, pta3, 1,
+                                          nascore, ptashift, tab);
+                numaDestroy(&nascore);
+                ptaDestroy(&ptashift);
+                ptaDestroy(&pta2);
+                ptaDestroy(&pta3);
+                pixDestroy(&pix1);
+            }
+            regTestCompareValues(rp, 0, nbad, 0.0);  /* 0 - 7 */
+        }
+        if (j == 1) pixaDestroy(&pixa);
+    }
+
+        /* Compare pixBestCorrelation() with the shifted correlator,
+         * on a region of pixs and a translated copy of it, for
+         * each vector kernel. */
+    box = boxCreate(100, 100, 500, 300);
+    pix1 = pixClipRectangle(pixs, box, NULL);
+    pix2 = pixTranslate(NULL, pix1, 3, -2, L_BRING_IN_WHITE);
+    pixCountPixels(pix1, &area1, tab);
+    pixCountPixels(pix2, &area2, tab);
+    maxscore = 0.0;
+    bestdelx = bestdely = 0;
+    for (y = -4; y <= 4; y++) {
+        for (x = -4; x <= 4; x++) {
+            pixCorrelationScoreShifted(pix1, pix2, area1, area2, x, y,
+                                       tab, &score);
+            if (score > maxscore) {
+                maxscore = score;
+                bestdelx = x;
+                bestdely = y;
+            }
+        }
+    }
+    for (mode = L_SIMD_NONE; mode <= L_SIMD_NEON; mode++) {
+        l_setSimdMode(l_simdSupported(mode) ? mode : L_SIMD_NONE);
+        pixBestCorrelation(pix1, pix2, area1, area2, 0, 0, 4, NULL,
+                           &delx, &dely, &score, 0);
+        regTestCompareValues(rp, bestdelx, delx, 0.0);  /* 8, 11, 14, 17 */
+        regTestCompareValues(rp, bestdely, dely, 0.0);  /* 9, 12, 15, 18 */
+        regTestCompareValues(rp, maxscore, score, 0.0);  /* 10, 13, 16, 19 */
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    boxDestroy(&box);
+
+    pixaDestroy(&pixac);
+    pixaDestroy(&pixa2);
+    pixaDestroy(&pixav);
+    numaDestroy(&na2);
+    boxaDestroy(&boxa);
+    pixDestroy(&pixs);
+    LEPT_FREE(tab);
+    LEPT_FREE(centtab);
+    return regTestCleanup(rp);
+}
+
+
+    /* Returns the number of exemplars for which the batch score or
+     * shift differs from the best found by pixCorrelationScoreSimple() */
+static l_int32
+CompareWithSimple(PIX      *pix1,
+                  l_int32   area1,
+                  PIXA     *pixa2,
+                  NUMA     *na2,
+                  PTA      *pta2,
+                  l_int32   maxshift,
+                  NUMA     *nascore,
+                  PTA      *ptashift,
+                  l_int32  *tab)
+{
+l_int32    i, n, area2, sx, sy, bestsx, bestsy, nbad;
+l_float32  delx, dely, shiftx, shifty, score, maxscore, val;
+PIX       *pix2;
+
+    n = pixaGetCount(pixa2);
+    nbad = 0;
+    for (i = 0; i < n; i++) {
+        pix2 = pixaGetPix(pixa2, i, L_CLONE);
+        numaGetIValue(na2, i, &area2);
+        ptaGetPt(pta2, i, &delx, &dely);
+        maxscore = 0.0;
+        bestsx = bestsy = 0;
+        for (sy = -maxshift; sy <= maxshift; sy++) {
+            for (sx = -maxshift; sx <= maxshift; sx++) {
+                pixCorrelationScoreSimple(pix1, pix2, area1, area2,
+                                          delx + sx, dely + sy,
+                                          (maxshift == 1) ? 8 : 5,
+                                          (maxshift == 1) ? 8 : 5,
+                                          tab, &score);
+                if (score > maxscore) {
+                    maxscore = score;
+                    bestsx = sx;
+                    bestsy = sy;
+                }
+            }
+        }
+        numaGetFValue(nascore, i, &val);
+        ptaGetPt(ptashift, i, &shiftx, &shifty);
+        if (val != maxscore || shiftx != bestsx || shifty != bestsy)
+            nbad++;
+        pixDestroy(&pix2);
+    }
+    return nbad;
+}
@@ -0,0 +1,296 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   dwaplan_reg.c
+ *
+ *   Tests dwa morphology with arbitrary Sels, using plans made at
+ *   run time, against the rasterop functions pixDilate(), pixErode(),
+ *   pixOpen(), pixClose() and pixHMT().  The Sels are the hit-miss
+ *   and junction Sels of sel2.c, and random Sels with hits, misses
+ *   and origins anywhere in the Sel.
+ *
+ *   Also tests each vector instruction set, the plan cache, and the
+ *   hmt on several threads.
+ */
+
+#include "allheaders.h"
+
+static SELA *MakeRandomSels(l_int32 nsels);
+static l_int32 CountDiffs(PIX *pixs, SEL *sel);
+static l_int32 HMTTask(void *data, l_int32 index);
+
+    /* Input to HMTTask() */
+static PIX   *TaskPix;
+static SELA  *TaskSela;
+static PIXA  *TaskPixa;
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, n, ndiff, nthreads, same, mode;
+BOX          *box;
+PIX          *pixs, *pix1, *pix2, *pix3;
+SEL          *sel;
+SELA         *sela, *sela1;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* The Sels */
+    sela = selaAddHitMiss(NULL);
+    sela = selaAddCrossJunctions(sela, 5.0, 2.0, 4, 0);
+    sela = selaAddTJunctions(sela, 5.0, 2.0, 4, 0);
+    sela1 = MakeRandomSels(20);
+    for (i = 0; i < selaGetCount(sela1); i++) {
+        sel = selaGetSel(sela1, i);
+        selaAddSel(sela, sel, selGetName(sel), L_COPY);
+    }
+    selaDestroy(&sela1);
+    n = selaGetCount(sela);
+    fprintf(stderr, "Number of sels: %d\n", n);
+
+        /* Two images, with widths that are not a multiple of 32 */
+    pix1 = pixRead("rabi.png");
+    box = boxCreate(600, 900, 613, 407);
+    pixs = pixClipRectangle(pix1, box, NULL);
+    boxDestroy(&box);
+    box = boxCreate(1200, 1400, 37, 9);
+    pix2 = pixClipRectangle(pix1, box, NULL);
+    boxDestroy(&box);
+    pixDestroy(&pix1);
+
+        /* Compare with rasterop, for both boundary conditions */
+    ndiff = 0;
+    for (i = 0; i < n; i++) {
+        sel = selaGetSel(sela, i);
+        ndiff += CountDiffs(pixs, sel);
+        ndiff += CountDiffs(pix2, sel);
+    }
+    regTestCompareValues(rp, 0, ndiff, 0);  /* 0 */
+    resetMorphBoundaryCondition(SYMMETRIC_MORPH_BC);
+    ndiff = 0;
+    for (i = 0; i < n; i++) {
+        sel = selaGetSel(sela, i);
+        ndiff += CountDiffs(pixs, sel);
+        ndiff += CountDiffs(pix2, sel);
+    }
+    resetMorphBoundaryCondition(ASYMMETRIC_MORPH_BC);
+    regTestCompareValues(rp, 0, ndiff, 0);  /* 1 */
+
+        /* Portable code and each supported instruction set */
+    ndiff = 0;
+    for (mode = L_SIMD_NONE; mode <= L_SIMD_NEON; mode++) {
+        if (!l_simdSupported(mode))
+            continue;
+        l_setSimdMode(mode);
+        for (i = 0; i < n; i++) {
+            sel = selaGetSel(sela, i);
+            ndiff += CountDiffs(pixs, sel);
+            ndiff += CountDiffs(pix2, sel);
+        }
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+    regTestCompareValues(rp, 0, ndiff, 0);  /* 2 */
+    pixDestroy(&pix2);
+
+        /* In-place */
+    sel = selaGetSel(sela, 0);
+    pix1 = pixHMT(NULL, pixs, sel);
+    pix2 = pixCopy(NULL, pixs);
+    pixHMTSelDwa(pix2, pix2, sel);
+    regTestComparePix(rp, pix1, pix2);  /* 3 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* One plan for each distinct sel.  A copy of a sel with
+         * another name uses the same plan. */
+    l_dwaPlanCacheClear();
+    regTestCompareValues(rp, 0, l_dwaPlanCacheGetCount(), 0);  /* 4 */
+    for (i = 0; i < 10; i++) {
+        pix1 = pixHMTSelDwa(NULL, pixs, selaGetSel(sela, i));
+        pixDestroy(&pix1);
+    }
+    regTestCompareValues(rp, 10, l_dwaPlanCacheGetCount(), 0);  /* 5 */
+    sel = selCopy(selaGetSel(sela, 3));
+    selSetName(sel, "another name");
+    pix1 = pixHMTSelDwa(NULL, pixs, sel);
+    pixDestroy(&pix1);
+    selDestroy(&sel);
+    regTestCompareValues(rp, 10, l_dwaPlanCacheGetCount(), 0);  /* 6 */
+    for (i = 0; i < n; i++) {
+        pix1 = pixMorphSelDwa(NULL, pixs, L_MORPH_DILATE,
+                              selaGetSel(sela, i));
+        pixDestroy(&pix1);
+    }
+    regTestCompareValues(rp, L_MIN(n, 64), l_dwaPlanCacheGetCount(),
+                         0);  /* 7 */
+    l_dwaPlanCacheClear();
+
+        /* The hmt with all the sels, on 4 threads */
+    TaskPix = pixs;
+    TaskSela = sela;
+    TaskPixa = pixaCreate(n);
+    for (i = 0; i < n; i++)
+        pixaAddPix(TaskPixa, pixCreateTemplate(pixs), L_INSERT);
+    nthreads = l_getParallelThreads();
+    l_setParallelThreads(4);
+    l_parallelRun(n, 0, HMTTask, NULL);
+    l_setParallelThreads(nthreads);
+    ndiff = 0;
+    for (i = 0; i < n; i++) {
+        pix1 = pixHMT(NULL, pixs, selaGetSel(sela, i));
+        pix2 = pixaGetPix(TaskPixa, i, L_CLONE);
+        pixEqual(pix1, pix2, &same);
+        if (!same) ndiff++;
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    regTestCompareValues(rp, 0, ndiff, 0);  /* 8 */
+    pixaDestroy(&TaskPixa);
+
+        /* Display the hmt matches for a junction sel */
+    pix1 = pixHMTSelDwa(NULL, pixs, selaGetSel(sela, 20));
+    pix2 = pixMorphSelDwa(NULL, pix1, L_MORPH_DILATE,
+                          selaGetSel(sela, 20));
+    pix3 = pixConvertTo32(pixs);
+    pixPaintThroughMask(pix3, pix2, 0, 0, 0xff000000);
+    regTestWritePixAndCheck(rp, pix3, IFF_PNG);  /* 9 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+    pixDestroy(&pixs);
+    selaDestroy(&sela);
+    l_dwaPlanCacheClear();
+    return regTestCleanup(rp);
+}
+
+
+    /* Random sels, from 1 x 1 to 17 x 17, with about 1/3 hits and
+     * 1/6 misses, and the origin anywhere in the sel */
+static SELA *
+MakeRandomSels(l_int32  nsels)
+{
+char     buf[32];
+l_int32  i, j, k, sx, sy, cx, cy, val;
+SEL     *sel;
+SELA    *sela;
+
+    sela = selaCreate(nsels);
+    for (k = 0; k < nsels; k++) {
+        genRandomIntegerInRange(17, (k == 0) ? 45 : 0, &sx);
+        genRandomIntegerInRange(17, 0, &sy);
+        sx = L_MIN(sx, 16) + 1;
+        sy = L_MIN(sy, 16) + 1;
+        sel = selCreate(sy, sx, NULL);
+        for (i = 0; i < sy; i++) {
+            for (j = 0; j < sx; j++) {
+                genRandomIntegerInRange(6, 0, &val);
+                if (val < 2)
+                    selSetElement(sel, i, j, SEL_HIT);
+                else if (val == 2)
+                    selSetElement(sel, i, j, SEL_MISS);
+            }
+        }
+        genRandomIntegerInRange(sx + 1, 0, &cx);
+        genRandomIntegerInRange(sy + 1, 0, &cy);
+        selSetOrigin(sel, L_MIN(cy, sy - 1), L_MIN(cx, sx - 1));
+        snprintf(buf, sizeof(buf), "random%d", k);
+        selaAddSel(sela, sel, buf, L_INSERT);
+    }
+    return sela;
+}
+
+
+    /* Returns the number of operations for which the dwa result
+     * differs from the rasterop result */
+static l_int32
+CountDiffs(PIX  *pixs,
+           SEL  *sel)
+{
+l_int32  i, j, nhits, nmisses, sx, sy, same, ndiff;
+l_int32  ops[4] = {L_MORPH_DILATE, L_MORPH_ERODE, L_MORPH_OPEN,
+                   L_MORPH_CLOSE};
+PIX     *pix1, *pix2;
+
+    ndiff = 0;
+    selGetParameters(sel, &sy, &sx, NULL, NULL);
+    nhits = nmisses = 0;
+    for (i = 0; i < sy; i++) {
+        for (j = 0; j < sx; j++) {
+            if (sel->data[i][j] == SEL_HIT)
+                nhits++;
+            else if (sel->data[i][j] == SEL_MISS)
+                nmisses++;
+        }
+    }
+    for (i = 0; i < 4 && nhits > 0; i++) {
+        if (ops[i] == L_MORPH_DILATE)
+            pix1 = pixDilate(NULL, pixs, sel);
+        else if (ops[i] == L_MORPH_ERODE)
+            pix1 = pixErode(NULL, pixs, sel);
+        else if (ops[i] == L_MORPH_OPEN)
+            pix1 = pixOpen(NULL, pixs, sel);
+        else
+            pix1 = pixClose(NULL, pixs, sel);
+        pix2 = pixMorphSelDwa(NULL, pixs, ops[i], sel);
+        pixEqual(pix1, pix2, &same);
+        if (!same) {
+            fprintf(stderr, "Failure: op %d, sel %d x %d\n", ops[i], sx, sy);
+            ndiff++;
+        }
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    if (nhits + nmisses > 0) {
+        pix1 = pixHMT(NULL, pixs, sel);
+        pix2 = pixHMTSelDwa(NULL, pixs, sel);
+        pixEqual(pix1, pix2, &same);
+        if (!same) {
+            fprintf(stderr, "Failure: hmt, sel %d x %d\n", sx, sy);
+            ndiff++;
+        }
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    return ndiff;
+}
+
+
+static l_int32
+HMTTask(void    *data,
+        l_int32  index)
+{
+PIX  *pixd;
+
+    pixd = pixaGetPix(TaskPixa, index, L_CLONE);
+    pixHMTSelDwa(pixd, TaskPix, selaGetSel(TaskSela, index));
+    pixDestroy(&pixd);
+    return 0;
+}
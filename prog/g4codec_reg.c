@@ -0,0 +1,183 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   g4codec_reg.c
+ *
+ *   Tests the native ccitt g4 coder, which does not require libtiff.
+ *   Images of various sizes, including odd widths, widths of 1 and
+ *   of a multiple of 32, and with very long runs, are encoded and
+ *   decoded, both as raw g4 data and as g4 compressed tiff.  The
+ *   coding must not depend on the padding bits.  The coder is also
+ *   used by pixcomp and for g4 data in pdf, and invalid data must be
+ *   rejected.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+static PIXA *MakeTestImages(void);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_uint8      *data1, *data2;
+l_int32       i, n, same, xres, yres, ret;
+size_t        nbytes1, nbytes2;
+PIX          *pixs, *pix1, *pix2;
+PIXA         *pixa;
+PIXC         *pixc;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pixa = MakeTestImages();
+    n = pixaGetCount(pixa);
+    for (i = 0; i < n; i++) {
+        pixs = pixaGetPix(pixa, i, L_CLONE);
+
+            /* Raw g4 data; the padding bits are ignored */
+        pixEncodeG4(&data1, &nbytes1, pixs);
+        pix1 = pixDecodeG4(data1, nbytes1, pixGetWidth(pixs),
+                           pixGetHeight(pixs));
+        regTestComparePix(rp, pixs, pix1);  /* 0, 7, ... */
+        pix2 = pixCopy(NULL, pixs);
+        pixSetPadBits(pix2, 1);
+        pixEncodeG4(&data2, &nbytes2, pix2);
+        same = (nbytes1 == nbytes2 && !memcmp(data1, data2, nbytes1));
+        regTestCompareValues(rp, 1, same, 0.0);  /* 1, 8, ... */
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        lept_free(data1);
+        lept_free(data2);
+
+            /* G4 compressed tiff */
+        pixSetResolution(pixs, 200, 100);
+        pixEncodeG4Tiff(&data1, &nbytes1, pixs);
+        pix1 = pixDecodeG4Tiff(data1, nbytes1);
+        regTestComparePix(rp, pixs, pix1);  /* 2, 9, ... */
+        pixGetResolution(pix1, &xres, &yres);
+        regTestCompareValues(rp, 200, xres, 0.0);  /* 3, 10, ... */
+        regTestCompareValues(rp, 100, yres, 0.0);  /* 4, 11, ... */
+        regTestCompareValues(rp, IFF_TIFF_G4,
+                             pixGetInputFormat(pix1), 0.0);  /* 5, 12, ... */
+        pixDestroy(&pix1);
+        lept_free(data1);
+
+            /* Pixcomp */
+        pixc = pixcompCreateFromPix(pixs, IFF_TIFF_G4);
+        pix1 = pixCreateFromPixcomp(pixc);
+        regTestComparePix(rp, pixs, pix1);  /* 6, 13, ... */
+        pixcompDestroy(&pixc);
+        pixDestroy(&pix1);
+        pixDestroy(&pixs);
+    }
+
+        /* The encoded data is stable */
+    pixs = pixaGetPix(pixa, 0, L_CLONE);
+    pixEncodeG4(&data1, &nbytes1, pixs);
+    l_binaryWrite("/tmp/lept/regout/g4codec.g4", "w", data1, nbytes1);
+    regTestCheckFile(rp, "/tmp/lept/regout/g4codec.g4");  /* 49 */
+
+        /* Truncated and corrupted data is rejected */
+    fprintf(stderr, "******************************************************\n");
+    fprintf(stderr, "* The next 2 error messages are intentional          *\n");
+    pix1 = pixDecodeG4(data1, nbytes1 / 2, pixGetWidth(pixs),
+                       pixGetHeight(pixs));
+    regTestCompareValues(rp, 1, (pix1 == NULL) ? 1 : 0, 0.0);  /* 50 */
+    memset(data1 + nbytes1 / 3, 0, 4);
+    pix1 = pixDecodeG4(data1, nbytes1, pixGetWidth(pixs),
+                       pixGetHeight(pixs));
+    regTestCompareValues(rp, 1, (pix1 == NULL) ? 1 : 0, 0.0);  /* 51 */
+    fprintf(stderr, "******************************************************\n");
+    lept_free(data1);
+
+        /* G4 data in pdf */
+    ret = pixConvertToPdfData(pixs, L_G4_ENCODE, 0, &data1, &nbytes1,
+                              0, 0, 0, "g4codec", NULL, 0);
+    regTestCompareValues(rp, 0, ret, 0.0);  /* 52 */
+    if (rp->display)
+        l_binaryWrite("/tmp/lept/regout/g4codec.pdf", "w", data1, nbytes1);
+    lept_free(data1);
+    pixDestroy(&pixs);
+
+    pixaDestroy(&pixa);
+    return regTestCleanup(rp);
+}
+
+
+    /* Makes 1 bpp images with text, noise, long runs, and edge cases
+     * in size */
+static PIXA *
+MakeTestImages(void)
+{
+l_int32  i, j;
+BOX     *box;
+PIX     *pix1, *pix2, *pix3;
+PIXA    *pixa;
+
+    pixa = pixaCreate(7);
+    pix1 = pixRead("rabi.png");
+    box = boxCreate(403, 717, 1201, 517);
+    pix2 = pixClipRectangle(pix1, box, NULL);
+    pixaAddPix(pixa, pix2, L_INSERT);
+    boxDestroy(&box);
+
+        /* Noise, with an odd width */
+    pix2 = pixRead("test8.jpg");
+    pix3 = pixAddGaussianNoise(pix2, 60.0);
+    pixaAddPix(pixa, pixThresholdToBinary(pix3, 128), L_INSERT);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+        /* Full width, with long runs on many lines */
+    pixaAddPix(pixa, pixScale(pix1, 1.4, 0.05), L_INSERT);
+    pixDestroy(&pix1);
+
+        /* All white, all black, and a checkerboard; with widths
+         * of 1 and a multiple of 32 */
+    pix1 = pixCreate(1, 19, 1);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixCreate(64, 9, 1);
+    pixSetAll(pix1);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixCreate(97, 33, 1);
+    for (i = 0; i < 33; i++) {
+        for (j = 0; j < 97; j++)
+            pixSetPixel(pix1, j, i, (i + j) & 1);
+    }
+    pixaAddPix(pixa, pix1, L_INSERT);
+
+        /* Black runs of more than 2560 that end at the right edge */
+    pix1 = pixCreate(5301, 4, 1);
+    pixRasterop(pix1, 7, 0, 5294, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pix1, 2, 2, 5299, 2, PIX_SET, NULL, 0, 0);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    return pixa;
+}
@@ -29,10 +29,20 @@
  *
  *   Compares graymorph results with special (3x1, 1x3, 3x3) cases
  *   against the general case.  Require exact equality.
+ *
+ *   Also compares the results of the general case with each vector
+ *   instruction set against the scalar code, for a set of brick sizes
+ *   and for image sizes that are not a multiple of the vector width.
  */
 
 #include "allheaders.h"
 
+static void TestSimdModes(L_REGPARAMS *rp, PIX *pixs);
+
+    /* Brick sizes for testing the vector kernels */
+static const l_int32  BrickSizes[][2] = {{1, 7}, {7, 1}, {5, 5}, {31, 31},
+                                         {15, 3}, {3, 21}, {9, 9}};
+
 int main(int    argc,
          char **argv)
 {
@@ -173,6 +183,65 @@ L_REGPARAMS  *rp;
     pixDestroy(&pixd);
     pixaDestroy(&pixa);
 
+        /* Vector kernels */
+    TestSimdModes(rp, pixs);  /* 12 - */
+
     pixDestroy(&pixs);
     return regTestCleanup(rp);
 }
+
+
+    /* For each available vector instruction set, compares erosion,
+     * dilation, opening and closing with the scalar results.  The
+     * images are clipped to sizes that exercise the partial vectors
+     * and partial 32-bit words at the right side. */
+static void
+TestSimdModes(L_REGPARAMS  *rp,
+              PIX          *pixs)
+{
+l_int32  i, j, k, mode, w, h, hsize, vsize, nsizes;
+BOX     *box;
+PIX     *pix1, *pix2, *pix3;
+PIX     *(*ops[4])(PIX *, l_int32, l_int32) = {pixErodeGray, pixDilateGray,
+                                               pixOpenGray, pixCloseGray};
+
+    nsizes = sizeof(BrickSizes) / sizeof(BrickSizes[0]);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    for (mode = L_SIMD_SSE2; mode <= L_SIMD_NEON; mode++) {
+        if (!l_simdSupported(mode))
+            continue;
+        for (i = 0; i < 3; i++) {
+            box = boxCreate(i, 2 * i, w - 5 * i, h - 3 * i);
+            pix1 = pixClipRectangle(pixs, box, NULL);
+            boxDestroy(&box);
+            for (j = 0; j < nsizes; j++) {
+                hsize = BrickSizes[j][0];
+                vsize = BrickSizes[j][1];
+                for (k = 0; k < 4; k++) {
+                    l_setSimdMode(L_SIMD_NONE);
+                    pix2 = ops[k](pix1, hsize, vsize);
+                    l_setSimdMode(mode);
+                    pix3 = ops[k](pix1, hsize, vsize);
+                    regTestComparePix(rp, pix2, pix3);
+                    pixDestroy(&pix2);
+                    pixDestroy(&pix3);
+                }
+            }
+            pixDestroy(&pix1);
+        }
+
+            /* Narrow image, with a single band of lines */
+        box = boxCreate(3, 5, 37, 11);
+        pix1 = pixClipRectangle(pixs, box, NULL);
+        boxDestroy(&box);
+        l_setSimdMode(L_SIMD_NONE);
+        pix2 = pixCloseGray(pix1, 5, 3);
+        l_setSimdMode(mode);
+        pix3 = pixCloseGray(pix1, 5, 3);
+        regTestComparePix(rp, pix2, pix3);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        pixDestroy(&pix3);
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+}
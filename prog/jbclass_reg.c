@@ -0,0 +1,169 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   jbclass_reg.c
+ *
+ *   Tests that the jbig2 classifier gives the same classes, in the
+ *   same order, when the pages and the components are handled on
+ *   several threads as when everything is done on one thread.
+ *   This is tested for correlation and rank hausdorff classifiers,
+ *   with connected components and characters.
+ *
+ *   Some of the files are not 1 bpp images; these pages are skipped.
+ */
+
+#include "allheaders.h"
+
+static const char *FileNames[] = {"cootoots.png", "copernicus.png",
+                                  "italic.png", "weasel8.png",
+                                  "keystone.png", "tribune-page-4x.png",
+                                  "no-such-file.png", "turingtest.png",
+                                  "cootoots.png"};
+
+static JBCLASSER *MakeClasser(l_int32 index);
+static l_int32 SameClasses(JBCLASSER *classer1, JBCLASSER *classer2);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, n, n1, n2, nthreads, same;
+JBCLASSER    *classer1, *classer2;
+JBDATA       *data1, *data2;
+PIX          *pix1;
+PIXA         *pixa1, *pixa2;
+SARRAY       *sa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    n = sizeof(FileNames) / sizeof(char *);
+    sa = sarrayCreate(n);
+    for (i = 0; i < n; i++)
+        sarrayAddString(sa, (char *)FileNames[i], L_COPY);
+
+        /* Classify on one thread and on three threads, and compare
+         * the classes and the rendered pages (0 - 27) */
+    nthreads = l_getParallelThreads();
+    for (i = 0; i < 4; i++) {
+        l_setParallelThreads(1);
+        classer1 = MakeClasser(i);
+        jbAddPages(classer1, sa);
+        l_setParallelThreads(3);
+        classer2 = MakeClasser(i);
+        jbAddPages(classer2, sa);
+        l_setParallelThreads(nthreads);
+        regTestCompareValues(rp, 7, classer2->npages, 0.0);
+        regTestCompareValues(rp, classer1->nclass, classer2->nclass, 0.0);
+        regTestCompareValues(rp, 1, SameClasses(classer1, classer2), 0.0);
+
+        data1 = jbDataSave(classer1);
+        data2 = jbDataSave(classer2);
+        pixa1 = jbDataRender(data1, FALSE);
+        pixa2 = jbDataRender(data2, FALSE);
+        same = (pixaGetCount(pixa1) == pixaGetCount(pixa2));
+        for (j = 0; same && j < pixaGetCount(pixa1); j++)
+            pixEqual(pixaGetPixArray(pixa1)[j], pixaGetPixArray(pixa2)[j],
+                     &same);
+        regTestCompareValues(rp, 1, same, 0.0);
+        pix1 = pixaGetPix(pixa2, 0, L_CLONE);
+        regTestWritePixAndCheck(rp, pix1, IFF_PNG);
+        pixDisplayWithTitle(pix1, 100 * i, 100, NULL, rp->display);
+        pixDestroy(&pix1);
+
+            /* The last page is the same image as the first */
+        numaGetIValue(classer2->nacomps, 0, &n1);
+        numaGetIValue(classer2->nacomps, 6, &n2);
+        regTestCompareValues(rp, n1, n2, 0.0);
+
+            /* Adding the pages one at a time gives the same classes */
+        l_setParallelThreads(3);
+        jbClasserDestroy(&classer1);
+        classer1 = MakeClasser(i);
+        for (j = 0; j < n; j++) {
+            pix1 = pixRead(FileNames[j]);
+            if (pix1 && pixGetDepth(pix1) == 1)
+                jbAddPage(classer1, pix1);
+            pixDestroy(&pix1);
+        }
+        l_setParallelThreads(nthreads);
+        regTestCompareValues(rp, 1, SameClasses(classer1, classer2), 0.0);
+
+        jbDataDestroy(&data1);
+        jbDataDestroy(&data2);
+        pixaDestroy(&pixa1);
+        pixaDestroy(&pixa2);
+        jbClasserDestroy(&classer1);
+        jbClasserDestroy(&classer2);
+    }
+
+    sarrayDestroy(&sa);
+    return regTestCleanup(rp);
+}
+
+
+static JBCLASSER *
+MakeClasser(l_int32  index)
+{
+    if (index == 0)
+        return jbCorrelationInit(JB_CONN_COMPS, 0, 0, 0.8, 0.6);
+    else if (index == 1)
+        return jbCorrelationInit(JB_CHARACTERS, 0, 0, 0.85, 0.0);
+    else if (index == 2)
+        return jbRankHausInit(JB_CONN_COMPS, 0, 0, 2, 0.97);
+    else
+        return jbRankHausInit(JB_CONN_COMPS, 0, 0, 3, 1.0);
+}
+
+
+    /* Compares the class, page and location of every component */
+static l_int32
+SameClasses(JBCLASSER  *classer1,
+            JBCLASSER  *classer2)
+{
+l_int32  i, n, val1, val2, x1, y1, x2, y2;
+
+    n = numaGetCount(classer1->naclass);
+    if (n != numaGetCount(classer2->naclass) ||
+        classer1->nclass != classer2->nclass ||
+        classer1->npages != classer2->npages)
+        return 0;
+    for (i = 0; i < n; i++) {
+        numaGetIValue(classer1->naclass, i, &val1);
+        numaGetIValue(classer2->naclass, i, &val2);
+        if (val1 != val2) return 0;
+        numaGetIValue(classer1->napage, i, &val1);
+        numaGetIValue(classer2->napage, i, &val2);
+        if (val1 != val2) return 0;
+        ptaGetIPt(classer1->ptaul, i, &x1, &y1);
+        ptaGetIPt(classer2->ptaul, i, &x2, &y2);
+        if (x1 != x2 || y1 != y2) return 0;
+    }
+    return 1;
+}
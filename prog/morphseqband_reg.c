@@ -0,0 +1,106 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   morphseqband_reg.c
+ *
+ *   Tests that the binary morphological sequences give the same
+ *   result when run on bands, with one or several threads, as when
+ *   each operation is run on the full image.  All four sequence
+ *   interpreters are tested, with sequences that include reductions,
+ *   expansions and an added border.
+ */
+
+#include "allheaders.h"
+
+static const char *Sequences[] = {
+                         "O1.3 + C3.1 + R22 + D2.2 + X4",
+                         "O2.13 + C5.25 + R22 + X4",
+                         "b32 + c25.25 + e5.5 + d3.3",
+                         "r11 + d3.3 + r2 + e3.3 + x2",
+                         "x2 + o5.5 + r1 + c1.35",
+                         "c9.9 + r1234",
+                         "d41.1 + e1.41 + o3.3"};
+
+static PIX *RunSequence(PIX *pixs, const char *sequence, l_int32 method);
+
+
+int main(int    argc,
+         char **argv)
+{
+char          buf[64];
+l_int32       i, j, method, nseq, nthreads;
+PIX          *pixs, *pix1, *pix2, *pix3;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    nthreads = l_getParallelThreads();
+    nseq = sizeof(Sequences) / sizeof(char *);
+    for (i = 0; i < 2; i++) {
+        snprintf(buf, sizeof(buf), "%s", (i == 0) ? "rabi.png" : "patent.png");
+        pixs = pixRead(buf);
+        for (j = 0; j < nseq; j++) {
+            for (method = 0; method < 4; method++) {
+                l_setMorphSequenceBanding(0);
+                pix1 = RunSequence(pixs, Sequences[j], method);
+                l_setMorphSequenceBanding(1);
+                l_setParallelThreads(1);
+                pix2 = RunSequence(pixs, Sequences[j], method);
+                l_setParallelThreads(4);
+                pix3 = RunSequence(pixs, Sequences[j], method);
+                l_setParallelThreads(nthreads);
+                regTestComparePix(rp, pix1, pix2);
+                regTestComparePix(rp, pix1, pix3);
+                if (i == 0 && method == 0 && j < 3)
+                    regTestWritePixAndCheck(rp, pix2, IFF_PNG);
+                pixDestroy(&pix1);
+                pixDestroy(&pix2);
+                pixDestroy(&pix3);
+            }
+        }
+        pixDestroy(&pixs);
+    }
+
+    return regTestCleanup(rp);
+}
+
+
+static PIX *
+RunSequence(PIX         *pixs,
+            const char  *sequence,
+            l_int32      method)
+{
+    if (method == 0)
+        return pixMorphSequence(pixs, sequence, 0);
+    else if (method == 1)
+        return pixMorphCompSequence(pixs, sequence, 0);
+    else if (method == 2)
+        return pixMorphSequenceDwa(pixs, sequence, 0);
+    else
+        return pixMorphCompSequenceDwa(pixs, sequence, 0);
+}
@@ -0,0 +1,263 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   multipage_reg.c
+ *
+ *   Tests that multipage pdf and tiff files are the same when the
+ *   pages are encoded on several threads as when they are encoded
+ *   one at a time, and that the pages are in the input order.
+ *   This includes a pixa that holds the same pix more than once.
+ *
+ *   The pdf date is omitted, so that the files made in different
+ *   runs can be compared byte for byte.
+ *
+ *   Multipage pdf files are streamed as the pages are made.  The
+ *   streamed file is tested against one made page by page with a
+ *   pdf writer, and against the concatenation of single-page files.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+static const char *FileNames[] = {"weasel8.png", "karen8.jpg",
+                                  "test24.jpg", "dreyfus8.png",
+                                  "not-an-image.xyz", "weasel4.png",
+                                  "church.png", "marge.jpg",
+                                  "weasel2.4c.png", "books_logo.png"};
+
+static l_int32 MakePdfs(SARRAY *sa, PIXA *pixa, l_uint8 **pdata1,
+                        size_t *psize1, l_uint8 **pdata2, size_t *psize2,
+                        l_uint8 **pdata3, size_t *psize3);
+
+
+int main(int    argc,
+         char **argv)
+{
+char          buf[256];
+FILE         *fp;
+l_uint8      *data1[2], *data2[2], *data3[2], *fdata1, *fdata2;
+l_int32       i, n, same, nthreads;
+l_float32     scale;
+size_t        size1[2], size2[2], size3[2], fsize1, fsize2;
+PIX          *pix;
+PIXA         *pixa, *pixa2;
+SARRAY       *sa, *sa1;
+L_PDFWRITER  *pw;
+L_REGPARAMS  *rp;
+#if  HAVE_LIBTIFF
+l_int32       npages;
+l_uint8      *tdata1, *tdata2;
+size_t        tsize1, tsize2;
+PIX          *pix1;
+PIXA         *pixa1;
+#endif  /* HAVE_LIBTIFF */
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    lept_mkdir("lept/multipage");
+    l_pdfSetDateAndVersion(0);
+    nthreads = l_getParallelThreads();
+
+        /* The input, as files and as images */
+    n = sizeof(FileNames) / sizeof(char *);
+    sa = sarrayCreate(n);
+    pixa = pixaCreate(n);
+    for (i = 0; i < n; i++) {
+        sarrayAddString(sa, (char *)FileNames[i], L_COPY);
+        if ((pix = pixRead(FileNames[i])) != NULL)
+            pixaAddPix(pixa, pix, L_INSERT);
+    }
+
+        /* Make the pdfs on one thread and on four threads */
+    l_setParallelThreads(1);
+    MakePdfs(sa, pixa, &data1[0], &size1[0], &data2[0], &size2[0],
+             &data3[0], &size3[0]);
+    l_setParallelThreads(4);
+    MakePdfs(sa, pixa, &data1[1], &size1[1], &data2[1], &size2[1],
+             &data3[1], &size3[1]);
+    l_setParallelThreads(nthreads);
+
+    l_binaryWrite("/tmp/lept/multipage/files.pdf", "w", data1[1], size1[1]);
+    l_binaryWrite("/tmp/lept/multipage/unscaled.pdf", "w", data2[1],
+                  size2[1]);
+    l_binaryWrite("/tmp/lept/multipage/pixa.pdf", "w", data3[1], size3[1]);
+    regTestCheckFile(rp, "/tmp/lept/multipage/files.pdf");  /* 0 */
+    regTestCheckFile(rp, "/tmp/lept/multipage/unscaled.pdf");  /* 1 */
+    regTestCheckFile(rp, "/tmp/lept/multipage/pixa.pdf");  /* 2 */
+    same = (size1[0] == size1[1] && !memcmp(data1[0], data1[1], size1[0]));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 3 */
+    same = (size2[0] == size2[1] && !memcmp(data2[0], data2[1], size2[0]));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 4 */
+    same = (size3[0] == size3[1] && !memcmp(data3[0], data3[1], size3[0]));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 5 */
+
+        /* Stream the pixa pdf to a file on one thread and on four
+         * threads.  Only the order of the objects differs from the
+         * pdf made in memory, so the size is the same. */
+    l_setParallelThreads(1);
+    pixaConvertToPdf(pixa, 100, 1.0, L_FLATE_ENCODE, 0, "pixa",
+                     "/tmp/lept/multipage/stream1.pdf");
+    l_setParallelThreads(4);
+    pixaConvertToPdf(pixa, 100, 1.0, L_FLATE_ENCODE, 0, "pixa",
+                     "/tmp/lept/multipage/stream4.pdf");
+    l_setParallelThreads(nthreads);
+    regTestCheckFile(rp, "/tmp/lept/multipage/stream4.pdf");  /* 6 */
+    fdata1 = l_binaryRead("/tmp/lept/multipage/stream1.pdf", &fsize1);
+    fdata2 = l_binaryRead("/tmp/lept/multipage/stream4.pdf", &fsize2);
+    same = (fsize1 == fsize2 && !memcmp(fdata1, fdata2, fsize1));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 7 */
+    regTestCompareValues(rp, size3[1], fsize2, 0.0);  /* 8 */
+    lept_free(fdata1);
+
+        /* The same pages, added one at a time with a pdf writer */
+    pw = pdfWriterOpen("/tmp/lept/multipage/writer.pdf", "pixa");
+    for (i = 0; i < pixaGetCount(pixa); i++) {
+        pix = pixaGetPix(pixa, i, L_CLONE);
+        pdfWriterAddPix(pw, pix, L_FLATE_ENCODE, 0, 100);
+        pixDestroy(&pix);
+    }
+    regTestCompareValues(rp, 0, pdfWriterClose(&pw), 0.0);  /* 9 */
+    fdata1 = l_binaryRead("/tmp/lept/multipage/writer.pdf", &fsize1);
+    same = (fsize1 == fsize2 && !memcmp(fdata1, fdata2, fsize1));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 10 */
+    lept_free(fdata1);
+
+        /* And as single-page files that are then concatenated */
+    sa1 = sarrayCreate(0);
+    for (i = 0; i < pixaGetCount(pixa); i++) {
+        pix = pixaGetPix(pixa, i, L_CLONE);
+        snprintf(buf, sizeof(buf), "/tmp/lept/multipage/page%02d.pdf", i);
+        pixConvertToPdf(pix, L_FLATE_ENCODE, 0, buf, 0, 0, 100, "pixa",
+                        NULL, 0);
+        sarrayAddString(sa1, buf, L_COPY);
+        pixDestroy(&pix);
+    }
+    saConcatenatePdf(sa1, "/tmp/lept/multipage/concat.pdf");
+    fdata1 = l_binaryRead("/tmp/lept/multipage/concat.pdf", &fsize1);
+    same = (fsize1 == fsize2 && !memcmp(fdata1, fdata2, fsize1));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 11 */
+    lept_free(fdata1);
+    lept_free(fdata2);
+    sarrayDestroy(&sa1);
+    for (i = 0; i < 2; i++) {
+        lept_free(data1[i]);
+        lept_free(data2[i]);
+        lept_free(data3[i]);
+    }
+
+        /* A pixa that holds two pix many times, as clones, gives the
+         * same pdf on four threads as on one, scaled and unscaled.
+         * The refcounts of the pix are not changed. */
+    pixa2 = pixaCreate(24);
+    for (i = 0; i < 24; i++) {
+        pix = pixaGetPix(pixa, i % 2, L_CLONE);
+        pixaAddPix(pixa2, pix, L_INSERT);
+    }
+    for (i = 0; i < 2; i++) {
+        scale = (i == 0) ? 1.0 : 0.6;
+        l_setParallelThreads(1);
+        pixaConvertToPdfData(pixa2, 100, scale, 0, 0, "clones", &fdata1,
+                             &fsize1);
+        l_setParallelThreads(4);
+        pixaConvertToPdfData(pixa2, 100, scale, 0, 0, "clones", &fdata2,
+                             &fsize2);
+        same = (fsize1 == fsize2 && !memcmp(fdata1, fdata2, fsize1));
+        regTestCompareValues(rp, 1, same, 0.0);  /* 12, 13 */
+        lept_free(fdata1);
+        lept_free(fdata2);
+    }
+    l_setParallelThreads(nthreads);
+    pix = pixaGetPix(pixa, 0, L_CLONE);
+    regTestCompareValues(rp, 14, pixGetRefcount(pix), 0.0);  /* 14 */
+    pixDestroy(&pix);
+    pixaDestroy(&pixa2);
+
+        /* A pdf writer to which no page is added makes no file */
+    lept_rmfile("/tmp/lept/multipage/empty.pdf");
+    pw = pdfWriterOpen("/tmp/lept/multipage/empty.pdf", "empty");
+    regTestCompareValues(rp, 1, pdfWriterClose(&pw), 0.0);  /* 15 */
+    fp = fopen("/tmp/lept/multipage/empty.pdf", "rb");
+    regTestCompareValues(rp, 0, (fp != NULL), 0.0);  /* 16 */
+    if (fp) fclose(fp);
+
+#if  HAVE_LIBTIFF
+        /* Make the multipage tiff on one thread and on four threads */
+    l_setParallelThreads(1);
+    writeMultipageTiffSA(sa, "/tmp/lept/multipage/tiff1.tif");
+    l_setParallelThreads(4);
+    writeMultipageTiffSA(sa, "/tmp/lept/multipage/tiff4.tif");
+    l_setParallelThreads(nthreads);
+    tdata1 = l_binaryRead("/tmp/lept/multipage/tiff1.tif", &tsize1);
+    tdata2 = l_binaryRead("/tmp/lept/multipage/tiff4.tif", &tsize2);
+    same = (tsize1 == tsize2 && !memcmp(tdata1, tdata2, tsize1));
+    regTestCompareValues(rp, 1, same, 0.0);  /* 17 */
+    lept_free(tdata1);
+    lept_free(tdata2);
+
+        /* The pages are in order, and are lossless */
+    pixa1 = pixaReadMultipageTiff("/tmp/lept/multipage/tiff4.tif");
+    npages = pixaGetCount(pixa1);
+    regTestCompareValues(rp, pixaGetCount(pixa), npages, 0.0);  /* 18 */
+    for (i = 0; i < npages; i++) {
+        pix = pixaGetPix(pixa, i, L_CLONE);
+        pix1 = pixaGetPix(pixa1, i, L_CLONE);
+        pixEqual(pix, pix1, &same);
+        if (!same) {
+            fprintf(stderr, "Page %d of multipage tiff is wrong\n", i);
+            rp->success = FALSE;
+        }
+        pixDestroy(&pix);
+        pixDestroy(&pix1);
+    }
+    pixaDestroy(&pixa1);
+#endif  /* HAVE_LIBTIFF */
+
+    sarrayDestroy(&sa);
+    pixaDestroy(&pixa);
+    return regTestCleanup(rp);
+}
+
+
+    /* Makes a pdf from the files, from the unscaled files, and from
+     * the images, with pages that don't need tiff g4 encoding. */
+static l_int32
+MakePdfs(SARRAY    *sa,
+         PIXA      *pixa,
+         l_uint8  **pdata1,
+         size_t    *psize1,
+         l_uint8  **pdata2,
+         size_t    *psize2,
+         l_uint8  **pdata3,
+         size_t    *psize3)
+{
+    saConvertFilesToPdfData(sa, 100, 0.7, 0, 0, NULL, pdata1, psize1);
+    saConvertUnscaledFilesToPdfData(sa, "multipage", pdata2, psize2);
+    pixaConvertToPdfData(pixa, 100, 1.0, L_FLATE_ENCODE, 0, "pixa",
+                         pdata3, psize3);
+    return 0;
+}
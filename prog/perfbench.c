@@ -0,0 +1,833 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ * perfbench.c
+ *
+ *   Benchmarks for the hot paths of the library, with the results
+ *   written as JSON.
+ *
+ *   Syntax: perfbench [-t seconds] [-n maxiters] [-j nthreads]
+ *                     [-f filter] [-o fileout] [-b baseline] [-r ratio]
+ *
+ *      -t  minimum time spent timing each benchmark (default 1.0 sec)
+ *      -n  maximum number of timed iterations of each benchmark
+ *          (default 1000)
+ *      -j  number of threads for the functions that can use them;
+ *          see l_setParallelThreads() (default 1)
+ *      -f  only run the benchmarks whose name contains this string
+ *      -o  write the JSON to this file instead of to stdout
+ *      -b  compare with the JSON from an earlier run
+ *      -r  with -b, a benchmark has regressed if its throughput is
+ *          less than this fraction of the baseline (default 0.9)
+ *
+ *   It must be run from the prog directory, which has the images
+ *   from which the fixtures are made:
+ *
+ *      text-150, text-300, text-600   scanned text page (rabi.png)
+ *                                     at 150, 300 and 600 ppi, 1 bpp
+ *      gray-page                      scanned text page, 8 bpp
+ *      photo                          photograph, 32 bpp rgb
+ *      cmap-photo                     the photo quantized to 8 bpp
+ *                                     with a colormap
+ *      news-150, news-300             the photo as a binary halftone,
+ *                                     as in newsprint, at 150 and 300 ppi
+ *
+ *   Each benchmark is run once to warm up, and then repeatedly until
+ *   it has been timed for at least the minimum time and at least
+ *   MinIters times, or for the maximum number of iterations.  For each
+ *   one it reports:
+ *
+ *      mpix_per_sec        megapixels of input per second, using the
+ *                          median time
+ *      ms_min, ms_mean, ms_p50, ms_p90, ms_p99
+ *                          latency in milliseconds
+ *      allocs_per_iter, bytes_per_iter
+ *                          number and total size of the pix data
+ *                          allocations per iteration, which are counted
+ *                          with setPixMemoryManager()
+ *
+ *   Benchmarks that can't be run (e.g., for a codec that isn't in this
+ *   build) are written with "status": "skipped".  Each benchmark is on
+ *   a single line of the output, to make it easy to grep and diff.
+ *
+ *   With -b, every benchmark that is slower than the baseline by more
+ *   than the ratio, or that makes more pix allocations per iteration,
+ *   is listed on stderr, and the program returns 1.  This can be used
+ *   to gate an upgrade on performance regressions.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Fixtures */
+enum {
+    TEXT_150 = 0,
+    TEXT_300 = 1,
+    TEXT_600 = 2,
+    GRAY_PAGE = 3,
+    PHOTO = 4,
+    CMAP_PHOTO = 5,
+    NEWS_150 = 6,
+    NEWS_300 = 7,
+    NFixtures = 8
+};
+
+static const char *FixtureNames[] = {"text-150", "text-300", "text-600",
+                                     "gray-page", "photo", "cmap-photo",
+                                     "news-150", "news-300"};
+
+    /* Input to one run of a benchmark function */
+struct BenchRun
+{
+    PIX          *pixs;       /* fixture                                 */
+    l_int32       param;      /* integer parameter for the function      */
+    l_float32     fparam;     /* float parameter for the function        */
+    l_uint8      *data;       /* pixs encoded with format @param, for    */
+    size_t        size;       /*   the decoding benchmarks               */
+};
+typedef struct BenchRun  BENCHRUN;
+
+    /* A benchmark function returns 0 if OK, 1 on error */
+typedef l_int32 (*BENCHFUNC)(BENCHRUN *br);
+
+struct BenchCase
+{
+    const char   *name;
+    l_int32       fixture;
+    BENCHFUNC     func;
+    l_int32       param;
+    l_float32     fparam;
+    l_int32       encode;     /* 1 if @pixs must be encoded with format  */
+                              /*   @param before it is run               */
+};
+typedef struct BenchCase  BENCHCASE;
+
+static l_int32 RunScale(BENCHRUN *br);
+static l_int32 RunScaleToGray4(BENCHRUN *br);
+static l_int32 RunRotateOrth(BENCHRUN *br);
+static l_int32 RunRotate(BENCHRUN *br);
+static l_int32 RunDilateBrick(BENCHRUN *br);
+static l_int32 RunOpenBrick(BENCHRUN *br);
+static l_int32 RunDilateBrickDwa(BENCHRUN *br);
+static l_int32 RunOpenBrickDwa(BENCHRUN *br);
+static l_int32 RunDilateGray(BENCHRUN *br);
+static l_int32 RunConnCompBB(BENCHRUN *br);
+static l_int32 RunConnCompPixa(BENCHRUN *br);
+static l_int32 RunThreshold(BENCHRUN *br);
+static l_int32 RunOtsu(BENCHRUN *br);
+static l_int32 RunSauvola(BENCHRUN *br);
+static l_int32 RunDither(BENCHRUN *br);
+static l_int32 RunOctreeQuant(BENCHRUN *br);
+static l_int32 RunOctcubeQuant256(BENCHRUN *br);
+static l_int32 RunMedianCutQuant(BENCHRUN *br);
+static l_int32 RunEncode(BENCHRUN *br);
+static l_int32 RunDecode(BENCHRUN *br);
+
+static const BENCHCASE Cases[] = {
+    {"scale.gray_0.5", GRAY_PAGE, RunScale, 0, 0.5, 0},
+    {"scale.gray_2.0", GRAY_PAGE, RunScale, 0, 2.0, 0},
+    {"scale.rgb_0.5", PHOTO, RunScale, 0, 0.5, 0},
+    {"scale.rgb_2.0", PHOTO, RunScale, 0, 2.0, 0},
+    {"scale.binary_0.6", TEXT_300, RunScale, 0, 0.6, 0},
+    {"scale.to_gray4", TEXT_300, RunScaleToGray4, 0, 0.0, 0},
+    {"scale.to_gray4", TEXT_600, RunScaleToGray4, 0, 0.0, 0},
+    {"rotate.orth_90", TEXT_300, RunRotateOrth, 1, 0.0, 0},
+    {"rotate.orth_90", PHOTO, RunRotateOrth, 1, 0.0, 0},
+    {"rotate.shear_2deg", TEXT_300, RunRotate, L_ROTATE_SHEAR, 0.035, 0},
+    {"rotate.areamap_2deg", GRAY_PAGE, RunRotate, L_ROTATE_AREA_MAP,
+     0.035, 0},
+    {"rotate.areamap_2deg", PHOTO, RunRotate, L_ROTATE_AREA_MAP, 0.035, 0},
+    {"morph.dilate_brick_7", TEXT_150, RunDilateBrick, 7, 0.0, 0},
+    {"morph.dilate_brick_7", TEXT_300, RunDilateBrick, 7, 0.0, 0},
+    {"morph.dilate_brick_7", TEXT_600, RunDilateBrick, 7, 0.0, 0},
+    {"morph.open_brick_25", TEXT_300, RunOpenBrick, 25, 0.0, 0},
+    {"morph.dilate_brick_dwa_7", TEXT_150, RunDilateBrickDwa, 7, 0.0, 0},
+    {"morph.dilate_brick_dwa_7", TEXT_300, RunDilateBrickDwa, 7, 0.0, 0},
+    {"morph.dilate_brick_dwa_7", TEXT_600, RunDilateBrickDwa, 7, 0.0, 0},
+    {"morph.open_brick_dwa_25", TEXT_300, RunOpenBrickDwa, 25, 0.0, 0},
+    {"morph.dilate_gray_7", GRAY_PAGE, RunDilateGray, 7, 0.0, 0},
+    {"conncomp.bb_8", TEXT_150, RunConnCompBB, 8, 0.0, 0},
+    {"conncomp.bb_8", TEXT_300, RunConnCompBB, 8, 0.0, 0},
+    {"conncomp.bb_8", TEXT_600, RunConnCompBB, 8, 0.0, 0},
+    {"conncomp.bb_8", NEWS_150, RunConnCompBB, 8, 0.0, 0},
+    {"conncomp.bb_8", NEWS_300, RunConnCompBB, 8, 0.0, 0},
+    {"conncomp.pixa_4", TEXT_300, RunConnCompPixa, 4, 0.0, 0},
+    {"binarize.threshold", GRAY_PAGE, RunThreshold, 128, 0.0, 0},
+    {"binarize.otsu_adaptive", GRAY_PAGE, RunOtsu, 0, 0.0, 0},
+    {"binarize.sauvola", GRAY_PAGE, RunSauvola, 7, 0.34, 0},
+    {"binarize.dither", GRAY_PAGE, RunDither, 0, 0.0, 0},
+    {"quantize.octree_128", PHOTO, RunOctreeQuant, 128, 0.0, 0},
+    {"quantize.octcube_256", PHOTO, RunOctcubeQuant256, 0, 0.0, 0},
+    {"quantize.median_cut", PHOTO, RunMedianCutQuant, 0, 0.0, 0},
+    {"codec.png_encode", TEXT_300, RunEncode, IFF_PNG, 0.0, 0},
+    {"codec.png_decode", TEXT_300, RunDecode, IFF_PNG, 0.0, 1},
+    {"codec.png_encode", GRAY_PAGE, RunEncode, IFF_PNG, 0.0, 0},
+    {"codec.png_decode", GRAY_PAGE, RunDecode, IFF_PNG, 0.0, 1},
+    {"codec.png_encode", PHOTO, RunEncode, IFF_PNG, 0.0, 0},
+    {"codec.png_decode", PHOTO, RunDecode, IFF_PNG, 0.0, 1},
+    {"codec.jpeg_encode", GRAY_PAGE, RunEncode, IFF_JFIF_JPEG, 0.0, 0},
+    {"codec.jpeg_decode", GRAY_PAGE, RunDecode, IFF_JFIF_JPEG, 0.0, 1},
+    {"codec.jpeg_encode", PHOTO, RunEncode, IFF_JFIF_JPEG, 0.0, 0},
+    {"codec.jpeg_decode", PHOTO, RunDecode, IFF_JFIF_JPEG, 0.0, 1},
+    {"codec.tiff_g4_encode", TEXT_300, RunEncode, IFF_TIFF_G4, 0.0, 0},
+    {"codec.tiff_g4_decode", TEXT_300, RunDecode, IFF_TIFF_G4, 0.0, 1},
+    {"codec.tiff_g4_encode", NEWS_300, RunEncode, IFF_TIFF_G4, 0.0, 0},
+    {"codec.tiff_g4_decode", NEWS_300, RunDecode, IFF_TIFF_G4, 0.0, 1},
+    {"codec.tiff_zip_encode", PHOTO, RunEncode, IFF_TIFF_ZIP, 0.0, 0},
+    {"codec.tiff_zip_decode", PHOTO, RunDecode, IFF_TIFF_ZIP, 0.0, 1},
+    {"codec.pnm_encode", PHOTO, RunEncode, IFF_PNM, 0.0, 0},
+    {"codec.pnm_decode", PHOTO, RunDecode, IFF_PNM, 0.0, 1},
+    {"codec.bmp_encode", PHOTO, RunEncode, IFF_BMP, 0.0, 0},
+    {"codec.bmp_decode", PHOTO, RunDecode, IFF_BMP, 0.0, 1},
+    {"codec.gif_encode", CMAP_PHOTO, RunEncode, IFF_GIF, 0.0, 0},
+    {"codec.gif_decode", CMAP_PHOTO, RunDecode, IFF_GIF, 0.0, 1},
+    {"codec.webp_encode", PHOTO, RunEncode, IFF_WEBP, 0.0, 0},
+    {"codec.webp_decode", PHOTO, RunDecode, IFF_WEBP, 0.0, 1},
+    {"codec.jp2k_encode", PHOTO, RunEncode, IFF_JP2, 0.0, 0},
+    {"codec.jp2k_decode", PHOTO, RunDecode, IFF_JP2, 0.0, 1},
+    {"codec.spix_encode", PHOTO, RunEncode, IFF_SPIX, 0.0, 0},
+    {"codec.spix_decode", PHOTO, RunDecode, IFF_SPIX, 0.0, 1}};
+
+static const l_int32  MinIters = 5;
+
+    /* Counters for the pix data allocations */
+static L_MUTEX  *AllocMutex = NULL;
+static l_int64   AllocCount = 0;
+static l_int64   AllocBytes = 0;
+
+static PIXA *MakeFixtures(void);
+static l_int32 RunCase(const BENCHCASE *bc, PIX *pixs, l_float32 mintime,
+                       l_int32 maxiters, FILE *fp, const char *baseline,
+                       l_float32 ratio, l_int32 *pregressed);
+static l_float64 GetTimeMs(void);
+static void *CountingAlloc(size_t size);
+static void CountingDealloc(void *ptr);
+static void WriteJsonString(FILE *fp, const char *str);
+static l_int32 FindBaselineValue(const char *baseline, const char *name,
+                                 const char *fixture, const char *field,
+                                 l_float32 *pval);
+static const char *SimdModeName(l_int32 mode);
+
+
+int main(int    argc,
+         char **argv)
+{
+char         *fileout, *filter, *basefile, *baseline, *str;
+l_int32       i, n, ncases, maxiters, nthreads, first, regressed, nregress;
+l_float32     mintime, ratio;
+size_t        nbytes;
+FILE         *fp;
+PIX          *pix;
+PIXA         *pixa;
+static char   mainName[] = "perfbench";
+
+    mintime = 1.0;
+    maxiters = 1000;
+    nthreads = 1;
+    ratio = 0.9;
+    filter = fileout = basefile = NULL;
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) break;
+        if (!strcmp(argv[i], "-t"))
+            mintime = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-n"))
+            maxiters = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-j"))
+            nthreads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-f"))
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "-o"))
+            fileout = argv[++i];
+        else if (!strcmp(argv[i], "-b"))
+            basefile = argv[++i];
+        else if (!strcmp(argv[i], "-r"))
+            ratio = atof(argv[++i]);
+        else
+            break;
+    }
+    if (i < argc || mintime < 0.0 || maxiters < MinIters || nthreads < 1) {
+        fprintf(stderr,
+                "Syntax: perfbench [-t seconds] [-n maxiters] [-j nthreads]\n"
+                "                  [-f filter] [-o fileout] [-b baseline]"
+                " [-r ratio]\n");
+        return 1;
+    }
+
+    baseline = NULL;
+    if (basefile) {
+        if ((baseline = (char *)l_binaryRead(basefile, &nbytes)) == NULL)
+            return ERROR_INT("baseline not read", mainName, 1);
+    }
+
+        /* Informational messages from the library would be timed */
+    setMsgSeverity(L_SEVERITY_WARNING);
+
+        /* Count the pix data allocations from here on */
+    AllocMutex = l_mutexCreate();
+    setPixMemoryManager(CountingAlloc, CountingDealloc);
+    l_setParallelThreads(nthreads);
+
+    if ((pixa = MakeFixtures()) == NULL)
+        return ERROR_INT("fixtures not made; run from prog", mainName, 1);
+
+    if (fileout)
+        fp = fopenWriteStream(fileout, "w");
+    else
+        fp = stdout;
+    if (!fp)
+        return ERROR_INT("output stream not opened", mainName, 1);
+
+    fprintf(fp, "{\n  \"library\": ");
+    str = getLeptonicaVersion();
+    WriteJsonString(fp, str);
+    lept_free(str);
+    fprintf(fp, ",\n  \"imagelibs\": ");
+    str = getImagelibVersions();
+    WriteJsonString(fp, str ? str : "");
+    lept_free(str);
+    fprintf(fp, ",\n  \"threads\": %d,\n  \"simd\": \"%s\",\n"
+            "  \"min_time_sec\": %.3f,\n  \"max_iters\": %d,\n"
+            "  \"benchmarks\": [\n", nthreads,
+            SimdModeName(l_getSimdMode()), mintime, maxiters);
+
+    ncases = sizeof(Cases) / sizeof(BENCHCASE);
+    first = TRUE;
+    nregress = 0;
+    for (i = 0; i < ncases; i++) {
+        if (filter && !strstr(Cases[i].name, filter))
+            continue;
+        if (!first) fprintf(fp, ",\n");
+        first = FALSE;
+        pix = pixaGetPix(pixa, Cases[i].fixture, L_CLONE);
+        RunCase(&Cases[i], pix, mintime, maxiters, fp, baseline, ratio,
+                &regressed);
+        nregress += regressed;
+        pixDestroy(&pix);
+        fflush(fp);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    if (fp != stdout)
+        fclose(fp);
+
+    pixaDestroy(&pixa);
+    lept_free(baseline);
+    setPixMemoryManager(malloc, free);
+    l_mutexDestroy(&AllocMutex);
+
+    if (basefile) {
+        n = nregress;
+        fprintf(stderr, "%d benchmark%s regressed\n", n, (n == 1) ? "" : "s");
+        return (n > 0) ? 1 : 0;
+    }
+    return 0;
+}
+
+
+    /* Makes the fixtures, in the order of the enum */
+static PIXA *
+MakeFixtures(void)
+{
+PIX   *pixt, *pixg, *pixc, *pix1, *pix2, *pix3;
+PIXA  *pixa;
+
+    if ((pixt = pixRead("rabi.png")) == NULL)
+        return NULL;
+    if ((pixg = pixRead("lucasta.047.jpg")) == NULL) {
+        pixDestroy(&pixt);
+        return NULL;
+    }
+    if ((pixc = pixRead("test24.jpg")) == NULL) {
+        pixDestroy(&pixt);
+        pixDestroy(&pixg);
+        return NULL;
+    }
+
+    pixa = pixaCreate(NFixtures);
+    pix1 = pixScaleBinary(pixt, 0.5, 0.5);
+    pixSetResolution(pix1, 150, 150);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixSetResolution(pixt, 300, 300);
+    pixaAddPix(pixa, pixt, L_COPY);
+    pix1 = pixExpandBinaryPower2(pixt, 2);
+    pixSetResolution(pix1, 600, 600);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixaAddPix(pixa, pixg, L_INSERT);
+    pixaAddPix(pixa, pixc, L_COPY);
+    pix1 = pixOctreeColorQuant(pixc, 240, 0);
+    pixaAddPix(pixa, pix1, L_INSERT);
+
+        /* The halftones are dithered from the luminance of the photo,
+         * taken to be at 75 ppi */
+    pix1 = pixConvertRGBToLuminance(pixc);
+    pix2 = pixScaleGrayLI(pix1, 2.0, 2.0);
+    pix3 = pixDitherToBinary(pix2);
+    pixSetResolution(pix3, 150, 150);
+    pixaAddPix(pixa, pix3, L_INSERT);
+    pixDestroy(&pix2);
+    pix2 = pixScaleGrayLI(pix1, 4.0, 4.0);
+    pix3 = pixDitherToBinary(pix2);
+    pixSetResolution(pix3, 300, 300);
+    pixaAddPix(pixa, pix3, L_INSERT);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pixt);
+    pixDestroy(&pixc);
+    return pixa;
+}
+
+
+    /* Times one benchmark, and writes its results as one line of json */
+static l_int32
+RunCase(const BENCHCASE  *bc,
+        PIX              *pixs,
+        l_float32         mintime,
+        l_int32           maxiters,
+        FILE             *fp,
+        const char       *baseline,
+        l_float32         ratio,
+        l_int32          *pregressed)
+{
+l_int32    w, h, d, niters, ret, sev;
+l_float32  sum, mint, p50, p90, p99, mpix, mpix0, nalloc, nalloc0;
+l_float64  t0, t1, total;
+l_int64    count, bytes;
+BENCHRUN   br;
+NUMA      *na;
+
+    *pregressed = 0;
+    pixGetDimensions(pixs, &w, &h, &d);
+    fprintf(fp, "    {\"name\": \"%s\", \"fixture\": \"%s\", \"width\": %d, "
+            "\"height\": %d, \"depth\": %d, ", bc->name,
+            FixtureNames[bc->fixture], w, h, d);
+
+        /* Set up, and do the warmup run.  Errors from codecs that are
+         * not in this build are expected, so they are not shown. */
+    memset(&br, 0, sizeof(BENCHRUN));
+    br.pixs = pixs;
+    br.param = bc->param;
+    br.fparam = bc->fparam;
+    sev = setMsgSeverity(L_SEVERITY_NONE);
+    ret = 0;
+    if (bc->encode)
+        ret = pixWriteMem(&br.data, &br.size, pixs, bc->param);
+    if (!ret)
+        ret = bc->func(&br);
+    setMsgSeverity(sev);
+    if (ret) {
+        fprintf(fp, "\"status\": \"skipped\"}");
+        fprintf(stderr, "%-26s %-10s skipped\n", bc->name,
+                FixtureNames[bc->fixture]);
+        lept_free(br.data);
+        return 0;
+    }
+
+    na = numaCreate(0);
+    total = 0.0;
+    l_mutexLock(AllocMutex);
+    AllocCount = AllocBytes = 0;
+    l_mutexUnlock(AllocMutex);
+    for (niters = 0; niters < maxiters; niters++) {
+        if (niters >= MinIters && total >= 1000.0 * mintime)
+            break;
+        t0 = GetTimeMs();
+        ret |= bc->func(&br);
+        t1 = GetTimeMs();
+        numaAddNumber(na, t1 - t0);
+        total += t1 - t0;
+    }
+    l_mutexLock(AllocMutex);
+    count = AllocCount;
+    bytes = AllocBytes;
+    l_mutexUnlock(AllocMutex);
+    lept_free(br.data);
+
+    numaGetMin(na, &mint, NULL);
+    numaGetSum(na, &sum);
+    numaGetRankValue(na, 0.5, NULL, 0, &p50);
+    numaGetRankValue(na, 0.9, NULL, 0, &p90);
+    numaGetRankValue(na, 0.99, NULL, 0, &p99);
+    numaDestroy(&na);
+    mpix = (l_float32)w * h / (1000.0 * L_MAX(p50, 0.001));
+    nalloc = (l_float32)count / niters;
+    fprintf(fp, "\"status\": \"%s\", \"iterations\": %d, "
+            "\"mpix_per_sec\": %.3f, \"ms_min\": %.4f, \"ms_mean\": %.4f, "
+            "\"ms_p50\": %.4f, \"ms_p90\": %.4f, \"ms_p99\": %.4f, "
+            "\"allocs_per_iter\": %.2f, \"bytes_per_iter\": %.0f}",
+            (ret) ? "error" : "ok", niters, mpix, mint, sum / niters,
+            p50, p90, p99, nalloc, (l_float64)bytes / niters);
+    fprintf(stderr, "%-26s %-10s %10.3f Mpix/s  p50 %9.3f ms  p99 %9.3f ms\n",
+            bc->name, FixtureNames[bc->fixture], mpix, p50, p99);
+
+        /* Compare with the baseline */
+    if (baseline) {
+        if (!FindBaselineValue(baseline, bc->name, FixtureNames[bc->fixture],
+                               "mpix_per_sec", &mpix0) &&
+            mpix < ratio * mpix0) {
+            fprintf(stderr, "  REGRESSION: %.3f Mpix/s; baseline %.3f\n",
+                    mpix, mpix0);
+            *pregressed = 1;
+        }
+        if (!FindBaselineValue(baseline, bc->name, FixtureNames[bc->fixture],
+                               "allocs_per_iter", &nalloc0) &&
+            nalloc > nalloc0 + 0.5) {
+            fprintf(stderr, "  REGRESSION: %.2f allocs/iter; baseline %.2f\n",
+                    nalloc, nalloc0);
+            *pregressed = 1;
+        }
+    }
+    return ret;
+}
+
+
+static l_float64
+GetTimeMs(void)
+{
+l_int32  sec, usec;
+
+    l_getCurrentTime(&sec, &usec);
+    return 1000.0 * sec + 0.001 * usec;
+}
+
+
+static void *
+CountingAlloc(size_t  size)
+{
+    l_mutexLock(AllocMutex);
+    AllocCount++;
+    AllocBytes += size;
+    l_mutexUnlock(AllocMutex);
+    return malloc(size);
+}
+
+
+static void
+CountingDealloc(void  *ptr)
+{
+    free(ptr);
+}
+
+
+static void
+WriteJsonString(FILE        *fp,
+                const char  *str)
+{
+const char  *p;
+
+    fputc('"', fp);
+    for (p = str; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(fp, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20)
+            fputc(' ', fp);
+        else
+            fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+
+    /* Finds a numeric field in the line of the baseline json that has
+     * this benchmark.  Returns 1 if not found. */
+static l_int32
+FindBaselineValue(const char  *baseline,
+                  const char  *name,
+                  const char  *fixture,
+                  const char  *field,
+                  l_float32   *pval)
+{
+char         key[256];
+const char  *p, *eol;
+
+    *pval = 0.0;
+    snprintf(key, sizeof(key), "\"name\": \"%s\", \"fixture\": \"%s\"",
+             name, fixture);
+    if ((p = strstr(baseline, key)) == NULL)
+        return 1;
+    if ((eol = strchr(p, '\n')) == NULL)
+        eol = p + strlen(p);
+    snprintf(key, sizeof(key), "\"%s\": ", field);
+    if ((p = strstr(p, key)) == NULL || p > eol)
+        return 1;
+    if (sscanf(p + strlen(key), "%f", pval) != 1)
+        return 1;
+    return 0;
+}
+
+
+static const char *
+SimdModeName(l_int32  mode)
+{
+    switch (mode) {
+    case L_SIMD_SSE2: return "sse2";
+    case L_SIMD_AVX2: return "avx2";
+    case L_SIMD_NEON: return "neon";
+    default: return "none";
+    }
+}
+
+
+/* --------------------------------------------------------------------- *
+ *                          Benchmark functions                          *
+ * --------------------------------------------------------------------- */
+static l_int32
+RunScale(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = pixScale(br->pixs, br->fparam, br->fparam);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunScaleToGray4(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixScaleToGray4(br->pixs)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunRotateOrth(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixRotateOrth(br->pixs, br->param)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunRotate(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = pixRotate(br->pixs, br->fparam, br->param, L_BRING_IN_WHITE, 0, 0);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunDilateBrick(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = pixDilateBrick(NULL, br->pixs, br->param, br->param);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunOpenBrick(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixOpenBrick(NULL, br->pixs, br->param, 1)) == NULL)
+        return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunDilateBrickDwa(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = pixDilateBrickDwa(NULL, br->pixs, br->param, br->param);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunOpenBrickDwa(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixOpenBrickDwa(NULL, br->pixs, br->param, 1)) == NULL)
+        return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunDilateGray(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = pixDilateGray(br->pixs, br->param, br->param);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunConnCompBB(BENCHRUN  *br)
+{
+BOXA  *boxa;
+
+    if ((boxa = pixConnCompBB(br->pixs, br->param)) == NULL) return 1;
+    boxaDestroy(&boxa);
+    return 0;
+}
+
+
+static l_int32
+RunConnCompPixa(BENCHRUN  *br)
+{
+BOXA  *boxa;
+PIXA  *pixa;
+
+    if ((boxa = pixConnComp(br->pixs, &pixa, br->param)) == NULL) return 1;
+    boxaDestroy(&boxa);
+    pixaDestroy(&pixa);
+    return 0;
+}
+
+
+static l_int32
+RunThreshold(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixThresholdToBinary(br->pixs, br->param)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunOtsu(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = NULL;
+    pixOtsuAdaptiveThreshold(br->pixs, 300, 300, 0, 0, 0.1, NULL, &pixd);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunSauvola(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    pixd = NULL;
+    pixSauvolaBinarize(br->pixs, br->param, br->fparam, 1, NULL, NULL,
+                       NULL, &pixd);
+    if (!pixd) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunDither(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixDitherToBinary(br->pixs)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunOctreeQuant(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixOctreeColorQuant(br->pixs, br->param, 0)) == NULL)
+        return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunOctcubeQuant256(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixFixedOctcubeQuant256(br->pixs, 0)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunMedianCutQuant(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixMedianCutQuant(br->pixs, 0)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
+
+
+static l_int32
+RunEncode(BENCHRUN  *br)
+{
+l_uint8  *data;
+size_t    size;
+
+    data = NULL;
+    if (pixWriteMem(&data, &size, br->pixs, br->param)) {
+        lept_free(data);
+        return 1;
+    }
+    lept_free(data);
+    return 0;
+}
+
+
+static l_int32
+RunDecode(BENCHRUN  *br)
+{
+PIX  *pixd;
+
+    if ((pixd = pixReadMem(br->data, br->size)) == NULL) return 1;
+    pixDestroy(&pixd);
+    return 0;
+}
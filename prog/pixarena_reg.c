@@ -0,0 +1,166 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   pixarena_reg.c
+ *
+ *   Tests the per-thread pix memory arenas.
+ *
+ *   The same operations are done serially and on several threads,
+ *   with the pix destroyed by the main thread, so that chunks are
+ *   freed by threads other than the ones that allocated them.
+ *   The results must be the same, and all the memory must be
+ *   accounted for when the pix have been destroyed.
+ *
+ *   Then the arenas are made again with a small bound on the memory
+ *   that they can hold, and we check that the bound is respected.
+ */
+
+#include "allheaders.h"
+
+#define  NTASKS   24
+
+    /* Input and output for the tasks */
+struct ArenaTestData
+{
+    PIX   *pixs;
+    PIX  **pixd;
+};
+typedef struct ArenaTestData  ARENATESTDATA;
+
+static l_int32 ProcessImage(void *data, l_int32 index);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32        i, same, eq, narenas, nthreads;
+size_t         nalloc, nreuse, nremote, inuse, inuse0, retained;
+PIX           *pixs, *pix1;
+PIX           *pixd1[NTASKS], *pixd2[NTASKS];
+PIXA          *pixa;
+ARENATESTDATA  atd;
+L_REGPARAMS   *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* Set up the arenas before making any pix */
+    pmaCreate(0, 0, 0);
+    setPixMemoryManager(pmaCustomAlloc, pmaCustomDealloc);
+    pixs = pixRead("test24.jpg");
+    pmaGetStats(NULL, NULL, NULL, NULL, &inuse0, NULL);
+
+        /* Serially, then on several threads */
+    nthreads = l_getParallelThreads();
+    atd.pixs = pixs;
+    atd.pixd = pixd1;
+    l_parallelRun(NTASKS, 1, ProcessImage, &atd);
+    l_setParallelThreads(4);
+    atd.pixd = pixd2;
+    l_parallelRun(NTASKS, 0, ProcessImage, &atd);
+    l_setParallelThreads(nthreads);
+    same = TRUE;
+    for (i = 0; i < NTASKS; i++) {
+        pixEqual(pixd1[i], pixd2[i], &eq);
+        if (!eq) same = FALSE;
+    }
+    regTestCompareValues(rp, TRUE, same, 0.0);  /* 0 */
+
+        /* Display some results, then destroy them all */
+    pixa = pixaCreate(0);
+    for (i = 0; i < 4; i++)
+        pixSaveTiled(pixd2[i], pixa, 1.0, (i == 0), 20, 32);
+    pix1 = pixaDisplay(pixa, 0, 0);
+    pixDisplayWithTitle(pix1, 100, 100, "arena", rp->display);
+    pixDestroy(&pix1);
+    pixaDestroy(&pixa);
+    for (i = 0; i < NTASKS; i++) {
+        pixDestroy(&pixd1[i]);
+        pixDestroy(&pixd2[i]);
+    }
+
+        /* Only pixs is in use; the other chunks were reused */
+    pmaGetStats(&narenas, &nalloc, &nreuse, &nremote, &inuse, &retained);
+    if (rp->display) pmaLogInfo();
+    regTestCompareValues(rp, inuse0, inuse, 0.0);  /* 1 */
+    regTestCompareValues(rp, TRUE, nreuse > 0, 0.0);  /* 2 */
+    regTestCompareValues(rp, TRUE, nalloc >= 4 * NTASKS, 0.0);  /* 3 */
+    regTestCompareValues(rp, TRUE, retained > 0, 0.0);  /* 4 */
+    pmaTrim();
+    pmaGetStats(NULL, NULL, NULL, NULL, NULL, &retained);
+    regTestCompareValues(rp, 0, retained, 0.0);  /* 5 */
+    pixDestroy(&pixs);
+    pmaGetStats(NULL, NULL, NULL, NULL, &inuse, NULL);
+    regTestCompareValues(rp, 0, inuse, 0.0);  /* 6 */
+    pmaDestroy();
+
+        /* Arenas that hold at most 1 MB of free chunks */
+    pmaCreate(1024, 0, 1000000);
+    pixs = pixRead("test24.jpg");  /* about 1.2 MB */
+    pix1 = pixCopy(NULL, pixs);
+    pixDestroy(&pix1);
+    pmaGetStats(NULL, NULL, NULL, NULL, NULL, &retained);
+    regTestCompareValues(rp, 0, retained, 0.0);  /* 7 */
+    for (i = 0; i < 3; i++) {
+        pix1 = pixScale(pixs, 0.5, 0.5);  /* about 0.3 MB */
+        pixDestroy(&pix1);
+    }
+    pmaGetStats(NULL, NULL, &nreuse, NULL, &inuse, &retained);
+    regTestCompareValues(rp, TRUE, nreuse > 0, 0.0);  /* 8 */
+    regTestCompareValues(rp, TRUE, retained <= 1000000, 0.0);  /* 9 */
+    pixDestroy(&pixs);
+    pmaGetStats(NULL, NULL, NULL, NULL, &inuse, &retained);
+    regTestCompareValues(rp, 0, inuse, 0.0);  /* 10 */
+    regTestCompareValues(rp, TRUE, retained <= 1000000, 0.0);  /* 11 */
+    pmaDestroy();
+    setPixMemoryManager(malloc, free);
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Makes several temporary pix of different sizes, and returns one */
+static l_int32
+ProcessImage(void     *data,
+             l_int32   index)
+{
+l_float32       scale;
+PIX            *pix1, *pix2, *pix3;
+ARENATESTDATA  *atd;
+
+    atd = (ARENATESTDATA *)data;
+    scale = 0.2 + 0.05 * (index % 8);
+    pix1 = pixScale(atd->pixs, scale, scale);
+    pix2 = pixConvertRGBToLuminance(pix1);
+    pix3 = pixDilateGray(pix2, 3, 5);
+    atd->pixd[index] = pixRotate90(pix3, index % 2 ? 1 : -1);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    return 0;
+}
@@ -0,0 +1,239 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   pixview_reg.c
+ *
+ *   Tests views of rectangles in a pix, and of a buffer that the pix
+ *   does not own.  The results of functions on a view are compared
+ *   with the same functions on a clipped copy.  A rectangle that does
+ *   not start on a word boundary gives a copy instead of a view.
+ */
+
+#include "allheaders.h"
+
+static const l_int32 BoxX[] = {0, 1, 37, 64, 203};
+static const l_int32 BoxY[] = {0, 5, 20, 31, 100};
+static const l_int32 BoxW[] = {300, 99, 257, 32, 45};
+static const l_int32 BoxH[] = {200, 150, 133, 60, 29};
+
+static void CompareViews(L_REGPARAMS *rp, PIX *pixs, PIX *pixm);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, w, h, wpl, count1, count2, format;
+l_uint8      *data1, *data2;
+l_uint32     *data;
+size_t        size1, size2;
+BOX          *box;
+PIX          *pixs, *pixm, *pix1, *pix2, *pix3, *pix4;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* Views of 1, 8 and 32 bpp images, and of a colormapped one */
+    pixs = pixRead("test8.jpg");
+    pixm = pixThresholdToBinary(pixs, 130);
+    CompareViews(rp, pixm, NULL);
+    CompareViews(rp, pixs, pixm);
+    pixDestroy(&pixs);
+    pixs = pixRead("dreyfus8.png");
+    CompareViews(rp, pixs, pixm);
+    pixDestroy(&pixs);
+    pixs = pixRead("test24.jpg");
+    CompareViews(rp, pixs, NULL);
+    pixDestroy(&pixs);
+
+        /* A view of a view outlives both parents */
+    pixs = pixRead("dreyfus8.png");
+    box = boxCreate(20, 13, 200, 150);
+    pix1 = pixCreateView(pixs, box);
+    boxDestroy(&box);
+    box = boxCreate(8, 11, 100, 90);
+    pix2 = pixCreateView(pix1, box);
+    pix3 = pixCreateView(pixs, NULL);
+    pixDestroy(&pix1);
+    boxSetGeometry(box, 28, 24, -1, -1);
+    pix1 = pixClipRectangle(pixs, box, NULL);
+    pixDestroy(&pixs);
+    regTestCompareValues(rp, 1, pixIsView(pix2), 0.0);
+    regTestCompareValues(rp, 1, pixIsView(pix3), 0.0);
+    pix4 = pixCopy(NULL, pix2);
+    regTestCompareValues(rp, 0, pixIsView(pix4), 0.0);
+    regTestComparePix(rp, pix1, pix4);
+    regTestWritePixAndCheck(rp, pix4, IFF_PNG);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pix4);
+    boxDestroy(&box);
+
+        /* Writing a view at the lower right of an 8 bpp image gives
+         * the same file as writing a copy, and does not change pixs */
+    pix1 = pixRead("test8.jpg");
+    pixs = pixScaleToSize(pix1, 1000, 200);
+    pixDestroy(&pix1);
+    box = boxCreate(800, 100, 40, 100);
+    pix1 = pixCreateView(pixs, box);
+    pix2 = pixClipRectangle(pixs, box, NULL);
+    pix3 = pixCopy(NULL, pixs);
+    regTestCompareValues(rp, 1, pixIsView(pix1), 0.0);
+    for (i = 0; i < 3; i++) {
+        format = (i == 0) ? IFF_PNG : ((i == 1) ? IFF_BMP : IFF_PNM);
+        pixWriteMem(&data1, &size1, pix1, format);
+        pixWriteMem(&data2, &size2, pix2, format);
+        regTestCompareStrings(rp, data1, size1, data2, size2);
+        lept_free(data1);
+        lept_free(data2);
+    }
+    regTestWritePixAndCheck(rp, pix1, IFF_PNG);
+    regTestComparePix(rp, pix3, pixs);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pixs);
+    boxDestroy(&box);
+
+        /* A pix on an external buffer with a larger wpl */
+    pixGetDimensions(pixm, &w, &h, NULL);
+    wpl = pixGetWpl(pixm) + 5;
+    data = (l_uint32 *)lept_calloc(wpl * h, sizeof(l_uint32));
+    pix1 = pixCreateFromData(data, w, h, 1, wpl);
+    pixRasterop(pix1, 0, 0, w, h, PIX_SRC, pixm, 0, 0);
+    pixCountPixels(pixm, &count1, NULL);
+    pixCountPixels(pix1, &count2, NULL);
+    regTestCompareValues(rp, count1, count2, 0.0);
+    pix2 = pixCopy(NULL, pix1);
+    regTestComparePix(rp, pixm, pix2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pix1 = pixCreateFromData(data, w, h, 1, wpl);  /* data is not freed */
+    pixCountPixels(pix1, &count2, NULL);
+    regTestCompareValues(rp, count1, count2, 0.0);
+    pixDestroy(&pix1);
+    lept_free(data);
+    pixDestroy(&pixm);
+
+    return regTestCleanup(rp);
+}
+
+
+    /* For each box, compares the view with a clipped copy of pixs.
+     * For 8 bpp, pixm is an optional mask for the masked average. */
+static void
+CompareViews(L_REGPARAMS  *rp,
+             PIX          *pixs,
+             PIX          *pixm)
+{
+l_int32    i, n, d, count1, count2, same;
+l_uint8   *data1, *data2;
+l_uint32   pval1, pval2;
+l_float32  val1, val2;
+size_t     size1, size2;
+BOX       *box;
+NUMA      *na1, *na2;
+PIX       *pixv, *pixc, *pixmv, *pixmc, *pix1, *pix2;
+
+    d = pixGetDepth(pixs);
+    n = sizeof(BoxX) / sizeof(l_int32);
+    for (i = 0; i < n; i++) {
+        box = boxCreate(BoxX[i], BoxY[i], BoxW[i], BoxH[i]);
+        pixv = pixCreateView(pixs, box);
+        pixc = pixClipRectangle(pixs, box, NULL);
+        regTestCompareValues(rp, (BoxX[i] * d) % 32 == 0, pixIsView(pixv),
+                             0.0);
+
+            /* Copies, and pixel access */
+        pix1 = pixCopy(NULL, pixv);
+        regTestComparePix(rp, pixc, pix1);
+        pixDestroy(&pix1);
+        boxSetGeometry(box, 0, 0, -1, -1);
+        pix1 = pixClipRectangle(pixv, box, NULL);
+        regTestComparePix(rp, pixc, pix1);
+        pixDestroy(&pix1);
+        pixGetPixel(pixv, BoxW[i] / 2, BoxH[i] / 2, &pval1);
+        pixGetPixel(pixc, BoxW[i] / 2, BoxH[i] / 2, &pval2);
+        regTestCompareValues(rp, pval2, pval1, 0.0);
+        if (d >= 8) {
+            pixWriteMem(&data1, &size1, pixv, IFF_PNG);
+            pixWriteMem(&data2, &size2, pixc, IFF_PNG);
+            regTestCompareStrings(rp, data1, size1, data2, size2);
+            lept_free(data1);
+            lept_free(data2);
+        }
+        pix1 = pixScale(pixv, 0.7, 0.7);
+        pix2 = pixScale(pixc, 0.7, 0.7);
+        regTestComparePix(rp, pix2, pix1);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+
+        if (d == 1) {
+            pixCountPixels(pixv, &count1, NULL);
+            pixCountPixels(pixc, &count2, NULL);
+            regTestCompareValues(rp, count2, count1, 0.0);
+        } else if (d == 8) {
+            na1 = pixGetGrayHistogram(pixv, 1);
+            na2 = pixGetGrayHistogram(pixc, 1);
+            numaSimilar(na1, na2, 0.0, &same);
+            regTestCompareValues(rp, 1, same, 0.0);
+            numaDestroy(&na1);
+            numaDestroy(&na2);
+            boxSetGeometry(box, 3, 2, BoxW[i] - 5, BoxH[i] - 3);
+            na1 = pixGetGrayHistogramInRect(pixv, box, 2);
+            na2 = pixGetGrayHistogramInRect(pixc, box, 2);
+            numaSimilar(na1, na2, 0.0, &same);
+            regTestCompareValues(rp, 1, same, 0.0);
+            numaDestroy(&na1);
+            numaDestroy(&na2);
+
+                /* The mask is a view only if the box starts on a
+                 * word boundary at 1 bpp */
+            pixmv = pixCreateView(pixm, box);
+            pixmc = pixClipRectangle(pixm, box, NULL);
+            na1 = pixGetGrayHistogramMasked(pixv, pixmv, 1, 2, 1);
+            na2 = pixGetGrayHistogramMasked(pixc, pixmc, 1, 2, 1);
+            numaSimilar(na1, na2, 0.0, &same);
+            regTestCompareValues(rp, 1, same, 0.0);
+            numaDestroy(&na1);
+            numaDestroy(&na2);
+            pixGetAverageMasked(pixv, pixmv, 1, 2, 1, L_MEAN_ABSVAL, &val1);
+            pixGetAverageMasked(pixc, pixmc, 1, 2, 1, L_MEAN_ABSVAL, &val2);
+            regTestCompareValues(rp, val2, val1, 0.0);
+            pixGetAverageMasked(pixv, NULL, 0, 0, 1, L_VARIANCE, &val1);
+            pixGetAverageMasked(pixc, NULL, 0, 0, 1, L_VARIANCE, &val2);
+            regTestCompareValues(rp, val2, val1, 0.0);
+            pixDestroy(&pixmv);
+            pixDestroy(&pixmc);
+        }
+        pixDestroy(&pixv);
+        pixDestroy(&pixc);
+        boxDestroy(&box);
+    }
+    return;
+}
@@ -0,0 +1,175 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   rankfilter_reg.c
+ *
+ *   Tests the constant-time rank filter in pixRankFilterGray()
+ *   against a direct computation of the rank value in each window,
+ *   for a set of filter sizes and ranks.
+ *
+ *   Also tests that the results are the same with each vector
+ *   instruction set, when done on strips in parallel, and for rgb.
+ */
+
+#include "allheaders.h"
+
+static PIX *RankFilterDirect(PIX *pixs, l_int32 wf, l_int32 hf,
+                             l_float32 rank);
+
+    /* Filter sizes and ranks */
+static const l_int32  Sizes[][2] = {{3, 3}, {25, 25}, {4, 9}, {15, 2},
+                                    {1, 6}, {40, 7}};
+static const l_float32  Ranks[] = {0.5, 0.1, 0.9, 0.0, 1.0};
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, mode, same, allsame, nthreads, nsizes, nranks, wf, hf;
+l_float32     rank;
+BOX          *box;
+PIX          *pix0, *pixs, *pixc, *pix1, *pix2, *pix3;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pix0 = pixRead("test8.jpg");
+    box = boxCreate(100, 50, 133, 117);
+    pixs = pixClipRectangle(pix0, box, NULL);
+    boxDestroy(&box);
+    pixDestroy(&pix0);
+
+        /* Compare with the direct computation (0 - 29) */
+    nsizes = sizeof(Sizes) / sizeof(Sizes[0]);
+    nranks = sizeof(Ranks) / sizeof(Ranks[0]);
+    for (i = 0; i < nsizes; i++) {
+        wf = Sizes[i][0];
+        hf = Sizes[i][1];
+        for (j = 0; j < nranks; j++) {
+            rank = Ranks[j];
+            pix1 = pixRankFilterGray(pixs, wf, hf, rank);
+            pix2 = RankFilterDirect(pixs, wf, hf, rank);
+            regTestComparePix(rp, pix1, pix2);
+            pixDestroy(&pix1);
+            pixDestroy(&pix2);
+        }
+    }
+
+        /* Vector instruction sets, and strips in parallel (30 - 32) */
+    pix0 = pixRead("test8.jpg");
+    l_setSimdMode(L_SIMD_NONE);
+    pix1 = pixMedianFilter(pix0, 25, 25);
+    pix2 = pixRankFilter(pix0, 11, 4, 0.3);
+    allsame = TRUE;
+    for (mode = L_SIMD_SSE2; mode <= L_SIMD_NEON; mode++) {
+        if (!l_simdSupported(mode))
+            continue;
+        l_setSimdMode(mode);
+        pix3 = pixMedianFilter(pix0, 25, 25);
+        pixEqual(pix1, pix3, &same);
+        if (!same) allsame = FALSE;
+        pixDestroy(&pix3);
+        pix3 = pixRankFilter(pix0, 11, 4, 0.3);
+        pixEqual(pix2, pix3, &same);
+        if (!same) allsame = FALSE;
+        pixDestroy(&pix3);
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+    regTestCompareValues(rp, TRUE, allsame, 0.0);  /* 30 */
+    pixDestroy(&pix2);
+    nthreads = l_getParallelThreads();
+    l_setParallelThreads(4);
+    pix2 = pixMedianFilter(pix0, 25, 25);
+    l_setParallelThreads(nthreads);
+    regTestComparePix(rp, pix1, pix2);  /* 31 */
+    regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 32 */
+    pixDisplayWithTitle(pix1, 100, 100, "median", rp->display);
+    pixDestroy(&pix0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Each component of rgb is filtered separately (33) */
+    pix0 = pixRead("test24.jpg");
+    pixc = pixScale(pix0, 0.25, 0.25);
+    pix1 = pixMedianFilter(pixc, 9, 9);
+    pix2 = pixGetRGBComponent(pixc, COLOR_GREEN);
+    pix3 = pixMedianFilter(pix2, 9, 9);
+    pixDestroy(&pix2);
+    pix2 = pixGetRGBComponent(pix1, COLOR_GREEN);
+    regTestComparePix(rp, pix2, pix3);  /* 33 */
+    pixDestroy(&pix0);
+    pixDestroy(&pixc);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+    pixDestroy(&pixs);
+    return regTestCleanup(rp);
+}
+
+
+    /* For each pixel, counts the values in the window of the mirrored
+     * image and finds the smallest value for which the count of lower
+     * or equal values exceeds rank * wf * hf. */
+static PIX *
+RankFilterDirect(PIX       *pixs,
+                 l_int32    wf,
+                 l_int32    hf,
+                 l_float32  rank)
+{
+l_int32    i, j, k, m, w, h, rankloc, sum, val;
+l_int32    histo[256];
+PIX       *pixt, *pixd;
+
+    if (rank == 0.0) rank = 0.0001;
+    if (rank == 1.0) rank = 0.9999;
+    rankloc = (l_int32)(rank * wf * hf);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixt = pixAddMirroredBorder(pixs, wf / 2, wf / 2, hf / 2, hf / 2);
+    pixd = pixCreateTemplate(pixs);
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            for (k = 0; k < 256; k++)
+                histo[k] = 0;
+            for (k = 0; k < hf; k++) {
+                for (m = 0; m < wf; m++) {
+                    pixGetPixel(pixt, j + m, i + k, (l_uint32 *)&val);
+                    histo[val]++;
+                }
+            }
+            for (k = 0, sum = 0; k < 256; k++) {
+                sum += histo[k];
+                if (sum > rankloc) break;
+            }
+            pixSetPixel(pixd, j, i, k);
+        }
+    }
+    pixDestroy(&pixt);
+    return pixd;
+}
@@ -34,10 +34,16 @@
  *
  *     Use it on images with a significant amount of FG
  *     that extends to the edges.
+ *
+ *     It then checks that each vector kernel for the full words
+ *     (see simd.c) gives the same result as the portable code,
+ *     for every op and for all the alignment cases.
  */
 
 #include "allheaders.h"
 
+static l_int32 TestSimdModes(PIX *pixs);
+
 int main(int    argc,
          char **argv)
 {
@@ -94,5 +100,66 @@ static char  mainName[] = "rasterop_reg";
 	}
     }
     pixDestroy(&pixs);
+
+    pixs = pixRead("rabi.png");
+    if (TestSimdModes(pixs))
+        return 1;
+    pixDestroy(&pixs);
+    return 0;
+}
+
+
+    /* For each supported vector instruction set, do all rasterops
+     * with a set of src and dest offsets, and compare with the
+     * result in L_SIMD_NONE mode.  The offsets cover the aligned,
+     * vertically aligned and general cases in roplow.c. */
+static l_int32
+TestSimdModes(PIX  *pixs)
+{
+static const l_int32  offsets[] = {0, 5, 32, 45, 64};
+static const l_int32  widths[] = {200, 1000};
+l_int32  mode, op, i, j, k, w, h, same;
+PIX     *pixd, *pixd1, *pixd2;
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixd = pixRotate180(NULL, pixs);
+    for (mode = L_SIMD_SSE2; mode <= L_SIMD_NEON; mode++) {
+        if (!l_simdSupported(mode)) {
+            fprintf(stderr, "SIMD mode %d: not supported\n", mode);
+            continue;
+        }
+        for (op = 0; op < 16; op++) {
+            for (i = 0; i < 5; i++) {  /* src offset */
+                for (j = 0; j < 5; j++) {  /* dest offset */
+                    for (k = 0; k < 2; k++) {
+                        pixd1 = pixCopy(NULL, pixd);
+                        pixd2 = pixCopy(NULL, pixd);
+                        l_setSimdMode(L_SIMD_NONE);
+                        pixRasterop(pixd1, offsets[j], 20, widths[k], 300,
+                                    op, pixs, offsets[i], 10);
+                        l_setSimdMode(mode);
+                        pixRasterop(pixd2, offsets[j], 20, widths[k], 300,
+                                    op, pixs, offsets[i], 10);
+                        pixEqual(pixd1, pixd2, &same);
+                        pixDestroy(&pixd1);
+                        pixDestroy(&pixd2);
+                        if (!same) {
+                            fprintf(stderr, "Error: SIMD mode %d, op %d, "
+                                    "sx = %d, dx = %d, width = %d\n",
+                                    mode, op, offsets[i], offsets[j],
+                                    widths[k]);
+                            l_setSimdMode(L_SIMD_AUTO);
+                            pixDestroy(&pixd);
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+        fprintf(stderr, "Correct for SIMD mode %d\n", mode);
+    }
+
+    l_setSimdMode(L_SIMD_AUTO);
+    pixDestroy(&pixd);
     return 0;
 }
@@ -30,15 +30,21 @@
  *   Tests in-place operation using the general 2-image pixRasterop().
  *   The in-place operation works because there is no overlap
  *   between the src and dest rectangles.
+ *
+ *   Also tests that the in-place horizontal and vertical block
+ *   transfers give the same results with each vector kernel
+ *   (see simd.c) as with the portable code.
  */
 
 #include "allheaders.h"
 
+static PIX *ShiftBlocks(PIX *pixs, l_int32 mode);
+
 int main(int    argc,
          char **argv)
 {
-l_int32       i, j;
-PIX          *pixs, *pixt, *pixd;
+l_int32       i, j, mode;
+PIX          *pixs, *pixt, *pixd, *pix1, *pix2;
 L_REGPARAMS  *rp;
 
     if (regTestSetup(argc, argv, &rp))
@@ -73,5 +79,50 @@ L_REGPARAMS  *rp;
     pixDestroy(&pixs);
     pixDestroy(&pixt);
     pixDestroy(&pixd);
+
+        /* Compare the vector kernels with the portable code, on
+         * 1 and 8 bpp images.  If a mode is not supported, the
+         * portable result is compared with itself.  */
+    pixs = pixRead("test8.jpg");
+    pixt = pixThresholdToBinary(pixs, 160);
+    for (i = 0; i < 2; i++) {
+        pixd = (i == 0) ? pixs : pixt;
+        pix1 = ShiftBlocks(pixd, L_SIMD_NONE);
+        for (mode = L_SIMD_SSE2; mode <= L_SIMD_NEON; mode++) {
+            if (l_simdSupported(mode))
+                pix2 = ShiftBlocks(pixd, mode);
+            else
+                pix2 = pixClone(pix1);
+            regTestComparePix(rp, pix1, pix2);  /* 2 - 7 */
+            pixDestroy(&pix2);
+        }
+        pixDestroy(&pix1);
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+    pixDestroy(&pixs);
+    pixDestroy(&pixt);
     return regTestCleanup(rp);
 }
+
+
+    /* Do a set of in-place horizontal and vertical block shifts,
+     * both by whole words and not, in the given SIMD mode */
+static PIX *
+ShiftBlocks(PIX     *pixs,
+            l_int32  mode)
+{
+static const l_int32  shifts[] = {1, -3, 32, -37, 70, -101};
+l_int32  i, w, h;
+PIX     *pixd;
+
+    l_setSimdMode(mode);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixd = pixCopy(NULL, pixs);
+    for (i = 0; i < 6; i++) {
+        pixRasteropHip(pixd, 10 + 30 * i, 40, shifts[i], L_BRING_IN_WHITE);
+        pixRasteropVip(pixd, 7 + 45 * i, 300 + 11 * i, shifts[i],
+                       L_BRING_IN_BLACK);
+    }
+    pixRasteropVip(pixd, 0, w, -13, L_BRING_IN_WHITE);
+    return pixd;
+}
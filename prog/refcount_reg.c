@@ -0,0 +1,235 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   refcount_reg.c
+ *
+ *   Stress test for cloning and destroying the refcounted structs
+ *   from many threads at once.
+ *
+ *   Each thread repeatedly clones and destroys handles to a shared
+ *   pix, pixa, box, boxa, pta, numa, l_dna, sarray and fpix, and
+ *   finally destroys the clones it was handed at startup.  When all
+ *   threads are done, the ref counts must be back to their values
+ *   before the threads were given their clones.
+ *
+ *   The threaded stress only runs when the library is built with
+ *   atomic refcounts (USE_ATOMIC_REFCOUNT; see environ.h).  Otherwise
+ *   the same work is done serially, which checks only the bookkeeping.
+ */
+
+#include "allheaders.h"
+
+#if L_HAVE_ATOMIC_REFCOUNT && !defined(_WIN32)
+#include <pthread.h>
+#define  DO_THREADS   1
+#else
+#define  DO_THREADS   0
+#endif  /* L_HAVE_ATOMIC_REFCOUNT && !_WIN32 */
+
+static const l_int32  NThreads = 32;
+static const l_int32  NIters = 20000;
+
+    /* Handles to the shared structs, one set per thread */
+struct SharedData
+{
+    PIX     *pix;
+    PIXA    *pixa;
+    BOX     *box;
+    BOXA    *boxa;
+    PTA     *pta;
+    NUMA    *na;
+    L_DNA   *da;
+    SARRAY  *sa;
+    FPIX    *fpix;
+};
+typedef struct SharedData  SHAREDDATA;
+
+static void *CloneAndDestroy(void *arg);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, n;
+BOX          *box;
+BOXA         *boxa;
+FPIX         *fpix;
+L_DNA        *da;
+NUMA         *na;
+PIX          *pix;
+PIXA         *pixa;
+PTA          *pta;
+SARRAY       *sa;
+SHAREDDATA   *sd;
+L_REGPARAMS  *rp;
+#if DO_THREADS
+pthread_t    *threads;
+#endif  /* DO_THREADS */
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    fprintf(stderr, "Atomic refcount: %s\n",
+            (L_HAVE_ATOMIC_REFCOUNT) ? "yes" : "no");
+#if DO_THREADS
+    fprintf(stderr, "Running the stress on %d threads\n", NThreads);
+#else
+    fprintf(stderr, "SKIPPED the threaded stress; it needs atomic refcounts\n"
+            "  (USE_ATOMIC_REFCOUNT; see environ.h).  Only the serial\n"
+            "  bookkeeping is checked.\n");
+#endif  /* DO_THREADS */
+
+        /* Make the shared structs */
+    pix = pixCreate(300, 200, 1);
+    pixa = pixaCreate(2);
+    pixaAddPix(pixa, pix, L_CLONE);
+    pixaAddPix(pixa, pix, L_CLONE);
+    box = boxCreate(10, 20, 30, 40);
+    boxa = boxaCreate(1);
+    boxaAddBox(boxa, box, L_CLONE);
+    pta = ptaCreate(1);
+    ptaAddPt(pta, 1.0, 2.0);
+    na = numaCreate(1);
+    numaAddNumber(na, 3.0);
+    da = l_dnaCreate(1);
+    l_dnaAddNumber(da, 4.0);
+    sa = sarrayCreate(1);
+    sarrayAddString(sa, (char *)"refcount", L_COPY);
+    fpix = fpixCreate(50, 50);
+
+        /* Give each thread its own clone of everything */
+    sd = (SHAREDDATA *)lept_calloc(NThreads, sizeof(SHAREDDATA));
+    for (i = 0; i < NThreads; i++) {
+        sd[i].pix = pixClone(pix);
+        sd[i].pixa = pixaCopy(pixa, L_CLONE);
+        sd[i].box = boxClone(box);
+        sd[i].boxa = boxaCopy(boxa, L_CLONE);
+        sd[i].pta = ptaClone(pta);
+        sd[i].na = numaClone(na);
+        sd[i].da = l_dnaClone(da);
+        sd[i].sa = sarrayClone(sa);
+        sd[i].fpix = fpixClone(fpix);
+    }
+    regTestCompareValues(rp, NThreads + 3, pixGetRefcount(pix), 0.0);  /* 0 */
+    regTestCompareValues(rp, NThreads + 2, boxGetRefcount(box), 0.0);  /* 1 */
+    regTestCompareValues(rp, NThreads + 1, numaGetRefcount(na), 0.0);  /* 2 */
+
+        /* Run the clone/destroy loops */
+#if DO_THREADS
+    threads = (pthread_t *)lept_calloc(NThreads, sizeof(pthread_t));
+    for (i = 0; i < NThreads; i++)
+        pthread_create(&threads[i], NULL, CloneAndDestroy, &sd[i]);
+    for (i = 0; i < NThreads; i++)
+        pthread_join(threads[i], NULL);
+    lept_free(threads);
+#else
+    for (i = 0; i < NThreads; i++)
+        CloneAndDestroy(&sd[i]);
+#endif  /* DO_THREADS */
+
+        /* Only the original handles remain */
+    regTestCompareValues(rp, 3, pixGetRefcount(pix), 0.0);  /* 3 */
+    regTestCompareValues(rp, 2, boxGetRefcount(box), 0.0);  /* 4 */
+    regTestCompareValues(rp, 1, ptaGetRefcount(pta), 0.0);  /* 5 */
+    regTestCompareValues(rp, 1, numaGetRefcount(na), 0.0);  /* 6 */
+    regTestCompareValues(rp, 1, l_dnaGetRefcount(da), 0.0);  /* 7 */
+    regTestCompareValues(rp, 1, sarrayGetRefcount(sa), 0.0);  /* 8 */
+    regTestCompareValues(rp, 1, fpixGetRefcount(fpix), 0.0);  /* 9 */
+    n = 0;
+    for (i = 0; i < NThreads; i++) {
+        if (sd[i].pix == NULL && sd[i].pixa == NULL && sd[i].box == NULL &&
+            sd[i].boxa == NULL && sd[i].pta == NULL && sd[i].na == NULL &&
+            sd[i].da == NULL && sd[i].sa == NULL && sd[i].fpix == NULL)
+            n++;
+    }
+    regTestCompareValues(rp, NThreads, n, 0.0);  /* 10 */
+    lept_free(sd);
+
+    pixDestroy(&pix);
+    pixaDestroy(&pixa);
+    boxDestroy(&box);
+    boxaDestroy(&boxa);
+    ptaDestroy(&pta);
+    numaDestroy(&na);
+    l_dnaDestroy(&da);
+    sarrayDestroy(&sa);
+    fpixDestroy(&fpix);
+    return regTestCleanup(rp);
+}
+
+
+static void *
+CloneAndDestroy(void  *arg)
+{
+l_int32      i;
+BOX         *box;
+BOXA        *boxa;
+FPIX        *fpix;
+L_DNA       *da;
+NUMA        *na;
+PIX         *pix1, *pix2;
+PIXA        *pixa;
+PTA         *pta;
+SARRAY      *sa;
+SHAREDDATA  *sd;
+
+    sd = (SHAREDDATA *)arg;
+    for (i = 0; i < NIters; i++) {
+        pix1 = pixClone(sd->pix);
+        pixa = pixaCopy(sd->pixa, L_CLONE);
+        pix2 = pixaGetPix(pixa, i % 2, L_CLONE);
+        box = boxClone(sd->box);
+        boxa = boxaCopy(sd->boxa, L_COPY_CLONE);
+        pta = ptaClone(sd->pta);
+        na = numaClone(sd->na);
+        da = l_dnaClone(sd->da);
+        sa = sarrayClone(sd->sa);
+        fpix = fpixClone(sd->fpix);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        pixaDestroy(&pixa);
+        boxDestroy(&box);
+        boxaDestroy(&boxa);
+        ptaDestroy(&pta);
+        numaDestroy(&na);
+        l_dnaDestroy(&da);
+        sarrayDestroy(&sa);
+        fpixDestroy(&fpix);
+    }
+
+        /* Release this thread's own handles */
+    pixDestroy(&sd->pix);
+    pixaDestroy(&sd->pixa);
+    boxDestroy(&sd->box);
+    boxaDestroy(&sd->boxa);
+    ptaDestroy(&sd->pta);
+    numaDestroy(&sd->na);
+    l_dnaDestroy(&sd->da);
+    sarrayDestroy(&sd->sa);
+    fpixDestroy(&sd->fpix);
+    return NULL;
+}
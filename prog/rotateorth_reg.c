@@ -39,12 +39,15 @@
 #define   RGB_IMAGE           "marge.jpg"
 
 void RotateOrthTest(PIX *pix, L_REGPARAMS *rp);
+static PIX *Rotate90ByPixel(PIX *pixs, l_int32 direction);
 
 
 int main(int    argc,
          char **argv)
 {
-PIX          *pixs;
+l_int32       i, dir;
+l_int32       depth[6] = {1, 2, 4, 8, 16, 32};
+PIX          *pixs, *pix1, *pix2;
 L_REGPARAMS  *rp;
 
     if (regTestSetup(argc, argv, &rp))
@@ -71,6 +74,21 @@ L_REGPARAMS  *rp;
     RotateOrthTest(pixs, rp);
     pixDestroy(&pixs);
 
+        /* Compare 90 degree rotation with rotation by pixel access,
+         * on an image whose sizes are not multiples of the blocks */
+    fprintf(stderr, "\nTest 90-degree rotation at each depth:\n");
+    for (i = 0; i < 6; i++) {
+        pixs = regTestMakeRandomPix(103, 67, depth[i], 54321);
+        for (dir = -1; dir <= 1; dir += 2) {
+            pix1 = pixRotate90(pixs, dir);
+            pix2 = Rotate90ByPixel(pixs, dir);
+            regTestComparePix(rp, pix1, pix2);
+            pixDestroy(&pix1);
+            pixDestroy(&pix2);
+        }
+        pixDestroy(&pixs);
+    }
+
     return regTestCleanup(rp);
 }
 
@@ -146,3 +164,27 @@ PIX      *pixt, *pixd;
     pixDestroy(&pixt);
     return;
 }
+
+
+    /* The trivial version of pixRotate90() */
+static PIX *
+Rotate90ByPixel(PIX     *pixs,
+                l_int32  direction)
+{
+l_int32   i, j, w, h, d;
+l_uint32  val;
+PIX      *pixd;
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    pixd = pixCreate(h, w, d);
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            pixGetPixel(pixs, j, i, &val);
+            if (direction == 1)
+                pixSetPixel(pixd, h - 1 - i, j, val);
+            else
+                pixSetPixel(pixd, i, w - 1 - j, val);
+        }
+    }
+    return pixd;
+}
@@ -0,0 +1,148 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   rotatepar_reg.c
+ *
+ *   Tests that area mapped rotation, rotation and shear by rasterop,
+ *   and 90 degree rotation give the same results on several threads,
+ *   and with each of the vector kernels, as on one thread without them.
+ *   Besides a photograph and images made from it, a synthetic image
+ *   with an odd width is used, and the shears are done with narrow
+ *   and wide bands, in place and to a new image.
+ */
+
+#include "allheaders.h"
+
+static PIXA *RotateAll(PIX *pixs, void *data, FPIXA **pfpixa);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j;
+l_float32     angle;
+PIX          *pixs, *pix1, *pix2;
+PIXA         *pixa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    for (i = 0; i < 4; i++) {
+        pix1 = pixRead("marge.jpg");
+        if (i == 0) {
+            pixs = regTestMakeRandomPix(253, 131, 32, 12345);
+        } else if (i == 1) {
+            pixs = pixClone(pix1);
+        } else if (i == 2) {
+            pixs = pixConvertRGBToLuminance(pix1);
+        } else {
+            pix2 = pixConvertRGBToLuminance(pix1);
+            pixs = pixThresholdToBinary(pix2, 130);
+            pixDestroy(&pix2);
+        }
+        pixDestroy(&pix1);
+        angle = (i % 2) ? 0.05 : -0.7;
+
+            /* Compare on four threads, with each of the vector kernels,
+             * with the results on one thread without them */
+        regTestCompareParallel(rp, RotateAll, pixs, &angle, 4, &pixa);
+        if (i == 1) {
+            for (j = 0; j < 2; j++) {  /* 120, 121 */
+                pix1 = pixaGetPix(pixa, j, L_CLONE);
+                regTestWritePixAndCheck(rp, pix1, IFF_JFIF_JPEG);
+                pixDestroy(&pix1);
+            }
+        } else if (i == 3) {
+            pix1 = pixaGetPix(pixa, 0, L_CLONE);
+            regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 226 */
+            pixDestroy(&pix1);
+        }
+        pixaDestroy(&pixa);
+        pixDestroy(&pixs);
+    }
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Rotates and shears pixs in the ways that apply to its depth,
+     * and returns the results in a pixa.  The shears by small angles
+     * have wide bands of lines or columns, and those by large angles
+     * have narrow ones.  The angle is given by data. */
+static PIXA *
+RotateAll(PIX     *pixs,
+          void    *data,
+          FPIXA  **pfpixa)
+{
+l_int32    w, h, d;
+l_float32  angle;
+PIX       *pix1;
+PIXA      *pixa;
+
+    angle = *(l_float32 *)data;
+    *pfpixa = NULL;
+    pixGetDimensions(pixs, &w, &h, &d);
+    pixa = pixaCreate(0);
+    if (d == 32) {
+        pixaAddPix(pixa, pixRotateAMColor(pixs, angle, 0xffffff00),
+                   L_INSERT);
+        pixaAddPix(pixa, pixRotateAMColorFast(pixs, angle, 0xffffff00),
+                   L_INSERT);
+        pixaAddPix(pixa, pixRotateAMColorCorner(pixs, angle, 0x0),
+                   L_INSERT);
+    } else if (d == 8) {
+        pixaAddPix(pixa, pixRotateAMGray(pixs, angle, 255), L_INSERT);
+        pixaAddPix(pixa, pixRotateAMGrayCorner(pixs, angle, 0), L_INSERT);
+    }
+    pixaAddPix(pixa, pixRotate(pixs, angle, L_ROTATE_SHEAR,
+                               L_BRING_IN_WHITE, 0, 0), L_INSERT);
+    pixaAddPix(pixa, pixHShear(NULL, pixs, h / 3, angle, L_BRING_IN_BLACK),
+               L_INSERT);
+    pixaAddPix(pixa, pixVShear(NULL, pixs, w / 3, angle, L_BRING_IN_WHITE),
+               L_INSERT);
+    pixaAddPix(pixa, pixVShear(NULL, pixs, w / 2, 1.1, L_BRING_IN_BLACK),
+               L_INSERT);
+    pixaAddPix(pixa, pixVShear(NULL, pixs, w / 3, 0.01, L_BRING_IN_BLACK),
+               L_INSERT);
+    pix1 = pixCopy(NULL, pixs);
+    pixHShearIP(pix1, h / 2, angle, L_BRING_IN_WHITE);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixCopy(NULL, pixs);
+    pixVShearIP(pix1, w / 2, angle, L_BRING_IN_BLACK);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixCopy(NULL, pixs);
+    pixVShearIP(pix1, 0, -1.1, L_BRING_IN_WHITE);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixCopy(NULL, pixs);
+    pixVShearIP(pix1, w, 0.01, L_BRING_IN_WHITE);
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixaAddPix(pixa, pixRotate90(pixs, 1), L_INSERT);
+    pixaAddPix(pixa, pixRotate90(pixs, -1), L_INSERT);
+    return pixa;
+}
@@ -49,9 +49,16 @@ static const l_int32    SPACE = 30;
 static const l_int32    WIDTH = 300;
 static const l_float32  FACTOR[5] = {2.3, 1.5, 1.1, 0.6, 0.3};
 
+    /* Scale factors for testing the vector kernels */
+static const l_float32  LIFactors[][2] = {{2.3, 2.3}, {1.5, 1.1}, {1.1, 1.1},
+                                          {0.85, 0.85}, {0.73, 3.1}};
+static const l_float32  AreaMapFactors[][2] = {{0.6, 0.6}, {0.45, 0.33},
+                                               {0.17, 0.17}, {0.69, 0.08}};
+
 static void AddScaledImages(PIXA *pixa, const char *fname, l_int32 width);
 static void PixSave32(PIXA *pixa, PIX *pixc);
 static void PixaSaveDisplay(PIXA *pixa, L_REGPARAMS *rp);
+static void TestSimdModes(L_REGPARAMS *rp);
 
 
 int main(int    argc,
@@ -239,6 +246,10 @@ L_REGPARAMS  *rp;
     PixaSaveDisplay(pixa, rp);
     pixDestroy(&pixs);
 
+        /* Compare the vector kernels with the scalar code */
+    fprintf(stderr, "\n-------------- Testing vector kernels ------\n");
+    TestSimdModes(rp);
+
     return regTestCleanup(rp);
 }
 
@@ -293,3 +304,62 @@ PIX  *pixd;
     pixaDestroy(&pixa);
     return;
 }
+
+    /* For each available vector instruction set, compares LI and area
+     * map scaling of 8 bpp and rgb images with the scalar results.
+     * The images are clipped so that the dest widths are not multiples
+     * of the vector widths. */
+static void
+TestSimdModes(L_REGPARAMS  *rp)
+{
+l_int32    i, j, k, mode, w, h, nli, narea;
+l_float32  sx, sy;
+BOX       *box;
+PIX       *pixs[2], *pix1, *pix2, *pix3;
+
+    pixs[0] = pixRead("test8.jpg");
+    pixs[1] = pixRead("test24.jpg");
+    nli = sizeof(LIFactors) / sizeof(LIFactors[0]);
+    narea = sizeof(AreaMapFactors) / sizeof(AreaMapFactors[0]);
+    for (mode = L_SIMD_SSE2; mode <= L_SIMD_NEON; mode++) {
+        if (!l_simdSupported(mode))
+            continue;
+        for (i = 0; i < 2; i++) {
+            pixGetDimensions(pixs[i], &w, &h, NULL);
+            for (j = 0; j < 2; j++) {
+                box = boxCreate(j, 3 * j, w - 7 * j, h - 5 * j);
+                pix1 = pixClipRectangle(pixs[i], box, NULL);
+                boxDestroy(&box);
+                for (k = 0; k < nli; k++) {
+                    sx = LIFactors[k][0];
+                    sy = LIFactors[k][1];
+                    l_setSimdMode(L_SIMD_NONE);
+                    pix2 = (i == 0) ? pixScaleGrayLI(pix1, sx, sy)
+                                    : pixScaleColorLI(pix1, sx, sy);
+                    l_setSimdMode(mode);
+                    pix3 = (i == 0) ? pixScaleGrayLI(pix1, sx, sy)
+                                    : pixScaleColorLI(pix1, sx, sy);
+                    regTestComparePix(rp, pix2, pix3);
+                    pixDestroy(&pix2);
+                    pixDestroy(&pix3);
+                }
+                for (k = 0; k < narea; k++) {
+                    sx = AreaMapFactors[k][0];
+                    sy = AreaMapFactors[k][1];
+                    l_setSimdMode(L_SIMD_NONE);
+                    pix2 = pixScaleAreaMap(pix1, sx, sy);
+                    l_setSimdMode(mode);
+                    pix3 = pixScaleAreaMap(pix1, sx, sy);
+                    regTestComparePix(rp, pix2, pix3);
+                    pixDestroy(&pix2);
+                    pixDestroy(&pix3);
+                }
+                pixDestroy(&pix1);
+            }
+        }
+    }
+    l_setSimdMode(L_SIMD_AUTO);
+    pixDestroy(&pixs[0]);
+    pixDestroy(&pixs[1]);
+    return;
+}
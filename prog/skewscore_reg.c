@@ -0,0 +1,138 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+
+/*
+ *   skewscore_reg.c
+ *
+ *   Tests that the differential square sums found for a set of
+ *   vertical shear angles by pixFindDifferentialSquareSums(), without
+ *   making the sheared images, are the same as those found on the
+ *   sheared images, for shears about the corner and the center, and
+ *   on one and several threads.  It also checks that the skew found
+ *   for a rotated image is close to the rotation angle.
+ */
+
+#include "allheaders.h"
+
+static const l_float32  Angles[] = {-12.0, -4.1, -0.3, 0.0, 0.05, 0.6,
+                                     2.3, 7.5};
+
+static void CompareScores(L_REGPARAMS *rp, PIX *pixs, NUMA *naangle,
+                          l_int32 pivot);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j, nthreads;
+l_float32     angle, conf;
+BOX          *box;
+NUMA         *naangle;
+PIX          *pix1, *pix2, *pixs;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    naangle = numaCreate(0);
+    for (i = 0; i < sizeof(Angles) / sizeof(l_float32); i++)
+        numaAddNumber(naangle, Angles[i]);
+
+    nthreads = l_getParallelThreads();
+    for (i = 0; i < 3; i++) {
+        if (i == 0) {
+            pix1 = pixRead("arabic.png");
+        } else if (i == 1) {
+            pix1 = pixRead("italic.png");
+        } else {  /* odd width, and text going to the right edge */
+            pix2 = pixRead("italic.png");
+            pix1 = pixRotate(pix2, 0.02, L_ROTATE_SAMPLING,
+                             L_BRING_IN_WHITE, 0, 0);
+            pixDestroy(&pix2);
+            box = boxCreate(37, 11, 333, 271);
+            pix2 = pixClipRectangle(pix1, box, NULL);
+            boxDestroy(&box);
+            pixDestroy(&pix1);
+            pix1 = pix2;
+        }
+        pixs = pixConvertTo1(pix1, 130);
+        pixDestroy(&pix1);
+        for (j = 1; j <= 4; j += 3) {
+            l_setParallelThreads(j);
+            CompareScores(rp, pixs, naangle, L_SHEAR_ABOUT_CORNER);
+            CompareScores(rp, pixs, naangle, L_SHEAR_ABOUT_CENTER);
+        }
+        l_setParallelThreads(nthreads);
+        pixDestroy(&pixs);
+    }
+
+        /* Find the skew of a rotated image */
+    pixs = pixRead("arabic.png");
+    pix1 = pixRotate(pixs, 3.1415926535 / 180. * 2.3, L_ROTATE_SHEAR,
+                     L_BRING_IN_WHITE, 0, 0);
+    pixFindSkew(pix1, &angle, &conf);
+    regTestCompareValues(rp, -2.3, angle, 0.1);
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+    numaDestroy(&naangle);
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Compares the scores found without making the sheared images to
+     * those found on the sheared images. */
+static void
+CompareScores(L_REGPARAMS  *rp,
+              PIX          *pixs,
+              NUMA         *naangle,
+              l_int32       pivot)
+{
+l_int32    i, n;
+l_float32  deg2rad, angle, score1, score2;
+NUMA      *nascore;
+PIX       *pix1;
+
+    deg2rad = 3.1415926535 / 180.;
+    nascore = pixFindDifferentialSquareSums(pixs, naangle, pivot);
+    n = numaGetCount(naangle);
+    regTestCompareValues(rp, n, numaGetCount(nascore), 0.0);
+    for (i = 0; i < n; i++) {
+        numaGetFValue(naangle, i, &angle);
+        if (pivot == L_SHEAR_ABOUT_CORNER)
+            pix1 = pixVShearCorner(NULL, pixs, deg2rad * angle,
+                                   L_BRING_IN_WHITE);
+        else
+            pix1 = pixVShearCenter(NULL, pixs, deg2rad * angle,
+                                   L_BRING_IN_WHITE);
+        pixFindDifferentialSquareSum(pix1, &score1);
+        numaGetFValue(nascore, i, &score2);
+        regTestCompareValues(rp, score1, score2, 0.0);
+        pixDestroy(&pix1);
+    }
+    numaDestroy(&nascore);
+}
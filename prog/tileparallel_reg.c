@@ -0,0 +1,130 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   tileparallel_reg.c
+ *
+ *   Tests that the operations that are split into tiles or bands and
+ *   run on several threads give the same result as with one thread:
+ *       pixTilingProcess()
+ *       pixSauvolaBinarizeTiled()
+ *       pixBlockconvTiled()
+ *       pixBackgroundNormSimple()
+ */
+
+#include "allheaders.h"
+
+static const l_int32  NThreads = 4;
+
+static PIX *InvertTile(PIX *pixt, l_int32 i, l_int32 j, void *data);
+static PIX *RunOps(PIX *pixs, l_int32 nthreads, PIX **ppixth,
+                   PIX **ppixc8, PIX **ppixc32, PIX **ppixn32);
+
+
+int main(int    argc,
+         char **argv)
+{
+PIX          *pixs, *pixg, *pix1, *pix2;
+PIX          *pixd1, *pixd2, *pixth1, *pixth2, *pixc81, *pixc82;
+PIX          *pixc321, *pixc322, *pixn321, *pixn322;
+PIXTILING    *pt;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pixs = pixRead("test24.jpg");
+    pixg = pixConvertRGBToLuminance(pixs);
+
+        /* Tile function on a 1 bpp image, where adjacent tiles
+         * share words in the destination */
+    pix1 = pixThresholdToBinary(pixg, 128);
+    pix2 = pixCreateTemplate(pix1);
+    pt = pixTilingCreate(pix1, 7, 9, 0, 0, 11, 13);
+    pixTilingProcess(pt, pix2, InvertTile, NULL, NThreads);
+    pixTilingDestroy(&pt);
+    pixInvert(pix2, pix2);
+    regTestComparePix(rp, pix1, pix2);  /* 0 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Library operations, with 1 thread and with NThreads */
+    pixd1 = RunOps(pixs, 1, &pixth1, &pixc81, &pixc321, &pixn321);
+    pixd2 = RunOps(pixs, NThreads, &pixth2, &pixc82, &pixc322, &pixn322);
+    regTestComparePix(rp, pixd1, pixd2);  /* 1 */
+    regTestComparePix(rp, pixth1, pixth2);  /* 2 */
+    regTestComparePix(rp, pixc81, pixc82);  /* 3 */
+    regTestComparePix(rp, pixc321, pixc322);  /* 4 */
+    regTestComparePix(rp, pixn321, pixn322);  /* 5 */
+    regTestWritePixAndCheck(rp, pixd2, IFF_PNG);  /* 6 */
+    regTestWritePixAndCheck(rp, pixn322, IFF_JFIF_JPEG);  /* 7 */
+    l_setParallelThreads(1);
+
+    pixDestroy(&pixd1);
+    pixDestroy(&pixd2);
+    pixDestroy(&pixth1);
+    pixDestroy(&pixth2);
+    pixDestroy(&pixc81);
+    pixDestroy(&pixc82);
+    pixDestroy(&pixc321);
+    pixDestroy(&pixc322);
+    pixDestroy(&pixn321);
+    pixDestroy(&pixn322);
+    pixDestroy(&pixs);
+    pixDestroy(&pixg);
+    return regTestCleanup(rp);
+}
+
+
+static PIX *
+InvertTile(PIX     *pixt,
+           l_int32  i,
+           l_int32  j,
+           void    *data)
+{
+    return pixInvert(NULL, pixt);
+}
+
+
+static PIX *
+RunOps(PIX     *pixs,
+       l_int32  nthreads,
+       PIX    **ppixth,
+       PIX    **ppixc8,
+       PIX    **ppixc32,
+       PIX    **ppixn32)
+{
+PIX  *pixg, *pixd;
+
+    l_setParallelThreads(nthreads);
+    pixg = pixConvertRGBToLuminance(pixs);
+    pixSauvolaBinarizeTiled(pixg, 8, 0.34, 3, 4, ppixth, &pixd);
+    *ppixc8 = pixBlockconvTiled(pixg, 5, 3, 4, 3);
+    *ppixc32 = pixBlockconvTiled(pixs, 4, 6, 3, 5);
+    *ppixn32 = pixBackgroundNormSimple(pixs, NULL, NULL);
+    pixDestroy(&pixg);
+    return pixd;
+}
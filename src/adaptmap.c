@@ -52,6 +52,10 @@
  *      Measurement of local background
  *          l_int32    pixGetBackgroundGrayMap()        8 bpp
  *          l_int32    pixGetBackgroundRGBMap()         32 bpp
+ *          static PIX      *makeBackgroundFgMask()
+ *          static PIX      *fgMaskTile()
+ *          static l_int32   bgGrayMapRow()
+ *          static l_int32   bgRGBMapRow()
  *          l_int32    pixGetBackgroundGrayMapMorph()   8 bpp
  *          l_int32    pixGetBackgroundRGBMapMorph()    32 bpp
  *          l_int32    pixFillMapHoles()
@@ -67,6 +71,8 @@
  *      Apply inverse background map to image
  *          PIX       *pixApplyInvBackgroundGrayMap()   8 bpp
  *          PIX       *pixApplyInvBackgroundRGBMap()    32 bpp
+ *          static l_int32   applyInvBgGrayRow()
+ *          static l_int32   applyInvBgRGBRow()
  *
  *      Apply variable map
  *          PIX       *pixApplyVariableGrayMap()        8 bpp
@@ -116,6 +122,12 @@
  *  Note: Several of these functions make an implicit assumption about RGB
  *        component ordering.
  *
+ *  The full resolution steps of (1) and (3) -- making the foreground
+ *  mask, accumulating the background in each tile, and applying the
+ *  inverse map -- are split into horizontal bands that are processed
+ *  on the number of threads set by l_setParallelThreads().  The results
+ *  do not depend on the number of threads.
+ *
  *  Other methods for adaptively normalizing the image are also given here.
  *
  *  (1) pixThresholdSpreadNorm() computes a local threshold over the image
@@ -148,6 +160,40 @@ static const l_int32  DEFAULT_BG_VAL = 200;
 static const l_int32  DEFAULT_X_SMOOTH_SIZE = 2;
 static const l_int32  DEFAULT_Y_SMOOTH_SIZE = 1;
 
+    /* Input to the row functions that measure and apply the background
+     * maps.  Each call handles one row of tiles, so that calls for
+     * different rows can run in parallel. */
+struct BgMapRowParams
+{
+    PIX       *pixs;      /* 8 or 32 bpp source                          */
+    PIX       *pixf;      /* foreground mask; for measuring only         */
+    PIX       *pixm[3];   /* gray map, or red, green and blue maps       */
+    PIX       *pixd;      /* output image; for applying only             */
+    l_int32    sx;        /* tile width                                  */
+    l_int32    sy;        /* tile height                                 */
+    l_int32    nx;        /* number of tiles in a row                    */
+    l_int32    mincount;  /* min number of bg pixels for a map value     */
+};
+typedef struct BgMapRowParams  BG_MAP_ROW_PARAMS;
+
+    /* Input to the tile function for making the foreground mask */
+struct FgMaskTileParams
+{
+    l_int32    thresh;    /* threshold for the foreground                */
+    l_int32    ny;        /* number of bands                             */
+    l_int32    overlap;   /* overlap between bands                       */
+};
+typedef struct FgMaskTileParams  FG_MASK_TILE_PARAMS;
+
+    /* Min height of a band for making the foreground mask in parallel */
+static const l_int32  MIN_FG_MASK_BAND_HEIGHT = 64;
+
+static PIX *makeBackgroundFgMask(PIX *pixg, l_int32 thresh);
+static PIX *fgMaskTile(PIX *pixt, l_int32 i, l_int32 j, void *data);
+static l_int32 bgGrayMapRow(void *data, l_int32 i);
+static l_int32 bgRGBMapRow(void *data, l_int32 i);
+static l_int32 applyInvBgGrayRow(void *data, l_int32 i);
+static l_int32 applyInvBgRGBRow(void *data, l_int32 i);
 static l_int32 *iaaGetLinearTRC(l_int32 **iaa, l_int32 diff);
 
 #ifndef  NO_CONSOLE_IO
@@ -831,13 +877,13 @@ pixGetBackgroundGrayMap(PIX     *pixs,
                         l_int32  mincount,
                         PIX    **ppixd)
 {
-l_int32    w, h, wd, hd, wim, him, wpls, wplim, wpld, wplf;
-l_int32    xim, yim, delx, nx, ny, i, j, k, m;
-l_int32    count, sum, val8;
-l_int32    empty, fgpixels;
-l_uint32  *datas, *dataim, *datad, *dataf, *lines, *lineim, *lined, *linef;
-l_float32  scalex, scaley;
-PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
+l_int32             w, h, wd, hd, wim, him, wplim;
+l_int32             xim, yim, nx, ny, i, j;
+l_int32             empty, fgpixels;
+l_uint32           *dataim, *lineim;
+l_float32           scalex, scaley;
+PIX                *pixd, *piximi, *pixf, *pixims;
+BG_MAP_ROW_PARAMS   params;
 
     PROCNAME("pixGetBackgroundGrayMap");
 
@@ -874,9 +920,8 @@ PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
         /* Generate the foreground mask, pixf, which is at
          * full resolution.  These pixels will be ignored when
          * computing the background values. */
-    pixb = pixThresholdToBinary(pixs, thresh);
-    pixf = pixMorphSequence(pixb, "d7.1 + d1.7", 0);
-    pixDestroy(&pixb);
+    if ((pixf = makeBackgroundFgMask(pixs, thresh)) == NULL)
+        return ERROR_INT("pixf not made", procName, 1);
 
 
     /* ------------- Set up the output map pixd --------------- */
@@ -892,34 +937,14 @@ PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
          * complete, and we must fill them in later. */
     nx = w / sx;
     ny = h / sy;
-    wpls = pixGetWpl(pixs);
-    datas = pixGetData(pixs);
-    wpld = pixGetWpl(pixd);
-    datad = pixGetData(pixd);
-    wplf = pixGetWpl(pixf);
-    dataf = pixGetData(pixf);
-    for (i = 0; i < ny; i++) {
-        lines = datas + sy * i * wpls;
-        linef = dataf + sy * i * wplf;
-        lined = datad + i * wpld;
-        for (j = 0; j < nx; j++) {
-            delx = j * sx;
-            sum = 0;
-            count = 0;
-            for (k = 0; k < sy; k++) {
-                for (m = 0; m < sx; m++) {
-                    if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
-                        sum += GET_DATA_BYTE(lines + k * wpls, delx + m);
-                        count++;
-                    }
-                }
-            }
-            if (count >= mincount) {
-                val8 = sum / count;
-                SET_DATA_BYTE(lined, j, val8);
-            }
-        }
-    }
+    params.pixs = pixs;
+    params.pixf = pixf;
+    params.pixm[0] = pixd;
+    params.sx = sx;
+    params.sy = sy;
+    params.nx = nx;
+    params.mincount = mincount;
+    l_parallelRun(ny, 0, bgGrayMapRow, &params);
     pixDestroy(&pixf);
 
         /* If there is an optional mask with fg pixels, erase the previous
@@ -1010,15 +1035,14 @@ pixGetBackgroundRGBMap(PIX     *pixs,
                        PIX    **ppixmg,
                        PIX    **ppixmb)
 {
-l_int32    w, h, wm, hm, wim, him, wpls, wplim, wplf;
-l_int32    xim, yim, delx, nx, ny, i, j, k, m;
-l_int32    count, rsum, gsum, bsum, rval, gval, bval;
-l_int32    empty, fgpixels;
-l_uint32   pixel;
-l_uint32  *datas, *dataim, *dataf, *lines, *lineim, *linef;
-l_float32  scalex, scaley;
-PIX       *piximi, *pixgc, *pixb, *pixf, *pixims;
-PIX       *pixmr, *pixmg, *pixmb;
+l_int32             w, h, wm, hm, wim, him, wplim;
+l_int32             xim, yim, nx, ny, i, j;
+l_int32             empty, fgpixels;
+l_uint32           *dataim, *lineim;
+l_float32           scalex, scaley;
+PIX                *piximi, *pixgc, *pixf, *pixims;
+PIX                *pixmr, *pixmg, *pixmb;
+BG_MAP_ROW_PARAMS   params;
 
     PROCNAME("pixGetBackgroundRGBMap");
 
@@ -1057,10 +1081,10 @@ PIX       *pixmr, *pixmg, *pixmb;
         pixgc = pixClone(pixg);
     else
         pixgc = pixConvertRGBToGrayFast(pixs);
-    pixb = pixThresholdToBinary(pixgc, thresh);
-    pixf = pixMorphSequence(pixb, "d7.1 + d1.7", 0);
+    pixf = makeBackgroundFgMask(pixgc, thresh);
     pixDestroy(&pixgc);
-    pixDestroy(&pixb);
+    if (!pixf)
+        return ERROR_INT("pixf not made", procName, 1);
 
         /* Generate the output mask images */
     w = pixGetWidth(pixs);
@@ -1077,38 +1101,16 @@ PIX       *pixmr, *pixmg, *pixmb;
          * complete, and we must fill them in later. */
     nx = w / sx;
     ny = h / sy;
-    wpls = pixGetWpl(pixs);
-    datas = pixGetData(pixs);
-    wplf = pixGetWpl(pixf);
-    dataf = pixGetData(pixf);
-    for (i = 0; i < ny; i++) {
-        lines = datas + sy * i * wpls;
-        linef = dataf + sy * i * wplf;
-        for (j = 0; j < nx; j++) {
-            delx = j * sx;
-            rsum = gsum = bsum = 0;
-            count = 0;
-            for (k = 0; k < sy; k++) {
-                for (m = 0; m < sx; m++) {
-                    if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
-                        pixel = *(lines + k * wpls + delx + m);
-                        rsum += (pixel >> 24);
-                        gsum += ((pixel >> 16) & 0xff);
-                        bsum += ((pixel >> 8) & 0xff);
-                        count++;
-                    }
-                }
-            }
-            if (count >= mincount) {
-                rval = rsum / count;
-                gval = gsum / count;
-                bval = bsum / count;
-                pixSetPixel(pixmr, j, i, rval);
-                pixSetPixel(pixmg, j, i, gval);
-                pixSetPixel(pixmb, j, i, bval);
-            }
-        }
-    }
+    params.pixs = pixs;
+    params.pixf = pixf;
+    params.pixm[0] = pixmr;
+    params.pixm[1] = pixmg;
+    params.pixm[2] = pixmb;
+    params.sx = sx;
+    params.sy = sy;
+    params.nx = nx;
+    params.mincount = mincount;
+    l_parallelRun(ny, 0, bgRGBMapRow, &params);
     pixDestroy(&pixf);
 
         /* If there is an optional mask with fg pixels, erase the previous
@@ -1172,6 +1174,194 @@ PIX       *pixmr, *pixmg, *pixmb;
 }
 
 
+/*!
+ *  makeBackgroundFgMask()
+ *
+ *      Input:  pixg (8 bpp)
+ *              thresh (threshold for determining foreground)
+ *      Return: pixf (1 bpp foreground mask, dilated by a 7x7 brick),
+ *                    or null on error
+ *
+ *  Notes:
+ *      (1) The mask is the same as
+ *              pixMorphSequence(pixThresholdToBinary(pixg, thresh),
+ *                               "d7.1 + d1.7", 0)
+ *          With more than one thread, it is made in horizontal bands
+ *          that overlap by the half-height of the dilation.
+ */
+static PIX *
+makeBackgroundFgMask(PIX     *pixg,
+                     l_int32  thresh)
+{
+l_int32               h, nthreads, ny;
+PIX                  *pixb, *pixf;
+PIXTILING            *pt;
+FG_MASK_TILE_PARAMS   params;
+
+    PROCNAME("makeBackgroundFgMask");
+
+    h = pixGetHeight(pixg);
+    nthreads = l_getParallelThreads();
+    ny = L_MIN(4 * nthreads, h / MIN_FG_MASK_BAND_HEIGHT);
+    if (nthreads <= 1 || ny < 2) {
+        pixb = pixThresholdToBinary(pixg, thresh);
+        pixf = pixMorphSequence(pixb, "d7.1 + d1.7", 0);
+        pixDestroy(&pixb);
+        return pixf;
+    }
+
+    params.thresh = thresh;
+    params.ny = ny;
+    params.overlap = 3;  /* half-height of the vertical dilation */
+    pixf = pixCreate(pixGetWidth(pixg), h, 1);
+    pt = pixTilingCreate(pixg, 1, ny, 0, 0, 0, params.overlap);
+    if (pixTilingProcess(pt, pixf, fgMaskTile, &params, nthreads)) {
+        pixDestroy(&pixf);
+        L_ERROR("mask not made\n", procName);
+    }
+    pixTilingDestroy(&pt);
+    return pixf;
+}
+
+
+/*!
+ *  fgMaskTile()
+ *
+ *      Input:  pixt (8 bpp band, with overlap)
+ *              i, j (band index and column)
+ *              data (FG_MASK_TILE_PARAMS)
+ *      Return: pixd (1 bpp dilated foreground for the band, with overlap),
+ *                    or null on error
+ *
+ *  Notes:
+ *      (1) At the top and bottom of the image the overlap is mirrored
+ *          by pixTilingGetTile().  It is cleared here, because the
+ *          dilation of the full image sees no foreground beyond
+ *          its boundary.
+ */
+static PIX *
+fgMaskTile(PIX     *pixt,
+           l_int32  i,
+           l_int32  j,
+           void    *data)
+{
+l_int32               top, bot;
+PIX                  *pixb, *pixd;
+FG_MASK_TILE_PARAMS  *params;
+
+    params = (FG_MASK_TILE_PARAMS *)data;
+    if ((pixb = pixThresholdToBinary(pixt, params->thresh)) == NULL)
+        return NULL;
+    top = (i == 0) ? params->overlap : 0;
+    bot = (i == params->ny - 1) ? params->overlap : 0;
+    if (top || bot)
+        pixSetOrClearBorder(pixb, 0, 0, top, bot, PIX_CLR);
+    pixd = pixMorphSequence(pixb, "d7.1 + d1.7", 0);
+    pixDestroy(&pixb);
+    return pixd;
+}
+
+
+/*!
+ *  bgGrayMapRow()
+ *
+ *      Input:  data (BG_MAP_ROW_PARAMS)
+ *              i (row of tiles)
+ *      Return: 0 if OK
+ *
+ *  Notes:
+ *      (1) For each complete tile in row i, this sets the map pixel to
+ *          the average of the pixels that are not under the foreground
+ *          mask, provided that there are at least mincount of them.
+ */
+static l_int32
+bgGrayMapRow(void    *data,
+             l_int32  i)
+{
+l_int32             j, k, m, sx, sy, delx, wpls, wplf, count, sum;
+l_uint32           *lines, *linef, *lined;
+BG_MAP_ROW_PARAMS  *params;
+
+    params = (BG_MAP_ROW_PARAMS *)data;
+    sx = params->sx;
+    sy = params->sy;
+    wpls = pixGetWpl(params->pixs);
+    wplf = pixGetWpl(params->pixf);
+    lines = pixGetData(params->pixs) + sy * i * wpls;
+    linef = pixGetData(params->pixf) + sy * i * wplf;
+    lined = pixGetData(params->pixm[0]) + i * pixGetWpl(params->pixm[0]);
+    for (j = 0; j < params->nx; j++) {
+        delx = j * sx;
+        sum = 0;
+        count = 0;
+        for (k = 0; k < sy; k++) {
+            for (m = 0; m < sx; m++) {
+                if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
+                    sum += GET_DATA_BYTE(lines + k * wpls, delx + m);
+                    count++;
+                }
+            }
+        }
+        if (count >= params->mincount)
+            SET_DATA_BYTE(lined, j, sum / count);
+    }
+    return 0;
+}
+
+
+/*!
+ *  bgRGBMapRow()
+ *
+ *      Input:  data (BG_MAP_ROW_PARAMS)
+ *              i (row of tiles)
+ *      Return: 0 if OK
+ *
+ *  Notes:
+ *      (1) This is the 32 bpp version of bgGrayMapRow(), setting the
+ *          pixels in the three component maps.
+ */
+static l_int32
+bgRGBMapRow(void    *data,
+            l_int32  i)
+{
+l_int32             j, k, m, sx, sy, delx, wpls, wplf;
+l_int32             count, rsum, gsum, bsum;
+l_uint32            pixel;
+l_uint32           *lines, *linef;
+BG_MAP_ROW_PARAMS  *params;
+
+    params = (BG_MAP_ROW_PARAMS *)data;
+    sx = params->sx;
+    sy = params->sy;
+    wpls = pixGetWpl(params->pixs);
+    wplf = pixGetWpl(params->pixf);
+    lines = pixGetData(params->pixs) + sy * i * wpls;
+    linef = pixGetData(params->pixf) + sy * i * wplf;
+    for (j = 0; j < params->nx; j++) {
+        delx = j * sx;
+        rsum = gsum = bsum = 0;
+        count = 0;
+        for (k = 0; k < sy; k++) {
+            for (m = 0; m < sx; m++) {
+                if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
+                    pixel = *(lines + k * wpls + delx + m);
+                    rsum += (pixel >> 24);
+                    gsum += ((pixel >> 16) & 0xff);
+                    bsum += ((pixel >> 8) & 0xff);
+                    count++;
+                }
+            }
+        }
+        if (count >= params->mincount) {
+            pixSetPixel(params->pixm[0], j, i, rsum / count);
+            pixSetPixel(params->pixm[1], j, i, gsum / count);
+            pixSetPixel(params->pixm[2], j, i, bsum / count);
+        }
+    }
+    return 0;
+}
+
+
 /*!
  *  pixGetBackgroundGrayMapMorph()
  *
@@ -1861,11 +2051,9 @@ pixApplyInvBackgroundGrayMap(PIX     *pixs,
                              l_int32  sx,
                              l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
-l_int32    vals, vald;
-l_uint32   val16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
-PIX       *pixd;
+l_int32             hm;
+PIX                *pixd;
+BG_MAP_ROW_PARAMS   params;
 
     PROCNAME("pixApplyInvBackgroundGrayMap");
 
@@ -1878,33 +2066,14 @@ PIX       *pixd;
     if (sx == 0 || sy == 0)
         return (PIX *)ERROR_PTR("invalid sx and/or sy", procName, NULL);
 
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
-    pixGetDimensions(pixs, &w, &h, NULL);
-    pixGetDimensions(pixm, &wm, &hm, NULL);
+    pixGetDimensions(pixm, &params.nx, &hm, NULL);
     pixd = pixCreateTemplate(pixs);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixm, j, i, &val16);
-            xoff = sx * j;
-            for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
-                for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = GET_DATA_BYTE(flines, xoff + m);
-                    vald = (vals * val16) / 256;
-                    vald = L_MIN(vald, 255);
-                    SET_DATA_BYTE(flined, xoff + m, vald);
-                }
-            }
-        }
-    }
-
+    params.pixs = pixs;
+    params.pixm[0] = pixm;
+    params.pixd = pixd;
+    params.sx = sx;
+    params.sy = sy;
+    l_parallelRun(hm, 0, applyInvBgGrayRow, &params);
     return pixd;
 }
 
@@ -1928,12 +2097,9 @@ pixApplyInvBackgroundRGBMap(PIX     *pixs,
                             l_int32  sx,
                             l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
-l_int32    rvald, gvald, bvald;
-l_uint32   vals;
-l_uint32   rval16, gval16, bval16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
-PIX       *pixd;
+l_int32             hm;
+PIX                *pixd;
+BG_MAP_ROW_PARAMS   params;
 
     PROCNAME("pixApplyInvBackgroundRGBMap");
 
@@ -1949,42 +2115,118 @@ PIX       *pixd;
     if (sx == 0 || sy == 0)
         return (PIX *)ERROR_PTR("invalid sx and/or sy", procName, NULL);
 
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
-    w = pixGetWidth(pixs);
-    h = pixGetHeight(pixs);
-    wm = pixGetWidth(pixmr);
-    hm = pixGetHeight(pixmr);
+    pixGetDimensions(pixmr, &params.nx, &hm, NULL);
     pixd = pixCreateTemplate(pixs);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixmr, j, i, &rval16);
-            pixGetPixel(pixmg, j, i, &gval16);
-            pixGetPixel(pixmb, j, i, &bval16);
-            xoff = sx * j;
-            for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
-                for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = *(flines + xoff + m);
-                    rvald = ((vals >> 24) * rval16) / 256;
-                    rvald = L_MIN(rvald, 255);
-                    gvald = (((vals >> 16) & 0xff) * gval16) / 256;
-                    gvald = L_MIN(gvald, 255);
-                    bvald = (((vals >> 8) & 0xff) * bval16) / 256;
-                    bvald = L_MIN(bvald, 255);
-                    composeRGBPixel(rvald, gvald, bvald, flined + xoff + m);
-                }
+    params.pixs = pixs;
+    params.pixm[0] = pixmr;
+    params.pixm[1] = pixmg;
+    params.pixm[2] = pixmb;
+    params.pixd = pixd;
+    params.sx = sx;
+    params.sy = sy;
+    l_parallelRun(hm, 0, applyInvBgRGBRow, &params);
+    return pixd;
+}
+
+
+/*!
+ *  applyInvBgGrayRow()
+ *
+ *      Input:  data (BG_MAP_ROW_PARAMS)
+ *              i (row of the inverse map)
+ *      Return: 0 if OK
+ *
+ *  Notes:
+ *      (1) Multiplies the pixels in the band of sy image rows that
+ *          correspond to map row i by the map values, in units of 1/256.
+ */
+static l_int32
+applyInvBgGrayRow(void    *data,
+                  l_int32  i)
+{
+l_int32             w, h, sx, sy, wpls, wpld, j, k, m, xoff, yoff;
+l_int32             vals, vald;
+l_uint32            val16;
+l_uint32           *lines, *lined, *flines, *flined;
+BG_MAP_ROW_PARAMS  *params;
+
+    params = (BG_MAP_ROW_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    sx = params->sx;
+    sy = params->sy;
+    wpls = pixGetWpl(params->pixs);
+    wpld = pixGetWpl(params->pixd);
+    lines = pixGetData(params->pixs) + sy * i * wpls;
+    lined = pixGetData(params->pixd) + sy * i * wpld;
+    yoff = sy * i;
+    for (j = 0; j < params->nx; j++) {
+        pixGetPixel(params->pixm[0], j, i, &val16);
+        xoff = sx * j;
+        for (k = 0; k < sy && yoff + k < h; k++) {
+            flines = lines + k * wpls;
+            flined = lined + k * wpld;
+            for (m = 0; m < sx && xoff + m < w; m++) {
+                vals = GET_DATA_BYTE(flines, xoff + m);
+                vald = (vals * val16) / 256;
+                vald = L_MIN(vald, 255);
+                SET_DATA_BYTE(flined, xoff + m, vald);
             }
         }
     }
+    return 0;
+}
 
-    return pixd;
+
+/*!
+ *  applyInvBgRGBRow()
+ *
+ *      Input:  data (BG_MAP_ROW_PARAMS)
+ *              i (row of the inverse maps)
+ *      Return: 0 if OK
+ *
+ *  Notes:
+ *      (1) This is the 32 bpp version of applyInvBgGrayRow().
+ */
+static l_int32
+applyInvBgRGBRow(void    *data,
+                 l_int32  i)
+{
+l_int32             w, h, sx, sy, wpls, wpld, j, k, m, xoff, yoff;
+l_int32             rvald, gvald, bvald;
+l_uint32            vals, rval16, gval16, bval16;
+l_uint32           *lines, *lined, *flines, *flined;
+BG_MAP_ROW_PARAMS  *params;
+
+    params = (BG_MAP_ROW_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    sx = params->sx;
+    sy = params->sy;
+    wpls = pixGetWpl(params->pixs);
+    wpld = pixGetWpl(params->pixd);
+    lines = pixGetData(params->pixs) + sy * i * wpls;
+    lined = pixGetData(params->pixd) + sy * i * wpld;
+    yoff = sy * i;
+    for (j = 0; j < params->nx; j++) {
+        pixGetPixel(params->pixm[0], j, i, &rval16);
+        pixGetPixel(params->pixm[1], j, i, &gval16);
+        pixGetPixel(params->pixm[2], j, i, &bval16);
+        xoff = sx * j;
+        for (k = 0; k < sy && yoff + k < h; k++) {
+            flines = lines + k * wpls;
+            flined = lined + k * wpld;
+            for (m = 0; m < sx && xoff + m < w; m++) {
+                vals = *(flines + xoff + m);
+                rvald = ((vals >> 24) * rval16) / 256;
+                rvald = L_MIN(rvald, 255);
+                gvald = (((vals >> 16) & 0xff) * gval16) / 256;
+                gvald = L_MIN(gvald, 255);
+                bvald = (((vals >> 8) & 0xff) * bval16) / 256;
+                bvald = L_MIN(bvald, 255);
+                composeRGBPixel(rvald, gvald, bvald, flined + xoff + m);
+            }
+        }
+    }
+    return 0;
 }
 
 
@@ -2681,7 +2923,7 @@ pixSetLowContrast(PIX     *pixs1,
                   PIX     *pixs2,
                   l_int32  mindiff)
 {
-l_int32    i, j, w, h, d, wpl, val1, val2, found;
+l_int32    i, j, w, h, d, wpl1, wpl2, val1, val2, found;
 l_uint32  *data1, *data2, *line1, *line2;
 
     PROCNAME("pixSetLowContrast");
@@ -2697,11 +2939,12 @@ l_uint32  *data1, *data2, *line1, *line2;
 
     data1 = pixGetData(pixs1);
     data2 = pixGetData(pixs2);
-    wpl = pixGetWpl(pixs1);
+    wpl1 = pixGetWpl(pixs1);
+    wpl2 = pixGetWpl(pixs2);
     found = 0;  /* init to not finding any diffs >= mindiff */
     for (i = 0; i < h; i++) {
-        line1 = data1 + i * wpl;
-        line2 = data2 + i * wpl;
+        line1 = data1 + i * wpl1;
+        line2 = data2 + i * wpl2;
         for (j = 0; j < w; j++) {
             val1 = GET_DATA_BYTE(line1, j);
             val2 = GET_DATA_BYTE(line2, j);
@@ -2720,8 +2963,8 @@ l_uint32  *data1, *data2, *line1, *line2;
     }
 
     for (i = 0; i < h; i++) {
-        line1 = data1 + i * wpl;
-        line2 = data2 + i * wpl;
+        line1 = data1 + i * wpl1;
+        line2 = data2 + i * wpl2;
         for (j = 0; j < w; j++) {
             val1 = GET_DATA_BYTE(line1, j);
             val2 = GET_DATA_BYTE(line2, j);
@@ -116,6 +116,13 @@ LEPT_DLL extern l_int32 l_getDataTwoBytes ( void *line, l_int32 n );
 LEPT_DLL extern void l_setDataTwoBytes ( void *line, l_int32 n, l_int32 val );
 LEPT_DLL extern l_int32 l_getDataFourBytes ( void *line, l_int32 n );
 LEPT_DLL extern void l_setDataFourBytes ( void *line, l_int32 n, l_int32 val );
+LEPT_DLL extern L_BANDREADER * bandReaderCreate ( const char *filename, l_int32 bandh, l_int32 overlap );
+LEPT_DLL extern void bandReaderDestroy ( L_BANDREADER **pbr );
+LEPT_DLL extern l_int32 bandReaderGetInfo ( L_BANDREADER *br, l_int32 *pw, l_int32 *ph, l_int32 *pd, l_int32 *pnbands );
+LEPT_DLL extern PIX * bandReaderNext ( L_BANDREADER *br, l_int32 *py, l_int32 *ptop, l_int32 *pbot );
+LEPT_DLL extern L_BANDWRITER * bandWriterCreate ( const char *filename, l_int32 format, l_int32 h, l_int32 quality );
+LEPT_DLL extern void bandWriterDestroy ( L_BANDWRITER **pbw );
+LEPT_DLL extern l_int32 bandWriterWrite ( L_BANDWRITER *bw, PIX *pixs );
 LEPT_DLL extern char * barcodeDispatchDecoder ( char *barstr, l_int32 format, l_int32 debugflag );
 LEPT_DLL extern l_int32 barcodeFormatIsSupported ( l_int32 format );
 LEPT_DLL extern NUMA * pixFindBaselines ( PIX *pixs, PTA **ppta, l_int32 debug );
@@ -608,12 +615,14 @@ LEPT_DLL extern FPIX * fpixConvolve ( FPIX *fpixs, L_KERNEL *kel, l_int32 normfl
 LEPT_DLL extern FPIX * fpixConvolveSep ( FPIX *fpixs, L_KERNEL *kelx, L_KERNEL *kely, l_int32 normflag );
 LEPT_DLL extern PIX * pixConvolveWithBias ( PIX *pixs, L_KERNEL *kel1, L_KERNEL *kel2, l_int32 force8, l_int32 *pbias );
 LEPT_DLL extern void l_setConvolveSampling ( l_int32 xfact, l_int32 yfact );
+LEPT_DLL extern void l_setConvolveSeparable ( l_int32 flag );
 LEPT_DLL extern PIX * pixAddGaussianNoise ( PIX *pixs, l_float32 stdev );
 LEPT_DLL extern l_float32 gaussDistribSampling (  );
 LEPT_DLL extern l_int32 pixCorrelationScore ( PIX *pix1, PIX *pix2, l_int32 area1, l_int32 area2, l_float32 delx, l_float32 dely, l_int32 maxdiffw, l_int32 maxdiffh, l_int32 *tab, l_float32 *pscore );
 LEPT_DLL extern l_int32 pixCorrelationScoreThresholded ( PIX *pix1, PIX *pix2, l_int32 area1, l_int32 area2, l_float32 delx, l_float32 dely, l_int32 maxdiffw, l_int32 maxdiffh, l_int32 *tab, l_int32 *downcount, l_float32 score_threshold );
 LEPT_DLL extern l_int32 pixCorrelationScoreSimple ( PIX *pix1, PIX *pix2, l_int32 area1, l_int32 area2, l_float32 delx, l_float32 dely, l_int32 maxdiffw, l_int32 maxdiffh, l_int32 *tab, l_float32 *pscore );
 LEPT_DLL extern l_int32 pixCorrelationScoreShifted ( PIX *pix1, PIX *pix2, l_int32 area1, l_int32 area2, l_int32 delx, l_int32 dely, l_int32 *tab, l_float32 *pscore );
+LEPT_DLL extern l_int32 pixCorrelationScoreBatch ( PIX *pix1, l_int32 area1, PIXA *pixa2, NUMA *na2, PTA *pta2, l_int32 maxshift, l_int32 maxdiffw, l_int32 maxdiffh, NUMA **pnascore, PTA **pptashift );
 LEPT_DLL extern L_DEWARP * dewarpCreate ( PIX *pixs, l_int32 pageno );
 LEPT_DLL extern L_DEWARP * dewarpCreateRef ( l_int32 pageno, l_int32 refpage );
 LEPT_DLL extern void dewarpDestroy ( L_DEWARP **pdew );
@@ -721,6 +730,10 @@ LEPT_DLL extern l_int32 l_dnaJoin ( L_DNA *dad, L_DNA *das, l_int32 istart, l_in
 LEPT_DLL extern PIX * pixMorphDwa_2 ( PIX *pixd, PIX *pixs, l_int32 operation, char *selname );
 LEPT_DLL extern PIX * pixFMorphopGen_2 ( PIX *pixd, PIX *pixs, l_int32 operation, char *selname );
 LEPT_DLL extern l_int32 fmorphopgen_low_2 ( l_uint32 *datad, l_int32 w, l_int32 h, l_int32 wpld, l_uint32 *datas, l_int32 wpls, l_int32 index );
+LEPT_DLL extern PIX * pixMorphSelDwa ( PIX *pixd, PIX *pixs, l_int32 operation, SEL *sel );
+LEPT_DLL extern PIX * pixHMTSelDwa ( PIX *pixd, PIX *pixs, SEL *sel );
+LEPT_DLL extern l_int32 l_dwaPlanCacheClear ( void );
+LEPT_DLL extern l_int32 l_dwaPlanCacheGetCount ( void );
 LEPT_DLL extern PIX * pixSobelEdgeFilter ( PIX *pixs, l_int32 orientflag );
 LEPT_DLL extern PIX * pixTwoSidedEdgeFilter ( PIX *pixs, l_int32 orientflag );
 LEPT_DLL extern l_int32 pixMeasureEdgeSmoothness ( PIX *pixs, l_int32 side, l_int32 minjump, l_int32 minreversal, l_float32 *pjpl, l_float32 *pjspl, l_float32 *prpl, const char *debugfile );
@@ -876,6 +889,10 @@ LEPT_DLL extern FPIX * fpixProjective ( FPIX *fpixs, l_float32 *vc, l_float32 in
 LEPT_DLL extern l_int32 linearInterpolatePixelFloat ( l_float32 *datas, l_int32 w, l_int32 h, l_float32 x, l_float32 y, l_float32 inval, l_float32 *pval );
 LEPT_DLL extern PIX * fpixThresholdToPix ( FPIX *fpix, l_float32 thresh );
 LEPT_DLL extern FPIX * pixComponentFunction ( PIX *pix, l_float32 rnum, l_float32 gnum, l_float32 bnum, l_float32 rdenom, l_float32 gdenom, l_float32 bdenom );
+LEPT_DLL extern l_int32 pixEncodeG4 ( l_uint8 **pdata, size_t *pnbytes, PIX *pixs );
+LEPT_DLL extern PIX * pixDecodeG4 ( const l_uint8 *data, size_t nbytes, l_int32 w, l_int32 h );
+LEPT_DLL extern l_int32 pixEncodeG4Tiff ( l_uint8 **pdata, size_t *psize, PIX *pixs );
+LEPT_DLL extern PIX * pixDecodeG4Tiff ( const l_uint8 *data, size_t size );
 LEPT_DLL extern PIX * pixReadStreamGif ( FILE *fp );
 LEPT_DLL extern l_int32 pixWriteStreamGif ( FILE *fp, PIX *pix );
 LEPT_DLL extern PIX * pixReadMemGif ( const l_uint8 *cdata, size_t size );
@@ -1042,6 +1059,12 @@ LEPT_DLL extern PIX * pixReadMemJpeg ( const l_uint8 *data, size_t size, l_int32
 LEPT_DLL extern l_int32 readHeaderMemJpeg ( const l_uint8 *data, size_t size, l_int32 *pw, l_int32 *ph, l_int32 *pspp, l_int32 *pycck, l_int32 *pcmyk );
 LEPT_DLL extern l_int32 pixWriteMemJpeg ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 quality, l_int32 progressive );
 LEPT_DLL extern l_int32 pixSetChromaSampling ( PIX *pix, l_int32 sampling );
+LEPT_DLL extern l_int32 jpegBandReaderOpen ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 jpegBandReaderRead ( L_BANDREADER *br, PIX *pixd, l_int32 y, l_int32 nrows );
+LEPT_DLL extern void jpegBandReaderClose ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 jpegBandWriterOpen ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 jpegBandWriterWrite ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 jpegBandWriterClose ( L_BANDWRITER *bw );
 LEPT_DLL extern L_KERNEL * kernelCreate ( l_int32 height, l_int32 width );
 LEPT_DLL extern void kernelDestroy ( L_KERNEL **pkel );
 LEPT_DLL extern L_KERNEL * kernelCopy ( L_KERNEL *kels );
@@ -1053,6 +1076,7 @@ LEPT_DLL extern l_int32 kernelGetSum ( L_KERNEL *kel, l_float32 *psum );
 LEPT_DLL extern l_int32 kernelGetMinMax ( L_KERNEL *kel, l_float32 *pmin, l_float32 *pmax );
 LEPT_DLL extern L_KERNEL * kernelNormalize ( L_KERNEL *kels, l_float32 normsum );
 LEPT_DLL extern L_KERNEL * kernelInvert ( L_KERNEL *kels );
+LEPT_DLL extern l_int32 kernelGetSeparable ( L_KERNEL *kel, L_KERNEL **pkelx, L_KERNEL **pkely );
 LEPT_DLL extern l_float32 ** create2dFloatArray ( l_int32 sy, l_int32 sx );
 LEPT_DLL extern L_KERNEL * kernelRead ( const char *fname );
 LEPT_DLL extern L_KERNEL * kernelReadStream ( FILE *fp );
@@ -1165,6 +1189,8 @@ LEPT_DLL extern PIX * pixMorphCompSequence ( PIX *pixs, const char *sequence, l_
 LEPT_DLL extern PIX * pixMorphSequenceDwa ( PIX *pixs, const char *sequence, l_int32 dispsep );
 LEPT_DLL extern PIX * pixMorphCompSequenceDwa ( PIX *pixs, const char *sequence, l_int32 dispsep );
 LEPT_DLL extern l_int32 morphSequenceVerify ( SARRAY *sa );
+LEPT_DLL extern l_int32 l_setMorphSequenceBanding ( l_int32 flag );
+LEPT_DLL extern l_int32 l_getMorphSequenceBanding ( void );
 LEPT_DLL extern PIX * pixGrayMorphSequence ( PIX *pixs, const char *sequence, l_int32 dispsep, l_int32 dispy );
 LEPT_DLL extern PIX * pixColorMorphSequence ( PIX *pixs, const char *sequence, l_int32 dispsep, l_int32 dispy );
 LEPT_DLL extern NUMA * numaCreate ( l_int32 n );
@@ -1331,6 +1357,14 @@ LEPT_DLL extern l_int32 pixColorGrayMaskedCmap ( PIX *pixs, PIX *pixm, l_int32 t
 LEPT_DLL extern l_int32 addColorizedGrayToCmap ( PIXCMAP *cmap, l_int32 type, l_int32 rval, l_int32 gval, l_int32 bval, NUMA **pna );
 LEPT_DLL extern l_int32 pixSetSelectMaskedCmap ( PIX *pixs, PIX *pixm, l_int32 x, l_int32 y, l_int32 sindex, l_int32 rval, l_int32 gval, l_int32 bval );
 LEPT_DLL extern l_int32 pixSetMaskedCmap ( PIX *pixs, PIX *pixm, l_int32 x, l_int32 y, l_int32 rval, l_int32 gval, l_int32 bval );
+LEPT_DLL extern l_int32 l_setParallelThreads ( l_int32 nthreads );
+LEPT_DLL extern l_int32 l_getParallelThreads ( void );
+LEPT_DLL extern l_int32 l_parallelRun ( l_int32 ntasks, l_int32 nthreads, l_int32 ( *func ) ( void *, l_int32 ), void *data );
+LEPT_DLL extern L_MUTEX * l_mutexCreate ( void );
+LEPT_DLL extern void l_mutexDestroy ( L_MUTEX **pmutex );
+LEPT_DLL extern void l_mutexLock ( L_MUTEX *mutex );
+LEPT_DLL extern void l_mutexUnlock ( L_MUTEX *mutex );
+LEPT_DLL extern L_MUTEX * l_mutexGetStatic ( L_MUTEX **pmutex );
 LEPT_DLL extern char * parseForProtos ( const char *filein, const char *prestring );
 LEPT_DLL extern BOXA * boxaGetWhiteblocks ( BOXA *boxas, BOX *box, l_int32 sortflag, l_int32 maxboxes, l_float32 maxoverlap, l_int32 maxperim, l_float32 fract, l_int32 maxpops );
 LEPT_DLL extern BOXA * boxaPruneSortedOnOverlap ( BOXA *boxas, l_float32 maxoverlap );
@@ -1364,13 +1398,19 @@ LEPT_DLL extern l_int32 concatenatePdfToData ( const char *dirname, const char *
 LEPT_DLL extern l_int32 saConcatenatePdfToData ( SARRAY *sa, l_uint8 **pdata, size_t *pnbytes );
 LEPT_DLL extern l_int32 pixConvertToPdfData ( PIX *pix, l_int32 type, l_int32 quality, l_uint8 **pdata, size_t *pnbytes, l_int32 x, l_int32 y, l_int32 res, const char *title, L_PDF_DATA **plpd, l_int32 position );
 LEPT_DLL extern l_int32 ptraConcatenatePdfToData ( L_PTRA *pa_data, SARRAY *sa, l_uint8 **pdata, size_t *pnbytes );
+LEPT_DLL extern L_PDFWRITER * pdfWriterOpen ( const char *fileout, const char *title );
+LEPT_DLL extern l_int32 pdfWriterAddPage ( L_PDFWRITER *pw, l_uint8 *data, size_t nbytes );
+LEPT_DLL extern l_int32 pdfWriterAddPix ( L_PDFWRITER *pw, PIX *pix, l_int32 type, l_int32 quality, l_int32 res );
+LEPT_DLL extern l_int32 pdfWriterClose ( L_PDFWRITER **ppw );
 LEPT_DLL extern l_int32 l_generateCIDataForPdf ( const char *fname, PIX *pix, l_int32 quality, L_COMP_DATA **pcid );
 LEPT_DLL extern L_COMP_DATA * l_generateFlateDataPdf ( const char *fname, PIX *pixs );
 LEPT_DLL extern L_COMP_DATA * l_generateJpegData ( const char *fname, l_int32 ascii85flag );
+LEPT_DLL extern L_COMP_DATA * l_generateJpegDataMem ( l_uint8 *data, size_t nbytes, l_int32 ascii85flag );
 LEPT_DLL extern l_int32 l_generateCIData ( const char *fname, l_int32 type, l_int32 quality, l_int32 ascii85, L_COMP_DATA **pcid );
 LEPT_DLL extern l_int32 pixGenerateCIData ( PIX *pixs, l_int32 type, l_int32 quality, l_int32 ascii85, L_COMP_DATA **pcid );
 LEPT_DLL extern L_COMP_DATA * l_generateFlateData ( const char *fname, l_int32 ascii85flag );
 LEPT_DLL extern L_COMP_DATA * l_generateG4Data ( const char *fname, l_int32 ascii85flag );
+LEPT_DLL extern L_COMP_DATA * l_generateG4DataMem ( l_uint8 *data, size_t nbytes, l_int32 ascii85flag );
 LEPT_DLL extern l_int32 cidConvertToPdfData ( L_COMP_DATA *cid, const char *title, l_uint8 **pdata, size_t *pnbytes );
 LEPT_DLL extern void l_CIDataDestroy ( L_COMP_DATA **pcid );
 LEPT_DLL extern void l_pdfSetG4ImageMask ( l_int32 flag );
@@ -1382,6 +1422,9 @@ LEPT_DLL extern PIX * pixCreateTemplate ( PIX *pixs );
 LEPT_DLL extern PIX * pixCreateTemplateNoInit ( PIX *pixs );
 LEPT_DLL extern PIX * pixCreateHeader ( l_int32 width, l_int32 height, l_int32 depth );
 LEPT_DLL extern PIX * pixClone ( PIX *pixs );
+LEPT_DLL extern PIX * pixCreateView ( PIX *pixs, BOX *box );
+LEPT_DLL extern PIX * pixCreateFromData ( l_uint32 *data, l_int32 width, l_int32 height, l_int32 depth, l_int32 wpl );
+LEPT_DLL extern l_int32 pixIsView ( PIX *pix );
 LEPT_DLL extern void pixDestroy ( PIX **ppix );
 LEPT_DLL extern PIX * pixCopy ( PIX *pixd, PIX *pixs );
 LEPT_DLL extern l_int32 pixResizeImageData ( PIX *pixd, PIX *pixs );
@@ -1734,6 +1777,13 @@ LEPT_DLL extern void * pmsGetAlloc ( size_t nbytes );
 LEPT_DLL extern l_int32 pmsGetLevelForAlloc ( size_t nbytes, l_int32 *plevel );
 LEPT_DLL extern l_int32 pmsGetLevelForDealloc ( void *data, l_int32 *plevel );
 LEPT_DLL extern void pmsLogInfo (  );
+LEPT_DLL extern l_int32 pmaCreate ( size_t minsize, size_t maxsize, size_t maxretain );
+LEPT_DLL extern void pmaDestroy ( void );
+LEPT_DLL extern void * pmaCustomAlloc ( size_t nbytes );
+LEPT_DLL extern void pmaCustomDealloc ( void *data );
+LEPT_DLL extern void pmaTrim ( void );
+LEPT_DLL extern l_int32 pmaGetStats ( l_int32 *pnarenas, size_t *pnalloc, size_t *pnreuse, size_t *pnremote, size_t *pinuse, size_t *pretained );
+LEPT_DLL extern void pmaLogInfo ( void );
 LEPT_DLL extern l_int32 pixAddConstantGray ( PIX *pixs, l_int32 val );
 LEPT_DLL extern l_int32 pixMultConstantGray ( PIX *pixs, l_float32 val );
 LEPT_DLL extern PIX * pixAddGray ( PIX *pixd, PIX *pixs1, PIX *pixs2 );
@@ -1854,6 +1904,7 @@ LEPT_DLL extern l_int32 pixTilingGetSize ( PIXTILING *pt, l_int32 *pw, l_int32 *
 LEPT_DLL extern PIX * pixTilingGetTile ( PIXTILING *pt, l_int32 i, l_int32 j );
 LEPT_DLL extern l_int32 pixTilingNoStripOnPaint ( PIXTILING *pt );
 LEPT_DLL extern l_int32 pixTilingPaintTile ( PIX *pixd, l_int32 i, l_int32 j, PIX *pixs, PIXTILING *pt );
+LEPT_DLL extern l_int32 pixTilingProcess ( PIXTILING *pt, PIX *pixd, PIX * ( *func ) ( PIX *, l_int32, l_int32, void * ), void *data, l_int32 nthreads );
 LEPT_DLL extern PIX * pixReadStreamPng ( FILE *fp );
 LEPT_DLL extern l_int32 readHeaderPng ( const char *filename, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
 LEPT_DLL extern l_int32 freadHeaderPng ( FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
@@ -1867,6 +1918,12 @@ LEPT_DLL extern l_int32 pixSetZlibCompression ( PIX *pix, l_int32 compval );
 LEPT_DLL extern void l_pngSetReadStrip16To8 ( l_int32 flag );
 LEPT_DLL extern PIX * pixReadMemPng ( const l_uint8 *data, size_t size );
 LEPT_DLL extern l_int32 pixWriteMemPng ( l_uint8 **pdata, size_t *psize, PIX *pix, l_float32 gamma );
+LEPT_DLL extern l_int32 pngBandReaderOpen ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 pngBandReaderRead ( L_BANDREADER *br, PIX *pixd, l_int32 y, l_int32 nrows );
+LEPT_DLL extern void pngBandReaderClose ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 pngBandWriterOpen ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 pngBandWriterWrite ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 pngBandWriterClose ( L_BANDWRITER *bw );
 LEPT_DLL extern PIX * pixReadStreamPnm ( FILE *fp );
 LEPT_DLL extern l_int32 readHeaderPnm ( const char *filename, l_int32 *pw, l_int32 *ph, l_int32 *pd, l_int32 *ptype, l_int32 *pbps, l_int32 *pspp );
 LEPT_DLL extern l_int32 freadHeaderPnm ( FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pd, l_int32 *ptype, l_int32 *pbps, l_int32 *pspp );
@@ -2171,6 +2228,9 @@ LEPT_DLL extern l_int32 regTestCompareSimilarPix ( L_REGPARAMS *rp, PIX *pix1, P
 LEPT_DLL extern l_int32 regTestCheckFile ( L_REGPARAMS *rp, const char *localname );
 LEPT_DLL extern l_int32 regTestCompareFiles ( L_REGPARAMS *rp, l_int32 index1, l_int32 index2 );
 LEPT_DLL extern l_int32 regTestWritePixAndCheck ( L_REGPARAMS *rp, PIX *pix, l_int32 format );
+LEPT_DLL extern l_int32 regTestCompareFPix ( L_REGPARAMS *rp, FPIX *fpix1, FPIX *fpix2 );
+LEPT_DLL extern l_int32 regTestCompareParallel ( L_REGPARAMS *rp, PIXA * ( *func ) ( PIX *, void *, FPIXA ** ), PIX *pixs, void *data, l_int32 nthreads, PIXA **ppixa );
+LEPT_DLL extern PIX * regTestMakeRandomPix ( l_int32 w, l_int32 h, l_int32 d, l_uint32 seed );
 LEPT_DLL extern l_int32 pixRasterop ( PIX *pixd, l_int32 dx, l_int32 dy, l_int32 dw, l_int32 dh, l_int32 op, PIX *pixs, l_int32 sx, l_int32 sy );
 LEPT_DLL extern l_int32 pixRasteropVip ( PIX *pixd, l_int32 bx, l_int32 bw, l_int32 vshift, l_int32 incolor );
 LEPT_DLL extern l_int32 pixRasteropHip ( PIX *pixd, l_int32 by, l_int32 bh, l_int32 hshift, l_int32 incolor );
@@ -2182,6 +2242,7 @@ LEPT_DLL extern void rasteropHipLow ( l_uint32 *data, l_int32 pixh, l_int32 dept
 LEPT_DLL extern void shiftDataHorizontalLow ( l_uint32 *datad, l_int32 wpld, l_uint32 *datas, l_int32 wpls, l_int32 shift );
 LEPT_DLL extern void rasteropUniLow ( l_uint32 *datad, l_int32 dpixw, l_int32 dpixh, l_int32 depth, l_int32 dwpl, l_int32 dx, l_int32 dy, l_int32 dw, l_int32 dh, l_int32 op );
 LEPT_DLL extern void rasteropLow ( l_uint32 *datad, l_int32 dpixw, l_int32 dpixh, l_int32 depth, l_int32 dwpl, l_int32 dx, l_int32 dy, l_int32 dw, l_int32 dh, l_int32 op, l_uint32 *datas, l_int32 spixw, l_int32 spixh, l_int32 swpl, l_int32 sx, l_int32 sy );
+LEPT_DLL extern void rasteropWordsLow ( l_uint32 *datad, l_int32 dwpl, l_uint32 *datas, l_int32 swpl, l_int32 nwords, l_int32 nrows, l_int32 op, l_int32 shift );
 LEPT_DLL extern PIX * pixRotate ( PIX *pixs, l_float32 angle, l_int32 type, l_int32 incolor, l_int32 width, l_int32 height );
 LEPT_DLL extern PIX * pixEmbedForRotation ( PIX *pixs, l_float32 angle, l_int32 incolor, l_int32 width, l_int32 height );
 LEPT_DLL extern PIX * pixRotateBySampling ( PIX *pixs, l_int32 xcen, l_int32 ycen, l_float32 angle, l_int32 incolor );
@@ -2430,6 +2491,10 @@ LEPT_DLL extern l_int32 pixHShearIP ( PIX *pixs, l_int32 yloc, l_float32 radang,
 LEPT_DLL extern l_int32 pixVShearIP ( PIX *pixs, l_int32 xloc, l_float32 radang, l_int32 incolor );
 LEPT_DLL extern PIX * pixHShearLI ( PIX *pixs, l_int32 yloc, l_float32 radang, l_int32 incolor );
 LEPT_DLL extern PIX * pixVShearLI ( PIX *pixs, l_int32 xloc, l_float32 radang, l_int32 incolor );
+LEPT_DLL extern l_int32 * makeShearBands ( l_int32 size, l_int32 loc, l_float32 radang, l_int32 vertical, l_int32 *pnbands );
+LEPT_DLL extern l_int32 l_simdSupported ( l_int32 mode );
+LEPT_DLL extern l_int32 l_setSimdMode ( l_int32 mode );
+LEPT_DLL extern l_int32 l_getSimdMode ( void );
 LEPT_DLL extern PIX * pixDeskew ( PIX *pixs, l_int32 redsearch );
 LEPT_DLL extern PIX * pixFindSkewAndDeskew ( PIX *pixs, l_int32 redsearch, l_float32 *pangle, l_float32 *pconf );
 LEPT_DLL extern PIX * pixDeskewGeneral ( PIX *pixs, l_int32 redsweep, l_float32 sweeprange, l_float32 sweepdelta, l_int32 redsearch, l_int32 thresh, l_float32 *pangle, l_float32 *pconf );
@@ -2440,6 +2505,7 @@ LEPT_DLL extern l_int32 pixFindSkewSweepAndSearchScore ( PIX *pixs, l_float32 *p
 LEPT_DLL extern l_int32 pixFindSkewSweepAndSearchScorePivot ( PIX *pixs, l_float32 *pangle, l_float32 *pconf, l_float32 *pendscore, l_int32 redsweep, l_int32 redsearch, l_float32 sweepcenter, l_float32 sweeprange, l_float32 sweepdelta, l_float32 minbsdelta, l_int32 pivot );
 LEPT_DLL extern l_int32 pixFindSkewOrthogonalRange ( PIX *pixs, l_float32 *pangle, l_float32 *pconf, l_int32 redsweep, l_int32 redsearch, l_float32 sweeprange, l_float32 sweepdelta, l_float32 minbsdelta, l_float32 confprior );
 LEPT_DLL extern l_int32 pixFindDifferentialSquareSum ( PIX *pixs, l_float32 *psum );
+LEPT_DLL extern NUMA * pixFindDifferentialSquareSums ( PIX *pixs, NUMA *naangle, l_int32 pivot );
 LEPT_DLL extern l_int32 pixFindNormalizedSquareSum ( PIX *pixs, l_float32 *phratio, l_float32 *pvratio, l_float32 *pfract );
 LEPT_DLL extern PIX * pixReadStreamSpix ( FILE *fp );
 LEPT_DLL extern l_int32 readHeaderSpix ( const char *filename, l_int32 *pwidth, l_int32 *pheight, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
@@ -2496,6 +2562,13 @@ LEPT_DLL extern l_int32 freadHeaderTiff ( FILE *fp, l_int32 n, l_int32 *pwidth,
 LEPT_DLL extern l_int32 readHeaderMemTiff ( const l_uint8 *cdata, size_t size, l_int32 n, l_int32 *pwidth, l_int32 *pheight, l_int32 *pbps, l_int32 *pspp, l_int32 *pres, l_int32 *pcmap, l_int32 *pformat );
 LEPT_DLL extern l_int32 findTiffCompression ( FILE *fp, l_int32 *pcomptype );
 LEPT_DLL extern l_int32 extractG4DataFromFile ( const char *filein, l_uint8 **pdata, size_t *pnbytes, l_int32 *pw, l_int32 *ph, l_int32 *pminisblack );
+LEPT_DLL extern l_int32 extractG4DataFromMem ( const l_uint8 *cdata, size_t size, size_t *poffset, size_t *pnbytes, l_int32 *pw, l_int32 *ph, l_int32 *pminisblack, l_int32 *pres );
+LEPT_DLL extern l_int32 tiffBandReaderOpen ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 tiffBandReaderRead ( L_BANDREADER *br, PIX *pixd, l_int32 y, l_int32 nrows );
+LEPT_DLL extern void tiffBandReaderClose ( L_BANDREADER *br );
+LEPT_DLL extern l_int32 tiffBandWriterOpen ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 tiffBandWriterWrite ( L_BANDWRITER *bw, PIX *pixs );
+LEPT_DLL extern l_int32 tiffBandWriterClose ( L_BANDWRITER *bw );
 LEPT_DLL extern PIX * pixReadMemTiff ( const l_uint8 *cdata, size_t size, l_int32 n );
 LEPT_DLL extern l_int32 pixWriteMemTiff ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 comptype );
 LEPT_DLL extern l_int32 pixWriteMemTiffCustom ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 comptype, NUMA *natags, SARRAY *savals, SARRAY *satypes, NUMA *nasizes );
@@ -40,6 +40,7 @@
 #include "bbuffer.h"
 #include "heap.h"
 #include "list.h"
+#include "parallel.h"
 #include "ptra.h"
 #include "queue.h"
 #include "rbtree.h"
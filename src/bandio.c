@@ -0,0 +1,586 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  bandio.c
+ *
+ *     Band reader
+ *          L_BANDREADER   *bandReaderCreate()
+ *          void            bandReaderDestroy()
+ *          l_int32         bandReaderGetInfo()
+ *          PIX            *bandReaderNext()
+ *
+ *     Band writer
+ *          L_BANDWRITER   *bandWriterCreate()
+ *          void            bandWriterDestroy()
+ *          l_int32         bandWriterWrite()
+ *
+ *   These functions let you process png, jpeg and tiff images that
+ *   are too large to hold in memory, by decoding and encoding them
+ *   in horizontal bands.  Only the rows of the current band (plus
+ *   a few retained rows for overlap) are ever decoded at once.
+ *   The row-level decoding and encoding is done in pngio.c (libpng
+ *   row reads and writes), jpegio.c (libjpeg scanlines) and tiffio.c
+ *   (libtiff scanlines, strips and tiles).
+ *
+ *   Each band returned by bandReaderNext() has @bandh rows of the
+ *   image (fewer for the last band), plus up to @overlap rows of
+ *   the adjacent bands above and below.  There are no overlap rows
+ *   above the first band or below the last one.  Here's a typical
+ *   usage, for a pixel-wise operation that needs no overlap:
+ *
+ *      L_BANDREADER *br = bandReaderCreate("big.png", 256, 0);
+ *      bandReaderGetInfo(br, &w, &h, NULL, NULL);
+ *      L_BANDWRITER *bw = bandWriterCreate("big_bin.tif", IFF_TIFF_G4,
+ *                                          h, 0);
+ *      while ((pixb = bandReaderNext(br, NULL, NULL, NULL)) != NULL) {
+ *          pixt = pixThresholdToBinary(pixb, 128);
+ *          bandWriterWrite(bw, pixt);
+ *          pixDestroy(&pixb);
+ *          pixDestroy(&pixt);
+ *      }
+ *      bandWriterDestroy(&bw);
+ *      bandReaderDestroy(&br);
+ *
+ *   For an operation with vertical support of @k rows, such as
+ *   pixBlockconv() with a half-height of k, use @overlap = k, and
+ *   strip the overlap from each processed band before writing it:
+ *
+ *      pixb = bandReaderNext(br, &y, &top, &bot);
+ *      pixt = pixBlockconv(pixb, k, k);
+ *      box = boxCreate(0, top, w, pixGetHeight(pixb) - top - bot);
+ *      pixc = pixClipRectangle(pixt, box, NULL);
+ *      bandWriterWrite(bw, pixc);
+ *
+ *   For a reduction by an integer factor, such as pixScaleAreaMap2()
+ *   or pixScaleToGray4(), choose @bandh to be a multiple of the
+ *   reduction factor; then each band is reduced exactly as it would
+ *   be in the full image, and the writer is created with the
+ *   reduced height.
+ *
+ *   The reader returns the same pixels as pixRead(), with these
+ *   exceptions, for which bandReaderCreate() fails:
+ *     - interlaced png, and png with a tRNS transparency chunk
+ *     - tiff with an orientation other than ORIENTATION_TOPLEFT
+ *   The writer encodes each band as the corresponding whole-image
+ *   writer would, except that 24 bpp rgb input is not accepted.
+ */
+
+#include "allheaders.h"
+
+
+/*---------------------------------------------------------------------*
+ *                             Band reader                             *
+ *---------------------------------------------------------------------*/
+/*!
+ *  bandReaderCreate()
+ *
+ *      Input:  filename (png, jpeg or tiff)
+ *              bandh (number of image rows in each band; >= 1)
+ *              overlap (number of rows from adjacent bands to include
+ *                       above and below each band; >= 0)
+ *      Return: band reader, or null on error
+ *
+ *  Notes:
+ *      (1) Only the image header is read here.  The file is held
+ *          open until the reader is destroyed.
+ *      (2) For a multipage tiff, the first page is read.
+ */
+L_BANDREADER *
+bandReaderCreate(const char  *filename,
+                 l_int32      bandh,
+                 l_int32      overlap)
+{
+l_int32        format, ret;
+FILE          *fp;
+L_BANDREADER  *br;
+
+    PROCNAME("bandReaderCreate");
+
+    if (!filename)
+        return (L_BANDREADER *)ERROR_PTR("filename not defined",
+                                         procName, NULL);
+    if (bandh < 1)
+        return (L_BANDREADER *)ERROR_PTR("bandh < 1", procName, NULL);
+    if (overlap < 0)
+        return (L_BANDREADER *)ERROR_PTR("overlap < 0", procName, NULL);
+
+    if ((fp = fopenReadStream(filename)) == NULL)
+        return (L_BANDREADER *)ERROR_PTR("image file not found",
+                                         procName, NULL);
+    findFileFormatStream(fp, &format);
+    rewind(fp);
+
+    if ((br = (L_BANDREADER *)LEPT_CALLOC(1, sizeof(L_BANDREADER))) == NULL) {
+        fclose(fp);
+        return (L_BANDREADER *)ERROR_PTR("br not made", procName, NULL);
+    }
+    br->format = format;
+    br->bandh = bandh;
+    br->overlap = overlap;
+    br->fp = fp;
+
+    switch (format)
+    {
+    case IFF_PNG:
+        ret = pngBandReaderOpen(br);
+        break;
+    case IFF_JFIF_JPEG:
+        ret = jpegBandReaderOpen(br);
+        break;
+    case IFF_TIFF:
+    case IFF_TIFF_PACKBITS:
+    case IFF_TIFF_RLE:
+    case IFF_TIFF_G3:
+    case IFF_TIFF_G4:
+    case IFF_TIFF_LZW:
+    case IFF_TIFF_ZIP:
+        ret = tiffBandReaderOpen(br);
+        break;
+    default:
+        L_ERROR("format %d not supported for band reading\n", procName,
+                format);
+        ret = 1;
+        break;
+    }
+
+    if (ret) {
+        bandReaderDestroy(&br);
+        return (L_BANDREADER *)ERROR_PTR("band reader not opened",
+                                         procName, NULL);
+    }
+    return br;
+}
+
+
+/*!
+ *  bandReaderDestroy()
+ *
+ *      Input:  &br (<will be set to null before returning>)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The reader can be destroyed before all bands have been
+ *          read; the decoder is then abandoned without error.
+ */
+void
+bandReaderDestroy(L_BANDREADER  **pbr)
+{
+L_BANDREADER  *br;
+
+    PROCNAME("bandReaderDestroy");
+
+    if (pbr == NULL) {
+        L_WARNING("ptr address is null!\n", procName);
+        return;
+    }
+    if ((br = *pbr) == NULL)
+        return;
+
+    if (br->codec) {
+        switch (br->format)
+        {
+        case IFF_PNG:
+            pngBandReaderClose(br);
+            break;
+        case IFF_JFIF_JPEG:
+            jpegBandReaderClose(br);
+            break;
+        default:
+            tiffBandReaderClose(br);
+            break;
+        }
+    }
+    if (br->fp)
+        fclose(br->fp);
+    pixcmapDestroy(&br->cmap);
+    pixDestroy(&br->pixo);
+    LEPT_FREE(br);
+    *pbr = NULL;
+    return;
+}
+
+
+/*!
+ *  bandReaderGetInfo()
+ *
+ *      Input:  br
+ *              &w, &h (<optional return> image size)
+ *              &d (<optional return> depth of the returned bands)
+ *              &nbands (<optional return> number of bands)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) For a png with a 1 bpp colormap, the colormap is removed
+ *          from each band, as it is by pixRead(), and the returned
+ *          depth is that of the first band.  Otherwise, it is the
+ *          depth of the decoded image.
+ */
+l_int32
+bandReaderGetInfo(L_BANDREADER  *br,
+                  l_int32       *pw,
+                  l_int32       *ph,
+                  l_int32       *pd,
+                  l_int32       *pnbands)
+{
+l_int32   d;
+PIX      *pixt, *pixd;
+
+    PROCNAME("bandReaderGetInfo");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pd) *pd = 0;
+    if (pnbands) *pnbands = 0;
+    if (!br)
+        return ERROR_INT("br not defined", procName, 1);
+
+    if (pw) *pw = br->w;
+    if (ph) *ph = br->h;
+    if (pnbands) *pnbands = (br->h + br->bandh - 1) / br->bandh;
+    if (pd) {
+        d = br->d;
+        if (br->removecmap) {  /* find the depth after removing the cmap */
+            pixt = pixCreate(1, 1, br->d);
+            pixSetColormap(pixt, pixcmapCopy(br->cmap));
+            pixd = pixRemoveColormap(pixt, REMOVE_CMAP_BASED_ON_SRC);
+            d = pixGetDepth(pixd);
+            pixDestroy(&pixt);
+            pixDestroy(&pixd);
+        }
+        *pd = d;
+    }
+    return 0;
+}
+
+
+/*!
+ *  bandReaderNext()
+ *
+ *      Input:  br
+ *              &y (<optional return> image row of the first row
+ *                  of the band, not including the top overlap)
+ *              &top (<optional return> number of overlap rows
+ *                    at the top of the returned pix)
+ *              &bot (<optional return> number of overlap rows
+ *                    at the bottom of the returned pix)
+ *      Return: pix of the next band, or null when all bands have
+ *              been returned or on error
+ *
+ *  Notes:
+ *      (1) Rows that belong to two bands because of the overlap are
+ *          decoded only once; they are retained from one call to
+ *          the next.
+ *      (2) The returned pix has the resolution and input format of
+ *          the image, and is owned by the caller.
+ */
+PIX *
+bandReaderNext(L_BANDREADER  *br,
+               l_int32       *py,
+               l_int32       *ptop,
+               l_int32       *pbot)
+{
+l_int32  y, ytop, yend, yo, ho, nkeep, ret;
+BOX     *box;
+PIX     *pixd, *pixt;
+
+    PROCNAME("bandReaderNext");
+
+    if (py) *py = 0;
+    if (ptop) *ptop = 0;
+    if (pbot) *pbot = 0;
+    if (!br)
+        return (PIX *)ERROR_PTR("br not defined", procName, NULL);
+    if (br->ynext >= br->h || !br->codec)
+        return NULL;
+
+        /* Rows [ytop, yend) go in this band; those in [ytop, nread)
+         * have already been decoded and are held in pixo. */
+    y = br->ynext;
+    ytop = L_MAX(0, y - br->overlap);
+    yend = L_MIN(br->h, y + br->bandh + br->overlap);
+    if ((pixd = pixCreate(br->w, yend - ytop, br->d)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    pixSetSpp(pixd, br->spp);
+    pixSetResolution(pixd, br->xres, br->yres);
+    pixSetInputFormat(pixd, br->format);
+    if (br->cmap)
+        pixSetColormap(pixd, pixcmapCopy(br->cmap));
+
+    nkeep = br->nread - ytop;
+    if (nkeep > 0 && br->pixo) {
+        ho = pixGetHeight(br->pixo);
+        yo = ytop - (br->nread - ho);
+        pixRasterop(pixd, 0, 0, br->w, nkeep, PIX_SRC, br->pixo, 0, yo);
+    }
+
+    switch (br->format)
+    {
+    case IFF_PNG:
+        ret = pngBandReaderRead(br, pixd, br->nread - ytop, yend - br->nread);
+        break;
+    case IFF_JFIF_JPEG:
+        ret = jpegBandReaderRead(br, pixd, br->nread - ytop, yend - br->nread);
+        break;
+    default:
+        ret = tiffBandReaderRead(br, pixd, br->nread - ytop, yend - br->nread);
+        break;
+    }
+    if (ret) {
+        pixDestroy(&pixd);
+        br->ynext = br->h;  /* don't try again */
+        return (PIX *)ERROR_PTR("rows not decoded", procName, NULL);
+    }
+    br->nread = yend;
+    br->ynext = y + br->bandh;
+
+        /* Retain the rows needed for the top of the next band */
+    pixDestroy(&br->pixo);
+    if (br->overlap > 0 && br->ynext < br->h) {
+        ho = L_MIN(2 * br->overlap, yend - ytop);
+        box = boxCreate(0, yend - ytop - ho, br->w, ho);
+        br->pixo = pixClipRectangle(pixd, box, NULL);
+        boxDestroy(&box);
+    }
+
+    if (br->removecmap) {
+        pixt = pixRemoveColormap(pixd, REMOVE_CMAP_BASED_ON_SRC);
+        pixDestroy(&pixd);
+        pixd = pixt;
+    }
+
+    if (py) *py = y;
+    if (ptop) *ptop = y - ytop;
+    if (pbot) *pbot = yend - L_MIN(br->h, y + br->bandh);
+    return pixd;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                             Band writer                             *
+ *---------------------------------------------------------------------*/
+/*!
+ *  bandWriterCreate()
+ *
+ *      Input:  filename
+ *              format (IFF_PNG, IFF_JFIF_JPEG, or one of the IFF_TIFF*)
+ *              h (height of the full image to be written)
+ *              quality (for jpeg: 1 - 100, 0 for default; else ignored)
+ *      Return: band writer, or null on error
+ *
+ *  Notes:
+ *      (1) The width, depth, colormap and resolution of the output
+ *          are taken from the first band that is written.
+ *      (2) The encoding is finished, and the file closed, when the
+ *          last of the @h rows has been written.
+ *      (3) As with pixWriteStreamTiff(), the tiff compression is
+ *          changed to IFF_TIFF_ZIP for depth > 1 if it is only
+ *          defined for 1 bpp.
+ */
+L_BANDWRITER *
+bandWriterCreate(const char  *filename,
+                 l_int32      format,
+                 l_int32      h,
+                 l_int32      quality)
+{
+FILE          *fp;
+L_BANDWRITER  *bw;
+
+    PROCNAME("bandWriterCreate");
+
+    if (!filename)
+        return (L_BANDWRITER *)ERROR_PTR("filename not defined",
+                                         procName, NULL);
+    if (h < 1)
+        return (L_BANDWRITER *)ERROR_PTR("h < 1", procName, NULL);
+    if (format != IFF_PNG && format != IFF_JFIF_JPEG &&
+        format != IFF_TIFF && format != IFF_TIFF_PACKBITS &&
+        format != IFF_TIFF_RLE && format != IFF_TIFF_G3 &&
+        format != IFF_TIFF_G4 && format != IFF_TIFF_LZW &&
+        format != IFF_TIFF_ZIP)
+        return (L_BANDWRITER *)ERROR_PTR("format not supported",
+                                         procName, NULL);
+
+    if ((fp = fopenWriteStream(filename, "wb+")) == NULL)
+        return (L_BANDWRITER *)ERROR_PTR("stream not opened", procName, NULL);
+    if ((bw = (L_BANDWRITER *)LEPT_CALLOC(1, sizeof(L_BANDWRITER))) == NULL) {
+        fclose(fp);
+        return (L_BANDWRITER *)ERROR_PTR("bw not made", procName, NULL);
+    }
+    bw->format = format;
+    bw->h = h;
+    bw->quality = (quality <= 0) ? 75 : L_MIN(quality, 100);
+    bw->fp = fp;
+    return bw;
+}
+
+
+/*!
+ *  bandWriterDestroy()
+ *
+ *      Input:  &bw (<will be set to null before returning>)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) If fewer rows than the image height have been written,
+ *          the encoder is abandoned and an error is reported; the
+ *          output file is then incomplete.
+ */
+void
+bandWriterDestroy(L_BANDWRITER  **pbw)
+{
+L_BANDWRITER  *bw;
+
+    PROCNAME("bandWriterDestroy");
+
+    if (pbw == NULL) {
+        L_WARNING("ptr address is null!\n", procName);
+        return;
+    }
+    if ((bw = *pbw) == NULL)
+        return;
+
+    if (bw->nwritten < bw->h)
+        L_ERROR("only %d of %d rows written; output is incomplete\n",
+                procName, bw->nwritten, bw->h);
+    if (bw->codec) {
+        switch (bw->format)
+        {
+        case IFF_PNG:
+            pngBandWriterClose(bw);
+            break;
+        case IFF_JFIF_JPEG:
+            jpegBandWriterClose(bw);
+            break;
+        default:
+            tiffBandWriterClose(bw);
+            break;
+        }
+    }
+    if (bw->fp)
+        fclose(bw->fp);
+    LEPT_FREE(bw);
+    *pbw = NULL;
+    return;
+}
+
+
+/*!
+ *  bandWriterWrite()
+ *
+ *      Input:  bw
+ *              pixs (next band of the image)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The bands can have any height, but all must have the
+ *          width and depth of the first one.
+ *      (2) When the last row has been written, the encoding is
+ *          finished and the output file is closed.
+ */
+l_int32
+bandWriterWrite(L_BANDWRITER  *bw,
+                PIX           *pixs)
+{
+l_int32  w, h, d, ret;
+
+    PROCNAME("bandWriterWrite");
+
+    if (!bw)
+        return ERROR_INT("bw not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+    if (!bw->fp)
+        return ERROR_INT("writer already finished", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    if (d == 24)
+        return ERROR_INT("24 bpp rgb not supported", procName, 1);
+    if (bw->nwritten + h > bw->h)
+        return ERROR_INT("band extends below the image", procName, 1);
+
+        /* The first band determines the image parameters */
+    if (bw->nwritten == 0 && !bw->codec) {
+        bw->w = w;
+        bw->d = d;
+        switch (bw->format)
+        {
+        case IFF_PNG:
+            ret = pngBandWriterOpen(bw, pixs);
+            break;
+        case IFF_JFIF_JPEG:
+            ret = jpegBandWriterOpen(bw, pixs);
+            break;
+        default:
+            ret = tiffBandWriterOpen(bw, pixs);
+            break;
+        }
+        if (ret)
+            return ERROR_INT("encoder not started", procName, 1);
+    }
+    if (w != bw->w || d != bw->d)
+        return ERROR_INT("band size or depth differs from first band",
+                         procName, 1);
+    if (!bw->codec)
+        return ERROR_INT("encoder not available", procName, 1);
+
+    switch (bw->format)
+    {
+    case IFF_PNG:
+        ret = pngBandWriterWrite(bw, pixs);
+        break;
+    case IFF_JFIF_JPEG:
+        ret = jpegBandWriterWrite(bw, pixs);
+        break;
+    default:
+        ret = tiffBandWriterWrite(bw, pixs);
+        break;
+    }
+    if (ret)
+        return ERROR_INT("band not written", procName, 1);
+    bw->nwritten += h;
+
+        /* Finish the encoding */
+    if (bw->nwritten == bw->h) {
+        switch (bw->format)
+        {
+        case IFF_PNG:
+            ret = pngBandWriterClose(bw);
+            break;
+        case IFF_JFIF_JPEG:
+            ret = jpegBandWriterClose(bw);
+            break;
+        default:
+            ret = tiffBandWriterClose(bw);
+            break;
+        }
+        fclose(bw->fp);
+        bw->fp = NULL;
+        if (ret)
+            return ERROR_INT("encoding not finished", procName, 1);
+    }
+    return 0;
+}
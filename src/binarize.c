@@ -47,6 +47,7 @@
  *
  *      Sauvola local thresholding
  *          l_int32    pixSauvolaBinarizeTiled()
+ *          static PIX  *sauvolaBinarizeTile()
  *          l_int32    pixSauvolaBinarize()
  *          PIX       *pixSauvolaGetThreshold()
  *          PIX       *pixApplyLocalThreshold();
@@ -76,6 +77,17 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Input to the tile function in pixSauvolaBinarizeTiled() */
+struct SauvolaTileParams
+{
+    l_int32     whsize;
+    l_float32   factor;
+    l_int32     getthresh;   /* return threshold tiles instead of binary */
+};
+typedef struct SauvolaTileParams  SAUVOLA_TILE_PARAMS;
+
+static PIX *sauvolaBinarizeTile(PIX *pixt, l_int32 i, l_int32 j, void *data);
+
 /*------------------------------------------------------------------*
  *                 Adaptive Otsu-based thresholding                 *
  *------------------------------------------------------------------*/
@@ -453,6 +465,12 @@ PIX      *pixn, *pixm, *pixd, *pixt1, *pixt2, *pixt3, *pixt4;
  *      (4) The Sauvola threshold is determined from the formula:
  *              t = m * (1 - k * (1 - s / 128))
  *          See pixSauvolaBinarize() for details.
+ *      (5) The tiles are processed on the number of threads set by
+ *          l_setParallelThreads().  The result does not depend on
+ *          the number of threads.
+ *      (6) If both outputs are requested, the threshold image is made
+ *          over the tiles and then applied to pixs in one pass.
+ *          This gives the same binary image as thresholding each tile.
  */
 l_int32
 pixSauvolaBinarizeTiled(PIX       *pixs,
@@ -463,10 +481,10 @@ pixSauvolaBinarizeTiled(PIX       *pixs,
                         PIX      **ppixth,
                         PIX      **ppixd)
 {
-l_int32     i, j, w, h, xrat, yrat;
-PIX        *pixth, *pixd, *tileth, *tiled, *pixt;
-PIX       **ptileth, **ptiled;
-PIXTILING  *pt;
+l_int32               w, h, xrat, yrat, ret;
+PIX                  *pixth, *pixd;
+PIXTILING            *pt;
+SAUVOLA_TILE_PARAMS   params;
 
     PROCNAME("pixSauvolaBinarizeTiled");
 
@@ -507,42 +525,71 @@ PIXTILING  *pt;
         return pixSauvolaBinarize(pixs, whsize, factor, 1, NULL, NULL,
                                   ppixth, ppixd);
 
-        /* We can use pixtiling for painting both outputs, if requested */
-    if (ppixth) {
+        /* Paint either the threshold or the binarized tiles */
+    pixth = pixd = NULL;
+    if (ppixth)
         pixth = pixCreateNoInit(w, h, 8);
-        *ppixth = pixth;
-    }
-    if (ppixd) {
+    else
         pixd = pixCreateNoInit(w, h, 1);
-        *ppixd = pixd;
-    }
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, whsize + 1, whsize + 1);
     pixTilingNoStripOnPaint(pt);  /* pixSauvolaBinarize() does the stripping */
+    params.whsize = whsize;
+    params.factor = factor;
+    params.getthresh = (ppixth) ? 1 : 0;
+    ret = pixTilingProcess(pt, (ppixth) ? pixth : pixd, sauvolaBinarizeTile,
+                           &params, 0);
+    pixTilingDestroy(&pt);
+    if (ret) {
+        if (ppixth)
+            pixDestroy(&pixth);
+        else
+            pixDestroy(&pixd);
+        return ERROR_INT("tiles not all binarized", procName, 1);
+    }
 
-    for (i = 0; i < ny; i++) {
-        for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-            ptileth = (ppixth) ? &tileth : NULL;
-            ptiled = (ppixd) ? &tiled : NULL;
-            pixSauvolaBinarize(pixt, whsize, factor, 0, NULL, NULL,
-                               ptileth, ptiled);
-            if (ppixth) {  /* do not strip */
-                pixTilingPaintTile(pixth, i, j, tileth, pt);
-                pixDestroy(&tileth);
-            }
-            if (ppixd) {
-                pixTilingPaintTile(pixd, i, j, tiled, pt);
-                pixDestroy(&tiled);
-            }
-            pixDestroy(&pixt);
+    if (ppixth) {
+        if (ppixd) {
+            pixd = pixApplyLocalThreshold(pixs, pixth, 1);
+            *ppixd = pixd;
         }
+        *ppixth = pixth;
+    } else {
+        *ppixd = pixd;
     }
-
-    pixTilingDestroy(&pt);
     return 0;
 }
 
 
+/*!
+ *  sauvolaBinarizeTile()
+ *
+ *      Input:  pixt (tile, with border of (whsize + 1) pixels)
+ *              i, j (tile row and column; not used)
+ *              data (SAUVOLA_TILE_PARAMS)
+ *      Return: pixd (threshold or binarized tile, without border),
+ *                    or null on error
+ */
+static PIX *
+sauvolaBinarizeTile(PIX     *pixt,
+                    l_int32  i,
+                    l_int32  j,
+                    void    *data)
+{
+PIX                  *pixd;
+SAUVOLA_TILE_PARAMS  *params;
+
+    params = (SAUVOLA_TILE_PARAMS *)data;
+    pixd = NULL;
+    if (params->getthresh)
+        pixSauvolaBinarize(pixt, params->whsize, params->factor, 0,
+                           NULL, NULL, &pixd, NULL);
+    else
+        pixSauvolaBinarize(pixt, params->whsize, params->factor, 0,
+                           NULL, NULL, NULL, &pixd);
+    return pixd;
+}
+
+
 /*!
  *  pixSauvolaBinarize()
  *
@@ -594,6 +641,7 @@ PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
 
     PROCNAME("pixSauvolaBinarize");
 
+    pixm = pixms = pixth = pixd = NULL;
     if (ppixm) *ppixm = NULL;
     if (ppixsd) *ppixsd = NULL;
     if (ppixth) *ppixth = NULL;
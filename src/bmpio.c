@@ -361,6 +361,9 @@ PIXCMAP   *cmap;
  *          truncates any existing data
  *      (2) 2 bpp Bmp files are apparently not valid!.  We can
  *          write and read them, but nobody else can read ours.
+ *      (3) The data in pix is byte swapped in place, and restored
+ *          when done.  A view (see pixCreateView()) must not be
+ *          changed, so a copy of it is written instead.
  */
 l_int32
 pixWriteStreamBmp(FILE  *fp,
@@ -373,7 +376,7 @@ l_uint16    bfOffBits, bfFill2, biPlanes, biBitCount;
 l_uint16    sval;
 l_uint32    biSize, biWidth, biHeight, biCompression, biSizeImage;
 l_uint32    biXPelsPerMeter, biYPelsPerMeter, biClrUsed, biClrImportant;
-l_int32     pixWpl, pixBpl, extrabytes, writeerror;
+l_int32     pixWpl, pixBpl, extrabytes, writeerror, ret;
 l_int32     fileBpl, fileWpl;
 l_int32     i, j, k;
 l_int32     heapcm;  /* extra copy of cta on the heap ? 1 : 0 */
@@ -385,6 +388,7 @@ l_uint8    *cta;          /* address of the bmp color table array */
 l_int32     cmaplen;      /* number of bytes in the bmp colormap */
 l_int32     ncolors, val, stepsize;
 RGBA_QUAD  *pquad;
+PIX        *pixt;
 
     PROCNAME("pixWriteStreamBmp");
 
@@ -393,6 +397,14 @@ RGBA_QUAD  *pquad;
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
 
+    if (pixIsView(pix)) {
+        if ((pixt = pixCopy(NULL, pix)) == NULL)
+            return ERROR_INT("pixt not made", procName, 1);
+        ret = pixWriteStreamBmp(fp, pixt);
+        pixDestroy(&pixt);
+        return ret;
+    }
+
     width  = pixGetWidth(pix);
     height = pixGetHeight(pix);
     d  = pixGetDepth(pix);
@@ -275,8 +275,8 @@ BOX  *box;
     if ((box = *pbox) == NULL)
         return;
 
-    boxChangeRefcount(box, -1);
-    if (boxGetRefcount(box) <= 0)
+        /* Decrement the ref count.  If it is 0, destroy the box. */
+    if (--box->refcount <= 0)
         LEPT_FREE(box);
     *pbox = NULL;
     return;
@@ -540,8 +540,7 @@ BOXA    *boxa;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the boxa. */
-    boxa->refcount--;
-    if (boxa->refcount <= 0) {
+    if (--boxa->refcount <= 0) {
         for (i = 0; i < boxa->n; i++)
             boxDestroy(&boxa->box[i]);
         LEPT_FREE(boxa->box);
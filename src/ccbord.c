@@ -413,8 +413,7 @@ CCBORD  *ccb;
     if ((ccb = *pccb) == NULL)
         return;
 
-    ccb->refcount--;
-    if (ccb->refcount == 0) {
+    if (--ccb->refcount == 0) {
         if (ccb->pix)
             pixDestroy(&ccb->pix);
         if (ccb->boxa)
@@ -55,6 +55,8 @@
  *
  *        which calls
  *          static l_int32    octreeFindColorCell()
+ *          static l_uint32  *octreeMakeCellTable()
+ *          static l_int32    octreeQuantizeStrip()
  *
  *      Helper cqcell functions
  *          static CQCELL  ***cqcellTreeCreate()
@@ -67,6 +69,14 @@
  *          static l_int32    getOctcubeIndices()
  *          static l_int32    octcubeGetCount()
  *
+ *      Octcube indices and histograms of lines, on several threads
+ *          static l_int32   *octcubeHistoParallel()
+ *          static l_int32    octcubeHistoStrip()
+ *          static void       octcubeIndexLine()
+ *          static l_int32    octcubeIndexLineSse2()
+ *          static l_int32    octcubeIndexLineAvx2()
+ *          static l_int32    octcubeIndexLineNeon()
+ *
  *  (2) Adaptive octree quantization based on population at a fixed level
  *          PIX              *pixOctreeQuantByPopulation()
  *          static l_int32    pixDitherOctindexWithCmap()
@@ -109,10 +119,21 @@
  *
  *  Note: leptonica also provides color quantization using a modified
  *        form of median cut.  See colorquant2.c for details.
+ *
+ *  Note: the octcube histograms of pixOctreeColorQuant() and
+ *        pixOctcubeHistogram(), and the undithered pixel assignment of
+ *        pixOctreeColorQuant(), are done on horizontal strips of the
+ *        image, one for each of the threads given by
+ *        l_getParallelThreads().  The histograms of the strips are
+ *        summed, so the results do not depend on the number of threads.
+ *        The octcube indices of each line are found with vector kernels
+ *        (see simd.h).  Error diffusion dithering goes through the
+ *        lines in order, and is done on one thread.
  */
 
 #include <string.h>
 #include "allheaders.h"
+#include "simd.h"
 
 
 /*  This data structure is used for pixOctreeColorQuant(),
@@ -207,11 +228,45 @@ typedef struct L_OctcubePop  L_OCTCUBE_POP;
 static const l_int32  FIXED_DIF_CAP = 0;
 static const l_int32  POP_DIF_CAP = 40;
 
+    /* Smallest strip of lines given to a thread */
+static const l_int32  MinQuantStripHeight = 32;
+
+
+    /* Parameters for making an octcube histogram on each strip of lines */
+struct OctcubeHistoParams
+{
+    PIX         *pixs;        /* 32 bpp rgb                                */
+    l_int32      level;       /* octcube level                             */
+    l_uint32    *rtab;        /* octcube index tables at level             */
+    l_uint32    *gtab;
+    l_uint32    *btab;
+    l_int32      nstrips;     /* number of strips                          */
+    l_int32    **histos;      /* histogram for each strip                  */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct OctcubeHistoParams  OCTCUBE_HISTO_PARAMS;
+
+    /* Parameters for undithered octree quantization of each strip */
+struct OctreeQuantParams
+{
+    PIX         *pixs;        /* 32 bpp rgb                                */
+    PIX         *pixd;        /* 8 bpp result                              */
+    l_uint32    *rtab;        /* octcube index tables at CQ_NLEVELS        */
+    l_uint32    *gtab;
+    l_uint32    *btab;
+    l_uint32    *celltab;     /* cell color and index for each octcube     */
+    l_int32      nstrips;     /* number of strips                          */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct OctreeQuantParams  OCTREE_QUANT_PARAMS;
+
 
     /* Static octree helper function */
 static l_int32 octreeFindColorCell(l_int32 octindex, CQCELL ***cqcaa,
                                    l_int32 *pindex, l_int32 *prval,
                                    l_int32 *pgval, l_int32 *pbval);
+static l_uint32 *octreeMakeCellTable(CQCELL ***cqcaa);
+static l_int32 octreeQuantizeStrip(void *data, l_int32 index);
 
     /* Static cqcell functions */
 static CQCELL ***octreeGenerateAndPrune(PIX *pixs, l_int32 colors,
@@ -229,6 +284,28 @@ static l_int32 getOctcubeIndices(l_int32 rgbindex, l_int32 level,
                                  l_int32 *pbindex, l_int32 *psindex);
 static l_int32 octcubeGetCount(l_int32 level, l_int32 *psize);
 
+    /* Static functions for octcube indices and histograms of lines */
+static l_int32 *octcubeHistoParallel(PIX *pixs, l_int32 level,
+                                     l_uint32 *rtab, l_uint32 *gtab,
+                                     l_uint32 *btab);
+static l_int32 octcubeHistoStrip(void *data, l_int32 index);
+static void octcubeIndexLine(l_uint32 *lines, l_int32 w, l_int32 level,
+                             l_uint32 *rtab, l_uint32 *gtab, l_uint32 *btab,
+                             l_uint32 *indices, l_int32 simd);
+#if L_HAVE_SSE2
+static l_int32 octcubeIndexLineSse2(l_uint32 *lines, l_int32 w,
+                                    l_int32 level, l_uint32 *indices);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 octcubeIndexLineAvx2(l_uint32 *lines, l_int32 w,
+                                    l_int32 level,
+                                    l_uint32 *indices) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 octcubeIndexLineNeon(l_uint32 *lines, l_int32 w,
+                                    l_int32 level, l_uint32 *indices);
+#endif  /* L_HAVE_NEON */
+
     /* Static function to perform octcube-indexed dithering */
 static l_int32 pixDitherOctindexWithCmap(PIX *pixs, PIX *pixd, l_uint32 *rtab,
                                          l_uint32 *gtab, l_uint32 *btab,
@@ -696,8 +773,8 @@ octreeGenerateAndPrune(PIX       *pixs,
                        PIXCMAP  **pcmap)
 {
 l_int32    rval, gval, bval, cindex;
-l_int32    level, ncells, octindex;
-l_int32    w, h, wpls;
+l_int32    level, ncells;
+l_int32    w, h;
 l_int32    i, j, isub;
 l_int32    npix;  /* number of remaining pixels to be assigned */
 l_int32    ncolor; /* number of remaining color cells to be used */
@@ -705,7 +782,7 @@ l_int32    ppc;  /* ave number of pixels left for each color cell */
 l_int32    rv, gv, bv;
 l_float32  thresholdFactor[] = {0.01, 0.01, 1.0, 1.0, 1.0, 1.0};
 l_float32  thresh;  /* factor of ppc for this level */
-l_uint32  *datas, *lines;
+l_int32   *histo;
 l_uint32  *rtab, *gtab, *btab;
 CQCELL  ***cqcaa;   /* one array for each octree level */
 CQCELL   **cqca, **cqcasub;
@@ -740,21 +817,16 @@ NUMA      *nar;  /* accumulates levels for residual cells */
     npix = w * h;  /* initialize to all pixels */
     ncolor = colors - reservedcolors - EXTRA_RESERVED_COLORS;
     ppc = npix / ncolor;
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
 
         /* Accumulate the centers of each cluster at level CQ_NLEVELS */
     ncells = 1 << (3 * CQ_NLEVELS);
     cqca = cqcaa[CQ_NLEVELS];
-    for (i = 0; i < h; i++) {
-        lines = datas + i * wpls;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            octindex = rtab[rval] | gtab[gval] | btab[bval];
-            cqc = cqca[octindex];
-            cqc->n++;
-        }
-    }
+    if ((histo = octcubeHistoParallel(pixs, CQ_NLEVELS, rtab, gtab,
+                                      btab)) == NULL)
+        return (CQCELL ***)ERROR_PTR("histo not made", procName, NULL);
+    for (i = 0; i < ncells; i++)
+        cqca[i]->n = histo[i];
+    LEPT_FREE(histo);
 
         /* Arrays for storing statistics */
     if ((nat = numaCreate(0)) == NULL)
@@ -939,6 +1011,10 @@ l_int32    nt, nr, ival;
  *          integer buffers.  Because the dif is truncated to an
  *          integer, the dither is accurate to 1/8 of a sample increment,
  *          or 1/2048 of the color range.
+ *      (3) The colormap index and color for each octcube at level
+ *          CQ_NLEVELS are first found from the octree, in a table.
+ *          Without dithering, the pixels are then assigned on strips,
+ *          one for each thread; see octreeQuantizeStrip().
  */
 static PIX *
 pixOctreeQuantizePixels(PIX       *pixs,
@@ -949,12 +1025,14 @@ l_uint8   *bufu8r, *bufu8g, *bufu8b;
 l_int32    rval, gval, bval;
 l_int32    octindex, index;
 l_int32    val1, val2, val3, dif;
-l_int32    w, h, wpls, wpld, i, j;
+l_int32    w, h, wpld, i, j, nstrips;
 l_int32    rc, gc, bc;
 l_int32   *buf1r, *buf1g, *buf1b, *buf2r, *buf2g, *buf2b;
-l_uint32  *rtab, *gtab, *btab;
-l_uint32  *datas, *datad, *lines, *lined;
+l_uint32   cellval;
+l_uint32  *rtab, *gtab, *btab, *celltab;
+l_uint32  *datad, *lined;
 PIX       *pixd;
+OCTREE_QUANT_PARAMS  params;
 
     PROCNAME("pixOctreeQuantizePixels");
 
@@ -969,10 +1047,18 @@ PIX       *pixd;
     if (makeRGBToIndexTables(&rtab, &gtab, &btab, CQ_NLEVELS))
         return (PIX *)ERROR_PTR("tables not made", procName, NULL);
 
+        /* Traverse tree from root, looking for lowest cube
+         * that is a leaf, to get the colortable index value
+         * for each octcube. */
+    if ((celltab = octreeMakeCellTable(cqcaa)) == NULL) {
+        LEPT_FREE(rtab);
+        LEPT_FREE(gtab);
+        LEPT_FREE(btab);
+        return (PIX *)ERROR_PTR("celltab not made", procName, NULL);
+    }
+
         /* Make output 8 bpp palette image */
     pixGetDimensions(pixs, &w, &h, NULL);
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
     if ((pixd = pixCreate(w, h, 8)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     pixCopyResolution(pixd, pixs);
@@ -980,22 +1066,22 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
-        /* Traverse tree from root, looking for lowest cube
-         * that is a leaf, and set dest pix to its
-         * colortable index value.  The results are far
-         * better when dithering to get a more accurate
-         * average color.  */
+        /* Set each dest pix to the colortable index value of its
+         * octcube.  The results are far better when dithering to
+         * get a more accurate average color.  */
     if (ditherflag == 0) {    /* no dithering */
-        for (i = 0; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;
-            for (j = 0; j < w; j++) {
-                extractRGBValues(lines[j], &rval, &gval, &bval);
-                octindex = rtab[rval] | gtab[gval] | btab[bval];
-                octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-                SET_DATA_BYTE(lined, j, index);
-            }
-        }
+        nstrips = L_MIN(l_getParallelThreads(), h / MinQuantStripHeight);
+        params.pixs = pixs;
+        params.pixd = pixd;
+        params.rtab = rtab;
+        params.gtab = gtab;
+        params.btab = btab;
+        params.celltab = celltab;
+        params.nstrips = L_MAX(1, nstrips);
+        params.simd = l_getSimdMode();
+        if (l_parallelRun(params.nstrips, params.nstrips,
+                          octreeQuantizeStrip, &params))
+            L_ERROR("strips not quantized\n", procName);
     } else {  /* Dither */
         bufu8r = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
         bufu8g = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
@@ -1039,7 +1125,9 @@ PIX       *pixd;
                 gval = buf1g[j] / 64;
                 bval = buf1b[j] / 64;
                 octindex = rtab[rval] | gtab[gval] | btab[bval];
-                octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
+                cellval = celltab[octindex];
+                index = cellval & 0xff;
+                extractRGBValues(cellval, &rc, &gc, &bc);
                 SET_DATA_BYTE(lined, j, index);
 
                 dif = buf1r[j] / 8 - 8 * rc;
@@ -1096,8 +1184,7 @@ PIX       *pixd;
             gval = buf1g[w - 1] / 64;
             bval = buf1b[w - 1] / 64;
             octindex = rtab[rval] | gtab[gval] | btab[bval];
-            octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-            SET_DATA_BYTE(lined, w - 1, index);
+            SET_DATA_BYTE(lined, w - 1, celltab[octindex] & 0xff);
         }
 
             /* Get last row of pixels; no leftward propagation */
@@ -1107,8 +1194,7 @@ PIX       *pixd;
             gval = buf2g[j] / 64;
             bval = buf2b[j] / 64;
             octindex = rtab[rval] | gtab[gval] | btab[bval];
-            octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-            SET_DATA_BYTE(lined, j, index);
+            SET_DATA_BYTE(lined, j, celltab[octindex] & 0xff);
         }
 
         LEPT_FREE(bufu8r);
@@ -1125,6 +1211,7 @@ PIX       *pixd;
     LEPT_FREE(rtab);
     LEPT_FREE(gtab);
     LEPT_FREE(btab);
+    LEPT_FREE(celltab);
     return pixd;
 }
 
@@ -1209,6 +1296,84 @@ CQCELL  *cqc, *cqcsub;
 }
 
 
+/*!
+ *  octreeMakeCellTable()
+ *
+ *      Input:  cqcaa
+ *      Return: celltab, or null on error
+ *
+ *  Notes:
+ *      (1) For each octcube at level CQ_NLEVELS, the table holds the
+ *          color of its CTE, as an rgb pixel, with the colormap index
+ *          in the low-order byte.  This replaces the tree traversal
+ *          of octreeFindColorCell() for each pixel by a lookup.
+ */
+static l_uint32 *
+octreeMakeCellTable(CQCELL  ***cqcaa)
+{
+l_int32    i, ncells, index, rc, gc, bc;
+l_uint32  *celltab;
+
+    PROCNAME("octreeMakeCellTable");
+
+    ncells = 1 << (3 * CQ_NLEVELS);
+    if ((celltab = (l_uint32 *)LEPT_CALLOC(ncells, sizeof(l_uint32))) == NULL)
+        return (l_uint32 *)ERROR_PTR("celltab not made", procName, NULL);
+    for (i = 0; i < ncells; i++) {
+        octreeFindColorCell(i, cqcaa, &index, &rc, &gc, &bc);
+        composeRGBPixel(rc, gc, bc, &celltab[i]);
+        celltab[i] |= index & 0xff;
+    }
+    return celltab;
+}
+
+
+/*!
+ *  octreeQuantizeStrip()
+ *
+ *      Input:  data (OCTREE_QUANT_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) Sets each pixel in the strip of pixd to the colormap index
+ *          of its octcube, without dithering.
+ */
+static l_int32
+octreeQuantizeStrip(void    *data,
+                    l_int32  index)
+{
+l_int32               w, h, wpls, wpld, i, j, y0, y1;
+l_uint32             *datas, *datad, *lines, *lined, *indices;
+OCTREE_QUANT_PARAMS  *params;
+
+    PROCNAME("octreeQuantizeStrip");
+
+    params = (OCTREE_QUANT_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    datas = pixGetData(params->pixs);
+    datad = pixGetData(params->pixd);
+    wpls = pixGetWpl(params->pixs);
+    wpld = pixGetWpl(params->pixd);
+    if ((indices = (l_uint32 *)LEPT_CALLOC(w, sizeof(l_uint32))) == NULL)
+        return ERROR_INT("indices not made", procName, 1);
+
+    y0 = (h * index) / params->nstrips;
+    y1 = (h * (index + 1)) / params->nstrips;
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        octcubeIndexLine(lines, w, CQ_NLEVELS, params->rtab, params->gtab,
+                         params->btab, indices, params->simd);
+        for (j = 0; j < w; j++)
+            SET_DATA_BYTE(lined, j, params->celltab[indices[j]] & 0xff);
+    }
+
+    LEPT_FREE(indices);
+    return 0;
+}
+
+
 
 /*------------------------------------------------------------------*
  *                      Helper cqcell functions                     *
@@ -1588,6 +1753,289 @@ octcubeGetCount(l_int32   level,
 }
 
 
+
+/*------------------------------------------------------------------*
+ *   Octcube indices and histograms of lines, on several threads    *
+ *------------------------------------------------------------------*/
+/*!
+ *  octcubeHistoParallel()
+ *
+ *      Input:  pixs (32 bpp rgb)
+ *              level (significant bits for each of RGB; valid in [1...6])
+ *              rtab, gtab, btab (generated with makeRGBToIndexTables())
+ *      Return: histo (of the number of pixels in each octcube at @level),
+ *              or null on error
+ *
+ *  Notes:
+ *      (1) The image is divided into strips of lines, one for each
+ *          thread.  A histogram is made for each strip, and they are
+ *          summed.
+ */
+static l_int32 *
+octcubeHistoParallel(PIX       *pixs,
+                     l_int32    level,
+                     l_uint32  *rtab,
+                     l_uint32  *gtab,
+                     l_uint32  *btab)
+{
+l_int32                i, k, h, size, nstrips, ret;
+l_int32               *histo;
+OCTCUBE_HISTO_PARAMS   params;
+
+    PROCNAME("octcubeHistoParallel");
+
+    size = 0;
+    if (octcubeGetCount(level, &size))
+        return (l_int32 *)ERROR_PTR("size not returned", procName, NULL);
+    h = pixGetHeight(pixs);
+    nstrips = L_MIN(l_getParallelThreads(), h / MinQuantStripHeight);
+    nstrips = L_MAX(1, nstrips);
+    params.pixs = pixs;
+    params.level = level;
+    params.rtab = rtab;
+    params.gtab = gtab;
+    params.btab = btab;
+    params.nstrips = nstrips;
+    params.simd = l_getSimdMode();
+    params.histos = (l_int32 **)LEPT_CALLOC(nstrips, sizeof(l_int32 *));
+    if (!params.histos)
+        return (l_int32 *)ERROR_PTR("histos not made", procName, NULL);
+    ret = 0;
+    for (k = 0; k < nstrips; k++) {
+        params.histos[k] = (l_int32 *)LEPT_CALLOC(size, sizeof(l_int32));
+        if (!params.histos[k])
+            ret = 1;
+    }
+    if (!ret)
+        ret = l_parallelRun(nstrips, nstrips, octcubeHistoStrip, &params);
+
+        /* Sum the histograms into the first one */
+    histo = params.histos[0];
+    for (k = 1; k < nstrips; k++) {
+        if (!ret) {
+            for (i = 0; i < size; i++)
+                histo[i] += params.histos[k][i];
+        }
+        LEPT_FREE(params.histos[k]);
+    }
+    LEPT_FREE(params.histos);
+    if (ret) {
+        LEPT_FREE(histo);
+        return (l_int32 *)ERROR_PTR("histo not made", procName, NULL);
+    }
+    return histo;
+}
+
+
+/*!
+ *  octcubeHistoStrip()
+ *
+ *      Input:  data (OCTCUBE_HISTO_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+octcubeHistoStrip(void    *data,
+                  l_int32  index)
+{
+l_int32                w, h, wpl, i, j, y0, y1;
+l_int32               *histo;
+l_uint32              *datas, *lines, *indices;
+OCTCUBE_HISTO_PARAMS  *params;
+
+    PROCNAME("octcubeHistoStrip");
+
+    params = (OCTCUBE_HISTO_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    datas = pixGetData(params->pixs);
+    wpl = pixGetWpl(params->pixs);
+    histo = params->histos[index];
+    if ((indices = (l_uint32 *)LEPT_CALLOC(w, sizeof(l_uint32))) == NULL)
+        return ERROR_INT("indices not made", procName, 1);
+
+    y0 = (h * index) / params->nstrips;
+    y1 = (h * (index + 1)) / params->nstrips;
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * wpl;
+        octcubeIndexLine(lines, w, params->level, params->rtab, params->gtab,
+                         params->btab, indices, params->simd);
+        for (j = 0; j < w; j++)
+            histo[indices[j]]++;
+    }
+
+    LEPT_FREE(indices);
+    return 0;
+}
+
+
+/*!
+ *  octcubeIndexLine()
+ *
+ *      Input:  lines (line of 32 bpp rgb pixels)
+ *              w (number of pixels)
+ *              level (significant bits for each of RGB; valid in [1...6])
+ *              rtab, gtab, btab (generated with makeRGBToIndexTables())
+ *              indices (<return> octcube index at @level of each pixel)
+ *              simd (simd mode)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The vector kernels compute the index directly, by spreading
+ *          the @level significant bits of each component so that there
+ *          are two 0 bits between each bit, and then interleaving the
+ *          three components, with red as the most significant.  This
+ *          is the same index that is looked up in the tables; see
+ *          makeRGBToIndexTables().
+ */
+static void
+octcubeIndexLine(l_uint32  *lines,
+                 l_int32    w,
+                 l_int32    level,
+                 l_uint32  *rtab,
+                 l_uint32  *gtab,
+                 l_uint32  *btab,
+                 l_uint32  *indices,
+                 l_int32    simd)
+{
+l_int32  j, jstart, rval, gval, bval;
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = octcubeIndexLineAvx2(lines, w, level, indices);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        jstart = octcubeIndexLineSse2(lines, w, level, indices);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        jstart = octcubeIndexLineNeon(lines, w, level, indices);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        extractRGBValues(lines[j], &rval, &gval, &bval);
+        indices[j] = rtab[rval] | gtab[gval] | btab[bval];
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of pixels
+     * it has done; the rest are done by the caller.  The component
+     * with index k (0 for red) has its significant bits at the low
+     * end of c[k], and they are spread with three shift and mask
+     * steps:  bits 0-3 and 4-5 are separated by 8, then bits 0-1 and
+     * 2-3 of each group by 4, and finally each pair by 2. */
+#if L_HAVE_SSE2
+static l_int32
+octcubeIndexLineSse2(l_uint32  *lines,
+                     l_int32    w,
+                     l_int32    level,
+                     l_uint32  *indices)
+{
+l_int32  j, k;
+__m128i  p, mask, x, index;
+__m128i  c[3];
+
+    mask = _mm_set1_epi32((1 << level) - 1);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = _mm_loadu_si128((const __m128i *)(lines + j));
+        index = _mm_setzero_si128();
+        for (k = 0; k < 3; k++) {
+            c[k] = _mm_and_si128(_mm_srl_epi32(p,
+                                 _mm_cvtsi32_si128(32 - 8 * k - level)), mask);
+            x = _mm_and_si128(_mm_or_si128(c[k], _mm_slli_epi32(c[k], 8)),
+                              _mm_set1_epi32(0x0000f00f));
+            x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 4)),
+                              _mm_set1_epi32(0x000c30c3));
+            x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 2)),
+                              _mm_set1_epi32(0x00249249));
+            index = _mm_or_si128(index,
+                                 _mm_sll_epi32(x, _mm_cvtsi32_si128(2 - k)));
+        }
+        _mm_storeu_si128((__m128i *)(indices + j), index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+static l_int32
+octcubeIndexLineAvx2(l_uint32  *lines,
+                     l_int32    w,
+                     l_int32    level,
+                     l_uint32  *indices)
+{
+l_int32  j, k;
+__m256i  p, mask, x, index;
+__m256i  c[3];
+
+    mask = _mm256_set1_epi32((1 << level) - 1);
+    for (j = 0; j + 8 <= w; j += 8) {
+        p = _mm256_loadu_si256((const __m256i *)(lines + j));
+        index = _mm256_setzero_si256();
+        for (k = 0; k < 3; k++) {
+            c[k] = _mm256_and_si256(_mm256_srl_epi32(p,
+                           _mm_cvtsi32_si128(32 - 8 * k - level)), mask);
+            x = _mm256_and_si256(
+                    _mm256_or_si256(c[k], _mm256_slli_epi32(c[k], 8)),
+                    _mm256_set1_epi32(0x0000f00f));
+            x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 4)),
+                                 _mm256_set1_epi32(0x000c30c3));
+            x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 2)),
+                                 _mm256_set1_epi32(0x00249249));
+            index = _mm256_or_si256(index, _mm256_sllv_epi32(x,
+                                    _mm256_set1_epi32(2 - k)));
+        }
+        _mm256_storeu_si256((__m256i *)(indices + j), index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+static l_int32
+octcubeIndexLineNeon(l_uint32  *lines,
+                     l_int32    w,
+                     l_int32    level,
+                     l_uint32  *indices)
+{
+l_int32     j, k;
+uint32x4_t  p, mask, x, index;
+uint32x4_t  c[3];
+
+    mask = vdupq_n_u32((1 << level) - 1);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = vld1q_u32(lines + j);
+        index = vdupq_n_u32(0);
+        for (k = 0; k < 3; k++) {
+            c[k] = vandq_u32(vshlq_u32(p, vdupq_n_s32(8 * k + level - 32)),
+                             mask);
+            x = vandq_u32(vorrq_u32(c[k], vshlq_n_u32(c[k], 8)),
+                          vdupq_n_u32(0x0000f00f));
+            x = vandq_u32(vorrq_u32(x, vshlq_n_u32(x, 4)),
+                          vdupq_n_u32(0x000c30c3));
+            x = vandq_u32(vorrq_u32(x, vshlq_n_u32(x, 2)),
+                          vdupq_n_u32(0x00249249));
+            index = vorrq_u32(index, vshlq_u32(x, vdupq_n_s32(2 - k)));
+        }
+        vst1q_u32(indices + j, index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_NEON */
+
+
 /*---------------------------------------------------------------------------*
  *      Adaptive octree quantization based on population at a fixed level    *
  *---------------------------------------------------------------------------*/
@@ -3629,11 +4077,9 @@ pixOctcubeHistogram(PIX      *pixs,
                     l_int32   level,
                     l_int32  *pncolors)
 {
-l_int32     size, i, j, w, h, wpl, ncolors, val;
-l_int32     rval, gval, bval;
-l_uint32    octindex;
+l_int32     size, i, ncolors;
+l_int32    *histo;
 l_uint32   *rtab, *gtab, *btab;
-l_uint32   *data, *line;
 l_float32  *array;
 NUMA       *na;
 
@@ -3645,53 +4091,32 @@ NUMA       *na;
     if (pixGetDepth(pixs) != 32)
         return (NUMA *)ERROR_PTR("pixs not 32 bpp", procName, NULL);
 
-    pixGetDimensions(pixs, &w, &h, NULL);
-    wpl = pixGetWpl(pixs);
-    data = pixGetData(pixs);
-
     if (octcubeGetCount(level, &size))  /* array size = 2 ** (3 * level) */
         return (NUMA *)ERROR_PTR("size not returned", procName, NULL);
     if (makeRGBToIndexTables(&rtab, &gtab, &btab, level))
         return (NUMA *)ERROR_PTR("tables not made", procName, NULL);
+    histo = octcubeHistoParallel(pixs, level, rtab, gtab, btab);
+    LEPT_FREE(rtab);
+    LEPT_FREE(gtab);
+    LEPT_FREE(btab);
+    if (!histo)
+        return (NUMA *)ERROR_PTR("histo not made", procName, NULL);
 
-    if ((na = numaCreate(size)) == NULL)
+    if ((na = numaCreate(size)) == NULL) {
+        LEPT_FREE(histo);
         return (NUMA *)ERROR_PTR("na not made", procName, NULL);
+    }
     numaSetCount(na, size);
     array = numaGetFArray(na, L_NOCOPY);
-
-    for (i = 0; i < h; i++) {
-        line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(line[j], &rval, &gval, &bval);
-            octindex = rtab[rval] | gtab[gval] | btab[bval];
-#if DEBUG_OCTINDEX
-            if ((level == 1 && octindex > 7) ||
-                (level == 2 && octindex > 63) ||
-                (level == 3 && octindex > 511) ||
-                (level == 4 && octindex > 4097) ||
-                (level == 5 && octindex > 32783) ||
-                (level == 6 && octindex > 262271)) {
-                fprintf(stderr, "level = %d, octindex = %d, index error!\n",
-                        level, octindex);
-                continue;
-            }
-#endif  /* DEBUG_OCTINDEX */
-              array[octindex] += 1.0;
-        }
+    for (i = 0, ncolors = 0; i < size; i++) {
+        array[i] = histo[i];
+        if (histo[i] > 0)
+            ncolors++;
     }
-
-    if (pncolors) {
-        for (i = 0, ncolors = 0; i < size; i++) {
-            numaGetIValue(na, i, &val);
-            if (val > 0)
-                ncolors++;
-        }
+    if (pncolors)
         *pncolors = ncolors;
-    }
 
-    LEPT_FREE(rtab);
-    LEPT_FREE(gtab);
-    LEPT_FREE(btab);
+    LEPT_FREE(histo);
     return na;
 }
 
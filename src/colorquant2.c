@@ -41,7 +41,13 @@
  *      Static helpers
  *          static PIXCMAP   *pixcmapGenerateFromHisto()
  *          static PIX       *pixQuantizeWithColormap()
+ *          static l_int32    quantizeWithColormapStrip()
  *          static void       getColorIndexMedianCut()
+ *          static l_int32    medianCutHistoStrip()
+ *          static void       medianCutIndexLine()
+ *          static l_int32    medianCutIndexLineSse2()
+ *          static l_int32    medianCutIndexLineAvx2()
+ *          static l_int32    medianCutIndexLineNeon()
  *          static L_BOX3D   *pixGetColorRegion()
  *          static l_int32    medianCutApply()
  *          static PIXCMAP   *pixcmapGenerateFromMedianCuts()
@@ -164,11 +170,19 @@
  *     (2) For rendering majority color regions, MMCQ does a better
  *         job of avoiding posterization.  That is, it does better
  *         dividing the color space up in the most heavily populated regions.
+ *
+ *   The histogram, and the assignment of pixels to the colormap
+ *   without dithering, are done on horizontal strips of the image,
+ *   one for each of the threads given by l_getParallelThreads().
+ *   The rgb index of each pixel in a line is found with vector
+ *   kernels (see simd.h).  Dithering goes through the lines in order,
+ *   on one thread.
  */
 
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#include "simd.h"
 
     /* Median cut 3-d volume element.  Sort on first element, which
      * can be the number of pixels, the volume or a combination
@@ -187,6 +201,30 @@ struct L_Box3d
 };
 typedef struct L_Box3d  L_BOX3D;
 
+    /* Parameters for the median cut histogram of each strip of lines */
+struct MedianCutHistoParams
+{
+    PIX         *pixs;        /* 32 bpp rgb                                */
+    l_int32      sigbits;     /* significant bits of each component        */
+    l_int32      subsample;   /* sampling factor in each direction         */
+    l_int32      nstrips;     /* number of strips                          */
+    l_int32    **histos;      /* histogram for each strip                  */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct MedianCutHistoParams  MEDIAN_CUT_HISTO_PARAMS;
+
+    /* Parameters for undithered quantization of each strip of lines */
+struct QuantizeCmapParams
+{
+    PIX         *pixs;        /* 32 bpp rgb                                */
+    PIX         *pixd;        /* result, with depth 1, 2, 4 or 8           */
+    l_int32     *indexmap;    /* colormap index for each rgb index         */
+    l_int32      sigbits;     /* significant bits of each component        */
+    l_int32      nstrips;     /* number of strips                          */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct QuantizeCmapParams  QUANTIZE_CMAP_PARAMS;
+
     /* Static median cut helper functions */
 static PIXCMAP *pixcmapGenerateFromHisto(PIX *pixs, l_int32 depth,
                                          l_int32 *histo, l_int32 histosize,
@@ -195,9 +233,26 @@ static PIX *pixQuantizeWithColormap(PIX *pixs, l_int32 ditherflag,
                                     l_int32 outdepth,
                                     PIXCMAP *cmap, l_int32 *indexmap,
                                     l_int32 mapsize, l_int32 sigbits);
+static l_int32 quantizeWithColormapStrip(void *data, l_int32 index);
 static void getColorIndexMedianCut(l_uint32 pixel, l_int32 rshift,
                                    l_uint32 mask, l_int32 sigbits,
                                    l_int32 *pindex);
+static l_int32 medianCutHistoStrip(void *data, l_int32 index);
+static void medianCutIndexLine(l_uint32 *lines, l_int32 w, l_int32 sigbits,
+                               l_int32 *indices, l_int32 simd);
+#if L_HAVE_SSE2
+static l_int32 medianCutIndexLineSse2(l_uint32 *lines, l_int32 w,
+                                      l_int32 sigbits, l_int32 *indices);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 medianCutIndexLineAvx2(l_uint32 *lines, l_int32 w,
+                                      l_int32 sigbits,
+                                      l_int32 *indices) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 medianCutIndexLineNeon(l_uint32 *lines, l_int32 w,
+                                      l_int32 sigbits, l_int32 *indices);
+#endif  /* L_HAVE_NEON */
 static L_BOX3D *pixGetColorRegion(PIX *pixs, l_int32 sigbits,
                                   l_int32 subsample);
 static l_int32 medianCutApply(l_int32 *histo, l_int32 sigbits,
@@ -228,6 +283,9 @@ static const l_float32  FRACT_BY_POPULATION = 0.85;
      * divide DIF_CAP by 8. */
 static const l_int32  DIF_CAP = 100;
 
+    /* Smallest strip of lines given to a thread */
+static const l_int32  MinQuantStripHeight = 32;
+
 
 #ifndef   NO_CONSOLE_IO
 #define   DEBUG_MC_COLORS       0
@@ -810,16 +868,17 @@ PIX     *pixg, *pixd;
  *          is 2^(3 * sigbits).
  *      (2) Indexing into the array from rgb uses red sigbits as
  *          most significant and blue as least.
+ *      (3) A histogram is made for each strip of the sampled lines,
+ *          on separate threads, and they are summed.
  */
 l_int32 *
 pixMedianCutHisto(PIX     *pixs,
                   l_int32  sigbits,
                   l_int32  subsample)
 {
-l_int32    i, j, w, h, wpl, rshift, index, histosize;
-l_int32   *histo;
-l_uint32   mask, pixel;
-l_uint32  *data, *line;
+l_int32                   i, k, h, histosize, nstrips, ret;
+l_int32                  *histo;
+MEDIAN_CUT_HISTO_PARAMS   params;
 
     PROCNAME("pixMedianCutHisto");
 
@@ -833,23 +892,40 @@ l_uint32  *data, *line;
         return (l_int32 *)ERROR_PTR("subsample not > 0", procName, NULL);
 
     histosize = 1 << (3 * sigbits);
-    if ((histo = (l_int32 *)LEPT_CALLOC(histosize, sizeof(l_int32))) == NULL)
-        return (l_int32 *)ERROR_PTR("histo not made", procName, NULL);
-
-    rshift = 8 - sigbits;
-    mask = 0xff >> rshift;
-    pixGetDimensions(pixs, &w, &h, NULL);
-    data = pixGetData(pixs);
-    wpl = pixGetWpl(pixs);
-    for (i = 0; i < h; i += subsample) {
-        line = data + i * wpl;
-        for (j = 0; j < w; j += subsample) {
-            pixel = line[j];
-            getColorIndexMedianCut(pixel, rshift, mask, sigbits, &index);
-            histo[index]++;
+    h = (pixGetHeight(pixs) + subsample - 1) / subsample;  /* sampled */
+    nstrips = L_MIN(l_getParallelThreads(), h / MinQuantStripHeight);
+    nstrips = L_MAX(1, nstrips);
+    params.pixs = pixs;
+    params.sigbits = sigbits;
+    params.subsample = subsample;
+    params.nstrips = nstrips;
+    params.simd = l_getSimdMode();
+    params.histos = (l_int32 **)LEPT_CALLOC(nstrips, sizeof(l_int32 *));
+    if (!params.histos)
+        return (l_int32 *)ERROR_PTR("histos not made", procName, NULL);
+    ret = 0;
+    for (k = 0; k < nstrips; k++) {
+        params.histos[k] = (l_int32 *)LEPT_CALLOC(histosize, sizeof(l_int32));
+        if (!params.histos[k])
+            ret = 1;
+    }
+    if (!ret)
+        ret = l_parallelRun(nstrips, nstrips, medianCutHistoStrip, &params);
+
+        /* Sum the histograms into the first one */
+    histo = params.histos[0];
+    for (k = 1; k < nstrips; k++) {
+        if (!ret) {
+            for (i = 0; i < histosize; i++)
+                histo[i] += params.histos[k][i];
         }
+        LEPT_FREE(params.histos[k]);
+    }
+    LEPT_FREE(params.histos);
+    if (ret) {
+        LEPT_FREE(histo);
+        return (l_int32 *)ERROR_PTR("histo not made", procName, NULL);
     }
-
     return histo;
 }
 
@@ -929,6 +1005,8 @@ PIXCMAP  *cmap;
  *          pixel and returns the index into the colormap.
  *      (2) If ditherflag is 1, @outdepth is ignored and the output
  *          depth is set to 8.
+ *      (3) Without dithering, the pixels are assigned on strips, one
+ *          for each thread; see quantizeWithColormapStrip().
  */
 static PIX *
 pixQuantizeWithColormap(PIX      *pixs,
@@ -940,13 +1018,14 @@ pixQuantizeWithColormap(PIX      *pixs,
                         l_int32   sigbits)
 {
 l_uint8   *bufu8r, *bufu8g, *bufu8b;
-l_int32    i, j, w, h, wpls, wpld, rshift, index, cmapindex;
+l_int32    i, j, w, h, wpld, rshift, index, cmapindex, nstrips;
 l_int32    rval, gval, bval, rc, gc, bc;
 l_int32    dif, val1, val2, val3;
 l_int32   *buf1r, *buf1g, *buf1b, *buf2r, *buf2g, *buf2b;
-l_uint32  *datas, *datad, *lines, *lined;
-l_uint32   mask, pixel;
+l_int32   *rmap, *gmap, *bmap;
+l_uint32  *datad, *lined;
 PIX       *pixd;
+QUANTIZE_CMAP_PARAMS  params;
 
     PROCNAME("pixQuantizeWithColormap");
 
@@ -964,48 +1043,21 @@ PIX       *pixd;
     pixSetColormap(pixd, cmap);
     pixCopyResolution(pixd, pixs);
     pixCopyInputFormat(pixd, pixs);
-    datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
     rshift = 8 - sigbits;
-    mask = 0xff >> rshift;
     if (ditherflag == 0) {
-        for (i = 0; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;
-            if (outdepth == 1) {
-                for (j = 0; j < w; j++) {
-                    pixel = lines[j];
-                    getColorIndexMedianCut(pixel, rshift, mask,
-                                           sigbits, &index);
-                    if (indexmap[index])
-                        SET_DATA_BIT(lined, j);
-                }
-            } else if (outdepth == 2) {
-                for (j = 0; j < w; j++) {
-                    pixel = lines[j];
-                    getColorIndexMedianCut(pixel, rshift, mask,
-                                           sigbits, &index);
-                    SET_DATA_DIBIT(lined, j, indexmap[index]);
-                }
-            } else if (outdepth == 4) {
-                for (j = 0; j < w; j++) {
-                    pixel = lines[j];
-                    getColorIndexMedianCut(pixel, rshift, mask,
-                                           sigbits, &index);
-                    SET_DATA_QBIT(lined, j, indexmap[index]);
-                }
-            } else {  /* outdepth == 8 */
-                for (j = 0; j < w; j++) {
-                    pixel = lines[j];
-                    getColorIndexMedianCut(pixel, rshift, mask,
-                                           sigbits, &index);
-                    SET_DATA_BYTE(lined, j, indexmap[index]);
-                }
-            }
-        }
+        nstrips = L_MIN(l_getParallelThreads(), h / MinQuantStripHeight);
+        params.pixs = pixs;
+        params.pixd = pixd;
+        params.indexmap = indexmap;
+        params.sigbits = sigbits;
+        params.nstrips = L_MAX(1, nstrips);
+        params.simd = l_getSimdMode();
+        if (l_parallelRun(params.nstrips, params.nstrips,
+                          quantizeWithColormapStrip, &params))
+            L_ERROR("strips not quantized\n", procName);
     } else {  /* ditherflag == 1 */
         bufu8r = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
         bufu8g = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
@@ -1020,6 +1072,8 @@ PIX       *pixd;
             return (PIX *)ERROR_PTR("uint8 line buf not made", procName, NULL);
         if (!buf1r || !buf1g || !buf1b || !buf2r || !buf2g || !buf2b)
             return (PIX *)ERROR_PTR("mono line buf not made", procName, NULL);
+        if (pixcmapToArrays(cmap, &rmap, &gmap, &bmap, NULL))
+            return (PIX *)ERROR_PTR("cmap arrays not made", procName, NULL);
 
             /* Start by priming buf2; line 1 is above line 2 */
         pixGetRGBLine(pixs, 0, bufu8r, bufu8g, bufu8b);
@@ -1051,7 +1105,9 @@ PIX       *pixd;
                         ((gval >> rshift) << sigbits) + (bval >> rshift);
                 cmapindex = indexmap[index];
                 SET_DATA_BYTE(lined, j, cmapindex);
-                pixcmapGetColor(cmap, cmapindex, &rc, &gc, &bc);
+                rc = rmap[cmapindex];
+                gc = gmap[cmapindex];
+                bc = bmap[cmapindex];
 
                 dif = buf1r[j] / 8 - 8 * rc;
                 if (dif > DIF_CAP) dif = DIF_CAP;
@@ -1137,12 +1193,76 @@ PIX       *pixd;
         LEPT_FREE(buf2r);
         LEPT_FREE(buf2g);
         LEPT_FREE(buf2b);
+        LEPT_FREE(rmap);
+        LEPT_FREE(gmap);
+        LEPT_FREE(bmap);
     }
 
     return pixd;
 }
 
 
+/*!
+ *  quantizeWithColormapStrip()
+ *
+ *      Input:  data (QUANTIZE_CMAP_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) Sets each pixel in the strip of pixd to the colormap index
+ *          of its rgb index, without dithering.
+ */
+static l_int32
+quantizeWithColormapStrip(void    *data,
+                          l_int32  index)
+{
+l_int32                i, j, w, h, wpls, wpld, y0, y1, outdepth;
+l_int32               *indexmap, *indices;
+l_uint32              *datas, *datad, *lines, *lined;
+QUANTIZE_CMAP_PARAMS  *params;
+
+    PROCNAME("quantizeWithColormapStrip");
+
+    params = (QUANTIZE_CMAP_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    datas = pixGetData(params->pixs);
+    datad = pixGetData(params->pixd);
+    wpls = pixGetWpl(params->pixs);
+    wpld = pixGetWpl(params->pixd);
+    outdepth = pixGetDepth(params->pixd);
+    indexmap = params->indexmap;
+    if ((indices = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32))) == NULL)
+        return ERROR_INT("indices not made", procName, 1);
+
+    y0 = (h * index) / params->nstrips;
+    y1 = (h * (index + 1)) / params->nstrips;
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        medianCutIndexLine(lines, w, params->sigbits, indices, params->simd);
+        if (outdepth == 1) {
+            for (j = 0; j < w; j++) {
+                if (indexmap[indices[j]])
+                    SET_DATA_BIT(lined, j);
+            }
+        } else if (outdepth == 2) {
+            for (j = 0; j < w; j++)
+                SET_DATA_DIBIT(lined, j, indexmap[indices[j]]);
+        } else if (outdepth == 4) {
+            for (j = 0; j < w; j++)
+                SET_DATA_QBIT(lined, j, indexmap[indices[j]]);
+        } else {  /* outdepth == 8 */
+            for (j = 0; j < w; j++)
+                SET_DATA_BYTE(lined, j, indexmap[indices[j]]);
+        }
+    }
+
+    LEPT_FREE(indices);
+    return 0;
+}
+
+
 /*!
  *  getColorIndexMedianCut()
  *
@@ -1174,6 +1294,212 @@ l_int32  rval, gval, bval;
 }
 
 
+/*!
+ *  medianCutHistoStrip()
+ *
+ *      Input:  data (MEDIAN_CUT_HISTO_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The strips divide the sampled lines.  Without subsampling,
+ *          the rgb indices of each line are found together.
+ */
+static l_int32
+medianCutHistoStrip(void    *data,
+                    l_int32  index)
+{
+l_int32                   i, j, w, h, wpl, y0, y1, nlines;
+l_int32                   sigbits, subsample, rshift, rgbindex;
+l_int32                  *histo, *indices;
+l_uint32                  mask;
+l_uint32                 *datas, *lines;
+MEDIAN_CUT_HISTO_PARAMS  *params;
+
+    PROCNAME("medianCutHistoStrip");
+
+    params = (MEDIAN_CUT_HISTO_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    datas = pixGetData(params->pixs);
+    wpl = pixGetWpl(params->pixs);
+    sigbits = params->sigbits;
+    subsample = params->subsample;
+    histo = params->histos[index];
+    rshift = 8 - sigbits;
+    mask = 0xff >> rshift;
+    if ((indices = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32))) == NULL)
+        return ERROR_INT("indices not made", procName, 1);
+
+    nlines = (h + subsample - 1) / subsample;
+    y0 = (nlines * index) / params->nstrips;
+    y1 = (nlines * (index + 1)) / params->nstrips;
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * subsample * wpl;
+        if (subsample == 1) {
+            medianCutIndexLine(lines, w, sigbits, indices, params->simd);
+            for (j = 0; j < w; j++)
+                histo[indices[j]]++;
+        } else {
+            for (j = 0; j < w; j += subsample) {
+                getColorIndexMedianCut(lines[j], rshift, mask, sigbits,
+                                       &rgbindex);
+                histo[rgbindex]++;
+            }
+        }
+    }
+
+    LEPT_FREE(indices);
+    return 0;
+}
+
+
+/*!
+ *  medianCutIndexLine()
+ *
+ *      Input:  lines (line of 32 bpp rgb pixels)
+ *              w (number of pixels)
+ *              sigbits (significant bits of each component)
+ *              indices (<return> rgb index of each pixel)
+ *              simd (simd mode)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The rgb index is the one from getColorIndexMedianCut().
+ */
+static void
+medianCutIndexLine(l_uint32  *lines,
+                   l_int32    w,
+                   l_int32    sigbits,
+                   l_int32   *indices,
+                   l_int32    simd)
+{
+l_int32   j, jstart, rshift;
+l_uint32  mask;
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = medianCutIndexLineAvx2(lines, w, sigbits, indices);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        jstart = medianCutIndexLineSse2(lines, w, sigbits, indices);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        jstart = medianCutIndexLineNeon(lines, w, sigbits, indices);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+    rshift = 8 - sigbits;
+    mask = 0xff >> rshift;
+    for (j = jstart; j < w; j++)
+        getColorIndexMedianCut(lines[j], rshift, mask, sigbits, &indices[j]);
+}
+
+
+    /* Each of the vector kernels below returns the number of pixels
+     * it has done; the rest are done by the caller.  Each component
+     * is shifted directly to its place in the index and masked. */
+#if L_HAVE_SSE2
+static l_int32
+medianCutIndexLineSse2(l_uint32  *lines,
+                       l_int32    w,
+                       l_int32    sigbits,
+                       l_int32   *indices)
+{
+l_int32  j, rshift;
+__m128i  p, index, rmask, gmask, bmask, rsh, gsh, bsh;
+
+    rshift = 8 - sigbits;
+    bmask = _mm_set1_epi32((1 << sigbits) - 1);
+    gmask = _mm_slli_epi32(bmask, sigbits);
+    rmask = _mm_slli_epi32(gmask, sigbits);
+    rsh = _mm_cvtsi32_si128(24 + rshift - 2 * sigbits);
+    gsh = _mm_cvtsi32_si128(16 + rshift - sigbits);
+    bsh = _mm_cvtsi32_si128(8 + rshift);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = _mm_loadu_si128((const __m128i *)(lines + j));
+        index = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(p, rsh), rmask),
+                             _mm_and_si128(_mm_srl_epi32(p, gsh), gmask));
+        index = _mm_or_si128(index,
+                             _mm_and_si128(_mm_srl_epi32(p, bsh), bmask));
+        _mm_storeu_si128((__m128i *)(indices + j), index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+static l_int32
+medianCutIndexLineAvx2(l_uint32  *lines,
+                       l_int32    w,
+                       l_int32    sigbits,
+                       l_int32   *indices)
+{
+l_int32  j, rshift;
+__m128i  rsh, gsh, bsh;
+__m256i  p, index, rmask, gmask, bmask;
+
+    rshift = 8 - sigbits;
+    bmask = _mm256_set1_epi32((1 << sigbits) - 1);
+    gmask = _mm256_set1_epi32(((1 << sigbits) - 1) << sigbits);
+    rmask = _mm256_set1_epi32(((1 << sigbits) - 1) << (2 * sigbits));
+    rsh = _mm_cvtsi32_si128(24 + rshift - 2 * sigbits);
+    gsh = _mm_cvtsi32_si128(16 + rshift - sigbits);
+    bsh = _mm_cvtsi32_si128(8 + rshift);
+    for (j = 0; j + 8 <= w; j += 8) {
+        p = _mm256_loadu_si256((const __m256i *)(lines + j));
+        index = _mm256_or_si256(
+                    _mm256_and_si256(_mm256_srl_epi32(p, rsh), rmask),
+                    _mm256_and_si256(_mm256_srl_epi32(p, gsh), gmask));
+        index = _mm256_or_si256(index,
+                    _mm256_and_si256(_mm256_srl_epi32(p, bsh), bmask));
+        _mm256_storeu_si256((__m256i *)(indices + j), index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+static l_int32
+medianCutIndexLineNeon(l_uint32  *lines,
+                       l_int32    w,
+                       l_int32    sigbits,
+                       l_int32   *indices)
+{
+l_int32     j, rshift;
+int32x4_t   rsh, gsh, bsh;
+uint32x4_t  p, index, rmask, gmask, bmask;
+
+    rshift = 8 - sigbits;
+    bmask = vdupq_n_u32((1 << sigbits) - 1);
+    gmask = vdupq_n_u32(((1 << sigbits) - 1) << sigbits);
+    rmask = vdupq_n_u32(((1 << sigbits) - 1) << (2 * sigbits));
+    rsh = vdupq_n_s32(2 * sigbits - 24 - rshift);  /* negative: right */
+    gsh = vdupq_n_s32(sigbits - 16 - rshift);
+    bsh = vdupq_n_s32(-8 - rshift);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = vld1q_u32(lines + j);
+        index = vorrq_u32(vandq_u32(vshlq_u32(p, rsh), rmask),
+                          vandq_u32(vshlq_u32(p, gsh), gmask));
+        index = vorrq_u32(index, vandq_u32(vshlq_u32(p, bsh), bmask));
+        vst1q_u32((l_uint32 *)(indices + j), index);
+    }
+    return j;
+}
+#endif  /* L_HAVE_NEON */
+
+
 /*!
  *  pixGetColorRegion()
  *
@@ -75,11 +75,29 @@
  *           PIX        *fpixaConvertLABToRGB()
  *           l_int32     convertRGBToLAB()
  *           l_int32     convertLABToRGB()
+ *
+ *      Forward conversion from RGB on bands of lines
+ *           static l_int32  convertRGBBands()
+ *           static l_int32  convertRGBBand()
+ *           static void     rgbToHSVLine()
+ *           static void     rgbToYUVLine()
+ *           static void     rgbToXYZLine()
+ *           static l_int32  rgbToHSVLineSse2()
+ *           static l_int32  rgbToYUVLineSse2()
+ *           static l_int32  rgbToXYZLineSse2()
+ *           static l_int32  rgbToXYZLineAvx2()
+ *
+ *      The forward conversions from 32 bpp RGB to HSV, YUV, XYZ and LAB
+ *      are done on bands of lines in parallel, and use vector kernels
+ *      for most of each line.  The kernels give exactly the same
+ *      results as the per-pixel functions convertRGBTo*(), which do
+ *      the rest of each line.
  */
 
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#include "simd.h"
 
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_HISTO       0
@@ -90,6 +108,59 @@
 static l_float32 lab_forward(l_float32 v);
 static l_float32 lab_reverse(l_float32 v);
 
+    /* Smallest band of lines given to a thread */
+static const l_int32  MinColorBandHeight = 32;
+
+    /* Forward conversions from rgb that are done on bands of lines */
+enum {
+    L_BAND_TO_HSV = 0,        /* in place, to hsv pixels                */
+    L_BAND_TO_YUV = 1,        /* in place, to yuv pixels                */
+    L_BAND_TO_XYZ = 2,        /* to three fpix                          */
+    L_BAND_TO_LAB = 3         /* to three fpix                          */
+};
+
+    /* Parameters for converting each band of lines from rgb */
+struct ColorBandParams
+{
+    l_int32      type;        /* L_BAND_TO_HSV, ...                        */
+    l_uint32    *datas;       /* 32 bpp rgb; converted in place to hsv, yuv */
+    l_int32      w;
+    l_int32      h;
+    l_int32      wpls;
+    l_float32   *datad[3];    /* fpix data, for xyz and lab                */
+    l_int32      wpld;
+    l_int32      nbands;      /* number of bands                           */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct ColorBandParams  COLOR_BAND_PARAMS;
+
+    /* Static functions for forward conversion of bands and lines */
+static l_int32 convertRGBBands(l_int32 type, l_uint32 *datas, l_int32 w,
+                               l_int32 h, l_int32 wpls, FPIXA *fpixa);
+static l_int32 convertRGBBand(void *data, l_int32 index);
+static void rgbToHSVLine(l_uint32 *line, l_int32 w, l_int32 simd);
+static void rgbToYUVLine(l_uint32 *line, l_int32 w, l_int32 simd);
+static void rgbToXYZLine(l_uint32 *lines, l_int32 w, l_float32 *line0,
+                         l_float32 *line1, l_float32 *line2, l_int32 tolab,
+                         l_int32 simd);
+#if L_HAVE_SSE2
+static l_int32 rgbToHSVLineSse2(l_uint32 *line, l_int32 w);
+static l_int32 rgbToYUVLineSse2(l_uint32 *line, l_int32 w);
+static l_int32 rgbToXYZLineSse2(l_uint32 *lines, l_int32 w,
+                                l_float32 *line0, l_float32 *line1,
+                                l_float32 *line2, l_int32 tolab);
+static __m128 mulDoubleSse2(__m128 v, l_float64 c);
+static __m128 labForwardSse2(__m128 v);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 rgbToXYZLineAvx2(l_uint32 *lines, l_int32 w,
+                                l_float32 *line0, l_float32 *line1,
+                                l_float32 *line2,
+                                l_int32 tolab) L_TARGET_AVX2;
+static __m256 mulDoubleAvx2(__m256 v, l_float64 c) L_TARGET_AVX2;
+static __m256 labForwardAvx2(__m256 v) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+
 
 /*---------------------------------------------------------------------------*
  *                  Colorspace conversion between RGB and HSB                *
@@ -130,9 +201,8 @@ PIX *
 pixConvertRGBToHSV(PIX  *pixd,
                    PIX  *pixs)
 {
-l_int32    w, h, d, wpl, i, j, rval, gval, bval, hval, sval, vval;
-l_uint32  *line, *data;
-PIXCMAP   *cmap;
+l_int32   w, h, d;
+PIXCMAP  *cmap;
 
     PROCNAME("pixConvertRGBToHSV");
 
@@ -157,17 +227,8 @@ PIXCMAP   *cmap;
 
         /* Convert RGB image */
     pixGetDimensions(pixd, &w, &h, NULL);
-    wpl = pixGetWpl(pixd);
-    data = pixGetData(pixd);
-    for (i = 0; i < h; i++) {
-        line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(line[j], &rval, &gval, &bval);
-            convertRGBToHSV(rval, gval, bval, &hval, &sval, &vval);
-            line[j] = (hval << 24) | (sval << 16) | (vval << 8);
-        }
-    }
-
+    convertRGBBands(L_BAND_TO_HSV, pixGetData(pixd), w, h, pixGetWpl(pixd),
+                    NULL);
     return pixd;
 }
 
@@ -1416,9 +1477,8 @@ PIX *
 pixConvertRGBToYUV(PIX  *pixd,
                    PIX  *pixs)
 {
-l_int32    w, h, d, wpl, i, j, rval, gval, bval, yval, uval, vval;
-l_uint32  *line, *data;
-PIXCMAP   *cmap;
+l_int32   w, h, d;
+PIXCMAP  *cmap;
 
     PROCNAME("pixConvertRGBToYUV");
 
@@ -1443,17 +1503,8 @@ PIXCMAP   *cmap;
 
         /* Convert RGB image */
     pixGetDimensions(pixd, &w, &h, NULL);
-    wpl = pixGetWpl(pixd);
-    data = pixGetData(pixd);
-    for (i = 0; i < h; i++) {
-        line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(line[j], &rval, &gval, &bval);
-            convertRGBToYUV(rval, gval, bval, &yval, &uval, &vval);
-            line[j] = (yval << 24) | (uval << 16) | (vval << 8);
-        }
-    }
-
+    convertRGBBands(L_BAND_TO_YUV, pixGetData(pixd), w, h, pixGetWpl(pixd),
+                    NULL);
     return pixd;
 }
 
@@ -1711,12 +1762,9 @@ l_int32   i, ncolors, rval, gval, bval, yval, uval, vval;
 FPIXA *
 pixConvertRGBToXYZ(PIX  *pixs)
 {
-l_int32     w, h, wpls, wpld, i, j, rval, gval, bval;
-l_uint32   *lines, *datas;
-l_float32   fxval, fyval, fzval;
-l_float32  *linex, *liney, *linez, *datax, *datay, *dataz;
-FPIX       *fpix;
-FPIXA      *fpixa;
+l_int32  w, h, i;
+FPIX    *fpix;
+FPIXA   *fpixa;
 
     PROCNAME("pixConvertRGBToXYZ");
 
@@ -1730,26 +1778,8 @@ FPIXA      *fpixa;
         fpix = fpixCreate(w, h);
         fpixaAddFPix(fpixa, fpix, L_INSERT);
     }
-    wpls = pixGetWpl(pixs);
-    wpld = fpixGetWpl(fpix);
-    datas = pixGetData(pixs);
-    datax = fpixaGetData(fpixa, 0);
-    datay = fpixaGetData(fpixa, 1);
-    dataz = fpixaGetData(fpixa, 2);
-    for (i = 0; i < h; i++) {
-        lines = datas + i * wpls;
-        linex = datax + i * wpld;
-        liney = datay + i * wpld;
-        linez = dataz + i * wpld;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            convertRGBToXYZ(rval, gval, bval, &fxval, &fyval, &fzval);
-            *(linex + j) = fxval;
-            *(liney + j) = fyval;
-            *(linez + j) = fzval;
-        }
-    }
-
+    convertRGBBands(L_BAND_TO_XYZ, pixGetData(pixs), w, h, pixGetWpl(pixs),
+                    fpixa);
     return fpixa;
 }
 
@@ -2176,16 +2206,15 @@ const l_float32  r_offset = 0.13793;  /* 4/29 */
  *  Notes:
  *      (1) The [l,a,b] values are stored as float values in three fpix
  *          that are returned in a fpixa.
+ *      (2) Each line goes directly from rgb to lab; the xyz values are
+ *          not stored.
  */
 FPIXA *
 pixConvertRGBToLAB(PIX  *pixs)
 {
-l_int32     w, h, wpls, wpld, i, j, rval, gval, bval;
-l_uint32   *lines, *datas;
-l_float32   flval, faval, fbval;
-l_float32  *linel, *linea, *lineb, *datal, *dataa, *datab;
-FPIX       *fpix;
-FPIXA      *fpixa;
+l_int32  w, h, i;
+FPIX    *fpix;
+FPIXA   *fpixa;
 
     PROCNAME("pixConvertRGBToLAB");
 
@@ -2199,26 +2228,8 @@ FPIXA      *fpixa;
         fpix = fpixCreate(w, h);
         fpixaAddFPix(fpixa, fpix, L_INSERT);
     }
-    wpls = pixGetWpl(pixs);
-    wpld = fpixGetWpl(fpix);
-    datas = pixGetData(pixs);
-    datal = fpixaGetData(fpixa, 0);
-    dataa = fpixaGetData(fpixa, 1);
-    datab = fpixaGetData(fpixa, 2);
-    for (i = 0; i < h; i++) {
-        lines = datas + i * wpls;
-        linel = datal + i * wpld;
-        linea = dataa + i * wpld;
-        lineb = datab + i * wpld;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            convertRGBToLAB(rval, gval, bval, &flval, &faval, &fbval);
-            *(linel + j) = flval;
-            *(linea + j) = faval;
-            *(lineb + j) = fbval;
-        }
-    }
-
+    convertRGBBands(L_BAND_TO_LAB, pixGetData(pixs), w, h, pixGetWpl(pixs),
+                    fpixa);
     return fpixa;
 }
 
@@ -2346,3 +2357,586 @@ l_float32  fxval, fyval, fzval;
     return 0;
 }
 
+
+
+/*---------------------------------------------------------------------------*
+ *               Forward conversion from RGB on bands of lines               *
+ *---------------------------------------------------------------------------*/
+/*!
+ *  convertRGBBands()
+ *
+ *      Input:  type (L_BAND_TO_HSV, L_BAND_TO_YUV, L_BAND_TO_XYZ,
+ *                    L_BAND_TO_LAB)
+ *              datas, w, h, wpls (32 bpp rgb image data)
+ *              fpixa (three fpix of size w x h for xyz and lab;
+ *                     null for hsv and yuv, which are done in place)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The image is divided into one band of lines for each
+ *          thread, each with at least MinColorBandHeight lines,
+ *          and the bands are converted in parallel.
+ */
+static l_int32
+convertRGBBands(l_int32    type,
+                l_uint32  *datas,
+                l_int32    w,
+                l_int32    h,
+                l_int32    wpls,
+                FPIXA     *fpixa)
+{
+l_int32            i, nbands;
+FPIX              *fpix;
+COLOR_BAND_PARAMS  params;
+
+    PROCNAME("convertRGBBands");
+
+    params.type = type;
+    params.datas = datas;
+    params.w = w;
+    params.h = h;
+    params.wpls = wpls;
+    params.wpld = 0;
+    for (i = 0; i < 3; i++)
+        params.datad[i] = (fpixa) ? fpixaGetData(fpixa, i) : NULL;
+    if (fpixa) {
+        fpix = fpixaGetFPix(fpixa, 0, L_CLONE);
+        params.wpld = fpixGetWpl(fpix);
+        fpixDestroy(&fpix);
+    }
+    nbands = L_MIN(l_getParallelThreads(), h / MinColorBandHeight);
+    params.nbands = L_MAX(1, nbands);
+    params.simd = l_getSimdMode();
+    if (l_parallelRun(params.nbands, params.nbands, convertRGBBand, &params))
+        return ERROR_INT("bands not converted", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  convertRGBBand()
+ *
+ *      Input:  data (COLOR_BAND_PARAMS)
+ *              index (of the band of lines)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+convertRGBBand(void    *data,
+               l_int32  index)
+{
+l_int32             i, y0, y1;
+l_uint32           *lines;
+l_float32          *line0, *line1, *line2;
+COLOR_BAND_PARAMS  *params;
+
+    params = (COLOR_BAND_PARAMS *)data;
+    y0 = (params->h * index) / params->nbands;
+    y1 = (params->h * (index + 1)) / params->nbands;
+    for (i = y0; i < y1; i++) {
+        lines = params->datas + i * params->wpls;
+        switch (params->type)
+        {
+        case L_BAND_TO_HSV:
+            rgbToHSVLine(lines, params->w, params->simd);
+            break;
+        case L_BAND_TO_YUV:
+            rgbToYUVLine(lines, params->w, params->simd);
+            break;
+        default:  /* xyz or lab */
+            line0 = params->datad[0] + i * params->wpld;
+            line1 = params->datad[1] + i * params->wpld;
+            line2 = params->datad[2] + i * params->wpld;
+            rgbToXYZLine(lines, params->w, line0, line1, line2,
+                         params->type == L_BAND_TO_LAB, params->simd);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+/*!
+ *  rgbToHSVLine()
+ *
+ *      Input:  line (of 32 bpp rgb pixels; converted in place to hsv)
+ *              w (number of pixels)
+ *              simd (simd mode)
+ *      Return: void
+ */
+static void
+rgbToHSVLine(l_uint32  *line,
+             l_int32    w,
+             l_int32    simd)
+{
+l_int32  j, jstart, rval, gval, bval, hval, sval, vval;
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_SSE2
+    case L_SIMD_AVX2:
+    case L_SIMD_SSE2:
+        jstart = rgbToHSVLineSse2(line, w);
+        break;
+#endif  /* L_HAVE_SSE2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        extractRGBValues(line[j], &rval, &gval, &bval);
+        convertRGBToHSV(rval, gval, bval, &hval, &sval, &vval);
+        line[j] = (hval << 24) | (sval << 16) | (vval << 8);
+    }
+}
+
+
+/*!
+ *  rgbToYUVLine()
+ *
+ *      Input:  line (of 32 bpp rgb pixels; converted in place to yuv)
+ *              w (number of pixels)
+ *              simd (simd mode)
+ *      Return: void
+ */
+static void
+rgbToYUVLine(l_uint32  *line,
+             l_int32    w,
+             l_int32    simd)
+{
+l_int32  j, jstart, rval, gval, bval, yval, uval, vval;
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_SSE2
+    case L_SIMD_AVX2:
+    case L_SIMD_SSE2:
+        jstart = rgbToYUVLineSse2(line, w);
+        break;
+#endif  /* L_HAVE_SSE2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        extractRGBValues(line[j], &rval, &gval, &bval);
+        convertRGBToYUV(rval, gval, bval, &yval, &uval, &vval);
+        line[j] = (yval << 24) | (uval << 16) | (vval << 8);
+    }
+}
+
+
+/*!
+ *  rgbToXYZLine()
+ *
+ *      Input:  lines (of 32 bpp rgb pixels)
+ *              w (number of pixels)
+ *              line0, line1, line2 (<return> x, y and z, or l, a and b)
+ *              tolab (1 to continue on to lab; 0 for xyz)
+ *              simd (simd mode)
+ *      Return: void
+ */
+static void
+rgbToXYZLine(l_uint32   *lines,
+             l_int32     w,
+             l_float32  *line0,
+             l_float32  *line1,
+             l_float32  *line2,
+             l_int32     tolab,
+             l_int32     simd)
+{
+l_int32    j, jstart, rval, gval, bval;
+l_float32  fxval, fyval, fzval;
+
+#if  SLOW_CUBE_ROOT
+    if (tolab)  /* the kernels use the rational approximation */
+        simd = L_SIMD_NONE;
+#endif  /* SLOW_CUBE_ROOT */
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = rgbToXYZLineAvx2(lines, w, line0, line1, line2, tolab);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        jstart = rgbToXYZLineSse2(lines, w, line0, line1, line2, tolab);
+        break;
+#endif  /* L_HAVE_SSE2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        extractRGBValues(lines[j], &rval, &gval, &bval);
+        if (tolab) {
+            convertRGBToLAB(rval, gval, bval, line0 + j, line1 + j,
+                            line2 + j);
+        } else {
+            convertRGBToXYZ(rval, gval, bval, &fxval, &fyval, &fzval);
+            line0[j] = fxval;
+            line1[j] = fyval;
+            line2[j] = fzval;
+        }
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of pixels
+     * it has done; the rest are done by the caller.  To give the same
+     * results as the per-pixel functions, the kernels do each step in
+     * the same precision (float or double) and the same order, and
+     * round to float wherever those functions store a float.  */
+#if L_HAVE_SSE2
+    /* Matrix of convertRGBToXYZ() and the normalization to the
+     * white point in convertXYZToLAB() */
+static const l_float64  XYZCoeffs[3][3] = {{0.4125, 0.3576, 0.1804},
+                                           {0.2127, 0.7152, 0.0722},
+                                           {0.0193, 0.1192, 0.9502}};
+static const l_float64  XYZWhite[3] = {0.0041259, 0.0039216, 0.0036012};
+
+static l_int32
+rgbToHSVLineSse2(l_uint32  *line,
+                 l_int32    w)
+{
+l_int32  j, k;
+__m128i  p, ff, zero, one, r, g, b, max, min, delta, gray;
+__m128i  rmax, gmax, bmax, num, off, delta1, max1, hv, sv;
+__m128i  hval[2], sval[2];
+__m128   hq;
+__m128d  t, t2, neg, half;
+
+    ff = _mm_set1_epi32(0xff);
+    zero = _mm_setzero_si128();
+    one = _mm_set1_epi32(1);
+    half = _mm_set1_pd(0.5);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = _mm_loadu_si128((const __m128i *)(line + j));
+        r = _mm_srli_epi32(p, 24);
+        g = _mm_and_si128(_mm_srli_epi32(p, 16), ff);
+        b = _mm_and_si128(_mm_srli_epi32(p, 8), ff);
+        max = _mm_max_epi16(r, _mm_max_epi16(g, b));
+        min = _mm_min_epi16(r, _mm_min_epi16(g, b));
+        delta = _mm_sub_epi32(max, min);
+        gray = _mm_cmpeq_epi32(delta, zero);
+
+            /* Sector of the hue, and its offset */
+        rmax = _mm_cmpeq_epi32(r, max);
+        gmax = _mm_andnot_si128(rmax, _mm_cmpeq_epi32(g, max));
+        bmax = _mm_cmpeq_epi32(_mm_or_si128(rmax, gmax), zero);
+        num = _mm_or_si128(
+                  _mm_and_si128(rmax, _mm_sub_epi32(g, b)),
+                  _mm_or_si128(_mm_and_si128(gmax, _mm_sub_epi32(b, r)),
+                               _mm_and_si128(bmax, _mm_sub_epi32(r, g))));
+        off = _mm_or_si128(_mm_and_si128(gmax, _mm_set1_epi32(2)),
+                           _mm_and_si128(bmax, _mm_set1_epi32(4)));
+
+            /* Gray pixels are given nonzero denominators here, and
+             * h = s = 0 at the end */
+        delta1 = _mm_or_si128(delta, _mm_and_si128(gray, one));
+        max1 = _mm_or_si128(max, _mm_and_si128(gray, one));
+        hq = _mm_div_ps(_mm_cvtepi32_ps(num), _mm_cvtepi32_ps(delta1));
+
+            /* Two pixels at a time in double */
+        for (k = 0; k < 2; k++) {
+            t = _mm_div_pd(_mm_mul_pd(_mm_set1_pd(255.),
+                                      _mm_cvtepi32_pd(delta1)),
+                           _mm_cvtepi32_pd(max1));
+            sval[k] = _mm_cvttpd_epi32(_mm_add_pd(t, half));
+            t = _mm_add_pd(_mm_cvtepi32_pd(off), _mm_cvtps_pd(hq));
+            t = _mm_cvtps_pd(_mm_cvtpd_ps(t));
+            t = _mm_mul_pd(t, _mm_set1_pd(40.0));
+            t = _mm_cvtps_pd(_mm_cvtpd_ps(t));
+            t2 = _mm_add_pd(t, _mm_set1_pd(240.0));
+            t2 = _mm_cvtps_pd(_mm_cvtpd_ps(t2));
+            neg = _mm_cmplt_pd(t, _mm_setzero_pd());
+            t = _mm_or_pd(_mm_and_pd(neg, t2), _mm_andnot_pd(neg, t));
+            t = _mm_andnot_pd(_mm_cmpge_pd(t, _mm_set1_pd(239.5)), t);
+            hval[k] = _mm_cvttpd_epi32(_mm_add_pd(t, half));
+
+                /* Move the upper two pixels down */
+            delta1 = _mm_shuffle_epi32(delta1, 0x0e);
+            max1 = _mm_shuffle_epi32(max1, 0x0e);
+            off = _mm_shuffle_epi32(off, 0x0e);
+            hq = _mm_movehl_ps(hq, hq);
+        }
+        hv = _mm_andnot_si128(gray, _mm_unpacklo_epi64(hval[0], hval[1]));
+        sv = _mm_andnot_si128(gray, _mm_unpacklo_epi64(sval[0], sval[1]));
+        p = _mm_or_si128(_mm_slli_epi32(hv, 24),
+                         _mm_or_si128(_mm_slli_epi32(sv, 16),
+                                      _mm_slli_epi32(max, 8)));
+        _mm_storeu_si128((__m128i *)(line + j), p);
+    }
+    return j;
+}
+
+static l_int32
+rgbToYUVLineSse2(l_uint32  *line,
+                 l_int32    w)
+{
+l_int32  j, k;
+__m128i  p, ff, r, g, b;
+__m128i  yval[2], uval[2], vval[2];
+__m128d  rd, gd, bd, t, norm, half;
+
+    ff = _mm_set1_epi32(0xff);
+    norm = _mm_set1_pd(1.0 / 256.);
+    half = _mm_set1_pd(0.5);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = _mm_loadu_si128((const __m128i *)(line + j));
+        r = _mm_srli_epi32(p, 24);
+        g = _mm_and_si128(_mm_srli_epi32(p, 16), ff);
+        b = _mm_and_si128(_mm_srli_epi32(p, 8), ff);
+        for (k = 0; k < 2; k++) {
+            rd = _mm_cvtepi32_pd(r);
+            gd = _mm_cvtepi32_pd(g);
+            bd = _mm_cvtepi32_pd(b);
+            t = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(65.738), rd),
+                                      _mm_mul_pd(_mm_set1_pd(129.057), gd)),
+                           _mm_mul_pd(_mm_set1_pd(25.064), bd));
+            t = _mm_add_pd(_mm_set1_pd(16.0), _mm_mul_pd(norm, t));
+            yval[k] = _mm_cvttpd_epi32(_mm_add_pd(t, half));
+            t = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(_mm_set1_pd(-37.945), rd),
+                                      _mm_mul_pd(_mm_set1_pd(74.494), gd)),
+                           _mm_mul_pd(_mm_set1_pd(112.439), bd));
+            t = _mm_add_pd(_mm_set1_pd(128.0), _mm_mul_pd(norm, t));
+            uval[k] = _mm_cvttpd_epi32(_mm_add_pd(t, half));
+            t = _mm_sub_pd(_mm_sub_pd(_mm_mul_pd(_mm_set1_pd(112.439), rd),
+                                      _mm_mul_pd(_mm_set1_pd(94.154), gd)),
+                           _mm_mul_pd(_mm_set1_pd(18.285), bd));
+            t = _mm_add_pd(_mm_set1_pd(128.0), _mm_mul_pd(norm, t));
+            vval[k] = _mm_cvttpd_epi32(_mm_add_pd(t, half));
+
+                /* Move the upper two pixels down */
+            r = _mm_shuffle_epi32(r, 0x0e);
+            g = _mm_shuffle_epi32(g, 0x0e);
+            b = _mm_shuffle_epi32(b, 0x0e);
+        }
+        p = _mm_or_si128(
+                _mm_slli_epi32(_mm_unpacklo_epi64(yval[0], yval[1]), 24),
+                _mm_or_si128(
+                    _mm_slli_epi32(_mm_unpacklo_epi64(uval[0], uval[1]), 16),
+                    _mm_slli_epi32(_mm_unpacklo_epi64(vval[0], vval[1]), 8)));
+        _mm_storeu_si128((__m128i *)(line + j), p);
+    }
+    return j;
+}
+
+static l_int32
+rgbToXYZLineSse2(l_uint32   *lines,
+                 l_int32     w,
+                 l_float32  *line0,
+                 l_float32  *line1,
+                 l_float32  *line2,
+                 l_int32     tolab)
+{
+l_int32  j, k, m;
+__m128i  p, ff;
+__m128i  c[3];
+__m128   f[3];
+__m128d  t[2];
+__m128d  d[3][2];
+
+    ff = _mm_set1_epi32(0xff);
+    for (j = 0; j + 4 <= w; j += 4) {
+        p = _mm_loadu_si128((const __m128i *)(lines + j));
+        c[0] = _mm_srli_epi32(p, 24);
+        c[1] = _mm_and_si128(_mm_srli_epi32(p, 16), ff);
+        c[2] = _mm_and_si128(_mm_srli_epi32(p, 8), ff);
+        for (k = 0; k < 3; k++) {
+            d[k][0] = _mm_cvtepi32_pd(c[k]);
+            d[k][1] = _mm_cvtepi32_pd(_mm_shuffle_epi32(c[k], 0x0e));
+        }
+        for (k = 0; k < 3; k++) {
+            for (m = 0; m < 2; m++) {
+                t[m] = _mm_add_pd(
+                    _mm_add_pd(_mm_mul_pd(_mm_set1_pd(XYZCoeffs[k][0]),
+                                          d[0][m]),
+                               _mm_mul_pd(_mm_set1_pd(XYZCoeffs[k][1]),
+                                          d[1][m])),
+                    _mm_mul_pd(_mm_set1_pd(XYZCoeffs[k][2]), d[2][m]));
+            }
+            f[k] = _mm_movelh_ps(_mm_cvtpd_ps(t[0]), _mm_cvtpd_ps(t[1]));
+        }
+
+        if (tolab) {
+            for (k = 0; k < 3; k++)
+                f[k] = labForwardSse2(mulDoubleSse2(f[k], XYZWhite[k]));
+            t[0] = _mm_sub_pd(_mm_mul_pd(_mm_set1_pd(116.0),
+                                         _mm_cvtps_pd(f[1])),
+                              _mm_set1_pd(16.0));
+            t[1] = _mm_sub_pd(_mm_mul_pd(_mm_set1_pd(116.0),
+                                    _mm_cvtps_pd(_mm_movehl_ps(f[1], f[1]))),
+                              _mm_set1_pd(16.0));
+            f[2] = mulDoubleSse2(_mm_sub_ps(f[1], f[2]), 200.0);
+            f[1] = mulDoubleSse2(_mm_sub_ps(f[0], f[1]), 500.0);
+            f[0] = _mm_movelh_ps(_mm_cvtpd_ps(t[0]), _mm_cvtpd_ps(t[1]));
+        }
+
+        _mm_storeu_ps(line0 + j, f[0]);
+        _mm_storeu_ps(line1 + j, f[1]);
+        _mm_storeu_ps(line2 + j, f[2]);
+    }
+    return j;
+}
+
+    /* Product of each float in @v with @c in double, rounded to float */
+static __m128
+mulDoubleSse2(__m128     v,
+              l_float64  c)
+{
+__m128d  lo, hi;
+
+    lo = _mm_mul_pd(_mm_cvtps_pd(v), _mm_set1_pd(c));
+    hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), _mm_set1_pd(c));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+    /* lab_forward() on 4 floats */
+static __m128
+labForwardSse2(__m128  v)
+{
+l_int32  m;
+__m128   num, den, lin, mask;
+__m128   fnum[2], fden[2];
+__m128d  d, t;
+
+    for (m = 0; m < 2; m++) {
+        d = _mm_cvtps_pd((m == 0) ? v : _mm_movehl_ps(v, v));
+        t = _mm_add_pd(_mm_set1_pd(1.25201),
+                       _mm_mul_pd(d, _mm_set1_pd(1.30273)));
+        t = _mm_add_pd(_mm_set1_pd(9.52695e-02), _mm_mul_pd(d, t));
+        t = _mm_add_pd(_mm_set1_pd(4.37089e-04), _mm_mul_pd(d, t));
+        fnum[m] = _mm_cvtpd_ps(t);
+        t = _mm_add_pd(_mm_set1_pd(1.71714),
+                       _mm_mul_pd(d, _mm_set1_pd(6.34341e-01)));
+        t = _mm_add_pd(_mm_set1_pd(2.95408e-01), _mm_mul_pd(d, t));
+        t = _mm_add_pd(_mm_set1_pd(3.91236e-03), _mm_mul_pd(d, t));
+        fden[m] = _mm_cvtpd_ps(t);
+    }
+    num = _mm_movelh_ps(fnum[0], fnum[1]);
+    den = _mm_movelh_ps(fden[0], fden[1]);
+    lin = _mm_add_ps(_mm_mul_ps(_mm_set1_ps((l_float32)7.787), v),
+                     _mm_set1_ps((l_float32)0.13793));
+    mask = _mm_cmpgt_ps(v, _mm_set1_ps((l_float32)0.008856));
+    return _mm_or_ps(_mm_and_ps(mask, _mm_div_ps(num, den)),
+                     _mm_andnot_ps(mask, lin));
+}
+#endif  /* L_HAVE_SSE2 */
+
+#if L_HAVE_AVX2
+static l_int32
+rgbToXYZLineAvx2(l_uint32   *lines,
+                 l_int32     w,
+                 l_float32  *line0,
+                 l_float32  *line1,
+                 l_float32  *line2,
+                 l_int32     tolab)
+{
+l_int32  j, k, m;
+__m256i  p, ff;
+__m256i  c[3];
+__m256   f[3];
+__m256d  t[2];
+__m256d  d[3][2];
+
+    ff = _mm256_set1_epi32(0xff);
+    for (j = 0; j + 8 <= w; j += 8) {
+        p = _mm256_loadu_si256((const __m256i *)(lines + j));
+        c[0] = _mm256_srli_epi32(p, 24);
+        c[1] = _mm256_and_si256(_mm256_srli_epi32(p, 16), ff);
+        c[2] = _mm256_and_si256(_mm256_srli_epi32(p, 8), ff);
+        for (k = 0; k < 3; k++) {
+            d[k][0] = _mm256_cvtepi32_pd(_mm256_castsi256_si128(c[k]));
+            d[k][1] = _mm256_cvtepi32_pd(_mm256_extracti128_si256(c[k], 1));
+        }
+        for (k = 0; k < 3; k++) {
+            for (m = 0; m < 2; m++) {
+                t[m] = _mm256_add_pd(
+                    _mm256_add_pd(
+                        _mm256_mul_pd(_mm256_set1_pd(XYZCoeffs[k][0]),
+                                      d[0][m]),
+                        _mm256_mul_pd(_mm256_set1_pd(XYZCoeffs[k][1]),
+                                      d[1][m])),
+                    _mm256_mul_pd(_mm256_set1_pd(XYZCoeffs[k][2]), d[2][m]));
+            }
+            f[k] = _mm256_insertf128_ps(
+                       _mm256_castps128_ps256(_mm256_cvtpd_ps(t[0])),
+                       _mm256_cvtpd_ps(t[1]), 1);
+        }
+
+        if (tolab) {
+            for (k = 0; k < 3; k++)
+                f[k] = labForwardAvx2(mulDoubleAvx2(f[k], XYZWhite[k]));
+            for (m = 0; m < 2; m++) {
+                t[m] = _mm256_sub_pd(
+                    _mm256_mul_pd(_mm256_set1_pd(116.0), _mm256_cvtps_pd(
+                        (m == 0) ? _mm256_castps256_ps128(f[1])
+                                 : _mm256_extractf128_ps(f[1], 1))),
+                    _mm256_set1_pd(16.0));
+            }
+            f[2] = mulDoubleAvx2(_mm256_sub_ps(f[1], f[2]), 200.0);
+            f[1] = mulDoubleAvx2(_mm256_sub_ps(f[0], f[1]), 500.0);
+            f[0] = _mm256_insertf128_ps(
+                       _mm256_castps128_ps256(_mm256_cvtpd_ps(t[0])),
+                       _mm256_cvtpd_ps(t[1]), 1);
+        }
+
+        _mm256_storeu_ps(line0 + j, f[0]);
+        _mm256_storeu_ps(line1 + j, f[1]);
+        _mm256_storeu_ps(line2 + j, f[2]);
+    }
+    return j;
+}
+
+    /* Product of each float in @v with @c in double, rounded to float */
+static __m256
+mulDoubleAvx2(__m256     v,
+              l_float64  c)
+{
+__m256d  lo, hi;
+
+    lo = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+                       _mm256_set1_pd(c));
+    hi = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)),
+                       _mm256_set1_pd(c));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)),
+                                _mm256_cvtpd_ps(hi), 1);
+}
+
+    /* lab_forward() on 8 floats */
+static __m256
+labForwardAvx2(__m256  v)
+{
+l_int32  m;
+__m128   fnum[2], fden[2];
+__m256   num, den, lin, mask;
+__m256d  d, t;
+
+    for (m = 0; m < 2; m++) {
+        d = _mm256_cvtps_pd((m == 0) ? _mm256_castps256_ps128(v)
+                                     : _mm256_extractf128_ps(v, 1));
+        t = _mm256_add_pd(_mm256_set1_pd(1.25201),
+                          _mm256_mul_pd(d, _mm256_set1_pd(1.30273)));
+        t = _mm256_add_pd(_mm256_set1_pd(9.52695e-02), _mm256_mul_pd(d, t));
+        t = _mm256_add_pd(_mm256_set1_pd(4.37089e-04), _mm256_mul_pd(d, t));
+        fnum[m] = _mm256_cvtpd_ps(t);
+        t = _mm256_add_pd(_mm256_set1_pd(1.71714),
+                          _mm256_mul_pd(d, _mm256_set1_pd(6.34341e-01)));
+        t = _mm256_add_pd(_mm256_set1_pd(2.95408e-01), _mm256_mul_pd(d, t));
+        t = _mm256_add_pd(_mm256_set1_pd(3.91236e-03), _mm256_mul_pd(d, t));
+        fden[m] = _mm256_cvtpd_ps(t);
+    }
+    num = _mm256_insertf128_ps(_mm256_castps128_ps256(fnum[0]), fnum[1], 1);
+    den = _mm256_insertf128_ps(_mm256_castps128_ps256(fden[0]), fden[1], 1);
+    lin = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps((l_float32)7.787), v),
+                        _mm256_set1_ps((l_float32)0.13793));
+    mask = _mm256_cmp_ps(v, _mm256_set1_ps((l_float32)0.008856), _CMP_GT_OQ);
+    return _mm256_blendv_ps(lin, _mm256_div_ps(num, den), mask);
+}
+#endif  /* L_HAVE_AVX2 */
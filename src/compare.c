@@ -3236,6 +3236,8 @@ PIXA      *pixa1, *pixa2, *pixadb;
  *          Consequently, if pix1 and pix2 are large, you should do this
  *          in a coarse-to-fine sequence.  See the use of this function
  *          in pixCompareWithTranslation().
+ *      (4) The correlations are done with pixCorrelationScoreBatch().
+ *          @tab8 is only used to make the debug image.
  */
 l_int32
 pixBestCorrelation(PIX        *pix1,
@@ -3253,9 +3255,12 @@ pixBestCorrelation(PIX        *pix1,
 {
 l_int32    shiftx, shifty, delx, dely;
 l_int32   *tab;
-l_float32  maxscore, score;
+l_float32  fshiftx, fshifty, maxscore, score;
 FPIX      *fpix;
+NUMA      *na, *nascore;
 PIX       *pix3, *pix4;
+PIXA      *pixa;
+PTA       *pta, *ptashift;
 
     PROCNAME("pixBestCorrelation");
 
@@ -3269,38 +3274,43 @@ PIX       *pix3, *pix4;
     if (!area1 || !area2)
         return ERROR_INT("areas must be > 0", procName, 1);
 
-    if (debugflag > 0)
-        fpix = fpixCreate(2 * maxshift + 1, 2 * maxshift + 1);
-
-    if (!tab8)
-        tab = makePixelSumTab8();
-    else
-        tab = tab8;
-
         /* Search over a set of {shiftx, shifty} for the max */
-    maxscore = 0;
-    delx = etransx;
-    dely = etransy;
-    for (shifty = -maxshift; shifty <= maxshift; shifty++) {
-        for (shiftx = -maxshift; shiftx <= maxshift; shiftx++) {
-            pixCorrelationScoreShifted(pix1, pix2, area1, area2,
-                                       etransx + shiftx,
-                                       etransy + shifty, tab, &score);
-            if (debugflag > 0) {
+    pixa = pixaCreate(1);
+    pixaAddPix(pixa, pix2, L_CLONE);
+    na = numaCreate(1);
+    numaAddNumber(na, area2);
+    pta = ptaCreate(1);
+    ptaAddPt(pta, etransx, etransy);
+    pixCorrelationScoreBatch(pix1, area1, pixa, na, pta, maxshift,
+                             100000, 100000, &nascore, &ptashift);
+    maxscore = 0.0;
+    fshiftx = fshifty = 0.0;
+    if (nascore) {
+        numaGetFValue(nascore, 0, &maxscore);
+        ptaGetPt(ptashift, 0, &fshiftx, &fshifty);
+    }
+    delx = etransx + (l_int32)fshiftx;
+    dely = etransy + (l_int32)fshifty;
+    pixaDestroy(&pixa);
+    numaDestroy(&na);
+    ptaDestroy(&pta);
+    numaDestroy(&nascore);
+    ptaDestroy(&ptashift);
+
+    if (debugflag > 0) {
+        fpix = fpixCreate(2 * maxshift + 1, 2 * maxshift + 1);
+        tab = (tab8) ? tab8 : makePixelSumTab8();
+        for (shifty = -maxshift; shifty <= maxshift; shifty++) {
+            for (shiftx = -maxshift; shiftx <= maxshift; shiftx++) {
+                pixCorrelationScoreShifted(pix1, pix2, area1, area2,
+                                           etransx + shiftx,
+                                           etransy + shifty, tab, &score);
                 fpixSetPixel(fpix, maxshift + shiftx, maxshift + shifty,
                              1000.0 * score);
-/*                fprintf(stderr, "(sx, sy) = (%d, %d): score = %6.4f\n",
-                        shiftx, shifty, score); */
-            }
-            if (score > maxscore) {
-                maxscore = score;
-                delx = etransx + shiftx;
-                dely = etransy + shifty;
             }
         }
-    }
+        if (!tab8) LEPT_FREE(tab);
 
-    if (debugflag > 0) {
         lept_mkdir("lept/comp");
         char  buf[128];
         pix3 = fpixDisplayMaxDynamicRange(fpix);
@@ -3316,6 +3326,5 @@ PIX       *pix3, *pix4;
     if (pdelx) *pdelx = delx;
     if (pdely) *pdely = dely;
     if (pscore) *pscore = maxscore;
-    if (!tab8) LEPT_FREE(tab);
     return 0;
 }
@@ -27,8 +27,8 @@
 /*
  *  conncomp.c
  *
- *    Connected component counting and extraction, using Heckbert's
- *    stack-based filling algorithm.
+ *    Connected component counting and extraction, using union-find
+ *    labeling of runs, and Heckbert's stack-based filling algorithm.
  *
  *      4- and 8-connected components: counts, bounding boxes and images
  *
@@ -57,35 +57,42 @@
  *           static void    pushFillseg()
  *           static void    popFillseg()
  *
- *  The basic method in pixConnCompBB() is very simple.  We scan the
- *  image in raster order, looking for the next ON pixel.  When it
- *  is found, we erase it and every pixel of the 4- or 8-connected
- *  component to which it belongs, using Heckbert's seedfill
- *  algorithm.  As pixels are erased, we keep track of the
- *  minimum rectangle that encloses all erased pixels; after
- *  the connected component has been erased, we save its
- *  bounding box in an array of boxes.  When all pixels in the
- *  image have been erased, we have an array that describes every
- *  4- or 8-connected component in terms of its bounding box.
+ *      Static helpers for union-find labeling of runs:
+ *           static CCRUNS  *pixLabelRuns()
+ *           static l_int32  labelRunsStrip()
+ *           static l_int32  findRunsOnLine()
+ *           static void     unionRunsOnLines()
+ *           static CCRUNS  *ccRunsCreate()
+ *           static void     ccRunsDestroy()
+ *           static l_int32  ccRunsAdd()
+ *           static BOXA    *ccRunsMakeBoxa()
  *
- *  pixConnCompPixa() is a slight variation on pixConnCompBB(),
- *  where we additionally save an array of images (in a Pixa)
- *  of each of the 4- or 8-connected components.  This is done trivially
- *  by maintaining two temporary images.  We erase a component from one,
- *  and use the bounding box to extract the pixels within the b.b.
- *  from each of the two images.  An XOR between these subimages
- *  gives the erased component.  Then we erase the component from the
- *  second image using the XOR again, with the extracted component
- *  placed on the second image at the location of the bounding box.
- *  Rasterop does all the work.  At the end, we have an array
- *  of the 4- or 8-connected components, as well as an array of the
- *  bounding boxes that describe where they came from in the original image.
+ *  The method in pixConnCompBB(), pixConnCompPixa() and pixCountConnComp()
+ *  is a two-pass labeling of runs.  In the first pass, the runs of
+ *  ON pixels are found on each raster line, in raster order.  Each run
+ *  is joined, using union-find, with the runs on the previous line that
+ *  it touches (with 4- or 8-connectivity).  The root of each set is
+ *  always the earliest of its runs.  In the second pass, the runs
+ *  are given the index of their set.  Because the sets are numbered
+ *  in the order of their earliest run, the components are found in
+ *  the same order as scanning the image in raster order for the next
+ *  ON pixel.  The bounding boxes, and optionally the images, of the
+ *  components are then made from their runs.  Each pixel is read once.
  *
- *  If you just want the number of connected components, pixCountConnComp()
- *  is a bit faster than pixConnCompBB(), because it doesn't have to
- *  keep track of the bounding rectangles for each c.c.
+ *  The first pass can be done in parallel on horizontal strips of the
+ *  image, using the number of threads set by l_setParallelThreads().
+ *  The sets of the runs on either side of each strip boundary are
+ *  then joined.  The result does not depend on the number of strips.
+ *
+ *  The older method, which is still available in pixSeedfillBB() and
+ *  related functions, scans the image in raster order for the next
+ *  ON pixel.  When it is found, it erases it and every pixel of the
+ *  4- or 8-connected component to which it belongs, using Heckbert's
+ *  seedfill algorithm, and keeps track of the minimum rectangle that
+ *  encloses all erased pixels.
  */
 
+#include <string.h>
 #include "allheaders.h"
 
 /*
@@ -115,6 +122,49 @@ static void popFillseg(L_STACK *stack, l_int32 *pxleft, l_int32 *pxright,
                        l_int32 *py, l_int32 *pdy);
 
 
+    /* Runs of ON pixels on a set of lines, with the union-find
+     * parent of each run.  Runs are stored in raster order. */
+struct CCRuns
+{
+    l_int32    y0;        /* first line                                  */
+    l_int32    nlines;    /* number of lines                             */
+    l_int32    n;         /* number of runs                              */
+    l_int32    nalloc;    /* size of the run arrays                      */
+    l_int32   *xstart;    /* first pixel of each run                     */
+    l_int32   *xend;      /* last pixel of each run                      */
+    l_int32   *parent;    /* parent of each run; then, index of its c.c. */
+    l_int32   *linestart; /* index of first run on each line, plus one   */
+                          /* more for the end of the last line           */
+};
+typedef struct CCRuns    CCRUNS;
+
+    /* Input and output for labeling the runs of one strip */
+struct CCStripParams
+{
+    PIX       *pixs;
+    l_int32    connectivity;
+    l_int32    nstrips;
+    l_int32   *tab;       /* MS bit location of ON pixel in a byte      */
+    CCRUNS   **strips;    /* <return> runs of each strip                */
+};
+typedef struct CCStripParams    CC_STRIP_PARAMS;
+
+    /* Static helpers for union-find labeling */
+static CCRUNS *pixLabelRuns(PIX *pixs, l_int32 connectivity,
+                            l_int32 *pncc);
+static l_int32 labelRunsStrip(void *data, l_int32 index);
+static l_int32 findRunsOnLine(l_uint32 *line, l_int32 w, l_int32 *tab,
+                              CCRUNS *runs);
+static void unionRunsOnLines(CCRUNS *runs, l_int32 start1, l_int32 end1,
+                             l_int32 start2, l_int32 end2, l_int32 dist);
+static CCRUNS *ccRunsCreate(l_int32 y0, l_int32 nlines, l_int32 nalloc);
+static void ccRunsDestroy(CCRUNS **pruns);
+static l_int32 ccRunsAdd(CCRUNS *runs, l_int32 xstart, l_int32 xend);
+static BOXA *ccRunsMakeBoxa(CCRUNS *runs, l_int32 ncc);
+
+    /* Min number of lines in a strip for parallel labeling */
+static const l_int32  MinStripHeight = 64;
+
 #ifndef  NO_CONSOLE_IO
 #define   DEBUG    0
 #endif  /* ~NO_CONSOLE_IO */
@@ -171,27 +221,31 @@ pixConnComp(PIX     *pixs,
  *      (1) This finds bounding boxes of 4- or 8-connected components
  *          in a binary image, and saves images of each c.c
  *          in a pixa array.
- *      (2) It sets up 2 temporary pix, and for each c.c. that is
- *          located in raster order, it erases the c.c. from one pix,
- *          then uses the b.b. to extract the c.c. from the two pix using
- *          an XOR, and finally erases the c.c. from the second pix.
+ *      (2) The runs of the image are labeled in one pass (see the
+ *          top of this file).  The image of each c.c. is then made
+ *          by painting its runs into a pix the size of its b.b.
+ *          The c.c. are in the order in which they are first reached
+ *          by a raster scan.
  *      (3) A clone of the returned boxa (where all boxes in the array
  *          are clones) is inserted into the pixa.
  *      (4) If the input is valid, this always returns a boxa and a pixa.
- *          If pixs is empty, the boxa and pixa will be empty.
+ *          If pixs is empty, the boxa and pixa will be empty.  If they
+ *          can't all be made, both are returned null; a pixa with
+ *          missing components is never returned.
  */
 BOXA *
 pixConnCompPixa(PIX     *pixs,
                 PIXA   **ppixa,
                 l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pixt1, *pixt2, *pixt3, *pixt4;
-PIXA     *pixa;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32    i, j, k, n, y, ncc, bw, bh, x0, x1, iszero;
+l_int32   *xa, *ya, *wpla;
+l_uint32  *line, *word;
+l_uint32 **dataa;
+BOXA      *boxa;
+CCRUNS    *runs;
+PIX       *pix;
+PIXA      *pixa;
 
     PROCNAME("pixConnCompPixa");
 
@@ -209,59 +263,81 @@ L_STACK  *stack, *auxstack;
     if (iszero)
         return boxaCreate(1);  /* return empty boxa */
 
-    if ((pixt1 = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pixt1 not made", procName, NULL);
-    if ((pixt2 = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pixt2 not made", procName, NULL);
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL)
-        return (BOXA *)ERROR_PTR("stack not made", procName, NULL);
-    if ((auxstack = lstackCreate(0)) == NULL)
-        return (BOXA *)ERROR_PTR("auxstack not made", procName, NULL);
-    stack->auxstack = auxstack;
-    if ((boxa = boxaCreate(0)) == NULL)
+    if ((runs = pixLabelRuns(pixs, connectivity, &ncc)) == NULL) {
+        pixaDestroy(ppixa);
+        return (BOXA *)ERROR_PTR("runs not made", procName, NULL);
+    }
+    if ((boxa = ccRunsMakeBoxa(runs, ncc)) == NULL) {
+        ccRunsDestroy(&runs);
+        pixaDestroy(ppixa);
         return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
+    }
 
-    xstart = 0;
-    ystart = 0;
-    while (1)
-    {
-        if (!nextOnPixelInRaster(pixt1, xstart, ystart, &x, &y))
+        /* Make an image for each c.c. */
+    dataa = (l_uint32 **)LEPT_CALLOC(ncc, sizeof(l_uint32 *));
+    wpla = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    xa = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    ya = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    if (!dataa || !wpla || !xa || !ya) {
+        LEPT_FREE(dataa);
+        LEPT_FREE(wpla);
+        LEPT_FREE(xa);
+        LEPT_FREE(ya);
+        ccRunsDestroy(&runs);
+        boxaDestroy(&boxa);
+        pixaDestroy(ppixa);
+        return (BOXA *)ERROR_PTR("arrays not made", procName, NULL);
+    }
+    for (i = 0; i < ncc; i++) {
+        boxaGetBoxGeometry(boxa, i, &xa[i], &ya[i], &bw, &bh);
+        if ((pix = pixCreate(bw, bh, 1)) == NULL)
             break;
-
-        if ((box = pixSeedfillBB(pixt1, stack, x, y, connectivity)) == NULL)
-            return (BOXA *)ERROR_PTR("box not made", procName, NULL);
-        boxaAddBox(boxa, box, L_INSERT);
-
-            /* Save the c.c. and remove from pixt2 as well */
-        pixt3 = pixClipRectangle(pixt1, box, NULL);
-        pixt4 = pixClipRectangle(pixt2, box, NULL);
-        pixXor(pixt3, pixt3, pixt4);
-        pixRasterop(pixt2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
-                    pixt3, 0, 0);
-        pixaAddPix(pixa, pixt3, L_INSERT);
-        pixDestroy(&pixt4);
-
-        xstart = x;
-        ystart = y;
+        pixCopyResolution(pix, pixs);
+        pixCopyColormap(pix, pixs);
+        dataa[i] = pixGetData(pix);
+        wpla[i] = pixGetWpl(pix);
+        pixaAddPix(pixa, pix, L_INSERT);
+    }
+    if (i < ncc) {  /* no partial results */
+        LEPT_FREE(dataa);
+        LEPT_FREE(wpla);
+        LEPT_FREE(xa);
+        LEPT_FREE(ya);
+        ccRunsDestroy(&runs);
+        boxaDestroy(&boxa);
+        pixaDestroy(ppixa);
+        return (BOXA *)ERROR_PTR("pix not made for a c.c.", procName, NULL);
     }
 
-#if  DEBUG
-    pixCountPixels(pixt1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pixt1, IFF_PNG);
-#endif  /* DEBUG */
+        /* Paint the runs of each c.c. into its image */
+    for (y = 0; y < runs->nlines; y++) {
+        for (k = runs->linestart[y]; k < runs->linestart[y + 1]; k++) {
+            n = runs->parent[k];
+            line = dataa[n] + (y - ya[n]) * wpla[n];
+            x0 = runs->xstart[k] - xa[n];
+            x1 = runs->xend[k] - xa[n];
+            word = line + (x0 >> 5);
+            if ((x0 >> 5) == (x1 >> 5)) {
+                *word |= (0xffffffff >> (x0 & 31)) &
+                         (0xffffffff << (31 - (x1 & 31)));
+            } else {
+                *word++ |= 0xffffffff >> (x0 & 31);
+                for (j = (x0 >> 5) + 1; j < (x1 >> 5); j++)
+                    *word++ = 0xffffffff;
+                *word |= 0xffffffff << (31 - (x1 & 31));
+            }
+        }
+    }
 
         /* Remove old boxa of pixa and replace with a clone copy */
     boxaDestroy(&pixa->boxa);
     pixa->boxa = boxaCopy(boxa, L_CLONE);
 
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
-
+    LEPT_FREE(dataa);
+    LEPT_FREE(wpla);
+    LEPT_FREE(xa);
+    LEPT_FREE(ya);
+    ccRunsDestroy(&runs);
     return boxa;
 }
 
@@ -276,20 +352,19 @@ L_STACK  *stack, *auxstack;
  * Notes:
  *     (1) Finds bounding boxes of 4- or 8-connected components
  *         in a binary image.
- *     (2) This works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.  In the process,
- *         the b.b. is computed and saved.
+ *     (2) The c.c. are labeled using union-find on the runs of the
+ *         image; the input pix is not altered.  The boxes are in the
+ *         order in which the c.c. are first reached by a raster scan.
+ *     (3) The labeling is done on strips in parallel when more than
+ *         one thread is set with l_setParallelThreads().
  */
 BOXA *
 pixConnCompBB(PIX     *pixs,
               l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pixt;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32  ncc, iszero;
+BOXA    *boxa;
+CCRUNS  *runs;
 
     PROCNAME("pixConnCompBB");
 
@@ -302,43 +377,12 @@ L_STACK  *stack, *auxstack;
     if (iszero)
         return boxaCreate(1);  /* return empty boxa */
 
-    if ((pixt = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pixt not made", procName, NULL);
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL)
-        return (BOXA *)ERROR_PTR("stack not made", procName, NULL);
-    if ((auxstack = lstackCreate(0)) == NULL)
-        return (BOXA *)ERROR_PTR("auxstack not made", procName, NULL);
-    stack->auxstack = auxstack;
-    if ((boxa = boxaCreate(0)) == NULL)
+    if ((runs = pixLabelRuns(pixs, connectivity, &ncc)) == NULL)
+        return (BOXA *)ERROR_PTR("runs not made", procName, NULL);
+    boxa = ccRunsMakeBoxa(runs, ncc);
+    ccRunsDestroy(&runs);
+    if (!boxa)
         return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
-
-    xstart = 0;
-    ystart = 0;
-    while (1)
-    {
-        if (!nextOnPixelInRaster(pixt, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pixt, stack, x, y, connectivity)) == NULL)
-            return (BOXA *)ERROR_PTR("box not made", procName, NULL);
-        boxaAddBox(boxa, box, L_INSERT);
-
-        xstart = x;
-        ystart = y;
-    }
-
-#if  DEBUG
-    pixCountPixels(pixt, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pixt1, IFF_PNG);
-#endif  /* DEBUG */
-
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pixt);
-
     return boxa;
 }
 
@@ -354,18 +398,16 @@ L_STACK  *stack, *auxstack;
  * Notes:
  *     (1) This is the top-level call for getting the number of
  *         4- or 8-connected components in a 1 bpp image.
- *     (2) It works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.
+ *     (2) The c.c. are labeled using union-find on the runs of the
+ *         image, as in pixConnCompBB().
  */
 l_int32
 pixCountConnComp(PIX      *pixs,
                  l_int32   connectivity,
                  l_int32  *pcount)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pixt;
-L_STACK  *stack, *auxstack;
+l_int32  iszero;
+CCRUNS  *runs;
 
     PROCNAME("pixCountConnComp");
 
@@ -381,33 +423,9 @@ L_STACK  *stack, *auxstack;
     if (iszero)
         return 0;
 
-    if ((pixt = pixCopy(NULL, pixs)) == NULL)
-        return ERROR_INT("pixt not made", procName, 1);
-
-    h = pixGetDepth(pixs);
-    if ((stack = lstackCreate(h)) == NULL)
-        return ERROR_INT("stack not made", procName, 1);
-    if ((auxstack = lstackCreate(0)) == NULL)
-        return ERROR_INT("auxstack not made", procName, 1);
-    stack->auxstack = auxstack;
-
-    xstart = 0;
-    ystart = 0;
-    while (1)
-    {
-        if (!nextOnPixelInRaster(pixt, xstart, ystart, &x, &y))
-            break;
-
-        pixSeedfill(pixt, stack, x, y, connectivity);
-        (*pcount)++;
-        xstart = x;
-        ystart = y;
-    }
-
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pixt);
-
+    if ((runs = pixLabelRuns(pixs, connectivity, pcount)) == NULL)
+        return ERROR_INT("runs not made", procName, 1);
+    ccRunsDestroy(&runs);
     return 0;
 }
 
@@ -1197,3 +1215,423 @@ L_STACK  *auxstack;
     lstackAdd(auxstack, fseg);
     return;
 }
+
+
+/*-----------------------------------------------------------------------*
+ *                 Union-find labeling of runs of ON pixels              *
+ *-----------------------------------------------------------------------*/
+/*!
+ *  pixLabelRuns()
+ *
+ *      Input:  pixs (1 bpp)
+ *              connectivity (4 or 8)
+ *              &ncc (<return> number of c.c.)
+ *      Return: runs, with the index of the c.c. of each run in the
+ *              parent array, or null on error
+ *
+ *  Notes:
+ *      (1) The image is divided into horizontal strips, one for each
+ *          thread, and the runs in each strip are labeled.  The strips
+ *          are then joined in order, merging the sets of runs that
+ *          touch across each boundary.
+ *      (2) The parent of each run is never later than the run, and the
+ *          root of each set is its earliest run.  Therefore the sets
+ *          can be numbered in raster order in a single pass.
+ */
+static CCRUNS *
+pixLabelRuns(PIX      *pixs,
+             l_int32   connectivity,
+             l_int32  *pncc)
+{
+l_int32           i, j, h, n, ns, nstrips, nthreads, offset, ncc, p;
+l_int32          *parent;
+CCRUNS           *runs, *strip;
+CCRUNS          **strips;
+CC_STRIP_PARAMS   params;
+
+    PROCNAME("pixLabelRuns");
+
+    *pncc = 0;
+    h = pixGetHeight(pixs);
+    nthreads = l_getParallelThreads();
+    nstrips = L_MAX(1, L_MIN(nthreads, h / MinStripHeight));
+    if ((strips = (CCRUNS **)LEPT_CALLOC(nstrips, sizeof(CCRUNS *))) == NULL)
+        return (CCRUNS *)ERROR_PTR("strips not made", procName, NULL);
+    params.pixs = pixs;
+    params.connectivity = connectivity;
+    params.nstrips = nstrips;
+    params.tab = makeMSBitLocTab(1);
+    params.strips = strips;
+    if (!params.tab ||
+        l_parallelRun(nstrips, nstrips, labelRunsStrip, &params)) {
+        for (i = 0; i < nstrips; i++)
+            ccRunsDestroy(&strips[i]);
+        LEPT_FREE(strips);
+        LEPT_FREE(params.tab);
+        return (CCRUNS *)ERROR_PTR("runs not labeled", procName, NULL);
+    }
+    LEPT_FREE(params.tab);
+
+        /* Join the strips */
+    if (nstrips == 1) {
+        runs = strips[0];
+    } else {
+        for (i = 0, n = 0; i < nstrips; i++)
+            n += strips[i]->n;
+        if ((runs = ccRunsCreate(0, h, n)) == NULL) {
+            for (i = 0; i < nstrips; i++)
+                ccRunsDestroy(&strips[i]);
+            LEPT_FREE(strips);
+            return (CCRUNS *)ERROR_PTR("runs not made", procName, NULL);
+        }
+        for (i = 0, offset = 0; i < nstrips; i++) {
+            strip = strips[i];
+            ns = strip->n;
+            memcpy(runs->xstart + offset, strip->xstart, ns * sizeof(l_int32));
+            memcpy(runs->xend + offset, strip->xend, ns * sizeof(l_int32));
+            for (j = 0; j < ns; j++)
+                runs->parent[offset + j] = offset + strip->parent[j];
+            for (j = 0; j < strip->nlines; j++)
+                runs->linestart[strip->y0 + j] = offset + strip->linestart[j];
+            offset += ns;
+            ccRunsDestroy(&strips[i]);
+        }
+        runs->n = n;
+        runs->linestart[h] = n;
+        for (i = 1; i < nstrips; i++) {
+            j = h * i / nstrips;  /* first line of strip i */
+            unionRunsOnLines(runs, runs->linestart[j - 1], runs->linestart[j],
+                             runs->linestart[j], runs->linestart[j + 1],
+                             (connectivity == 8) ? 1 : 0);
+        }
+    }
+    LEPT_FREE(strips);
+
+        /* Number the sets in order of their roots */
+    parent = runs->parent;
+    for (i = 0, ncc = 0; i < runs->n; i++) {
+        p = parent[i];
+        if (p == i)
+            parent[i] = ncc++;
+        else  /* p < i, so it has already been given its c.c. */
+            parent[i] = parent[p];
+    }
+    *pncc = ncc;
+    return runs;
+}
+
+
+/*!
+ *  labelRunsStrip()
+ *
+ *      Input:  data (CC_STRIP_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This finds the runs on the lines of one strip, and joins
+ *          each run with those on the previous line that it touches.
+ */
+static l_int32
+labelRunsStrip(void     *data,
+               l_int32   index)
+{
+l_int32           w, h, wpl, y, y0, y1, start1, start2;
+l_uint32         *line;
+CCRUNS           *runs;
+CC_STRIP_PARAMS  *params;
+
+    params = (CC_STRIP_PARAMS *)data;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    wpl = pixGetWpl(params->pixs);
+    y0 = h * index / params->nstrips;
+    y1 = h * (index + 1) / params->nstrips;
+    if ((runs = ccRunsCreate(y0, y1 - y0, 4 * (y1 - y0))) == NULL)
+        return 1;
+    params->strips[index] = runs;
+
+    line = pixGetData(params->pixs) + y0 * wpl;
+    start1 = 0;
+    for (y = 0; y < y1 - y0; y++, line += wpl) {
+        start2 = runs->n;
+        runs->linestart[y] = start2;
+        if (findRunsOnLine(line, w, params->tab, runs))
+            return 1;
+        if (y > 0)
+            unionRunsOnLines(runs, start1, start2, start2, runs->n,
+                             (params->connectivity == 8) ? 1 : 0);
+        start1 = start2;
+    }
+    runs->linestart[y1 - y0] = runs->n;
+    return 0;
+}
+
+
+/*!
+ *  findRunsOnLine()
+ *
+ *      Input:  line (of 1 bpp image)
+ *              w (width of image)
+ *              tab (MS bit location of ON pixel in a byte)
+ *              runs (the runs are added to this, each as its own set)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The words are searched for the next transition, looking
+ *          for an ON pixel outside a run and for an OFF pixel inside
+ *          a run.  Runs of 0 or ~0 words are skipped quickly.
+ *      (2) The pad bits of the last word are ignored.
+ */
+static l_int32
+findRunsOnLine(l_uint32  *line,
+               l_int32    w,
+               l_int32   *tab,
+               CCRUNS    *runs)
+{
+l_int32   j, nwords, pos, inrun, xstart;
+l_uint32  word, val;
+
+    nwords = (w + 31) / 32;
+    inrun = FALSE;
+    xstart = 0;
+    for (j = 0; j < nwords; j++) {
+        word = line[j];
+        if (j == nwords - 1 && (w & 31))
+            word &= 0xffffffff << (32 - (w & 31));
+        pos = 0;
+        while (1) {
+                /* The first transition at or after pos */
+            val = (inrun) ? ~word : word;
+            if (pos > 0)
+                val &= 0xffffffff >> pos;
+            if (!val)
+                break;
+            if (val >> 24)
+                pos = tab[val >> 24];
+            else if (val >> 16)
+                pos = 8 + tab[val >> 16];
+            else if (val >> 8)
+                pos = 16 + tab[val >> 8];
+            else
+                pos = 24 + tab[val];
+            if (inrun) {
+                if (ccRunsAdd(runs, xstart, 32 * j + pos - 1))
+                    return 1;
+            } else {
+                xstart = 32 * j + pos;
+            }
+            inrun = !inrun;
+        }
+    }
+    if (inrun && ccRunsAdd(runs, xstart, w - 1))
+        return 1;
+    return 0;
+}
+
+
+/*!
+ *  unionRunsOnLines()
+ *
+ *      Input:  runs
+ *              start1, end1 (range of runs on the upper line)
+ *              start2, end2 (range of runs on the lower line)
+ *              dist (1 for 8-connectivity; 0 for 4-connectivity)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Two runs on adjacent lines touch if their x ranges overlap
+ *          after one of them is extended by @dist on each side.
+ *      (2) The sets of touching runs are joined.  The root of the
+ *          joined set is the earlier of the two roots.  Paths are
+ *          halved as they are followed.
+ */
+static void
+unionRunsOnLines(CCRUNS   *runs,
+                 l_int32   start1,
+                 l_int32   end1,
+                 l_int32   start2,
+                 l_int32   end2,
+                 l_int32   dist)
+{
+l_int32   i, j, k, r1, r2;
+l_int32  *xs, *xe, *parent;
+
+    xs = runs->xstart;
+    xe = runs->xend;
+    parent = runs->parent;
+    i = start1;
+    for (j = start2; j < end2; j++) {
+        while (i < end1 && xe[i] + dist < xs[j])
+            i++;
+        for (k = i; k < end1 && xs[k] <= xe[j] + dist; k++) {
+            r1 = k;
+            while (parent[r1] != r1) {
+                parent[r1] = parent[parent[r1]];
+                r1 = parent[r1];
+            }
+            r2 = j;
+            while (parent[r2] != r2) {
+                parent[r2] = parent[parent[r2]];
+                r2 = parent[r2];
+            }
+            if (r1 < r2)
+                parent[r2] = r1;
+            else if (r2 < r1)
+                parent[r1] = r2;
+        }
+    }
+    return;
+}
+
+
+/*!
+ *  ccRunsMakeBoxa()
+ *
+ *      Input:  runs (with the index of the c.c. of each run)
+ *              ncc (number of c.c.)
+ *      Return: boxa (of the c.c., in order), or null on error
+ */
+static BOXA *
+ccRunsMakeBoxa(CCRUNS   *runs,
+               l_int32   ncc)
+{
+l_int32   i, k, n, y;
+l_int32  *xmin, *ymin, *xmax, *ymax;
+BOXA     *boxa;
+
+    PROCNAME("ccRunsMakeBoxa");
+
+    xmin = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    ymin = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    xmax = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    ymax = (l_int32 *)LEPT_CALLOC(ncc, sizeof(l_int32));
+    boxa = boxaCreate(ncc);
+    if (!xmin || !ymin || !xmax || !ymax || !boxa) {
+        boxaDestroy(&boxa);
+        boxa = (BOXA *)ERROR_PTR("arrays not made", procName, NULL);
+    } else {
+        for (i = 0; i < ncc; i++) {
+            xmin[i] = ymin[i] = 0x7fffffff;
+            xmax[i] = ymax[i] = -1;
+        }
+        for (y = 0; y < runs->nlines; y++) {
+            for (k = runs->linestart[y]; k < runs->linestart[y + 1]; k++) {
+                n = runs->parent[k];
+                if (y < ymin[n]) ymin[n] = y;
+                ymax[n] = y;  /* lines are in order */
+                if (runs->xstart[k] < xmin[n]) xmin[n] = runs->xstart[k];
+                if (runs->xend[k] > xmax[n]) xmax[n] = runs->xend[k];
+            }
+        }
+        for (i = 0; i < ncc; i++) {
+            boxaAddBox(boxa, boxCreate(xmin[i], ymin[i], xmax[i] - xmin[i] + 1,
+                                       ymax[i] - ymin[i] + 1), L_INSERT);
+        }
+    }
+
+    LEPT_FREE(xmin);
+    LEPT_FREE(ymin);
+    LEPT_FREE(xmax);
+    LEPT_FREE(ymax);
+    return boxa;
+}
+
+
+/*!
+ *  ccRunsCreate()
+ *
+ *      Input:  y0 (first line)
+ *              nlines (number of lines)
+ *              nalloc (initial size of run arrays)
+ *      Return: runs, or null on error
+ */
+static CCRUNS *
+ccRunsCreate(l_int32  y0,
+             l_int32  nlines,
+             l_int32  nalloc)
+{
+CCRUNS  *runs;
+
+    PROCNAME("ccRunsCreate");
+
+    if ((runs = (CCRUNS *)LEPT_CALLOC(1, sizeof(CCRUNS))) == NULL)
+        return (CCRUNS *)ERROR_PTR("runs not made", procName, NULL);
+    nalloc = L_MAX(nalloc, 64);
+    runs->y0 = y0;
+    runs->nlines = nlines;
+    runs->nalloc = nalloc;
+    runs->xstart = (l_int32 *)LEPT_CALLOC(nalloc, sizeof(l_int32));
+    runs->xend = (l_int32 *)LEPT_CALLOC(nalloc, sizeof(l_int32));
+    runs->parent = (l_int32 *)LEPT_CALLOC(nalloc, sizeof(l_int32));
+    runs->linestart = (l_int32 *)LEPT_CALLOC(nlines + 1, sizeof(l_int32));
+    if (!runs->xstart || !runs->xend || !runs->parent || !runs->linestart) {
+        ccRunsDestroy(&runs);
+        return (CCRUNS *)ERROR_PTR("run arrays not made", procName, NULL);
+    }
+    return runs;
+}
+
+
+/*!
+ *  ccRunsDestroy()
+ *
+ *      Input:  &runs (<will be set to null before returning>)
+ *      Return: void
+ */
+static void
+ccRunsDestroy(CCRUNS  **pruns)
+{
+CCRUNS  *runs;
+
+    if (!pruns || (runs = *pruns) == NULL)
+        return;
+    LEPT_FREE(runs->xstart);
+    LEPT_FREE(runs->xend);
+    LEPT_FREE(runs->parent);
+    LEPT_FREE(runs->linestart);
+    LEPT_FREE(runs);
+    *pruns = NULL;
+    return;
+}
+
+
+/*!
+ *  ccRunsAdd()
+ *
+ *      Input:  runs
+ *              xstart, xend (first and last pixel of the run)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The new run is the root of its own set.
+ */
+static l_int32
+ccRunsAdd(CCRUNS   *runs,
+          l_int32   xstart,
+          l_int32   xend)
+{
+l_int32  n, oldsize;
+
+    PROCNAME("ccRunsAdd");
+
+    n = runs->n;
+    if (n >= runs->nalloc) {
+        oldsize = runs->nalloc * sizeof(l_int32);
+        if ((runs->xstart = (l_int32 *)reallocNew((void **)&runs->xstart,
+                                                  oldsize, 2 * oldsize))
+            == NULL ||
+            (runs->xend = (l_int32 *)reallocNew((void **)&runs->xend,
+                                                oldsize, 2 * oldsize))
+            == NULL ||
+            (runs->parent = (l_int32 *)reallocNew((void **)&runs->parent,
+                                                  oldsize, 2 * oldsize))
+            == NULL)
+            return ERROR_INT("run arrays not extended", procName, 1);
+        runs->nalloc *= 2;
+    }
+    runs->xstart[n] = xstart;
+    runs->xend[n] = xend;
+    runs->parent[n] = n;
+    runs->n++;
+    return 0;
+}
@@ -43,6 +43,7 @@
  *
  *      Tiled grayscale or color block convolution
  *          PIX          *pixBlockconvTiled()
+ *          static PIX   *blockconvTile()
  *          PIX          *pixBlockconvGrayTile()
  *
  *      Convolution for mean, mean square, variance and rms deviation
@@ -71,19 +72,33 @@
  *          FPIX         *fpixConvolve()
  *          FPIX         *fpixConvolveSep()
  *
+ *      Generic convolution on bands of lines
+ *          static PIX       *pixConvolveLow()
+ *          static FPIX      *fpixConvolveLow()
+ *          static l_int32    convolveBands()
+ *          static l_int32    convolveBand()
+ *          static void       convolveGetRow()
+ *          static void       convolveLine()
+ *          static void       convolveSetLine()
+ *          static l_int32    convolveLineSse2()
+ *          static l_int32    convolveLineAvx2()
+ *
  *      Convolution with bias (for non-negative output)
  *          PIX          *pixConvolveWithBias()
  *
- *      Set parameter for convolution subsampling
+ *      Set parameters for generic convolution
  *          void          l_setConvolveSampling()
+ *          void          l_setConvolveSeparable()
  *
  *      Additive gaussian noise
  *          PIX          *pixAddGaussNoise()
  *          l_float32     gaussDistribSampling()
  */
 
+#include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#include "simd.h"
 
     /* These globals determine the subsampling factors for
      * generic convolution of pix and fpix.  Declare extern to use.
@@ -91,6 +106,37 @@
 LEPT_DLL l_int32  ConvolveSamplingFactX = 1;
 LEPT_DLL l_int32  ConvolveSamplingFactY = 1;
 
+    /* Call l_setConvolveSeparable() to change this */
+static l_int32  var_CONVOLVE_SEPARABLE = 0;
+
+    /* Smallest band of output lines given to a thread */
+static const l_int32  MinConvolveBandHeight = 16;
+
+    /* Parameters for generic convolution of each band of output lines */
+struct ConvolveParams
+{
+    l_uint32    *datas;       /* pix source; null for fpix                 */
+    l_float32   *fdatas;      /* fpix source; null for pix                 */
+    l_int32      w;           /* source size                               */
+    l_int32      h;
+    l_int32      d;           /* source depth: 8, 16 or 32; 0 for fpix     */
+    l_int32      wpls;
+    L_KERNEL    *kel1;        /* inverted kernel; the row kernel if kel2   */
+    L_KERNEL    *kel2;        /* inverted column kernel; null for 1 pass   */
+    l_int32      roundmid;    /* round the row pass, as for 32 bpp output  */
+    l_int32      xfact;       /* subsampling factors                       */
+    l_int32      yfact;
+    l_uint32    *datad;       /* pix dest; null for fpix                   */
+    l_float32   *fdatad;      /* fpix dest; null for pix                   */
+    l_int32      wd;          /* dest size                                 */
+    l_int32      hd;
+    l_int32      outdepth;    /* dest depth: 8, 16 or 32; 0 for fpix       */
+    l_int32      wpld;
+    l_int32      nbands;      /* number of bands                           */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct ConvolveParams  CONVOLVE_PARAMS;
+
     /* Low-level static functions */
 static void blockconvLow(l_uint32 *data, l_int32 w, l_int32 h, l_int32 wpl,
                          l_uint32 *dataa, l_int32 wpla, l_int32 wc,
@@ -101,6 +147,42 @@ static void blockconvAccumLow(l_uint32 *datad, l_int32 w, l_int32 h,
 static void blocksumLow(l_uint32 *datad, l_int32 w, l_int32 h, l_int32 wpl,
                         l_uint32 *dataa, l_int32 wpla, l_int32 wc, l_int32 hc);
 
+    /* Static functions for generic convolution on bands of lines */
+static PIX *pixConvolveLow(PIX *pixs, L_KERNEL *kel1, L_KERNEL *kel2,
+                           l_int32 roundmid, l_int32 outdepth,
+                           l_int32 xfact, l_int32 yfact);
+static FPIX *fpixConvolveLow(FPIX *fpixs, L_KERNEL *kel1, L_KERNEL *kel2,
+                             l_int32 xfact, l_int32 yfact);
+static l_int32 convolveBands(CONVOLVE_PARAMS *params);
+static l_int32 convolveBand(void *data, l_int32 index);
+static void convolveGetRow(CONVOLVE_PARAMS *params, l_int32 y,
+                           l_float32 *row, l_int32 wt, l_int32 cx);
+static void convolveLine(l_float32 *lined, l_float32 **rows, l_int32 sy,
+                         l_int32 sx, l_float32 **kdata, l_int32 n,
+                         l_int32 xfact, l_int32 simd);
+static void convolveSetLine(CONVOLVE_PARAMS *params, l_int32 id,
+                            l_float32 *line);
+#if L_HAVE_SSE2
+static l_int32 convolveLineSse2(l_float32 *lined, l_float32 **rows,
+                                l_int32 sy, l_int32 sx, l_float32 **kdata,
+                                l_int32 n);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 convolveLineAvx2(l_float32 *lined, l_float32 **rows,
+                                l_int32 sy, l_int32 sx, l_float32 **kdata,
+                                l_int32 n) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+
+    /* Input to the tile function in pixBlockconvTiled() */
+struct BlockconvTileParams
+{
+    l_int32     wc;
+    l_int32     hc;
+};
+typedef struct BlockconvTileParams  BLOCKCONV_TILE_PARAMS;
+
+static PIX *blockconvTile(PIX *pixt, l_int32 i, l_int32 j, void *data);
+
 
 /*----------------------------------------------------------------------*
  *             Top-level grayscale or color block convolution           *
@@ -708,6 +790,9 @@ PIX       *pixsb, *pixacc, *pixd;
  *              tiles reduces the size of this array.
  *          (c) Each tile can be processed independently, in parallel,
  *              on a multicore processor.
+ *      (7) The tiles are processed on the number of threads set by
+ *          l_setParallelThreads().  The result does not depend on
+ *          the number of threads.
  */
 PIX *
 pixBlockconvTiled(PIX     *pix,
@@ -716,10 +801,10 @@ pixBlockconvTiled(PIX     *pix,
                   l_int32  nx,
                   l_int32  ny)
 {
-l_int32     i, j, w, h, d, xrat, yrat;
-PIX        *pixs, *pixd, *pixc, *pixt;
-PIX        *pixr, *pixrc, *pixg, *pixgc, *pixb, *pixbc;
-PIXTILING  *pt;
+l_int32                 w, h, d, xrat, yrat, ret;
+PIX                    *pixs, *pixd;
+PIXTILING              *pt;
+BLOCKCONV_TILE_PARAMS   params;
 
     PROCNAME("pixBlockconvTiled");
 
@@ -779,37 +864,57 @@ PIXTILING  *pt;
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     }
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, wc + 2, hc + 2);
-    for (i = 0; i < ny; i++) {
-        for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-
-                /* Convolve over the tile */
-            if (d == 8) {
-                pixc = pixBlockconvGrayTile(pixt, NULL, wc, hc);
-            } else { /* d == 32 */
-                pixr = pixGetRGBComponent(pixt, COLOR_RED);
-                pixrc = pixBlockconvGrayTile(pixr, NULL, wc, hc);
-                pixDestroy(&pixr);
-                pixg = pixGetRGBComponent(pixt, COLOR_GREEN);
-                pixgc = pixBlockconvGrayTile(pixg, NULL, wc, hc);
-                pixDestroy(&pixg);
-                pixb = pixGetRGBComponent(pixt, COLOR_BLUE);
-                pixbc = pixBlockconvGrayTile(pixb, NULL, wc, hc);
-                pixDestroy(&pixb);
-                pixc = pixCreateRGBImage(pixrc, pixgc, pixbc);
-                pixDestroy(&pixrc);
-                pixDestroy(&pixgc);
-                pixDestroy(&pixbc);
-            }
-
-            pixTilingPaintTile(pixd, i, j, pixc, pt);
-            pixDestroy(&pixt);
-            pixDestroy(&pixc);
-        }
-    }
-
+    params.wc = wc;
+    params.hc = hc;
+    ret = pixTilingProcess(pt, pixd, blockconvTile, &params, 0);
     pixDestroy(&pixs);
     pixTilingDestroy(&pt);
+    if (ret) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("tiles not all convolved", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*!
+ *  blockconvTile()
+ *
+ *      Input:  pixt (8 or 32 bpp tile, with overlap)
+ *              i, j (tile row and column; not used)
+ *              data (BLOCKCONV_TILE_PARAMS)
+ *      Return: pixd (convolved tile, same size as pixt), or null on error
+ */
+static PIX *
+blockconvTile(PIX     *pixt,
+              l_int32  i,
+              l_int32  j,
+              void    *data)
+{
+l_int32                 wc, hc;
+PIX                    *pixd, *pixr, *pixrc, *pixg, *pixgc, *pixb, *pixbc;
+BLOCKCONV_TILE_PARAMS  *params;
+
+    params = (BLOCKCONV_TILE_PARAMS *)data;
+    wc = params->wc;
+    hc = params->hc;
+    if (pixGetDepth(pixt) == 8)
+        return pixBlockconvGrayTile(pixt, NULL, wc, hc);
+
+        /* d == 32 */
+    pixr = pixGetRGBComponent(pixt, COLOR_RED);
+    pixrc = pixBlockconvGrayTile(pixr, NULL, wc, hc);
+    pixDestroy(&pixr);
+    pixg = pixGetRGBComponent(pixt, COLOR_GREEN);
+    pixgc = pixBlockconvGrayTile(pixg, NULL, wc, hc);
+    pixDestroy(&pixg);
+    pixb = pixGetRGBComponent(pixt, COLOR_BLUE);
+    pixbc = pixBlockconvGrayTile(pixb, NULL, wc, hc);
+    pixDestroy(&pixb);
+    pixd = pixCreateRGBImage(pixrc, pixgc, pixbc);
+    pixDestroy(&pixrc);
+    pixDestroy(&pixgc);
+    pixDestroy(&pixbc);
     return pixd;
 }
 
@@ -1814,10 +1919,14 @@ PIX       *pixav, *pixd;
  *      (7) To get a subsampled output, call l_setConvolveSampling().
  *          The time to make a subsampled output is reduced by the
  *          product of the sampling factors.
- *      (8) The function is slow, running at about 12 machine cycles for
- *          each pixel-op in the convolution.  For example, with a 3 GHz
- *          cpu, a 1 Mpixel grayscale image, and a kernel with
- *          (sx * sy) = 25 elements, the convolution takes about 100 msec.
+ *      (8) The time is proportional to (sx * sy) for each output pixel.
+ *          The image is divided into bands of lines that are convolved
+ *          in parallel (see l_setParallelThreads()), and the sums are
+ *          made for several pixels at once with SSE2 or AVX2 if
+ *          available.  The result does not depend on either.
+ *      (9) If the kernel is separable, it is faster to use
+ *          pixConvolveSep().  To have separable kernels found and
+ *          used here, call l_setConvolveSeparable().
  */
 PIX *
 pixConvolve(PIX       *pixs,
@@ -1825,12 +1934,9 @@ pixConvolve(PIX       *pixs,
             l_int32    outdepth,
             l_int32    normflag)
 {
-l_int32    i, j, id, jd, k, m, w, h, d, wd, hd, sx, sy, cx, cy, wplt, wpld;
-l_int32    val;
-l_uint32  *datat, *datad, *linet, *lined;
-l_float32  sum;
-L_KERNEL  *keli, *keln;
-PIX       *pixt, *pixd;
+l_int32    w, h, d, sx, sy;
+L_KERNEL  *keli, *keln, *kelx, *kely;
+PIX       *pixd;
 
     PROCNAME("pixConvolve");
 
@@ -1845,58 +1951,28 @@ PIX       *pixt, *pixd;
         return (PIX *)ERROR_PTR("kel not defined", procName, NULL);
 
     keli = kernelInvert(kel);
-    kernelGetParameters(keli, &sy, &sx, &cy, &cx);
+    kernelGetParameters(keli, &sy, &sx, NULL, NULL);
     if (normflag)
         keln = kernelNormalize(keli, 1.0);
     else
         keln = kernelCopy(keli);
 
-    if ((pixt = pixAddMirroredBorder(pixs, cx, sx - cx, cy, sy - cy)) == NULL)
-        return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
-
-    wd = (w + ConvolveSamplingFactX - 1) / ConvolveSamplingFactX;
-    hd = (h + ConvolveSamplingFactY - 1) / ConvolveSamplingFactY;
-    pixd = pixCreate(wd, hd, outdepth);
-    datat = pixGetData(pixt);
-    datad = pixGetData(pixd);
-    wplt = pixGetWpl(pixt);
-    wpld = pixGetWpl(pixd);
-    for (i = 0, id = 0; id < hd; i += ConvolveSamplingFactY, id++) {
-        lined = datad + id * wpld;
-        for (j = 0, jd = 0; jd < wd; j += ConvolveSamplingFactX, jd++) {
-            sum = 0.0;
-            for (k = 0; k < sy; k++) {
-                linet = datat + (i + k) * wplt;
-                if (d == 8) {
-                    for (m = 0; m < sx; m++) {
-                        val = GET_DATA_BYTE(linet, j + m);
-                        sum += val * keln->data[k][m];
-                    }
-                } else if (d == 16) {
-                    for (m = 0; m < sx; m++) {
-                        val = GET_DATA_TWO_BYTES(linet, j + m);
-                        sum += val * keln->data[k][m];
-                    }
-                } else {  /* d == 32 */
-                    for (m = 0; m < sx; m++) {
-                        val = *(linet + j + m);
-                        sum += val * keln->data[k][m];
-                    }
-                }
-            }
-            if (sum < 0.0) sum = -sum;  /* make it non-negative */
-            if (outdepth == 8)
-                SET_DATA_BYTE(lined, jd, (l_int32)(sum + 0.5));
-            else if (outdepth == 16)
-                SET_DATA_TWO_BYTES(lined, jd, (l_int32)(sum + 0.5));
-            else  /* outdepth == 32 */
-                *(lined + jd) = (l_uint32)(sum + 0.5);
-        }
-    }
+    kelx = kely = NULL;
+    if (var_CONVOLVE_SEPARABLE && sx > 1 && sy > 1)
+        kernelGetSeparable(keln, &kelx, &kely);
+    if (kelx)
+        pixd = pixConvolveLow(pixs, kelx, kely, 0, outdepth,
+                              ConvolveSamplingFactX, ConvolveSamplingFactY);
+    else
+        pixd = pixConvolveLow(pixs, keln, NULL, 0, outdepth,
+                              ConvolveSamplingFactX, ConvolveSamplingFactY);
 
     kernelDestroy(&keli);
     kernelDestroy(&keln);
-    pixDestroy(&pixt);
+    kernelDestroy(&kelx);
+    kernelDestroy(&kely);
+    if (!pixd)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     return pixd;
 }
 
@@ -1941,6 +2017,11 @@ PIX       *pixt, *pixd;
  *          convolution.
  *      (6) This uses mirrored borders to avoid special casing on
  *          the boundaries.
+ *      (7) For a row kernel @kelx and a column kernel @kely, both
+ *          convolutions are done on each band of lines, keeping only
+ *          the few rows of the first convolution that are needed by
+ *          the second.  The result is the same as with the two
+ *          convolutions done in sequence on the full image.
  */
 PIX *
 pixConvolveSep(PIX       *pixs,
@@ -1949,8 +2030,8 @@ pixConvolveSep(PIX       *pixs,
                l_int32    outdepth,
                l_int32    normflag)
 {
-l_int32    d, xfact, yfact;
-L_KERNEL  *kelxn, *kelyn;
+l_int32    d, xfact, yfact, syx, sxy;
+L_KERNEL  *kelxn, *kelyn, *kelxi, *kelyi;
 PIX       *pixt, *pixd;
 
     PROCNAME("pixConvolveSep");
@@ -1970,22 +2051,34 @@ PIX       *pixt, *pixd;
     if (normflag) {
         kelxn = kernelNormalize(kelx, 1000.0);
         kelyn = kernelNormalize(kely, 0.001);
-        l_setConvolveSampling(xfact, 1);
-        pixt = pixConvolve(pixs, kelxn, 32, 0);
-        l_setConvolveSampling(1, yfact);
-        pixd = pixConvolve(pixt, kelyn, outdepth, 0);
-        l_setConvolveSampling(xfact, yfact);  /* restore */
-        kernelDestroy(&kelxn);
-        kernelDestroy(&kelyn);
     } else {  /* don't normalize */
-        l_setConvolveSampling(xfact, 1);
-        pixt = pixConvolve(pixs, kelx, 32, 0);
-        l_setConvolveSampling(1, yfact);
-        pixd = pixConvolve(pixt, kely, outdepth, 0);
-        l_setConvolveSampling(xfact, yfact);
+        kelxn = kernelCopy(kelx);
+        kelyn = kernelCopy(kely);
+    }
+    kelxi = kernelInvert(kelxn);
+    kelyi = kernelInvert(kelyn);
+    kernelGetParameters(kelxi, &syx, NULL, NULL, NULL);
+    kernelGetParameters(kelyi, NULL, &sxy, NULL, NULL);
+
+        /* A row kernel and a column kernel are done together on each
+         * band, without an intermediate image.  Otherwise, do the two
+         * convolutions in sequence. */
+    if (syx == 1 && sxy == 1) {
+        pixd = pixConvolveLow(pixs, kelxi, kelyi, 1, outdepth, xfact, yfact);
+    } else {
+        pixd = NULL;
+        if ((pixt = pixConvolveLow(pixs, kelxi, NULL, 0, 32, xfact, 1))
+            != NULL)
+            pixd = pixConvolveLow(pixt, kelyi, NULL, 0, outdepth, 1, yfact);
+        pixDestroy(&pixt);
     }
 
-    pixDestroy(&pixt);
+    kernelDestroy(&kelxn);
+    kernelDestroy(&kelyn);
+    kernelDestroy(&kelxi);
+    kernelDestroy(&kelyi);
+    if (!pixd)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     return pixd;
 }
 
@@ -2128,18 +2221,18 @@ PIX  *pixt, *pixr, *pixg, *pixb, *pixd;
  *          product of the sampling factors.
  *      (5) This uses a mirrored border to avoid special casing on
  *          the boundaries.
+ *      (6) As with pixConvolve(), this is done on bands of lines in
+ *          parallel, and separable kernels are used as such if
+ *          requested with l_setConvolveSeparable().
  */
 FPIX *
 fpixConvolve(FPIX      *fpixs,
              L_KERNEL  *kel,
              l_int32    normflag)
 {
-l_int32     i, j, id, jd, k, m, w, h, wd, hd, sx, sy, cx, cy, wplt, wpld;
-l_float32   val;
-l_float32  *datat, *datad, *linet, *lined;
-l_float32   sum;
-L_KERNEL   *keli, *keln;
-FPIX       *fpixt, *fpixd;
+l_int32    sx, sy;
+L_KERNEL  *keli, *keln, *kelx, *kely;
+FPIX      *fpixd;
 
     PROCNAME("fpixConvolve");
 
@@ -2149,42 +2242,28 @@ FPIX       *fpixt, *fpixd;
         return (FPIX *)ERROR_PTR("kel not defined", procName, NULL);
 
     keli = kernelInvert(kel);
-    kernelGetParameters(keli, &sy, &sx, &cy, &cx);
+    kernelGetParameters(keli, &sy, &sx, NULL, NULL);
     if (normflag)
         keln = kernelNormalize(keli, 1.0);
     else
         keln = kernelCopy(keli);
 
-    fpixGetDimensions(fpixs, &w, &h);
-    fpixt = fpixAddMirroredBorder(fpixs, cx, sx - cx, cy, sy - cy);
-    if (!fpixt)
-        return (FPIX *)ERROR_PTR("fpixt not made", procName, NULL);
-
-    wd = (w + ConvolveSamplingFactX - 1) / ConvolveSamplingFactX;
-    hd = (h + ConvolveSamplingFactY - 1) / ConvolveSamplingFactY;
-    fpixd = fpixCreate(wd, hd);
-    datat = fpixGetData(fpixt);
-    datad = fpixGetData(fpixd);
-    wplt = fpixGetWpl(fpixt);
-    wpld = fpixGetWpl(fpixd);
-    for (i = 0, id = 0; id < hd; i += ConvolveSamplingFactY, id++) {
-        lined = datad + id * wpld;
-        for (j = 0, jd = 0; jd < wd; j += ConvolveSamplingFactX, jd++) {
-            sum = 0.0;
-            for (k = 0; k < sy; k++) {
-                linet = datat + (i + k) * wplt;
-                for (m = 0; m < sx; m++) {
-                    val = *(linet + j + m);
-                    sum += val * keln->data[k][m];
-                }
-            }
-            *(lined + jd) = sum;
-        }
-    }
+    kelx = kely = NULL;
+    if (var_CONVOLVE_SEPARABLE && sx > 1 && sy > 1)
+        kernelGetSeparable(keln, &kelx, &kely);
+    if (kelx)
+        fpixd = fpixConvolveLow(fpixs, kelx, kely, ConvolveSamplingFactX,
+                                ConvolveSamplingFactY);
+    else
+        fpixd = fpixConvolveLow(fpixs, keln, NULL, ConvolveSamplingFactX,
+                                ConvolveSamplingFactY);
 
     kernelDestroy(&keli);
     kernelDestroy(&keln);
-    fpixDestroy(&fpixt);
+    kernelDestroy(&kelx);
+    kernelDestroy(&kely);
+    if (!fpixd)
+        return (FPIX *)ERROR_PTR("fpixd not made", procName, NULL);
     return fpixd;
 }
 
@@ -2215,6 +2294,8 @@ FPIX       *fpixt, *fpixd;
  *          convolution.
  *      (4) This uses mirrored borders to avoid special casing on
  *          the boundaries.
+ *      (5) As with pixConvolveSep(), there is no intermediate image
+ *          for a row kernel and a column kernel.
  */
 FPIX *
 fpixConvolveSep(FPIX      *fpixs,
@@ -2222,8 +2303,8 @@ fpixConvolveSep(FPIX      *fpixs,
                 L_KERNEL  *kely,
                 l_int32    normflag)
 {
-l_int32    xfact, yfact;
-L_KERNEL  *kelxn, *kelyn;
+l_int32    xfact, yfact, syx, sxy;
+L_KERNEL  *kelxn, *kelyn, *kelxi, *kelyi;
 FPIX      *fpixt, *fpixd;
 
     PROCNAME("fpixConvolveSep");
@@ -2240,26 +2321,562 @@ FPIX      *fpixt, *fpixd;
     if (normflag) {
         kelxn = kernelNormalize(kelx, 1.0);
         kelyn = kernelNormalize(kely, 1.0);
-        l_setConvolveSampling(xfact, 1);
-        fpixt = fpixConvolve(fpixs, kelxn, 0);
-        l_setConvolveSampling(1, yfact);
-        fpixd = fpixConvolve(fpixt, kelyn, 0);
-        l_setConvolveSampling(xfact, yfact);  /* restore */
-        kernelDestroy(&kelxn);
-        kernelDestroy(&kelyn);
     } else {  /* don't normalize */
-        l_setConvolveSampling(xfact, 1);
-        fpixt = fpixConvolve(fpixs, kelx, 0);
-        l_setConvolveSampling(1, yfact);
-        fpixd = fpixConvolve(fpixt, kely, 0);
-        l_setConvolveSampling(xfact, yfact);
+        kelxn = kernelCopy(kelx);
+        kelyn = kernelCopy(kely);
+    }
+    kelxi = kernelInvert(kelxn);
+    kelyi = kernelInvert(kelyn);
+    kernelGetParameters(kelxi, &syx, NULL, NULL, NULL);
+    kernelGetParameters(kelyi, NULL, &sxy, NULL, NULL);
+
+        /* As in pixConvolveSep() */
+    if (syx == 1 && sxy == 1) {
+        fpixd = fpixConvolveLow(fpixs, kelxi, kelyi, xfact, yfact);
+    } else {
+        fpixd = NULL;
+        if ((fpixt = fpixConvolveLow(fpixs, kelxi, NULL, xfact, 1)) != NULL)
+            fpixd = fpixConvolveLow(fpixt, kelyi, NULL, 1, yfact);
+        fpixDestroy(&fpixt);
     }
 
-    fpixDestroy(&fpixt);
+    kernelDestroy(&kelxn);
+    kernelDestroy(&kelyn);
+    kernelDestroy(&kelxi);
+    kernelDestroy(&kelyi);
+    if (!fpixd)
+        return (FPIX *)ERROR_PTR("fpixd not made", procName, NULL);
     return fpixd;
 }
 
 
+/*----------------------------------------------------------------------*
+ *                Generic convolution on bands of lines                 *
+ *----------------------------------------------------------------------*/
+/*!
+ *  pixConvolveLow()
+ *
+ *      Input:  pixs (8, 16 or 32 bpp; no colormap)
+ *              kel1 (inverted and normalized kernel; the row kernel
+ *                    if kel2 is defined)
+ *              kel2 (<optional> inverted and normalized column kernel)
+ *              roundmid (1 to round the results of the row pass as
+ *                        if they were stored in a 32 bpp pix)
+ *              outdepth (of pixd: 8, 16 or 32)
+ *              xfact, yfact (subsampling factors)
+ *      Return: pixd, or null on error
+ *
+ *  Notes:
+ *      (1) With one kernel, this is the convolution of pixConvolve().
+ *          With two, it gives exactly the same result as convolving
+ *          with kel1 to get a 32 bpp pix if roundmid == 1 (or an fpix
+ *          if roundmid == 0), and then convolving that with kel2.
+ */
+static PIX *
+pixConvolveLow(PIX       *pixs,
+               L_KERNEL  *kel1,
+               L_KERNEL  *kel2,
+               l_int32    roundmid,
+               l_int32    outdepth,
+               l_int32    xfact,
+               l_int32    yfact)
+{
+l_int32          w, h, d;
+PIX             *pixd;
+CONVOLVE_PARAMS  params;
+
+    PROCNAME("pixConvolveLow");
+
+    if (!kel1)
+        return (PIX *)ERROR_PTR("kel1 not defined", procName, NULL);
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    memset(&params, 0, sizeof(CONVOLVE_PARAMS));
+    params.datas = pixGetData(pixs);
+    params.w = w;
+    params.h = h;
+    params.d = d;
+    params.wpls = pixGetWpl(pixs);
+    params.kel1 = kel1;
+    params.kel2 = kel2;
+    params.roundmid = roundmid;
+    params.xfact = xfact;
+    params.yfact = yfact;
+    params.wd = (w + xfact - 1) / xfact;
+    params.hd = (h + yfact - 1) / yfact;
+    params.outdepth = outdepth;
+    if ((pixd = pixCreate(params.wd, params.hd, outdepth)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    params.datad = pixGetData(pixd);
+    params.wpld = pixGetWpl(pixd);
+    if (convolveBands(&params)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("convolution failed", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*!
+ *  fpixConvolveLow()
+ *
+ *      Input:  fpixs
+ *              kel1 (inverted and normalized kernel; the row kernel
+ *                    if kel2 is defined)
+ *              kel2 (<optional> inverted and normalized column kernel)
+ *              xfact, yfact (subsampling factors)
+ *      Return: fpixd, or null on error
+ */
+static FPIX *
+fpixConvolveLow(FPIX      *fpixs,
+                L_KERNEL  *kel1,
+                L_KERNEL  *kel2,
+                l_int32    xfact,
+                l_int32    yfact)
+{
+l_int32          w, h;
+FPIX            *fpixd;
+CONVOLVE_PARAMS  params;
+
+    PROCNAME("fpixConvolveLow");
+
+    if (!kel1)
+        return (FPIX *)ERROR_PTR("kel1 not defined", procName, NULL);
+
+    fpixGetDimensions(fpixs, &w, &h);
+    memset(&params, 0, sizeof(CONVOLVE_PARAMS));
+    params.fdatas = fpixGetData(fpixs);
+    params.w = w;
+    params.h = h;
+    params.wpls = fpixGetWpl(fpixs);
+    params.kel1 = kel1;
+    params.kel2 = kel2;
+    params.xfact = xfact;
+    params.yfact = yfact;
+    params.wd = (w + xfact - 1) / xfact;
+    params.hd = (h + yfact - 1) / yfact;
+    if ((fpixd = fpixCreate(params.wd, params.hd)) == NULL)
+        return (FPIX *)ERROR_PTR("fpixd not made", procName, NULL);
+    params.fdatad = fpixGetData(fpixd);
+    params.wpld = fpixGetWpl(fpixd);
+    if (convolveBands(&params)) {
+        fpixDestroy(&fpixd);
+        return (FPIX *)ERROR_PTR("convolution failed", procName, NULL);
+    }
+    return fpixd;
+}
+
+
+/*!
+ *  convolveBands()
+ *
+ *      Input:  params (CONVOLVE_PARAMS, with all but nbands and simd set)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The output is divided into one band of lines for each
+ *          thread, each with at least MinConvolveBandHeight lines,
+ *          and the bands are convolved in parallel.
+ *      (2) The image is not copied with a border.  Instead, the rows
+ *          used by each band are made with mirrored borders, just as
+ *          pixAddMirroredBorder() would give, and with the same limit
+ *          on the kernel size.
+ */
+static l_int32
+convolveBands(CONVOLVE_PARAMS  *params)
+{
+l_int32  sx, sy, cx, cy, nbands;
+
+    PROCNAME("convolveBands");
+
+    kernelGetParameters(params->kel1, &sy, &sx, &cy, &cx);
+    if (cx > params->w || sx - cx > params->w ||
+        cy > params->h || sy - cy > params->h)
+        return ERROR_INT("kernel too large for image", procName, 1);
+    if (params->kel2) {
+        kernelGetParameters(params->kel2, &sy, NULL, &cy, NULL);
+        if (sy - cy > params->h || cy > params->h)
+            return ERROR_INT("kernel too large for image", procName, 1);
+    }
+
+    nbands = L_MIN(l_getParallelThreads(), params->hd / MinConvolveBandHeight);
+    params->nbands = L_MAX(1, nbands);
+    params->simd = l_getSimdMode();
+    if (l_parallelRun(params->nbands, params->nbands, convolveBand, params))
+        return ERROR_INT("bands not convolved", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  convolveBand()
+ *
+ *      Input:  data (CONVOLVE_PARAMS)
+ *              index (of the band of output lines)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The rows used for each output line are kept in a ring of
+ *          buffers, with row y (relative to the image, before
+ *          mirroring) in buffer (y + c) % n, where c is the origin
+ *          of the kernel and n the number of its rows.  Each row is
+ *          thus made once in the band, unless the subsampling factor
+ *          is larger than n.
+ *      (2) For one kernel, the rows are source rows with mirrored
+ *          borders.  For a row kernel and a column kernel, they are the
+ *          results of the row pass, which are made from source rows
+ *          as they are needed, so there is no intermediate image.
+ */
+static l_int32
+convolveBand(void    *data,
+             l_int32  index)
+{
+l_int32           i, j, id, k, y, y0, y1, slot, sx, sy, cx, cy, sy2, cy2;
+l_int32           wt, wd, nrows, c, rowsize;
+l_int32          *tags;
+l_float32         sum;
+l_float32        *srcrow, *buf, *line;
+l_float32       **rows;
+CONVOLVE_PARAMS  *params;
+
+    PROCNAME("convolveBand");
+
+    params = (CONVOLVE_PARAMS *)data;
+    kernelGetParameters(params->kel1, &sy, &sx, &cy, &cx);
+    sy2 = cy2 = 0;
+    if (params->kel2)
+        kernelGetParameters(params->kel2, &sy2, NULL, &cy2, NULL);
+    wd = params->wd;
+    wt = (wd - 1) * params->xfact + sx;  /* source row with borders */
+    nrows = (params->kel2) ? sy2 : sy;
+    c = (params->kel2) ? cy2 : cy;
+    rowsize = (params->kel2) ? wd : wt;
+
+    srcrow = (l_float32 *)LEPT_CALLOC(wt, sizeof(l_float32));
+    buf = (l_float32 *)LEPT_CALLOC(nrows * rowsize, sizeof(l_float32));
+    line = (l_float32 *)LEPT_CALLOC(wd, sizeof(l_float32));
+    rows = (l_float32 **)LEPT_CALLOC(nrows, sizeof(l_float32 *));
+    tags = (l_int32 *)LEPT_CALLOC(nrows, sizeof(l_int32));
+    if (!srcrow || !buf || !line || !rows || !tags) {
+        LEPT_FREE(srcrow);
+        LEPT_FREE(buf);
+        LEPT_FREE(line);
+        LEPT_FREE(rows);
+        LEPT_FREE(tags);
+        return ERROR_INT("buffers not made", procName, 1);
+    }
+
+    y0 = (params->hd * index) / params->nbands;
+    y1 = (params->hd * (index + 1)) / params->nbands;
+    for (id = y0; id < y1; id++) {
+        i = id * params->yfact;
+        for (k = 0; k < nrows; k++) {
+            y = i + k - c;
+            slot = (y + c) % nrows;
+            rows[k] = buf + slot * rowsize;
+            if (tags[slot] == y + c + 1)  /* 0 for empty */
+                continue;
+            tags[slot] = y + c + 1;
+            if (!params->kel2) {
+                convolveGetRow(params, y, rows[k], wt, cx);
+                continue;
+            }
+
+                /* Row pass, rounded as in a 32 bpp pix if requested */
+            convolveGetRow(params, y, srcrow, wt, cx);
+            convolveLine(rows[k], &srcrow, 1, sx, params->kel1->data, wd,
+                         params->xfact, params->simd);
+            if (params->roundmid) {
+                for (j = 0; j < wd; j++) {
+                    sum = rows[k][j];
+                    if (sum < 0.0) sum = -sum;
+                    rows[k][j] = (l_float32)(l_int32)(l_uint32)(sum + 0.5);
+                }
+            }
+        }
+
+        if (!params->kel2)
+            convolveLine(line, rows, sy, sx, params->kel1->data, wd,
+                         params->xfact, params->simd);
+        else
+            convolveLine(line, rows, sy2, 1, params->kel2->data, wd, 1,
+                         params->simd);
+        convolveSetLine(params, id, line);
+    }
+
+    LEPT_FREE(srcrow);
+    LEPT_FREE(buf);
+    LEPT_FREE(line);
+    LEPT_FREE(rows);
+    LEPT_FREE(tags);
+    return 0;
+}
+
+
+/*!
+ *  convolveGetRow()
+ *
+ *      Input:  params (CONVOLVE_PARAMS)
+ *              y (row of the source; mirrored if outside the image)
+ *              row (<return> float values of the row, starting cx
+ *                   pixels to the left of the image)
+ *              wt (number of values in row)
+ *              cx (width of the left border)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The border pixels are mirrored about the image boundary,
+ *          as in pixAddMirroredBorder(): pixel -1 is pixel 0, and
+ *          pixel w is pixel w - 1.
+ *      (2) Pixel values of 32 bpp images are taken as signed integers.
+ */
+static void
+convolveGetRow(CONVOLVE_PARAMS  *params,
+               l_int32           y,
+               l_float32        *row,
+               l_int32           wt,
+               l_int32           cx)
+{
+l_int32     j, x, w, h;
+l_uint32   *lines;
+l_float32  *flines;
+
+    w = params->w;
+    h = params->h;
+    if (y < 0)
+        y = -1 - y;
+    else if (y >= h)
+        y = 2 * h - 1 - y;
+    lines = NULL;
+    flines = NULL;
+    if (params->fdatas)
+        flines = params->fdatas + y * params->wpls;
+    else
+        lines = params->datas + y * params->wpls;
+
+    for (j = 0; j < wt; j++) {
+        x = j - cx;
+        if (x < 0)
+            x = -1 - x;
+        else if (x >= w)
+            x = 2 * w - 1 - x;
+        if (flines)
+            row[j] = flines[x];
+        else if (params->d == 8)
+            row[j] = (l_float32)GET_DATA_BYTE(lines, x);
+        else if (params->d == 16)
+            row[j] = (l_float32)GET_DATA_TWO_BYTES(lines, x);
+        else  /* d == 32 */
+            row[j] = (l_float32)(l_int32)lines[x];
+    }
+}
+
+
+/*!
+ *  convolveLine()
+ *
+ *      Input:  lined (<return> n values)
+ *              rows (sy rows, each starting at the left border)
+ *              sy, sx (kernel size)
+ *              kdata (kernel values)
+ *              n (number of values in lined)
+ *              xfact (horizontal subsampling factor)
+ *              simd (simd mode)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Each output value is a sum of products, in float, starting
+ *          from 0.0 and taken in raster order over the kernel.  The
+ *          vector kernels do the sums for several output values at
+ *          once, in the same order, so the results are the same.
+ */
+static void
+convolveLine(l_float32   *lined,
+             l_float32  **rows,
+             l_int32      sy,
+             l_int32      sx,
+             l_float32  **kdata,
+             l_int32      n,
+             l_int32      xfact,
+             l_int32      simd)
+{
+l_int32     j, jstart, k, m;
+l_float32   sum;
+l_float32  *row;
+
+    jstart = 0;
+    if (xfact == 1) {
+        switch (simd)
+        {
+#if L_HAVE_AVX2
+        case L_SIMD_AVX2:
+            jstart = convolveLineAvx2(lined, rows, sy, sx, kdata, n);
+            break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+        case L_SIMD_SSE2:
+            jstart = convolveLineSse2(lined, rows, sy, sx, kdata, n);
+            break;
+#endif  /* L_HAVE_SSE2 */
+        default:
+            break;
+        }
+    }
+
+    for (j = jstart; j < n; j++) {
+        sum = 0.0;
+        for (k = 0; k < sy; k++) {
+            row = rows[k] + j * xfact;
+            for (m = 0; m < sx; m++)
+                sum += row[m] * kdata[k][m];
+        }
+        lined[j] = sum;
+    }
+}
+
+
+/*!
+ *  convolveSetLine()
+ *
+ *      Input:  params (CONVOLVE_PARAMS)
+ *              id (output line)
+ *              line (convolved values)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) For pix output, the absolute value is rounded to the
+ *          output depth, as described in pixConvolve().
+ */
+static void
+convolveSetLine(CONVOLVE_PARAMS  *params,
+                l_int32           id,
+                l_float32        *line)
+{
+l_int32    jd;
+l_uint32  *lined;
+l_float32  sum;
+
+    if (params->fdatad) {
+        memcpy(params->fdatad + id * params->wpld, line,
+               params->wd * sizeof(l_float32));
+        return;
+    }
+
+    lined = params->datad + id * params->wpld;
+    for (jd = 0; jd < params->wd; jd++) {
+        sum = line[jd];
+        if (sum < 0.0) sum = -sum;  /* make it non-negative */
+        if (params->outdepth == 8)
+            SET_DATA_BYTE(lined, jd, (l_int32)(sum + 0.5));
+        else if (params->outdepth == 16)
+            SET_DATA_TWO_BYTES(lined, jd, (l_int32)(sum + 0.5));
+        else  /* outdepth == 32 */
+            *(lined + jd) = (l_uint32)(sum + 0.5);
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of output
+     * values it has made; the rest are made by the caller.  Several
+     * registers of sums are kept over the whole kernel, and each is
+     * updated with a multiply and an add (not fused), as in the
+     * scalar code. */
+#if L_HAVE_SSE2
+static l_int32
+convolveLineSse2(l_float32   *lined,
+                 l_float32  **rows,
+                 l_int32      sy,
+                 l_int32      sx,
+                 l_float32  **kdata,
+                 l_int32      n)
+{
+l_int32     j, k, m;
+l_float32  *row;
+__m128      v, s0, s1, s2, s3;
+
+    for (j = 0; j + 16 <= n; j += 16) {
+        s0 = s1 = s2 = s3 = _mm_setzero_ps();
+        for (k = 0; k < sy; k++) {
+            row = rows[k] + j;
+            for (m = 0; m < sx; m++) {
+                v = _mm_set1_ps(kdata[k][m]);
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(row + m), v));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(row + m + 4), v));
+                s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(row + m + 8), v));
+                s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(row + m + 12), v));
+            }
+        }
+        _mm_storeu_ps(lined + j, s0);
+        _mm_storeu_ps(lined + j + 4, s1);
+        _mm_storeu_ps(lined + j + 8, s2);
+        _mm_storeu_ps(lined + j + 12, s3);
+    }
+    for (; j + 4 <= n; j += 4) {
+        s0 = _mm_setzero_ps();
+        for (k = 0; k < sy; k++) {
+            row = rows[k] + j;
+            for (m = 0; m < sx; m++) {
+                v = _mm_set1_ps(kdata[k][m]);
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(row + m), v));
+            }
+        }
+        _mm_storeu_ps(lined + j, s0);
+    }
+    return j;
+}
+#endif  /* L_HAVE_SSE2 */
+
+#if L_HAVE_AVX2
+static l_int32
+convolveLineAvx2(l_float32   *lined,
+                 l_float32  **rows,
+                 l_int32      sy,
+                 l_int32      sx,
+                 l_float32  **kdata,
+                 l_int32      n)
+{
+l_int32     j, k, m;
+l_float32  *row;
+__m256      v, s0, s1, s2, s3;
+
+    for (j = 0; j + 32 <= n; j += 32) {
+        s0 = s1 = s2 = s3 = _mm256_setzero_ps();
+        for (k = 0; k < sy; k++) {
+            row = rows[k] + j;
+            for (m = 0; m < sx; m++) {
+                v = _mm256_set1_ps(kdata[k][m]);
+                s0 = _mm256_add_ps(s0,
+                         _mm256_mul_ps(_mm256_loadu_ps(row + m), v));
+                s1 = _mm256_add_ps(s1,
+                         _mm256_mul_ps(_mm256_loadu_ps(row + m + 8), v));
+                s2 = _mm256_add_ps(s2,
+                         _mm256_mul_ps(_mm256_loadu_ps(row + m + 16), v));
+                s3 = _mm256_add_ps(s3,
+                         _mm256_mul_ps(_mm256_loadu_ps(row + m + 24), v));
+            }
+        }
+        _mm256_storeu_ps(lined + j, s0);
+        _mm256_storeu_ps(lined + j + 8, s1);
+        _mm256_storeu_ps(lined + j + 16, s2);
+        _mm256_storeu_ps(lined + j + 24, s3);
+    }
+    for (; j + 8 <= n; j += 8) {
+        s0 = _mm256_setzero_ps();
+        for (k = 0; k < sy; k++) {
+            row = rows[k] + j;
+            for (m = 0; m < sx; m++) {
+                v = _mm256_set1_ps(kdata[k][m]);
+                s0 = _mm256_add_ps(s0,
+                         _mm256_mul_ps(_mm256_loadu_ps(row + m), v));
+            }
+        }
+        _mm256_storeu_ps(lined + j, s0);
+    }
+    return j;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
 /*------------------------------------------------------------------------*
  *              Convolution with bias (for non-negative output)           *
  *------------------------------------------------------------------------*/
@@ -2367,7 +2984,7 @@ PIX       *pixd;
 
 
 /*------------------------------------------------------------------------*
- *                Set parameter for convolution subsampling               *
+ *                Set parameters for generic convolution                  *
  *------------------------------------------------------------------------*/
 /*!
  *  l_setConvolveSampling()
@@ -2391,6 +3008,31 @@ l_setConvolveSampling(l_int32  xfact,
 }
 
 
+/*!
+ *  l_setConvolveSeparable()
+ *
+ *      Input:  flag (1 to look for separable kernels; 0 otherwise)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) If set, pixConvolve() and fpixConvolve() test whether the
+ *          kernel is separable, using kernelGetSeparable(), and if so,
+ *          convolve with the row and column factors in sequence, as
+ *          fpixConvolveSep() does.  For a kernel of size sx * sy,
+ *          this takes time proportional to (sx + sy) instead of
+ *          (sx * sy).
+ *      (2) The results can differ slightly from those with the full
+ *          kernel, because the sums are rounded differently.  For pix,
+ *          a few pixels may differ by 1.  The default value is 0, which
+ *          always uses the full kernel.
+ */
+void
+l_setConvolveSeparable(l_int32  flag)
+{
+    var_CONVOLVE_SEPARABLE = (flag) ? 1 : 0;
+}
+
+
 /*------------------------------------------------------------------------*
  *                          Additive gaussian noise                       *
  *------------------------------------------------------------------------*/
@@ -38,6 +38,15 @@
  *         l_int32     pixCorrelationScoreSimple()
  *         l_int32     pixCorrelationScoreShifted()
  *
+ *     Batch correlator (one pix against many, over a range of shifts)
+ *         l_int32     pixCorrelationScoreBatch()
+ *
+ *     Static helpers
+ *         static l_int32  correlCountLow()
+ *         static l_int32  correlCountSse2()
+ *         static l_int32  correlCountAvx2()
+ *         static l_int32  correlCountNeon()
+ *
  *     There are other, more application-oriented functions, that
  *     compute the correlation between two binary images, taking into
  *     account small translational shifts, between two binary images.
@@ -48,8 +57,25 @@
  *                        Uses small shifts between c.c. centroids.
  */
 
+#include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#include "simd.h"
+
+static l_int32 correlCountLow(const l_uint32 *data1, const l_uint32 *data2,
+                              l_int32 n, l_int32 mode);
+#if L_HAVE_SSE2
+static l_int32 correlCountSse2(const l_uint32 *data1, const l_uint32 *data2,
+                               l_int32 n, l_int32 *pcount);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 correlCountAvx2(const l_uint32 *data1, const l_uint32 *data2,
+                               l_int32 n, l_int32 *pcount) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 correlCountNeon(const l_uint32 *data1, const l_uint32 *data2,
+                               l_int32 n, l_int32 *pcount);
+#endif  /* L_HAVE_NEON */
 
 
 /* -------------------------------------------------------------------- *
@@ -867,3 +893,323 @@ PIX     *pixt;
                ((l_float32)area1 * (l_float32)area2);
     return 0;
 }
+
+
+/* -------------------------------------------------------------------- *
+ *                          Batch correlator                            *
+ * -------------------------------------------------------------------- */
+/*!
+ *  pixCorrelationScoreBatch()
+ *
+ *      Input:  pix1   (test pix, 1 bpp)
+ *              area1  (number of on pixels in pix1)
+ *              pixa2  (exemplar pix, 1 bpp)
+ *              na2    (number of on pixels in each exemplar)
+ *              pta2   (<optional> (delx, dely) for each exemplar; the
+ *                      centroid difference x(1) - x(2), y(1) - y(2).
+ *                      Use NULL to align the UL corners.)
+ *              maxshift (max additional shift in x and y; >= 0)
+ *              maxdiffw (max width difference of pix1 and each exemplar)
+ *              maxdiffh (max height difference of pix1 and each exemplar)
+ *              &nascore (<return> best correlation score for each exemplar)
+ *              &ptashift (<optional return> shift (sx, sy) giving the
+ *                         best score for each exemplar)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) For each exemplar in @pixa2, this gives the maximum of
+ *            pixCorrelationScoreSimple(pix1, pix2, area1, area2,
+ *                                      delx + sx, dely + sy, ...)
+ *          over all shifts -maxshift <= sx, sy <= maxshift, with the
+ *          same rounding of the translation to the nearest integer.
+ *          The shifts are scanned with sy in the outer loop, and the
+ *          first shift found with the max score is returned, so the
+ *          results are identical to calling the simple correlator
+ *          in that order.
+ *      (2) The score is 0.0, with shift (0, 0), for an exemplar with
+ *          no on pixels, or if its width or height differs from that
+ *          of pix1 by more than @maxdiffw or @maxdiffh.  To correlate
+ *          regardless of size, use large values for both.
+ *      (3) One line buffer with the size of pix1 is made for all the
+ *          correlations.  For each shift, the exemplar is blitted
+ *          into it, and the on pixels in its AND with pix1 are counted
+ *          over the rows that overlap, using a vector popcount kernel
+ *          selected by l_getSimdMode().  No pix are created or cloned,
+ *          so this can be called on shared pixa from several threads.
+ *      (4) The exemplars can be views; a view for pix1 is copied.
+ *      (5) The shifts in @ptashift can be negative; read them with
+ *          ptaGetPt(), because ptaGetIPt() does not round negative
+ *          values correctly.
+ */
+l_int32
+pixCorrelationScoreBatch(PIX        *pix1,
+                         l_int32     area1,
+                         PIXA       *pixa2,
+                         NUMA       *na2,
+                         PTA        *pta2,
+                         l_int32     maxshift,
+                         l_int32     maxdiffw,
+                         l_int32     maxdiffh,
+                         NUMA      **pnascore,
+                         PTA       **pptashift)
+{
+l_int32    i, n, w1, h1, wpl1, w2, h2, d2, wpl2, area2, mode;
+l_int32    sx, sy, idelx, idely, ylo, yhi, bestsx, bestsy, count;
+l_uint32  *data1, *data2, *buf;
+l_float32  delx, dely, fdel, score, maxscore;
+NUMA      *nascore;
+PIX       *pixc, *pix2;
+PIX      **pixs2;
+PTA       *ptashift;
+
+    PROCNAME("pixCorrelationScoreBatch");
+
+    if (pptashift) *pptashift = NULL;
+    if (!pnascore)
+        return ERROR_INT("&nascore not defined", procName, 1);
+    *pnascore = NULL;
+    if (!pix1 || pixGetDepth(pix1) != 1)
+        return ERROR_INT("pix1 undefined or not 1 bpp", procName, 1);
+    if (area1 <= 0)
+        return ERROR_INT("area1 must be > 0", procName, 1);
+    if (!pixa2)
+        return ERROR_INT("pixa2 not defined", procName, 1);
+    n = pixaGetCount(pixa2);
+    if (!na2 || numaGetCount(na2) != n)
+        return ERROR_INT("na2 undefined or wrong size", procName, 1);
+    if (pta2 && ptaGetCount(pta2) != n)
+        return ERROR_INT("pta2 wrong size", procName, 1);
+    if (maxshift < 0)
+        return ERROR_INT("maxshift must be >= 0", procName, 1);
+
+        /* pix1 is read word by word, aligned with the buffer */
+    pixc = (pixIsView(pix1)) ? pixCopy(NULL, pix1) : NULL;
+    if (pixc) pix1 = pixc;
+    pixGetDimensions(pix1, &w1, &h1, NULL);
+    data1 = pixGetData(pix1);
+    wpl1 = pixGetWpl(pix1);
+    if ((buf = (l_uint32 *)LEPT_CALLOC(h1 * wpl1, sizeof(l_uint32)))
+        == NULL) {
+        pixDestroy(&pixc);
+        return ERROR_INT("buf not made", procName, 1);
+    }
+
+    nascore = numaCreate(n);
+    ptashift = (pptashift) ? ptaCreate(n) : NULL;
+    pixs2 = pixaGetPixArray(pixa2);
+    mode = l_getSimdMode();
+    delx = dely = 0.0;
+    for (i = 0; i < n; i++) {
+        maxscore = 0.0;
+        bestsx = bestsy = 0;
+        pix2 = pixs2[i];
+        pixGetDimensions(pix2, &w2, &h2, &d2);
+        numaGetIValue(na2, i, &area2);
+        if (pta2)
+            ptaGetPt(pta2, i, &delx, &dely);
+        if (d2 != 1) {
+            L_ERROR("pix %d not 1 bpp\n", procName, i);
+            area2 = 0;
+        }
+        if (area2 <= 0 || L_ABS(w1 - w2) > maxdiffw ||
+            L_ABS(h1 - h2) > maxdiffh) {
+            numaAddNumber(nascore, 0.0);
+            if (ptashift) ptaAddPt(ptashift, 0, 0);
+            continue;
+        }
+
+        data2 = pixGetData(pix2);
+        wpl2 = pixGetWpl(pix2);
+        for (sy = -maxshift; sy <= maxshift; sy++) {
+            fdel = dely + sy;
+            if (fdel >= 0)
+                idely = (l_int32)(fdel + 0.5);
+            else
+                idely = (l_int32)(fdel - 0.5);
+            ylo = L_MAX(0, idely);
+            yhi = L_MIN(h1, idely + h2);
+            if (ylo >= yhi)  /* no overlap */
+                continue;
+            for (sx = -maxshift; sx <= maxshift; sx++) {
+                fdel = delx + sx;
+                if (fdel >= 0)
+                    idelx = (l_int32)(fdel + 0.5);
+                else
+                    idelx = (l_int32)(fdel - 0.5);
+                if (idelx >= w1 || idelx + w2 <= 0)
+                    continue;
+
+                    /* Blit the shifted pix2 into the cleared rows of the
+                     * buffer, clipped to pix1, and count the on pixels
+                     * that it has in common with pix1. */
+                memset(buf + ylo * wpl1, 0,
+                       sizeof(l_uint32) * (yhi - ylo) * wpl1);
+                rasteropLow(buf, w1, h1, 1, wpl1, idelx, idely, w2, h2,
+                            PIX_SRC, data2, w2, h2, wpl2, 0, 0);
+                count = correlCountLow(buf + ylo * wpl1, data1 + ylo * wpl1,
+                                       (yhi - ylo) * wpl1, mode);
+                score = (l_float32)count * (l_float32)count /
+                         ((l_float32)area1 * (l_float32)area2);
+                if (score > maxscore) {
+                    maxscore = score;
+                    bestsx = sx;
+                    bestsy = sy;
+                }
+            }
+        }
+        numaAddNumber(nascore, maxscore);
+        if (ptashift) ptaAddPt(ptashift, bestsx, bestsy);
+    }
+
+    LEPT_FREE(buf);
+    pixDestroy(&pixc);
+    *pnascore = nascore;
+    if (pptashift) *pptashift = ptashift;
+    return 0;
+}
+
+
+/*!
+ *  correlCountLow()
+ *
+ *      Input:  data1, data2 (two arrays of words)
+ *              n (number of words)
+ *              mode (simd mode)
+ *      Return: number of on bits in the AND of the two arrays
+ */
+static l_int32
+correlCountLow(const l_uint32  *data1,
+               const l_uint32  *data2,
+               l_int32          n,
+               l_int32          mode)
+{
+l_int32   k, kstart, count;
+l_uint32  word;
+
+    count = 0;
+    kstart = 0;
+    switch (mode)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        kstart = correlCountAvx2(data1, data2, n, &count);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        kstart = correlCountSse2(data1, data2, n, &count);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        kstart = correlCountNeon(data1, data2, n, &count);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+        /* Parallel bit count within each word */
+    for (k = kstart; k < n; k++) {
+        word = data1[k] & data2[k];
+        word -= (word >> 1) & 0x55555555;
+        word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+        word = (word + (word >> 4)) & 0x0f0f0f0f;
+        count += (word * 0x01010101) >> 24;
+    }
+    return count;
+}
+
+
+    /* Each of the vector kernels below adds the on bits in the AND of
+     * the first words to *pcount, and returns the number of words it
+     * has done; the rest are done by the caller. */
+#if L_HAVE_SSE2
+static l_int32
+correlCountSse2(const l_uint32  *data1,
+                const l_uint32  *data2,
+                l_int32          n,
+                l_int32         *pcount)
+{
+l_int32  k;
+__m128i  m1, m2, m4, zero, acc, v;
+
+    m1 = _mm_set1_epi8(0x55);
+    m2 = _mm_set1_epi8(0x33);
+    m4 = _mm_set1_epi8(0x0f);
+    zero = _mm_setzero_si128();
+    acc = zero;
+    for (k = 0; k + 4 <= n; k += 4) {
+        v = _mm_and_si128(_mm_loadu_si128((const __m128i *)(data1 + k)),
+                          _mm_loadu_si128((const __m128i *)(data2 + k)));
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+        v = _mm_add_epi8(_mm_and_si128(v, m2),
+                         _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+        v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    *pcount += _mm_cvtsi128_si32(acc) +
+               _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+    return k;
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+    /* Bit count of each byte from a table of the counts of its nibbles */
+static l_int32
+correlCountAvx2(const l_uint32  *data1,
+                const l_uint32  *data2,
+                l_int32          n,
+                l_int32         *pcount)
+{
+l_int32  k;
+__m128i  sum;
+__m256i  lut, m4, zero, acc, v, c;
+
+    lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    m4 = _mm256_set1_epi8(0x0f);
+    zero = _mm256_setzero_si256();
+    acc = zero;
+    for (k = 0; k + 8 <= n; k += 8) {
+        v = _mm256_and_si256(
+                _mm256_loadu_si256((const __m256i *)(data1 + k)),
+                _mm256_loadu_si256((const __m256i *)(data2 + k)));
+        c = _mm256_add_epi8(
+                _mm256_shuffle_epi8(lut, _mm256_and_si256(v, m4)),
+                _mm256_shuffle_epi8(lut, _mm256_and_si256(
+                                         _mm256_srli_epi16(v, 4), m4)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(c, zero));
+    }
+    sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                        _mm256_extracti128_si256(acc, 1));
+    *pcount += _mm_cvtsi128_si32(sum) +
+               _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+    return k;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+static l_int32
+correlCountNeon(const l_uint32  *data1,
+                const l_uint32  *data2,
+                l_int32          n,
+                l_int32         *pcount)
+{
+l_int32     k;
+uint8x16_t  c;
+uint32x4_t  acc, v;
+
+    acc = vdupq_n_u32(0);
+    for (k = 0; k + 4 <= n; k += 4) {
+        v = vandq_u32(vld1q_u32(data1 + k), vld1q_u32(data2 + k));
+        c = vcntq_u8(vreinterpretq_u8_u32(v));
+        acc = vpadalq_u16(acc, vpaddlq_u8(c));
+    }
+    *pcount += vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+               vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    return k;
+}
+#endif  /* L_HAVE_NEON */
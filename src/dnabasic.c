@@ -347,8 +347,7 @@ L_DNA  *da;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the l_dna. */
-    l_dnaChangeRefcount(da, -1);
-    if (l_dnaGetRefcount(da) <= 0) {
+    if (--da->refcount <= 0) {
         if (da->array)
             LEPT_FREE(da->array);
         LEPT_FREE(da);
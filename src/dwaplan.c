@@ -0,0 +1,989 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  dwaplan.c
+ *
+ *      Dwa morphology with an arbitrary Sel
+ *            PIX             *pixMorphSelDwa()
+ *            PIX             *pixHMTSelDwa()
+ *
+ *      Cache of dwa plans
+ *            l_int32          l_dwaPlanCacheClear()
+ *            l_int32          l_dwaPlanCacheGetCount()
+ *
+ *      Static helpers
+ *            static DWA_PLAN *dwaPlanGet()
+ *            static DWA_PLAN *dwaPlanCreate()
+ *            static void      dwaPlanDestroy()
+ *            static void      dwaPlanRelease()
+ *            static l_uint32  selHash()
+ *            static l_int32   selSame()
+ *            static PIX      *pixApplyDwaPlan()
+ *            static void      dwaSetTerm()
+ *            static void      dwaCombineLine()
+ *            static l_int32   dwaCombineLineSse2()
+ *            static l_int32   dwaCombineLineAvx2()
+ *            static l_int32   dwaCombineLineNeon()
+ *            static void      dwaPlanLock()
+ *            static void      dwaPlanUnlock()
+ *
+ *  The dwa functions generated by fmorphautogen() and fhmtautogen()
+ *  are fast because each destination word is computed in one pass,
+ *  as a logical combination of shifted source words, with no
+ *  intermediate images.  But they must be generated, compiled and
+ *  linked for a fixed set of Sels.  Any other Sel goes through the
+ *  rasterop functions pixDilate(), pixErode() and pixHMT(), which
+ *  make one pass over the full image for each hit and miss.
+ *
+ *  The functions here do dwa morphology with any Sel, by making
+ *  a "plan" for the Sel at run time:
+ *      (1) The hits (and, separately, the misses) in each row of the
+ *          Sel give a set of horizontal shifts.  Rows with the same
+ *          set of shifts are put in one group, and the shifted source
+ *          for the group is computed once and used for each of its rows.
+ *          For a brick, all rows are in one group, so the work is that
+ *          of a separable operation.
+ *      (2) A group used by only one row is applied directly to the
+ *          destination, so there is no intermediate image for it.
+ *      (3) As in the generated code, each destination word is made
+ *          from all the shifted source words in one pass, with a single
+ *          store.  This is done for a band of lines at a time that stays
+ *          in the cache, with vector kernels (see simd.h) that do 4 or
+ *          8 words at a time.
+ *  The source is copied into a buffer with a border that is large
+ *  enough for all the shifts, and that holds the pixel value assumed
+ *  outside the image.  The results are identical to those of
+ *  pixDilate(), pixErode(), pixOpen(), pixClose() and pixHMT(),
+ *  including the boundary conditions (see morph.c).
+ *
+ *  Plans are cached, keyed by a hash of the Sel size, origin and
+ *  elements, so the plan for a Sel is made only once.  The Sel name
+ *  is ignored.  The cache holds up to DWA_PLAN_CACHE_SIZE plans; when
+ *  it is full, the oldest plan is replaced.  The cache is protected
+ *  by a lock, so these functions can be called from several threads.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
+#include <string.h>
+#include "allheaders.h"
+#include "simd.h"
+
+    /* Max number of cached plans */
+#define  DWA_PLAN_CACHE_SIZE   64
+
+    /* Approximate size of a band of the result; it should fit in
+     * the L1 cache */
+static const l_int32  DWA_BAND_BYTES = 32768;
+
+    /* Rows of a Sel with the same set of horizontal shifts, either
+     * for hits or for misses */
+struct DwaPlanGroup
+{
+    l_int32     miss;      /* 1 for misses; 0 for hits                    */
+    l_int32     nx;        /* number of horizontal shifts                 */
+    l_int32    *dx;        /* horizontal shifts: j - cx                   */
+    l_int32     ny;        /* number of rows with this set of shifts      */
+    l_int32    *dy;        /* vertical shifts of the rows: i - cy         */
+};
+typedef struct DwaPlanGroup  DWA_PLAN_GROUP;
+
+    /* The plan for a Sel */
+struct DwaPlan
+{
+    l_uint32         hash;      /* hash of the Sel                        */
+    SEL             *sel;       /* copy of the Sel, to identify the plan  */
+    l_int32          ngroups;   /* number of groups                       */
+    DWA_PLAN_GROUP  *groups;    /* array of groups                        */
+    l_int32          maxdx;     /* largest horizontal shift magnitude     */
+    l_int32          maxdy;     /* largest vertical shift magnitude       */
+    l_int32          nterms;    /* number of hits and misses              */
+    l_int32          refcount;  /* the cache and the current users        */
+};
+typedef struct DwaPlan  DWA_PLAN;
+
+    /* A shifted source: the words at ps, shifted left by r bits
+     * (0 <= r < 32) with the bits of the next word, and XORed with inv */
+struct DwaTerm
+{
+    l_uint32   *ps;        /* source word for the first destination word  */
+    l_int32     r;         /* shift within the word                        */
+    l_uint32    inv;       /* 0xffffffff to invert (misses); 0 otherwise   */
+};
+typedef struct DwaTerm  DWA_TERM;
+
+    /* Ways of combining the terms */
+enum {
+    L_DWA_AND = 0,         /* d = AND of the terms                        */
+    L_DWA_OR = 1           /* d = OR of the terms                         */
+};
+
+    /* The cache */
+static DWA_PLAN  *var_DWA_PLAN_CACHE[DWA_PLAN_CACHE_SIZE];
+static l_int32    var_DWA_PLAN_NEXT = 0;   /* slot for the next new plan */
+static L_MUTEX   *var_DWA_PLAN_LOCK = NULL;  /* made on first use */
+
+static DWA_PLAN *dwaPlanGet(SEL *sel);
+static DWA_PLAN *dwaPlanCreate(SEL *sel, l_uint32 hash);
+static void dwaPlanDestroy(DWA_PLAN **pplan);
+static void dwaPlanRelease(DWA_PLAN **pplan);
+static l_uint32 selHash(SEL *sel);
+static l_int32 selSame(SEL *sel1, SEL *sel2);
+static PIX *pixApplyDwaPlan(PIX *pixs, DWA_PLAN *plan, l_int32 operation);
+static void dwaSetTerm(DWA_TERM *term, l_uint32 *lines, l_int32 shift,
+                       l_int32 invert);
+static void dwaCombineLine(l_uint32 *lined, l_int32 nwords, DWA_TERM *terms,
+                           l_int32 nterms, l_int32 op, l_int32 simd);
+#if L_HAVE_SSE2
+static l_int32 dwaCombineLineSse2(l_uint32 *lined, l_int32 n,
+                                  DWA_TERM *terms, l_int32 nterms,
+                                  l_int32 op);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 dwaCombineLineAvx2(l_uint32 *lined, l_int32 n,
+                                  DWA_TERM *terms, l_int32 nterms,
+                                  l_int32 op) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 dwaCombineLineNeon(l_uint32 *lined, l_int32 n,
+                                  DWA_TERM *terms, l_int32 nterms,
+                                  l_int32 op);
+#endif  /* L_HAVE_NEON */
+static void dwaPlanLock(void);
+static void dwaPlanUnlock(void);
+
+
+/*-----------------------------------------------------------------*
+ *                Dwa morphology with an arbitrary Sel             *
+ *-----------------------------------------------------------------*/
+/*!
+ *  pixMorphSelDwa()
+ *
+ *      Input:  pixd (<optional>; this can be null, equal to pixs,
+ *                    or different from pixs)
+ *              pixs (1 bpp)
+ *              operation  (L_MORPH_DILATE, L_MORPH_ERODE,
+ *                          L_MORPH_OPEN, L_MORPH_CLOSE)
+ *              sel (any Sel; only the hits are used)
+ *      Return: pixd, or null on error
+ *
+ *  Notes:
+ *      (1) This gives the same result as pixDilate(), pixErode(),
+ *          pixOpen() and pixClose(), for the current boundary condition
+ *          (see resetMorphBoundaryCondition()).
+ *      (2) The plan for the Sel is made on the first call, and is
+ *          cached for later calls with an identical Sel.
+ *      (3) There are three cases for pixd:
+ *          (a) pixd == null   (result into new pixd)
+ *          (b) pixd == pixs   (in-place; writes result back to pixs)
+ *          (c) pixd != pixs   (puts result into existing pixd)
+ */
+PIX *
+pixMorphSelDwa(PIX     *pixd,
+               PIX     *pixs,
+               l_int32  operation,
+               SEL     *sel)
+{
+DWA_PLAN  *plan;
+PIX       *pix1, *pix2;
+
+    PROCNAME("pixMorphSelDwa");
+
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (PIX *)ERROR_PTR("pixs undefined or not 1 bpp", procName, pixd);
+    if (!sel)
+        return (PIX *)ERROR_PTR("sel not defined", procName, pixd);
+    if (operation != L_MORPH_DILATE && operation != L_MORPH_ERODE &&
+        operation != L_MORPH_OPEN && operation != L_MORPH_CLOSE)
+        return (PIX *)ERROR_PTR("invalid operation", procName, pixd);
+    if ((plan = dwaPlanGet(sel)) == NULL)
+        return (PIX *)ERROR_PTR("plan not made", procName, pixd);
+
+    pix2 = NULL;
+    switch (operation)
+    {
+    case L_MORPH_DILATE:
+    case L_MORPH_ERODE:
+        pix2 = pixApplyDwaPlan(pixs, plan, operation);
+        break;
+    case L_MORPH_OPEN:
+        pix1 = pixApplyDwaPlan(pixs, plan, L_MORPH_ERODE);
+        if (pix1)
+            pix2 = pixApplyDwaPlan(pix1, plan, L_MORPH_DILATE);
+        pixDestroy(&pix1);
+        break;
+    case L_MORPH_CLOSE:
+        pix1 = pixApplyDwaPlan(pixs, plan, L_MORPH_DILATE);
+        if (pix1)
+            pix2 = pixApplyDwaPlan(pix1, plan, L_MORPH_ERODE);
+        pixDestroy(&pix1);
+        break;
+    default:
+        break;
+    }
+    dwaPlanRelease(&plan);
+    if (!pix2)
+        return (PIX *)ERROR_PTR("pix2 not made", procName, pixd);
+
+    if (!pixd)
+        return pix2;
+    pixCopy(pixd, pix2);
+    pixDestroy(&pix2);
+    return pixd;
+}
+
+
+/*!
+ *  pixHMTSelDwa()
+ *
+ *      Input:  pixd (<optional>; this can be null, equal to pixs,
+ *                    or different from pixs)
+ *              pixs (1 bpp)
+ *              sel (any Sel with at least one hit or miss)
+ *      Return: pixd, or null on error
+ *
+ *  Notes:
+ *      (1) This gives the same result as pixHMT().
+ *      (2) See pixMorphSelDwa() for the plan cache and for pixd.
+ */
+PIX *
+pixHMTSelDwa(PIX  *pixd,
+             PIX  *pixs,
+             SEL  *sel)
+{
+DWA_PLAN  *plan;
+PIX       *pix1;
+
+    PROCNAME("pixHMTSelDwa");
+
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (PIX *)ERROR_PTR("pixs undefined or not 1 bpp", procName, pixd);
+    if (!sel)
+        return (PIX *)ERROR_PTR("sel not defined", procName, pixd);
+    if ((plan = dwaPlanGet(sel)) == NULL)
+        return (PIX *)ERROR_PTR("plan not made", procName, pixd);
+    if (plan->ngroups == 0) {
+        dwaPlanRelease(&plan);
+        return (PIX *)ERROR_PTR("sel has no hits or misses", procName, pixd);
+    }
+
+    pix1 = pixApplyDwaPlan(pixs, plan, L_MORPH_HMT);
+    dwaPlanRelease(&plan);
+    if (!pix1)
+        return (PIX *)ERROR_PTR("pix1 not made", procName, pixd);
+
+    if (!pixd)
+        return pix1;
+    pixCopy(pixd, pix1);
+    pixDestroy(&pix1);
+    return pixd;
+}
+
+
+/*-----------------------------------------------------------------*
+ *                        Cache of dwa plans                       *
+ *-----------------------------------------------------------------*/
+/*!
+ *  l_dwaPlanCacheClear()
+ *
+ *      Return: 0 if OK
+ *
+ *  Notes:
+ *      (1) This removes all plans from the cache.  Plans that are
+ *          in use by another thread are destroyed when it is done
+ *          with them.
+ */
+l_int32
+l_dwaPlanCacheClear(void)
+{
+l_int32  i;
+
+    dwaPlanLock();
+    for (i = 0; i < DWA_PLAN_CACHE_SIZE; i++) {
+        if (var_DWA_PLAN_CACHE[i] && --var_DWA_PLAN_CACHE[i]->refcount == 0)
+            dwaPlanDestroy(&var_DWA_PLAN_CACHE[i]);
+        var_DWA_PLAN_CACHE[i] = NULL;
+    }
+    var_DWA_PLAN_NEXT = 0;
+    dwaPlanUnlock();
+    return 0;
+}
+
+
+/*!
+ *  l_dwaPlanCacheGetCount()
+ *
+ *      Return: number of plans in the cache
+ */
+l_int32
+l_dwaPlanCacheGetCount(void)
+{
+l_int32  i, count;
+
+    dwaPlanLock();
+    for (i = 0, count = 0; i < DWA_PLAN_CACHE_SIZE; i++) {
+        if (var_DWA_PLAN_CACHE[i])
+            count++;
+    }
+    dwaPlanUnlock();
+    return count;
+}
+
+
+/*-----------------------------------------------------------------*
+ *                          Static helpers                         *
+ *-----------------------------------------------------------------*/
+/*!
+ *  dwaPlanGet()
+ *
+ *      Input:  sel
+ *      Return: plan, or null on error
+ *
+ *  Notes:
+ *      (1) This returns the cached plan for the sel, making it if
+ *          necessary.  Call dwaPlanRelease() when done with it.
+ *      (2) The plan is made without holding the lock.  If another
+ *          thread has cached a plan for the same sel in the meantime,
+ *          that one is used.
+ */
+static DWA_PLAN *
+dwaPlanGet(SEL  *sel)
+{
+l_int32    i;
+l_uint32   hash;
+DWA_PLAN  *plan, *newplan;
+
+    PROCNAME("dwaPlanGet");
+
+    hash = selHash(sel);
+    newplan = NULL;
+    while (1) {
+        dwaPlanLock();
+        for (i = 0; i < DWA_PLAN_CACHE_SIZE; i++) {
+            plan = var_DWA_PLAN_CACHE[i];
+            if (plan && plan->hash == hash && selSame(plan->sel, sel)) {
+                plan->refcount++;
+                dwaPlanUnlock();
+                if (newplan)
+                    dwaPlanDestroy(&newplan);
+                return plan;
+            }
+        }
+        if (newplan) {  /* insert it, replacing the oldest plan */
+            i = var_DWA_PLAN_NEXT;
+            plan = var_DWA_PLAN_CACHE[i];
+            if (plan && --plan->refcount == 0)
+                dwaPlanDestroy(&plan);
+            newplan->refcount = 2;
+            var_DWA_PLAN_CACHE[i] = newplan;
+            var_DWA_PLAN_NEXT = (i + 1) % DWA_PLAN_CACHE_SIZE;
+            dwaPlanUnlock();
+            return newplan;
+        }
+        dwaPlanUnlock();
+
+        if ((newplan = dwaPlanCreate(sel, hash)) == NULL)
+            return (DWA_PLAN *)ERROR_PTR("plan not made", procName, NULL);
+    }
+}
+
+
+/*!
+ *  dwaPlanCreate()
+ *
+ *      Input:  sel
+ *              hash (of the sel)
+ *      Return: plan, or null on error
+ *
+ *  Notes:
+ *      (1) The groups of hits come before the groups of misses, and
+ *          within each kind they are in order of the first row that
+ *          uses them.
+ */
+static DWA_PLAN *
+dwaPlanCreate(SEL       *sel,
+              l_uint32   hash)
+{
+l_int32          sx, sy, cx, cy, i, j, k, m, miss, val, nx;
+l_int32         *dx;
+DWA_PLAN        *plan;
+DWA_PLAN_GROUP  *group;
+
+    PROCNAME("dwaPlanCreate");
+
+    selGetParameters(sel, &sy, &sx, &cy, &cx);
+    if ((plan = (DWA_PLAN *)LEPT_CALLOC(1, sizeof(DWA_PLAN))) == NULL)
+        return (DWA_PLAN *)ERROR_PTR("plan not made", procName, NULL);
+    plan->hash = hash;
+    plan->sel = selCopy(sel);
+    plan->groups = (DWA_PLAN_GROUP *)LEPT_CALLOC(2 * sy,
+                                                 sizeof(DWA_PLAN_GROUP));
+    dx = (l_int32 *)LEPT_CALLOC(sx, sizeof(l_int32));
+    if (!plan->sel || !plan->groups || !dx) {
+        LEPT_FREE(dx);
+        dwaPlanDestroy(&plan);
+        return (DWA_PLAN *)ERROR_PTR("plan arrays not made", procName, NULL);
+    }
+
+    for (miss = 0; miss < 2; miss++) {
+        val = (miss) ? SEL_MISS : SEL_HIT;
+        for (i = 0; i < sy; i++) {
+            for (j = 0, nx = 0; j < sx; j++) {
+                if (sel->data[i][j] == val)
+                    dx[nx++] = j - cx;
+            }
+            if (nx == 0)
+                continue;
+            plan->maxdx = L_MAX(plan->maxdx, L_MAX(L_ABS(dx[0]),
+                                                   L_ABS(dx[nx - 1])));
+            plan->maxdy = L_MAX(plan->maxdy, L_ABS(i - cy));
+
+                /* Look for a group with the same set of shifts */
+            for (k = 0; k < plan->ngroups; k++) {
+                group = &plan->groups[k];
+                if (group->miss != miss || group->nx != nx)
+                    continue;
+                for (m = 0; m < nx; m++) {
+                    if (group->dx[m] != dx[m])
+                        break;
+                }
+                if (m == nx)
+                    break;
+            }
+            group = &plan->groups[k];
+            if (k == plan->ngroups) {  /* new group */
+                group->miss = miss;
+                group->nx = nx;
+                group->dx = (l_int32 *)LEPT_CALLOC(nx, sizeof(l_int32));
+                group->dy = (l_int32 *)LEPT_CALLOC(sy, sizeof(l_int32));
+                plan->ngroups++;
+                if (!group->dx || !group->dy) {
+                    LEPT_FREE(dx);
+                    dwaPlanDestroy(&plan);
+                    return (DWA_PLAN *)ERROR_PTR("group arrays not made",
+                                                 procName, NULL);
+                }
+                memcpy(group->dx, dx, nx * sizeof(l_int32));
+            }
+            group->dy[group->ny++] = i - cy;
+            plan->nterms += nx;
+        }
+    }
+
+    LEPT_FREE(dx);
+    return plan;
+}
+
+
+/*!
+ *  dwaPlanDestroy()
+ *
+ *      Input:  &plan (<will be set to null>)
+ *      Return: void
+ */
+static void
+dwaPlanDestroy(DWA_PLAN  **pplan)
+{
+l_int32    i;
+DWA_PLAN  *plan;
+
+    if (!pplan || (plan = *pplan) == NULL)
+        return;
+
+    if (plan->groups) {
+        for (i = 0; i < plan->ngroups; i++) {
+            LEPT_FREE(plan->groups[i].dx);
+            LEPT_FREE(plan->groups[i].dy);
+        }
+        LEPT_FREE(plan->groups);
+    }
+    selDestroy(&plan->sel);
+    LEPT_FREE(plan);
+    *pplan = NULL;
+}
+
+
+/*!
+ *  dwaPlanRelease()
+ *
+ *      Input:  &plan (<will be set to null>)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This decrements the ref count of a plan obtained with
+ *          dwaPlanGet(), and destroys the plan if it is no longer
+ *          in the cache.
+ */
+static void
+dwaPlanRelease(DWA_PLAN  **pplan)
+{
+l_int32    refcount;
+DWA_PLAN  *plan;
+
+    if (!pplan || (plan = *pplan) == NULL)
+        return;
+
+    dwaPlanLock();
+    refcount = --plan->refcount;
+    dwaPlanUnlock();
+    if (refcount == 0)
+        dwaPlanDestroy(&plan);
+    *pplan = NULL;
+}
+
+
+/*!
+ *  selHash()
+ *
+ *      Input:  sel
+ *      Return: 32-bit FNV-1a hash of the size, origin and elements
+ */
+static l_uint32
+selHash(SEL  *sel)
+{
+l_int32   i, j;
+l_uint32  hash;
+
+    hash = 2166136261U;
+    hash = (hash ^ (l_uint32)sel->sy) * 16777619U;
+    hash = (hash ^ (l_uint32)sel->sx) * 16777619U;
+    hash = (hash ^ (l_uint32)sel->cy) * 16777619U;
+    hash = (hash ^ (l_uint32)sel->cx) * 16777619U;
+    for (i = 0; i < sel->sy; i++) {
+        for (j = 0; j < sel->sx; j++)
+            hash = (hash ^ (l_uint32)sel->data[i][j]) * 16777619U;
+    }
+    return hash;
+}
+
+
+/*!
+ *  selSame()
+ *
+ *      Input:  sel1, sel2
+ *      Return: 1 if the size, origin and elements are the same; 0 otherwise
+ */
+static l_int32
+selSame(SEL  *sel1,
+        SEL  *sel2)
+{
+l_int32  i, j;
+
+    if (sel1->sy != sel2->sy || sel1->sx != sel2->sx ||
+        sel1->cy != sel2->cy || sel1->cx != sel2->cx)
+        return 0;
+    for (i = 0; i < sel1->sy; i++) {
+        for (j = 0; j < sel1->sx; j++) {
+            if (sel1->data[i][j] != sel2->data[i][j])
+                return 0;
+        }
+    }
+    return 1;
+}
+
+
+/*!
+ *  pixApplyDwaPlan()
+ *
+ *      Input:  pixs (1 bpp)
+ *              plan
+ *              operation (L_MORPH_DILATE, L_MORPH_ERODE, L_MORPH_HMT)
+ *      Return: pixd, or null on error
+ *
+ *  Notes:
+ *      (1) Dilation is the OR of the source shifted by the reflected
+ *          hits; erosion is the AND of the source shifted by the hits.
+ *          The hmt is the erosion by the hits, ANDed with the erosion
+ *          of the inverted source by the misses.
+ *      (2) Pixels outside the image are OFF, except for erosion with
+ *          the symmetric boundary condition, where they are ON.
+ *          This matches the rasterop implementation in morph.c.
+ *      (3) The source, the result and the groups used by several rows
+ *          of the sel are all held with the same line stride, including
+ *          the border.  A shifted source for a band of lines is then
+ *          a single run of words, from the first word of the first
+ *          line to the last word of the last line; the words it gives
+ *          for the border are not used.
+ *      (4) The result is made in bands of about DWA_BAND_BYTES, that
+ *          stay in the cache while all the hits and misses are
+ *          combined into them.
+ */
+static PIX *
+pixApplyDwaPlan(PIX       *pixs,
+                DWA_PLAN  *plan,
+                l_int32    operation)
+{
+l_int32          w, h, wpl, wplb, bw, bh, i, j, k, y, y0, y1, sign;
+l_int32          bandh, nwords, nterms, op, dymax, endbits, ok, simd;
+l_int32         *ty0;
+l_uint32         endmask;
+l_uint32        *datab, *datadb, *datad, *lined;
+l_uint32       **datat;
+DWA_PLAN_GROUP  *group;
+DWA_TERM        *terms;
+PIX             *pixb, *pixd;
+
+    PROCNAME("pixApplyDwaPlan");
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = (w + 31) / 32;  /* of pixd; pixs may be a view with more */
+    sign = (operation == L_MORPH_DILATE) ? -1 : 1;
+    op = (operation == L_MORPH_DILATE) ? L_DWA_OR : L_DWA_AND;
+    simd = l_getSimdMode();
+
+        /* Copy to a buffer with a border holding the outside value.
+         * The border is wide enough that a shifted word never reads
+         * past it.  datab is at pixel (0, 0). */
+    bw = (plan->maxdx + 31) / 32 + 1;
+    bh = plan->maxdy;
+    wplb = wpl + 2 * bw;
+    if ((pixb = pixCreate(32 * wplb, h + 2 * bh, 1)) == NULL)
+        return (PIX *)ERROR_PTR("pixb not made", procName, NULL);
+    if (operation == L_MORPH_ERODE &&
+        getMorphBorderPixelColor(L_MORPH_ERODE, 1) == 1)
+        pixSetAll(pixb);
+    pixRasterop(pixb, 32 * bw, bh, w, h, PIX_SRC, pixs, 0, 0);
+    datab = pixGetData(pixb) + bh * wplb + bw;
+
+        /* Compute the groups that are used by more than one row,
+         * for the lines from ty0[k] to h + dymax that are needed.
+         * datat[k] is at pixel (0, ty0[k]).  Misses are only used
+         * for the hmt. */
+    ok = TRUE;
+    datadb = (l_uint32 *)LEPT_CALLOC(h * wplb, sizeof(l_uint32));
+    datat = (l_uint32 **)LEPT_CALLOC(L_MAX(1, plan->ngroups),
+                                     sizeof(l_uint32 *));
+    ty0 = (l_int32 *)LEPT_CALLOC(L_MAX(1, plan->ngroups), sizeof(l_int32));
+    terms = (DWA_TERM *)LEPT_CALLOC(L_MAX(1, plan->nterms),
+                                    sizeof(DWA_TERM));
+    if (!datadb || !datat || !ty0 || !terms)
+        ok = FALSE;
+    for (k = 0; k < plan->ngroups && ok; k++) {
+        group = &plan->groups[k];
+        if (group->ny < 2 || (group->miss && operation != L_MORPH_HMT))
+            continue;
+        ty0[k] = dymax = sign * group->dy[0];
+        for (i = 1; i < group->ny; i++) {
+            ty0[k] = L_MIN(ty0[k], sign * group->dy[i]);
+            dymax = L_MAX(dymax, sign * group->dy[i]);
+        }
+        datat[k] = (l_uint32 *)LEPT_CALLOC((h + dymax - ty0[k]) * wplb,
+                                           sizeof(l_uint32));
+        if (!datat[k]) {
+            ok = FALSE;
+            break;
+        }
+        datat[k] += bw;
+        for (j = 0; j < group->nx; j++)
+            dwaSetTerm(&terms[j], datab + ty0[k] * wplb, sign * group->dx[j],
+                       group->miss);
+        nwords = (h + dymax - ty0[k] - 1) * wplb + wpl;
+        dwaCombineLine(datat[k], nwords, terms, group->nx,
+                       (group->miss) ? L_DWA_AND : op, simd);
+    }
+
+        /* Combine the groups into each band of the result */
+    bandh = L_MAX(1, DWA_BAND_BYTES / (4 * wplb));
+    for (y0 = 0; y0 < h && ok; y0 += bandh) {
+        y1 = L_MIN(h, y0 + bandh);
+        nterms = 0;
+        for (k = 0; k < plan->ngroups; k++) {
+            group = &plan->groups[k];
+            if (group->miss && operation != L_MORPH_HMT)
+                continue;
+            for (i = 0; i < group->ny; i++) {
+                y = y0 + sign * group->dy[i];
+                if (datat[k]) {
+                    dwaSetTerm(&terms[nterms++],
+                               datat[k] + (y - ty0[k]) * wplb, 0, 0);
+                    continue;
+                }
+                for (j = 0; j < group->nx; j++)
+                    dwaSetTerm(&terms[nterms++], datab + y * wplb,
+                               sign * group->dx[j], group->miss);
+            }
+        }
+        lined = datadb + y0 * wplb + bw;
+        nwords = (y1 - y0 - 1) * wplb + wpl;
+        dwaCombineLine(lined, nwords, terms, nterms, op, simd);
+    }
+
+        /* Copy the result to pixd, clearing the padding bits at the
+         * end of each line */
+    pixd = (ok) ? pixCreateTemplateNoInit(pixs) : NULL;
+    if (pixd) {
+        datad = pixGetData(pixd);
+        endbits = w & 31;
+        endmask = (endbits) ? 0xffffffff << (32 - endbits) : 0xffffffff;
+        for (y = 0; y < h; y++) {
+            memcpy(datad + y * wpl, datadb + y * wplb + bw, 4 * wpl);
+            datad[y * wpl + wpl - 1] &= endmask;
+        }
+    }
+
+    for (k = 0; k < plan->ngroups && datat; k++) {
+        if (datat[k])
+            LEPT_FREE(datat[k] - bw);
+    }
+    LEPT_FREE(datat);
+    LEPT_FREE(ty0);
+    LEPT_FREE(terms);
+    LEPT_FREE(datadb);
+    pixDestroy(&pixb);
+    if (!pixd)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    return pixd;
+}
+
+
+/*!
+ *  dwaSetTerm()
+ *
+ *      Input:  term (to be set)
+ *              lines (source words, at the position of the first
+ *                     destination word)
+ *              shift (the destination pixel at x is made from the
+ *                     source pixel at x + shift)
+ *              invert (1 to invert the source; 0 otherwise)
+ *      Return: void
+ */
+static void
+dwaSetTerm(DWA_TERM  *term,
+           l_uint32  *lines,
+           l_int32    shift,
+           l_int32    invert)
+{
+l_int32  q;
+
+    q = (shift >= 0) ? shift / 32 : -((31 - shift) / 32);
+    term->ps = lines + q;
+    term->r = shift - 32 * q;  /* 0 <= r < 32 */
+    term->inv = (invert) ? 0xffffffff : 0;
+}
+
+
+/*!
+ *  dwaCombineLine()
+ *
+ *      Input:  lined (destination words)
+ *              nwords (number of words to write in lined)
+ *              terms (array of shifted sources)
+ *              nterms (number of terms; can be 0)
+ *              op (L_DWA_AND, L_DWA_OR)
+ *              simd (simd mode)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This sets each word of lined to the AND or the OR of the
+ *          terms.  With no terms, it is all 1s for AND and all 0s for OR.
+ *      (2) A shifted word is made from two adjacent source words with
+ *          a barrel shift, as in the generated dwa code.  The second
+ *          word is only read for a term with r > 0, so a source with
+ *          no border can be used with r == 0.
+ */
+static void
+dwaCombineLine(l_uint32  *lined,
+               l_int32    nwords,
+               DWA_TERM  *terms,
+               l_int32    nterms,
+               l_int32    op,
+               l_int32    simd)
+{
+l_int32    i, k, kstart, r, rc;
+l_uint32   inv;
+l_uint32  *ps;
+
+    kstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        kstart = dwaCombineLineAvx2(lined, nwords, terms, nterms, op);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        kstart = dwaCombineLineSse2(lined, nwords, terms, nterms, op);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        kstart = dwaCombineLineNeon(lined, nwords, terms, nterms, op);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+    if (kstart >= nwords)
+        return;
+
+    for (k = kstart; k < nwords; k++)
+        lined[k] = (op == L_DWA_AND) ? 0xffffffff : 0;
+    for (i = 0; i < nterms; i++) {
+        ps = terms[i].ps;
+        r = terms[i].r;
+        rc = 32 - r;
+        inv = terms[i].inv;
+        if (r == 0 && op == L_DWA_AND) {
+            for (k = kstart; k < nwords; k++)
+                lined[k] &= ps[k] ^ inv;
+        } else if (r == 0) {
+            for (k = kstart; k < nwords; k++)
+                lined[k] |= ps[k] ^ inv;
+        } else if (op == L_DWA_AND) {
+            for (k = kstart; k < nwords; k++)
+                lined[k] &= ((ps[k] << r) | (ps[k + 1] >> rc)) ^ inv;
+        } else {
+            for (k = kstart; k < nwords; k++)
+                lined[k] |= ((ps[k] << r) | (ps[k + 1] >> rc)) ^ inv;
+        }
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of words
+     * it has done; the rest are done by the caller.  The terms are
+     * combined in registers, and each destination vector is stored
+     * once. */
+#if L_HAVE_SSE2
+static l_int32
+dwaCombineLineSse2(l_uint32  *lined,
+                   l_int32    n,
+                   DWA_TERM  *terms,
+                   l_int32    nterms,
+                   l_int32    op)
+{
+l_int32   i, k, r;
+__m128i   init, v, d;
+
+    init = _mm_set1_epi32((op == L_DWA_AND) ? -1 : 0);
+    for (k = 0; k + 4 <= n; k += 4) {
+        d = init;
+        for (i = 0; i < nterms; i++) {
+            v = _mm_loadu_si128((const __m128i *)(terms[i].ps + k));
+            if ((r = terms[i].r) > 0) {
+                v = _mm_or_si128(_mm_sll_epi32(v, _mm_cvtsi32_si128(r)),
+                        _mm_srl_epi32(_mm_loadu_si128(
+                            (const __m128i *)(terms[i].ps + k + 1)),
+                            _mm_cvtsi32_si128(32 - r)));
+            }
+            v = _mm_xor_si128(v, _mm_set1_epi32(terms[i].inv));
+            d = (op == L_DWA_AND) ? _mm_and_si128(d, v) : _mm_or_si128(d, v);
+        }
+        _mm_storeu_si128((__m128i *)(lined + k), d);
+    }
+    return k;
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+static l_int32
+dwaCombineLineAvx2(l_uint32  *lined,
+                   l_int32    n,
+                   DWA_TERM  *terms,
+                   l_int32    nterms,
+                   l_int32    op)
+{
+l_int32   i, k, r;
+__m256i   init, v, d;
+
+    init = _mm256_set1_epi32((op == L_DWA_AND) ? -1 : 0);
+    for (k = 0; k + 8 <= n; k += 8) {
+        d = init;
+        for (i = 0; i < nterms; i++) {
+            v = _mm256_loadu_si256((const __m256i *)(terms[i].ps + k));
+            if ((r = terms[i].r) > 0) {
+                v = _mm256_or_si256(_mm256_sll_epi32(v, _mm_cvtsi32_si128(r)),
+                        _mm256_srl_epi32(_mm256_loadu_si256(
+                            (const __m256i *)(terms[i].ps + k + 1)),
+                            _mm_cvtsi32_si128(32 - r)));
+            }
+            v = _mm256_xor_si256(v, _mm256_set1_epi32(terms[i].inv));
+            d = (op == L_DWA_AND) ? _mm256_and_si256(d, v)
+                                  : _mm256_or_si256(d, v);
+        }
+        _mm256_storeu_si256((__m256i *)(lined + k), d);
+    }
+    return k;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+static l_int32
+dwaCombineLineNeon(l_uint32  *lined,
+                   l_int32    n,
+                   DWA_TERM  *terms,
+                   l_int32    nterms,
+                   l_int32    op)
+{
+l_int32     i, k, r;
+uint32x4_t  init, v, d;
+
+    init = vdupq_n_u32((op == L_DWA_AND) ? 0xffffffff : 0);
+    for (k = 0; k + 4 <= n; k += 4) {
+        d = init;
+        for (i = 0; i < nterms; i++) {
+            v = vld1q_u32(terms[i].ps + k);
+            if ((r = terms[i].r) > 0) {
+                v = vorrq_u32(vshlq_u32(v, vdupq_n_s32(r)),
+                              vshlq_u32(vld1q_u32(terms[i].ps + k + 1),
+                                        vdupq_n_s32(r - 32)));
+            }
+            v = veorq_u32(v, vdupq_n_u32(terms[i].inv));
+            d = (op == L_DWA_AND) ? vandq_u32(d, v) : vorrq_u32(d, v);
+        }
+        vst1q_u32(lined + k, d);
+    }
+    return k;
+}
+#endif  /* L_HAVE_NEON */
+
+
+/*!
+ *  dwaPlanLock(), dwaPlanUnlock()
+ *
+ *      Notes:
+ *          (1) The cache lock is made by the first call to dwaPlanLock(),
+ *              and kept until the program exits.  Without thread
+ *              support these are no-ops.
+ */
+static void
+dwaPlanLock(void)
+{
+    l_mutexLock(l_mutexGetStatic(&var_DWA_PLAN_LOCK));
+}
+
+
+static void
+dwaPlanUnlock(void)
+{
+    l_mutexUnlock(var_DWA_PLAN_LOCK);
+}
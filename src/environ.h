@@ -126,6 +126,15 @@ typedef uintptr_t l_uintptr_t;
 #define  HAVE_FMEMOPEN    1
 #endif  /* ! HAVE_CONFIG_H etc. */
 
+/*
+ * Some operations can split their work among several threads; see
+ * parallel.c.  This uses posix threads, and requires HAVE_LIBPTHREAD
+ * to be 1.  Otherwise, all the work is done in the calling thread.
+ */
+#if !defined(HAVE_CONFIG_H) && !defined(ANDROID_BUILD) && !defined(_WIN32)
+#define  HAVE_LIBPTHREAD  1
+#endif  /* ! HAVE_CONFIG_H etc. */
+
 
 /*--------------------------------------------------------------------*
  * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*
@@ -177,6 +186,61 @@ typedef unsigned long long      l_uint64;
 #endif  /* COMPILER_MSVC */
 
 
+/*--------------------------------------------------------------------*
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*
+ *                          USER CONFIGURABLE                         *
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*
+ *                    Atomic reference counting                       *
+ *--------------------------------------------------------------------*/
+/*
+ *  The refcounted structs (pix, pixa, box, boxa, pta, numa, l_dna,
+ *  sarray, l_bytea, fpix, fpixa, dpix and ccbord) hold their ref
+ *  count in an l_atomic.  By default this is a plain integer, and
+ *  handles to the same struct must not be cloned or destroyed
+ *  concurrently from different threads.
+ *  Setting USE_ATOMIC_REFCOUNT to 1, either here or on the compile
+ *  line (cmake -DATOMIC_REFCOUNT=ON, or configure --enable-atomic-refcount),
+ *  makes l_atomic a C11 atomic_int.  Then clones of a struct can be
+ *  handed to several threads, each of which destroys its own handle.
+ *  This requires a C11 compiler that provides <stdatomic.h>; otherwise
+ *  the plain integer is used.  Note that it makes only the ref counts
+ *  thread-safe: the contents of a struct must still not be modified
+ *  in one thread while it is being used in another.
+ */
+#ifndef USE_ATOMIC_REFCOUNT
+#define  USE_ATOMIC_REFCOUNT   0
+#endif
+
+#if USE_ATOMIC_REFCOUNT && !defined(__cplusplus) && \
+    defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+    !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define  L_HAVE_ATOMIC_REFCOUNT   1
+typedef atomic_int              l_atomic;
+#else
+#define  L_HAVE_ATOMIC_REFCOUNT   0
+typedef l_int32                 l_atomic;
+#endif
+
+
+/*--------------------------------------------------------------------*
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*
+ *                          USER CONFIGURABLE                         *
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*
+ *                     Vector instruction sets                        *
+ *--------------------------------------------------------------------*/
+/*
+ *  Some low-level operations have kernels that use vector instructions
+ *  (SSE2 or AVX2 on x86, NEON on ARM).  The instruction set is chosen
+ *  at run time; see simd.c.  All kernels give exactly the same result
+ *  as the portable C code.  Setting L_USE_SIMD to 0 compiles the
+ *  library with the portable C code only.
+ */
+#ifndef L_USE_SIMD
+#define  L_USE_SIMD   1
+#endif
+
+
 /*------------------------------------------------------------------------*
  *                            Standard macros                             *
  *------------------------------------------------------------------------*/
@@ -245,6 +309,18 @@ enum {
 };
 
 
+/*------------------------------------------------------------------------*
+ *                        Vector instruction sets                         *
+ *------------------------------------------------------------------------*/
+enum {
+    L_SIMD_NONE = 0,            /* portable C code only                   */
+    L_SIMD_SSE2 = 1,            /* x86 SSE2                               */
+    L_SIMD_AVX2 = 2,            /* x86 AVX2                               */
+    L_SIMD_NEON = 3,            /* ARM NEON                               */
+    L_SIMD_AUTO = 4             /* best available; for l_setSimdMode()    */
+};
+
+
 /*------------------------------------------------------------------------*
  *                          Timing structs                                *
  *------------------------------------------------------------------------*/
@@ -363,8 +363,7 @@ FPIX       *fpix;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the fpix. */
-    fpixChangeRefcount(fpix, -1);
-    if (fpixGetRefcount(fpix) <= 0) {
+    if (--fpix->refcount <= 0) {
         if ((data = fpixGetData(fpix)) != NULL)
             LEPT_FREE(data);
         LEPT_FREE(fpix);
@@ -719,8 +718,7 @@ FPIXA   *fpixa;
         return;
 
         /* Decrement the refcount.  If it is 0, destroy the pixa. */
-    fpixaChangeRefcount(fpixa, -1);
-    if (fpixa->refcount <= 0) {
+    if (--fpixa->refcount <= 0) {
         for (i = 0; i < fpixa->n; i++)
             fpixDestroy(&fpixa->fpix[i]);
         LEPT_FREE(fpixa->fpix);
@@ -1269,8 +1267,7 @@ DPIX       *dpix;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the dpix. */
-    dpixChangeRefcount(dpix, -1);
-    if (dpixGetRefcount(dpix) <= 0) {
+    if (--dpix->refcount <= 0) {
         if ((data = dpixGetData(dpix)) != NULL)
             LEPT_FREE(data);
         LEPT_FREE(dpix);
@@ -0,0 +1,1176 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  g4codec.c
+ *
+ *      Ccitt group 4 (T.6) coding of 1 bpp images in memory
+ *           l_int32       pixEncodeG4()
+ *           PIX          *pixDecodeG4()
+ *
+ *      Single strip g4 tiff in memory
+ *           l_int32       pixEncodeG4Tiff()
+ *           PIX          *pixDecodeG4Tiff()
+ *
+ *      Static helpers
+ *           static l_int32       g4CountLeadingZeros()
+ *           static l_int32       g4FindChange()
+ *           static l_int32       g4GetChanges()
+ *           static void          g4SetRun()
+ *           static l_int32       g4PutBits()
+ *           static l_int32       g4PutRun()
+ *           static l_uint32      g4PeekBits()
+ *           static l_int32       g4ReadMode()
+ *           static l_int32       g4ReadRun()
+ *           static void          g4MakeRunTable()
+ *           static void          g4PutTiffValue()
+ *           static void          g4PutTiffEntry()
+ *           static l_uint32      g4GetTiffValue()
+ *           static l_int32       g4GetTiffElement()
+ *
+ *    This is a self-contained codec for the 2D coding scheme used by
+ *    fax machines and by g4 compressed tiff.  It does not require
+ *    libtiff, so 1 bpp images can be g4 compressed for pdf and
+ *    PostScript, and for pixcomp, in builds without libtiff.
+ *    The encoded data is the same as that generated by libtiff.
+ *
+ *    Each raster line is converted to a sorted array of the positions
+ *    of its changing elements.  The changes are found a word at a time
+ *    directly on the pix data, using a count of leading zeroes on the
+ *    word (possibly inverted) that holds the next pixel to be examined.
+ *    Coding and decoding work on the arrays of changes for the current
+ *    line and the reference (previous) line, and the black runs of a
+ *    decoded line are set with word masks.
+ *
+ *    The array for a line holds the changing elements in order, starting
+ *    with a change from white to black; i.e., entries with even index
+ *    are changes to black and those with odd index are changes to white.
+ *    It is terminated by 4 entries with the value w, so that the
+ *    searches for b1 and b2 never run off the end.  The reference line
+ *    for the first line is white.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Codes for runs of 0 to 63 (terminating codes), followed by the
+     * makeup codes for runs of 64 to 2560 in steps of 64.  Each is
+     * given as {number of bits, code}.  The makeup codes for 1792 and
+     * larger are shared by white and black runs.  */
+static const l_uint16  WhiteCodes[104][2] = {
+    { 8, 0x035}, { 6, 0x007}, { 4, 0x007}, { 4, 0x008}, { 4, 0x00b},
+    { 4, 0x00c}, { 4, 0x00e}, { 4, 0x00f}, { 5, 0x013}, { 5, 0x014},
+    { 5, 0x007}, { 5, 0x008}, { 6, 0x008}, { 6, 0x003}, { 6, 0x034},
+    { 6, 0x035}, { 6, 0x02a}, { 6, 0x02b}, { 7, 0x027}, { 7, 0x00c},
+    { 7, 0x008}, { 7, 0x017}, { 7, 0x003}, { 7, 0x004}, { 7, 0x028},
+    { 7, 0x02b}, { 7, 0x013}, { 7, 0x024}, { 7, 0x018}, { 8, 0x002},
+    { 8, 0x003}, { 8, 0x01a}, { 8, 0x01b}, { 8, 0x012}, { 8, 0x013},
+    { 8, 0x014}, { 8, 0x015}, { 8, 0x016}, { 8, 0x017}, { 8, 0x028},
+    { 8, 0x029}, { 8, 0x02a}, { 8, 0x02b}, { 8, 0x02c}, { 8, 0x02d},
+    { 8, 0x004}, { 8, 0x005}, { 8, 0x00a}, { 8, 0x00b}, { 8, 0x052},
+    { 8, 0x053}, { 8, 0x054}, { 8, 0x055}, { 8, 0x024}, { 8, 0x025},
+    { 8, 0x058}, { 8, 0x059}, { 8, 0x05a}, { 8, 0x05b}, { 8, 0x04a},
+    { 8, 0x04b}, { 8, 0x032}, { 8, 0x033}, { 8, 0x034}, { 5, 0x01b},
+    { 5, 0x012}, { 6, 0x017}, { 7, 0x037}, { 8, 0x036}, { 8, 0x037},
+    { 8, 0x064}, { 8, 0x065}, { 8, 0x068}, { 8, 0x067}, { 9, 0x0cc},
+    { 9, 0x0cd}, { 9, 0x0d2}, { 9, 0x0d3}, { 9, 0x0d4}, { 9, 0x0d5},
+    { 9, 0x0d6}, { 9, 0x0d7}, { 9, 0x0d8}, { 9, 0x0d9}, { 9, 0x0da},
+    { 9, 0x0db}, { 9, 0x098}, { 9, 0x099}, { 9, 0x09a}, { 6, 0x018},
+    { 9, 0x09b}, {11, 0x008}, {11, 0x00c}, {11, 0x00d}, {12, 0x012},
+    {12, 0x013}, {12, 0x014}, {12, 0x015}, {12, 0x016}, {12, 0x017},
+    {12, 0x01c}, {12, 0x01d}, {12, 0x01e}, {12, 0x01f}
+};
+
+static const l_uint16  BlackCodes[104][2] = {
+    {10, 0x037}, { 3, 0x002}, { 2, 0x003}, { 2, 0x002}, { 3, 0x003},
+    { 4, 0x003}, { 4, 0x002}, { 5, 0x003}, { 6, 0x005}, { 6, 0x004},
+    { 7, 0x004}, { 7, 0x005}, { 7, 0x007}, { 8, 0x004}, { 8, 0x007},
+    { 9, 0x018}, {10, 0x017}, {10, 0x018}, {10, 0x008}, {11, 0x067},
+    {11, 0x068}, {11, 0x06c}, {11, 0x037}, {11, 0x028}, {11, 0x017},
+    {11, 0x018}, {12, 0x0ca}, {12, 0x0cb}, {12, 0x0cc}, {12, 0x0cd},
+    {12, 0x068}, {12, 0x069}, {12, 0x06a}, {12, 0x06b}, {12, 0x0d2},
+    {12, 0x0d3}, {12, 0x0d4}, {12, 0x0d5}, {12, 0x0d6}, {12, 0x0d7},
+    {12, 0x06c}, {12, 0x06d}, {12, 0x0da}, {12, 0x0db}, {12, 0x054},
+    {12, 0x055}, {12, 0x056}, {12, 0x057}, {12, 0x064}, {12, 0x065},
+    {12, 0x052}, {12, 0x053}, {12, 0x024}, {12, 0x037}, {12, 0x038},
+    {12, 0x027}, {12, 0x028}, {12, 0x058}, {12, 0x059}, {12, 0x02b},
+    {12, 0x02c}, {12, 0x05a}, {12, 0x066}, {12, 0x067}, {10, 0x00f},
+    {12, 0x0c8}, {12, 0x0c9}, {12, 0x05b}, {12, 0x033}, {12, 0x034},
+    {12, 0x035}, {13, 0x06c}, {13, 0x06d}, {13, 0x04a}, {13, 0x04b},
+    {13, 0x04c}, {13, 0x04d}, {13, 0x072}, {13, 0x073}, {13, 0x074},
+    {13, 0x075}, {13, 0x076}, {13, 0x077}, {13, 0x052}, {13, 0x053},
+    {13, 0x054}, {13, 0x055}, {13, 0x05a}, {13, 0x05b}, {13, 0x064},
+    {13, 0x065}, {11, 0x008}, {11, 0x00c}, {11, 0x00d}, {12, 0x012},
+    {12, 0x013}, {12, 0x014}, {12, 0x015}, {12, 0x016}, {12, 0x017},
+    {12, 0x01c}, {12, 0x01d}, {12, 0x01e}, {12, 0x01f}
+};
+
+    /* Number of bits looked up at once when decoding runs; this is the
+     * length of the longest run code */
+static const l_int32  G4_RUN_BITS = 13;
+
+    /* Modes of 2D coding */
+enum {
+    G4_VERTICAL = 0,
+    G4_PASS = 1,
+    G4_HORIZONTAL = 2,
+    G4_INVALID = 3
+};
+
+struct G4BitWriter
+{
+    l_uint8   *data;       /* encoded bytes                              */
+    l_int32    nalloc;     /* size of data array                         */
+    l_int32    nbytes;     /* number of bytes written                    */
+    l_uint32   buf;        /* bits not yet written, in the low bits      */
+    l_int32    nbits;      /* number of bits in buf; always < 8 on exit  */
+};
+typedef struct G4BitWriter  G4_BITWRITER;
+
+struct G4BitReader
+{
+    const l_uint8  *data;  /* encoded bytes                              */
+    size_t          size;  /* number of encoded bytes                    */
+    size_t          pos;   /* index of next byte to be loaded into buf   */
+    l_uint32        buf;   /* bits not yet read, in the low bits         */
+    l_int32         nbits; /* number of bits in buf                      */
+};
+typedef struct G4BitReader  G4_BITREADER;
+
+static l_int32 g4CountLeadingZeros(l_uint32 word);
+static l_int32 g4FindChange(const l_uint32 *line, l_int32 x, l_int32 w,
+                            l_int32 color);
+static l_int32 g4GetChanges(const l_uint32 *line, l_int32 w,
+                            l_int32 *changes);
+static void g4SetRun(l_uint32 *line, l_int32 start, l_int32 end);
+static l_int32 g4PutBits(G4_BITWRITER *bw, l_uint32 code, l_int32 len);
+static l_int32 g4PutRun(G4_BITWRITER *bw, l_int32 run, l_int32 color);
+static l_uint32 g4PeekBits(G4_BITREADER *br, l_int32 n);
+static l_int32 g4ReadMode(G4_BITREADER *br, l_int32 *pdelta);
+static l_int32 g4ReadRun(G4_BITREADER *br, const l_uint16 *table,
+                         l_int32 w);
+static void g4MakeRunTable(const l_uint16 codes[][2], l_uint16 *table);
+static void g4PutTiffValue(l_uint8 *p, l_uint32 value, l_int32 nbytes);
+static void g4PutTiffEntry(l_uint8 *p, l_int32 tag, l_int32 type,
+                           l_uint32 count, l_uint32 value);
+static l_uint32 g4GetTiffValue(const l_uint8 *p, l_int32 nbytes,
+                               l_int32 bigend);
+static l_int32 g4GetTiffElement(const l_uint8 *data, size_t size,
+                                const l_uint8 *entry, l_uint32 index,
+                                l_int32 bigend, l_uint32 *pval);
+
+
+/*---------------------------------------------------------------------*
+ *                 Ccitt group 4 coding of 1 bpp images                *
+ *---------------------------------------------------------------------*/
+/*!
+ *  pixEncodeG4()
+ *
+ *      Input:  &data (<return> g4 encoded data)
+ *              &nbytes (<return> size of encoded data)
+ *              pixs (1 bpp)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The output is the raw ccitt g4 (T.6) data for pixs, with
+ *          fill order msb-to-lsb, black as the 1 (foreground) pixel,
+ *          and terminated by an end-of-facsimile-block (EOFB).
+ *          It is suitable for /CCITTFaxDecode with K = -1 in pdf and
+ *          PostScript, and for a g4 compressed tiff strip.
+ *      (2) Only the pixels within the image width are examined; the
+ *          padding bits at the end of each raster line are ignored.
+ */
+l_int32
+pixEncodeG4(l_uint8  **pdata,
+            size_t    *pnbytes,
+            PIX       *pixs)
+{
+l_int32        w, h, wpl, i, ai, bi, a0, a1, a2, b1, b2, d, color, ret;
+l_int32       *cur, *refs, *tmp;
+l_uint32      *datas, *lines;
+G4_BITWRITER   bw;
+
+    PROCNAME("pixEncodeG4");
+
+    if (!pdata)
+        return ERROR_INT("&data not defined", procName, 1);
+    *pdata = NULL;
+    if (!pnbytes)
+        return ERROR_INT("&nbytes not defined", procName, 1);
+    *pnbytes = 0;
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return ERROR_INT("pixs not defined or not 1 bpp", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = pixGetWpl(pixs);
+    datas = pixGetData(pixs);
+    cur = (l_int32 *)LEPT_CALLOC(w + 8, sizeof(l_int32));
+    refs = (l_int32 *)LEPT_CALLOC(w + 8, sizeof(l_int32));
+    memset(&bw, 0, sizeof(G4_BITWRITER));
+    bw.nalloc = L_MAX(256, wpl * h / 2);
+    bw.data = (l_uint8 *)LEPT_CALLOC(bw.nalloc, sizeof(l_uint8));
+    if (!cur || !refs || !bw.data) {
+        LEPT_FREE(cur);
+        LEPT_FREE(refs);
+        LEPT_FREE(bw.data);
+        return ERROR_INT("arrays not made", procName, 1);
+    }
+
+        /* The reference line for the first line is white */
+    refs[0] = refs[1] = refs[2] = refs[3] = w;
+
+    ret = 0;
+    for (i = 0; i < h && ret == 0; i++) {
+        lines = datas + i * wpl;
+        g4GetChanges(lines, w, cur);
+
+            /* Start with an imaginary white pixel to the left of
+             * the line, and code the changes up to the end */
+        a0 = -1;
+        color = 0;
+        ai = bi = 0;
+        while (a0 < w && ret == 0) {
+            while (cur[ai] <= a0)
+                ai++;
+            a1 = cur[ai];
+            while (bi > 0 && refs[bi - 1] > a0)
+                bi--;
+            while (refs[bi] <= a0 || (bi & 1) != color)
+                bi++;
+            b1 = refs[bi];
+            b2 = refs[bi + 1];
+            d = a1 - b1;
+            if (b2 < a1) {  /* pass mode */
+                ret = g4PutBits(&bw, 0x1, 4);
+                a0 = b2;
+            } else if (d >= -3 && d <= 3) {  /* vertical mode */
+                    /* 1, 011, 000011, 0000011 for d = 0, 1, 2, 3,
+                     * and 010, 000010, 0000010 for d = -1, -2, -3 */
+                if (d == 0)
+                    ret = g4PutBits(&bw, 0x1, 1);
+                else if (d == 1 || d == -1)
+                    ret = g4PutBits(&bw, (d > 0) ? 0x3 : 0x2, 3);
+                else
+                    ret = g4PutBits(&bw, (d > 0) ? 0x3 : 0x2, L_ABS(d) + 4);
+                a0 = a1;
+                color ^= 1;
+            } else {  /* horizontal mode */
+                a2 = cur[ai + 1];
+                ret = g4PutBits(&bw, 0x1, 3);
+                ret += g4PutRun(&bw, a1 - L_MAX(a0, 0), color);
+                ret += g4PutRun(&bw, a2 - a1, color ^ 1);
+                a0 = a2;
+            }
+        }
+        tmp = refs;
+        refs = cur;
+        cur = tmp;
+    }
+
+        /* Add the EOFB and flush the last byte */
+    if (ret == 0) {
+        ret = g4PutBits(&bw, 0x1, 12);
+        ret += g4PutBits(&bw, 0x1, 12);
+        if (bw.nbits > 0)
+            ret += g4PutBits(&bw, 0, 8 - bw.nbits);
+    }
+
+    LEPT_FREE(cur);
+    LEPT_FREE(refs);
+    if (ret) {
+        LEPT_FREE(bw.data);
+        return ERROR_INT("g4 data not made", procName, 1);
+    }
+    *pdata = bw.data;
+    *pnbytes = bw.nbytes;
+    return 0;
+}
+
+
+/*!
+ *  pixDecodeG4()
+ *
+ *      Input:  data (g4 encoded data)
+ *              nbytes (size of encoded data)
+ *              w, h (of the image)
+ *      Return: pixd (1 bpp), or null on error
+ *
+ *  Notes:
+ *      (1) This decodes raw ccitt g4 (T.6) data with fill order
+ *          msb-to-lsb, as made by pixEncodeG4(), where the 1 bits
+ *          in the decoded image are black.  Decoding stops after
+ *          h lines, so the EOFB is optional.
+ *      (2) The data is validated as it is decoded, and null is returned
+ *          for invalid codes, changes that would not advance along a
+ *          line or would go past its end, and data that is truncated.
+ */
+PIX *
+pixDecodeG4(const l_uint8  *data,
+            size_t          nbytes,
+            l_int32         w,
+            l_int32         h)
+{
+l_int32        wpld, i, k, n, bi, a0, a1, a2, b1, b2, mode, delta;
+l_int32        color, run1, run2, error;
+l_int32       *cur, *refs, *tmp;
+l_uint16      *wtab, *btab;
+l_uint32      *datad, *lined;
+G4_BITREADER   br;
+PIX           *pixd;
+
+    PROCNAME("pixDecodeG4");
+
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if (w <= 0 || h <= 0)
+        return (PIX *)ERROR_PTR("invalid w or h", procName, NULL);
+
+    if ((pixd = pixCreate(w, h, 1)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    wpld = pixGetWpl(pixd);
+    datad = pixGetData(pixd);
+    cur = (l_int32 *)LEPT_CALLOC(w + 8, sizeof(l_int32));
+    refs = (l_int32 *)LEPT_CALLOC(w + 8, sizeof(l_int32));
+    wtab = (l_uint16 *)LEPT_CALLOC(1 << G4_RUN_BITS, sizeof(l_uint16));
+    btab = (l_uint16 *)LEPT_CALLOC(1 << G4_RUN_BITS, sizeof(l_uint16));
+    if (!cur || !refs || !wtab || !btab) {
+        pixDestroy(&pixd);
+        LEPT_FREE(cur);
+        LEPT_FREE(refs);
+        LEPT_FREE(wtab);
+        LEPT_FREE(btab);
+        return (PIX *)ERROR_PTR("arrays not made", procName, NULL);
+    }
+    g4MakeRunTable(WhiteCodes, wtab);
+    g4MakeRunTable(BlackCodes, btab);
+    memset(&br, 0, sizeof(G4_BITREADER));
+    br.data = data;
+    br.size = nbytes;
+
+    refs[0] = refs[1] = refs[2] = refs[3] = w;
+    error = FALSE;
+    for (i = 0; i < h && !error; i++) {
+        a0 = -1;
+        color = 0;
+        n = 0;
+        bi = 0;
+        while (a0 < w) {
+            while (bi > 0 && refs[bi - 1] > a0)
+                bi--;
+            while (refs[bi] <= a0 || (bi & 1) != color)
+                bi++;
+            b1 = refs[bi];
+            b2 = refs[bi + 1];
+            mode = g4ReadMode(&br, &delta);
+            if (mode == G4_PASS) {
+                a0 = b2;
+                continue;
+            } else if (mode == G4_VERTICAL) {
+                a1 = b1 + delta;
+                if (a1 <= a0 || a1 > w) {
+                    error = TRUE;
+                    break;
+                }
+                cur[n++] = a1;
+                a0 = a1;
+                color ^= 1;
+            } else if (mode == G4_HORIZONTAL) {
+                run1 = g4ReadRun(&br, (color == 0) ? wtab : btab, w);
+                run2 = g4ReadRun(&br, (color == 0) ? btab : wtab, w);
+                if (run1 < 0 || run2 < 0) {
+                    error = TRUE;
+                    break;
+                }
+                a1 = L_MAX(a0, 0) + run1;
+                a2 = a1 + run2;
+                if (a2 <= a0 || a2 > w) {
+                    error = TRUE;
+                    break;
+                }
+                    /* A change at the same place as the previous one
+                     * cancels it; this keeps the changes increasing */
+                if (n > 0 && cur[n - 1] == a1)
+                    n--;
+                else
+                    cur[n++] = a1;
+                if (n > 0 && cur[n - 1] == a2)
+                    n--;
+                else
+                    cur[n++] = a2;
+                a0 = a2;
+            } else {
+                error = TRUE;
+                break;
+            }
+        }
+        if (error || 8 * br.pos - br.nbits > 8 * nbytes) {
+            error = TRUE;
+            break;
+        }
+
+            /* Set the black runs, and make this the reference line */
+        cur[n] = cur[n + 1] = cur[n + 2] = cur[n + 3] = w;
+        lined = datad + i * wpld;
+        for (k = 0; k < n; k += 2)
+            g4SetRun(lined, cur[k], cur[k + 1]);
+        tmp = refs;
+        refs = cur;
+        cur = tmp;
+    }
+
+    LEPT_FREE(cur);
+    LEPT_FREE(refs);
+    LEPT_FREE(wtab);
+    LEPT_FREE(btab);
+    if (error) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("invalid or truncated g4 data",
+                                procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                   Single strip g4 tiff in memory                    *
+ *---------------------------------------------------------------------*/
+/*!
+ *  pixEncodeG4Tiff()
+ *
+ *      Input:  &data (<return> g4 compressed tiff data)
+ *              &size (<return> size of tiff data)
+ *              pixs (1 bpp)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This writes a little-endian tiff file in memory, without
+ *          libtiff.  The image is a single g4 compressed strip starting
+ *          at byte 8, followed by the image directory, which is the
+ *          layout expected by extractG4DataFromMem().
+ *      (2) As with pixWriteMemTiff(), the image is minisblack = 0,
+ *          and the resolution defaults to 300 ppi if not set.
+ *      (3) The text field of pixs is not written.
+ */
+l_int32
+pixEncodeG4Tiff(l_uint8  **pdata,
+                size_t    *psize,
+                PIX       *pixs)
+{
+l_uint8  *g4data, *data, *p;
+l_int32   w, h, xres, yres, diroff, ratoff;
+size_t    nbytes, size;
+
+    PROCNAME("pixEncodeG4Tiff");
+
+    if (!pdata)
+        return ERROR_INT("&data not defined", procName, 1);
+    *pdata = NULL;
+    if (!psize)
+        return ERROR_INT("&size not defined", procName, 1);
+    *psize = 0;
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return ERROR_INT("pixs not defined or not 1 bpp", procName, 1);
+
+    if (pixEncodeG4(&g4data, &nbytes, pixs))
+        return ERROR_INT("g4 data not made", procName, 1);
+
+        /* Header, g4 strip, directory of 12 entries on a word
+         * boundary, and the two resolution rationals */
+    diroff = 8 + nbytes + (nbytes & 1);
+    ratoff = diroff + 2 + 12 * 12 + 4;
+    size = ratoff + 16;
+    if ((data = (l_uint8 *)LEPT_CALLOC(size, sizeof(l_uint8))) == NULL) {
+        LEPT_FREE(g4data);
+        return ERROR_INT("data not made", procName, 1);
+    }
+    data[0] = data[1] = 'I';
+    data[2] = 42;
+    g4PutTiffValue(data + 4, diroff, 4);
+    memcpy(data + 8, g4data, nbytes);
+    LEPT_FREE(g4data);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixGetResolution(pixs, &xres, &yres);
+    if (xres == 0) xres = 300;
+    if (yres == 0) yres = 300;
+    p = data + diroff;
+    p[0] = 12;
+    p += 2;
+    g4PutTiffEntry(p, 256, 4, 1, w);  /* width */
+    g4PutTiffEntry(p + 12, 257, 4, 1, h);  /* height */
+    g4PutTiffEntry(p + 24, 258, 3, 1, 1);  /* bits/sample */
+    g4PutTiffEntry(p + 36, 259, 3, 1, 4);  /* compression: g4 */
+    g4PutTiffEntry(p + 48, 262, 3, 1, 0);  /* photometric: miniswhite */
+    g4PutTiffEntry(p + 60, 273, 4, 1, 8);  /* strip offset */
+    g4PutTiffEntry(p + 72, 277, 3, 1, 1);  /* samples/pixel */
+    g4PutTiffEntry(p + 84, 278, 4, 1, h);  /* rows/strip */
+    g4PutTiffEntry(p + 96, 279, 4, 1, nbytes);  /* strip byte count */
+    g4PutTiffEntry(p + 108, 282, 5, 1, ratoff);  /* x resolution */
+    g4PutTiffEntry(p + 120, 283, 5, 1, ratoff + 8);  /* y resolution */
+    g4PutTiffEntry(p + 132, 296, 3, 1, 2);  /* resolution unit: inch */
+    p = data + ratoff;  /* numerator and denominator */
+    g4PutTiffValue(p, xres, 4);
+    g4PutTiffValue(p + 4, 1, 4);
+    g4PutTiffValue(p + 8, yres, 4);
+    g4PutTiffValue(p + 12, 1, 4);
+
+    *pdata = data;
+    *psize = size;
+    return 0;
+}
+
+
+/*!
+ *  pixDecodeG4Tiff()
+ *
+ *      Input:  data (tiff data)
+ *              size (size of tiff data)
+ *      Return: pixd (1 bpp), or null on error
+ *
+ *  Notes:
+ *      (1) This reads the first image of a g4 compressed tiff in memory,
+ *          without libtiff.  Either byte order and either fill order
+ *          are allowed, and the image can be in any number of strips.
+ *      (2) The resolution is read if it is given.  The input format
+ *          of pixd is set to IFF_TIFF_G4.
+ */
+PIX *
+pixDecodeG4Tiff(const l_uint8  *data,
+                size_t          size)
+{
+const l_uint8  *p, *pstrips, *pcounts;
+l_uint8        *strip;
+l_int32         bigend, i, y, nentries, tag, resunit, photometric, nrows;
+l_uint32        w, h, j, value, diroff, offset, nbytes, nstrips;
+l_uint32        bps, spp, comp, fillorder, rowsperstrip, num, den;
+l_float32       xres, yres;
+PIX            *pixd, *pixt;
+
+    PROCNAME("pixDecodeG4Tiff");
+
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if (size < 8)
+        return (PIX *)ERROR_PTR("data too small", procName, NULL);
+
+    if (data[0] == 'I' && data[1] == 'I')
+        bigend = 0;
+    else if (data[0] == 'M' && data[1] == 'M')
+        bigend = 1;
+    else
+        return (PIX *)ERROR_PTR("not tiff data", procName, NULL);
+    diroff = g4GetTiffValue(data + 4, 4, bigend);
+    if (g4GetTiffValue(data + 2, 2, bigend) != 42 ||
+        diroff < 8 || diroff > size - 2)
+        return (PIX *)ERROR_PTR("invalid tiff header", procName, NULL);
+    nentries = g4GetTiffValue(data + diroff, 2, bigend);
+    if ((size_t)(12 * nentries) > size - diroff - 2)
+        return (PIX *)ERROR_PTR("invalid tiff directory", procName, NULL);
+
+        /* Read the tags we need, using the tiff defaults for others */
+    w = h = 0;
+    bps = spp = comp = fillorder = 1;
+    photometric = 0;
+    rowsperstrip = 0xffffffff;
+    resunit = 2;
+    xres = yres = 0.0;
+    pstrips = pcounts = NULL;
+    for (i = 0; i < nentries; i++) {
+        p = data + diroff + 2 + 12 * i;
+        tag = g4GetTiffValue(p, 2, bigend);
+        if (tag == 273) {
+            pstrips = p;
+            continue;
+        } else if (tag == 279) {
+            pcounts = p;
+            continue;
+        } else if (tag == 282 || tag == 283) {
+            value = g4GetTiffValue(p + 8, 4, bigend);
+            if (g4GetTiffValue(p + 2, 2, bigend) != 5 ||
+                value < 8 || value > size - 8)
+                continue;
+            num = g4GetTiffValue(data + value, 4, bigend);
+            den = g4GetTiffValue(data + value + 4, 4, bigend);
+            if (tag == 282 && den > 0)
+                xres = (l_float32)num / (l_float32)den;
+            else if (tag == 283 && den > 0)
+                yres = (l_float32)num / (l_float32)den;
+            continue;
+        }
+        if (g4GetTiffElement(data, size, p, 0, bigend, &value))
+            continue;
+        switch (tag)
+        {
+        case 256:
+            w = value;
+            break;
+        case 257:
+            h = value;
+            break;
+        case 258:
+            bps = value;
+            break;
+        case 259:
+            comp = value;
+            break;
+        case 262:
+            photometric = value;
+            break;
+        case 266:
+            fillorder = value;
+            break;
+        case 277:
+            spp = value;
+            break;
+        case 278:
+            rowsperstrip = value;
+            break;
+        case 296:
+            resunit = value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (comp != 4 || bps != 1 || spp != 1)
+        return (PIX *)ERROR_PTR("not g4 compressed", procName, NULL);
+    if (w == 0 || h == 0 || w > 1000000 || h > 1000000)
+        return (PIX *)ERROR_PTR("invalid w or h", procName, NULL);
+    if (!pstrips || !pcounts)
+        return (PIX *)ERROR_PTR("strips not found", procName, NULL);
+    if (rowsperstrip == 0 || rowsperstrip > h)
+        rowsperstrip = h;
+    nstrips = (h + rowsperstrip - 1) / rowsperstrip;
+    if (g4GetTiffValue(pstrips + 4, 4, bigend) < nstrips ||
+        g4GetTiffValue(pcounts + 4, 4, bigend) < nstrips)
+        return (PIX *)ERROR_PTR("too few strips", procName, NULL);
+
+        /* Each strip is coded independently */
+    pixd = NULL;
+    for (i = 0, y = 0; i < nstrips; i++, y += rowsperstrip) {
+        if (g4GetTiffElement(data, size, pstrips, i, bigend, &offset) ||
+            g4GetTiffElement(data, size, pcounts, i, bigend, &nbytes) ||
+            offset > size || nbytes > size - offset) {
+            pixDestroy(&pixd);
+            return (PIX *)ERROR_PTR("strip not in data", procName, NULL);
+        }
+        nrows = L_MIN(rowsperstrip, h - y);
+        if (fillorder == 2) {  /* reverse the bits in each byte */
+            if ((strip = (l_uint8 *)LEPT_CALLOC(nbytes + 1, 1)) == NULL) {
+                pixDestroy(&pixd);
+                return (PIX *)ERROR_PTR("strip not made", procName, NULL);
+            }
+            for (j = 0; j < nbytes; j++) {
+                value = data[offset + j];
+                value = ((value & 0x0f) << 4) | ((value & 0xf0) >> 4);
+                value = ((value & 0x33) << 2) | ((value & 0xcc) >> 2);
+                strip[j] = ((value & 0x55) << 1) | ((value & 0xaa) >> 1);
+            }
+            pixt = pixDecodeG4(strip, nbytes, w, nrows);
+            LEPT_FREE(strip);
+        } else {
+            pixt = pixDecodeG4(data + offset, nbytes, w, nrows);
+        }
+        if (!pixt) {
+            pixDestroy(&pixd);
+            return (PIX *)ERROR_PTR("strip not decoded", procName, NULL);
+        }
+        if (nstrips == 1) {
+            pixd = pixt;
+        } else {
+            if (!pixd)
+                pixd = pixCreate(w, h, 1);
+            pixRasterop(pixd, 0, y, w, nrows, PIX_SRC, pixt, 0, 0);
+            pixDestroy(&pixt);
+        }
+    }
+
+    if (photometric == 1)  /* minisblack */
+        pixInvert(pixd, pixd);
+    if (xres == 0.0) xres = yres;
+    if (yres == 0.0) yres = xres;
+    if (resunit == 3) {  /* convert from ppcm to ppi */
+        xres *= 2.54;
+        yres *= 2.54;
+    }
+    pixSetResolution(pixd, (l_int32)(xres + 0.5), (l_int32)(yres + 0.5));
+    pixSetInputFormat(pixd, IFF_TIFF_G4);
+    return pixd;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                            Static helpers                           *
+ *---------------------------------------------------------------------*/
+/*!
+ *  g4CountLeadingZeros()
+ *
+ *      Input:  word (not 0)
+ *      Return: number of 0 bits before the first 1 bit, starting
+ *              from the msb
+ */
+static l_int32
+g4CountLeadingZeros(l_uint32  word)
+{
+#if defined(__GNUC__)
+    return __builtin_clz(word);
+#else
+l_int32  n;
+
+    n = 0;
+    if ((word & 0xffff0000) == 0) {
+        n += 16;
+        word <<= 16;
+    }
+    if ((word & 0xff000000) == 0) {
+        n += 8;
+        word <<= 8;
+    }
+    if ((word & 0xf0000000) == 0) {
+        n += 4;
+        word <<= 4;
+    }
+    if ((word & 0xc0000000) == 0) {
+        n += 2;
+        word <<= 2;
+    }
+    if ((word & 0x80000000) == 0)
+        n += 1;
+    return n;
+#endif  /* __GNUC__ */
+}
+
+
+/*!
+ *  g4FindChange()
+ *
+ *      Input:  line (of 1 bpp pix data)
+ *              x (starting pixel)
+ *              w (width of line)
+ *              color (of the pixels to be skipped; 0 or 1)
+ *      Return: location of the first pixel at or after x that is not
+ *              of the given color, or w if there is none
+ *
+ *  Notes:
+ *      (1) Pixels of the given color are skipped a word at a time.
+ *          Padding bits are never examined past the word holding the
+ *          last pixel, and a result in the padding is clipped to w.
+ */
+static l_int32
+g4FindChange(const l_uint32  *line,
+             l_int32          x,
+             l_int32          w,
+             l_int32          color)
+{
+l_int32   i, nwords;
+l_uint32  flip, word;
+
+    if (x >= w)
+        return w;
+    flip = (color) ? 0xffffffff : 0;
+    nwords = (w + 31) / 32;
+    i = x / 32;
+    word = (line[i] ^ flip) & (0xffffffff >> (x & 31));
+    while (word == 0) {
+        if (++i >= nwords)
+            return w;
+        word = line[i] ^ flip;
+    }
+    x = 32 * i + g4CountLeadingZeros(word);
+    return L_MIN(x, w);
+}
+
+
+/*!
+ *  g4GetChanges()
+ *
+ *      Input:  line (of 1 bpp pix data)
+ *              w (width of line)
+ *              changes (array of size at least w + 4, for the output)
+ *      Return: number of changing elements
+ *
+ *  Notes:
+ *      (1) The changes are followed by 4 entries with the value w.
+ */
+static l_int32
+g4GetChanges(const l_uint32  *line,
+             l_int32          w,
+             l_int32         *changes)
+{
+l_int32  n, x, color;
+
+    n = 0;
+    color = 0;
+    x = g4FindChange(line, 0, w, color);
+    while (x < w) {
+        changes[n++] = x;
+        color ^= 1;
+        x = g4FindChange(line, x, w, color);
+    }
+    changes[n] = changes[n + 1] = changes[n + 2] = changes[n + 3] = w;
+    return n;
+}
+
+
+/*!
+ *  g4SetRun()
+ *
+ *      Input:  line (of 1 bpp pix data)
+ *              start, end (set pixels in [start, end) to 1)
+ */
+static void
+g4SetRun(l_uint32  *line,
+         l_int32    start,
+         l_int32    end)
+{
+l_int32   i, iend;
+l_uint32  firstmask, lastmask;
+
+    if (start >= end)
+        return;
+    i = start / 32;
+    iend = (end - 1) / 32;
+    firstmask = 0xffffffff >> (start & 31);
+    lastmask = 0xffffffff << (31 - ((end - 1) & 31));
+    if (i == iend) {
+        line[i] |= firstmask & lastmask;
+        return;
+    }
+    line[i++] |= firstmask;
+    while (i < iend)
+        line[i++] = 0xffffffff;
+    line[iend] |= lastmask;
+}
+
+
+/*!
+ *  g4PutBits()
+ *
+ *      Input:  bw (bit writer)
+ *              code (in the low-order bits)
+ *              len (number of bits in the code; <= 24)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+g4PutBits(G4_BITWRITER  *bw,
+          l_uint32       code,
+          l_int32        len)
+{
+    bw->buf = (bw->buf << len) | code;
+    bw->nbits += len;
+    while (bw->nbits >= 8) {
+        if (bw->nbytes >= bw->nalloc) {
+            if ((bw->data = (l_uint8 *)reallocNew((void **)&bw->data,
+                            bw->nalloc, 2 * bw->nalloc)) == NULL)
+                return 1;
+            bw->nalloc *= 2;
+        }
+        bw->nbits -= 8;
+        bw->data[bw->nbytes++] = (bw->buf >> bw->nbits) & 0xff;
+    }
+    return 0;
+}
+
+
+/*!
+ *  g4PutRun()
+ *
+ *      Input:  bw (bit writer)
+ *              run (length of run)
+ *              color (of run; 0 for white, 1 for black)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) Runs of 2624 or more are broken into makeup codes of 2560,
+ *          and what is left is coded with a makeup code for a multiple
+ *          of 64 if necessary, followed by a terminating code.
+ */
+static l_int32
+g4PutRun(G4_BITWRITER  *bw,
+         l_int32        run,
+         l_int32        color)
+{
+l_int32          index, ret;
+const l_uint16  (*codes)[2];
+
+    codes = (color == 0) ? WhiteCodes : BlackCodes;
+    ret = 0;
+    while (run >= 2624) {
+        ret += g4PutBits(bw, codes[103][1], codes[103][0]);
+        run -= 2560;
+    }
+    if (run >= 64) {
+        index = 63 + run / 64;
+        ret += g4PutBits(bw, codes[index][1], codes[index][0]);
+        run -= 64 * (run / 64);
+    }
+    ret += g4PutBits(bw, codes[run][1], codes[run][0]);
+    return (ret) ? 1 : 0;
+}
+
+
+/*!
+ *  g4PeekBits()
+ *
+ *      Input:  br (bit reader)
+ *              n (number of bits; <= 24)
+ *      Return: the next n bits, in the low-order bits
+ *
+ *  Notes:
+ *      (1) The bits are not consumed; to do that, decrease br->nbits.
+ *      (2) Zero bits are supplied past the end of the data; the caller
+ *          checks br->pos to find if the data was overrun.
+ */
+static l_uint32
+g4PeekBits(G4_BITREADER  *br,
+           l_int32        n)
+{
+    while (br->nbits < n) {
+        br->buf <<= 8;
+        if (br->pos < br->size)
+            br->buf |= br->data[br->pos];
+        br->pos++;
+        br->nbits += 8;
+    }
+    return (br->buf >> (br->nbits - n)) & ((1 << n) - 1);
+}
+
+
+/*!
+ *  g4ReadMode()
+ *
+ *      Input:  br (bit reader)
+ *              &delta (<return> a1 - b1, for vertical mode)
+ *      Return: mode (G4_VERTICAL, G4_PASS, G4_HORIZONTAL or G4_INVALID)
+ */
+static l_int32
+g4ReadMode(G4_BITREADER  *br,
+           l_int32       *pdelta)
+{
+l_uint32  bits;
+
+    *pdelta = 0;
+    bits = g4PeekBits(br, 7);
+    if (bits >= 0x40) {  /* 1 */
+        br->nbits -= 1;
+        return G4_VERTICAL;
+    } else if (bits >= 0x20) {  /* 011 or 010 */
+        br->nbits -= 3;
+        *pdelta = (bits >= 0x30) ? 1 : -1;
+        return G4_VERTICAL;
+    } else if (bits >= 0x10) {  /* 001 */
+        br->nbits -= 3;
+        return G4_HORIZONTAL;
+    } else if (bits >= 0x08) {  /* 0001 */
+        br->nbits -= 4;
+        return G4_PASS;
+    } else if (bits >= 0x04) {  /* 000011 or 000010 */
+        br->nbits -= 6;
+        *pdelta = (bits >= 0x06) ? 2 : -2;
+        return G4_VERTICAL;
+    } else if (bits >= 0x02) {  /* 0000011 or 0000010 */
+        br->nbits -= 7;
+        *pdelta = (bits == 0x03) ? 3 : -3;
+        return G4_VERTICAL;
+    }
+    return G4_INVALID;  /* extension, EOFB or bad data */
+}
+
+
+/*!
+ *  g4ReadRun()
+ *
+ *      Input:  br (bit reader)
+ *              table (lookup table for the color of the run)
+ *              w (width of line)
+ *      Return: length of run, or -1 on error
+ */
+static l_int32
+g4ReadRun(G4_BITREADER    *br,
+          const l_uint16  *table,
+          l_int32          w)
+{
+l_int32  run, entry, index;
+
+    run = 0;
+    while (1) {
+        entry = table[g4PeekBits(br, G4_RUN_BITS)];
+        if (entry == 0)
+            return -1;
+        br->nbits -= entry & 0xf;
+        index = entry >> 4;
+        if (index < 64)
+            return run + index;
+        run += 64 * (index - 63);
+        if (run > w)
+            return -1;
+    }
+}
+
+
+/*!
+ *  g4MakeRunTable()
+ *
+ *      Input:  codes (WhiteCodes or BlackCodes)
+ *              table (of size 2^G4_RUN_BITS, initialized to 0)
+ *
+ *  Notes:
+ *      (1) The table is indexed by the next G4_RUN_BITS bits of data.
+ *          Each entry holds (index << 4) | len for the code that
+ *          starts the data, where index is the row in @codes and
+ *          len is the length of the code.  Entries that do not start
+ *          with a valid code are 0.
+ */
+static void
+g4MakeRunTable(const l_uint16  codes[][2],
+               l_uint16       *table)
+{
+l_int32  i, j, len, first, n;
+
+    for (i = 0; i < 104; i++) {
+        len = codes[i][0];
+        first = codes[i][1] << (G4_RUN_BITS - len);
+        n = 1 << (G4_RUN_BITS - len);
+        for (j = 0; j < n; j++)
+            table[first + j] = (i << 4) | len;
+    }
+}
+
+
+/*!
+ *  g4PutTiffValue()
+ *
+ *      Input:  p (location in tiff data)
+ *              value
+ *              nbytes (2 or 4)
+ *
+ *  Notes:
+ *      (1) Writes the value in little-endian order.
+ */
+static void
+g4PutTiffValue(l_uint8  *p,
+               l_uint32  value,
+               l_int32   nbytes)
+{
+l_int32  i;
+
+    for (i = 0; i < nbytes; i++)
+        p[i] = (value >> (8 * i)) & 0xff;
+}
+
+
+/*!
+ *  g4PutTiffEntry()
+ *
+ *      Input:  p (location of directory entry in tiff data)
+ *              tag
+ *              type (3 for short, 4 for long, 5 for rational)
+ *              count (number of values)
+ *              value (for a single short or long; otherwise an offset)
+ */
+static void
+g4PutTiffEntry(l_uint8  *p,
+               l_int32   tag,
+               l_int32   type,
+               l_uint32  count,
+               l_uint32  value)
+{
+    g4PutTiffValue(p, tag, 2);
+    g4PutTiffValue(p + 2, type, 2);
+    g4PutTiffValue(p + 4, count, 4);
+    g4PutTiffValue(p + 8, value, (type == 3) ? 2 : 4);
+}
+
+
+/*!
+ *  g4GetTiffValue()
+ *
+ *      Input:  p (location in tiff data)
+ *              nbytes (2 or 4)
+ *              bigend (1 for big-endian, 0 for little-endian data)
+ *      Return: value
+ */
+static l_uint32
+g4GetTiffValue(const l_uint8  *p,
+               l_int32         nbytes,
+               l_int32         bigend)
+{
+l_int32   i;
+l_uint32  value;
+
+    value = 0;
+    for (i = 0; i < nbytes; i++) {
+        if (bigend)
+            value = (value << 8) | p[i];
+        else
+            value |= (l_uint32)p[i] << (8 * i);
+    }
+    return value;
+}
+
+
+/*!
+ *  g4GetTiffElement()
+ *
+ *      Input:  data (tiff data)
+ *              size (size of tiff data)
+ *              entry (location of directory entry in tiff data)
+ *              index (of the element in the values of the entry)
+ *              bigend (1 for big-endian, 0 for little-endian data)
+ *              &val (<return> value)
+ *      Return: 0 if OK, 1 if the element is not a short or long,
+ *              or is not in the data
+ */
+static l_int32
+g4GetTiffElement(const l_uint8  *data,
+                 size_t          size,
+                 const l_uint8  *entry,
+                 l_uint32        index,
+                 l_int32         bigend,
+                 l_uint32       *pval)
+{
+const l_uint8  *p;
+l_int32         type;
+l_uint32        count, offset, elsize;
+
+    *pval = 0;
+    type = g4GetTiffValue(entry + 2, 2, bigend);
+    count = g4GetTiffValue(entry + 4, 4, bigend);
+    if ((type != 3 && type != 4) || index >= count)
+        return 1;
+    elsize = (type == 3) ? 2 : 4;
+    if (count <= 4 / elsize) {  /* values are in the entry */
+        p = entry + 8;
+    } else {
+        offset = g4GetTiffValue(entry + 8, 4, bigend);
+        if (offset > size || count > (size - offset) / elsize)
+            return 1;
+        p = data + offset;
+    }
+    *pval = g4GetTiffValue(p + elsize * index, elsize, bigend);
+    return 0;
+}
@@ -48,6 +48,15 @@
  *            static void    dilateGrayLow()
  *            static void    erodeGrayLow()
  *
+ *      Vector kernels for the low-level operations
+ *            static l_int32 grayMorphSimdLow()
+ *            static void    grayVertColumns()
+ *            static l_int32 grayVertSse2()
+ *            static l_int32 grayVertAvx2()
+ *            static l_int32 grayVertNeon()
+ *            static l_int32 grayHorizSse2()
+ *            static void    transpose16x16Sse2()
+ *
  *
  *      Method: Algorithm by van Herk and Gil and Werman, 1992
  *
@@ -115,9 +124,22 @@
  *      pixel corresponding to the SE center.  A picture is worth
  *      at least this many words, so if this isn't clear, see the
  *      leptonica documentation on grayscale morphology.
+ *
+ *      When a vector instruction set is selected (see simd.c), the
+ *      low-level operations use vector kernels that give results
+ *      identical to the scalar code.  The vertical pass does the
+ *      same computation on 16 (SSE2, NEON) or 32 (AVX2) adjacent
+ *      columns at once, working directly on the raster lines.  For
+ *      the horizontal pass (SSE2 and AVX2), a band of 16 lines is
+ *      transposed in 16x16 blocks, so that each vector holds one
+ *      column of the band.  The vertical computation is then done
+ *      on the transposed band, which is transposed back.  With NEON,
+ *      the horizontal pass uses the scalar code.
  */
 
+#include <string.h>
 #include "allheaders.h"
+#include "simd.h"
 
     /* Special static operations for 3x1, 1x3 and 3x3 structuring elements */
 static PIX *pixErodeGray3h(PIX *pixs);
@@ -135,6 +157,38 @@ static void erodeGrayLow(l_uint32 *datad, l_int32 w, l_int32 h,
                          l_int32 size, l_int32 direction, l_uint8 *buffer,
                          l_uint8 *minarray);
 
+    /* Vector kernels for the low-level operations */
+static l_int32 grayMorphSimdLow(l_uint32 *datad, l_int32 w, l_int32 h,
+                                l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                                l_int32 size, l_int32 direction,
+                                l_int32 type);
+static void grayVertColumns(l_uint32 *datad, l_int32 h, l_int32 wpld,
+                            l_uint32 *datas, l_int32 wpls, l_int32 size,
+                            l_int32 type, l_int32 jstart, l_int32 jend);
+#if L_HAVE_SSE2
+static l_int32 grayVertSse2(l_uint32 *datad, l_int32 w, l_int32 h,
+                            l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                            l_int32 size, l_int32 type);
+static l_int32 grayHorizSse2(l_uint32 *datad, l_int32 w, l_int32 h,
+                             l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                             l_int32 size, l_int32 type);
+static void transpose16x16Sse2(const l_uint8 *src, l_int32 sstride,
+                               l_uint8 *dst, l_int32 dstride);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 grayVertAvx2(l_uint32 *datad, l_int32 w, l_int32 h,
+                            l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                            l_int32 size, l_int32 type) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 grayVertNeon(l_uint32 *datad, l_int32 w, l_int32 h,
+                            l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                            l_int32 size, l_int32 type);
+#endif  /* L_HAVE_NEON */
+
+    /* Min image width for using the vector kernels */
+static const l_int32  MinSimdWidth = 32;
+
 /*-----------------------------------------------------------------*
  *           Top-level grayscale morphological operations          *
  *-----------------------------------------------------------------*/
@@ -674,7 +728,7 @@ static PIX *
 pixErodeGray3h(PIX  *pixs)
 {
 l_uint32  *datas, *datad, *lines, *lined;
-l_int32    w, h, wpl, i, j;
+l_int32    w, h, wpls, wpld, i, j;
 l_int32    val0, val1, val2, val3, val4, val5, val6, val7, val8, val9, minval;
 PIX       *pixd;
 
@@ -690,10 +744,11 @@ PIX       *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
+    wpld = pixGetWpl(pixd);
     for (i = 0; i < h; i++) {
-        lines = datas + i * wpl;
-        lined = datad + i * wpl;
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
         for (j = 1; j < w - 8; j += 8) {
             val0 = GET_DATA_BYTE(lines, j - 1);
             val1 = GET_DATA_BYTE(lines, j);
@@ -740,7 +795,7 @@ static PIX *
 pixErodeGray3v(PIX  *pixs)
 {
 l_uint32  *datas, *datad, *linesi, *linedi;
-l_int32    w, h, wpl, i, j;
+l_int32    w, h, wpls, wpld, i, j;
 l_int32    val0, val1, val2, val3, val4, val5, val6, val7, val8, val9, minval;
 PIX       *pixd;
 
@@ -755,33 +810,34 @@ PIX       *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
+    wpld = pixGetWpl(pixd);
     for (j = 0; j < w; j++) {
         for (i = 1; i < h - 8; i += 8) {
-            linesi = datas + i * wpl;
-            linedi = datad + i * wpl;
-            val0 = GET_DATA_BYTE(linesi - wpl, j);
+            linesi = datas + i * wpls;
+            linedi = datad + i * wpld;
+            val0 = GET_DATA_BYTE(linesi - wpls, j);
             val1 = GET_DATA_BYTE(linesi, j);
-            val2 = GET_DATA_BYTE(linesi + wpl, j);
-            val3 = GET_DATA_BYTE(linesi + 2 * wpl, j);
-            val4 = GET_DATA_BYTE(linesi + 3 * wpl, j);
-            val5 = GET_DATA_BYTE(linesi + 4 * wpl, j);
-            val6 = GET_DATA_BYTE(linesi + 5 * wpl, j);
-            val7 = GET_DATA_BYTE(linesi + 6 * wpl, j);
-            val8 = GET_DATA_BYTE(linesi + 7 * wpl, j);
-            val9 = GET_DATA_BYTE(linesi + 8 * wpl, j);
+            val2 = GET_DATA_BYTE(linesi + wpls, j);
+            val3 = GET_DATA_BYTE(linesi + 2 * wpls, j);
+            val4 = GET_DATA_BYTE(linesi + 3 * wpls, j);
+            val5 = GET_DATA_BYTE(linesi + 4 * wpls, j);
+            val6 = GET_DATA_BYTE(linesi + 5 * wpls, j);
+            val7 = GET_DATA_BYTE(linesi + 6 * wpls, j);
+            val8 = GET_DATA_BYTE(linesi + 7 * wpls, j);
+            val9 = GET_DATA_BYTE(linesi + 8 * wpls, j);
             minval = L_MIN(val1, val2);
             SET_DATA_BYTE(linedi, j, L_MIN(val0, minval));
-            SET_DATA_BYTE(linedi + wpl, j, L_MIN(minval, val3));
+            SET_DATA_BYTE(linedi + wpld, j, L_MIN(minval, val3));
             minval = L_MIN(val3, val4);
-            SET_DATA_BYTE(linedi + 2 * wpl, j, L_MIN(val2, minval));
-            SET_DATA_BYTE(linedi + 3 * wpl, j, L_MIN(minval, val5));
+            SET_DATA_BYTE(linedi + 2 * wpld, j, L_MIN(val2, minval));
+            SET_DATA_BYTE(linedi + 3 * wpld, j, L_MIN(minval, val5));
             minval = L_MIN(val5, val6);
-            SET_DATA_BYTE(linedi + 4 * wpl, j, L_MIN(val4, minval));
-            SET_DATA_BYTE(linedi + 5 * wpl, j, L_MIN(minval, val7));
+            SET_DATA_BYTE(linedi + 4 * wpld, j, L_MIN(val4, minval));
+            SET_DATA_BYTE(linedi + 5 * wpld, j, L_MIN(minval, val7));
             minval = L_MIN(val7, val8);
-            SET_DATA_BYTE(linedi + 6 * wpl, j, L_MIN(val6, minval));
-            SET_DATA_BYTE(linedi + 7 * wpl, j, L_MIN(minval, val9));
+            SET_DATA_BYTE(linedi + 6 * wpld, j, L_MIN(val6, minval));
+            SET_DATA_BYTE(linedi + 7 * wpld, j, L_MIN(minval, val9));
         }
     }
     return pixd;
@@ -855,7 +911,7 @@ static PIX *
 pixDilateGray3h(PIX  *pixs)
 {
 l_uint32  *datas, *datad, *lines, *lined;
-l_int32    w, h, wpl, i, j;
+l_int32    w, h, wpls, wpld, i, j;
 l_int32    val0, val1, val2, val3, val4, val5, val6, val7, val8, val9, maxval;
 PIX       *pixd;
 
@@ -871,10 +927,11 @@ PIX       *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
+    wpld = pixGetWpl(pixd);
     for (i = 0; i < h; i++) {
-        lines = datas + i * wpl;
-        lined = datad + i * wpl;
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
         for (j = 1; j < w - 8; j += 8) {
             val0 = GET_DATA_BYTE(lines, j - 1);
             val1 = GET_DATA_BYTE(lines, j);
@@ -918,7 +975,7 @@ static PIX *
 pixDilateGray3v(PIX  *pixs)
 {
 l_uint32  *datas, *datad, *linesi, *linedi;
-l_int32    w, h, wpl, i, j;
+l_int32    w, h, wpls, wpld, i, j;
 l_int32    val0, val1, val2, val3, val4, val5, val6, val7, val8, val9, maxval;
 PIX       *pixd;
 
@@ -933,33 +990,34 @@ PIX       *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
+    wpld = pixGetWpl(pixd);
     for (j = 0; j < w; j++) {
         for (i = 1; i < h - 8; i += 8) {
-            linesi = datas + i * wpl;
-            linedi = datad + i * wpl;
-            val0 = GET_DATA_BYTE(linesi - wpl, j);
+            linesi = datas + i * wpls;
+            linedi = datad + i * wpld;
+            val0 = GET_DATA_BYTE(linesi - wpls, j);
             val1 = GET_DATA_BYTE(linesi, j);
-            val2 = GET_DATA_BYTE(linesi + wpl, j);
-            val3 = GET_DATA_BYTE(linesi + 2 * wpl, j);
-            val4 = GET_DATA_BYTE(linesi + 3 * wpl, j);
-            val5 = GET_DATA_BYTE(linesi + 4 * wpl, j);
-            val6 = GET_DATA_BYTE(linesi + 5 * wpl, j);
-            val7 = GET_DATA_BYTE(linesi + 6 * wpl, j);
-            val8 = GET_DATA_BYTE(linesi + 7 * wpl, j);
-            val9 = GET_DATA_BYTE(linesi + 8 * wpl, j);
+            val2 = GET_DATA_BYTE(linesi + wpls, j);
+            val3 = GET_DATA_BYTE(linesi + 2 * wpls, j);
+            val4 = GET_DATA_BYTE(linesi + 3 * wpls, j);
+            val5 = GET_DATA_BYTE(linesi + 4 * wpls, j);
+            val6 = GET_DATA_BYTE(linesi + 5 * wpls, j);
+            val7 = GET_DATA_BYTE(linesi + 6 * wpls, j);
+            val8 = GET_DATA_BYTE(linesi + 7 * wpls, j);
+            val9 = GET_DATA_BYTE(linesi + 8 * wpls, j);
             maxval = L_MAX(val1, val2);
             SET_DATA_BYTE(linedi, j, L_MAX(val0, maxval));
-            SET_DATA_BYTE(linedi + wpl, j, L_MAX(maxval, val3));
+            SET_DATA_BYTE(linedi + wpld, j, L_MAX(maxval, val3));
             maxval = L_MAX(val3, val4);
-            SET_DATA_BYTE(linedi + 2 * wpl, j, L_MAX(val2, maxval));
-            SET_DATA_BYTE(linedi + 3 * wpl, j, L_MAX(maxval, val5));
+            SET_DATA_BYTE(linedi + 2 * wpld, j, L_MAX(val2, maxval));
+            SET_DATA_BYTE(linedi + 3 * wpld, j, L_MAX(maxval, val5));
             maxval = L_MAX(val5, val6);
-            SET_DATA_BYTE(linedi + 4 * wpl, j, L_MAX(val4, maxval));
-            SET_DATA_BYTE(linedi + 5 * wpl, j, L_MAX(maxval, val7));
+            SET_DATA_BYTE(linedi + 4 * wpld, j, L_MAX(val4, maxval));
+            SET_DATA_BYTE(linedi + 5 * wpld, j, L_MAX(maxval, val7));
             maxval = L_MAX(val7, val8);
-            SET_DATA_BYTE(linedi + 6 * wpl, j, L_MAX(val6, maxval));
-            SET_DATA_BYTE(linedi + 7 * wpl, j, L_MAX(maxval, val9));
+            SET_DATA_BYTE(linedi + 6 * wpld, j, L_MAX(val6, maxval));
+            SET_DATA_BYTE(linedi + 7 * wpld, j, L_MAX(maxval, val9));
         }
     }
     return pixd;
@@ -1121,6 +1179,8 @@ PIX  *pixt, *pixb, *pixbd, *pixd;
  *            This allows full processing over the actual image; at
  *            the end the border is removed.
  *        (2) Uses algorithm of van Herk, Gil and Werman
+ *        (3) Uses a vector kernel if one is selected; see
+ *            grayMorphSimdLow().
  */
 static void
 dilateGrayLow(l_uint32  *datad,
@@ -1139,6 +1199,10 @@ l_int32    hsize, nsteps, startmax, startx, starty;
 l_uint8    maxval;
 l_uint32  *lines, *lined;
 
+    if (grayMorphSimdLow(datad, w, h, wpld, datas, wpls, size, direction,
+                         L_MORPH_DILATE))
+        return;
+
     if (direction == L_HORIZ) {
         hsize = size / 2;
         nsteps = (w - 2 * hsize) / size;
@@ -1241,6 +1305,10 @@ l_int32    hsize, nsteps, startmin, startx, starty;
 l_uint8    minval;
 l_uint32  *lines, *lined;
 
+    if (grayMorphSimdLow(datad, w, h, wpld, datas, wpls, size, direction,
+                         L_MORPH_ERODE))
+        return;
+
     if (direction == L_HORIZ) {
         hsize = size / 2;
         nsteps = (w - 2 * hsize) / size;
@@ -1310,3 +1378,479 @@ l_uint32  *lines, *lined;
 
     return;
 }
+
+
+/*-----------------------------------------------------------------*
+ *           Vector kernels for the low-level operations           *
+ *-----------------------------------------------------------------*/
+/*!
+ *  grayMorphSimdLow()
+ *
+ *    Input:  datad, w, h, wpld (8 bpp image)
+ *            datas, wpls  (8 bpp image, of same dimensions)
+ *            size  (full length of SEL; restricted to odd numbers)
+ *            direction  (L_HORIZ or L_VERT)
+ *            type  (L_MORPH_DILATE or L_MORPH_ERODE)
+ *    Return: 1 if the operation was done; 0 if it must be done
+ *            with the scalar code
+ *
+ *    Notes:
+ *        (1) This uses the vector kernel for the instruction set
+ *            selected by l_getSimdMode().  The dest pixels that are
+ *            written, and their values, are the same as with the
+ *            scalar code in dilateGrayLow() and erodeGrayLow().
+ */
+static l_int32
+grayMorphSimdLow(l_uint32  *datad,
+                 l_int32    w,
+                 l_int32    h,
+                 l_int32    wpld,
+                 l_uint32  *datas,
+                 l_int32    wpls,
+                 l_int32    size,
+                 l_int32    direction,
+                 l_int32    type)
+{
+l_int32  ret;
+
+    if (w < MinSimdWidth || size < 2)
+        return 0;
+
+    ret = 1;
+    switch (l_getSimdMode())
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        if (direction == L_HORIZ)
+            ret = grayHorizSse2(datad, w, h, wpld, datas, wpls, size, type);
+        else
+            ret = grayVertAvx2(datad, w, h, wpld, datas, wpls, size, type);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        if (direction == L_HORIZ)
+            ret = grayHorizSse2(datad, w, h, wpld, datas, wpls, size, type);
+        else
+            ret = grayVertSse2(datad, w, h, wpld, datas, wpls, size, type);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        if (direction == L_VERT)
+            ret = grayVertNeon(datad, w, h, wpld, datas, wpls, size, type);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+    return (ret == 0) ? 1 : 0;
+}
+
+
+/*!
+ *  grayVertColumns()
+ *
+ *    Input:  datad, h, wpld (8 bpp image)
+ *            datas, wpls  (8 bpp image, of same dimensions)
+ *            size  (full length of SEL; restricted to odd numbers)
+ *            type  (L_MORPH_DILATE or L_MORPH_ERODE)
+ *            jstart, jend  (range of columns [jstart ... jend - 1])
+ *    Return: void
+ *
+ *    Notes:
+ *        (1) This is the scalar vertical operation on a range of columns.
+ *            It is used by the vector kernels for the last few columns,
+ *            which do not fill a 32-bit word.
+ */
+static void
+grayVertColumns(l_uint32  *datad,
+                l_int32    h,
+                l_int32    wpld,
+                l_uint32  *datas,
+                l_int32    wpls,
+                l_int32    size,
+                l_int32    type,
+                l_int32    jstart,
+                l_int32    jend)
+{
+l_int32    i, j, k, hsize, nsteps, center, val, bval, fval;
+l_uint8   *barray;
+l_uint32  *lines, *lined;
+
+    hsize = size / 2;
+    nsteps = (h - 2 * hsize) / size;
+    if ((barray = (l_uint8 *)LEPT_CALLOC(size, sizeof(l_uint8))) == NULL)
+        return;
+    for (j = jstart; j < jend; j++) {
+        for (i = 0; i < nsteps; i++) {
+            center = (i + 1) * size - 1;
+            lines = datas + center * wpls;
+            bval = GET_DATA_BYTE(lines, j);
+            barray[0] = bval;
+            for (k = 1; k < size; k++) {
+                val = GET_DATA_BYTE(lines - k * wpls, j);
+                bval = (type == L_MORPH_DILATE) ? L_MAX(bval, val)
+                                                : L_MIN(bval, val);
+                barray[k] = bval;
+            }
+            lined = datad + (hsize + i * size) * wpld;
+            SET_DATA_BYTE(lined, j, bval);
+            fval = GET_DATA_BYTE(lines, j);
+            for (k = 1; k < size; k++) {
+                val = GET_DATA_BYTE(lines + k * wpls, j);
+                bval = barray[size - 1 - k];
+                if (type == L_MORPH_DILATE) {
+                    fval = L_MAX(fval, val);
+                    SET_DATA_BYTE(lined + k * wpld, j, L_MAX(bval, fval));
+                } else {
+                    fval = L_MIN(fval, val);
+                    SET_DATA_BYTE(lined + k * wpld, j, L_MIN(bval, fval));
+                }
+            }
+        }
+    }
+    LEPT_FREE(barray);
+    return;
+}
+
+
+    /* The vertical operation on the raster lines, done on VBYTES
+     * adjacent bytes at a time.  For the group of @size dest lines
+     * centered on src line c = (i + 1) * size - 1, the backward
+     * extrema over lines (c - k ... c) are stored in barray, and the
+     * forward extrema over lines (c ... c + k) are accumulated in v.
+     * The bytes are done in the order they are stored, because every
+     * column is independent.  The last group of VBYTES overlaps the
+     * previous one, to end at the last full word. */
+#define GRAY_VERT_LOOP(VOP)                                              \
+    for (i = 0; i < nsteps; i++) {                                       \
+        lines = (l_uint8 *)(datas + ((i + 1) * size - 1) * wpls);        \
+        lined = (l_uint8 *)(datad + (hsize + i * size) * wpld);          \
+        for (x = 0; x < nbytes; x += VBYTES) {                           \
+            if (x > nbytes - VBYTES)                                     \
+                x = nbytes - VBYTES;                                     \
+            ps = lines + x;                                              \
+            pd = lined + x;                                              \
+            v = VLOAD(ps);                                               \
+            VSTORE(barray, v);                                           \
+            for (k = 1; k < size; k++) {                                 \
+                v = VOP(v, VLOAD(ps - k * bpls));                        \
+                VSTORE(barray + k * VBYTES, v);                          \
+            }                                                            \
+            VSTORE(pd, v);                                               \
+            v = VLOAD(ps);                                               \
+            for (k = 1; k < size; k++) {                                 \
+                v = VOP(v, VLOAD(ps + k * bpls));                        \
+                VSTORE(pd + k * bpld,                                    \
+                       VOP(VLOAD(barray + (size - 1 - k) * VBYTES), v)); \
+            }                                                            \
+        }                                                                \
+    }
+
+    /* Declarations and setup shared by the vertical kernels */
+#define GRAY_VERT_SETUP                                                  \
+    hsize = size / 2;                                                    \
+    nsteps = (h - 2 * hsize) / size;                                     \
+    nbytes = 4 * (w / 4);  /* bytes in full words */                     \
+    bpls = 4 * wpls;                                                     \
+    bpld = 4 * wpld;                                                     \
+    if (nsteps <= 0)                                                     \
+        return 0;                                                        \
+    if ((barray = (l_uint8 *)LEPT_CALLOC(size, VBYTES)) == NULL)         \
+        return 1;
+
+#define GRAY_VERT_FINISH                                                 \
+    LEPT_FREE(barray);                                                   \
+    if (nbytes < w)                                                      \
+        grayVertColumns(datad, h, wpld, datas, wpls, size, type,         \
+                        nbytes, w);                                      \
+    return 0;
+
+
+#if L_HAVE_SSE2
+/*!
+ *  grayVertSse2()
+ *
+ *    Input:  see grayMorphSimdLow()
+ *    Return: 0 if OK; 1 on error
+ */
+static l_int32
+grayVertSse2(l_uint32  *datad,
+             l_int32    w,
+             l_int32    h,
+             l_int32    wpld,
+             l_uint32  *datas,
+             l_int32    wpls,
+             l_int32    size,
+             l_int32    type)
+{
+l_int32   i, k, x, hsize, nsteps, nbytes, bpls, bpld;
+l_uint8  *barray, *lines, *lined, *ps, *pd;
+__m128i   v;
+
+#define VBYTES         16
+#define VLOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define VSTORE(p, v)   _mm_storeu_si128((__m128i *)(p), (v))
+    GRAY_VERT_SETUP
+    if (type == L_MORPH_DILATE) {
+        GRAY_VERT_LOOP(_mm_max_epu8)
+    } else {
+        GRAY_VERT_LOOP(_mm_min_epu8)
+    }
+    GRAY_VERT_FINISH
+#undef VBYTES
+#undef VLOAD
+#undef VSTORE
+}
+
+
+/*!
+ *  grayHorizSse2()
+ *
+ *    Input:  see grayMorphSimdLow()
+ *    Return: 0 if OK; 1 on error
+ *
+ *    Notes:
+ *        (1) The image is processed in bands of 16 lines.  Each band is
+ *            copied to sbuf, with a line stride that is a multiple of 16,
+ *            and transposed into tbuf, where the 16 bytes at 16 * x are
+ *            the 16 lines of column x.  The vertical operation is done
+ *            from tbuf into obuf, which is transposed back into sbuf.
+ *        (2) The bytes are stored in each 32-bit word in big-endian
+ *            order, so pixel x of a line is in byte (x ^ 3).
+ *        (3) Only the dest pixels that the scalar code computes,
+ *            (hsize ... hsize + nsteps * size - 1) in each line, are
+ *            copied from sbuf to the dest.
+ */
+static l_int32
+grayHorizSse2(l_uint32  *datad,
+              l_int32    w,
+              l_int32    h,
+              l_int32    wpld,
+              l_uint32  *datas,
+              l_int32    wpls,
+              l_int32    size,
+              l_int32    type)
+{
+l_int32    i, j, k, r, y, nr, x, hsize, nsteps, nbytes, stride;
+l_int32    xstart, xend, wstart, wend;
+l_uint8   *sbuf, *tbuf, *obuf, *barray;
+l_uint32  *lined, *lineb;
+__m128i    v;
+
+    hsize = size / 2;
+    nsteps = (w - 2 * hsize) / size;
+    if (nsteps <= 0)
+        return 0;
+    nbytes = 4 * ((w + 3) / 4);
+    stride = 16 * ((nbytes + 15) / 16);
+    sbuf = (l_uint8 *)LEPT_CALLOC(16 * stride, 1);
+    tbuf = (l_uint8 *)LEPT_CALLOC(16 * stride, 1);
+    obuf = (l_uint8 *)LEPT_CALLOC(16 * stride, 1);
+    barray = (l_uint8 *)LEPT_CALLOC(size, 16);
+    if (!sbuf || !tbuf || !obuf || !barray) {
+        LEPT_FREE(sbuf);
+        LEPT_FREE(tbuf);
+        LEPT_FREE(obuf);
+        LEPT_FREE(barray);
+        return 1;
+    }
+
+        /* Range of dest pixels, and of full words, that are written */
+    xstart = hsize;
+    xend = hsize + nsteps * size;
+    wstart = (xstart + 3) / 4;
+    wend = xend / 4;
+
+#define VLOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define VSTORE(p, v)   _mm_storeu_si128((__m128i *)(p), (v))
+#define COL(buf, x)    ((buf) + 16 * ((x) ^ 3))
+#define GRAY_HORIZ_LOOP(VOP)                                             \
+    for (i = 0; i < nsteps; i++) {                                       \
+        x = (i + 1) * size - 1;                                          \
+        v = VLOAD(COL(tbuf, x));                                         \
+        VSTORE(barray, v);                                               \
+        for (k = 1; k < size; k++) {                                     \
+            v = VOP(v, VLOAD(COL(tbuf, x - k)));                         \
+            VSTORE(barray + 16 * k, v);                                  \
+        }                                                                \
+        VSTORE(COL(obuf, x - hsize), v);                                 \
+        v = VLOAD(COL(tbuf, x));                                         \
+        for (k = 1; k < size; k++) {                                     \
+            v = VOP(v, VLOAD(COL(tbuf, x + k)));                         \
+            VSTORE(COL(obuf, x - hsize + k),                             \
+                   VOP(VLOAD(barray + 16 * (size - 1 - k)), v));         \
+        }                                                                \
+    }
+
+    for (y = 0; y < h; y += 16) {
+        nr = L_MIN(16, h - y);
+        for (r = 0; r < nr; r++)
+            memcpy(sbuf + r * stride, datas + (y + r) * wpls, nbytes);
+        for (j = 0; j < stride; j += 16)
+            transpose16x16Sse2(sbuf + j, stride, tbuf + 16 * j, 16);
+        if (type == L_MORPH_DILATE) {
+            GRAY_HORIZ_LOOP(_mm_max_epu8)
+        } else {
+            GRAY_HORIZ_LOOP(_mm_min_epu8)
+        }
+        for (j = 0; j < stride; j += 16)
+            transpose16x16Sse2(obuf + 16 * j, 16, sbuf + j, stride);
+
+        for (r = 0; r < nr; r++) {
+            lined = datad + (y + r) * wpld;
+            lineb = (l_uint32 *)(sbuf + r * stride);
+            if (wend > wstart) {
+                memcpy(lined + wstart, lineb + wstart, 4 * (wend - wstart));
+                for (x = xstart; x < 4 * wstart; x++)
+                    SET_DATA_BYTE(lined, x, GET_DATA_BYTE(lineb, x));
+                for (x = 4 * wend; x < xend; x++)
+                    SET_DATA_BYTE(lined, x, GET_DATA_BYTE(lineb, x));
+            } else {
+                for (x = xstart; x < xend; x++)
+                    SET_DATA_BYTE(lined, x, GET_DATA_BYTE(lineb, x));
+            }
+        }
+    }
+#undef VLOAD
+#undef VSTORE
+#undef COL
+#undef GRAY_HORIZ_LOOP
+
+    LEPT_FREE(sbuf);
+    LEPT_FREE(tbuf);
+    LEPT_FREE(obuf);
+    LEPT_FREE(barray);
+    return 0;
+}
+
+
+/*!
+ *  transpose16x16Sse2()
+ *
+ *    Input:  src (first byte of the 16x16 block)
+ *            sstride (bytes between src lines)
+ *            dst (first byte of the transposed block)
+ *            dstride (bytes between dst lines)
+ *    Return: void
+ *
+ *    Notes:
+ *        (1) Byte j of src line i goes to byte i of dst line j.
+ *            This interleaves bytes, 16-bit, 32-bit and 64-bit units
+ *            of pairs of lines in four stages.
+ */
+static void
+transpose16x16Sse2(const l_uint8  *src,
+                   l_int32         sstride,
+                   l_uint8        *dst,
+                   l_int32         dstride)
+{
+l_int32  i;
+__m128i  a[16], b[16];
+
+    for (i = 0; i < 16; i++)
+        a[i] = _mm_loadu_si128((const __m128i *)(src + i * sstride));
+    for (i = 0; i < 16; i += 2) {
+        b[i] = _mm_unpacklo_epi8(a[i], a[i + 1]);
+        b[i + 1] = _mm_unpackhi_epi8(a[i], a[i + 1]);
+    }
+    for (i = 0; i < 16; i += 4) {
+        a[i] = _mm_unpacklo_epi16(b[i], b[i + 2]);
+        a[i + 1] = _mm_unpackhi_epi16(b[i], b[i + 2]);
+        a[i + 2] = _mm_unpacklo_epi16(b[i + 1], b[i + 3]);
+        a[i + 3] = _mm_unpackhi_epi16(b[i + 1], b[i + 3]);
+    }
+        /* a[4 * m + q] holds columns (4q ... 4q + 3), lines (4m ... 4m + 3) */
+    for (i = 0; i < 4; i++) {
+        b[2 * i] = _mm_unpacklo_epi32(a[i], a[i + 4]);
+        b[2 * i + 1] = _mm_unpackhi_epi32(a[i], a[i + 4]);
+        b[2 * i + 8] = _mm_unpacklo_epi32(a[i + 8], a[i + 12]);
+        b[2 * i + 9] = _mm_unpackhi_epi32(a[i + 8], a[i + 12]);
+    }
+        /* b[k] and b[k + 8] hold columns (2k, 2k + 1), lines (0 ... 7)
+         * and (8 ... 15), respectively */
+    for (i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i *)(dst + 2 * i * dstride),
+                         _mm_unpacklo_epi64(b[i], b[i + 8]));
+        _mm_storeu_si128((__m128i *)(dst + (2 * i + 1) * dstride),
+                         _mm_unpackhi_epi64(b[i], b[i + 8]));
+    }
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+/*!
+ *  grayVertAvx2()
+ *
+ *    Input:  see grayMorphSimdLow()
+ *    Return: 0 if OK; 1 on error
+ */
+static l_int32
+grayVertAvx2(l_uint32  *datad,
+             l_int32    w,
+             l_int32    h,
+             l_int32    wpld,
+             l_uint32  *datas,
+             l_int32    wpls,
+             l_int32    size,
+             l_int32    type)
+{
+l_int32   i, k, x, hsize, nsteps, nbytes, bpls, bpld;
+l_uint8  *barray, *lines, *lined, *ps, *pd;
+__m256i   v;
+
+#define VBYTES         32
+#define VLOAD(p)       _mm256_loadu_si256((const __m256i *)(p))
+#define VSTORE(p, v)   _mm256_storeu_si256((__m256i *)(p), (v))
+    GRAY_VERT_SETUP
+    if (type == L_MORPH_DILATE) {
+        GRAY_VERT_LOOP(_mm256_max_epu8)
+    } else {
+        GRAY_VERT_LOOP(_mm256_min_epu8)
+    }
+    GRAY_VERT_FINISH
+#undef VBYTES
+#undef VLOAD
+#undef VSTORE
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+/*!
+ *  grayVertNeon()
+ *
+ *    Input:  see grayMorphSimdLow()
+ *    Return: 0 if OK; 1 on error
+ */
+static l_int32
+grayVertNeon(l_uint32  *datad,
+             l_int32    w,
+             l_int32    h,
+             l_int32    wpld,
+             l_uint32  *datas,
+             l_int32    wpls,
+             l_int32    size,
+             l_int32    type)
+{
+l_int32     i, k, x, hsize, nsteps, nbytes, bpls, bpld;
+l_uint8    *barray, *lines, *lined, *ps, *pd;
+uint8x16_t  v;
+
+#define VBYTES         16
+#define VLOAD(p)       vld1q_u8((const uint8_t *)(p))
+#define VSTORE(p, v)   vst1q_u8((uint8_t *)(p), (v))
+    GRAY_VERT_SETUP
+    if (type == L_MORPH_DILATE) {
+        GRAY_VERT_LOOP(vmaxq_u8)
+    } else {
+        GRAY_VERT_LOOP(vminq_u8)
+    }
+    GRAY_VERT_FINISH
+#undef VBYTES
+#undef VLOAD
+#undef VSTORE
+}
+#endif  /* L_HAVE_NEON */
@@ -203,4 +203,72 @@ struct L_Pdf_Data
 typedef struct L_Pdf_Data  L_PDF_DATA;
 
 
+/* ------------------- Streaming multipage pdf output --------------------- */
+/*
+ *  A pdf writer writes the objects of each page to the output file
+ *  as soon as the page is added, and keeps only the locations of the
+ *  objects.  The Pages object and the xref table are written when the
+ *  writer is closed.  See pdfWriterOpen() in pdfio2.c.
+ */
+struct L_Pdf_Writer
+{
+    FILE              *fp;           /* output stream; opened on first page */
+    char              *fileout;      /* name of the output file             */
+    char              *title;        /* optional title for pdf              */
+    l_int32            npages;       /* number of pages written             */
+    l_int32            nobj;         /* number of the next pdf object       */
+    size_t             nbytes;       /* number of bytes written             */
+    struct L_Dna      *objloc;       /* location of each pdf object         */
+    struct Numa       *napage;       /* object number of each page          */
+};
+typedef struct L_Pdf_Writer  L_PDFWRITER;
+
+
+/* ------------------- Band (strip) streaming i/o ------------------- */
+/*
+ *  A band reader decodes a png, jpeg or tiff file a few rows at a
+ *  time, and hands back successive horizontal bands of the image.
+ *  Each band can include @overlap rows above and below it, so that
+ *  filters with vertical support can be applied band by band.
+ *  A band writer accepts successive bands and encodes them
+ *  incrementally, so that the full image is never held in memory.
+ *
+ *  The codec state is opaque here; it is owned by the format-specific
+ *  functions in pngio.c, jpegio.c and tiffio.c.
+ */
+struct L_Band_Reader
+{
+    l_int32            format;       /* IFF_PNG, IFF_JFIF_JPEG or IFF_TIFF  */
+    l_int32            w;            /* image width                         */
+    l_int32            h;            /* image height                        */
+    l_int32            d;            /* depth of the decoded rows           */
+    l_int32            spp;          /* samples/pixel of the decoded rows   */
+    l_int32            xres;         /* x resolution (ppi); 0 if unknown    */
+    l_int32            yres;         /* y resolution (ppi); 0 if unknown    */
+    struct PixColormap *cmap;        /* colormap of the decoded rows        */
+    l_int32            removecmap;   /* remove cmap from each band (png)    */
+    l_int32            bandh;        /* rows in each band, without overlap  */
+    l_int32            overlap;      /* extra rows above and below a band   */
+    l_int32            ynext;        /* first row of the next band          */
+    l_int32            nread;        /* number of rows decoded so far       */
+    struct Pix        *pixo;         /* decoded rows retained for overlap   */
+    FILE              *fp;           /* input stream                        */
+    void              *codec;        /* format-specific decoder state       */
+};
+typedef struct L_Band_Reader  L_BANDREADER;
+
+struct L_Band_Writer
+{
+    l_int32            format;       /* IFF_PNG, IFF_JFIF_JPEG or IFF_TIFF* */
+    l_int32            w;            /* image width; set by the first band  */
+    l_int32            h;            /* image height                        */
+    l_int32            d;            /* depth; set by the first band        */
+    l_int32            quality;      /* jpeg quality                        */
+    l_int32            nwritten;     /* number of rows encoded so far       */
+    FILE              *fp;           /* output stream                       */
+    void              *codec;        /* format-specific encoder state       */
+};
+typedef struct L_Band_Writer  L_BANDWRITER;
+
+
 #endif  /* LEPTONICA_IMAGEIO_H */
@@ -83,6 +83,9 @@
  *
  *     Static helpers
  *
+ *         static l_int32    jbGetPageComponents()
+ *         static l_int32    jbMatchComponent()
+ *         static l_int32    jbMatchTemplate()
  *         static JBFINDCTX *findSimilarSizedTemplatesInit()
  *         static l_int32    findSimilarSizedTemplatesNext()
  *         static void       findSimilarSizedTemplatesDestroy()
@@ -168,6 +171,19 @@
  *     As mentioned above, if visual substitution errors must be
  *     avoided, you should use the correlation method.
  *
+ *     The work can be spread over several threads (see parallel.c).
+ *     jbAddPages() reads the page images and extracts their components
+ *     in parallel, a few pages for each thread at a time, and then adds
+ *     the pages to the classer in order.  Within each page, the
+ *     components are first compared in parallel with the templates
+ *     that existed before the page was started, which are not changed
+ *     during this step (with one thread, this step is skipped).
+ *     Then the components are assigned to classes in order, and only
+ *     the templates made from earlier components on the same page
+ *     still need to be tested.  Each component goes to the first
+ *     matching template in the same order as in a serial run, so the
+ *     classes do not depend on the number of threads.
+ *
  *     We provide executables that show how to do the encoding:
  *         prog/jbrankhaus.c
  *         prog/jbcorrelation.c
@@ -242,17 +258,57 @@ struct JbFindTemplatesState
     l_int32          w;          /* desired width                         */
     l_int32          h;          /* desired height                        */
     l_int32          i;          /* index into two_by_two step array      */
-    L_DNA           *dna;        /* current number array                  */
+    L_DNA           *dna;        /* current number array; not owned       */
     l_int32          n;          /* current element of dna                */
 };
 typedef struct JbFindTemplatesState JBFINDCTX;
 
+    /* Input to jbGetPageComponents(), which reads one page image and
+     * extracts its components.  The pages are handled in batches,
+     * starting with the image file @first, and the results are stored
+     * by index in the batch. */
+struct JbPageParams
+{
+    SARRAY       *safiles;     /* page image file names                  */
+    l_int32       components;  /* JB_CONN_COMPS, JB_CHARACTERS, JB_WORDS */
+    l_int32       maxwidth;    /* max component width allowed            */
+    l_int32       maxheight;   /* max component height allowed           */
+    l_int32       first;       /* index of the image file for pix[0]     */
+    PIX         **pix;         /* page images; null if not used          */
+    BOXA        **boxa;        /* b.b. of the components on each page    */
+    PIXA        **pixa;        /* components on each page                */
+};
+typedef struct JbPageParams  JB_PAGE_PARAMS;
+
+    /* Input to jbMatchComponent() and jbMatchTemplate(), which compare
+     * the components on one page with the templates.  The components
+     * are bordered, as the templates are. */
+struct JbMatchParams
+{
+    JBCLASSER    *classer;     /* holds the templates                    */
+    PIX         **pixi;        /* components on the page                 */
+    PIX         **pixid;       /* dilated components; rank hausdorff     */
+    PTA          *pta;         /* centroids of the components            */
+    l_int32      *pixcts;      /* fg pixels in each component            */
+    l_int32     **pixrowcts;   /* fg pixels below each row; correlation  */
+    l_int32      *sumtab;      /* table of pixel sums for byte           */
+    l_int32      *match;       /* first matching template, or -1         */
+};
+typedef struct JbMatchParams  JB_MATCH_PARAMS;
+
+    /* Page images read for each thread before the pages are classified */
+static const l_int32  JbPagesPerThread = 4;
+
     /* Static initialization function */
 static JBCLASSER * jbCorrelationInitInternal(l_int32 components,
                        l_int32 maxwidth, l_int32 maxheight, l_float32 thresh,
                        l_float32 weightfactor, l_int32 keep_components);
 
     /* Static helper functions */
+static l_int32 jbGetPageComponents(void *data, l_int32 i);
+static l_int32 jbMatchComponent(void *data, l_int32 i);
+static l_int32 jbMatchTemplate(JB_MATCH_PARAMS *params, l_int32 i,
+                               l_int32 iclass);
 static JBFINDCTX * findSimilarSizedTemplatesInit(JBCLASSER *classer, PIX *pixs);
 static l_int32 findSimilarSizedTemplatesNext(JBFINDCTX *context);
 static void findSimilarSizedTemplatesDestroy(JBFINDCTX **pcontext);
@@ -431,14 +487,18 @@ JBCLASSER  *classer;
  *  Note:
  *      (1) jbclasser makes a copy of the array of file names.
  *      (2) The caller is still responsible for destroying the input array.
+ *      (3) The page images are read and their components are extracted
+ *          in parallel, in batches of a few pages for each thread
+ *          (see l_setParallelThreads()).  The pages of each batch are
+ *          then classified in order, so the result is the same as
+ *          calling jbAddPage() on each page.
  */
 l_int32
 jbAddPages(JBCLASSER  *classer,
            SARRAY     *safiles)
 {
-l_int32  i, nfiles;
-char    *fname;
-PIX     *pix;
+l_int32         i, first, nfiles, nbatch, nb;
+JB_PAGE_PARAMS  params;
 
     PROCNAME("jbAddPages");
 
@@ -449,20 +509,87 @@ PIX     *pix;
 
     classer->safiles = sarrayCopy(safiles);
     nfiles = sarrayGetCount(safiles);
-    for (i = 0; i < nfiles; i++) {
-        fname = sarrayGetString(safiles, i, L_NOCOPY);
-        if ((pix = pixRead(fname)) == NULL) {
-            L_WARNING("image file %d not read\n", procName, i);
-            continue;
-        }
-        if (pixGetDepth(pix) != 1) {
-            L_WARNING("image file %d not 1 bpp\n", procName, i);
-            continue;
+    nbatch = JbPagesPerThread * l_getParallelThreads();
+    memset(&params, 0, sizeof(JB_PAGE_PARAMS));
+    params.safiles = safiles;
+    params.components = classer->components;
+    params.maxwidth = classer->maxwidth;
+    params.maxheight = classer->maxheight;
+    params.pix = (PIX **)LEPT_CALLOC(nbatch, sizeof(PIX *));
+    params.boxa = (BOXA **)LEPT_CALLOC(nbatch, sizeof(BOXA *));
+    params.pixa = (PIXA **)LEPT_CALLOC(nbatch, sizeof(PIXA *));
+    if (!params.pix || !params.boxa || !params.pixa) {
+        LEPT_FREE(params.pix);
+        LEPT_FREE(params.boxa);
+        LEPT_FREE(params.pixa);
+        return ERROR_INT("page arrays not made", procName, 1);
+    }
+
+    for (first = 0; first < nfiles; first += nbatch) {
+        nb = L_MIN(nbatch, nfiles - first);
+        params.first = first;
+        l_parallelRun(nb, 0, jbGetPageComponents, &params);
+        for (i = 0; i < nb; i++) {
+            if (!params.pix[i]) continue;
+            classer->w = pixGetWidth(params.pix[i]);
+            classer->h = pixGetHeight(params.pix[i]);
+            jbAddPageComponents(classer, params.pix[i], params.boxa[i],
+                                params.pixa[i]);
+            pixDestroy(&params.pix[i]);
+            boxaDestroy(&params.boxa[i]);
+            pixaDestroy(&params.pixa[i]);
         }
-        jbAddPage(classer, pix);
-        pixDestroy(&pix);
     }
 
+    LEPT_FREE(params.pix);
+    LEPT_FREE(params.boxa);
+    LEPT_FREE(params.pixa);
+    return 0;
+}
+
+
+/*!
+ *  jbGetPageComponents()
+ *
+ *      Input:  data (JB_PAGE_PARAMS)
+ *              i (index in the batch; the image file is first + i)
+ *      Return: 0 always; a page that can't be used is left null
+ *
+ *  Notes:
+ *      (1) This reads the page image and saves it in params->pix[i],
+ *          along with its components and their bounding boxes.
+ */
+static l_int32
+jbGetPageComponents(void    *data,
+                    l_int32  i)
+{
+char            *fname;
+l_int32          index;
+PIX             *pix;
+JB_PAGE_PARAMS  *params;
+
+    PROCNAME("jbGetPageComponents");
+
+    params = (JB_PAGE_PARAMS *)data;
+    index = params->first + i;
+    fname = sarrayGetString(params->safiles, index, L_NOCOPY);
+    if ((pix = pixRead(fname)) == NULL) {
+        L_WARNING("image file %d not read\n", procName, index);
+        return 0;
+    }
+    if (pixGetDepth(pix) != 1) {
+        L_WARNING("image file %d not 1 bpp\n", procName, index);
+        pixDestroy(&pix);
+        return 0;
+    }
+    if (jbGetComponents(pix, params->components, params->maxwidth,
+                        params->maxheight, &params->boxa[i],
+                        &params->pixa[i])) {
+        L_ERROR("components not made for image file %d\n", procName, index);
+        pixDestroy(&pix);
+        return 0;
+    }
+    params->pix[i] = pix;
     return 0;
 }
 
@@ -577,28 +704,34 @@ l_int32  n;
  *              boxa (of new components for classification)
  *              pixas (of new components for classification)
  *      Return: 0 if OK; 1 on error
+ *
+ *  Notes:
+ *      (1) With more than one thread, the components are compared in
+ *          parallel with the templates made on earlier pages; see
+ *          jbMatchComponent().  The result is the same for any number
+ *          of threads.
  */
 l_int32
 jbClassifyRankHaus(JBCLASSER  *classer,
                    BOXA       *boxa,
                    PIXA       *pixas)
 {
-l_int32     n, nt, i, wt, ht, iclass, size, found, testval;
-l_int32    *sumtab;
-l_int32     npages, area1, area3;
-l_int32    *tab8;
-l_float32   rank, x1, y1, x2, y2;
-BOX        *box;
-NUMA       *naclass, *napage;
-NUMA       *nafg;   /* fg area of all instances */
-NUMA       *nafgt;  /* fg area of all templates */
-JBFINDCTX  *findcontext;
-L_DNAHASH  *dahash;
-PIX        *pix, *pix1, *pix2, *pix3, *pix4;
-PIXA       *pixa, *pixa1, *pixa2, *pixat, *pixatd;
-PIXAA      *pixaa;
-PTA        *pta, *ptac, *ptact;
-SEL        *sel;
+l_int32          n, nt, nt0, i, wt, ht, iclass, size, found;
+l_int32          npages;
+l_int32         *sumtab, *areas;
+l_float32        rank, x1, y1;
+BOX             *box;
+NUMA            *naclass, *napage;
+NUMA            *nafg;   /* fg area of all instances */
+NUMA            *nafgt;  /* fg area of all templates */
+JBFINDCTX       *findcontext;
+JB_MATCH_PARAMS  params;
+L_DNAHASH       *dahash;
+PIX             *pix, *pix1, *pix2;
+PIXA            *pixa, *pixa1, *pixa2, *pixat, *pixatd;
+PIXAA           *pixaa;
+PTA             *pta, *ptac, *ptact;
+SEL             *sel;
 
     PROCNAME("jbClassifyRankHaus");
 
@@ -640,6 +773,17 @@ SEL        *sel;
     napage = classer->napage;
     sumtab = makePixelSumTab8();
 
+        /* The fg areas are only needed for the rank test */
+    rank = classer->rankhaus;
+    nafg = NULL;
+    areas = NULL;
+    if (rank < 1.0) {
+        if ((nafg = pixaCountPixels(pixas)) == NULL)  /* areas, this page */
+            return ERROR_INT("nafg not made", procName, 1);
+        areas = numaGetIArray(nafg);
+    }
+    nafgt = classer->nafgt;
+
         /* Store the unbordered pix in a pixaa, in a hierarchical
          * set of arrays.  There is one pixa for each class,
          * and the pix in each pixa are all the instances found
@@ -657,6 +801,23 @@ SEL        *sel;
     pixat = classer->pixat;   /* un-dilated */
     pixatd = classer->pixatd;   /* dilated */
 
+        /* With more than one thread, first compare every component
+         * with the templates from the earlier pages.  These are not
+         * changed until all the components have been tested, so this
+         * is done in parallel.  With one thread, nt0 = 0 and all
+         * templates are tested in the loop below. */
+    memset(&params, 0, sizeof(JB_MATCH_PARAMS));
+    params.classer = classer;
+    params.pixi = pixaGetPixArray(pixa1);
+    params.pixid = pixaGetPixArray(pixa2);
+    params.pta = pta;
+    params.pixcts = areas;
+    params.sumtab = sumtab;
+    params.match = (l_int32 *)LEPT_CALLOC(L_MAX(n, 1), sizeof(l_int32));
+    nt0 = (l_getParallelThreads() > 1) ? pixaGetCount(pixat) : 0;
+    if (nt0 > 0)
+        l_parallelRun(n, 0, jbMatchComponent, &params);
+
         /* Fill up the pixaa tree with the template exemplars as
          * the first pix in each pixa.  As we add each pix,
          * we also add the associated box to the pixa.
@@ -674,132 +835,66 @@ SEL        *sel;
          * from which components can be chosen.
          * The larger the Sel you use, the fewer the number of classes,
          * and the greater the likelihood of putting semantically
-         * different objects in the same class.  For simplicity,
-         * we do this separately for the case of rank == 1.0 (exact
-         * match within the Hausdorff distance) and rank < 1.0.  */
-    rank = classer->rankhaus;
+         * different objects in the same class.  The test is an exact
+         * match within the Hausdorff distance for rank == 1.0,
+         * and a rank test for rank < 1.0.  */
     dahash = classer->dahash;
-    if (rank == 1.0) {
-        for (i = 0; i < n; i++) {
-            pix1 = pixaGetPix(pixa1, i, L_CLONE);
-            pix2 = pixaGetPix(pixa2, i, L_CLONE);
-            ptaGetPt(pta, i, &x1, &y1);
-            nt = pixaGetCount(pixat);  /* number of templates */
-            found = FALSE;
-            findcontext = findSimilarSizedTemplatesInit(classer, pix1);
-            while ((iclass = findSimilarSizedTemplatesNext(findcontext)) > -1) {
-                    /* Find score for this template */
-                pix3 = pixaGetPix(pixat, iclass, L_CLONE);
-                pix4 = pixaGetPix(pixatd, iclass, L_CLONE);
-                ptaGetPt(ptact, iclass, &x2, &y2);
-                testval = pixHaustest(pix1, pix2, pix3, pix4, x1 - x2, y1 - y2,
-                                      MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT);
-                pixDestroy(&pix3);
-                pixDestroy(&pix4);
-                if (testval == 1) {
-                    found = TRUE;
-                    numaAddNumber(naclass, iclass);
-                    numaAddNumber(napage, npages);
-                    if (classer->keep_pixaa) {
-                        pixa = pixaaGetPixa(pixaa, iclass, L_CLONE);
-                        pix = pixaGetPix(pixas, i, L_CLONE);
-                        pixaAddPix(pixa, pix, L_INSERT);
-                        box = boxaGetBox(boxa, i, L_CLONE);
-                        pixaAddBox(pixa, box, L_INSERT);
-                        pixaDestroy(&pixa);
-                    }
-                    break;
-                }
-            }
-            findSimilarSizedTemplatesDestroy(&findcontext);
-            if (found == FALSE) {  /* new class */
-                numaAddNumber(naclass, nt);
+    for (i = 0; i < n; i++) {   /* all instances on this page */
+        pix1 = pixaGetPix(pixa1, i, L_CLONE);
+        pix2 = pixaGetPix(pixa2, i, L_CLONE);
+        ptaGetPt(pta, i, &x1, &y1);   /* use pta for this page */
+        nt = pixaGetCount(pixat);  /* number of templates */
+        found = FALSE;
+        findcontext = findSimilarSizedTemplatesInit(classer, pix1);
+        while ((iclass = findSimilarSizedTemplatesNext(findcontext)) > -1) {
+                /* The templates from earlier pages have been tested */
+            if (iclass < nt0)
+                found = (iclass == params.match[i]);
+            else
+                found = jbMatchTemplate(&params, i, iclass);
+            if (found) {  /* greedy match; take the first */
+                numaAddNumber(naclass, iclass);
                 numaAddNumber(napage, npages);
-                pixa = pixaCreate(0);
-                pix = pixaGetPix(pixas, i, L_CLONE);  /* unbordered instance */
-                pixaAddPix(pixa, pix, L_INSERT);
-                wt = pixGetWidth(pix);
-                ht = pixGetHeight(pix);
-                l_dnaHashAdd(dahash, ht * wt, nt);
-                box = boxaGetBox(boxa, i, L_CLONE);
-                pixaAddBox(pixa, box, L_INSERT);
-                pixaaAddPixa(pixaa, pixa, L_INSERT);  /* unbordered instance */
-                ptaAddPt(ptact, x1, y1);
-                pixaAddPix(pixat, pix1, L_INSERT);  /* bordered template */
-                pixaAddPix(pixatd, pix2, L_INSERT);  /* bordered dil template */
-            } else {  /* don't save them */
-                pixDestroy(&pix1);
-                pixDestroy(&pix2);
-            }
-        }
-    } else {  /* rank < 1.0 */
-        if ((nafg = pixaCountPixels(pixas)) == NULL)  /* areas for this page */
-            return ERROR_INT("nafg not made", procName, 1);
-        nafgt = classer->nafgt;
-        tab8 = makePixelSumTab8();
-        for (i = 0; i < n; i++) {   /* all instances on this page */
-            pix1 = pixaGetPix(pixa1, i, L_CLONE);
-            numaGetIValue(nafg, i, &area1);
-            pix2 = pixaGetPix(pixa2, i, L_CLONE);
-            ptaGetPt(pta, i, &x1, &y1);   /* use pta for this page */
-            nt = pixaGetCount(pixat);  /* number of templates */
-            found = FALSE;
-            findcontext = findSimilarSizedTemplatesInit(classer, pix1);
-            while ((iclass = findSimilarSizedTemplatesNext(findcontext)) > -1) {
-                    /* Find score for this template */
-                pix3 = pixaGetPix(pixat, iclass, L_CLONE);
-                numaGetIValue(nafgt, iclass, &area3);
-                pix4 = pixaGetPix(pixatd, iclass, L_CLONE);
-                ptaGetPt(ptact, iclass, &x2, &y2);
-                testval = pixRankHaustest(pix1, pix2, pix3, pix4,
-                                          x1 - x2, y1 - y2,
-                                          MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
-                                          area1, area3, rank, tab8);
-                pixDestroy(&pix3);
-                pixDestroy(&pix4);
-                if (testval == 1) {  /* greedy match; take the first */
-                    found = TRUE;
-                    numaAddNumber(naclass, iclass);
-                    numaAddNumber(napage, npages);
-                    if (classer->keep_pixaa) {
-                        pixa = pixaaGetPixa(pixaa, iclass, L_CLONE);
-                        pix = pixaGetPix(pixas, i, L_CLONE);
-                        pixaAddPix(pixa, pix, L_INSERT);
-                        box = boxaGetBox(boxa, i, L_CLONE);
-                        pixaAddBox(pixa, box, L_INSERT);
-                        pixaDestroy(&pixa);
-                    }
-                    break;
+                if (classer->keep_pixaa) {
+                    pixa = pixaaGetPixa(pixaa, iclass, L_CLONE);
+                    pix = pixaGetPix(pixas, i, L_CLONE);
+                    pixaAddPix(pixa, pix, L_INSERT);
+                    box = boxaGetBox(boxa, i, L_CLONE);
+                    pixaAddBox(pixa, box, L_INSERT);
+                    pixaDestroy(&pixa);
                 }
-            }
-            findSimilarSizedTemplatesDestroy(&findcontext);
-            if (found == FALSE) {  /* new class */
-                numaAddNumber(naclass, nt);
-                numaAddNumber(napage, npages);
-                pixa = pixaCreate(0);
-                pix = pixaGetPix(pixas, i, L_CLONE);  /* unbordered instance */
-                pixaAddPix(pixa, pix, L_INSERT);
-                wt = pixGetWidth(pix);
-                ht = pixGetHeight(pix);
-                l_dnaHashAdd(dahash, ht * wt, nt);
-                box = boxaGetBox(boxa, i, L_CLONE);
-                pixaAddBox(pixa, box, L_INSERT);
-                pixaaAddPixa(pixaa, pixa, L_INSERT);  /* unbordered instance */
-                ptaAddPt(ptact, x1, y1);
-                pixaAddPix(pixat, pix1, L_INSERT);  /* bordered template */
-                pixaAddPix(pixatd, pix2, L_INSERT);  /* ditto */
-                numaAddNumber(nafgt, area1);
-            } else {  /* don't save them */
-                pixDestroy(&pix1);
-                pixDestroy(&pix2);
+                break;
             }
         }
-        LEPT_FREE(tab8);
-        numaDestroy(&nafg);
+        findSimilarSizedTemplatesDestroy(&findcontext);
+        if (found == FALSE) {  /* new class */
+            numaAddNumber(naclass, nt);
+            numaAddNumber(napage, npages);
+            pixa = pixaCreate(0);
+            pix = pixaGetPix(pixas, i, L_CLONE);  /* unbordered instance */
+            pixaAddPix(pixa, pix, L_INSERT);
+            wt = pixGetWidth(pix);
+            ht = pixGetHeight(pix);
+            l_dnaHashAdd(dahash, ht * wt, nt);
+            box = boxaGetBox(boxa, i, L_CLONE);
+            pixaAddBox(pixa, box, L_INSERT);
+            pixaaAddPixa(pixaa, pixa, L_INSERT);  /* unbordered instance */
+            ptaAddPt(ptact, x1, y1);
+            pixaAddPix(pixat, pix1, L_INSERT);  /* bordered template */
+            pixaAddPix(pixatd, pix2, L_INSERT);  /* bordered dil template */
+            if (rank < 1.0)
+                numaAddNumber(nafgt, areas[i]);
+        } else {  /* don't save them */
+            pixDestroy(&pix1);
+            pixDestroy(&pix2);
+        }
     }
     classer->nclass = pixaGetCount(pixat);
 
+    LEPT_FREE(params.match);
+    LEPT_FREE(areas);
     LEPT_FREE(sumtab);
+    numaDestroy(&nafg);
     ptaDestroy(&pta);
     pixaDestroy(&pixa1);
     pixaDestroy(&pixa2);
@@ -1013,32 +1108,37 @@ PIX     *pixt;
  *              boxa (of new components for classification)
  *              pixas (of new components for classification)
  *      Return: 0 if OK; 1 on error
+ *
+ *  Notes:
+ *      (1) With more than one thread, the components are compared in
+ *          parallel with the templates made on earlier pages; see
+ *          jbMatchComponent().  The result is the same for any number
+ *          of threads.
  */
 l_int32
 jbClassifyCorrelation(JBCLASSER  *classer,
                       BOXA       *boxa,
                       PIXA       *pixas)
 {
-l_int32     n, nt, i, iclass, wt, ht, found, area, area1, area2, npages,
-            overthreshold;
-l_int32    *sumtab, *centtab;
-l_uint32   *row, word;
-l_float32   x1, y1, x2, y2, xsum, ysum;
-l_float32   thresh, weight, threshold;
-BOX        *box;
-NUMA       *naclass, *napage;
-NUMA       *nafgt;   /* fg area of all templates */
-NUMA       *naarea;   /* w * h area of all templates */
-JBFINDCTX  *findcontext;
-L_DNAHASH  *dahash;
-PIX        *pix, *pix1, *pix2;
-PIXA       *pixa, *pixa1, *pixat;
-PIXAA      *pixaa;
-PTA        *pta, *ptac, *ptact;
-l_int32    *pixcts;  /* pixel counts of each pixa */
-l_int32   **pixrowcts;  /* row-by-row pixel counts of each pixa */
-l_int32     x, y, rowcount, downcount, wpl;
-l_uint8     byte;
+l_int32          n, nt, nt0, i, iclass, wt, ht, found, area, area1, npages;
+l_int32         *sumtab, *centtab;
+l_uint32        *row, word;
+l_float32        x1, y1, xsum, ysum;
+BOX             *box;
+NUMA            *naclass, *napage;
+NUMA            *nafgt;   /* fg area of all templates */
+NUMA            *naarea;   /* w * h area of all templates */
+JBFINDCTX       *findcontext;
+JB_MATCH_PARAMS  params;
+L_DNAHASH       *dahash;
+PIX             *pix, *pix1;
+PIXA            *pixa, *pixa1, *pixat;
+PIXAA           *pixaa;
+PTA             *pta, *ptac, *ptact;
+l_int32         *pixcts;  /* pixel counts of each pixa */
+l_int32        **pixrowcts;  /* row-by-row pixel counts of each pixa */
+l_int32          x, y, rowcount, downcount, wpl;
+l_uint8          byte;
 
     PROCNAME("jbClassifyCorrelation");
 
@@ -1141,6 +1241,23 @@ l_uint8     byte;
         /* Array to store class exemplars */
     pixat = classer->pixat;
 
+        /* With more than one thread, first compare every component
+         * with the templates from the earlier pages.  These are not
+         * changed until all the components have been tested, so this
+         * is done in parallel.  With one thread, nt0 = 0 and all
+         * templates are tested in the loop below. */
+    memset(&params, 0, sizeof(JB_MATCH_PARAMS));
+    params.classer = classer;
+    params.pixi = pixaGetPixArray(pixa1);
+    params.pta = pta;
+    params.pixcts = pixcts;
+    params.pixrowcts = pixrowcts;
+    params.sumtab = sumtab;
+    params.match = (l_int32 *)LEPT_CALLOC(L_MAX(n, 1), sizeof(l_int32));
+    nt0 = (l_getParallelThreads() > 1) ? pixaGetCount(pixat) : 0;
+    if (nt0 > 0)
+        l_parallelRun(n, 0, jbMatchComponent, &params);
+
         /* Fill up the pixaa tree with the template exemplars as
          * the first pix in each pixa.  As we add each pix,
          * we also add the associated box to the pixa.
@@ -1159,8 +1276,6 @@ l_uint8     byte;
          * same character.  The weightfactor adds in some of the
          * difference (1.0 - thresh), depending on the heaviness
          * of the template (measured as the fraction of fg pixels). */
-    thresh = classer->thresh;
-    weight = classer->weightfactor;
     naarea = classer->naarea;
     dahash = classer->dahash;
     for (i = 0; i < n; i++) {
@@ -1171,58 +1286,12 @@ l_uint8     byte;
         found = FALSE;
         findcontext = findSimilarSizedTemplatesInit(classer, pix1);
         while ( (iclass = findSimilarSizedTemplatesNext(findcontext)) > -1) {
-                /* Get the template */
-            pix2 = pixaGetPix(pixat, iclass, L_CLONE);
-            numaGetIValue(nafgt, iclass, &area2);
-            ptaGetPt(ptact, iclass, &x2, &y2);  /* template centroid */
-
-                /* Find threshold for this template */
-            if (weight > 0.0) {
-                numaGetIValue(naarea, iclass, &area);
-                threshold = thresh + (1. - thresh) * weight * area2 / area;
-            } else {
-                threshold = thresh;
-            }
-
-                /* Find score for this template */
-            overthreshold = pixCorrelationScoreThresholded(pix1, pix2,
-                                         area1, area2, x1 - x2, y1 - y2,
-                                         MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
-                                         sumtab, pixrowcts[i], threshold);
-#if DEBUG_CORRELATION_SCORE
-            {
-                l_float32 score, testscore;
-                l_int32 count, testcount;
-                pixCorrelationScore(pix1, pix2, area1, area2, x1 - x2, y1 - y2,
-                                    MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
-                                    sumtab, &score);
-
-                pixCorrelationScoreSimple(pix1, pix2, area1, area2,
-                                          x1 - x2, y1 - y2, MAX_DIFF_WIDTH,
-                                          MAX_DIFF_HEIGHT, sumtab, &testscore);
-                count = (l_int32)rint(sqrt(score * area1 * area2));
-                testcount = (l_int32)rint(sqrt(testscore * area1 * area2));
-                if ((score >= threshold) != (testscore >= threshold)) {
-                    fprintf(stderr, "Correlation score mismatch: "
-                            "%d(%g,%d) vs %d(%g,%d) (%g)\n",
-                            count, score, score >= threshold,
-                            testcount, testscore, testscore >= threshold,
-                            score - testscore);
-                }
-
-                if ((score >= threshold) != overthreshold) {
-                    fprintf(stderr, "Mismatch between correlation/threshold "
-                            "comparison: %g(%g,%d) >= %g(%g) vs %s\n",
-                            score, score*area1*area2, count, threshold,
-                            threshold*area1*area2,
-                            (overthreshold ? "true" : "false"));
-                }
-            }
-#endif  /* DEBUG_CORRELATION_SCORE */
-            pixDestroy(&pix2);
-
-            if (overthreshold) {  /* greedy match */
-                found = TRUE;
+                /* The templates from earlier pages have been tested */
+            if (iclass < nt0)
+                found = (iclass == params.match[i]);
+            else
+                found = jbMatchTemplate(&params, i, iclass);
+            if (found) {  /* greedy match */
                 numaAddNumber(naclass, iclass);
                 numaAddNumber(napage, npages);
                 if (classer->keep_pixaa) {
@@ -1262,6 +1331,7 @@ l_uint8     byte;
     }
     classer->nclass = pixaGetCount(pixat);
 
+    LEPT_FREE(params.match);
     LEPT_FREE(pixcts);
     LEPT_FREE(centtab);
     for (i = 0; i < n; i++) {
@@ -2278,6 +2348,146 @@ PTA       *ptaul, *ptall;
 /*----------------------------------------------------------------------*
  *                              Static helpers                          *
  *----------------------------------------------------------------------*/
+/*!
+ *  jbMatchComponent()
+ *
+ *      Input:  data (JB_MATCH_PARAMS)
+ *              i (index of the component on the page)
+ *      Return: 0 always
+ *
+ *  Notes:
+ *      (1) This finds the first template in the walk over similar sizes
+ *          that matches component i, and saves its index in
+ *          params->match[i], or -1 if there is none.
+ *      (2) The classer is only read, so this can be called on all
+ *          components of a page in parallel, provided that no templates
+ *          are added until it has returned for every component.
+ */
+static l_int32
+jbMatchComponent(void    *data,
+                 l_int32  i)
+{
+l_int32           iclass;
+JBFINDCTX        *findcontext;
+JB_MATCH_PARAMS  *params;
+
+    params = (JB_MATCH_PARAMS *)data;
+    params->match[i] = -1;
+    findcontext = findSimilarSizedTemplatesInit(params->classer,
+                                                params->pixi[i]);
+    while ((iclass = findSimilarSizedTemplatesNext(findcontext)) > -1) {
+        if (jbMatchTemplate(params, i, iclass)) {
+            params->match[i] = iclass;
+            break;
+        }
+    }
+    findSimilarSizedTemplatesDestroy(&findcontext);
+    return 0;
+}
+
+
+/*!
+ *  jbMatchTemplate()
+ *
+ *      Input:  params (JB_MATCH_PARAMS)
+ *              i (index of the component on the page)
+ *              iclass (index of the template)
+ *      Return: 1 (TRUE) if component i is in class iclass; 0 otherwise
+ *
+ *  Notes:
+ *      (1) This uses the test of the classer: correlation, hausdorff
+ *          or rank hausdorff.  No ref counts are changed.
+ */
+static l_int32
+jbMatchTemplate(JB_MATCH_PARAMS  *params,
+                l_int32           i,
+                l_int32           iclass)
+{
+l_int32     area, area1, area2, area3;
+l_float32   x1, y1, x2, y2, threshold;
+JBCLASSER  *classer;
+PIX        *pix1, *pix2, *pix3, *pix4;
+
+    classer = params->classer;
+    pix1 = params->pixi[i];
+    pix3 = pixaGetPixArray(classer->pixat)[iclass];
+    ptaGetPt(params->pta, i, &x1, &y1);  /* centroid for this instance */
+    ptaGetPt(classer->ptact, iclass, &x2, &y2);  /* template centroid */
+
+    if (classer->method == JB_CORRELATION) {
+        area1 = params->pixcts[i];
+        numaGetIValue(classer->nafgt, iclass, &area2);
+
+            /* Find threshold for this template */
+        if (classer->weightfactor > 0.0) {
+            numaGetIValue(classer->naarea, iclass, &area);
+            threshold = classer->thresh + (1. - classer->thresh) *
+                        classer->weightfactor * area2 / area;
+        } else {
+            threshold = classer->thresh;
+        }
+
+#if DEBUG_CORRELATION_SCORE
+        {
+            l_int32 overthreshold;
+            l_float32 score, testscore;
+            l_int32 count, testcount;
+            overthreshold = pixCorrelationScoreThresholded(pix1, pix3,
+                                   area1, area2, x1 - x2, y1 - y2,
+                                   MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
+                                   params->sumtab, params->pixrowcts[i],
+                                   threshold);
+            pixCorrelationScore(pix1, pix3, area1, area2, x1 - x2, y1 - y2,
+                                MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
+                                params->sumtab, &score);
+
+            pixCorrelationScoreSimple(pix1, pix3, area1, area2,
+                                      x1 - x2, y1 - y2, MAX_DIFF_WIDTH,
+                                      MAX_DIFF_HEIGHT, params->sumtab,
+                                      &testscore);
+            count = (l_int32)rint(sqrt(score * area1 * area2));
+            testcount = (l_int32)rint(sqrt(testscore * area1 * area2));
+            if ((score >= threshold) != (testscore >= threshold)) {
+                fprintf(stderr, "Correlation score mismatch: "
+                        "%d(%g,%d) vs %d(%g,%d) (%g)\n",
+                        count, score, score >= threshold,
+                        testcount, testscore, testscore >= threshold,
+                        score - testscore);
+            }
+
+            if ((score >= threshold) != overthreshold) {
+                fprintf(stderr, "Mismatch between correlation/threshold "
+                        "comparison: %g(%g,%d) >= %g(%g) vs %s\n",
+                        score, score*area1*area2, count, threshold,
+                        threshold*area1*area2,
+                        (overthreshold ? "true" : "false"));
+            }
+        }
+#endif  /* DEBUG_CORRELATION_SCORE */
+
+            /* Find score for this template */
+        return pixCorrelationScoreThresholded(pix1, pix3, area1, area2,
+                                              x1 - x2, y1 - y2,
+                                              MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
+                                              params->sumtab,
+                                              params->pixrowcts[i],
+                                              threshold);
+    }
+
+        /* Rank hausdorff; the exact test is used for rank == 1.0 */
+    pix2 = params->pixid[i];
+    pix4 = pixaGetPixArray(classer->pixatd)[iclass];
+    if (classer->rankhaus == 1.0)
+        return pixHaustest(pix1, pix2, pix3, pix4, x1 - x2, y1 - y2,
+                           MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT);
+    numaGetIValue(classer->nafgt, iclass, &area3);
+    return pixRankHaustest(pix1, pix2, pix3, pix4, x1 - x2, y1 - y2,
+                           MAX_DIFF_WIDTH, MAX_DIFF_HEIGHT,
+                           params->pixcts[i], area3, classer->rankhaus,
+                           params->sumtab);
+}
+
+
 /* When looking for similar matches we check templates whose size is +/- 2 in
  * each direction. This involves 25 possible sizes. This array contains the
  * offsets for each of those positions in a spiral pattern. There are 25 pairs
@@ -2346,7 +2556,6 @@ JBFINDCTX  *state;
     if ((state = *pstate) == NULL)
         return;
 
-    l_dnaDestroy(&state->dna);
     LEPT_FREE(state);
     *pstate = NULL;
     return;
@@ -2369,11 +2578,14 @@ JBFINDCTX  *state;
  *  because we hope to find a well-matching template quickly.  So we
  *  keep the context for this walk in an explictit state structure,
  *  and this function acts like a generator.
+ *
+ *  Nothing in the classer is cloned or changed, so that several
+ *  walks can be made at the same time from different threads.
  */
 static l_int32
 findSimilarSizedTemplatesNext(JBFINDCTX  *state)
 {
-l_int32  desiredh, desiredw, size, templ;
+l_int32  desiredh, desiredw, size, templ, w, h;
 PIX     *pixt;
 
     while(1) {  /* Continue the walk over step 'i' */
@@ -2391,7 +2603,7 @@ PIX     *pixt;
         if (!state->dna) {
                 /* We have yet to start walking the array for the step 'i' */
             state->dna = l_dnaHashGetDna(state->classer->dahash,
-                                         desiredh * desiredw, L_CLONE);
+                                         desiredh * desiredw, L_NOCOPY);
             if (!state->dna) {  /* nothing there */
                 state->i++;
                 continue;
@@ -2404,19 +2616,17 @@ PIX     *pixt;
         size = l_dnaGetCount(state->dna);
         for ( ; state->n < size; ) {
             templ = (l_int32)(state->dna->array[state->n++] + 0.5);
-            pixt = pixaGetPix(state->classer->pixat, templ, L_CLONE);
-            if (pixGetWidth(pixt) - 2 * JB_ADDED_PIXELS == desiredw &&
-                pixGetHeight(pixt) - 2 * JB_ADDED_PIXELS == desiredh) {
-                pixDestroy(&pixt);
+            pixt = pixaGetPixArray(state->classer->pixat)[templ];
+            pixGetDimensions(pixt, &w, &h, NULL);
+            if (w - 2 * JB_ADDED_PIXELS == desiredw &&
+                h - 2 * JB_ADDED_PIXELS == desiredh)
                 return templ;
-            }
-            pixDestroy(&pixt);
         }
 
             /* Exhausted the dna (no match found); take another step and
              * try again. */
         state->i++;
-        l_dnaDestroy(&state->dna);
+        state->dna = NULL;
         continue;
     }
 }
@@ -49,6 +49,18 @@
  *    Setting special flag for chroma sampling on write
  *          l_int32          pixSetChromaSampling()
  *
+ *    Band reading and writing (see bandio.c)
+ *          l_int32          jpegBandReaderOpen()
+ *          l_int32          jpegBandReaderRead()
+ *          void             jpegBandReaderClose()
+ *          l_int32          jpegBandWriterOpen()
+ *          l_int32          jpegBandWriterWrite()
+ *          l_int32          jpegBandWriterClose()
+ *
+ *    Static helpers
+ *          static void      jpegSetColorRow()
+ *          static PIX      *jpegPrepareForWrite()
+ *
  *    Static system helpers
  *          static void      jpeg_error_catch_all_1()
  *          static void      jpeg_error_catch_all_2()
@@ -154,6 +166,9 @@ static l_uint8 jpeg_getc(j_decompress_ptr cinfo);
      * the prototype for jpeg_comment_callback() is given as
      * returning a boolean.  */
 static boolean jpeg_comment_callback(j_decompress_ptr cinfo);
+static void jpegSetColorRow(JSAMPROW rowbuffer, l_uint32 *line, l_int32 w,
+                            l_int32 spp, l_int32 adobe);
+static PIX *jpegPrepareForWrite(PIX *pixs);
 
     /* This is saved in the client_data field of cinfo, and used both
      * to retrieve the comment from its callback and to handle
@@ -163,6 +178,25 @@ struct callback_data {
     l_uint8  *comment;
 };
 
+    /* Decoder and encoder state that is kept between band reads and
+     * writes, in the codec field of the L_BANDREADER and L_BANDWRITER.
+     * The jmpbuf is in the client_data field of cinfo, as above, and
+     * setjmp() is called on it in each function that calls libjpeg. */
+struct jpeg_band_reader {
+    jmp_buf                        jmpbuf;
+    struct jpeg_decompress_struct  cinfo;
+    struct jpeg_error_mgr          jerr;
+    JSAMPROW                       rowbuffer;
+    l_int32                        spp;     /* components decoded */
+};
+
+struct jpeg_band_writer {
+    jmp_buf                        jmpbuf;
+    struct jpeg_compress_struct    cinfo;
+    struct jpeg_error_mgr          jerr;
+    JSAMPROW                       rowbuffer;
+};
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_INFO      0
 #endif  /* ~NO_CONSOLE_IO */
@@ -266,11 +300,11 @@ pixReadStreamJpeg(FILE     *fp,
                   l_int32  *pnwarn,
                   l_int32   hint)
 {
-l_int32                        cyan, yellow, magenta, black, nwarn;
-l_int32                        i, j, k, rval, gval, bval;
+l_int32                        nwarn;
+l_int32                        i, j, rval, gval, bval;
 l_int32                        w, h, wpl, spp, ncolors, cindex, ycck, cmyk;
 l_uint32                      *data;
-l_uint32                      *line, *ppixel;
+l_uint32                      *line;
 JSAMPROW                       rowbuffer;
 PIX                           *pix;
 PIXCMAP                       *cmap;
@@ -390,57 +424,8 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 
             /* -- 24 bit color -- */
         if ((spp == 3 && cmapflag == 0) || ycck || cmyk) {
-            ppixel = data + i * wpl;
-            if (spp == 3) {
-                for (j = k = 0; j < w; j++) {
-                    SET_DATA_BYTE(ppixel, COLOR_RED, rowbuffer[k++]);
-                    SET_DATA_BYTE(ppixel, COLOR_GREEN, rowbuffer[k++]);
-                    SET_DATA_BYTE(ppixel, COLOR_BLUE, rowbuffer[k++]);
-                    ppixel++;
-                }
-            } else {
-                    /* This is a conversion from CMYK -> RGB that ignores
-                       color profiles, and is invoked when the image header
-                       claims to be in CMYK or YCCK colorspace.  If in YCCK,
-                       libjpeg may be doing YCCK -> CMYK under the hood.
-                       To understand why the colors need to be inverted on
-                       read-in for the Adobe marker, see the "Special
-                       color spaces" section of "Using the IJG JPEG
-                       Library" by Thomas G. Lane:
-                         http://www.jpegcameras.com/libjpeg/libjpeg-3.html#ss3.1
-                       The non-Adobe conversion is equivalent to:
-                           rval = black - black * cyan / 255
-                           ...
-                       The Adobe conversion is equivalent to:
-                           rval = black - black * (255 - cyan) / 255
-                           ...
-                       Note that cyan is the complement to red, and we
-                       are subtracting the complement color (weighted
-                       by black) from black.  For Adobe conversions,
-                       where they've already inverted the CMY but not
-                       the K, we have to invert again.  The results
-                       must be clipped to [0 ... 255]. */
-                for (j = k = 0; j < w; j++) {
-                    cyan = rowbuffer[k++];
-                    magenta = rowbuffer[k++];
-                    yellow = rowbuffer[k++];
-                    black = rowbuffer[k++];
-                    if (cinfo.saw_Adobe_marker) {
-                        rval = (black * cyan) / 255;
-                        gval = (black * magenta) / 255;
-                        bval = (black * yellow) / 255;
-                    } else {
-                        rval = black * (255 - cyan) / 255;
-                        gval = black * (255 - magenta) / 255;
-                        bval = black * (255 - yellow) / 255;
-                    }
-                    rval = L_MIN(L_MAX(rval, 0), 255);
-                    gval = L_MIN(L_MAX(gval, 0), 255);
-                    bval = L_MIN(L_MAX(bval, 0), 255);
-                    composeRGBPixel(rval, gval, bval, ppixel);
-                    ppixel++;
-                }
-            }
+            jpegSetColorRow(rowbuffer, data + i * wpl, w, spp,
+                            cinfo.saw_Adobe_marker);
         } else {    /* 8 bpp grayscale or colormapped pix */
             line = data + i * wpl;
             for (j = 0; j < w; j++)
@@ -802,25 +787,9 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     if (quality <= 0)
         quality = 75;  /* default */
 
-        /* If necessary, convert the pix so that it can be jpeg compressed.
-         * The colormap is removed based on the source, so if the colormap
-         * has only gray colors, the image will be compressed with spp = 1. */
+        /* If necessary, convert the pix so that it can be jpeg compressed */
     pixGetDimensions(pixs, &w, &h, &d);
-    pix = NULL;
-    if (pixGetColormap(pixs) != NULL) {
-        L_INFO("removing colormap; may be better to compress losslessly\n",
-               procName);
-        pix = pixRemoveColormap(pixs, REMOVE_CMAP_BASED_ON_SRC);
-    } else if (d >= 8 && d != 16) {  /* normal case; no rewrite */
-        pix = pixClone(pixs);
-    } else if (d < 8 || d == 16) {
-        L_INFO("converting from %d to 8 bpp\n", procName, d);
-        pix = pixConvertTo8(pixs, 0);  /* 8 bpp, no cmap */
-    } else {
-        L_ERROR("unknown pix type with d = %d and no cmap\n", procName, d);
-        return 1;
-    }
-    if (!pix)
+    if ((pix = jpegPrepareForWrite(pixs)) == NULL)
         return ERROR_INT("pix not made", procName, 1);
 
     rewind(fp);
@@ -1128,6 +1097,463 @@ pixSetChromaSampling(PIX     *pix,
 }
 
 
+/*---------------------------------------------------------------------*
+ *                     Band reading and writing                        *
+ *---------------------------------------------------------------------*/
+/*!
+ *  jpegBandReaderOpen()
+ *
+ *      Input:  br (band reader, with the stream at the start of the file)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandReaderCreate().  It reads the jpeg
+ *          header, starts the decompression and sets the image
+ *          parameters in @br.
+ *      (2) The decoded rows are the same as in pixReadStreamJpeg()
+ *          without a colormap, at full resolution: 8 bpp gray, or
+ *          32 bpp rgb (including the conversion from YCCK and CMYK).
+ */
+l_int32
+jpegBandReaderOpen(L_BANDREADER  *br)
+{
+l_int32                   spp, cmyk;
+struct jpeg_band_reader  *jbr;
+
+    PROCNAME("jpegBandReaderOpen");
+
+    if (!br || !br->fp)
+        return ERROR_INT("br or stream not defined", procName, 1);
+    if (BITS_IN_JSAMPLE != 8)  /* set in jmorecfg.h */
+        return ERROR_INT("BITS_IN_JSAMPLE != 8", procName, 1);
+
+    if ((jbr = (struct jpeg_band_reader *)LEPT_CALLOC(1,
+               sizeof(struct jpeg_band_reader))) == NULL)
+        return ERROR_INT("jbr not made", procName, 1);
+    br->codec = (void *)jbr;
+
+    jbr->cinfo.err = jpeg_std_error(&jbr->jerr);
+    jbr->jerr.error_exit = jpeg_error_catch_all_1;
+    jbr->cinfo.client_data = (void *)&jbr->jmpbuf;
+    if (setjmp(jbr->jmpbuf))
+        return ERROR_INT("internal jpeg error", procName, 1);
+
+    jpeg_create_decompress(&jbr->cinfo);
+    jpeg_stdio_src(&jbr->cinfo, br->fp);
+    jpeg_read_header(&jbr->cinfo, TRUE);
+    jpeg_calc_output_dimensions(&jbr->cinfo);
+    spp = jbr->cinfo.out_color_components;
+    cmyk = ((jbr->cinfo.jpeg_color_space == JCS_YCCK ||
+             jbr->cinfo.jpeg_color_space == JCS_CMYK) && spp == 4);
+    if (spp != 1 && spp != 3 && !cmyk)
+        return ERROR_INT("spp must be 1 or 3, or YCCK or CMYK", procName, 1);
+
+    br->w = jbr->cinfo.output_width;
+    br->h = jbr->cinfo.output_height;
+    br->d = (spp == 1) ? 8 : 32;
+    br->spp = (spp == 1) ? 1 : 3;
+    if (jbr->cinfo.density_unit == 1) {  /* pixels per inch */
+        br->xres = jbr->cinfo.X_density;
+        br->yres = jbr->cinfo.Y_density;
+    } else if (jbr->cinfo.density_unit == 2) {  /* pixels per centimeter */
+        br->xres = (l_int32)((l_float32)jbr->cinfo.X_density * 2.54 + 0.5);
+        br->yres = (l_int32)((l_float32)jbr->cinfo.Y_density * 2.54 + 0.5);
+    }
+
+    jbr->spp = spp;
+    if ((jbr->rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE),
+                                                spp * br->w)) == NULL)
+        return ERROR_INT("rowbuffer not made", procName, 1);
+    jbr->cinfo.quantize_colors = FALSE;
+    jpeg_start_decompress(&jbr->cinfo);
+    return 0;
+}
+
+
+/*!
+ *  jpegBandReaderRead()
+ *
+ *      Input:  br
+ *              pixd (band to receive the rows)
+ *              y (first row in pixd to be written)
+ *              nrows (number of rows to decode)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+jpegBandReaderRead(L_BANDREADER  *br,
+                   PIX           *pixd,
+                   l_int32        y,
+                   l_int32        nrows)
+{
+l_int32                   i, j, w, wpl;
+l_uint32                 *data, *line;
+struct jpeg_band_reader  *jbr;
+
+    PROCNAME("jpegBandReaderRead");
+
+    if (!br || !br->codec)
+        return ERROR_INT("br or codec not defined", procName, 1);
+    if (!pixd)
+        return ERROR_INT("pixd not defined", procName, 1);
+
+    jbr = (struct jpeg_band_reader *)br->codec;
+    if (setjmp(jbr->jmpbuf))
+        return ERROR_INT("internal jpeg error", procName, 1);
+
+    w = br->w;
+    wpl = pixGetWpl(pixd);
+    data = pixGetData(pixd);
+    for (i = 0; i < nrows; i++) {
+        if (jpeg_read_scanlines(&jbr->cinfo, &jbr->rowbuffer,
+                                (JDIMENSION)1) == 0) {
+            L_ERROR("read error at scanline %d\n", procName,
+                    jbr->cinfo.output_scanline);
+            return ERROR_INT("bad data", procName, 1);
+        }
+        line = data + (y + i) * wpl;
+        if (jbr->spp == 1) {
+            for (j = 0; j < w; j++)
+                SET_DATA_BYTE(line, j, jbr->rowbuffer[j]);
+        } else {
+            jpegSetColorRow(jbr->rowbuffer, line, w, jbr->spp,
+                            jbr->cinfo.saw_Adobe_marker);
+        }
+    }
+    return 0;
+}
+
+
+/*!
+ *  jpegBandReaderClose()
+ *
+ *      Input:  br
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) If all rows have been read, this finishes the decompression
+ *          and warns if the jpeg library reported corrupted data.
+ */
+void
+jpegBandReaderClose(L_BANDREADER  *br)
+{
+l_int32                   nwarn;
+struct jpeg_band_reader  *jbr;
+
+    PROCNAME("jpegBandReaderClose");
+
+    if (!br || !br->codec)
+        return;
+
+    jbr = (struct jpeg_band_reader *)br->codec;
+    if (!setjmp(jbr->jmpbuf)) {
+        if (br->nread == br->h && jbr->cinfo.output_scanline == br->h) {
+            nwarn = jbr->cinfo.err->num_warnings;
+            if (nwarn > 0)
+                L_WARNING("%d warning(s) of bad data\n", procName, nwarn);
+            jpeg_finish_decompress(&jbr->cinfo);
+        }
+    }
+    jpeg_destroy_decompress(&jbr->cinfo);
+    LEPT_FREE(jbr->rowbuffer);
+    LEPT_FREE(jbr);
+    br->codec = NULL;
+    return;
+}
+
+
+/*!
+ *  jpegBandWriterOpen()
+ *
+ *      Input:  bw (band writer)
+ *              pixs (first band of the image)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandWriterWrite() for the first band.
+ *          It starts the compression, using the height and quality
+ *          in @bw and the width, depth, resolution, text and chroma
+ *          sampling of @pixs, as pixWriteStreamJpeg() does.
+ *      (2) Each band is converted for jpeg compression in the same
+ *          way as the full image would be; e.g., a colormap is
+ *          removed and 1 bpp is converted to 8 bpp.
+ */
+l_int32
+jpegBandWriterOpen(L_BANDWRITER  *bw,
+                   PIX           *pixs)
+{
+l_int32                   w, d, xres, yres;
+const char               *text;
+PIX                      *pix;
+struct jpeg_band_writer  *jbw;
+
+    PROCNAME("jpegBandWriterOpen");
+
+    if (!bw || !bw->fp)
+        return ERROR_INT("bw or stream not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    if ((pix = jpegPrepareForWrite(pixs)) == NULL)
+        return ERROR_INT("pix not made", procName, 1);
+    pixGetDimensions(pix, &w, NULL, &d);
+    pixDestroy(&pix);
+
+    if ((jbw = (struct jpeg_band_writer *)LEPT_CALLOC(1,
+               sizeof(struct jpeg_band_writer))) == NULL)
+        return ERROR_INT("jbw not made", procName, 1);
+    bw->codec = (void *)jbw;
+    if ((jbw->rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE),
+                                        ((d == 8) ? 1 : 3) * w)) == NULL)
+        return ERROR_INT("rowbuffer not made", procName, 1);
+
+    jbw->cinfo.err = jpeg_std_error(&jbw->jerr);
+    jbw->jerr.error_exit = jpeg_error_catch_all_1;
+    jbw->cinfo.client_data = (void *)&jbw->jmpbuf;
+    if (setjmp(jbw->jmpbuf))
+        return ERROR_INT("internal jpeg error", procName, 1);
+
+    jpeg_create_compress(&jbw->cinfo);
+    jpeg_stdio_dest(&jbw->cinfo, bw->fp);
+    jbw->cinfo.image_width  = w;
+    jbw->cinfo.image_height = bw->h;
+    if (d == 8) {
+        jbw->cinfo.input_components = 1;
+        jbw->cinfo.in_color_space = JCS_GRAYSCALE;
+    } else {
+        jbw->cinfo.input_components = 3;
+        jbw->cinfo.in_color_space = JCS_RGB;
+    }
+    jpeg_set_defaults(&jbw->cinfo);
+    jbw->cinfo.optimize_coding = FALSE;
+
+    xres = pixGetXRes(pixs);
+    yres = pixGetYRes(pixs);
+    if ((xres != 0) && (yres != 0)) {
+        jbw->cinfo.density_unit = 1;  /* designates pixels per inch */
+        jbw->cinfo.X_density = xres;
+        jbw->cinfo.Y_density = yres;
+    }
+    jpeg_set_quality(&jbw->cinfo, bw->quality, TRUE);
+    if (pixs->special == L_NO_CHROMA_SAMPLING_JPEG) {
+        jbw->cinfo.comp_info[0].h_samp_factor = 1;
+        jbw->cinfo.comp_info[0].v_samp_factor = 1;
+        jbw->cinfo.comp_info[1].h_samp_factor = 1;
+        jbw->cinfo.comp_info[1].v_samp_factor = 1;
+        jbw->cinfo.comp_info[2].h_samp_factor = 1;
+        jbw->cinfo.comp_info[2].v_samp_factor = 1;
+    }
+
+    jpeg_start_compress(&jbw->cinfo, TRUE);
+    if ((text = pixGetText(pixs)))
+        jpeg_write_marker(&jbw->cinfo, JPEG_COM, (const JOCTET *)text,
+                          strlen(text));
+    return 0;
+}
+
+
+/*!
+ *  jpegBandWriterWrite()
+ *
+ *      Input:  bw
+ *              pixs (band to be encoded)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+jpegBandWriterWrite(L_BANDWRITER  *bw,
+                    PIX           *pixs)
+{
+l_int32                   i, j, k, w, h, d, wpl;
+l_uint32                 *data, *line, *ppixel;
+JSAMPROW                  rowbuffer;
+PIX                      *pix;
+struct jpeg_band_writer  *jbw;
+
+    PROCNAME("jpegBandWriterWrite");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    jbw = (struct jpeg_band_writer *)bw->codec;
+    if ((pix = jpegPrepareForWrite(pixs)) == NULL)
+        return ERROR_INT("pix not made", procName, 1);
+    if (setjmp(jbw->jmpbuf)) {
+        pixDestroy(&pix);
+        return ERROR_INT("internal jpeg error", procName, 1);
+    }
+
+    pixGetDimensions(pix, &w, &h, &d);
+    rowbuffer = jbw->rowbuffer;
+    wpl = pixGetWpl(pix);
+    data = pixGetData(pix);
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        if (d == 8) {
+            for (j = 0; j < w; j++)
+                rowbuffer[j] = GET_DATA_BYTE(line, j);
+        } else {
+            for (j = k = 0, ppixel = line; j < w; j++, ppixel++) {
+                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
+                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
+                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
+            }
+        }
+        jpeg_write_scanlines(&jbw->cinfo, &rowbuffer, 1);
+    }
+    pixDestroy(&pix);
+    return 0;
+}
+
+
+/*!
+ *  jpegBandWriterClose()
+ *
+ *      Input:  bw
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) If all rows have been written, this finishes the
+ *          compression; otherwise the encoder is abandoned.
+ */
+l_int32
+jpegBandWriterClose(L_BANDWRITER  *bw)
+{
+l_int32                   ret;
+struct jpeg_band_writer  *jbw;
+
+    PROCNAME("jpegBandWriterClose");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+
+    jbw = (struct jpeg_band_writer *)bw->codec;
+    ret = (bw->nwritten == bw->h) ? 0 : 1;
+    if (setjmp(jbw->jmpbuf)) {
+        ret = 1;
+    } else if (ret == 0) {
+        jpeg_finish_compress(&jbw->cinfo);
+    }
+    jpeg_destroy_compress(&jbw->cinfo);
+    LEPT_FREE(jbw->rowbuffer);
+    LEPT_FREE(jbw);
+    bw->codec = NULL;
+    return ret;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                            Static helpers                           *
+ *---------------------------------------------------------------------*/
+/*!
+ *  jpegSetColorRow()
+ *
+ *      Input:  rowbuffer (one decoded scanline, with 3 or 4 samples)
+ *              line (of a 32 bpp pix)
+ *              w (width)
+ *              spp (3 for rgb; 4 for YCCK or CMYK)
+ *              adobe (1 if the Adobe marker was seen)
+ *      Return: void
+ */
+static void
+jpegSetColorRow(JSAMPROW   rowbuffer,
+                l_uint32  *line,
+                l_int32    w,
+                l_int32    spp,
+                l_int32    adobe)
+{
+l_int32    j, k, cyan, yellow, magenta, black, rval, gval, bval;
+l_uint32  *ppixel;
+
+    ppixel = line;
+    if (spp == 3) {
+        for (j = k = 0; j < w; j++) {
+            SET_DATA_BYTE(ppixel, COLOR_RED, rowbuffer[k++]);
+            SET_DATA_BYTE(ppixel, COLOR_GREEN, rowbuffer[k++]);
+            SET_DATA_BYTE(ppixel, COLOR_BLUE, rowbuffer[k++]);
+            ppixel++;
+        }
+        return;
+    }
+
+        /* This is a conversion from CMYK -> RGB that ignores
+           color profiles, and is invoked when the image header
+           claims to be in CMYK or YCCK colorspace.  If in YCCK,
+           libjpeg may be doing YCCK -> CMYK under the hood.
+           To understand why the colors need to be inverted on
+           read-in for the Adobe marker, see the "Special
+           color spaces" section of "Using the IJG JPEG
+           Library" by Thomas G. Lane:
+             http://www.jpegcameras.com/libjpeg/libjpeg-3.html#ss3.1
+           The non-Adobe conversion is equivalent to:
+               rval = black - black * cyan / 255
+               ...
+           The Adobe conversion is equivalent to:
+               rval = black - black * (255 - cyan) / 255
+               ...
+           Note that cyan is the complement to red, and we
+           are subtracting the complement color (weighted
+           by black) from black.  For Adobe conversions,
+           where they've already inverted the CMY but not
+           the K, we have to invert again.  The results
+           must be clipped to [0 ... 255]. */
+    for (j = k = 0; j < w; j++) {
+        cyan = rowbuffer[k++];
+        magenta = rowbuffer[k++];
+        yellow = rowbuffer[k++];
+        black = rowbuffer[k++];
+        if (adobe) {
+            rval = (black * cyan) / 255;
+            gval = (black * magenta) / 255;
+            bval = (black * yellow) / 255;
+        } else {
+            rval = black * (255 - cyan) / 255;
+            gval = black * (255 - magenta) / 255;
+            bval = black * (255 - yellow) / 255;
+        }
+        rval = L_MIN(L_MAX(rval, 0), 255);
+        gval = L_MIN(L_MAX(gval, 0), 255);
+        bval = L_MIN(L_MAX(bval, 0), 255);
+        composeRGBPixel(rval, gval, bval, ppixel);
+        ppixel++;
+    }
+    return;
+}
+
+
+/*!
+ *  jpegPrepareForWrite()
+ *
+ *      Input:  pixs
+ *      Return: pix that can be jpeg compressed, or null on error
+ *
+ *  Notes:
+ *      (1) The colormap is removed based on the source, so if the
+ *          colormap has only gray colors, the image will be compressed
+ *          with spp = 1.  Depths less than 8 and 16 bpp are converted
+ *          to 8 bpp.  Otherwise, this returns a clone.
+ */
+static PIX *
+jpegPrepareForWrite(PIX  *pixs)
+{
+l_int32  d;
+
+    PROCNAME("jpegPrepareForWrite");
+
+    d = pixGetDepth(pixs);
+    if (pixGetColormap(pixs) != NULL) {
+        L_INFO("removing colormap; may be better to compress losslessly\n",
+               procName);
+        return pixRemoveColormap(pixs, REMOVE_CMAP_BASED_ON_SRC);
+    } else if (d >= 8 && d != 16) {  /* normal case; no rewrite */
+        return pixClone(pixs);
+    } else {
+        L_INFO("converting from %d to 8 bpp\n", procName, d);
+        return pixConvertTo8(pixs, 0);  /* 8 bpp, no cmap */
+    }
+}
+
+
 /*---------------------------------------------------------------------*
  *                        Static system helpers                        *
  *---------------------------------------------------------------------*/
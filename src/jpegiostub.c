@@ -136,6 +136,50 @@ l_int32 pixSetChromaSampling(PIX *pix, l_int32 sampling)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 jpegBandReaderOpen(L_BANDREADER *br)
+{
+    return ERROR_INT("function not present", "jpegBandReaderOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 jpegBandReaderRead(L_BANDREADER *br, PIX *pixd, l_int32 y,
+                           l_int32 nrows)
+{
+    return ERROR_INT("function not present", "jpegBandReaderRead", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+void jpegBandReaderClose(L_BANDREADER *br)
+{
+    L_ERROR("function not present\n", "jpegBandReaderClose");
+    return;
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 jpegBandWriterOpen(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "jpegBandWriterOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 jpegBandWriterWrite(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "jpegBandWriterWrite", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 jpegBandWriterClose(L_BANDWRITER *bw)
+{
+    return ERROR_INT("function not present", "jpegBandWriterClose", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 /* --------------------------------------------*/
 #endif  /* !HAVE_LIBJPEG */
 /* --------------------------------------------*/
@@ -47,6 +47,9 @@
  *            L_KERNEL   *kernelNormalize()
  *            L_KERNEL   *kernelInvert()
  *
+ *         Separable kernels
+ *            l_int32     kernelGetSeparable()
+ *
  *         Helper function
  *            l_float32 **create2dFloatArray()
  *
@@ -82,6 +85,10 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Largest difference, relative to the largest kernel value, between
+     * a kernel value and the product of the separable factors */
+static const l_float32  SeparableTolerance = 0.00001;
+
 
 /*------------------------------------------------------------------------*
  *                           Create / Destroy                             *
@@ -455,6 +462,98 @@ L_KERNEL  *keld;
 }
 
 
+/*----------------------------------------------------------------------*
+ *                           Separable kernels                          *
+ *----------------------------------------------------------------------*/
+/*!
+ *  kernelGetSeparable()
+ *
+ *      Input:  kel
+ *              &kelx (<return> kernel with one row; null if kel
+ *                     is not separable)
+ *              &kely (<return> kernel with one column; null if kel
+ *                     is not separable)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) A kernel is separable if each element is the product of
+ *          an element of a row kernel and an element of a column
+ *          kernel:  kel[i][j] = kely[i] * kelx[j].  As a matrix,
+ *          the kernel has rank 1.
+ *      (2) The factors are the row and the column through the element
+ *          of largest magnitude, with kely scaled to 1.0 at that element.
+ *          Every element of the kernel must differ from the product
+ *          of the factors by at most SeparableTolerance times the
+ *          largest magnitude.
+ *      (3) kelx has the origin cx of kel, and kely has its origin cy,
+ *          so that convolving with kelx and then with kely, as is done
+ *          in pixConvolveSep(), is the same as convolving with kel,
+ *          apart from rounding.
+ *      (4) A kernel of zeroes is not separable.
+ */
+l_int32
+kernelGetSeparable(L_KERNEL   *kel,
+                   L_KERNEL  **pkelx,
+                   L_KERNEL  **pkely)
+{
+l_int32    i, j, sx, sy, cx, cy, imax, jmax;
+l_float32  val, maxval, pivot;
+L_KERNEL  *kelx, *kely;
+
+    PROCNAME("kernelGetSeparable");
+
+    if (pkelx) *pkelx = NULL;
+    if (pkely) *pkely = NULL;
+    if (!pkelx || !pkely)
+        return ERROR_INT("&kelx and &kely not both defined", procName, 1);
+    if (!kel)
+        return ERROR_INT("kernel not defined", procName, 1);
+
+        /* Find the pivot, the element of largest magnitude */
+    kernelGetParameters(kel, &sy, &sx, &cy, &cx);
+    maxval = 0.0;
+    imax = jmax = 0;
+    for (i = 0; i < sy; i++) {
+        for (j = 0; j < sx; j++) {
+            val = L_ABS(kel->data[i][j]);
+            if (val > maxval) {
+                maxval = val;
+                imax = i;
+                jmax = j;
+            }
+        }
+    }
+    if (maxval == 0.0)
+        return 0;
+
+        /* Test that the kernel has rank 1 */
+    pivot = kel->data[imax][jmax];
+    for (i = 0; i < sy; i++) {
+        for (j = 0; j < sx; j++) {
+            val = kel->data[i][jmax] * kel->data[imax][j] / pivot;
+            if (L_ABS(kel->data[i][j] - val) > SeparableTolerance * maxval)
+                return 0;
+        }
+    }
+
+    if ((kelx = kernelCreate(1, sx)) == NULL)
+        return ERROR_INT("kelx not made", procName, 1);
+    if ((kely = kernelCreate(sy, 1)) == NULL) {
+        kernelDestroy(&kelx);
+        return ERROR_INT("kely not made", procName, 1);
+    }
+    kernelSetOrigin(kelx, 0, cx);
+    kernelSetOrigin(kely, cy, 0);
+    for (j = 0; j < sx; j++)
+        kelx->data[0][j] = kel->data[imax][j];
+    for (i = 0; i < sy; i++)
+        kely->data[i][0] = kel->data[i][jmax] / pivot;
+    *pkelx = kelx;
+    *pkely = kely;
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------*
  *                            Helper function                           *
  *----------------------------------------------------------------------*/
@@ -42,6 +42,15 @@
  *      Parser verifier for binary morphological operations
  *            l_int32  morphSequenceVerify()
  *
+ *      Control of band processing for binary sequences
+ *            l_int32  l_setMorphSequenceBanding()
+ *            l_int32  l_getMorphSequenceBanding()
+ *
+ *      Band processing of binary sequences
+ *            static PIX      *pixMorphSequenceBanded()
+ *            static l_int32   morphSeqCompile()
+ *            static l_int32   morphSeqBand()
+ *
  *      Run a sequence of grayscale morphological operations
  *            PIX     *pixGrayMorphSequence()
  *
@@ -50,8 +59,56 @@
  */
 
 #include <string.h>
+#include <ctype.h>
 #include "allheaders.h"
 
+    /* Methods for the four binary sequence interpreters */
+enum {
+    L_SEQ_BRICK = 0,            /* rasterop bricks                       */
+    L_SEQ_COMP_BRICK = 1,       /* composite rasterop bricks             */
+    L_SEQ_BRICK_DWA = 2,        /* dwa bricks                            */
+    L_SEQ_COMP_BRICK_DWA = 3    /* composite dwa bricks                  */
+};
+
+    /* A parsed operation of a binary sequence */
+struct MorphSeqOp
+{
+    l_int32    type;      /* 'd', 'e', 'o', 'c', 'r' or 'x'               */
+    l_int32    w;         /* brick width; for morphological operations    */
+    l_int32    h;         /* brick height; for morphological operations   */
+    l_int32    level[4];  /* rank thresholds; for reduction               */
+    l_int32    fact;      /* replication factor; for expansion            */
+};
+typedef struct MorphSeqOp  MORPH_SEQ_OP;
+
+    /* Input to the band function.  Each call runs the sequence on
+     * one band, so that calls for different bands can run in
+     * parallel. */
+struct MorphSeqBandParams
+{
+    PIX           *pixs;    /* 1 bpp source, with border if requested     */
+    PIX           *pixd;    /* result of the sequence                     */
+    MORPH_SEQ_OP  *ops;     /* parsed operations, without the border      */
+    l_int32        nops;    /* number of parsed operations                */
+    l_int32        method;  /* L_SEQ_BRICK, ...                           */
+    l_int32        bandh;   /* band height, in source rows                */
+    l_int32        halo;    /* source rows added above and below a band   */
+    l_int32        lev;     /* net reduction, as a power of 2             */
+};
+typedef struct MorphSeqBandParams  MORPH_SEQ_BAND_PARAMS;
+
+    /* Approximate size of the source part of a band; the intermediate
+     * images of a band should fit in the L2 cache */
+static const l_int32  MORPH_SEQ_BAND_BYTES = 256 * 1024;
+
+    /* Band processing of binary sequences; on by default */
+static l_int32  var_MORPH_SEQ_BANDING = 1;
+
+static PIX *pixMorphSequenceBanded(PIX *pixs, SARRAY *sa, l_int32 method);
+static l_int32 morphSeqCompile(SARRAY *sa, MORPH_SEQ_OP **pops,
+                               l_int32 *pnops, l_int32 *pborder);
+static l_int32 morphSeqBand(void *data, l_int32 index);
+
 /*-------------------------------------------------------------------------*
  *         Run a sequence of binary rasterop morphological operations      *
  *-------------------------------------------------------------------------*/
@@ -124,6 +181,13 @@
  *              - The border is removed at the end, so if a border is
  *                added at the beginning, the result must be at the
  *                same resolution as the input!
+ *      (13) Unless intermediate results are displayed, a large image is
+ *           processed in horizontal bands that are small enough for
+ *           all the intermediate images to stay in the cache, and the
+ *           bands are run in parallel.  The result is identical to
+ *           running each operation on the full image.  This is also
+ *           done by the other three binary sequence interpreters.
+ *           See l_setMorphSequenceBanding().
  */
 PIX *
 pixMorphSequence(PIX         *pixs,
@@ -134,7 +198,7 @@ char    *rawop, *op, *fname;
 char     buf[256];
 l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout;
 l_int32  level[4];
-PIX     *pixt1, *pixt2;
+PIX     *pixt1, *pixt2, *pixd;
 PIXA    *pixa;
 SARRAY  *sa;
 
@@ -156,6 +220,16 @@ SARRAY  *sa;
         return (PIX *)ERROR_PTR("sequence not valid", procName, NULL);
     }
 
+        /* Run on bands, unless displaying; pixMorphSequenceBanded()
+         * returns null if the image makes fewer than 2 bands */
+    if (dispsep == 0 && var_MORPH_SEQ_BANDING) {
+        pixd = pixMorphSequenceBanded(pixs, sa, L_SEQ_BRICK);
+        if (pixd) {
+            sarrayDestroy(&sa);
+            return pixd;
+        }
+    }
+
         /* Parse and operate */
     pixa = NULL;
     if (pdfout) {
@@ -301,7 +375,7 @@ char    *rawop, *op, *fname;
 char     buf[256];
 l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout;
 l_int32  level[4];
-PIX     *pixt1, *pixt2;
+PIX     *pixt1, *pixt2, *pixd;
 PIXA    *pixa;
 SARRAY  *sa;
 
@@ -323,6 +397,16 @@ SARRAY  *sa;
         return (PIX *)ERROR_PTR("sequence not valid", procName, NULL);
     }
 
+        /* Run on bands, unless displaying; pixMorphSequenceBanded()
+         * returns null if the image makes fewer than 2 bands */
+    if (dispsep == 0 && var_MORPH_SEQ_BANDING) {
+        pixd = pixMorphSequenceBanded(pixs, sa, L_SEQ_COMP_BRICK);
+        if (pixd) {
+            sarrayDestroy(&sa);
+            return pixd;
+        }
+    }
+
         /* Parse and operate */
     pixa = NULL;
     if (pdfout) {
@@ -449,7 +533,7 @@ char    *rawop, *op, *fname;
 char     buf[256];
 l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout;
 l_int32  level[4];
-PIX     *pixt1, *pixt2;
+PIX     *pixt1, *pixt2, *pixd;
 PIXA    *pixa;
 SARRAY  *sa;
 
@@ -471,6 +555,16 @@ SARRAY  *sa;
         return (PIX *)ERROR_PTR("sequence not valid", procName, NULL);
     }
 
+        /* Run on bands, unless displaying; pixMorphSequenceBanded()
+         * returns null if the image makes fewer than 2 bands */
+    if (dispsep == 0 && var_MORPH_SEQ_BANDING) {
+        pixd = pixMorphSequenceBanded(pixs, sa, L_SEQ_BRICK_DWA);
+        if (pixd) {
+            sarrayDestroy(&sa);
+            return pixd;
+        }
+    }
+
         /* Parse and operate */
     pixa = NULL;
     if (pdfout) {
@@ -597,7 +691,7 @@ char    *rawop, *op, *fname;
 char     buf[256];
 l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout;
 l_int32  level[4];
-PIX     *pixt1, *pixt2;
+PIX     *pixt1, *pixt2, *pixd;
 PIXA    *pixa;
 SARRAY  *sa;
 
@@ -619,6 +713,16 @@ SARRAY  *sa;
         return (PIX *)ERROR_PTR("sequence not valid", procName, NULL);
     }
 
+        /* Run on bands, unless displaying; pixMorphSequenceBanded()
+         * returns null if the image makes fewer than 2 bands */
+    if (dispsep == 0 && var_MORPH_SEQ_BANDING) {
+        pixd = pixMorphSequenceBanded(pixs, sa, L_SEQ_COMP_BRICK_DWA);
+        if (pixd) {
+            sarrayDestroy(&sa);
+            return pixd;
+        }
+    }
+
         /* Parse and operate */
     pixa = NULL;
     if (pdfout) {
@@ -850,6 +954,428 @@ l_int32  intlogbase2[5] = {1, 2, 3, 0, 4};  /* of arg/4 */
 }
 
 
+/*-------------------------------------------------------------------------*
+ *             Control of band processing for binary sequences             *
+ *-------------------------------------------------------------------------*/
+/*!
+ *  l_setMorphSequenceBanding()
+ *
+ *      Input:  flag (1 to run binary sequences on bands; 0 to run
+ *                    each operation on the full image)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This applies to pixMorphSequence(), pixMorphCompSequence(),
+ *          pixMorphSequenceDwa() and pixMorphCompSequenceDwa().
+ *          Banding is on by default.  The results are the same either
+ *          way; this is for testing and timing.
+ *      (2) See pixMorphSequenceBanded() for details.
+ */
+l_int32
+l_setMorphSequenceBanding(l_int32  flag)
+{
+    PROCNAME("l_setMorphSequenceBanding");
+
+    if (flag != 0 && flag != 1)
+        return ERROR_INT("invalid flag", procName, 1);
+    var_MORPH_SEQ_BANDING = flag;
+    return 0;
+}
+
+
+/*!
+ *  l_getMorphSequenceBanding()
+ *
+ *      Return: 1 if binary sequences are run on bands; 0 otherwise
+ */
+l_int32
+l_getMorphSequenceBanding(void)
+{
+    return var_MORPH_SEQ_BANDING;
+}
+
+
+/*-------------------------------------------------------------------------*
+ *                Band processing of binary sequences                      *
+ *-------------------------------------------------------------------------*/
+/*!
+ *  pixMorphSequenceBanded()
+ *
+ *      Input:  pixs (1 bpp)
+ *              sa (sarray of verified operations)
+ *              method (L_SEQ_BRICK, L_SEQ_COMP_BRICK, L_SEQ_BRICK_DWA,
+ *                      L_SEQ_COMP_BRICK_DWA)
+ *      Return: pixd, or null if banding is not used or on error
+ *
+ *  Notes:
+ *      (1) This runs the whole sequence on one horizontal band of the
+ *          image at a time, instead of running each operation on the
+ *          whole image.  The intermediate images of a band are small
+ *          enough to stay in the cache, whereas for a large image each
+ *          operation otherwise reads and writes main memory.  The bands
+ *          are independent, and are run in parallel with the default
+ *          number of threads (see l_setParallelThreads()).
+ *      (2) Each band is extended above and below by a halo of source
+ *          rows that covers the reach of all the operations, composed
+ *          over the sequence and measured at full resolution.  Only
+ *          the result for the interior of the band is kept, so the
+ *          result is identical to that of the full image sequence.
+ *      (3) Band boundaries are at multiples of the largest reduction
+ *          factor in the sequence, so the rank reductions of each band
+ *          are aligned with those of the full image.
+ *      (4) The band height is set by MORPH_SEQ_BAND_BYTES.  If the
+ *          halo is more than 1/8 of that height, the band height is
+ *          increased to 8 times the halo, so that the halos add at
+ *          most 25% to the work; banding is not skipped.  This returns
+ *          null, without an error message, only if the image then
+ *          makes fewer than 2 bands: a short image, or a halo that is
+ *          large relative to the image height.  The caller then runs
+ *          the sequence on the full image.
+ *      (5) A border ('b') is added to the full image before banding,
+ *          and removed from the result, as in the full image sequence.
+ */
+static PIX *
+pixMorphSequenceBanded(PIX     *pixs,
+                       SARRAY  *sa,
+                       l_int32  method)
+{
+l_int32                 w, h, wd, hd, wpl, nops, border, ret;
+l_int32                 i, j, lev, maxlev, bandh, halo, nbands;
+l_float64               scale, reach, fhalo;
+MORPH_SEQ_OP           *ops, *sop;
+MORPH_SEQ_BAND_PARAMS   params;
+PIX                    *pix1, *pixd;
+
+    PROCNAME("pixMorphSequenceBanded");
+
+    if (pixGetDepth(pixs) != 1)
+        return NULL;
+    if (morphSeqCompile(sa, &ops, &nops, &border))
+        return (PIX *)ERROR_PTR("ops not made", procName, NULL);
+
+        /* Find the output size, the net and largest reductions, and
+         * the halo in source rows.  The reach of a brick is bounded
+         * generously, to allow for the composite decompositions,
+         * which can be a bit larger than the requested size. */
+    pixGetDimensions(pixs, &w, &h, NULL);
+    w += 2 * border;
+    h += 2 * border;
+    wd = w;
+    hd = h;
+    lev = maxlev = 0;
+    scale = 1.0;
+    fhalo = 0.0;
+    for (i = 0; i < nops; i++) {
+        sop = &ops[i];
+        switch (sop->type)
+        {
+        case 'd':
+        case 'e':
+        case 'o':
+        case 'c':
+            reach = sop->h + sop->h / 2 + 1;
+            if (sop->type == 'o' || sop->type == 'c')
+                reach *= 2;
+            fhalo += reach * scale;
+            break;
+        case 'r':
+            for (j = 0; j < 4 && sop->level[j] > 0; j++) {
+                fhalo += scale;
+                scale *= 2.0;
+                wd /= 2;
+                hd /= 2;
+                lev++;
+            }
+            break;
+        case 'x':
+            scale /= sop->fact;
+            wd *= sop->fact;
+            hd *= sop->fact;
+            for (j = sop->fact; j > 1; j /= 2)
+                lev--;
+            break;
+        default:
+            break;
+        }
+        maxlev = L_MAX(maxlev, lev);
+    }
+    if (wd == 0 || hd == 0) {  /* let the full image sequence report it */
+        LEPT_FREE(ops);
+        return NULL;
+    }
+
+        /* Choose the band height.  Both it and the halo are multiples
+         * of the largest reduction.  The band is made at least 8 times
+         * the halo, so that the extra work is at most 25%. */
+    halo = (l_int32)(fhalo + 1.0);
+    halo = ((halo + (1 << maxlev) - 1) >> maxlev) << maxlev;
+    wpl = (w + 31) / 32;
+    bandh = MORPH_SEQ_BAND_BYTES / (4 * wpl);
+    bandh = L_MAX(bandh, 8 * halo);
+    bandh = ((bandh + (1 << maxlev) - 1) >> maxlev) << maxlev;
+    nbands = (h + bandh - 1) / bandh;
+    if (nbands < 2) {
+        LEPT_FREE(ops);
+        return NULL;
+    }
+
+        /* The sequence of the full image begins with a copy; a border,
+         * if requested, is added to the full image. */
+    if (border > 0)
+        pix1 = pixAddBorder(pixs, border, 0);
+    else
+        pix1 = pixClone(pixs);
+    if ((pixd = pixCreate(wd, hd, 1)) == NULL) {
+        LEPT_FREE(ops);
+        pixDestroy(&pix1);
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    }
+    pixCopyResolution(pixd, pixs);
+    if (lev >= 0)
+        pixScaleResolution(pixd, 1.0 / (1 << lev), 1.0 / (1 << lev));
+    else
+        pixScaleResolution(pixd, (l_float32)(1 << -lev),
+                           (l_float32)(1 << -lev));
+    pixCopyInputFormat(pixd, pixs);
+
+    params.pixs = pix1;
+    params.pixd = pixd;
+    params.ops = ops;
+    params.nops = nops;
+    params.method = method;
+    params.bandh = bandh;
+    params.halo = halo;
+    params.lev = lev;
+    ret = l_parallelRun(nbands, 0, morphSeqBand, &params);
+    LEPT_FREE(ops);
+    pixDestroy(&pix1);
+    if (ret) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("band failed", procName, NULL);
+    }
+
+    if (border > 0) {
+        pix1 = pixRemoveBorder(pixd, border);
+        pixDestroy(&pixd);
+        pixd = pix1;
+    }
+    return pixd;
+}
+
+
+/*!
+ *  morphSeqCompile()
+ *
+ *      Input:  sa (sarray of verified operations)
+ *              &ops (<return> array of parsed operations, without the
+ *                    border; free with LEPT_FREE)
+ *              &nops (<return> number of parsed operations)
+ *              &border (<return> border to be added; 0 if none)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+morphSeqCompile(SARRAY         *sa,
+                MORPH_SEQ_OP  **pops,
+                l_int32        *pnops,
+                l_int32        *pborder)
+{
+char          *rawop, *op;
+l_int32        n, i, j, nred, nops;
+MORPH_SEQ_OP  *ops, *sop;
+
+    PROCNAME("morphSeqCompile");
+
+    *pops = NULL;
+    *pnops = *pborder = 0;
+    n = sarrayGetCount(sa);
+    if ((ops = (MORPH_SEQ_OP *)LEPT_CALLOC(L_MAX(n, 1), sizeof(MORPH_SEQ_OP)))
+            == NULL)
+        return ERROR_INT("ops not made", procName, 1);
+
+    nops = 0;
+    for (i = 0; i < n; i++) {
+        rawop = sarrayGetString(sa, i, L_NOCOPY);
+        op = stringRemoveChars(rawop, " \n\t");
+        sop = &ops[nops];
+        switch (op[0])
+        {
+        case 'd':
+        case 'D':
+        case 'e':
+        case 'E':
+        case 'o':
+        case 'O':
+        case 'c':
+        case 'C':
+            sop->type = tolower(op[0]);
+            sscanf(&op[1], "%d.%d", &sop->w, &sop->h);
+            nops++;
+            break;
+        case 'r':
+        case 'R':
+            sop->type = 'r';
+            nred = strlen(op) - 1;
+            for (j = 0; j < nred; j++)
+                sop->level[j] = op[j + 1] - '0';
+            nops++;
+            break;
+        case 'x':
+        case 'X':
+            sop->type = 'x';
+            sscanf(&op[1], "%d", &sop->fact);
+            nops++;
+            break;
+        case 'b':
+        case 'B':
+            sscanf(&op[1], "%d", pborder);
+            break;
+        default:
+            break;
+        }
+        LEPT_FREE(op);
+    }
+
+    *pops = ops;
+    *pnops = nops;
+    return 0;
+}
+
+
+/*!
+ *  morphSeqBand()
+ *
+ *      Input:  data (MORPH_SEQ_BAND_PARAMS)
+ *              index (of the band)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This runs the sequence on band @index of the source,
+ *          extended by the halo, and copies the rows of the result
+ *          that belong to the band into pixd.
+ */
+static l_int32
+morphSeqBand(void    *data,
+             l_int32  index)
+{
+l_int32                 i, w, h, y0, y1, ya, yb, od, od0, od1, nrows;
+l_int32                 wpl, wplr, hd, hr, method;
+l_uint32               *datad, *datar;
+MORPH_SEQ_OP           *sop;
+MORPH_SEQ_BAND_PARAMS  *params;
+BOX                    *box;
+PIX                    *pix1, *pix2;
+
+    PROCNAME("morphSeqBand");
+
+    params = (MORPH_SEQ_BAND_PARAMS *)data;
+    method = params->method;
+    pixGetDimensions(params->pixs, &w, &h, NULL);
+    y0 = index * params->bandh;
+    y1 = L_MIN(h, y0 + params->bandh);
+    ya = L_MAX(0, y0 - params->halo);
+    yb = L_MIN(h, y1 + params->halo);
+    box = boxCreate(0, ya, w, yb - ya);
+    pix1 = pixClipRectangle(params->pixs, box, NULL);
+    boxDestroy(&box);
+    if (!pix1)
+        return ERROR_INT("band not made", procName, 1);
+
+    for (i = 0; i < params->nops && pix1; i++) {
+        sop = &params->ops[i];
+        pix2 = NULL;
+        switch (sop->type)
+        {
+        case 'd':
+            if (method == L_SEQ_BRICK)
+                pix2 = pixDilateBrick(NULL, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_COMP_BRICK)
+                pix2 = pixDilateCompBrick(NULL, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_BRICK_DWA)
+                pix2 = pixDilateBrickDwa(NULL, pix1, sop->w, sop->h);
+            else
+                pix2 = pixDilateCompBrickDwa(NULL, pix1, sop->w, sop->h);
+            break;
+        case 'e':
+            if (method == L_SEQ_BRICK)
+                pix2 = pixErodeBrick(NULL, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_COMP_BRICK)
+                pix2 = pixErodeCompBrick(NULL, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_BRICK_DWA)
+                pix2 = pixErodeBrickDwa(NULL, pix1, sop->w, sop->h);
+            else
+                pix2 = pixErodeCompBrickDwa(NULL, pix1, sop->w, sop->h);
+            break;
+        case 'o':
+            if (method == L_SEQ_BRICK)
+                pixOpenBrick(pix1, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_COMP_BRICK)
+                pixOpenCompBrick(pix1, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_BRICK_DWA)
+                pixOpenBrickDwa(pix1, pix1, sop->w, sop->h);
+            else
+                pixOpenCompBrickDwa(pix1, pix1, sop->w, sop->h);
+            pix2 = pixClone(pix1);
+            break;
+        case 'c':
+            if (method == L_SEQ_BRICK)
+                pixCloseSafeBrick(pix1, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_COMP_BRICK)
+                pixCloseSafeCompBrick(pix1, pix1, sop->w, sop->h);
+            else if (method == L_SEQ_BRICK_DWA)
+                pixCloseBrickDwa(pix1, pix1, sop->w, sop->h);
+            else
+                pixCloseCompBrickDwa(pix1, pix1, sop->w, sop->h);
+            pix2 = pixClone(pix1);
+            break;
+        case 'r':
+            pix2 = pixReduceRankBinaryCascade(pix1, sop->level[0],
+                                              sop->level[1], sop->level[2],
+                                              sop->level[3]);
+            break;
+        case 'x':
+            pix2 = pixExpandReplicate(pix1, sop->fact);
+            break;
+        default:
+            break;
+        }
+        pixDestroy(&pix1);
+        pix1 = pix2;
+    }
+    if (!pix1)
+        return ERROR_INT("sequence failed on band", procName, 1);
+
+        /* Copy the rows of the band to pixd */
+    if (params->lev >= 0) {
+        od = (y0 - ya) >> params->lev;
+        od0 = y0 >> params->lev;
+        od1 = y1 >> params->lev;
+    } else {
+        od = (y0 - ya) << -params->lev;
+        od0 = y0 << -params->lev;
+        od1 = y1 << -params->lev;
+    }
+    hd = pixGetHeight(params->pixd);
+    if (y1 == h)  /* last band */
+        od1 = hd;
+    od1 = L_MIN(od1, hd);
+    hr = pixGetHeight(pix1);
+    nrows = L_MIN(od1 - od0, hr - od);
+    wpl = pixGetWpl(params->pixd);
+    wplr = pixGetWpl(pix1);
+    if (nrows < od1 - od0 || wplr != wpl) {
+        pixDestroy(&pix1);
+        return ERROR_INT("band result has wrong size", procName, 1);
+    }
+    if (nrows > 0) {
+        datad = pixGetData(params->pixd) + od0 * wpl;
+        datar = pixGetData(pix1) + od * wplr;
+        memcpy(datad, datar, 4 * wpl * nrows);
+    }
+    pixDestroy(&pix1);
+    return 0;
+}
+
+
 /*-----------------------------------------------------------------*
  *       Run a sequence of grayscale morphological operations      *
  *-----------------------------------------------------------------*/
@@ -356,8 +356,7 @@ NUMA  *na;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the numa. */
-    numaChangeRefcount(na, -1);
-    if (numaGetRefcount(na) <= 0) {
+    if (--na->refcount <= 0) {
         if (na->array)
             LEPT_FREE(na->array);
         LEPT_FREE(na);
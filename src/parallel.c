@@ -0,0 +1,492 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  parallel.c
+ *
+ *      Number of threads for parallel operations
+ *          l_int32         l_setParallelThreads()
+ *          l_int32         l_getParallelThreads()
+ *
+ *      Running a set of independent tasks on worker threads
+ *          l_int32         l_parallelRun()
+ *          static void    *parallelWorker()
+ *          static l_int32  parallelTakeTask()
+ *
+ *      Mutex
+ *          L_MUTEX        *l_mutexCreate()
+ *          void            l_mutexDestroy()
+ *          void            l_mutexLock()
+ *          void            l_mutexUnlock()
+ *          L_MUTEX        *l_mutexGetStatic()
+ *
+ *  Some operations, such as pixTilingProcess(), split their work into
+ *  a number of independent tasks.  l_parallelRun() executes these
+ *  tasks on a set of worker threads.  The calling thread is one of
+ *  the workers, so with one thread everything happens in the caller,
+ *  exactly as in the serial implementation.
+ *
+ *  Tasks are not assigned to the workers in advance.  Each worker
+ *  takes the next unclaimed task index from a shared counter when
+ *  it becomes idle, so a worker that gets cheap tasks (e.g., blank
+ *  tiles) automatically takes over work from the others.  For
+ *  independent tasks of unknown cost, this has the same load
+ *  balancing effect as work stealing, with a single lock acquisition
+ *  per task as the only overhead.
+ *
+ *  The number of threads used by default is set globally with
+ *  l_setParallelThreads().  It is 1 unless changed, so nothing in
+ *  the library uses more than one thread unless the application asks
+ *  for it.  If a task itself calls l_parallelRun(), the inner call
+ *  runs in the calling worker thread, to avoid oversubscription.
+ *
+ *  Threads are only available when the library is built with posix
+ *  threads (HAVE_LIBPTHREAD; see environ.h).  Otherwise all tasks
+ *  are run in the calling thread, and the mutex functions are no-ops.
+ *
+ *  Functions that are called from a task must be thread-safe for
+ *  the data they are given.  Most leptonica functions that make a
+ *  new pix from a read-only input qualify, provided that the input
+ *  is not cloned or destroyed by the task, or that the library is
+ *  built with atomic ref counts (USE_ATOMIC_REFCOUNT; see environ.h).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
+#include "allheaders.h"
+
+#if HAVE_LIBPTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif  /* HAVE_LIBPTHREAD */
+
+    /* Default number of threads used in parallel operations */
+static l_int32  var_PARALLEL_THREADS = 1;
+
+    /* Maximum number of threads that will be started for one operation */
+static const l_int32  MaxParallelThreads = 256;
+
+struct L_Mutex
+{
+#if HAVE_LIBPTHREAD
+    pthread_mutex_t    mutex;
+#else
+    l_int32            dummy;
+#endif  /* HAVE_LIBPTHREAD */
+};
+
+    /* Shared state for one call to l_parallelRun() */
+struct L_ParallelJob
+{
+    l_int32            ntasks;   /* number of tasks                       */
+    l_int32            next;     /* index of the next task to be taken    */
+    l_int32            nfail;    /* number of tasks that returned error   */
+    l_int32          (*func)(void *, l_int32);  /* task function          */
+    void              *data;     /* input to every task                   */
+#if HAVE_LIBPTHREAD
+    pthread_mutex_t    mutex;    /* protects next and nfail               */
+#endif  /* HAVE_LIBPTHREAD */
+};
+typedef struct L_ParallelJob  L_PARALLEL_JOB;
+
+static void *parallelWorker(void *arg);
+static l_int32 parallelTakeTask(L_PARALLEL_JOB *job, l_int32 lastret);
+
+#if HAVE_LIBPTHREAD
+    /* Marks threads that are running as workers */
+static pthread_once_t  worker_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   worker_key;
+
+static void
+makeWorkerKey(void)
+{
+    pthread_key_create(&worker_key, NULL);
+}
+
+    /* Protects the creation of mutexes by l_mutexGetStatic() */
+static pthread_mutex_t  static_mutex_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif  /* HAVE_LIBPTHREAD */
+
+
+/*--------------------------------------------------------------------*
+ *                Number of threads for parallel operations           *
+ *--------------------------------------------------------------------*/
+/*!
+ *  l_setParallelThreads()
+ *
+ *      Input:  nthreads (default number of threads for parallel
+ *                        operations; use 0 for one per processor)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This sets the number of threads used by operations that
+ *          are requested to run with the default number of threads.
+ *          The initial value is 1, which runs everything serially
+ *          in the calling thread.
+ *      (2) Call this before starting any parallel operation; it is
+ *          not safe to change while one is running.
+ *      (3) Without thread support, this has no effect.
+ */
+l_int32
+l_setParallelThreads(l_int32  nthreads)
+{
+    PROCNAME("l_setParallelThreads");
+
+    if (nthreads < 0)
+        return ERROR_INT("nthreads must be >= 0", procName, 1);
+
+#if HAVE_LIBPTHREAD && defined(_SC_NPROCESSORS_ONLN)
+    if (nthreads == 0)
+        nthreads = (l_int32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif  /* HAVE_LIBPTHREAD && _SC_NPROCESSORS_ONLN */
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > MaxParallelThreads) {
+        L_WARNING("nthreads reduced to %d\n", procName, MaxParallelThreads);
+        nthreads = MaxParallelThreads;
+    }
+    var_PARALLEL_THREADS = nthreads;
+    return 0;
+}
+
+
+/*!
+ *  l_getParallelThreads()
+ *
+ *      Return: default number of threads for parallel operations
+ */
+l_int32
+l_getParallelThreads(void)
+{
+#if HAVE_LIBPTHREAD
+    return var_PARALLEL_THREADS;
+#else
+    return 1;
+#endif  /* HAVE_LIBPTHREAD */
+}
+
+
+/*--------------------------------------------------------------------*
+ *             Running a set of independent tasks on threads          *
+ *--------------------------------------------------------------------*/
+/*!
+ *  l_parallelRun()
+ *
+ *      Input:  ntasks (number of tasks)
+ *              nthreads (max number of threads; use 0 for the default
+ *                        set by l_setParallelThreads())
+ *              func (task function: called as func(data, index) for
+ *                    each index in [0 ... ntasks - 1]; returns 0 if OK,
+ *                    1 on error)
+ *              data (input passed to every task; can be null)
+ *      Return: 0 if OK, 1 on error or if any task returned an error
+ *
+ *  Notes:
+ *      (1) The tasks are run in arbitrary order, and several of them
+ *          can run at the same time.  func must therefore write only
+ *          to memory that belongs to its own task, or protect shared
+ *          output with an L_MUTEX.
+ *      (2) The calling thread participates in the work.  At most
+ *          (nthreads - 1) new threads are created, and never more
+ *          than there are tasks.  All threads have finished when
+ *          this returns.
+ *      (3) If threads cannot be created, the remaining workers
+ *          (at least the calling thread) do all the tasks.
+ *      (4) When called from inside a task, this runs serially.
+ */
+l_int32
+l_parallelRun(l_int32    ntasks,
+              l_int32    nthreads,
+              l_int32  (*func)(void *, l_int32),
+              void      *data)
+{
+l_int32          i;
+L_PARALLEL_JOB   job;
+#if HAVE_LIBPTHREAD
+l_int32          nstarted;
+pthread_t       *threads;
+#endif  /* HAVE_LIBPTHREAD */
+
+    PROCNAME("l_parallelRun");
+
+    if (!func)
+        return ERROR_INT("func not defined", procName, 1);
+    if (ntasks <= 0)
+        return 0;
+
+    if (nthreads <= 0)
+        nthreads = l_getParallelThreads();
+    nthreads = L_MIN(nthreads, ntasks);
+    nthreads = L_MIN(nthreads, MaxParallelThreads);
+
+    job.ntasks = ntasks;
+    job.next = 0;
+    job.nfail = 0;
+    job.func = func;
+    job.data = data;
+
+#if HAVE_LIBPTHREAD
+    pthread_once(&worker_key_once, makeWorkerKey);
+    if (pthread_getspecific(worker_key) != NULL)  /* nested call */
+        nthreads = 1;
+#else
+    nthreads = 1;
+#endif  /* HAVE_LIBPTHREAD */
+
+        /* Serial case: no locking required */
+    if (nthreads <= 1) {
+        for (i = 0; i < ntasks; i++) {
+            if ((*func)(data, i) != 0)
+                job.nfail++;
+        }
+        if (job.nfail > 0)
+            return ERROR_INT("task failed", procName, 1);
+        return 0;
+    }
+
+#if HAVE_LIBPTHREAD
+    pthread_mutex_init(&job.mutex, NULL);
+    threads = (pthread_t *)LEPT_CALLOC(nthreads - 1, sizeof(pthread_t));
+    nstarted = 0;
+    if (threads) {
+        for (i = 0; i < nthreads - 1; i++) {
+            if (pthread_create(&threads[i], NULL, parallelWorker, &job) != 0)
+                break;
+            nstarted++;
+        }
+    }
+    if (nstarted < nthreads - 1)
+        L_WARNING("only %d of %d threads started\n", procName,
+                  nstarted + 1, nthreads);
+
+    parallelWorker(&job);  /* the calling thread is also a worker */
+    for (i = 0; i < nstarted; i++)
+        pthread_join(threads[i], NULL);
+    LEPT_FREE(threads);
+    pthread_mutex_destroy(&job.mutex);
+#endif  /* HAVE_LIBPTHREAD */
+
+    if (job.nfail > 0)
+        return ERROR_INT("task failed", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  parallelWorker()
+ *
+ *      Input:  arg (the job)
+ *      Return: null
+ *
+ *  Notes:
+ *      (1) Runs tasks until none are left.
+ */
+static void *
+parallelWorker(void  *arg)
+{
+l_int32          index, ret;
+L_PARALLEL_JOB  *job;
+
+    job = (L_PARALLEL_JOB *)arg;
+#if HAVE_LIBPTHREAD
+    pthread_setspecific(worker_key, job);
+#endif  /* HAVE_LIBPTHREAD */
+
+    ret = 0;
+    while ((index = parallelTakeTask(job, ret)) >= 0)
+        ret = (*job->func)(job->data, index);
+
+#if HAVE_LIBPTHREAD
+    pthread_setspecific(worker_key, NULL);
+#endif  /* HAVE_LIBPTHREAD */
+    return NULL;
+}
+
+
+/*!
+ *  parallelTakeTask()
+ *
+ *      Input:  job
+ *              lastret (return value of the task just finished by
+ *                       this worker; 0 if none)
+ *      Return: index of the next task, or -1 if there are none left
+ *
+ *  Notes:
+ *      (1) Recording the result of the previous task and claiming
+ *          the next one share a single lock acquisition.
+ */
+static l_int32
+parallelTakeTask(L_PARALLEL_JOB  *job,
+                 l_int32          lastret)
+{
+l_int32  index;
+
+#if HAVE_LIBPTHREAD
+    pthread_mutex_lock(&job->mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    if (lastret != 0)
+        job->nfail++;
+    if (job->next < job->ntasks)
+        index = job->next++;
+    else
+        index = -1;
+#if HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&job->mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    return index;
+}
+
+
+/*--------------------------------------------------------------------*
+ *                                Mutex                               *
+ *--------------------------------------------------------------------*/
+/*!
+ *  l_mutexCreate()
+ *
+ *      Return: mutex, or null on error
+ */
+L_MUTEX *
+l_mutexCreate(void)
+{
+L_MUTEX  *mutex;
+
+    PROCNAME("l_mutexCreate");
+
+    if ((mutex = (L_MUTEX *)LEPT_CALLOC(1, sizeof(L_MUTEX))) == NULL)
+        return (L_MUTEX *)ERROR_PTR("mutex not made", procName, NULL);
+#if HAVE_LIBPTHREAD
+    if (pthread_mutex_init(&mutex->mutex, NULL) != 0) {
+        LEPT_FREE(mutex);
+        return (L_MUTEX *)ERROR_PTR("mutex not initialized", procName, NULL);
+    }
+#endif  /* HAVE_LIBPTHREAD */
+    return mutex;
+}
+
+
+/*!
+ *  l_mutexDestroy()
+ *
+ *      Input:  &mutex (<will be set to null before returning>)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The mutex must not be locked.
+ */
+void
+l_mutexDestroy(L_MUTEX  **pmutex)
+{
+L_MUTEX  *mutex;
+
+    PROCNAME("l_mutexDestroy");
+
+    if (pmutex == NULL) {
+        L_WARNING("ptr address is null!\n", procName);
+        return;
+    }
+    if ((mutex = *pmutex) == NULL)
+        return;
+
+#if HAVE_LIBPTHREAD
+    pthread_mutex_destroy(&mutex->mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    LEPT_FREE(mutex);
+    *pmutex = NULL;
+    return;
+}
+
+
+/*!
+ *  l_mutexLock()
+ *
+ *      Input:  mutex
+ *      Return: void
+ */
+void
+l_mutexLock(L_MUTEX  *mutex)
+{
+    if (!mutex) return;
+#if HAVE_LIBPTHREAD
+    pthread_mutex_lock(&mutex->mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    return;
+}
+
+
+/*!
+ *  l_mutexUnlock()
+ *
+ *      Input:  mutex
+ *      Return: void
+ */
+void
+l_mutexUnlock(L_MUTEX  *mutex)
+{
+    if (!mutex) return;
+#if HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&mutex->mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    return;
+}
+
+
+/*!
+ *  l_mutexGetStatic()
+ *
+ *      Input:  &mutex (<in/out> static mutex; null before the first call)
+ *      Return: mutex, or null on error
+ *
+ *  Notes:
+ *      (1) This is for a mutex that protects static data.  The mutex
+ *          is made on the first call, which may come from any thread,
+ *          and is kept until the program exits.  Use
+ *              l_mutexLock(l_mutexGetStatic(&mutex));
+ *              ...
+ *              l_mutexUnlock(mutex);
+ */
+L_MUTEX *
+l_mutexGetStatic(L_MUTEX  **pmutex)
+{
+L_MUTEX  *mutex;
+
+    PROCNAME("l_mutexGetStatic");
+
+    if (!pmutex)
+        return (L_MUTEX *)ERROR_PTR("&mutex not defined", procName, NULL);
+
+#if HAVE_LIBPTHREAD
+    pthread_mutex_lock(&static_mutex_lock);
+#endif  /* HAVE_LIBPTHREAD */
+    if (*pmutex == NULL)
+        *pmutex = l_mutexCreate();
+    mutex = *pmutex;
+#if HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&static_mutex_lock);
+#endif  /* HAVE_LIBPTHREAD */
+    return mutex;
+}
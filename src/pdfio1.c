@@ -82,6 +82,18 @@
  *     pdf 'strings' in memory.  The output can be either a file or
  *     an array of bytes in memory.
  *
+ *     In sets 1, 2 and 3, each page is encoded independently, and
+ *     the pages are then concatenated in order.  The encoding, which
+ *     dominates the time, is done on the worker threads set up by
+ *     l_setParallelThreads() (see parallel.c).  By default there is
+ *     only one thread, and the pages are encoded one at a time.
+ *
+ *     When the output of sets 1, 2, 3 and 7 is a file, the pages are
+ *     written as they are made (or read), using the streaming pdf
+ *     writer in pdfio2.c, so that the memory used does not grow
+ *     with the number of pages.  The output to memory is assembled
+ *     after all the pages are made.
+ *
  *     The images in the pdf file can be rendered using a pdf viewer,
  *     such as gv, evince, xpdf or acroread.
  *
@@ -93,16 +105,21 @@
  *          l_int32             saConvertFilesToPdf()
  *          l_int32             saConvertFilesToPdfData()
  *          l_int32             selectDefaultPdfEncoding()
+ *          static l_int32      pdfFilePage()
  *
  *     2. Convert specified image files to pdf without scaling
  *          l_int32             convertUnscaledFilesToPdf()
  *          l_int32             saConvertUnscaledFilesToPdf()
  *          l_int32             saConvertUnscaledFilesToPdfData()
  *          l_int32             convertUnscaledToPdfData()
+ *          static l_int32      pdfUnscaledFilePage()
  *
  *     3. Convert multiple images to pdf (one image per page)
  *          l_int32             pixaConvertToPdf()
  *          l_int32             pixaConvertToPdfData()
+ *          static l_int32      pdfPixaPage()
+ *          static l_int32      pdfConcatenatePages()
+ *          static l_int32      pdfWritePages()
  *
  *     4. Single page, multi-image converters
  *          l_int32             convertToPdf()
@@ -196,6 +213,38 @@
     /* Typical scan resolution in ppi (pixels/inch) */
 static const l_int32  DEFAULT_INPUT_RES = 300;
 
+    /* Input to the page functions that generate the pdf data for one
+     * page of a multipage pdf.  Each call makes one page, so that pages
+     * can be encoded in parallel.  The results are stored by page
+     * index, and concatenated in order after all pages are made.
+     * When writing to a file, the pages are made in batches starting
+     * at image @first, and each batch is written before the next. */
+struct PdfPageParams
+{
+    SARRAY       *sa;           /* image filenames; or null               */
+    PIXA         *pixa;         /* images; or null                        */
+    l_int32       res;          /* input resolution of all images         */
+    l_float32     scalefactor;  /* scaling applied to each image          */
+    l_int32       type;         /* encoding type, or 0 for default        */
+    l_int32       quality;      /* for jpeg                               */
+    const char   *title;        /* pdf title; can be null                 */
+    l_int32       first;        /* index of the image for pages[0]        */
+    L_BYTEA     **pages;        /* output pdf data for each page          */
+};
+typedef struct PdfPageParams  PDF_PAGE_PARAMS;
+
+static l_int32 pdfFilePage(void *data, l_int32 i);
+static l_int32 pdfUnscaledFilePage(void *data, l_int32 i);
+static l_int32 pdfPixaPage(void *data, l_int32 i);
+static l_int32 pdfConcatenatePages(L_BYTEA **pages, l_int32 n,
+                                   l_uint8 **pdata, size_t *pnbytes);
+static l_int32 pdfWritePages(PDF_PAGE_PARAMS *params, l_int32 n,
+                             l_int32 (*pagefunc)(void *, l_int32),
+                             const char *fileout);
+
+    /* Pages encoded for each thread before a batch is written */
+static const l_int32  PdfPagesPerThread = 4;
+
 
 /*---------------------------------------------------------------------*
  *    Convert specified image files to pdf (one image file per page)   *
@@ -228,6 +277,8 @@ static const l_int32  DEFAULT_INPUT_RES = 300;
  *          all images to be compressed with that type.  Use 0 to have
  *          the type determined for each image based on depth and whether
  *          or not it has a colormap.
+ *      (5) The images are read and encoded in parallel if more than
+ *          one thread has been set with l_setParallelThreads().
  */
 l_int32
 convertFilesToPdf(const char  *dirname,
@@ -274,6 +325,9 @@ SARRAY  *sa;
  *
  *  Notes:
  *      (1) See convertFilesToPdf().
+ *      (2) The pages are written to @fileout as they are made, a few
+ *          at a time, so the memory used does not depend on the number
+ *          of pages.  See pdfWritePages().
  */
 l_int32
 saConvertFilesToPdf(SARRAY      *sa,
@@ -284,27 +338,32 @@ saConvertFilesToPdf(SARRAY      *sa,
                     const char  *title,
                     const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+l_int32           n;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("saConvertFilesToPdf");
 
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
-
-    ret = saConvertFilesToPdfData(sa, res, scalefactor, type, quality,
-                                  title, &data, &nbytes);
-    if (ret) {
-        if (data) LEPT_FREE(data);
-        return ERROR_INT("pdf data not made", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
+    if (scalefactor <= 0.0) scalefactor = 1.0;
+    if (type < 0 || type > L_FLATE_ENCODE) {
+        L_WARNING("invalid compression type; using per-page default\n",
+                  procName);
+        type = 0;
     }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    if ((n = sarrayGetCount(sa)) == 0)
+        return ERROR_INT("no filenames in sa", procName, 1);
+
+    memset(&params, 0, sizeof(PDF_PAGE_PARAMS));
+    params.sa = sa;
+    params.res = res;
+    params.scalefactor = scalefactor;
+    params.type = type;
+    params.quality = quality;
+    params.title = title;
+    return pdfWritePages(&params, n, pdfFilePage, fileout);
 }
 
 
@@ -336,14 +395,8 @@ saConvertFilesToPdfData(SARRAY      *sa,
                         l_uint8    **pdata,
                         size_t      *pnbytes)
 {
-char        *fname;
-const char  *pdftitle;
-l_uint8     *imdata;
-l_int32      i, n, ret, pagetype, npages, scaledres;
-size_t       imbytes;
-L_BYTEA     *ba;
-PIX         *pixs, *pix;
-L_PTRA      *pa_data;
+l_int32           n, ret;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("saConvertFilesToPdfData");
 
@@ -364,59 +417,25 @@ L_PTRA      *pa_data;
 
         /* Generate all the encoded pdf strings */
     n = sarrayGetCount(sa);
-    pa_data = ptraCreate(n);
-    pdftitle = NULL;
-    for (i = 0; i < n; i++) {
-        if (i && (i % 10 == 0)) fprintf(stderr, ".. %d ", i);
-        fname = sarrayGetString(sa, i, L_NOCOPY);
-        if ((pixs = pixRead(fname)) == NULL) {
-            L_ERROR("image not readable from file %s\n", procName, fname);
-            continue;
-        }
-        if (!pdftitle)
-            pdftitle = (title) ? title : fname;
-        if (scalefactor != 1.0)
-            pix = pixScale(pixs, scalefactor, scalefactor);
-        else
-            pix = pixClone(pixs);
-        scaledres = (l_int32)(res * scalefactor);
-        if (type != 0) {
-            pagetype = type;
-        } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
-            L_ERROR("encoding type selection failed for file %s\n",
-                    procName, fname);
-            continue;
-        }
-        ret = pixConvertToPdfData(pix, pagetype, quality, &imdata, &imbytes,
-                                  0, 0, scaledres, pdftitle, NULL, 0);
-        pixDestroy(&pix);
-        pixDestroy(&pixs);
-        if (ret) {
-            L_ERROR("pdf encoding failed for %s\n", procName, fname);
-            continue;
-        }
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        if (imdata) LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
-    }
-    ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
-    }
+    if (n == 0)
+        return ERROR_INT("no filenames in sa", procName, 1);
+    params.sa = sa;
+    params.pixa = NULL;
+    params.res = res;
+    params.scalefactor = scalefactor;
+    params.type = type;
+    params.quality = quality;
+    params.title = title;
+    params.first = 0;
+    if ((params.pages = (L_BYTEA **)LEPT_CALLOC(n, sizeof(L_BYTEA *)))
+        == NULL)
+        return ERROR_INT("pages not made", procName, 1);
+    l_parallelRun(n, 0, pdfFilePage, &params);
 
         /* Concatenate them */
     fprintf(stderr, "\nconcatenating ... ");
-    ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
+    ret = pdfConcatenatePages(params.pages, n, pdata, pnbytes);
     fprintf(stderr, "done\n");
-
-    ptraGetActualCount(pa_data, &npages);  /* recalculate in case it changes */
-    for (i = 0; i < npages; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
-    }
-    ptraDestroy(&pa_data, FALSE, FALSE);
     return ret;
 }
 
@@ -475,6 +494,70 @@ PIXCMAP  *cmap;
 }
 
 
+/*!
+ *  pdfFilePage()
+ *
+ *      Input:  data (PDF_PAGE_PARAMS)
+ *              i (index of the page; the image file is first + i)
+ *      Return: 0 always; a page that can't be made is left null
+ *
+ *  Notes:
+ *      (1) This reads the image file, scales and encodes it, and
+ *          saves the pdf data for the page in params->pages[i].
+ *      (2) If the title is null, the filename is used.  Only the title
+ *          on the first page is kept when the pages are concatenated,
+ *          so the result is the filename of the first readable image.
+ */
+static l_int32
+pdfFilePage(void    *data,
+            l_int32  i)
+{
+char             *fname;
+const char       *pdftitle;
+l_uint8          *imdata;
+l_int32           index, ret, pagetype, scaledres;
+size_t            imbytes;
+PIX              *pixs, *pix;
+PDF_PAGE_PARAMS  *params;
+
+    PROCNAME("pdfFilePage");
+
+    params = (PDF_PAGE_PARAMS *)data;
+    index = params->first + i;
+    if (index && (index % 10 == 0)) fprintf(stderr, ".. %d ", index);
+    fname = sarrayGetString(params->sa, index, L_NOCOPY);
+    if ((pixs = pixRead(fname)) == NULL) {
+        L_ERROR("image not readable from file %s\n", procName, fname);
+        return 0;
+    }
+    pdftitle = (params->title) ? params->title : fname;
+    if (params->scalefactor != 1.0)
+        pix = pixScale(pixs, params->scalefactor, params->scalefactor);
+    else
+        pix = pixClone(pixs);
+    pixDestroy(&pixs);
+    scaledres = (l_int32)(params->res * params->scalefactor);
+    if (params->type != 0) {
+        pagetype = params->type;
+    } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
+        L_ERROR("encoding type selection failed for file %s\n",
+                procName, fname);
+        pixDestroy(&pix);
+        return 0;
+    }
+    ret = pixConvertToPdfData(pix, pagetype, params->quality, &imdata,
+                              &imbytes, 0, 0, scaledres, pdftitle, NULL, 0);
+    pixDestroy(&pix);
+    if (ret) {
+        L_ERROR("pdf encoding failed for %s\n", procName, fname);
+        return 0;
+    }
+    params->pages[i] = l_byteaInitFromMem(imdata, imbytes);
+    LEPT_FREE(imdata);
+    return 0;
+}
+
+
 /*---------------------------------------------------------------------*
  *          Convert specified image files to pdf without scaling       *
  *---------------------------------------------------------------------*/
@@ -534,32 +617,30 @@ SARRAY  *sa;
  *
  *  Notes:
  *      (1) See convertUnscaledFilesToPdf().
+ *      (2) The pages are written to @fileout as they are made; see
+ *          pdfWritePages().
  */
 l_int32
 saConvertUnscaledFilesToPdf(SARRAY      *sa,
                             const char  *title,
                             const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+l_int32           n;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("saConvertUnscaledFilesToPdf");
 
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
+    if ((n = sarrayGetCount(sa)) == 0)
+        return ERROR_INT("no filenames in sa", procName, 1);
 
-    ret = saConvertUnscaledFilesToPdfData(sa, title, &data, &nbytes);
-    if (ret) {
-        if (data) LEPT_FREE(data);
-        return ERROR_INT("pdf data not made", procName, 1);
-    }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    memset(&params, 0, sizeof(PDF_PAGE_PARAMS));
+    params.sa = sa;
+    params.title = title;
+    return pdfWritePages(&params, n, pdfUnscaledFilePage, fileout);
 }
 
 
@@ -579,12 +660,8 @@ saConvertUnscaledFilesToPdfData(SARRAY      *sa,
                                 l_uint8    **pdata,
                                 size_t      *pnbytes)
 {
-char         *fname;
-l_uint8      *imdata;
-l_int32       i, n, ret, npages;
-size_t        imbytes;
-L_BYTEA      *ba;
-L_PTRA       *pa_data;
+l_int32           n, ret;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("saConvertUnscaledFilesToPdfData");
 
@@ -599,39 +676,20 @@ L_PTRA       *pa_data;
 
         /* Generate all the encoded pdf strings */
     n = sarrayGetCount(sa);
-    pa_data = ptraCreate(n);
-    for (i = 0; i < n; i++) {
-        if (i && (i % 10 == 0)) fprintf(stderr, ".. %d ", i);
-        fname = sarrayGetString(sa, i, L_NOCOPY);
-
-            /* Generate the pdf data */
-        if (convertUnscaledToPdfData(fname, title, &imdata, &imbytes))
-            continue;
-
-            /* ... and add it to the array of single page data */
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        if (imdata) LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
-    }
-    ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
-    }
+    if (n == 0)
+        return ERROR_INT("no filenames in sa", procName, 1);
+    memset(&params, 0, sizeof(PDF_PAGE_PARAMS));
+    params.sa = sa;
+    params.title = title;
+    if ((params.pages = (L_BYTEA **)LEPT_CALLOC(n, sizeof(L_BYTEA *)))
+        == NULL)
+        return ERROR_INT("pages not made", procName, 1);
+    l_parallelRun(n, 0, pdfUnscaledFilePage, &params);
 
         /* Concatenate to generate a multipage pdf */
     fprintf(stderr, "\nconcatenating ... ");
-    ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
+    ret = pdfConcatenatePages(params.pages, n, pdata, pnbytes);
     fprintf(stderr, "done\n");
-
-        /* Clean up */
-    ptraGetActualCount(pa_data, &npages);  /* maybe failed to read some files */
-    for (i = 0; i < npages; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
-    }
-    ptraDestroy(&pa_data, FALSE, FALSE);
     return ret;
 }
 
@@ -701,6 +759,39 @@ L_COMP_DATA  *cid;
 }
 
 
+/*!
+ *  pdfUnscaledFilePage()
+ *
+ *      Input:  data (PDF_PAGE_PARAMS)
+ *              i (index of the page; the image file is first + i)
+ *      Return: 0 always; a page that can't be made is left null
+ *
+ *  Notes:
+ *      (1) This saves the pdf data for the image file, made by
+ *          convertUnscaledToPdfData(), in params->pages[i].
+ */
+static l_int32
+pdfUnscaledFilePage(void    *data,
+                    l_int32  i)
+{
+char             *fname;
+l_uint8          *imdata;
+l_int32           index;
+size_t            imbytes;
+PDF_PAGE_PARAMS  *params;
+
+    params = (PDF_PAGE_PARAMS *)data;
+    index = params->first + i;
+    if (index && (index % 10 == 0)) fprintf(stderr, ".. %d ", index);
+    fname = sarrayGetString(params->sa, index, L_NOCOPY);
+    if (convertUnscaledToPdfData(fname, params->title, &imdata, &imbytes))
+        return 0;
+    params->pages[i] = l_byteaInitFromMem(imdata, imbytes);
+    LEPT_FREE(imdata);
+    return 0;
+}
+
+
 /*---------------------------------------------------------------------*
  *          Convert multiple images to pdf (one image per page)        *
  *---------------------------------------------------------------------*/
@@ -727,6 +818,12 @@ L_COMP_DATA  *cid;
  *          all images to be compressed with that type.  Use 0 to have
  *          the type determined for each image based on depth and whether
  *          or not it has a colormap.
+ *      (4) The images are encoded in parallel if more than one thread
+ *          has been set with l_setParallelThreads().  Each thread then
+ *          encodes a copy of its pix, because the encoders clone the
+ *          pix; so the same pix may appear more than once in @pixa.
+ *      (5) The pages are written to @fileout as they are made; see
+ *          pdfWritePages().
  */
 l_int32
 pixaConvertToPdf(PIXA        *pixa,
@@ -737,27 +834,32 @@ pixaConvertToPdf(PIXA        *pixa,
                  const char  *title,
                  const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+l_int32           n;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("pixaConvertToPdf");
 
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
-
-    ret = pixaConvertToPdfData(pixa, res, scalefactor, type, quality,
-                               title, &data, &nbytes);
-    if (ret) {
-        LEPT_FREE(data);
-        return ERROR_INT("conversion to pdf failed", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
+    if (scalefactor <= 0.0) scalefactor = 1.0;
+    if (type < 0 || type > L_FLATE_ENCODE) {
+        L_WARNING("invalid compression type; using per-page default\n",
+                  procName);
+        type = 0;
     }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    if ((n = pixaGetCount(pixa)) == 0)
+        return ERROR_INT("no pix in pixa", procName, 1);
+
+    memset(&params, 0, sizeof(PDF_PAGE_PARAMS));
+    params.pixa = pixa;
+    params.res = res;
+    params.scalefactor = scalefactor;
+    params.type = type;
+    params.quality = quality;
+    params.title = title;
+    return pdfWritePages(&params, n, pdfPixaPage, fileout);
 }
 
 
@@ -788,12 +890,8 @@ pixaConvertToPdfData(PIXA        *pixa,
                      l_uint8    **pdata,
                      size_t      *pnbytes)
 {
-l_uint8  *imdata;
-l_int32   i, n, ret, scaledres, pagetype;
-size_t    imbytes;
-L_BYTEA  *ba;
-PIX      *pixs, *pix;
-L_PTRA   *pa_data;
+l_int32           n;
+PDF_PAGE_PARAMS   params;
 
     PROCNAME("pixaConvertToPdfData");
 
@@ -814,49 +912,142 @@ L_PTRA   *pa_data;
 
         /* Generate all the encoded pdf strings */
     n = pixaGetCount(pixa);
+    if (n == 0)
+        return ERROR_INT("no pix in pixa", procName, 1);
+    params.sa = NULL;
+    params.pixa = pixa;
+    params.res = res;
+    params.scalefactor = scalefactor;
+    params.type = type;
+    params.quality = quality;
+    params.title = title;
+    params.first = 0;
+    if ((params.pages = (L_BYTEA **)LEPT_CALLOC(n, sizeof(L_BYTEA *)))
+        == NULL)
+        return ERROR_INT("pages not made", procName, 1);
+    l_parallelRun(n, 0, pdfPixaPage, &params);
+
+        /* Concatenate them */
+    return pdfConcatenatePages(params.pages, n, pdata, pnbytes);
+}
+
+
+/*!
+ *  pdfPixaPage()
+ *
+ *      Input:  data (PDF_PAGE_PARAMS)
+ *              i (index of the page; the pix is first + i in the pixa)
+ *      Return: 0 always; a page that can't be made is left null
+ *
+ *  Notes:
+ *      (1) This scales and encodes the pix, and saves the pdf data
+ *          for the page in params->pages[i].
+ *      (2) When more than one thread is set, a copy of the pix is
+ *          encoded.  The encoders clone the pix, and the refcount of a
+ *          pix that is in the pixa more than once (or that has clones
+ *          in it) must not be changed by several threads at once.
+ *          The pixa itself is only read.
+ */
+static l_int32
+pdfPixaPage(void    *data,
+            l_int32  i)
+{
+l_uint8          *imdata;
+l_int32           index, ret, scaledres, pagetype;
+size_t            imbytes;
+PIX              *pixs, *pix;
+PDF_PAGE_PARAMS  *params;
+
+    PROCNAME("pdfPixaPage");
+
+    params = (PDF_PAGE_PARAMS *)data;
+    index = params->first + i;
+    if ((pixs = pixaGetPixArray(params->pixa)[index]) == NULL) {
+        L_ERROR("pix[%d] not retrieved\n", procName, index);
+        return 0;
+    }
+    if (l_getParallelThreads() > 1)
+        pixs = pixCopy(NULL, pixs);
+    else
+        pixs = pixClone(pixs);
+    if (!pixs) {
+        L_ERROR("pix[%d] not copied\n", procName, index);
+        return 0;
+    }
+    if (params->scalefactor != 1.0)
+        pix = pixScale(pixs, params->scalefactor, params->scalefactor);
+    else
+        pix = pixClone(pixs);
+    scaledres = (l_int32)(params->res * params->scalefactor);
+    ret = 0;
+    if (params->type != 0) {
+        pagetype = params->type;
+    } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
+        L_ERROR("encoding type selection failed for pix[%d]\n",
+                    procName, index);
+        ret = 1;
+    }
+    if (!ret) {
+        ret = pixConvertToPdfData(pix, pagetype, params->quality, &imdata,
+                                  &imbytes, 0, 0, scaledres, params->title,
+                                  NULL, 0);
+        if (ret)
+            L_ERROR("pdf encoding failed for pix[%d]\n", procName, index);
+    }
+    pixDestroy(&pix);
+    pixDestroy(&pixs);
+    if (ret)
+        return 0;
+    params->pages[i] = l_byteaInitFromMem(imdata, imbytes);
+    LEPT_FREE(imdata);
+    return 0;
+}
+
+
+/*!
+ *  pdfConcatenatePages()
+ *
+ *      Input:  pages (array of pdf data for each page; null entries
+ *                     are pages that could not be made)
+ *              n (size of the array)
+ *              &data (<return> output pdf data for all pages)
+ *              &nbytes (<return> size of output pdf data)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The pages are concatenated in order, skipping null entries.
+ *      (2) This takes ownership of the array and the page data,
+ *          and destroys them.
+ */
+static l_int32
+pdfConcatenatePages(L_BYTEA  **pages,
+                    l_int32    n,
+                    l_uint8  **pdata,
+                    size_t    *pnbytes)
+{
+l_int32   i, npages, ret;
+L_BYTEA  *ba;
+L_PTRA   *pa_data;
+
+    PROCNAME("pdfConcatenatePages");
+
     pa_data = ptraCreate(n);
     for (i = 0; i < n; i++) {
-        if ((pixs = pixaGetPix(pixa, i, L_CLONE)) == NULL) {
-            L_ERROR("pix[%d] not retrieved\n", procName, i);
-            continue;
-        }
-        if (scalefactor != 1.0)
-            pix = pixScale(pixs, scalefactor, scalefactor);
-        else
-            pix = pixClone(pixs);
-        pixDestroy(&pixs);
-        scaledres = (l_int32)(res * scalefactor);
-        if (type != 0) {
-            pagetype = type;
-        } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
-            L_ERROR("encoding type selection failed for pix[%d]\n",
-                        procName, i);
-            pixDestroy(&pix);
-            continue;
-        }
-        ret = pixConvertToPdfData(pix, pagetype, quality, &imdata, &imbytes,
-                                  0, 0, scaledres, title, NULL, 0);
-        pixDestroy(&pix);
-        if (ret) {
-            L_ERROR("pdf encoding failed for pix[%d]\n", procName, i);
-            continue;
-        }
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        if (imdata) LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
+        if (pages[i])
+            ptraAdd(pa_data, pages[i]);
     }
-    ptraGetActualCount(pa_data, &n);
-    if (n == 0) {
+    LEPT_FREE(pages);
+    ptraGetActualCount(pa_data, &npages);
+    if (npages == 0) {
         L_ERROR("no pdf files made\n", procName);
         ptraDestroy(&pa_data, FALSE, FALSE);
         return 1;
     }
 
-        /* Concatenate them */
     ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
 
-    ptraGetActualCount(pa_data, &n);  /* recalculate in case it changes */
-    for (i = 0; i < n; i++) {
+    ptraGetActualCount(pa_data, &npages);  /* recalculate in case it changes */
+    for (i = 0; i < npages; i++) {
         ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
         l_byteaDestroy(&ba);
     }
@@ -865,6 +1056,62 @@ L_PTRA   *pa_data;
 }
 
 
+/*!
+ *  pdfWritePages()
+ *
+ *      Input:  params (PDF_PAGE_PARAMS, without the pages array)
+ *              n (number of pages)
+ *              pagefunc (makes the pdf data for one page)
+ *              fileout (output pdf file)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The pages are made in batches of a few pages for each thread,
+ *          and each batch is written to @fileout with a pdf writer
+ *          before the next is made.  Only one batch of encoded pages is
+ *          in memory at a time.
+ *      (2) Pages that can't be made are skipped, as in
+ *          pdfConcatenatePages().
+ */
+static l_int32
+pdfWritePages(PDF_PAGE_PARAMS  *params,
+              l_int32           n,
+              l_int32         (*pagefunc)(void *, l_int32),
+              const char       *fileout)
+{
+l_uint8      *data;
+l_int32       i, first, nbatch, nb;
+size_t        size;
+L_PDFWRITER  *pw;
+
+    PROCNAME("pdfWritePages");
+
+    nbatch = PdfPagesPerThread * l_getParallelThreads();
+    if ((params->pages = (L_BYTEA **)LEPT_CALLOC(nbatch, sizeof(L_BYTEA *)))
+        == NULL)
+        return ERROR_INT("pages not made", procName, 1);
+    if ((pw = pdfWriterOpen(fileout, NULL)) == NULL) {
+        LEPT_FREE(params->pages);
+        return ERROR_INT("pdf writer not made", procName, 1);
+    }
+
+    for (first = 0; first < n; first += nbatch) {
+        nb = L_MIN(nbatch, n - first);
+        params->first = first;
+        l_parallelRun(nb, 0, pagefunc, params);
+        for (i = 0; i < nb; i++) {
+            if (!params->pages[i]) continue;
+            data = l_byteaGetData(params->pages[i], &size);
+            if (pdfWriterAddPage(pw, data, size))
+                L_ERROR("can't add page %d; skipping\n", procName, first + i);
+            l_byteaDestroy(&params->pages[i]);
+        }
+    }
+    LEPT_FREE(params->pages);
+    return pdfWriterClose(&pw);
+}
+
+
 /*---------------------------------------------------------------------*
  *                Single page, multi-image converters                  *
  *---------------------------------------------------------------------*/
@@ -1971,14 +2218,18 @@ SARRAY  *sa;
  *
  *  Notes:
  *      (1) This only works with leptonica-formatted single-page pdf files.
+ *      (2) The files are read and written one at a time with a pdf
+ *          writer; see pdfWriterOpen().
  */
 l_int32
 saConcatenatePdf(SARRAY      *sa,
                  const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+char         *fname;
+l_uint8      *data;
+l_int32       i, n;
+size_t        nbytes;
+L_PDFWRITER  *pw;
 
     PROCNAME("saConcatenatePdf");
 
@@ -1986,13 +2237,22 @@ size_t    nbytes;
         return ERROR_INT("sa not defined", procName, 1);
     if (!fileout)
         return ERROR_INT("fileout not defined", procName, 1);
+    if ((n = sarrayGetCount(sa)) == 0)
+        return ERROR_INT("no filenames found", procName, 1);
 
-    ret = saConcatenatePdfToData(sa, &data, &nbytes);
-    if (ret)
-        return ERROR_INT("pdf data not made", procName, 1);
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    return ret;
+    if ((pw = pdfWriterOpen(fileout, NULL)) == NULL)
+        return ERROR_INT("pdf writer not made", procName, 1);
+    for (i = 0; i < n; i++) {
+        fname = sarrayGetString(sa, i, L_NOCOPY);
+        if ((data = l_binaryRead(fname, &nbytes)) == NULL) {
+            L_ERROR("can't read file %s; skipping\n", procName, fname);
+            continue;
+        }
+        if (pdfWriterAddPage(pw, data, nbytes))
+            L_ERROR("can't parse file %s; skipping\n", procName, fname);
+        LEPT_FREE(data);
+    }
+    return pdfWriterClose(&pw);
 }
 
 
@@ -2005,14 +2265,18 @@ size_t    nbytes;
  *
  *  Notes:
  *      (1) This only works with leptonica-formatted single-page pdf files.
+ *      (2) The pages are written one at a time with a pdf writer,
+ *          so the output is never assembled in memory.
  */
 l_int32
 ptraConcatenatePdf(L_PTRA      *pa,
                    const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+l_uint8      *data;
+l_int32       i, n;
+size_t        nbytes;
+L_BYTEA      *ba;
+L_PDFWRITER  *pw;
 
     PROCNAME("ptraConcatenatePdf");
 
@@ -2021,12 +2285,17 @@ size_t    nbytes;
     if (!fileout)
         return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = ptraConcatenatePdfToData(pa, NULL, &data, &nbytes);
-    if (ret)
-        return ERROR_INT("pdf data not made", procName, 1);
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    return ret;
+    if ((pw = pdfWriterOpen(fileout, NULL)) == NULL)
+        return ERROR_INT("pdf writer not made", procName, 1);
+    ptraGetMaxIndex(pa, &n);
+    for (i = 0; i <= n; i++) {
+        if ((ba = (L_BYTEA *)ptraGetPtrToItem(pa, i)) == NULL)
+            continue;
+        data = l_byteaGetData(ba, &nbytes);
+        if (pdfWriterAddPage(pw, data, nbytes))
+            L_ERROR("can't parse file %d; skipping\n", procName, i);
+    }
+    return pdfWriterClose(&pw);
 }
 
 
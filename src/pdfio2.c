@@ -35,12 +35,20 @@
  *     Intermediate function for generating multipage pdf output
  *          l_int32              ptraConcatenatePdfToData()
  *
+ *     Streaming multipage pdf output
+ *          L_PDFWRITER         *pdfWriterOpen()
+ *          l_int32              pdfWriterAddPage()
+ *          l_int32              pdfWriterAddPix()
+ *          l_int32              pdfWriterClose()
+ *          static l_int32       pdfWriterWrite()
+ *
  *     Low-level CID-based operations
  *
  *       Without transcoding
  *          l_int32              l_generateCIDataForPdf()
  *          L_COMP_DATA         *l_generateFlateDataPdf()
  *          L_COMP_DATA         *l_generateJpegData()
+ *          L_COMP_DATA         *l_generateJpegDataMem()
  *          static L_COMP_DATA  *l_generateJp2kData()
  *
  *       With transcoding
@@ -51,6 +59,7 @@
  *          static L_COMP_DATA  *pixGenerateJpegData()
  *          static L_COMP_DATA  *pixGenerateG4Data()
  *          L_COMP_DATA         *l_generateG4Data()
+ *          L_COMP_DATA         *l_generateG4DataMem()
  *
  *       Other
  *          l_int32              cidConvertToPdfData()
@@ -118,6 +127,9 @@ static l_int32       parseTrailerPdf(L_BYTEA *bas, L_DNA **pda);
 static char         *generatePagesObjStringPdf(NUMA *napage);
 static L_BYTEA      *substituteObjectNumbers(L_BYTEA *bas, NUMA *na_objs);
 
+static l_int32       pdfWriterWrite(L_PDFWRITER *pw, const void *data,
+                                    size_t nbytes);
+
 static L_PDF_DATA   *pdfdataCreate(const char *title);
 static void          pdfdataDestroy(L_PDF_DATA **plpd);
 static L_COMP_DATA  *pdfdataGetCid(L_PDF_DATA *lpd, l_int32 index);
@@ -439,6 +451,280 @@ NUMAA    *naa_objs;  /* object mapping numbers to new values */
 }
 
 
+/*---------------------------------------------------------------------*
+ *                   Streaming multipage pdf output                    *
+ *---------------------------------------------------------------------*/
+/*!
+ *  pdfWriterOpen()
+ *
+ *      Input:  fileout (output pdf file)
+ *              title (<optional> pdf title for pages made from a pix)
+ *      Return: pw (pdf writer), or null on error
+ *
+ *  Notes:
+ *      (1) This writes a multipage pdf one page at a time, so that the
+ *          memory used does not grow with the number of pages, apart
+ *          from the location of each object:
+ *              L_PDFWRITER *pw = pdfWriterOpen("book.pdf", "book");
+ *              for (i = 0; i < n; i++) {
+ *                  pix = ...  (get or make the image for page i)
+ *                  pdfWriterAddPix(pw, pix, L_JPEG_ENCODE, 0, 300);
+ *                  pixDestroy(&pix);
+ *              }
+ *              pdfWriterClose(&pw);
+ *      (2) Pages can also be added as single-page pdf data that was
+ *          made by leptonica; see pdfWriterAddPage().
+ *      (3) The catalog and info objects are those of the first page,
+ *          which are followed by the objects of each page, renumbered
+ *          as in ptraConcatenatePdfToData().  The Pages object, which
+ *          refers to all the pages, is written after the last page.
+ *      (4) The file is not opened until the first page is added, so
+ *          that no file is made if no page is ever added.
+ */
+L_PDFWRITER *
+pdfWriterOpen(const char  *fileout,
+              const char  *title)
+{
+L_PDFWRITER  *pw;
+
+    PROCNAME("pdfWriterOpen");
+
+    if (!fileout)
+        return (L_PDFWRITER *)ERROR_PTR("fileout not defined", procName, NULL);
+    if ((pw = (L_PDFWRITER *)LEPT_CALLOC(1, sizeof(L_PDFWRITER))) == NULL)
+        return (L_PDFWRITER *)ERROR_PTR("pw not made", procName, NULL);
+    pw->fileout = stringNew(fileout);
+    if (title) pw->title = stringNew(title);
+    pw->nobj = 4;  /* the first 3 are catalog, info and pages */
+    pw->objloc = l_dnaCreate(0);
+    pw->napage = numaCreate(0);
+    return pw;
+}
+
+
+/*!
+ *  pdfWriterAddPage()
+ *
+ *      Input:  pw (pdf writer)
+ *              data (pdf data for a single page, made by leptonica)
+ *              nbytes (size of the data)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The objects of the page are written immediately, and the
+ *          data can then be freed.
+ *      (2) As with ptraConcatenatePdfToData(), the page must be in the
+ *          format written by leptonica.  If it cannot be parsed, it is
+ *          not added, and the writer can still be used.
+ *      (3) The output file is opened when the first page is added.
+ */
+l_int32
+pdfWriterAddPage(L_PDFWRITER  *pw,
+                 l_uint8      *data,
+                 size_t        nbytes)
+{
+l_uint8  *pdfdata, *objdata;
+l_int32   j, n, ret;
+l_int32  *sizes, *locs;
+size_t    size;
+L_BYTEA  *bas, *bat1, *bat2;
+L_DNA    *da_locs, *da_sizes;
+NUMA     *na_objs;
+
+    PROCNAME("pdfWriterAddPage");
+
+    if (!pw)
+        return ERROR_INT("pw not defined", procName, 1);
+    if (!data || nbytes == 0)
+        return ERROR_INT("no page data", procName, 1);
+
+    bas = l_byteaInitFromMem(data, nbytes);
+    if (parseTrailerPdf(bas, &da_locs) != 0) {
+        l_byteaDestroy(&bas);
+        return ERROR_INT("can't parse page", procName, 1);
+    }
+    n = l_dnaGetCount(da_locs) - 1;  /* objects, with the header as #0 */
+    if (n < 5) {
+        l_dnaDestroy(&da_locs);
+        l_byteaDestroy(&bas);
+        return ERROR_INT("page has too few objects", procName, 1);
+    }
+    if (!pw->fp && (pw->fp = fopenWriteStream(pw->fileout, "wb")) == NULL) {
+        l_dnaDestroy(&da_locs);
+        l_byteaDestroy(&bas);
+        return ERROR_INT("stream not opened", procName, 1);
+    }
+
+        /* Map the page objects (from #4) to the next numbers.  The
+         * catalog, info and pages objects keep their numbers. */
+    na_objs = numaMakeSequence(0.0, 1.0, n);
+    numaAddNumber(pw->napage, pw->nobj);  /* the Page object is #4 */
+    for (j = 4; j < n; j++)
+        numaSetValue(na_objs, j, pw->nobj++);
+
+    pdfdata = l_byteaGetData(bas, &size);
+    da_sizes = l_dnaMakeDelta(da_locs);
+    sizes = l_dnaGetIArray(da_sizes);
+    locs = l_dnaGetIArray(da_locs);
+    ret = 0;
+    if (pw->npages == 0) {  /* header, catalog and info */
+        for (j = 0; j < 3; j++) {
+            l_dnaAddNumber(pw->objloc, (l_float64)pw->nbytes);
+            ret |= pdfWriterWrite(pw, pdfdata + locs[j], sizes[j]);
+        }
+        l_dnaAddNumber(pw->objloc, 0);  /* pages; set by pdfWriterClose() */
+    }
+    for (j = 4; j < n; j++) {
+        l_dnaAddNumber(pw->objloc, (l_float64)pw->nbytes);
+        bat1 = l_byteaInitFromMem(pdfdata + locs[j], sizes[j]);
+        bat2 = substituteObjectNumbers(bat1, na_objs);
+        objdata = l_byteaGetData(bat2, &size);
+        ret |= pdfWriterWrite(pw, objdata, size);
+        l_byteaDestroy(&bat1);
+        l_byteaDestroy(&bat2);
+    }
+    pw->npages++;
+
+    LEPT_FREE(sizes);
+    LEPT_FREE(locs);
+    l_dnaDestroy(&da_sizes);
+    l_dnaDestroy(&da_locs);
+    numaDestroy(&na_objs);
+    l_byteaDestroy(&bas);
+    if (ret)
+        return ERROR_INT("page not written", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  pdfWriterAddPix()
+ *
+ *      Input:  pw (pdf writer)
+ *              pix (all depths; cmap OK)
+ *              type (L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE, or 0
+ *                    for the default for the image)
+ *              quality (used for JPEG only; 0 for default (75))
+ *              res (override the resolution of the input image, in ppi;
+ *                   use 0 to respect the resolution embedded in the input)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This encodes the pix on a page by itself, and adds the page.
+ *      (2) See selectDefaultPdfEncoding() for the default type.
+ */
+l_int32
+pdfWriterAddPix(L_PDFWRITER  *pw,
+                PIX          *pix,
+                l_int32       type,
+                l_int32       quality,
+                l_int32       res)
+{
+l_uint8  *data;
+l_int32   ret;
+size_t    nbytes;
+
+    PROCNAME("pdfWriterAddPix");
+
+    if (!pw)
+        return ERROR_INT("pw not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+    if (type == 0 && selectDefaultPdfEncoding(pix, &type) != 0)
+        return ERROR_INT("encoding type not selected", procName, 1);
+
+    if (pixConvertToPdfData(pix, type, quality, &data, &nbytes, 0, 0, res,
+                            pw->title, NULL, 0) != 0)
+        return ERROR_INT("pdf data not made", procName, 1);
+    ret = pdfWriterAddPage(pw, data, nbytes);
+    LEPT_FREE(data);
+    return ret;
+}
+
+
+/*!
+ *  pdfWriterClose()
+ *
+ *      Input:  &pw (<will be set to null before returning>)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This writes the Pages object and the xref table, closes
+ *          the file and destroys the writer.
+ *      (2) It is an error if no pages were added, in which case no
+ *          file was made, or if any write to the file failed, in which
+ *          case the file is removed.  No invalid pdf is left behind.
+ */
+l_int32
+pdfWriterClose(L_PDFWRITER  **ppw)
+{
+char         *str_pages, *str_trailer;
+l_int32       ret;
+L_PDFWRITER  *pw;
+
+    PROCNAME("pdfWriterClose");
+
+    if (!ppw)
+        return ERROR_INT("&pw not defined", procName, 1);
+    if ((pw = *ppw) == NULL)
+        return ERROR_INT("pw not defined", procName, 1);
+
+    ret = 0;
+    if (pw->npages == 0) {
+        L_ERROR("no pages were written\n", procName);
+        ret = 1;
+    } else {
+        l_dnaSetValue(pw->objloc, 3, (l_float64)pw->nbytes);
+        str_pages = generatePagesObjStringPdf(pw->napage);
+        ret |= pdfWriterWrite(pw, str_pages, strlen(str_pages));
+        l_dnaAddNumber(pw->objloc, (l_float64)pw->nbytes);  /* xref */
+        str_trailer = makeTrailerStringPdf(pw->objloc);
+        ret |= pdfWriterWrite(pw, str_trailer, strlen(str_trailer));
+        LEPT_FREE(str_pages);
+        LEPT_FREE(str_trailer);
+    }
+    if (pw->fp) {
+        if (ferror(pw->fp))
+            ret = 1;
+        if (fclose(pw->fp) != 0)
+            ret = 1;
+        if (ret)
+            lept_rmfile(pw->fileout);
+    }
+
+    LEPT_FREE(pw->fileout);
+    if (pw->title) LEPT_FREE(pw->title);
+    l_dnaDestroy(&pw->objloc);
+    numaDestroy(&pw->napage);
+    LEPT_FREE(pw);
+    *ppw = NULL;
+    if (ret)
+        return ERROR_INT("pdf not completed", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  pdfWriterWrite()
+ *
+ *      Input:  pw (pdf writer)
+ *              data, nbytes
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+pdfWriterWrite(L_PDFWRITER  *pw,
+               const void   *data,
+               size_t        nbytes)
+{
+    PROCNAME("pdfWriterWrite");
+
+    if (fwrite(data, 1, nbytes, pw->fp) != nbytes)
+        return ERROR_INT("write to stream failed", procName, 1);
+    pw->nbytes += nbytes;
+    return 0;
+}
+
+
 /*---------------------------------------------------------------------*
  *                     Low-level CID-based operations                  *
  *---------------------------------------------------------------------*/
@@ -721,13 +1007,8 @@ L_COMP_DATA *
 l_generateJpegData(const char  *fname,
                    l_int32      ascii85flag)
 {
-l_uint8      *datacomp = NULL;  /* entire jpeg compressed file */
-char         *data85 = NULL;  /* ascii85 encoded jpeg compressed file */
-l_int32       w, h, xres, yres, bps, spp;
-l_int32       nbytes85;
-size_t        nbytescomp;
-FILE         *fp;
-L_COMP_DATA  *cid;
+l_uint8  *data;
+size_t    nbytes;
 
     PROCNAME("l_generateJpegData");
 
@@ -736,22 +1017,63 @@ L_COMP_DATA  *cid;
 
         /* The returned jpeg data in memory is the entire jpeg file,
          * which starts with ffd8 and ends with ffd9 */
-    if ((datacomp = l_binaryRead(fname, &nbytescomp)) == NULL)
+    if ((data = l_binaryRead(fname, &nbytes)) == NULL)
         return (L_COMP_DATA *)ERROR_PTR("datacomp not extracted",
                                         procName, NULL);
+    return l_generateJpegDataMem(data, nbytes, ascii85flag);
+}
+
+
+/*!
+ *  l_generateJpegDataMem()
+ *
+ *      Input:  data (entire jpeg file in memory)
+ *              nbytes (size of data)
+ *              ascii85flag (0 for jpeg; 1 for ascii85-encoded jpeg)
+ *      Return: cid (containing jpeg data), or null on error
+ *
+ *  Notes:
+ *      (1) The @data is absorbed: for binary output, it becomes the
+ *          compressed data of the cid without being copied; otherwise
+ *          it is freed after ascii85 encoding.  It is also freed on
+ *          error, so the caller must not use it after this call.
+ *      (2) The metadata is read from the header in memory.
+ *      (3) See l_generateJpegData() for the use of ascii85flag.
+ */
+L_COMP_DATA *
+l_generateJpegDataMem(l_uint8  *data,
+                      size_t    nbytes,
+                      l_int32   ascii85flag)
+{
+char         *data85 = NULL;  /* ascii85 encoded jpeg compressed file */
+l_int32       w, h, xres, yres, bps, spp;
+l_int32       nbytes85;
+FILE         *fp;
+L_COMP_DATA  *cid;
+
+    PROCNAME("l_generateJpegDataMem");
+
+    if (!data)
+        return (L_COMP_DATA *)ERROR_PTR("data not defined", procName, NULL);
 
         /* Read the metadata */
-    if ((fp = fopenReadStream(fname)) == NULL)
+    if ((fp = fopenReadFromMemory(data, nbytes)) == NULL) {
+        LEPT_FREE(data);
         return (L_COMP_DATA *)ERROR_PTR("stream not opened", procName, NULL);
-    freadHeaderJpeg(fp, &w, &h, &spp, NULL, NULL);
+    }
+    if (freadHeaderJpeg(fp, &w, &h, &spp, NULL, NULL)) {
+        fclose(fp);
+        LEPT_FREE(data);
+        return (L_COMP_DATA *)ERROR_PTR("header not read", procName, NULL);
+    }
     bps = 8;
     fgetJpegResolution(fp, &xres, &yres);
     fclose(fp);
 
         /* Optionally, encode the compressed data */
     if (ascii85flag == 1) {
-        data85 = encodeAscii85(datacomp, nbytescomp, &nbytes85);
-        LEPT_FREE(datacomp);
+        data85 = encodeAscii85(data, nbytes, &nbytes85);
+        LEPT_FREE(data);
         if (!data85)
             return (L_COMP_DATA *)ERROR_PTR("data85 not made", procName, NULL);
         else
@@ -759,16 +1081,21 @@ L_COMP_DATA  *cid;
     }
 
     cid = (L_COMP_DATA *)LEPT_CALLOC(1, sizeof(L_COMP_DATA));
-    if (!cid)
+    if (!cid) {
+        if (ascii85flag == 0)
+            LEPT_FREE(data);
+        else
+            LEPT_FREE(data85);
         return (L_COMP_DATA *)ERROR_PTR("cid not made", procName, NULL);
+    }
     if (ascii85flag == 0) {
-        cid->datacomp = datacomp;
+        cid->datacomp = data;
     } else {  /* ascii85 */
         cid->data85 = data85;
         cid->nbytes85 = nbytes85;
     }
     cid->type = L_JPEG_ENCODE;
-    cid->nbytescomp = nbytescomp;
+    cid->nbytescomp = nbytes;
     cid->w = w;
     cid->h = h;
     cid->bps = bps;
@@ -1160,8 +1487,8 @@ pixGenerateJpegData(PIX     *pixs,
                     l_int32  quality)
 {
 l_int32       d;
-char         *fname;
-L_COMP_DATA  *cid;
+l_uint8      *data;
+size_t        nbytes;
 
     PROCNAME("pixGenerateJpegData");
 
@@ -1173,15 +1500,13 @@ L_COMP_DATA  *cid;
     if (d != 8 && d != 32)
         return (L_COMP_DATA *)ERROR_PTR("pixs not 8 or 32 bpp", procName, NULL);
 
-        /* Compress to a temp jpeg file */
-    lept_mkdir("lept");
-    fname = genTempFilename("/tmp/lept", "temp.jpg", 1, 1);
-    pixWriteJpeg(fname, pixs, quality, 0);
-
-    cid = l_generateJpegData(fname, ascii85flag);
-    lept_rmfile(fname);
-    lept_free(fname);
-    return cid;
+        /* Compress to jpeg in memory; the data is absorbed by the cid */
+    data = NULL;
+    if (pixWriteMemJpeg(&data, &nbytes, pixs, quality, 0)) {
+        LEPT_FREE(data);
+        return (L_COMP_DATA *)ERROR_PTR("jpeg data not made", procName, NULL);
+    }
+    return l_generateJpegDataMem(data, nbytes, ascii85flag);
 }
 
 
@@ -1196,12 +1521,17 @@ L_COMP_DATA  *cid;
  *      (1) Set ascii85flag:
  *           - 0 for binary data (not permitted in PostScript)
  *           - 1 for ascii85 (5 for 4) encoded binary data
+ *      (2) The g4 data is generated directly with pixEncodeG4(),
+ *          so this does not require libtiff.
  */
 static L_COMP_DATA *
 pixGenerateG4Data(PIX     *pixs,
                   l_int32  ascii85flag)
 {
-char         *tname;
+char         *data85 = NULL;  /* ascii85 encoded g4 compressed data */
+l_uint8      *data;
+l_int32       nbytes85;
+size_t        nbytes;
 L_COMP_DATA  *cid;
 
     PROCNAME("pixGenerateG4Data");
@@ -1211,14 +1541,42 @@ L_COMP_DATA  *cid;
     if (pixGetDepth(pixs) != 1)
         return (L_COMP_DATA *)ERROR_PTR("pixs not 1 bpp", procName, NULL);
 
-        /* Compress to a temp tiff g4 file */
-    lept_mkdir("lept");
-    tname = genTempFilename("/tmp/lept", "temp.tif", 1, 1);
-    pixWrite(tname, pixs, IFF_TIFF_G4);
+        /* Compress to g4 in memory; the data is absorbed by the cid */
+    if (pixEncodeG4(&data, &nbytes, pixs))
+        return (L_COMP_DATA *)ERROR_PTR("g4 data not made", procName, NULL);
+
+        /* Optionally, encode the compressed data */
+    if (ascii85flag == 1) {
+        data85 = encodeAscii85(data, nbytes, &nbytes85);
+        LEPT_FREE(data);
+        if (!data85)
+            return (L_COMP_DATA *)ERROR_PTR("data85 not made", procName, NULL);
+        else
+            data85[nbytes85 - 1] = '\0';  /* remove the newline */
+    }
 
-    cid = l_generateG4Data(tname, ascii85flag);
-    lept_rmfile(tname);
-    lept_free(tname);
+    cid = (L_COMP_DATA *)LEPT_CALLOC(1, sizeof(L_COMP_DATA));
+    if (!cid) {
+        if (ascii85flag == 0)
+            LEPT_FREE(data);
+        else
+            LEPT_FREE(data85);
+        return (L_COMP_DATA *)ERROR_PTR("cid not made", procName, NULL);
+    }
+    if (ascii85flag == 0) {
+        cid->datacomp = data;
+    } else {  /* ascii85 */
+        cid->data85 = data85;
+        cid->nbytes85 = nbytes85;
+    }
+    cid->type = L_G4_ENCODE;
+    cid->nbytescomp = nbytes;
+    cid->w = pixGetWidth(pixs);
+    cid->h = pixGetHeight(pixs);
+    cid->bps = 1;
+    cid->spp = 1;
+    cid->minisblack = FALSE;
+    cid->res = pixGetXRes(pixs);
     return cid;
 }
 
@@ -1240,50 +1598,85 @@ L_COMP_DATA *
 l_generateG4Data(const char  *fname,
                  l_int32      ascii85flag)
 {
-l_uint8      *datacomp = NULL;  /* g4 compressed raster data */
+l_uint8  *data;
+size_t    nbytes;
+
+    PROCNAME("l_generateG4Data");
+
+    if (!fname)
+        return (L_COMP_DATA *)ERROR_PTR("fname not defined", procName, NULL);
+
+    if ((data = l_binaryRead(fname, &nbytes)) == NULL)
+        return (L_COMP_DATA *)ERROR_PTR("data not read", procName, NULL);
+    return l_generateG4DataMem(data, nbytes, ascii85flag);
+}
+
+
+/*!
+ *  l_generateG4DataMem()
+ *
+ *      Input:  data (entire tiff g4 file in memory)
+ *              nbytes (size of data)
+ *              ascii85flag (0 for g4 compressed; 1 for ascii85-encoded g4)
+ *      Return: cid (g4 compressed image data), or null on error
+ *
+ *  Notes:
+ *      (1) The @data is absorbed.  For binary output, the ccitt g4
+ *          stream is moved to the start of @data, which becomes the
+ *          compressed data of the cid; nothing is copied to another
+ *          buffer.  For ascii85 output, @data is freed after encoding.
+ *          It is also freed on error.
+ *      (2) The metadata is read from the tiff header in memory.
+ *      (3) See l_generateG4Data() for the use of ascii85flag.
+ */
+L_COMP_DATA *
+l_generateG4DataMem(l_uint8  *data,
+                    size_t    nbytes,
+                    l_int32   ascii85flag)
+{
 char         *data85 = NULL;  /* ascii85 encoded g4 compressed data */
-l_int32       w, h, xres, yres;
+l_int32       w, h, xres;
 l_int32       minisblack;  /* TRUE or FALSE */
 l_int32       nbytes85;
-size_t        nbytescomp;
+size_t        offset, nbytescomp;
 L_COMP_DATA  *cid;
-FILE         *fp;
 
-    PROCNAME("l_generateG4Data");
+    PROCNAME("l_generateG4DataMem");
 
-    if (!fname)
-        return (L_COMP_DATA *)ERROR_PTR("fname not defined", procName, NULL);
+    if (!data)
+        return (L_COMP_DATA *)ERROR_PTR("data not defined", procName, NULL);
 
-        /* The returned ccitt g4 data in memory is the block of
-         * bytes in the tiff file, starting after 8 bytes and
-         * ending before the directory. */
-    if (extractG4DataFromFile(fname, &datacomp, &nbytescomp,
-                              &w, &h, &minisblack)) {
+        /* The ccitt g4 data is the block of bytes in the tiff data,
+         * starting after 8 bytes and ending before the directory. */
+    if (extractG4DataFromMem(data, nbytes, &offset, &nbytescomp,
+                             &w, &h, &minisblack, &xres)) {
+        LEPT_FREE(data);
         return (L_COMP_DATA *)ERROR_PTR("datacomp not extracted",
                                         procName, NULL);
     }
 
-        /* Read the resolution */
-    if ((fp = fopenReadStream(fname)) == NULL)
-        return (L_COMP_DATA *)ERROR_PTR("stream not opened", procName, NULL);
-    getTiffResolution(fp, &xres, &yres);
-    fclose(fp);
-
         /* Optionally, encode the compressed data */
     if (ascii85flag == 1) {
-        data85 = encodeAscii85(datacomp, nbytescomp, &nbytes85);
-        LEPT_FREE(datacomp);
+        data85 = encodeAscii85(data + offset, nbytescomp, &nbytes85);
+        LEPT_FREE(data);
         if (!data85)
             return (L_COMP_DATA *)ERROR_PTR("data85 not made", procName, NULL);
         else
             data85[nbytes85 - 1] = '\0';  /* remove the newline */
+    } else {
+        memmove(data, data + offset, nbytescomp);
     }
 
     cid = (L_COMP_DATA *)LEPT_CALLOC(1, sizeof(L_COMP_DATA));
-    if (!cid)
+    if (!cid) {
+        if (ascii85flag == 0)
+            LEPT_FREE(data);
+        else
+            LEPT_FREE(data85);
         return (L_COMP_DATA *)ERROR_PTR("cid not made", procName, NULL);
+    }
     if (ascii85flag == 0) {
-        cid->datacomp = datacomp;
+        cid->datacomp = data;
     } else {  /* ascii85 */
         cid->data85 = data85;
         cid->nbytes85 = nbytes85;
@@ -1827,10 +2220,11 @@ L_DNA   *daloc, *dasize;
 static char *
 makeTrailerStringPdf(L_DNA  *daloc)
 {
-char    *outstr;
-char     buf[L_BIGBUF];
-l_int32  i, n, linestart, xrefloc;
-SARRAY  *sa;
+char      *outstr;
+char       buf[L_BIGBUF];
+l_int32    i, n;
+l_float64  linestart, xrefloc;
+SARRAY    *sa;
 
     PROCNAME("makeTrailerStringPdf");
 
@@ -1843,13 +2237,15 @@ SARRAY  *sa;
                                "0 %d\n"
                                "0000000000 65535 f \n", n);
     sarrayAddString(sa, (char *)buf, L_COPY);
+        /* The locations are doubles, so that a streamed file
+         * can be larger than 2 GB */
     for (i = 1; i < n; i++) {
-        l_dnaGetIValue(daloc, i, &linestart);
-        snprintf(buf, sizeof(buf), "%010d 00000 n \n", linestart);
+        l_dnaGetDValue(daloc, i, &linestart);
+        snprintf(buf, sizeof(buf), "%010.0f 00000 n \n", linestart);
         sarrayAddString(sa, (char *)buf, L_COPY);
     }
 
-    l_dnaGetIValue(daloc, n, &xrefloc);
+    l_dnaGetDValue(daloc, n, &xrefloc);
     snprintf(buf, sizeof(buf), "trailer\n"
                                "<<\n"
                                "/Size %d\n"
@@ -1857,7 +2253,7 @@ SARRAY  *sa;
                                "/Info 2 0 R\n"
                                ">>\n"
                                "startxref\n"
-                               "%d\n"
+                               "%.0f\n"
                                "%%%%EOF\n", n, xrefloc);
     sarrayAddString(sa, (char *)buf, L_COPY);
     outstr = sarrayToString(sa, 0);
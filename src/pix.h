@@ -117,7 +117,12 @@
  *                              Basic Pix                                  *
  *-------------------------------------------------------------------------*/
     /* The 'special' field is by default 0, but it can hold integers
-     * that direct non-default actions, e.g., in png and jpeg I/O. */
+     * that direct non-default actions, e.g., in png and jpeg I/O.
+     * A view does not own its image data.  It is either a rectangle
+     * of the data of another pix (the parent, which is cloned by the
+     * view), or an external buffer that is owned by the caller.
+     * The lines of a view have the stride (wpl) of the parent, and
+     * start on a word boundary; see pixCreateView(). */
 struct Pix
 {
     l_uint32             w;           /* width in pixels                   */
@@ -125,7 +130,7 @@ struct Pix
     l_uint32             d;           /* depth in bits (bpp)               */
     l_uint32             spp;         /* number of samples per pixel       */
     l_uint32             wpl;         /* 32-bit words/line                 */
-    l_uint32             refcount;    /* reference count (1 if no clones)  */
+    l_atomic             refcount;    /* reference count (1 if no clones)  */
     l_int32              xres;        /* image res (ppi) in x direction    */
                                       /* (use 0 if unknown)                */
     l_int32              yres;        /* image res (ppi) in y direction    */
@@ -135,6 +140,8 @@ struct Pix
     char                *text;        /* text string associated with pix   */
     struct PixColormap  *colormap;    /* colormap (may be null)            */
     l_uint32            *data;        /* the image data                    */
+    l_int32              view;        /* 1 if the data is not owned        */
+    struct Pix          *parent;      /* owner of the data of a view       */
 };
 typedef struct Pix PIX;
 
@@ -416,7 +423,7 @@ struct Pixa
 {
     l_int32             n;            /* number of Pix in ptr array        */
     l_int32             nalloc;       /* number of Pix ptrs allocated      */
-    l_uint32            refcount;     /* reference count (1 if no clones)  */
+    l_atomic            refcount;     /* reference count (1 if no clones)  */
     struct Pix        **pix;          /* the array of ptrs to pix          */
     struct Boxa        *boxa;         /* array of boxes                    */
 };
@@ -442,7 +449,7 @@ struct Box
     l_int32            y;
     l_int32            w;
     l_int32            h;
-    l_uint32           refcount;      /* reference count (1 if no clones)  */
+    l_atomic           refcount;      /* reference count (1 if no clones)  */
 
 };
 typedef struct Box    BOX;
@@ -451,7 +458,7 @@ struct Boxa
 {
     l_int32            n;             /* number of box in ptr array        */
     l_int32            nalloc;        /* number of box ptrs allocated      */
-    l_uint32           refcount;      /* reference count (1 if no clones)  */
+    l_atomic           refcount;      /* reference count (1 if no clones)  */
     struct Box       **box;           /* box ptr array                     */
 };
 typedef struct Boxa  BOXA;
@@ -474,7 +481,7 @@ struct Pta
 {
     l_int32            n;             /* actual number of pts              */
     l_int32            nalloc;        /* size of allocated arrays          */
-    l_uint32           refcount;      /* reference count (1 if no clones)  */
+    l_atomic           refcount;      /* reference count (1 if no clones)  */
     l_float32         *x, *y;         /* arrays of floats                  */
 };
 typedef struct Pta PTA;
@@ -533,7 +540,7 @@ struct FPix
     l_int32              w;           /* width in pixels                   */
     l_int32              h;           /* height in pixels                  */
     l_int32              wpl;         /* 32-bit words/line                 */
-    l_uint32             refcount;    /* reference count (1 if no clones)  */
+    l_atomic             refcount;    /* reference count (1 if no clones)  */
     l_int32              xres;        /* image res (ppi) in x direction    */
                                       /* (use 0 if unknown)                */
     l_int32              yres;        /* image res (ppi) in y direction    */
@@ -547,7 +554,7 @@ struct FPixa
 {
     l_int32             n;            /* number of fpix in ptr array       */
     l_int32             nalloc;       /* number of fpix ptrs allocated     */
-    l_uint32            refcount;     /* reference count (1 if no clones)  */
+    l_atomic            refcount;     /* reference count (1 if no clones)  */
     struct FPix       **fpix;         /* the array of ptrs to fpix         */
 };
 typedef struct FPixa FPIXA;
@@ -563,7 +570,7 @@ struct DPix
     l_int32              w;           /* width in pixels                   */
     l_int32              h;           /* height in pixels                  */
     l_int32              wpl;         /* 32-bit words/line                 */
-    l_uint32             refcount;    /* reference count (1 if no clones)  */
+    l_atomic             refcount;    /* reference count (1 if no clones)  */
     l_int32              xres;        /* image res (ppi) in x direction    */
                                       /* (use 0 if unknown)                */
     l_int32              yres;        /* image res (ppi) in y direction    */
@@ -52,6 +52,11 @@
  *          PIX          *pixCreateHeader()
  *          PIX          *pixClone()
  *
+ *    Pix views
+ *          PIX          *pixCreateView()
+ *          PIX          *pixCreateFromData()
+ *          l_int32       pixIsView()
+ *
  *    Pix destruction
  *          void          pixDestroy()
  *          static void   pixFree()
@@ -185,6 +190,12 @@
  *  on the pix data field, look carefully at the behavior of the image
  *  data accessors and keep in mind that when you invoke pixDestroy(),
  *  the pix considers itself the owner of all its heap data.
+ *
+ *  The exception is a view, which refers to image data that it
+ *  does not own: either a rectangle in another pix, or a buffer
+ *  provided by the caller.  See pixCreateView() and pixCreateFromData().
+ *  pixDestroy() never frees the data of a view, and pixFreeData()
+ *  just detaches it.
  */
 
 #include <string.h>
@@ -503,6 +514,148 @@ pixClone(PIX  *pixs)
 }
 
 
+/*--------------------------------------------------------------------*
+ *                               Pix Views                            *
+ *--------------------------------------------------------------------*/
+/*!
+ *  pixCreateView()
+ *
+ *      Input:  pixs
+ *              box (<optional> rectangle of pixs; use all of pixs if null)
+ *      Return: pixd (a view of the rectangle, or a copy of it),
+ *              or null on error
+ *
+ *  Notes:
+ *      (1) This makes a pix that refers to the image data of pixs
+ *          within the box, without copying it.  The box is clipped
+ *          to pixs.  pixs is cloned, so it can be destroyed by the
+ *          caller before the view.  pixs can itself be a view.
+ *      (2) The view should only be read.  Changes to the pixels
+ *          in pixs are seen in the view.  Functions that change their
+ *          input in place, such as pixSetPadBits(), must not be used
+ *          on a view, because they change pixs.
+ *      (3) The view has the wpl of pixs, and its lines start at the
+ *          left edge of the box.  This requires the left edge to be on
+ *          a word boundary: always for 32 bpp, for 8 bpp when x is a
+ *          multiple of 4, and for 1 bpp only when x is a multiple of 32.
+ *          A box that does not start on a word boundary is not viewed:
+ *          a copy of the rectangle is returned instead, as with
+ *          pixClipRectangle().  Use pixIsView() to tell which was made.
+ *      (4) The wpl of a view is usually larger than that of a pix of
+ *          its width.  Functions that find each line from the wpl of
+ *          the pix handle this.  Functions that treat the data as one
+ *          block of wpl * h words, or that use the wpl of the input
+ *          for a new pix, do not.  pixCopy(), pixEndianByteSwapNew(),
+ *          pixSerializeToMemory() and the image writers support
+ *          views.  When in doubt, use pixCopy() first.
+ */
+PIX *
+pixCreateView(PIX  *pixs,
+              BOX  *box)
+{
+l_int32  w, h, d, bx, by, bw, bh, bit;
+BOX     *boxc;
+PIX     *pixd;
+
+    PROCNAME("pixCreateView");
+
+    if (!pixs)
+        return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    bx = by = 0;
+    bw = w;
+    bh = h;
+    if (box) {
+        if ((boxc = boxClipToRectangle(box, w, h)) == NULL)
+            return (PIX *)ERROR_PTR("box outside pixs", procName, NULL);
+        boxGetGeometry(boxc, &bx, &by, &bw, &bh);
+        boxDestroy(&boxc);
+    }
+    bit = bx * d;
+    if (bit & 31)  /* lines would not start on a word boundary */
+        return pixClipRectangle(pixs, box, NULL);
+
+    if ((pixd = pixCreateHeader(bw, bh, d)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    pixCopySpp(pixd, pixs);
+    pixCopyResolution(pixd, pixs);
+    pixCopyColormap(pixd, pixs);
+    pixCopyInputFormat(pixd, pixs);
+    pixSetWpl(pixd, pixGetWpl(pixs));
+    pixd->data = pixGetData(pixs) + by * pixGetWpl(pixs) + bit / 32;
+    pixd->view = 1;
+    if (pixs->parent)  /* refer to the owner of the data */
+        pixd->parent = pixClone(pixs->parent);
+    else if (!pixs->view)
+        pixd->parent = pixClone(pixs);
+    return pixd;
+}
+
+
+/*!
+ *  pixCreateFromData()
+ *
+ *      Input:  data (image data, owned by the caller)
+ *              width, height, depth
+ *              wpl (32-bit words from the start of one line to the next)
+ *      Return: pixd (a view of the data), or null on error
+ *
+ *  Notes:
+ *      (1) This wraps an existing buffer, such as the output of a
+ *          decoder, without copying it.  The data is never freed by
+ *          the pix, and must not be freed by the caller until the pix
+ *          (and any views of it) have been destroyed.
+ *      (2) The data must be in the pix format: each line starts on a
+ *          32-bit word boundary, and the pixels are packed from the
+ *          most significant bit of each word.  For depths less than
+ *          32 on little-endian machines, the bytes of each word are
+ *          in reverse order; see pixEndianByteSwap().
+ *      (3) The pix is a view; see pixCreateView().
+ */
+PIX *
+pixCreateFromData(l_uint32  *data,
+                  l_int32    width,
+                  l_int32    height,
+                  l_int32    depth,
+                  l_int32    wpl)
+{
+PIX  *pixd;
+
+    PROCNAME("pixCreateFromData");
+
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if ((pixd = pixCreateHeader(width, height, depth)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    if (wpl < pixGetWpl(pixd)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("wpl too small", procName, NULL);
+    }
+    pixSetWpl(pixd, wpl);
+    pixd->data = data;
+    pixd->view = 1;
+    return pixd;
+}
+
+
+/*!
+ *  pixIsView()
+ *
+ *      Input:  pix
+ *      Return: 1 if pix is a view; 0 if it owns its data or on error
+ */
+l_int32
+pixIsView(PIX  *pix)
+{
+    PROCNAME("pixIsView");
+
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 0);
+    return pix->view;
+}
+
+
 /*--------------------------------------------------------------------*
  *                           Pix Destruction                          *
  *--------------------------------------------------------------------*/
@@ -553,10 +706,15 @@ char      *text;
 
     if (!pix) return;
 
-    pixChangeRefcount(pix, -1);
-    if (pixGetRefcount(pix) <= 0) {
-        if ((data = pixGetData(pix)) != NULL)
+        /* Decrement the ref count.  If it is 0, destroy the pix.
+         * The decrement and the test are a single operation, so this
+         * is safe against concurrent destroys when the refcount is
+         * atomic (see USE_ATOMIC_REFCOUNT in environ.h). */
+    if (--pix->refcount <= 0) {
+        if ((data = pixGetData(pix)) != NULL && !pix->view)
             pix_free(data);
+        if (pix->parent)
+            pixDestroy(&pix->parent);
         if ((text = pixGetText(pix)) != NULL)
             LEPT_FREE(text);
         pixDestroyColormap(pix);
@@ -596,6 +754,8 @@ char      *text;
  *          and the copy proceeds.  The refcount of pixd is unchanged.
  *      (4) This operation, like all others that may involve a pre-existing
  *          pixd, will side-effect any existing clones of pixd.
+ *      (5) If pixs is a view, pixd owns a copy of the pixels in the view,
+ *          and the pad bits are 0.
  */
 PIX *
 pixCopy(PIX  *pixd,   /* can be null */
@@ -618,6 +778,11 @@ l_uint32  *datas, *datad;
     if (!pixd) {
         if ((pixd = pixCreateTemplate(pixs)) == NULL)
             return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+        if (pixIsView(pixs)) {
+            pixRasterop(pixd, 0, 0, pixGetWidth(pixs), pixGetHeight(pixs),
+                        PIX_SRC, pixs, 0, 0);
+            return pixd;
+        }
         datas = pixGetData(pixs);
         datad = pixGetData(pixd);
         memcpy((char *)datad, (char *)datas, bytes);
@@ -636,6 +801,12 @@ l_uint32  *datas, *datad;
     pixCopyText(pixd, pixs);
 
         /* Copy image data */
+    if (pixIsView(pixs)) {
+        pixSetPadBits(pixd, 0);
+        pixRasterop(pixd, 0, 0, pixGetWidth(pixs), pixGetHeight(pixs),
+                    PIX_SRC, pixs, 0, 0);
+        return pixd;
+    }
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
     memcpy((char*)datad, (char*)datas, bytes);
@@ -654,6 +825,8 @@ l_uint32  *datas, *datad;
  *      (1) This removes any existing image data from pixd and
  *          allocates an uninitialized buffer that will hold the
  *          amount of image data that is in pixs.
+ *      (2) If pixs is a view, the buffer only holds the pixels of
+ *          the view, without the rest of the lines of its parent.
  */
 l_int32
 pixResizeImageData(PIX  *pixd,
@@ -669,11 +842,11 @@ l_uint32  *data;
     if (!pixd)
         return ERROR_INT("pixd not defined", procName, 1);
 
-    if (pixSizesEqual(pixs, pixd))  /* nothing to do */
+    if (pixSizesEqual(pixs, pixd) && !pixIsView(pixd))  /* nothing to do */
         return 0;
 
     pixGetDimensions(pixs, &w, &h, &d);
-    wpl = pixGetWpl(pixs);
+    wpl = (pixIsView(pixs)) ? (w * d + 31) / 32 : pixGetWpl(pixs);
     pixSetWidth(pixd, w);
     pixSetHeight(pixd, h);
     pixSetDepth(pixd, d);
@@ -818,7 +991,8 @@ PIX     *pixs;
     if (pixs == pixd)  /* no-op */
         return ERROR_INT("pixd == pixs", procName, 1);
 
-    if (pixGetRefcount(pixs) == 1) {  /* transfer the data, cmap, text */
+    if (pixGetRefcount(pixs) == 1 && !pixIsView(pixs)) {
+            /* transfer the data, cmap, text */
         pixFreeData(pixd);  /* dealloc any existing data */
         pixSetData(pixd, pixGetData(pixs));  /* transfer new data from pixs */
         pixs->data = NULL;  /* pixs no longer owns data */
@@ -830,8 +1004,15 @@ PIX     *pixs;
         }
     } else {  /* preserve pixs by making a copy of the data, cmap, text */
         pixResizeImageData(pixd, pixs);
-        nbytes = 4 * pixGetWpl(pixs) * pixGetHeight(pixs);
-        memcpy((char *)pixGetData(pixd), (char *)pixGetData(pixs), nbytes);
+        if (pixIsView(pixs)) {
+            pixSetPadBits(pixd, 0);
+            pixRasterop(pixd, 0, 0, pixGetWidth(pixs), pixGetHeight(pixs),
+                        PIX_SRC, pixs, 0, 0);
+        } else {
+            nbytes = 4 * pixGetWpl(pixs) * pixGetHeight(pixs);
+            memcpy((char *)pixGetData(pixd), (char *)pixGetData(pixs),
+                   nbytes);
+        }
         pixCopyColormap(pixd, pixs);
         if (copytext)
             pixCopyText(pixd, pixs);
@@ -839,7 +1020,8 @@ PIX     *pixs;
 
     pixCopySpp(pixd, pixs);
     pixCopyResolution(pixd, pixs);
-    pixCopyDimensions(pixd, pixs);
+    if (!pixIsView(pixs))  /* the wpl of a view is not its own */
+        pixCopyDimensions(pixd, pixs);
     if (copyformat)
         pixCopyInputFormat(pixd, pixs);
 
@@ -1586,18 +1768,30 @@ pixSetData(PIX       *pix,
  *          pix->data ptr is set to NULL.
  *      (3) If refcount > 1, this simply returns a copy of the data,
  *          using the pix allocator, and leaving the input pix unchanged.
+ *      (4) If pixs is a view, this returns a copy of the pixels in the
+ *          view, with the wpl of a pix of its size.
  */
 l_uint32 *
 pixExtractData(PIX  *pixs)
 {
 l_int32    count, bytes;
 l_uint32  *data, *datas;
+PIX       *pixt;
 
     PROCNAME("pixExtractData");
 
     if (!pixs)
         return (l_uint32 *)ERROR_PTR("pixs not defined", procName, NULL);
 
+    if (pixIsView(pixs)) {  /* copy the pixels of the view */
+        if ((pixt = pixCopy(NULL, pixs)) == NULL)
+            return (l_uint32 *)ERROR_PTR("pixt not made", procName, NULL);
+        data = pixGetData(pixt);
+        pixSetData(pixt, NULL);
+        pixDestroy(&pixt);
+        return data;
+    }
+
     count = pixGetRefcount(pixs);
     if (count == 1) {  /* extract */
         data = pixGetData(pixs);
@@ -1622,6 +1816,8 @@ l_uint32  *data, *datas;
  *          It should be used before pixSetData() in the situation where
  *          you want to free any existing data before doing
  *          a subsequent assignment with pixSetData().
+ *      (2) For a view, the data is not freed; the pix is detached from
+ *          it, and is no longer a view.
  */
 l_int32
 pixFreeData(PIX  *pix)
@@ -1633,7 +1829,12 @@ l_uint32  *data;
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
 
-    if ((data = pixGetData(pix)) != NULL) {
+    if (pix->view) {
+        if (pix->parent)
+            pixDestroy(&pix->parent);
+        pix->view = 0;
+        pix->data = NULL;
+    } else if ((data = pixGetData(pix)) != NULL) {
         pix_free(data);
         pix->data = NULL;
     }
@@ -2754,8 +2754,8 @@ l_int32    wpls;
 PIX *
 pixEndianByteSwapNew(PIX  *pixs)
 {
-l_uint32  *datas, *datad;
-l_int32    i, j, h, wpl;
+l_uint32  *datas, *datad, *lines, *lined;
+l_int32    i, j, h, wpls, wpld;
 l_uint32   word;
 PIX       *pixd;
 
@@ -2771,14 +2771,17 @@ PIX       *pixd;
         return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
 
     datas = pixGetData(pixs);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
     h = pixGetHeight(pixs);
     pixd = pixCreateTemplate(pixs);
     datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);  /* smaller than wpls if pixs is a view */
     for (i = 0; i < h; i++) {
-        for (j = 0; j < wpl; j++, datas++, datad++) {
-            word = *datas;
-            *datad = (word >> 24) |
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        for (j = 0; j < wpld; j++, lines++, lined++) {
+            word = *lines;
+            *lined = (word >> 24) |
                     ((word >> 8) & 0x0000ff00) |
                     ((word << 8) & 0x00ff0000) |
                     (word << 24);
@@ -2922,8 +2925,8 @@ l_uint32  word;
 PIX *
 pixEndianTwoByteSwapNew(PIX  *pixs)
 {
-l_uint32  *datas, *datad;
-l_int32    i, j, h, wpl;
+l_uint32  *datas, *datad, *lines, *lined;
+l_int32    i, j, h, wpls, wpld;
 l_uint32   word;
 PIX       *pixd;
 
@@ -2939,14 +2942,17 @@ PIX       *pixd;
         return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
 
     datas = pixGetData(pixs);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
     h = pixGetHeight(pixs);
     pixd = pixCreateTemplate(pixs);
     datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);  /* smaller than wpls if pixs is a view */
     for (i = 0; i < h; i++) {
-        for (j = 0; j < wpl; j++, datas++, datad++) {
-            word = *datas;
-            *datad = (word << 16) | (word >> 16);
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        for (j = 0; j < wpld; j++, lines++, lined++) {
+            word = *lines;
+            *lined = (word << 16) | (word >> 16);
         }
     }
 
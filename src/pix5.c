@@ -2716,7 +2716,7 @@ PTA       *pta;
 PIX *
 pixRankRowTransform(PIX  *pixs)
 {
-l_int32    i, j, k, m, w, h, wpl, val;
+l_int32    i, j, k, m, w, h, wpls, wpld, val;
 l_int32    histo[256];
 l_uint32  *datas, *datad, *lines, *lined;
 PIX       *pixd;
@@ -2734,11 +2734,12 @@ PIX       *pixd;
     pixd = pixCreateTemplateNoInit(pixs);
     datas = pixGetData(pixs);
     datad = pixGetData(pixd);
-    wpl = pixGetWpl(pixs);
+    wpls = pixGetWpl(pixs);
+    wpld = pixGetWpl(pixd);
     for (i = 0; i < h; i++) {
         memset(histo, 0, 1024);
-        lines = datas + i * wpl;
-        lined = datad + i * wpl;
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
         for (j = 0; j < w; j++) {
             val = GET_DATA_BYTE(lines, j);
             histo[val]++;
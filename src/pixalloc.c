@@ -37,10 +37,33 @@
  *          l_int32       pmsGetLevelForAlloc()
  *          l_int32       pmsGetLevelForDealloc()
  *          void          pmsLogInfo()
+ *
+ *      Per-thread pix memory arenas with allocator and deallocator
+ *
+ *          l_int32       pmaCreate()
+ *          void          pmaDestroy()
+ *          void         *pmaCustomAlloc()
+ *          void          pmaCustomDealloc()
+ *          void          pmaTrim()
+ *          l_int32       pmaGetStats()
+ *          void          pmaLogInfo()
+ *          static L_PIX_ARENA  *pmaGetThreadArena()
+ *          static l_int32       pmaGetLevel()
+ *          static void          pmaReleaseCache()
+ *          static void          pmaRetireArena()
+ *          static void          pmaFreeArena()
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
 #include "allheaders.h"
 
+#if HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif  /* HAVE_LIBPTHREAD */
+
 /*-------------------------------------------------------------------------*
  *                          Pix Memory Storage                             *
  *                                                                         *
@@ -158,7 +181,8 @@ static L_PIX_MEM_STORE  *CustomPMS = NULL;
  *          in the normal way before calling pmsDestroy().
  *      (4) The pms struct is stored in a static global, so this function
  *          is not thread-safe.  When used, there must be only one thread
- *          per process.
+ *          per process.  For multithreaded programs, use the per-thread
+ *          arenas; see pmaCreate().
  */
 l_int32
 pmsCreate(size_t       minsize,
@@ -529,3 +553,644 @@ L_PIX_MEM_STORE  *pms;
 
     return;
 }
+
+
+/*-------------------------------------------------------------------------*
+ *                     Per-thread Pix Memory Arenas                        *
+ *                                                                         *
+ *  This is a pix memory allocator that can be used by any number of      *
+ *  threads.  It is enabled by setting the PixMemoryManager allocators    *
+ *  to the functions that are defined here                                *
+ *        pmaCustomAlloc()                                                 *
+ *        pmaCustomDealloc()                                               *
+ *  Use pmaCreate() at the beginning to set the parameters, and           *
+ *  pmaDestroy() at the end to clean it up.                                *
+ *-------------------------------------------------------------------------*/
+/*
+ *  Each thread that allocates pix data gets its own arena, which keeps
+ *  lists of free chunks in a set of size classes.  The classes go from
+ *  'minsize' to 'maxsize' in steps of alternately 1.5x and 4/3x
+ *  (1, 1.5, 2, 3, 4, 6, ...), so that at most 1/3 of a chunk is unused.
+ *  A request is rounded up to its class, and taken from the free list
+ *  of the calling thread's arena if it is not empty.  Requests that are
+ *  smaller than 'minsize' or larger than 'maxsize' are passed directly
+ *  to malloc and free.
+ *
+ *  Every chunk starts with a small header that records the arena that
+ *  allocated it and its size class.  When a chunk is freed, it goes
+ *  back to the free list of that arena, even if it is freed by a
+ *  different thread.  Each arena has its own lock, which is normally
+ *  only taken by its own thread, so there is no contention unless
+ *  chunks are freed by other threads.
+ *
+ *  The memory kept in the free lists of an arena is bounded by
+ *  'maxretain'.  A chunk that would exceed it is returned to the
+ *  system.  When a thread exits, the free chunks of its arena are
+ *  returned to the system; the arena itself is kept, and counted in
+ *  the statistics, until the last of its chunks that is still in use
+ *  is freed.
+ *
+ *  The usage statistics for all arenas are given by pmaGetStats().
+ *  Without thread support (HAVE_LIBPTHREAD is 0), there is a single
+ *  arena, and no locking.
+ */
+
+    /* Max number of size classes */
+#define  MAX_PMA_LEVELS   64
+
+    /* Default parameters */
+static const size_t  DefaultPmaMinsize = 4096;
+static const size_t  DefaultPmaMaxsize = 64 * 1024 * 1024;
+static const size_t  DefaultPmaMaxretain = 256 * 1024 * 1024;
+
+struct L_PixArena;
+
+    /* Header at the start of each chunk.  The data follows it, at an
+     * offset of PmaHeaderSize bytes. */
+struct L_PixArenaChunk
+{
+    struct L_PixArena        *arena;   /* arena that allocated the chunk  */
+    struct L_PixArenaChunk   *next;    /* next chunk in the free list     */
+    size_t                    size;    /* bytes of data in the chunk      */
+    l_int32                   level;   /* size class; -1 if not cached    */
+};
+typedef struct L_PixArenaChunk  L_PIX_ARENA_CHUNK;
+
+struct L_PixArena
+{
+    L_MUTEX             *mutex;      /* protects all the fields below      */
+    L_PIX_ARENA_CHUNK   *free[MAX_PMA_LEVELS];  /* free list for each size */
+    struct L_PixArena   *nextarena;  /* next arena in the list of all      */
+    l_int32              retired;    /* 1 after its thread has exited      */
+    l_int32              detached;   /* 1 if not in the list of the store  */
+    size_t               nout;       /* number of chunks in use            */
+    size_t               nalloc;     /* log: number of allocs              */
+    size_t               nreuse;     /* log: allocs taken from free lists  */
+    size_t               nremote;    /* log: chunks freed by other threads */
+    size_t               inuse;      /* log: bytes in use                  */
+    size_t               retained;   /* bytes held in the free lists       */
+};
+typedef struct L_PixArena  L_PIX_ARENA;
+
+struct PixArenaStore
+{
+    L_MUTEX         *mutex;        /* protects the list and the totals     */
+    L_PIX_ARENA     *arenas;       /* list of arenas                       */
+    l_int32          nlevels;      /* number of size classes               */
+    size_t           sizes[MAX_PMA_LEVELS];  /* data bytes in each class   */
+    size_t           minsize;      /* smaller requests use malloc          */
+    size_t           maxsize;      /* larger requests use malloc           */
+    size_t           maxretain;    /* max bytes in free lists of an arena  */
+    size_t           nalloc;       /* log: allocs in freed arenas          */
+    size_t           nreuse;       /* log: reuses in freed arenas          */
+    size_t           nremote;      /* log: remote frees in freed arenas    */
+#if HAVE_LIBPTHREAD
+    pthread_key_t    key;          /* arena of the calling thread          */
+#else
+    L_PIX_ARENA     *arena;        /* the single arena                     */
+#endif  /* HAVE_LIBPTHREAD */
+};
+typedef struct PixArenaStore   L_PIX_ARENA_STORE;
+
+static L_PIX_ARENA_STORE  *CustomPMA = NULL;
+
+    /* Offset of the data from the start of the chunk; keeps the data
+     * aligned as well as memory from malloc() */
+static const size_t  PmaHeaderSize = (sizeof(L_PIX_ARENA_CHUNK) + 15) & ~15;
+
+static L_PIX_ARENA *pmaGetThreadArena(L_PIX_ARENA_STORE *pma);
+static l_int32 pmaGetLevel(L_PIX_ARENA_STORE *pma, size_t nbytes);
+static void pmaReleaseCache(L_PIX_ARENA *arena);
+static void pmaRetireArena(void *arg);
+static void pmaFreeArena(L_PIX_ARENA *arena);
+
+
+/*!
+ *  pmaCreate()
+ *
+ *      Input:  minsize (smallest data chunk that is held in the arenas;
+ *                       use 0 for default)
+ *              maxsize (largest data chunk that is held in the arenas;
+ *                       use 0 for default)
+ *              maxretain (max bytes of free chunks that each arena holds;
+ *                         use 0 for default)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This sets up the arenas that are used by pmaCustomAlloc()
+ *          and pmaCustomDealloc().  The arenas themselves are made as
+ *          each thread does its first allocation.
+ *      (2) The defaults are 4 KB for @minsize, 64 MB for @maxsize and
+ *          256 MB for @maxretain.  Smaller chunks are handled well by
+ *          the system malloc, and chunks larger than @maxsize are
+ *          passed on to it as well.
+ *      (3) Important: call this, and then set the allocators with
+ *             setPixMemoryManager(pmaCustomAlloc, pmaCustomDealloc);
+ *          before any pix have been allocated.  Destroy all the pix
+ *          in the normal way before calling pmaDestroy().
+ *      (4) Call this from one thread, before any other thread uses
+ *          the library.
+ *      (5) Image data must be freed with pixFreeData() or pixDestroy(),
+ *          not with free(); for example, data that is taken from a pix
+ *          with pixExtractData().
+ */
+l_int32
+pmaCreate(size_t  minsize,
+          size_t  maxsize,
+          size_t  maxretain)
+{
+l_int32             i;
+size_t              size;
+L_PIX_ARENA_STORE  *pma;
+
+    PROCNAME("pmaCreate");
+
+    if (CustomPMA)
+        return ERROR_INT("pma already exists", procName, 1);
+    if (minsize == 0) minsize = DefaultPmaMinsize;
+    if (maxsize == 0) maxsize = DefaultPmaMaxsize;
+    if (maxretain == 0) maxretain = DefaultPmaMaxretain;
+    minsize = (minsize + 15) & ~15;  /* keep every class a multiple of 16 */
+    if (maxsize < minsize)
+        return ERROR_INT("maxsize < minsize", procName, 1);
+
+    if ((pma = (L_PIX_ARENA_STORE *)LEPT_CALLOC(1, sizeof(L_PIX_ARENA_STORE)))
+        == NULL)
+        return ERROR_INT("pma not made", procName, 1);
+    if ((pma->mutex = l_mutexCreate()) == NULL) {
+        LEPT_FREE(pma);
+        return ERROR_INT("mutex not made", procName, 1);
+    }
+#if HAVE_LIBPTHREAD
+    if (pthread_key_create(&pma->key, pmaRetireArena) != 0) {
+        l_mutexDestroy(&pma->mutex);
+        LEPT_FREE(pma);
+        return ERROR_INT("thread key not made", procName, 1);
+    }
+#endif  /* HAVE_LIBPTHREAD */
+
+        /* Size classes 1, 1.5, 2, 3, 4, ... times minsize */
+    for (i = 0, size = minsize; i < MAX_PMA_LEVELS; i++) {
+        pma->sizes[i] = size;
+        if (size >= maxsize)
+            break;
+        size = (i % 2 == 0) ? (minsize << (i / 2)) * 3 / 2
+                            : minsize << (i / 2 + 1);
+    }
+    pma->nlevels = L_MIN(i + 1, MAX_PMA_LEVELS);
+    pma->minsize = minsize;
+    pma->maxsize = pma->sizes[pma->nlevels - 1];
+    pma->maxretain = maxretain;
+    CustomPMA = pma;
+    return 0;
+}
+
+
+/*!
+ *  pmaDestroy()
+ *
+ *      Input:  (none)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Important: call this function at the end of the program,
+ *          after the last pix has been destroyed and the other threads
+ *          that used the library have stopped.
+ *      (2) The memory held by the arenas is returned to the system.
+ *          An arena with chunks that are still in use is kept until
+ *          they are freed with pmaCustomDealloc().
+ */
+void
+pmaDestroy(void)
+{
+L_PIX_ARENA        *arena, *next;
+L_PIX_ARENA_STORE  *pma;
+
+    if ((pma = CustomPMA) == NULL)
+        return;
+
+#if HAVE_LIBPTHREAD
+    pthread_key_delete(pma->key);
+#endif  /* HAVE_LIBPTHREAD */
+    l_mutexLock(pma->mutex);
+    arena = pma->arenas;
+    pma->arenas = NULL;
+    l_mutexUnlock(pma->mutex);
+    while (arena) {
+        next = arena->nextarena;
+        l_mutexLock(arena->mutex);
+        arena->nextarena = NULL;
+        arena->detached = TRUE;
+        l_mutexUnlock(arena->mutex);
+        pmaRetireArena(arena);
+        arena = next;
+    }
+
+    l_mutexDestroy(&pma->mutex);
+    LEPT_FREE(pma);
+    CustomPMA = NULL;
+    return;
+}
+
+
+/*!
+ *  pmaCustomAlloc()
+ *
+ *      Input:  nbytes (min number of bytes in the chunk to be retrieved)
+ *      Return: data (ptr to chunk), or null on error
+ *
+ *  Notes:
+ *      (1) The chunk is taken from the free list of the calling
+ *          thread's arena if possible.  Otherwise it is allocated.
+ *      (2) The data is not initialized.
+ */
+void *
+pmaCustomAlloc(size_t  nbytes)
+{
+l_int32             level;
+size_t              size;
+L_PIX_ARENA        *arena;
+L_PIX_ARENA_CHUNK  *chunk;
+L_PIX_ARENA_STORE  *pma;
+
+    PROCNAME("pmaCustomAlloc");
+
+    if ((pma = CustomPMA) == NULL)
+        return (void *)ERROR_PTR("pma not defined", procName, NULL);
+    if ((arena = pmaGetThreadArena(pma)) == NULL)
+        return (void *)ERROR_PTR("arena not made", procName, NULL);
+
+    level = pmaGetLevel(pma, nbytes);
+    size = (level >= 0) ? pma->sizes[level] : nbytes;
+    l_mutexLock(arena->mutex);
+    if (level >= 0 && (chunk = arena->free[level]) != NULL) {
+        arena->free[level] = chunk->next;
+        arena->retained -= size;
+        arena->nreuse++;
+    } else {
+        l_mutexUnlock(arena->mutex);
+        chunk = (L_PIX_ARENA_CHUNK *)malloc(PmaHeaderSize + size);
+        if (!chunk)
+            return (void *)ERROR_PTR("chunk not made", procName, NULL);
+        chunk->arena = arena;
+        chunk->size = size;
+        chunk->level = level;
+        l_mutexLock(arena->mutex);
+    }
+    chunk->next = NULL;
+    arena->nalloc++;
+    arena->nout++;
+    arena->inuse += size;
+    l_mutexUnlock(arena->mutex);
+    return (void *)((char *)chunk + PmaHeaderSize);
+}
+
+
+/*!
+ *  pmaCustomDealloc()
+ *
+ *      Input:  data (to be freed or returned to the arena)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The chunk goes back to the arena that allocated it, whichever
+ *          thread frees it.  It is returned to the system if the arena
+ *          already holds @maxretain bytes of free chunks, or if its
+ *          thread has exited.
+ *      (2) This only uses the chunk header, so it can be called after
+ *          pmaDestroy() for data that was allocated before it.
+ */
+void
+pmaCustomDealloc(void  *data)
+{
+l_int32             remote, release, retired;
+L_PIX_ARENA        *arena;
+L_PIX_ARENA_CHUNK  *chunk;
+L_PIX_ARENA_STORE  *pma;
+
+    if (!data)
+        return;
+
+    pma = CustomPMA;
+    chunk = (L_PIX_ARENA_CHUNK *)((char *)data - PmaHeaderSize);
+    arena = chunk->arena;
+#if HAVE_LIBPTHREAD
+    remote = (!pma || arena != pthread_getspecific(pma->key));
+#else
+    remote = FALSE;
+#endif  /* HAVE_LIBPTHREAD */
+
+    release = TRUE;
+    l_mutexLock(arena->mutex);
+    arena->nout--;
+    arena->inuse -= chunk->size;
+    if (remote)
+        arena->nremote++;
+    if (chunk->level >= 0 && !arena->retired && pma &&
+        arena->retained + chunk->size <= pma->maxretain) {
+        chunk->next = arena->free[chunk->level];
+        arena->free[chunk->level] = chunk;
+        arena->retained += chunk->size;
+        release = FALSE;
+    }
+    retired = (arena->retired && arena->nout == 0);
+    l_mutexUnlock(arena->mutex);
+
+    if (release)
+        free(chunk);
+    if (retired)  /* last chunk of an arena whose thread has exited */
+        pmaFreeArena(arena);
+    return;
+}
+
+
+/*!
+ *  pmaTrim()
+ *
+ *      Input:  (none)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This returns the free chunks held by all the arenas to the
+ *          system.  Chunks in use are not affected.  It can be called
+ *          at any time; for example, when a service becomes idle.
+ */
+void
+pmaTrim(void)
+{
+L_PIX_ARENA        *arena;
+L_PIX_ARENA_STORE  *pma;
+
+    if ((pma = CustomPMA) == NULL)
+        return;
+
+    l_mutexLock(pma->mutex);
+    for (arena = pma->arenas; arena; arena = arena->nextarena) {
+        l_mutexLock(arena->mutex);
+        pmaReleaseCache(arena);
+        l_mutexUnlock(arena->mutex);
+    }
+    l_mutexUnlock(pma->mutex);
+    return;
+}
+
+
+/*!
+ *  pmaGetStats()
+ *
+ *      Input:  &narenas (<optional return> number of arenas in use)
+ *              &nalloc (<optional return> total number of allocs)
+ *              &nreuse (<optional return> number of allocs that were
+ *                       taken from the free lists)
+ *              &nremote (<optional return> number of chunks that were
+ *                        freed by a thread other than the allocating one)
+ *              &inuse (<optional return> bytes currently in use)
+ *              &retained (<optional return> bytes currently held in
+ *                         the free lists)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The counts include the arenas of threads that have exited.
+ *          @narenas includes those that still have chunks in use.
+ *          The byte counts are rounded up to the size classes, and do
+ *          not include the chunk headers.
+ *      (2) While other threads are allocating, the values are a
+ *          snapshot taken one arena at a time.
+ */
+l_int32
+pmaGetStats(l_int32  *pnarenas,
+            size_t   *pnalloc,
+            size_t   *pnreuse,
+            size_t   *pnremote,
+            size_t   *pinuse,
+            size_t   *pretained)
+{
+l_int32             narenas;
+size_t              nalloc, nreuse, nremote, inuse, retained;
+L_PIX_ARENA        *arena;
+L_PIX_ARENA_STORE  *pma;
+
+    PROCNAME("pmaGetStats");
+
+    if (pnarenas) *pnarenas = 0;
+    if (pnalloc) *pnalloc = 0;
+    if (pnreuse) *pnreuse = 0;
+    if (pnremote) *pnremote = 0;
+    if (pinuse) *pinuse = 0;
+    if (pretained) *pretained = 0;
+    if ((pma = CustomPMA) == NULL)
+        return ERROR_INT("pma not defined", procName, 1);
+
+    narenas = 0;
+    inuse = retained = 0;
+    l_mutexLock(pma->mutex);
+    nalloc = pma->nalloc;
+    nreuse = pma->nreuse;
+    nremote = pma->nremote;
+    for (arena = pma->arenas; arena; arena = arena->nextarena) {
+        l_mutexLock(arena->mutex);
+        narenas++;
+        nalloc += arena->nalloc;
+        nreuse += arena->nreuse;
+        nremote += arena->nremote;
+        inuse += arena->inuse;
+        retained += arena->retained;
+        l_mutexUnlock(arena->mutex);
+    }
+    l_mutexUnlock(pma->mutex);
+
+    if (pnarenas) *pnarenas = narenas;
+    if (pnalloc) *pnalloc = nalloc;
+    if (pnreuse) *pnreuse = nreuse;
+    if (pnremote) *pnremote = nremote;
+    if (pinuse) *pinuse = inuse;
+    if (pretained) *pretained = retained;
+    return 0;
+}
+
+
+/*!
+ *  pmaLogInfo()
+ *
+ *      Input:  (none)
+ *      Return: void
+ */
+void
+pmaLogInfo(void)
+{
+l_int32  narenas;
+size_t   nalloc, nreuse, nremote, inuse, retained;
+
+    if (!CustomPMA)
+        return;
+
+    pmaGetStats(&narenas, &nalloc, &nreuse, &nremote, &inuse, &retained);
+    fprintf(stderr, "Number of arenas: %d\n", narenas);
+    fprintf(stderr, "Number of allocs: %lu\n", (unsigned long)nalloc);
+    fprintf(stderr, "Allocs taken from the free lists: %lu\n",
+            (unsigned long)nreuse);
+    fprintf(stderr, "Chunks freed by other threads: %lu\n",
+            (unsigned long)nremote);
+    fprintf(stderr, "Bytes in use: %lu\n", (unsigned long)inuse);
+    fprintf(stderr, "Bytes in free lists: %lu\n", (unsigned long)retained);
+    return;
+}
+
+
+/*!
+ *  pmaGetThreadArena()
+ *
+ *      Input:  pma
+ *      Return: arena of the calling thread, or null on error
+ *
+ *  Notes:
+ *      (1) The arena is made on the first call from each thread.
+ */
+static L_PIX_ARENA *
+pmaGetThreadArena(L_PIX_ARENA_STORE  *pma)
+{
+L_PIX_ARENA  *arena;
+
+    PROCNAME("pmaGetThreadArena");
+
+#if HAVE_LIBPTHREAD
+    if ((arena = (L_PIX_ARENA *)pthread_getspecific(pma->key)) != NULL)
+        return arena;
+#else
+    if ((arena = pma->arena) != NULL)
+        return arena;
+#endif  /* HAVE_LIBPTHREAD */
+
+    if ((arena = (L_PIX_ARENA *)LEPT_CALLOC(1, sizeof(L_PIX_ARENA))) == NULL)
+        return (L_PIX_ARENA *)ERROR_PTR("arena not made", procName, NULL);
+    if ((arena->mutex = l_mutexCreate()) == NULL) {
+        LEPT_FREE(arena);
+        return (L_PIX_ARENA *)ERROR_PTR("mutex not made", procName, NULL);
+    }
+#if HAVE_LIBPTHREAD
+    pthread_setspecific(pma->key, arena);
+#else
+    pma->arena = arena;
+#endif  /* HAVE_LIBPTHREAD */
+
+    l_mutexLock(pma->mutex);
+    arena->nextarena = pma->arenas;
+    pma->arenas = arena;
+    l_mutexUnlock(pma->mutex);
+    return arena;
+}
+
+
+/*!
+ *  pmaGetLevel()
+ *
+ *      Input:  pma
+ *              nbytes (size of request)
+ *      Return: smallest size class that holds @nbytes, or -1 if
+ *              the request is not handled by the arenas
+ */
+static l_int32
+pmaGetLevel(L_PIX_ARENA_STORE  *pma,
+            size_t              nbytes)
+{
+l_int32  i;
+
+    if (nbytes < pma->minsize || nbytes > pma->maxsize)
+        return -1;
+    for (i = 0; i < pma->nlevels; i++) {
+        if (nbytes <= pma->sizes[i])
+            break;
+    }
+    return i;
+}
+
+
+/*!
+ *  pmaReleaseCache()
+ *
+ *      Input:  arena (locked by the caller)
+ *      Return: void
+ */
+static void
+pmaReleaseCache(L_PIX_ARENA  *arena)
+{
+l_int32             i;
+L_PIX_ARENA_CHUNK  *chunk, *next;
+
+    for (i = 0; i < MAX_PMA_LEVELS; i++) {
+        for (chunk = arena->free[i]; chunk; chunk = next) {
+            next = chunk->next;
+            free(chunk);
+        }
+        arena->free[i] = NULL;
+    }
+    arena->retained = 0;
+    return;
+}
+
+
+/*!
+ *  pmaRetireArena()
+ *
+ *      Input:  arena
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This is called when the thread that owns the arena exits,
+ *          and by pmaDestroy().  The free chunks are returned to the
+ *          system, and chunks that are freed later are not kept.
+ *      (2) If no chunks of the arena are in use, it is destroyed.
+ *          Otherwise it is destroyed by pmaCustomDealloc() when the
+ *          last chunk is freed.
+ */
+static void
+pmaRetireArena(void  *arg)
+{
+l_int32       destroy;
+L_PIX_ARENA  *arena;
+
+    arena = (L_PIX_ARENA *)arg;
+    l_mutexLock(arena->mutex);
+    pmaReleaseCache(arena);
+    arena->retired = TRUE;
+    destroy = (arena->nout == 0);
+    l_mutexUnlock(arena->mutex);
+    if (destroy)
+        pmaFreeArena(arena);
+    return;
+}
+
+
+/*!
+ *  pmaFreeArena()
+ *
+ *      Input:  arena (retired, with no chunks in use)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The arena is taken out of the list of arenas, and its
+ *          counts are added to the totals of the store.
+ */
+static void
+pmaFreeArena(L_PIX_ARENA  *arena)
+{
+L_PIX_ARENA        **parena;
+L_PIX_ARENA_STORE   *pma;
+
+    if ((pma = CustomPMA) != NULL && !arena->detached) {
+        l_mutexLock(pma->mutex);
+        for (parena = &pma->arenas; *parena; parena = &(*parena)->nextarena) {
+            if (*parena == arena) {
+                *parena = arena->nextarena;
+                break;
+            }
+        }
+        pma->nalloc += arena->nalloc;
+        pma->nreuse += arena->nreuse;
+        pma->nremote += arena->nremote;
+        l_mutexUnlock(pma->mutex);
+    }
+    l_mutexDestroy(&arena->mutex);
+    LEPT_FREE(arena);
+    return;
+}
@@ -162,6 +162,8 @@ static l_int32 pixacompExtendArray(PIXAC *pixac);
  *  Notes:
  *      (1) Use @comptype == IFF_DEFAULT to have the compression
  *          type automatically determined.
+ *      (2) G4 compressed tiff data is made with pixEncodeG4Tiff(),
+ *          so it does not require libtiff.
  */
 PIXC *
 pixcompCreateFromPix(PIX     *pix,
@@ -192,7 +194,10 @@ PIXC     *pixc;
 
     pixcompDetermineFormat(comptype, pixc->d, pixc->cmapflag, &format);
     pixc->comptype = format;
-    ret = pixWriteMem(&data, &size, pix, format);
+    if (format == IFF_TIFF_G4)  /* native g4 coder; no libtiff required */
+        ret = pixEncodeG4Tiff(&data, &size, pix);
+    else
+        ret = pixWriteMem(&data, &size, pix, format);
     if (ret) {
         L_ERROR("write to memory failed\n", procName);
         pixcompDestroy(&pixc);
@@ -477,6 +482,10 @@ pixcompDetermineFormat(l_int32   comptype,
  *
  *      Input:  pixc
  *      Return: pix, or null on error
+ *
+ *  Notes:
+ *      (1) G4 compressed tiff data is decoded with pixDecodeG4Tiff(),
+ *          falling back to libtiff for tiff features it does not handle.
  */
 PIX *
 pixCreateFromPixcomp(PIXC  *pixc)
@@ -489,7 +498,10 @@ PIX     *pix;
     if (!pixc)
         return (PIX *)ERROR_PTR("pixc not defined", procName, NULL);
 
-    if ((pix = pixReadMem(pixc->data, pixc->size)) == NULL)
+    pix = NULL;
+    if (pixc->comptype == IFF_TIFF_G4)
+        pix = pixDecodeG4Tiff(pixc->data, pixc->size);
+    if (!pix && (pix = pixReadMem(pixc->data, pixc->size)) == NULL)
         return (PIX *)ERROR_PTR("pix not read", procName, NULL);
     pixSetResolution(pix, pixc->xres, pixc->yres);
     if (pixc->text)
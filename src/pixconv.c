@@ -136,17 +136,61 @@
  *      Setting neutral point for min/max boost conversion to gray
  *          void         l_setNeutralBoostVal()
  *
+ *      Static helpers for conversion from RGB color to grayscale
+ *          static l_int32   rgbToGrayBand()
+ *          static void      rgbToGrayLine()
+ *          static l_int32   rgbToGrayLineSse2()
+ *          static l_int32   rgbToGrayLineAvx2()
+ *
  *      *** indicates implicit assumption about RGB component ordering
  */
 
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#include "simd.h"
 
 /* ------- Set neutral point for min/max boost conversion to gray ------ */
    /* Call l_setNeutralBoostVal() to change this */
 static l_int32  var_NEUTRAL_BOOST_VAL = 180;
 
+    /* Smallest band of lines given to a thread */
+static const l_int32  MinGrayBandHeight = 32;
+
+    /* Parameters for converting each band of lines from rgb to gray */
+struct RGBToGrayParams
+{
+    l_uint32    *datas;       /* 32 bpp rgb                                */
+    l_uint32    *datad;       /* 8 bpp gray                                */
+    l_int32      w;
+    l_int32      h;
+    l_int32      wpls;
+    l_int32      wpld;
+    l_float32    rwt;         /* weights, adding to 1.0                    */
+    l_float32    gwt;
+    l_float32    bwt;
+    l_int32      nbands;      /* number of bands                           */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct RGBToGrayParams  RGB_TO_GRAY_PARAMS;
+
+    /* Static functions for conversion from rgb to gray */
+static l_int32 rgbToGrayBand(void *data, l_int32 index);
+static void rgbToGrayLine(l_uint32 *lines, l_int32 w, l_uint32 *lined,
+                          l_float32 rwt, l_float32 gwt, l_float32 bwt,
+                          l_int32 simd);
+#if L_HAVE_SSE2
+static l_int32 rgbToGrayLineSse2(l_uint32 *lines, l_int32 w,
+                                 l_uint32 *lined, l_float32 rwt,
+                                 l_float32 gwt, l_float32 bwt);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 rgbToGrayLineAvx2(l_uint32 *lines, l_int32 w,
+                                 l_uint32 *lined, l_float32 rwt,
+                                 l_float32 gwt,
+                                 l_float32 bwt) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+
 
 #ifndef  NO_CONSOLE_IO
 #define DEBUG_CONVERT_TO_COLORMAP  0
@@ -717,6 +761,7 @@ pixConvertRGBToLuminance(PIX *pixs)
  *
  *  Notes:
  *      (1) Use a weighted average of the RGB values.
+ *      (2) The image is converted on bands of lines in parallel.
  */
 PIX *
 pixConvertRGBToGray(PIX       *pixs,
@@ -724,11 +769,10 @@ pixConvertRGBToGray(PIX       *pixs,
                     l_float32  gwt,
                     l_float32  bwt)
 {
-l_int32    i, j, w, h, wpls, wpld, val;
-l_uint32   word;
-l_uint32  *datas, *lines, *datad, *lined;
-l_float32  sum;
-PIX       *pixd;
+l_int32             w, h, nbands;
+l_float32           sum;
+PIX                *pixd;
+RGB_TO_GRAY_PARAMS  params;
 
     PROCNAME("pixConvertRGBToGray");
 
@@ -755,31 +799,206 @@ PIX       *pixd;
     }
 
     pixGetDimensions(pixs, &w, &h, NULL);
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
     if ((pixd = pixCreate(w, h, 8)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     pixCopyResolution(pixd, pixs);
     pixCopyInputFormat(pixd, pixs);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
 
-    for (i = 0; i < h; i++) {
-        lines = datas + i * wpls;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            word = *(lines + j);
-            val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
-                            gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
-                            bwt * ((word >> L_BLUE_SHIFT) & 0xff) + 0.5);
-            SET_DATA_BYTE(lined, j, val);
-        }
-    }
+    params.datas = pixGetData(pixs);
+    params.datad = pixGetData(pixd);
+    params.w = w;
+    params.h = h;
+    params.wpls = pixGetWpl(pixs);
+    params.wpld = pixGetWpl(pixd);
+    params.rwt = rwt;
+    params.gwt = gwt;
+    params.bwt = bwt;
+    nbands = L_MIN(l_getParallelThreads(), h / MinGrayBandHeight);
+    params.nbands = L_MAX(1, nbands);
+    params.simd = l_getSimdMode();
+    if (l_parallelRun(params.nbands, params.nbands, rgbToGrayBand, &params))
+        L_ERROR("bands not converted\n", procName);
 
     return pixd;
 }
 
 
+/*!
+ *  rgbToGrayBand()
+ *
+ *      Input:  data (RGB_TO_GRAY_PARAMS)
+ *              index (of the band of lines)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+rgbToGrayBand(void    *data,
+              l_int32  index)
+{
+l_int32              i, y0, y1;
+RGB_TO_GRAY_PARAMS  *params;
+
+    params = (RGB_TO_GRAY_PARAMS *)data;
+    y0 = (params->h * index) / params->nbands;
+    y1 = (params->h * (index + 1)) / params->nbands;
+    for (i = y0; i < y1; i++) {
+        rgbToGrayLine(params->datas + i * params->wpls, params->w,
+                      params->datad + i * params->wpld, params->rwt,
+                      params->gwt, params->bwt, params->simd);
+    }
+    return 0;
+}
+
+
+/*!
+ *  rgbToGrayLine()
+ *
+ *      Input:  lines (line of 32 bpp rgb pixels)
+ *              w (number of pixels)
+ *              lined (<return> line of 8 bpp gray pixels)
+ *              rwt, gwt, bwt (weights, adding to 1.0)
+ *              simd (simd mode)
+ *      Return: void
+ */
+static void
+rgbToGrayLine(l_uint32   *lines,
+              l_int32     w,
+              l_uint32   *lined,
+              l_float32   rwt,
+              l_float32   gwt,
+              l_float32   bwt,
+              l_int32     simd)
+{
+l_int32   j, jstart, val;
+l_uint32  word;
+
+    jstart = 0;
+    switch (simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = rgbToGrayLineAvx2(lines, w, lined, rwt, gwt, bwt);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        jstart = rgbToGrayLineSse2(lines, w, lined, rwt, gwt, bwt);
+        break;
+#endif  /* L_HAVE_SSE2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        word = *(lines + j);
+        val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
+                        gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
+                        bwt * ((word >> L_BLUE_SHIFT) & 0xff) + 0.5);
+        SET_DATA_BYTE(lined, j, val);
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of pixels
+     * it has done, a multiple of 8; the rest are done by the caller.
+     * The weighted sum is made in float, as in the scalar code.  That
+     * code rounds the sum with (l_int32)(sum + 0.5) in double, which
+     * here is the truncated sum, plus 1 if its fractional part is at
+     * least 0.5.  The gray values are packed to bytes in pixel order, and
+     * then each group of 4 is reversed, to put pixel j in the most
+     * significant byte of its word, as SET_DATA_BYTE() does. */
+#if L_HAVE_SSE2
+static l_int32
+rgbToGrayLineSse2(l_uint32   *lines,
+                  l_int32     w,
+                  l_uint32   *lined,
+                  l_float32   rwt,
+                  l_float32   gwt,
+                  l_float32   bwt)
+{
+l_int32  j, k;
+__m128i  p, ff, ff00, val;
+__m128i  gray[2];
+__m128   rw, gw, bw, half, sum;
+
+    ff = _mm_set1_epi32(0xff);
+    ff00 = _mm_set1_epi32(0xff00);
+    rw = _mm_set1_ps(rwt);
+    gw = _mm_set1_ps(gwt);
+    bw = _mm_set1_ps(bwt);
+    half = _mm_set1_ps(0.5);
+    for (j = 0; j + 8 <= w; j += 8) {
+        for (k = 0; k < 2; k++) {
+            p = _mm_loadu_si128((const __m128i *)(lines + j + 4 * k));
+            sum = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(rw, _mm_cvtepi32_ps(
+                               _mm_srli_epi32(p, L_RED_SHIFT))),
+                           _mm_mul_ps(gw, _mm_cvtepi32_ps(_mm_and_si128(
+                               _mm_srli_epi32(p, L_GREEN_SHIFT), ff)))),
+                _mm_mul_ps(bw, _mm_cvtepi32_ps(_mm_and_si128(
+                               _mm_srli_epi32(p, L_BLUE_SHIFT), ff))));
+            val = _mm_cvttps_epi32(sum);
+            val = _mm_sub_epi32(val, _mm_castps_si128(_mm_cmpge_ps(
+                      _mm_sub_ps(sum, _mm_cvtepi32_ps(val)), half)));
+            gray[k] = _mm_and_si128(val, ff);
+        }
+        val = _mm_packs_epi32(gray[0], gray[1]);
+        val = _mm_packus_epi16(val, val);
+        val = _mm_or_si128(
+                  _mm_or_si128(_mm_slli_epi32(val, 24),
+                               _mm_srli_epi32(val, 24)),
+                  _mm_or_si128(_mm_slli_epi32(_mm_and_si128(val, ff00), 8),
+                               _mm_and_si128(_mm_srli_epi32(val, 8), ff00)));
+        _mm_storel_epi64((__m128i *)(lined + j / 4), val);
+    }
+    return j;
+}
+#endif  /* L_HAVE_SSE2 */
+
+#if L_HAVE_AVX2
+static l_int32
+rgbToGrayLineAvx2(l_uint32   *lines,
+                  l_int32     w,
+                  l_uint32   *lined,
+                  l_float32   rwt,
+                  l_float32   gwt,
+                  l_float32   bwt)
+{
+l_int32  j;
+__m128i  gray, rev;
+__m256i  p, ff, val;
+__m256   rw, gw, bw, half, sum;
+
+    ff = _mm256_set1_epi32(0xff);
+    rw = _mm256_set1_ps(rwt);
+    gw = _mm256_set1_ps(gwt);
+    bw = _mm256_set1_ps(bwt);
+    half = _mm256_set1_ps(0.5);
+    rev = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (j = 0; j + 8 <= w; j += 8) {
+        p = _mm256_loadu_si256((const __m256i *)(lines + j));
+        sum = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(rw, _mm256_cvtepi32_ps(
+                              _mm256_srli_epi32(p, L_RED_SHIFT))),
+                          _mm256_mul_ps(gw, _mm256_cvtepi32_ps(
+                              _mm256_and_si256(
+                                  _mm256_srli_epi32(p, L_GREEN_SHIFT), ff)))),
+            _mm256_mul_ps(bw, _mm256_cvtepi32_ps(_mm256_and_si256(
+                              _mm256_srli_epi32(p, L_BLUE_SHIFT), ff))));
+        val = _mm256_cvttps_epi32(sum);
+        val = _mm256_sub_epi32(val, _mm256_castps_si256(_mm256_cmp_ps(
+                  _mm256_sub_ps(sum, _mm256_cvtepi32_ps(val)), half,
+                  _CMP_GE_OQ)));
+        val = _mm256_and_si256(val, ff);
+        gray = _mm_packs_epi32(_mm256_castsi256_si128(val),
+                               _mm256_extracti128_si256(val, 1));
+        gray = _mm_shuffle_epi8(_mm_packus_epi16(gray, gray), rev);
+        _mm_storel_epi64((__m128i *)(lined + j / 4), gray);
+    }
+    return j;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
 /*!
  *  pixConvertRGBToGrayFast()
  *
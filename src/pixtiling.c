@@ -35,6 +35,8 @@
  *        PIX             *pixTilingGetTile()
  *        l_int32          pixTilingNoStripOnPaint()
  *        l_int32          pixTilingPaintTile()
+ *        l_int32          pixTilingProcess()
+ *        static l_int32   pixTilingProcessTask()
  *
  *   This provides a simple way to split an image into tiles
  *   and to perform operations independently on each tile.
@@ -81,10 +83,36 @@
  *      for pixels that are near the image boundary.
  *    - The tiles are labeled by (i, j) = (row, column),
  *      and in this example there is one row and nx columns.
+ *
+ *   The same loop can be run on several threads with pixTilingProcess(),
+ *   by putting the in-place operation in a tile function:
+ *
+ *     PIX *TileFunc(PIX *pixt, l_int32 i, l_int32 j, void *data) {
+ *         SomeInPlaceOperation(pixt, 30, 0, ...);
+ *         return pixClone(pixt);
+ *     }
+ *     ...
+ *     pixTilingProcess(pt, pixd, TileFunc, NULL, 0);
+ *
+ *   The tiles are processed in parallel, and each result is painted
+ *   into pixd as soon as it is done.
  */
 
 #include "allheaders.h"
 
+    /* Shared input for the tasks in pixTilingProcess() */
+struct TilingProcessJob
+{
+    PIXTILING   *pt;
+    PIX         *pixd;
+    PIX       *(*func)(PIX *, l_int32, l_int32, void *);
+    void        *data;
+    L_MUTEX    **rowlocks;   /* one lock for each row of tiles */
+};
+typedef struct TilingProcessJob  TILING_PROCESS_JOB;
+
+static l_int32 pixTilingProcessTask(void *data, l_int32 index);
+
 
 /*!
  *  pixTilingCreate()
@@ -415,3 +443,111 @@ l_int32  w, h;
     return 0;
 }
 
+
+/*!
+ *  pixTilingProcess()
+ *
+ *      Input:  pt (pixtiling)
+ *              pixd (<optional> dest: paint each processed tile onto this,
+ *                    without overlap; can be null)
+ *              func (tile function: called as func(pixt, i, j, data)
+ *                    for each tile pixt returned by pixTilingGetTile();
+ *                    returns the processed tile, or null on error)
+ *              data (<optional> input passed to every call of func)
+ *              nthreads (max number of threads; use 0 for the default
+ *                        set by l_setParallelThreads())
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This runs the loop over tiles shown at the top of this file,
+ *          with the tiles distributed over a set of threads.
+ *          See l_parallelRun() for how the tiles are scheduled.
+ *      (2) The tile pixt belongs to the call of func; it can be modified
+ *          in place.  func returns a new pix or a clone of pixt.  Both are
+ *          destroyed after the result has been painted into pixd.
+ *      (3) func must not change anything that is shared between tiles,
+ *          such as pixs or @data, without its own locking.
+ *      (4) Painting is done with pixTilingPaintTile(), so the result must
+ *          have the size of the tile, unless pixTilingNoStripOnPaint()
+ *          has been called.  Tiles in different rows never share a word
+ *          of pixd.  Tiles in the same row can, when the depth is less
+ *          than 32, so the painting is serialized within each row.
+ *      (5) If pixd is null, nothing is painted.  Use this when func
+ *          saves its results in @data.
+ */
+l_int32
+pixTilingProcess(PIXTILING  *pt,
+                 PIX        *pixd,
+                 PIX      *(*func)(PIX *, l_int32, l_int32, void *),
+                 void       *data,
+                 l_int32     nthreads)
+{
+l_int32              i, nx, ny, ret;
+TILING_PROCESS_JOB   job;
+
+    PROCNAME("pixTilingProcess");
+
+    if (!pt)
+        return ERROR_INT("pt not defined", procName, 1);
+    if (!func)
+        return ERROR_INT("func not defined", procName, 1);
+
+    pixTilingGetCount(pt, &nx, &ny);
+    job.pt = pt;
+    job.pixd = pixd;
+    job.func = func;
+    job.data = data;
+    if ((job.rowlocks = (L_MUTEX **)LEPT_CALLOC(ny, sizeof(L_MUTEX *)))
+        == NULL)
+        return ERROR_INT("rowlocks not made", procName, 1);
+    for (i = 0; i < ny; i++)
+        job.rowlocks[i] = l_mutexCreate();
+
+    ret = l_parallelRun(nx * ny, nthreads, pixTilingProcessTask, &job);
+
+    for (i = 0; i < ny; i++)
+        l_mutexDestroy(&job.rowlocks[i]);
+    LEPT_FREE(job.rowlocks);
+    if (ret)
+        return ERROR_INT("not all tiles processed", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  pixTilingProcessTask()
+ *
+ *      Input:  data (TILING_PROCESS_JOB)
+ *              index (tile index, in raster order)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+pixTilingProcessTask(void    *data,
+                     l_int32  index)
+{
+l_int32              i, j, nx, ret;
+PIX                 *pixt, *pixr;
+TILING_PROCESS_JOB  *job;
+
+    PROCNAME("pixTilingProcessTask");
+
+    job = (TILING_PROCESS_JOB *)data;
+    nx = job->pt->nx;
+    i = index / nx;
+    j = index % nx;
+    if ((pixt = pixTilingGetTile(job->pt, i, j)) == NULL)
+        return ERROR_INT("tile not made", procName, 1);
+    pixr = (*job->func)(pixt, i, j, job->data);
+    pixDestroy(&pixt);
+    if (!pixr)
+        return ERROR_INT("tile not processed", procName, 1);
+
+    ret = 0;
+    if (job->pixd) {
+        l_mutexLock(job->rowlocks[i]);
+        ret = pixTilingPaintTile(job->pixd, i, j, pixr, job->pt);
+        l_mutexUnlock(job->rowlocks[i]);
+    }
+    pixDestroy(&pixr);
+    return ret;
+}
@@ -48,6 +48,14 @@
  *          PIX        *pixReadMemPng()
  *          l_int32     pixWriteMemPng()
  *
+ *    Band reading and writing (see bandio.c)
+ *          l_int32     pngBandReaderOpen()
+ *          l_int32     pngBandReaderRead()
+ *          void        pngBandReaderClose()
+ *          l_int32     pngBandWriterOpen()
+ *          l_int32     pngBandWriterWrite()
+ *          l_int32     pngBandWriterClose()
+ *
  *    Documentation: libpng.txt and example.c
  *
  *    On input (decompression from file), palette color images
@@ -125,6 +133,28 @@
 static l_int32   var_PNG_STRIP_16_TO_8 = 1;
 
 
+    /* Decoder and encoder state that is kept between band reads
+     * and writes.  These are held in the codec field of the
+     * L_BANDREADER and L_BANDWRITER. */
+struct png_band_reader {
+    png_structp   png_ptr;
+    png_infop     info_ptr;
+    png_bytep     rowbuf;      /* one decoded row                    */
+    png_uint_32   rowbytes;
+    l_int32       channels;    /* samples/pixel in the png           */
+    l_int32       invert;      /* 1 bpp without colormap             */
+};
+
+struct png_band_writer {
+    png_structp   png_ptr;
+    png_infop     info_ptr;
+    png_bytep     rowbuf;      /* one row to be encoded              */
+    png_uint_32   rowbytes;
+    png_colorp    palette;
+    l_int32       spp;         /* samples/pixel written for 32 bpp   */
+    l_int32       invert;      /* 1 bpp without colormap             */
+};
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_READ     0
 #define  DEBUG_WRITE    0
@@ -1340,6 +1370,419 @@ FILE    *fp;
     return ret;
 }
 
+
+/*---------------------------------------------------------------------*
+ *                     Band reading and writing                        *
+ *---------------------------------------------------------------------*/
+/*!
+ *  pngBandReaderOpen()
+ *
+ *      Input:  br (band reader, with the stream at the start of the file)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandReaderCreate().  It reads the png
+ *          header and sets the image parameters in @br.
+ *      (2) The decoded rows are the same as in pixReadStreamPng(),
+ *          including the stripping of 16 bit samples and the
+ *          inversion of 1 bpp images without a colormap.  For 1 bpp
+ *          with a colormap, the colormap is removed from each band
+ *          by the caller.
+ *      (3) Interlaced images and images with a tRNS chunk are not
+ *          supported; they must be read with pixRead().
+ */
+l_int32
+pngBandReaderOpen(L_BANDREADER  *br)
+{
+l_int32                  cindex, d;
+int                      num_palette;
+png_byte                 bit_depth, color_type, channels;
+png_uint_32              xres, yres;
+png_colorp               palette;
+PIXCMAP                 *cmap;
+struct png_band_reader  *pbr;
+
+    PROCNAME("pngBandReaderOpen");
+
+    if (!br || !br->fp)
+        return ERROR_INT("br or stream not defined", procName, 1);
+
+    if ((pbr = (struct png_band_reader *)LEPT_CALLOC(1,
+               sizeof(struct png_band_reader))) == NULL)
+        return ERROR_INT("pbr not made", procName, 1);
+    br->codec = (void *)pbr;
+    if ((pbr->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+                   (png_voidp)NULL, NULL, NULL)) == NULL)
+        return ERROR_INT("png_ptr not made", procName, 1);
+    if ((pbr->info_ptr = png_create_info_struct(pbr->png_ptr)) == NULL)
+        return ERROR_INT("info_ptr not made", procName, 1);
+    if (setjmp(png_jmpbuf(pbr->png_ptr)))
+        return ERROR_INT("internal png error", procName, 1);
+
+    png_init_io(pbr->png_ptr, br->fp);
+    png_read_info(pbr->png_ptr, pbr->info_ptr);
+    if (png_get_interlace_type(pbr->png_ptr, pbr->info_ptr) !=
+        PNG_INTERLACE_NONE)
+        return ERROR_INT("interlaced png; use pixRead()", procName, 1);
+    if (png_get_valid(pbr->png_ptr, pbr->info_ptr, PNG_INFO_tRNS))
+        return ERROR_INT("png with tRNS; use pixRead()", procName, 1);
+    if (var_PNG_STRIP_16_TO_8 == 1)
+        png_set_strip_16(pbr->png_ptr);
+    png_read_update_info(pbr->png_ptr, pbr->info_ptr);
+
+    bit_depth = png_get_bit_depth(pbr->png_ptr, pbr->info_ptr);
+    color_type = png_get_color_type(pbr->png_ptr, pbr->info_ptr);
+    channels = png_get_channels(pbr->png_ptr, pbr->info_ptr);
+    if (channels > 1 && bit_depth != 8)
+        return ERROR_INT("color with bit_depth != 8 not supported",
+                         procName, 1);
+    d = (channels == 1) ? bit_depth : 32;
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE ||
+        color_type == PNG_COLOR_MASK_PALETTE) {
+        png_get_PLTE(pbr->png_ptr, pbr->info_ptr, &palette, &num_palette);
+        cmap = pixcmapCreate(d);
+        for (cindex = 0; cindex < num_palette; cindex++)
+            pixcmapAddColor(cmap, palette[cindex].red, palette[cindex].green,
+                            palette[cindex].blue);
+        br->cmap = cmap;
+    }
+
+    pbr->channels = channels;
+    pbr->rowbytes = png_get_rowbytes(pbr->png_ptr, pbr->info_ptr);
+    if ((pbr->rowbuf = (png_bytep)LEPT_CALLOC(pbr->rowbytes, 1)) == NULL)
+        return ERROR_INT("rowbuf not made", procName, 1);
+    if (d == 1) {
+        if (br->cmap)
+            br->removecmap = 1;
+        else
+            pbr->invert = 1;
+    }
+
+    br->w = png_get_image_width(pbr->png_ptr, pbr->info_ptr);
+    br->h = png_get_image_height(pbr->png_ptr, pbr->info_ptr);
+    br->d = d;
+    br->spp = (channels == 1 || channels == 3) ? channels : 4;
+    xres = png_get_x_pixels_per_meter(pbr->png_ptr, pbr->info_ptr);
+    yres = png_get_y_pixels_per_meter(pbr->png_ptr, pbr->info_ptr);
+    br->xres = (l_int32)((l_float32)xres / 39.37 + 0.5);  /* to ppi */
+    br->yres = (l_int32)((l_float32)yres / 39.37 + 0.5);  /* to ppi */
+    return 0;
+}
+
+
+/*!
+ *  pngBandReaderRead()
+ *
+ *      Input:  br
+ *              pixd (band to receive the rows)
+ *              y (first row in pixd to be written)
+ *              nrows (number of rows to decode)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+pngBandReaderRead(L_BANDREADER  *br,
+                  PIX           *pixd,
+                  l_int32        y,
+                  l_int32        nrows)
+{
+l_int32                  i, j, k, w, wpl, channels;
+l_uint32                *data, *line, *ppixel;
+png_bytep                rowptr;
+struct png_band_reader  *pbr;
+
+    PROCNAME("pngBandReaderRead");
+
+    if (!br || !br->codec)
+        return ERROR_INT("br or codec not defined", procName, 1);
+    if (!pixd)
+        return ERROR_INT("pixd not defined", procName, 1);
+
+    pbr = (struct png_band_reader *)br->codec;
+    if (setjmp(png_jmpbuf(pbr->png_ptr)))
+        return ERROR_INT("internal png error", procName, 1);
+
+    w = br->w;
+    channels = pbr->channels;
+    rowptr = pbr->rowbuf;
+    wpl = pixGetWpl(pixd);
+    data = pixGetData(pixd);
+    for (i = 0; i < nrows; i++) {
+        png_read_row(pbr->png_ptr, rowptr, NULL);
+        line = data + (y + i) * wpl;
+        if (channels == 1) {
+            for (j = 0; j < pbr->rowbytes; j++)
+                SET_DATA_BYTE(line, j, rowptr[j]);
+        } else if (channels == 2) {  /* gray + alpha ==> RGBA */
+            for (j = k = 0, ppixel = line; j < w; j++, ppixel++) {
+                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k]);
+                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k]);
+                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
+                SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
+            }
+        } else {  /* rgb or rgba */
+            for (j = k = 0, ppixel = line; j < w; j++, ppixel++) {
+                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k++]);
+                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k++]);
+                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
+                if (channels == 4)
+                    SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
+            }
+        }
+    }
+
+        /* png stores black pixels as 0 */
+    if (pbr->invert)
+        pixRasterop(pixd, 0, y, w, nrows, PIX_NOT(PIX_DST), NULL, 0, 0);
+    return 0;
+}
+
+
+/*!
+ *  pngBandReaderClose()
+ *
+ *      Input:  br
+ *      Return: void
+ */
+void
+pngBandReaderClose(L_BANDREADER  *br)
+{
+struct png_band_reader  *pbr;
+
+    if (!br || !br->codec)
+        return;
+
+    pbr = (struct png_band_reader *)br->codec;
+    if (pbr->png_ptr)
+        png_destroy_read_struct(&pbr->png_ptr,
+                                pbr->info_ptr ? &pbr->info_ptr : NULL, NULL);
+    LEPT_FREE(pbr->rowbuf);
+    LEPT_FREE(pbr);
+    br->codec = NULL;
+    return;
+}
+
+
+/*!
+ *  pngBandWriterOpen()
+ *
+ *      Input:  bw (band writer)
+ *              pixs (first band of the image)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandWriterWrite() for the first band.
+ *          It writes the png header, using the height in @bw and the
+ *          width, depth, colormap, resolution, text and zlib
+ *          compression level of @pixs, as pixWriteStreamPng() does.
+ */
+l_int32
+pngBandWriterOpen(L_BANDWRITER  *bw,
+                  PIX           *pixs)
+{
+char                     commentstring[] = "Comment";
+l_int32                  i, w, d, spp, cmflag, opaque, ncolors, compval;
+l_int32                 *rmap, *gmap, *bmap, *amap;
+png_byte                 bit_depth, color_type;
+png_byte                 alpha[256];
+png_uint_32              xres, yres;
+PIXCMAP                 *cmap;
+char                    *text;
+struct png_band_writer  *pbw;
+
+    PROCNAME("pngBandWriterOpen");
+
+    if (!bw || !bw->fp)
+        return ERROR_INT("bw or stream not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    if ((pbw = (struct png_band_writer *)LEPT_CALLOC(1,
+               sizeof(struct png_band_writer))) == NULL)
+        return ERROR_INT("pbw not made", procName, 1);
+    bw->codec = (void *)pbw;
+    if ((pbw->png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+                   (png_voidp)NULL, NULL, NULL)) == NULL)
+        return ERROR_INT("png_ptr not made", procName, 1);
+    if ((pbw->info_ptr = png_create_info_struct(pbw->png_ptr)) == NULL)
+        return ERROR_INT("info_ptr not made", procName, 1);
+    if (setjmp(png_jmpbuf(pbw->png_ptr)))
+        return ERROR_INT("internal png error", procName, 1);
+
+    png_init_io(pbw->png_ptr, bw->fp);
+    compval = Z_DEFAULT_COMPRESSION;
+    if (pixs->special >= 10 && pixs->special < 20)
+        compval = pixs->special - 10;
+    png_set_compression_level(pbw->png_ptr, compval);
+
+    w = pixGetWidth(pixs);
+    d = pixGetDepth(pixs);
+    spp = pixGetSpp(pixs);
+    cmap = pixGetColormap(pixs);
+    cmflag = (cmap) ? 1 : 0;
+    if (d == 32) {
+        bit_depth = 8;
+        color_type = (spp == 4) ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB;
+        cmflag = 0;  /* ignore if it exists */
+        pbw->spp = (spp == 4) ? 4 : 3;
+        pbw->rowbytes = pbw->spp * w;
+    } else {
+        bit_depth = d;
+        color_type = (cmflag) ? PNG_COLOR_TYPE_PALETTE : PNG_COLOR_TYPE_GRAY;
+        pbw->rowbytes = (w * d + 7) / 8;
+        pbw->invert = (d == 1 && !cmap);
+    }
+    png_set_IHDR(pbw->png_ptr, pbw->info_ptr, w, bw->h, bit_depth,
+                 color_type, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
+                 PNG_FILTER_TYPE_BASE);
+
+    xres = (png_uint_32)(39.37 * (l_float32)pixGetXRes(pixs) + 0.5);
+    yres = (png_uint_32)(39.37 * (l_float32)pixGetYRes(pixs) + 0.5);
+    if ((xres == 0) || (yres == 0))
+        png_set_pHYs(pbw->png_ptr, pbw->info_ptr, 0, 0,
+                     PNG_RESOLUTION_UNKNOWN);
+    else
+        png_set_pHYs(pbw->png_ptr, pbw->info_ptr, xres, yres,
+                     PNG_RESOLUTION_METER);
+
+    if (cmflag) {
+        pixcmapToArrays(cmap, &rmap, &gmap, &bmap, &amap);
+        ncolors = pixcmapGetCount(cmap);
+        pixcmapIsOpaque(cmap, &opaque);
+        if ((pbw->palette = (png_colorp)LEPT_CALLOC(ncolors,
+                                                    sizeof(png_color))) == NULL)
+            return ERROR_INT("palette not made", procName, 1);
+        for (i = 0; i < ncolors; i++) {
+            pbw->palette[i].red = (png_byte)rmap[i];
+            pbw->palette[i].green = (png_byte)gmap[i];
+            pbw->palette[i].blue = (png_byte)bmap[i];
+            alpha[i] = (png_byte)amap[i];
+        }
+        png_set_PLTE(pbw->png_ptr, pbw->info_ptr, pbw->palette, (int)ncolors);
+        if (!opaque)
+            png_set_tRNS(pbw->png_ptr, pbw->info_ptr, (png_bytep)alpha,
+                         (int)ncolors, NULL);
+        LEPT_FREE(rmap);
+        LEPT_FREE(gmap);
+        LEPT_FREE(bmap);
+        LEPT_FREE(amap);
+    }
+
+    if ((text = pixGetText(pixs))) {
+        png_text text_chunk;
+        text_chunk.compression = PNG_TEXT_COMPRESSION_NONE;
+        text_chunk.key = commentstring;
+        text_chunk.text = text;
+        text_chunk.text_length = strlen(text);
+#ifdef PNG_ITXT_SUPPORTED
+        text_chunk.itxt_length = 0;
+        text_chunk.lang = NULL;
+        text_chunk.lang_key = NULL;
+#endif
+        png_set_text(pbw->png_ptr, pbw->info_ptr, &text_chunk, 1);
+    }
+    png_write_info(pbw->png_ptr, pbw->info_ptr);
+
+    if ((pbw->rowbuf = (png_bytep)LEPT_CALLOC(pbw->rowbytes, 1)) == NULL)
+        return ERROR_INT("rowbuf not made", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  pngBandWriterWrite()
+ *
+ *      Input:  bw
+ *              pixs (band to be encoded)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+pngBandWriterWrite(L_BANDWRITER  *bw,
+                   PIX           *pixs)
+{
+l_int32                  i, j, k, w, h, wpl;
+l_uint32                *data, *line, *ppixel;
+png_bytep                rowbuf;
+struct png_band_writer  *pbw;
+
+    PROCNAME("pngBandWriterWrite");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    pbw = (struct png_band_writer *)bw->codec;
+    if (setjmp(png_jmpbuf(pbw->png_ptr)))
+        return ERROR_INT("internal png error", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    rowbuf = pbw->rowbuf;
+    wpl = pixGetWpl(pixs);
+    data = pixGetData(pixs);
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        if (bw->d != 32) {
+            for (j = 0; j < pbw->rowbytes; j++)
+                rowbuf[j] = GET_DATA_BYTE(line, j);
+            if (pbw->invert) {  /* png writes black as 0 */
+                for (j = 0; j < pbw->rowbytes; j++)
+                    rowbuf[j] = ~rowbuf[j];
+            }
+        } else {
+            for (j = k = 0, ppixel = line; j < w; j++, ppixel++) {
+                rowbuf[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
+                rowbuf[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
+                rowbuf[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
+                if (pbw->spp == 4)
+                    rowbuf[k++] = GET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL);
+            }
+        }
+        png_write_row(pbw->png_ptr, rowbuf);
+    }
+    return 0;
+}
+
+
+/*!
+ *  pngBandWriterClose()
+ *
+ *      Input:  bw
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) If all rows have been written, this finishes the png;
+ *          otherwise the encoder is abandoned.
+ */
+l_int32
+pngBandWriterClose(L_BANDWRITER  *bw)
+{
+l_int32                  ret;
+struct png_band_writer  *pbw;
+
+    PROCNAME("pngBandWriterClose");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+
+    pbw = (struct png_band_writer *)bw->codec;
+    ret = (bw->nwritten == bw->h) ? 0 : 1;
+    if (ret == 0 && pbw->png_ptr && pbw->info_ptr) {
+        if (setjmp(png_jmpbuf(pbw->png_ptr)))
+            ret = 1;
+        else
+            png_write_end(pbw->png_ptr, pbw->info_ptr);
+    }
+    if (pbw->png_ptr)
+        png_destroy_write_struct(&pbw->png_ptr,
+                                 pbw->info_ptr ? &pbw->info_ptr : NULL);
+    LEPT_FREE(pbw->rowbuf);
+    LEPT_FREE(pbw->palette);
+    LEPT_FREE(pbw);
+    bw->codec = NULL;
+    return ret;
+}
+
 /* --------------------------------------------*/
 #endif  /* HAVE_LIBPNG */
 /* --------------------------------------------*/
@@ -136,6 +136,50 @@ l_int32 pixWriteMemPng(l_uint8 **pdata, size_t *psize, PIX *pix,
     return ERROR_INT("function not present", "pixWriteMemPng", 1);
 }
 
+/* ----------------------------------------------------------------------*/
+
+l_int32 pngBandReaderOpen(L_BANDREADER *br)
+{
+    return ERROR_INT("function not present", "pngBandReaderOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pngBandReaderRead(L_BANDREADER *br, PIX *pixd, l_int32 y,
+                          l_int32 nrows)
+{
+    return ERROR_INT("function not present", "pngBandReaderRead", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+void pngBandReaderClose(L_BANDREADER *br)
+{
+    L_ERROR("function not present\n", "pngBandReaderClose");
+    return;
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pngBandWriterOpen(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "pngBandWriterOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pngBandWriterWrite(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "pngBandWriterWrite", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pngBandWriterClose(L_BANDWRITER *bw)
+{
+    return ERROR_INT("function not present", "pngBandWriterClose", 1);
+}
+
 /* --------------------------------------------*/
 #endif  /* !HAVE_LIBPNG */
 /* --------------------------------------------*/
@@ -456,7 +456,7 @@ PIX       *pixs;
         } else {  /* 32 bpp rgb */
             for (i = 0; i < h; i++) {
                 lines = datas + i * wpls;
-                for (j = 0; j < wpls; j++) {
+                for (j = 0; j < w; j++) {
                     pword = lines + j;
                     pel[0] = GET_DATA_BYTE(pword, COLOR_RED);
                     pel[1] = GET_DATA_BYTE(pword, COLOR_GREEN);
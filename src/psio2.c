@@ -61,6 +61,7 @@
  *          l_int32              convertG4ToPSEmbed()
  *          l_int32              convertG4ToPS()
  *          l_int32              convertG4ToPSString()
+ *          static l_int32       convertG4DataToPSString()
  *          char                *generateG4PS()
  *
  *     For multipage tiff images
@@ -107,6 +108,12 @@ static const l_int32  A4_WIDTH                = 595;   /* points */
 static const l_int32  A4_HEIGHT               = 842;   /* points */
 static const l_float32  DEFAULT_FILL_FRACTION = 0.95;
 
+static l_int32  convertG4DataToPSString(L_COMP_DATA *cid, const char *title,
+                                        char **poutstr, l_int32 *pnbytes,
+                                        l_int32 x, l_int32 y, l_int32 res,
+                                        l_float32 scale, l_int32 pageno,
+                                        l_int32 maskflag, l_int32 endpage);
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_JPEG       0
 #define  DEBUG_G4         0
@@ -1181,8 +1188,6 @@ convertG4ToPSString(const char  *filein,
                     l_int32      maskflag,
                     l_int32      endpage)
 {
-char         *outstr;
-l_float32     xpt, ypt, wpt, hpt;
 L_COMP_DATA  *cid;
 
     PROCNAME("convertG4ToPSString");
@@ -1198,6 +1203,43 @@ L_COMP_DATA  *cid;
 
     if ((cid = l_generateG4Data(filein, 1)) == NULL)
         return ERROR_INT("g4 data not made", procName, 1);
+    return convertG4DataToPSString(cid, filein, poutstr, pnbytes, x, y, res,
+                                   scale, pageno, maskflag, endpage);
+}
+
+
+/*!
+ *  convertG4DataToPSString()
+ *
+ *      Input:  cid (g4 compressed image data, ascii85 encoded)
+ *              title (<optional> for the PS title; can be null)
+ *              &poutstr (<return> PS string)
+ *              &nbytes (<return> number of bytes in PS string)
+ *              x, y, res, scale, pageno, maskflag, endpage
+ *                  (see convertG4ToPSString())
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The cid is absorbed; it is destroyed by this function.
+ *      (2) This lets the g4 data come from a file or from memory.
+ */
+static l_int32
+convertG4DataToPSString(L_COMP_DATA  *cid,
+                        const char   *title,
+                        char        **poutstr,
+                        l_int32      *pnbytes,
+                        l_int32       x,
+                        l_int32       y,
+                        l_int32       res,
+                        l_float32     scale,
+                        l_int32       pageno,
+                        l_int32       maskflag,
+                        l_int32       endpage)
+{
+char       *outstr;
+l_float32   xpt, ypt, wpt, hpt;
+
+    PROCNAME("convertG4DataToPSString");
 
         /* Get scaled location in pts.  Guess the input scan resolution
          * based on the input parameter @res, the resolution data in
@@ -1232,13 +1274,13 @@ L_COMP_DATA  *cid;
 #endif   /* DEBUG_G4 */
 
         /* Generate the PS */
-    outstr = generateG4PS(filein, cid, xpt, ypt, wpt, hpt,
+    outstr = generateG4PS(title, cid, xpt, ypt, wpt, hpt,
                           maskflag, pageno, endpage);
+    l_CIDataDestroy(&cid);
     if (!outstr)
         return ERROR_INT("outstr not made", procName, 1);
     *poutstr = outstr;
     *pnbytes = strlen(outstr);
-    l_CIDataDestroy(&cid);
     return 0;
 }
 
@@ -1382,8 +1424,7 @@ SARRAY  *sa;
  *
  *      Input:  filein (input tiff multipage file)
  *              fileout (output ps file)
- *              tempfile (<optional> for temporary g4 tiffs;
- *                        use NULL for default)
+ *              tempfile (not used; use NULL)
  *              factor (for filling 8.5 x 11 inch page;
  *                      use 0.0 for DEFAULT_FILL_FRACTION)
  *      Return: 0 if OK, 1 on error
@@ -1394,6 +1435,8 @@ SARRAY  *sa;
  *      (2) If the images are generated from a standard resolution fax,
  *          the vertical resolution is doubled to give a normal-looking
  *          aspect ratio.
+ *      (3) Each page is g4 compressed in memory, so no temporary
+ *          files are written.  @tempfile is kept for compatibility.
  */
 l_int32
 convertTiffMultipageToPS(const char  *filein,
@@ -1401,12 +1444,12 @@ convertTiffMultipageToPS(const char  *filein,
                          const char  *tempfile,
                          l_float32    fillfract)
 {
-const char   tempdefault[] = "/tmp/junk_temp_g4.tif";
-const char  *tempname;
-l_int32      i, npages, w, h, istiff;
-l_float32    scale;
-PIX         *pix, *pixs;
-FILE        *fp;
+char         *outstr;
+l_int32       i, npages, w, h, istiff, nbytes, ret;
+l_float32     scale;
+L_COMP_DATA  *cid;
+PIX          *pix, *pixs;
+FILE         *fp;
 
     PROCNAME("convertTiffMultipageToPS");
 
@@ -1425,11 +1468,6 @@ FILE        *fp;
     tiffGetCount(fp, &npages);
     fclose(fp);
 
-    if (tempfile)
-        tempname = tempfile;
-    else
-        tempname = tempdefault;
-
     if (fillfract == 0.0)
         fillfract = DEFAULT_FILL_FRACTION;
 
@@ -1444,16 +1482,19 @@ FILE        *fp;
         else
             pixs = pixClone(pix);
 
-        pixWrite(tempname, pixs, IFF_TIFF_G4);
-        scale = L_MIN(fillfract * 2550 / w, fillfract * 3300 / h);
-        if (i == 0)
-            convertG4ToPS(tempname, fileout, "w", 0, 0, 300, scale,
-                          i + 1, FALSE, TRUE);
-        else
-            convertG4ToPS(tempname, fileout, "a", 0, 0, 300, scale,
-                          i + 1, FALSE, TRUE);
+        ret = pixGenerateCIData(pixs, L_G4_ENCODE, 0, 1, &cid);
         pixDestroy(&pix);
         pixDestroy(&pixs);
+        if (ret)
+            return ERROR_INT("g4 data not made", procName, 1);
+        scale = L_MIN(fillfract * 2550 / w, fillfract * 3300 / h);
+        if (convertG4DataToPSString(cid, filein, &outstr, &nbytes, 0, 0, 300,
+                                    scale, i + 1, FALSE, TRUE))
+            return ERROR_INT("ps string not made", procName, 1);
+        ret = l_binaryWrite(fileout, (i == 0) ? "w" : "a", outstr, nbytes);
+        LEPT_FREE(outstr);
+        if (ret)
+            return ERROR_INT("ps string not written to file", procName, 1);
     }
 
     return 0;
@@ -193,8 +193,8 @@ PTA  *pta;
     if ((pta = *ppta) == NULL)
         return;
 
-    ptaChangeRefcount(pta, -1);
-    if (ptaGetRefcount(pta) <= 0) {
+        /* Decrement the ref count.  If it is 0, destroy the pta. */
+    if (--pta->refcount <= 0) {
         LEPT_FREE(pta->x);
         LEPT_FREE(pta->y);
         LEPT_FREE(pta);
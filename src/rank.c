@@ -38,6 +38,14 @@
  *      Rank filter (accelerated with downscaling)
  *          PIX      *pixRankFilterWithScaling()
  *
+ *      Static helpers for the constant-time rank filter
+ *          static PIX      *rankFilterGrayCT()
+ *          static l_int32   rankFilterStrip()
+ *          static void      rankFilterRow()
+ *          static void      rankFilterRowSse2()
+ *          static void      rankFilterRowAvx2()
+ *          static void      rankFilterRowNeon()
+ *
  *  What is a brick rank filter?
  *
  *    A brick rank order filter evaluates, for every pixel in the image,
@@ -105,18 +113,95 @@
  *
  *  If someone has a better method, please let me know!
  *
+ *    Perreault and Hebert did, in "Median Filtering in Constant Time",
+ *    IEEE Trans. Image Processing, 16(9), 2007.
+ *
+ *      * Keep a coarse and fine histogram for each column of the image,
+ *        over the hf lines of the filter.  Moving the filter down by
+ *        one line changes each column histogram by one pixel removed
+ *        and one added.
+ *
+ *      * The histogram of the filter is the sum of wf column histograms.
+ *        Moving the filter right by one pixel adds one column histogram
+ *        and subtracts another.  This is done on the 16 coarse bins
+ *        with a few vector instructions.
+ *
+ *      * The fine histogram of the filter is only needed for the coarse
+ *        bin that holds the rank value.  Each of the 16 sections of
+ *        the fine histogram is brought up to date when it is needed,
+ *        from the last position at which it was used.  Because the
+ *        image is locally smooth, this is usually a short distance.
+ *
+ *    The cost per pixel is then independent of the filter size.  This
+ *    method is used in pixRankFilterGray() for filters with between 49
+ *    and 65535 pixels.  Smaller filters are faster with the coarse and
+ *    fine histograms alone, and larger ones would overflow the 16-bit
+ *    histogram counts.
+ *    The image can be divided into horizontal strips that are filtered
+ *    in parallel, using the number of threads set by
+ *    l_setParallelThreads().
+ *
  *  The rank filtering operation is relatively expensive, compared to most
- *  of the other imaging operations.  The speed is only weakly dependent
- *  on the size of the rank filter.  On standard hardware, it runs at
- *  about 10 Mpix/sec for a 50 x 50 filter, and 25 Mpix/sec for
- *  a 5 x 5 filter.   For applications where the rank filter can be
+ *  of the other imaging operations.  With the coarse and fine histograms
+ *  alone, the speed is only weakly dependent on the size of the rank
+ *  filter.  On standard hardware, it runs at about 10 Mpix/sec for
+ *  a 50 x 50 filter, and 25 Mpix/sec for a 5 x 5 filter.  The column
+ *  histograms make it independent of the filter size.  For applications
+ *  where the rank filter can be
  *  performed on a downscaled image, significant speedup can be
  *  achieved because the time goes as the square of the scaling factor.
  *  We provide an interface that handles the details, and only
  *  requires the amount of downscaling to be input.
  */
 
+#include <string.h>
 #include "allheaders.h"
+#include "simd.h"
+
+    /* Input and output for filtering one strip of lines */
+struct RankFilterParams
+{
+    PIX       *pixt;      /* image with mirrored border                  */
+    PIX       *pixd;      /* <return> filtered image                     */
+    l_int32    wf, hf;    /* filter size                                 */
+    l_int32    rankloc;   /* number of pixels below the rank value       */
+    l_int32    nstrips;   /* number of strips                            */
+};
+typedef struct RankFilterParams  RANK_FILTER_PARAMS;
+
+static PIX *rankFilterGrayCT(PIX *pixt, PIX *pixs, l_int32 wf, l_int32 hf,
+                             l_int32 rankloc);
+static l_int32 rankFilterStrip(void *data, l_int32 index);
+static void rankFilterRow(l_uint32 *lined, l_int32 w, l_int32 wf,
+                          l_int32 rankloc, l_uint16 *colc, l_uint16 *colf,
+                          l_uint16 *hc, l_uint16 *hf, l_int32 *luc);
+#if L_HAVE_SSE2
+static void rankFilterRowSse2(l_uint32 *lined, l_int32 w, l_int32 wf,
+                              l_int32 rankloc, l_uint16 *colc,
+                              l_uint16 *colf, l_uint16 *hc, l_uint16 *hf,
+                              l_int32 *luc);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static void rankFilterRowAvx2(l_uint32 *lined, l_int32 w, l_int32 wf,
+                              l_int32 rankloc, l_uint16 *colc,
+                              l_uint16 *colf, l_uint16 *hc, l_uint16 *hf,
+                              l_int32 *luc) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static void rankFilterRowNeon(l_uint32 *lined, l_int32 w, l_int32 wf,
+                              l_int32 rankloc, l_uint16 *colc,
+                              l_uint16 *colf, l_uint16 *hc, l_uint16 *hf,
+                              l_int32 *luc);
+#endif  /* L_HAVE_NEON */
+
+    /* Range of number of pixels in the filter for the constant-time
+     * method.  Smaller filters are faster with the older method, and
+     * larger ones would overflow the 16-bit histogram counts. */
+static const l_int32  MinFilterSizeCT = 49;
+static const l_int32  MaxFilterSizeCT = 65535;
+
+    /* Min number of lines in each strip, when done in parallel */
+static const l_int32  MinRankStripHeight = 32;
 
 /*----------------------------------------------------------------------*
  *                           Rank order filter                          *
@@ -252,8 +337,15 @@ PIX  *pixr, *pixg, *pixb, *pixrf, *pixgf, *pixbf, *pixd;
  *      (4) This dispatches to grayscale erosion or dilation if the
  *          filter dimensions are odd and the rank is 0.0 or 1.0, rsp.
  *      (5) Returns a copy if both wf and hf are 1.
- *      (6) Uses row-major or column-major incremental updates to the
- *          histograms depending on whether hf > wf or hv <= wf, rsp.
+ *      (6) For filters with 49 to 65535 pixels, this uses the
+ *          constant-time method with column histograms; see the
+ *          top of this file.  The histogram sums use the vector
+ *          instruction set selected in simd.c, and the image is done
+ *          in strips in parallel if l_setParallelThreads() has been
+ *          used to set more than one thread.
+ *      (7) Otherwise it uses row-major or column-major incremental
+ *          updates to the histograms depending on whether hf > wf
+ *          or hv <= wf, rsp.
  */
 PIX  *
 pixRankFilterGray(PIX       *pixs,
@@ -304,10 +396,18 @@ PIX       *pixt, *pixd;
         == NULL)
         return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
 
+    rankloc = (l_int32)(rank * wf * hf);
+    if (wf * hf >= MinFilterSizeCT && wf * hf <= MaxFilterSizeCT) {
+        pixd = rankFilterGrayCT(pixt, pixs, wf, hf, rankloc);
+        pixDestroy(&pixt);
+        if (!pixd)
+            return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+        return pixd;
+    }
+
         /* Set up the two histogram arrays. */
     histo = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
     histo16 = (l_int32 *)LEPT_CALLOC(16, sizeof(l_int32));
-    rankloc = (l_int32)(rank * wf * hf);
 
         /* Place the filter center at (0, 0).  This is just a
          * convenient location, because it allows us to perform
@@ -518,3 +618,365 @@ PIX     *pix1, *pix2, *pixd;
     pixDestroy(&pix2);
     return pixd;
 }
+
+
+/*----------------------------------------------------------------------*
+ *                   Constant-time rank order filter                    *
+ *----------------------------------------------------------------------*/
+/*!
+ *  rankFilterGrayCT()
+ *
+ *      Input:  pixt (pixs with mirrored border of wf/2 and hf/2)
+ *              pixs (8 bpp)
+ *              wf, hf  (width and height of filter)
+ *              rankloc (the output value is the smallest one for which
+ *                       more than rankloc pixels have a lower or equal
+ *                       value)
+ *      Return: pixd (of rank values), or null on error
+ *
+ *  Notes:
+ *      (1) The lines are divided into strips, which are filtered
+ *          independently; see rankFilterStrip().  There is only one
+ *          strip unless several threads are available.
+ */
+static PIX *
+rankFilterGrayCT(PIX     *pixt,
+                 PIX     *pixs,
+                 l_int32  wf,
+                 l_int32  hf,
+                 l_int32  rankloc)
+{
+l_int32             h, nstrips;
+PIX                *pixd;
+RANK_FILTER_PARAMS  params;
+
+    PROCNAME("rankFilterGrayCT");
+
+    if ((pixd = pixCreateTemplate(pixs)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    h = pixGetHeight(pixs);
+    nstrips = L_MIN(l_getParallelThreads(), h / MinRankStripHeight);
+    nstrips = L_MAX(1, nstrips);
+    params.pixt = pixt;
+    params.pixd = pixd;
+    params.wf = wf;
+    params.hf = hf;
+    params.rankloc = rankloc;
+    params.nstrips = nstrips;
+    if (l_parallelRun(nstrips, nstrips, rankFilterStrip, &params)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("strips not filtered", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*!
+ *  rankFilterStrip()
+ *
+ *      Input:  data (RANK_FILTER_PARAMS)
+ *              index (of strip)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) There is a 16-bin coarse and a 256-bin fine histogram for
+ *          each column of pixt.  They are initialized from the first hf
+ *          lines of pixt for the strip, and moved down one line for each
+ *          output line.
+ *      (2) Each output line is then found by rankFilterRow(), or its
+ *          vector version, from the column histograms.
+ */
+static l_int32
+rankFilterStrip(void     *data,
+                l_int32   index)
+{
+l_int32              i, j, k, w, h, wt, wplt, wpld, hfilt, y0, y1, val;
+l_int32              luc[16];
+l_uint16            *colc, *colf, *hc, *hf;
+l_uint32            *linet, *linet2, *lined;
+PIX                 *pixt, *pixd;
+RANK_FILTER_PARAMS  *params;
+
+    PROCNAME("rankFilterStrip");
+
+    params = (RANK_FILTER_PARAMS *)data;
+    pixt = params->pixt;
+    pixd = params->pixd;
+    hfilt = params->hf;
+    pixGetDimensions(pixd, &w, &h, NULL);
+    wt = pixGetWidth(pixt);
+    wplt = pixGetWpl(pixt);
+    wpld = pixGetWpl(pixd);
+    y0 = h * index / params->nstrips;
+    y1 = h * (index + 1) / params->nstrips;
+
+    colc = (l_uint16 *)LEPT_CALLOC(16 * wt, sizeof(l_uint16));
+    colf = (l_uint16 *)LEPT_CALLOC(256 * wt, sizeof(l_uint16));
+    hc = (l_uint16 *)LEPT_CALLOC(16, sizeof(l_uint16));
+    hf = (l_uint16 *)LEPT_CALLOC(256, sizeof(l_uint16));
+    if (!colc || !colf || !hc || !hf) {
+        LEPT_FREE(colc);
+        LEPT_FREE(colf);
+        LEPT_FREE(hc);
+        LEPT_FREE(hf);
+        return ERROR_INT("histograms not made", procName, 1);
+    }
+
+        /* Column histograms for the first output line of the strip */
+    for (k = 0; k < hfilt; k++) {
+        linet = pixGetData(pixt) + (y0 + k) * wplt;
+        for (j = 0; j < wt; j++) {
+            val = GET_DATA_BYTE(linet, j);
+            colc[16 * j + (val >> 4)]++;
+            colf[256 * j + val]++;
+        }
+    }
+
+    for (i = y0; i < y1; i++) {
+        if (i > y0) {  /* move the column histograms down one line */
+            linet = pixGetData(pixt) + (i - 1) * wplt;
+            linet2 = pixGetData(pixt) + (i + hfilt - 1) * wplt;
+            for (j = 0; j < wt; j++) {
+                val = GET_DATA_BYTE(linet, j);
+                colc[16 * j + (val >> 4)]--;
+                colf[256 * j + val]--;
+                val = GET_DATA_BYTE(linet2, j);
+                colc[16 * j + (val >> 4)]++;
+                colf[256 * j + val]++;
+            }
+        }
+
+        lined = pixGetData(pixd) + i * wpld;
+        for (k = 0; k < 16; k++)
+            luc[k] = 0;
+        switch (l_getSimdMode())
+        {
+#if L_HAVE_AVX2
+        case L_SIMD_AVX2:
+            rankFilterRowAvx2(lined, w, params->wf, params->rankloc,
+                              colc, colf, hc, hf, luc);
+            break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+        case L_SIMD_SSE2:
+            rankFilterRowSse2(lined, w, params->wf, params->rankloc,
+                              colc, colf, hc, hf, luc);
+            break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+        case L_SIMD_NEON:
+            rankFilterRowNeon(lined, w, params->wf, params->rankloc,
+                              colc, colf, hc, hf, luc);
+            break;
+#endif  /* L_HAVE_NEON */
+        default:
+            rankFilterRow(lined, w, params->wf, params->rankloc,
+                          colc, colf, hc, hf, luc);
+            break;
+        }
+    }
+
+    LEPT_FREE(colc);
+    LEPT_FREE(colf);
+    LEPT_FREE(hc);
+    LEPT_FREE(hf);
+    return 0;
+}
+
+
+    /* The filter for one line.  hc is the coarse histogram of the
+     * filter, which is moved one column to the right for each pixel.
+     * Section b of the fine histogram hf holds the sum over columns
+     * (luc[b] - wf ... luc[b] - 1); it is only brought up to date for
+     * the coarse bin that holds the rank value.  HADD(h, a) adds the
+     * 16 counts in a to those in h, and HADDSUB(h, a, s) adds those
+     * in a and subtracts those in s. */
+#define RANK_FILTER_ROW_BODY                                             \
+    for (k = 0; k < 16; k++)                                             \
+        hc[k] = 0;                                                       \
+    for (j = 0; j < wf; j++)                                             \
+        HADD(hc, colc + 16 * j);                                         \
+    for (x = 0; x < w; x++) {                                            \
+        if (x > 0)                                                       \
+            HADDSUB(hc, colc + 16 * (x + wf - 1), colc + 16 * (x - 1));  \
+                                                                         \
+            /* Find the coarse bin */                                    \
+        sum = 0;                                                         \
+        for (b = 0; b < 16; b++) {                                       \
+            if (sum + hc[b] > rankloc)                                   \
+                break;                                                   \
+            sum += hc[b];                                                \
+        }                                                                \
+                                                                         \
+            /* Update that section of the fine histogram */              \
+        fine = hf + 16 * b;                                              \
+        if (luc[b] <= x) {  /* no overlap; start over */                 \
+            for (k = 0; k < 16; k++)                                     \
+                fine[k] = 0;                                             \
+            for (j = x; j < x + wf; j++)                                 \
+                HADD(fine, colf + 256 * j + 16 * b);                     \
+        } else {                                                         \
+            for (j = luc[b]; j < x + wf; j++)                            \
+                HADDSUB(fine, colf + 256 * j + 16 * b,                   \
+                        colf + 256 * (j - wf) + 16 * b);                 \
+        }                                                                \
+        luc[b] = x + wf;                                                 \
+                                                                         \
+            /* Find the value in the fine bins */                        \
+        for (k = 0; k < 15; k++) {                                       \
+            sum += fine[k];                                              \
+            if (sum > rankloc)                                           \
+                break;                                                   \
+        }                                                                \
+        SET_DATA_BYTE(lined, x, 16 * b + k);                             \
+    }
+
+
+/*!
+ *  rankFilterRow()
+ *
+ *      Input:  lined (output line)
+ *              w (width of output)
+ *              wf (width of filter)
+ *              rankloc (see rankFilterGrayCT())
+ *              colc, colf (coarse and fine histograms of each column)
+ *              hc, hf (coarse and fine histograms of the filter)
+ *              luc (for each coarse bin, the column just after the last
+ *                   one in that section of hf; set to 0 for a new line)
+ *      Return: void
+ */
+static void
+rankFilterRow(l_uint32  *lined,
+              l_int32    w,
+              l_int32    wf,
+              l_int32    rankloc,
+              l_uint16  *colc,
+              l_uint16  *colf,
+              l_uint16  *hc,
+              l_uint16  *hf,
+              l_int32   *luc)
+{
+l_int32    b, j, k, x, sum;
+l_uint16  *fine;
+
+#define HADD(h, a)                                                       \
+    { l_int32 n_; for (n_ = 0; n_ < 16; n_++) (h)[n_] += (a)[n_]; }
+#define HADDSUB(h, a, s)                                                 \
+    { l_int32 n_; for (n_ = 0; n_ < 16; n_++)                            \
+                      (h)[n_] += (a)[n_] - (s)[n_]; }
+    RANK_FILTER_ROW_BODY
+#undef HADD
+#undef HADDSUB
+}
+
+
+#if L_HAVE_SSE2
+/*!
+ *  rankFilterRowSse2()
+ *
+ *      Input:  see rankFilterRow()
+ *      Return: void
+ */
+static void
+rankFilterRowSse2(l_uint32  *lined,
+                  l_int32    w,
+                  l_int32    wf,
+                  l_int32    rankloc,
+                  l_uint16  *colc,
+                  l_uint16  *colf,
+                  l_uint16  *hc,
+                  l_uint16  *hf,
+                  l_int32   *luc)
+{
+l_int32    b, j, k, x, sum;
+l_uint16  *fine;
+
+#define LD(p)        _mm_loadu_si128((const __m128i *)(p))
+#define ST(p, v)     _mm_storeu_si128((__m128i *)(p), (v))
+#define HADD(h, a)                                                       \
+    { ST(h, _mm_add_epi16(LD(h), LD(a)));                                \
+      ST((h) + 8, _mm_add_epi16(LD((h) + 8), LD((a) + 8))); }
+#define HADDSUB(h, a, s)                                                 \
+    { ST(h, _mm_sub_epi16(_mm_add_epi16(LD(h), LD(a)), LD(s)));          \
+      ST((h) + 8, _mm_sub_epi16(_mm_add_epi16(LD((h) + 8), LD((a) + 8)), \
+                                LD((s) + 8))); }
+    RANK_FILTER_ROW_BODY
+#undef LD
+#undef ST
+#undef HADD
+#undef HADDSUB
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+/*!
+ *  rankFilterRowAvx2()
+ *
+ *      Input:  see rankFilterRow()
+ *      Return: void
+ */
+static void
+rankFilterRowAvx2(l_uint32  *lined,
+                  l_int32    w,
+                  l_int32    wf,
+                  l_int32    rankloc,
+                  l_uint16  *colc,
+                  l_uint16  *colf,
+                  l_uint16  *hc,
+                  l_uint16  *hf,
+                  l_int32   *luc)
+{
+l_int32    b, j, k, x, sum;
+l_uint16  *fine;
+
+#define LD(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define ST(p, v)     _mm256_storeu_si256((__m256i *)(p), (v))
+#define HADD(h, a)        ST(h, _mm256_add_epi16(LD(h), LD(a)))
+#define HADDSUB(h, a, s)                                                 \
+    ST(h, _mm256_sub_epi16(_mm256_add_epi16(LD(h), LD(a)), LD(s)))
+    RANK_FILTER_ROW_BODY
+#undef LD
+#undef ST
+#undef HADD
+#undef HADDSUB
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+/*!
+ *  rankFilterRowNeon()
+ *
+ *      Input:  see rankFilterRow()
+ *      Return: void
+ */
+static void
+rankFilterRowNeon(l_uint32  *lined,
+                  l_int32    w,
+                  l_int32    wf,
+                  l_int32    rankloc,
+                  l_uint16  *colc,
+                  l_uint16  *colf,
+                  l_uint16  *hc,
+                  l_uint16  *hf,
+                  l_int32   *luc)
+{
+l_int32    b, j, k, x, sum;
+l_uint16  *fine;
+
+#define HADD(h, a)                                                       \
+    { vst1q_u16(h, vaddq_u16(vld1q_u16(h), vld1q_u16(a)));               \
+      vst1q_u16((h) + 8, vaddq_u16(vld1q_u16((h) + 8),                   \
+                                   vld1q_u16((a) + 8))); }
+#define HADDSUB(h, a, s)                                                 \
+    { vst1q_u16(h, vsubq_u16(vaddq_u16(vld1q_u16(h), vld1q_u16(a)),      \
+                             vld1q_u16(s)));                             \
+      vst1q_u16((h) + 8, vsubq_u16(vaddq_u16(vld1q_u16((h) + 8),         \
+                                             vld1q_u16((a) + 8)),        \
+                                   vld1q_u16((s) + 8))); }
+    RANK_FILTER_ROW_BODY
+#undef HADD
+#undef HADDSUB
+}
+#endif  /* L_HAVE_NEON */
@@ -1092,13 +1092,13 @@ recogIdentifyPix(L_RECOG  *recog,
                  PIX     **ppixdb)
 {
 char      *text;
-l_int32    i, j, n, bestindex, bestsample, area1, area2;
-l_int32    shiftx, shifty, bestdelx, bestdely, bestwidth, maxyshift;
-l_float32  x1, y1, x2, y2, delx, dely, score, maxscore;
-NUMA      *numa;
+l_int32    i, j, n, bestindex, bestsample, area1;
+l_int32    bestdelx, bestdely, bestwidth, maxyshift;
+l_float32  x1, y1, delx, dely, shiftx, shifty, score, maxscore;
+NUMA      *numa, *nascore;
 PIX       *pix0, *pix1, *pix2;
 PIXA      *pixa;
-PTA       *pta;
+PTA       *pta, *pta1, *pta2, *ptashift;
 
     PROCNAME("recogIdentifyPix");
 
@@ -1126,28 +1126,26 @@ PTA       *pta;
     maxscore = 0.0;
     maxyshift = recog->maxyshift;
     if (recog->templ_type == L_USE_AVERAGE) {
+            /* Offsets (x1 - x2, y1 - y2) of the template centroids */
+        pta1 = ptaScale(recog->pta, -1.0, -1.0);
+        pta = ptaTranslate(pta1, x1, y1);
+        ptaDestroy(&pta1);
+        pixCorrelationScoreBatch(pix1, area1, recog->pixa, recog->nasum,
+                                 pta, maxyshift, 5, 5, &nascore, &ptashift);
         for (i = 0; i < recog->setsize; i++) {
-            numaGetIValue(recog->nasum, i, &area2);
-            if (area2 == 0) continue;  /* no template available */
-            pix2 = pixaGetPix(recog->pixa, i, L_CLONE);
-            ptaGetPt(recog->pta, i, &x2, &y2);
-            delx = x1 - x2;
-            dely = y1 - y2;
-            for (shifty = -maxyshift; shifty <= maxyshift; shifty++) {
-                for (shiftx = -maxyshift; shiftx <= maxyshift; shiftx++) {
-                    pixCorrelationScoreSimple(pix1, pix2, area1, area2,
-                                              delx + shiftx, dely + shifty,
-                                              5, 5, recog->sumtab, &score);
-                    if (score > maxscore) {
-                        bestindex = i;
-                        bestdelx = delx + shiftx;
-                        bestdely = dely + shifty;
-                        maxscore = score;
-                    }
-                }
+            numaGetFValue(nascore, i, &score);
+            if (score > maxscore) {
+                ptaGetPt(pta, i, &delx, &dely);
+                ptaGetPt(ptashift, i, &shiftx, &shifty);
+                bestindex = i;
+                bestdelx = delx + shiftx;
+                bestdely = dely + shifty;
+                maxscore = score;
             }
-            pixDestroy(&pix2);
         }
+        ptaDestroy(&pta);
+        numaDestroy(&nascore);
+        ptaDestroy(&ptashift);
     } else {  /* use all the samples */
         for (i = 0; i < recog->setsize; i++) {
             pixa = pixaaGetPixa(recog->pixaa, i, L_CLONE);
@@ -1157,33 +1155,31 @@ PTA       *pta;
                 continue;
             }
             numa = numaaGetNuma(recog->naasum, i, L_CLONE);
-            pta = ptaaGetPta(recog->ptaa, i, L_CLONE);
+            pta1 = ptaaGetPta(recog->ptaa, i, L_CLONE);
+            pta2 = ptaScale(pta1, -1.0, -1.0);
+            pta = ptaTranslate(pta2, x1, y1);
+            ptaDestroy(&pta2);
+            pixCorrelationScoreBatch(pix1, area1, pixa, numa, pta, maxyshift,
+                                     5, 5, &nascore, &ptashift);
             for (j = 0; j < n; j++) {
-                pix2 = pixaGetPix(pixa, j, L_CLONE);
-                numaGetIValue(numa, j, &area2);
-                ptaGetPt(pta, j, &x2, &y2);
-                delx = x1 - x2;
-                dely = y1 - y2;
-                for (shifty = -maxyshift; shifty <= maxyshift; shifty++) {
-                    for (shiftx = -maxyshift; shiftx <= maxyshift; shiftx++) {
-                        pixCorrelationScoreSimple(pix1, pix2, area1, area2,
-                                                  delx + shiftx, dely + shifty,
-                                                  5, 5, recog->sumtab, &score);
-                        if (score > maxscore) {
-                            bestindex = i;
-                            bestsample = j;
-                            bestdelx = delx + shiftx;
-                            bestdely = dely + shifty;
-                            maxscore = score;
-                            bestwidth = pixGetWidth(pix2);
-                        }
-                    }
+                numaGetFValue(nascore, j, &score);
+                if (score > maxscore) {
+                    ptaGetPt(pta, j, &delx, &dely);
+                    ptaGetPt(ptashift, j, &shiftx, &shifty);
+                    bestindex = i;
+                    bestsample = j;
+                    bestdelx = delx + shiftx;
+                    bestdely = dely + shifty;
+                    maxscore = score;
+                    pixaGetPixDimensions(pixa, j, &bestwidth, NULL, NULL);
                 }
-                pixDestroy(&pix2);
             }
             pixaDestroy(&pixa);
             numaDestroy(&numa);
+            ptaDestroy(&pta1);
             ptaDestroy(&pta);
+            numaDestroy(&nascore);
+            ptaDestroy(&ptashift);
         }
     }
 
@@ -845,12 +845,12 @@ recogRemoveOutliers(L_RECOG    *recog,
                     l_float32   minfract,
                     l_int32     debug)
 {
-l_int32    i, j, nremoved, n, nkeep, ngood, ival, area1, area2;
-l_float32  x1, y1, x2, y2, score, val;
+l_int32    i, j, nremoved, n, nkeep, ngood, ival, area1;
+l_float32  x1, y1, score, val;
 NUMA      *nasum, *nasum_u, *nascore, *nainvert, *nasort;
-PIX       *pix1, *pix2;
+PIX       *pix1;
 PIXA      *pixa, *pixa_u;
-PTA       *pta, *pta_u;
+PTA       *pta, *pta1, *pta2, *pta_u;
 
     PROCNAME("recogRemoveOutliers");
 
@@ -873,24 +873,25 @@ PTA       *pta, *pta_u;
         ptaGetPt(recog->pta, i, &x1, &y1);
         numaGetIValue(recog->nasum, i, &area1);
 
-            /* Get the sorted scores for each sample in the class */
+            /* Get the sorted scores for each sample in the class,
+             * at the offsets (x1 - x2, y1 - y2) of the sample centroids */
         pixa = pixaaGetPixa(recog->pixaa, i, L_CLONE);
         pta = ptaaGetPta(recog->ptaa, i, L_CLONE);
         nasum = numaaGetNuma(recog->naasum, i, L_CLONE);
         n = pixaGetCount(pixa);
-        nascore = numaCreate(n);
+        pta1 = ptaScale(pta, -1.0, -1.0);
+        pta2 = ptaTranslate(pta1, x1, y1);
+        pixCorrelationScoreBatch(pix1, area1, pixa, nasum, pta2, 0, 5, 5,
+                                 &nascore, NULL);
+        if (!nascore)
+            nascore = numaMakeConstant(0.0, n);
         for (j = 0; j < n; j++) {
-            pix2 = pixaGetPix(pixa, j, L_CLONE);
-            ptaGetPt(pta, j, &x2, &y2);
-            numaGetIValue(nasum, j, &area2);
-            pixCorrelationScoreSimple(pix1, pix2, area1, area2,
-                                      x1 - x2, y1 - y2, 5, 5,
-                                      recog->sumtab, &score);
-            numaAddNumber(nascore, score);
+            numaGetFValue(nascore, j, &score);
             if (score == 0.0)  /* typ. large size difference */
                 fprintf(stderr, "Got 0 score for i = %d, j = %d\n", i, j);
-            pixDestroy(&pix2);
         }
+        ptaDestroy(&pta1);
+        ptaDestroy(&pta2);
         pixDestroy(&pix1);
             /* Symbolically, na[i] = nasort[nainvert[i]]  */
         numaSortGeneral(nascore, &nasort, NULL, &nainvert,
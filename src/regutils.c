@@ -38,6 +38,9 @@
  *           l_int32    regTestCheckFile()
  *           l_int32    regTestCompareFiles()
  *           l_int32    regTestWritePixAndCheck()
+ *           l_int32    regTestCompareFPix()
+ *           l_int32    regTestCompareParallel()
+ *           PIX       *regTestMakeRandomPix()
  *
  *       Static function
  *           char      *getRootNameFromArgv0()
@@ -688,8 +691,9 @@ char   namebuf[256];
     snprintf(namebuf, sizeof(namebuf), "/tmp/lept/regout/%s.%02d.%s",
              rp->testname, rp->index + 1, ImageFileFormatExtensions[format]);
 
-        /* Write the local file */
-    if (pixGetDepth(pix) < 8)
+        /* Write the local file.  The pad bits of a view are pixels
+         * of its parent, and are not changed. */
+    if (pixGetDepth(pix) < 8 && !pixIsView(pix))
         pixSetPadBits(pix, 0);
     pixWrite(namebuf, pix, format);
 
@@ -701,6 +705,210 @@ char   namebuf[256];
 }
 
 
+/*!
+ *  regTestCompareFPix()
+ *
+ *      Input:  rp (regtest parameters)
+ *              fpix1, fpix2 (to be tested for equality)
+ *      Return: 0 if OK, 1 on error (a failure in comparison is not an error)
+ *
+ *  Notes:
+ *      (1) This function compares two fpix for equality of size and
+ *          of every pixel value.  On failure, this writes to stderr.
+ */
+l_int32
+regTestCompareFPix(L_REGPARAMS  *rp,
+                   FPIX         *fpix1,
+                   FPIX         *fpix2)
+{
+l_int32     i, j, w1, h1, w2, h2, wpl1, wpl2, same;
+l_float32  *line1, *line2;
+
+    PROCNAME("regTestCompareFPix");
+
+    if (!rp)
+        return ERROR_INT("rp not defined", procName, 1);
+    if (!fpix1 || !fpix2) {
+        rp->success = FALSE;
+        return ERROR_INT("fpix1 and fpix2 not both defined", procName, 1);
+    }
+
+    rp->index++;
+    fpixGetDimensions(fpix1, &w1, &h1);
+    fpixGetDimensions(fpix2, &w2, &h2);
+    same = (w1 == w2 && h1 == h2);
+    wpl1 = fpixGetWpl(fpix1);
+    wpl2 = fpixGetWpl(fpix2);
+    for (i = 0; same && i < h1; i++) {
+        line1 = fpixGetData(fpix1) + i * wpl1;
+        line2 = fpixGetData(fpix2) + i * wpl2;
+        for (j = 0; j < w1; j++) {
+            if (line1[j] != line2[j]) {
+                same = FALSE;
+                break;
+            }
+        }
+    }
+
+        /* Record on failure */
+    if (!same) {
+        if (rp->fp) {
+            fprintf(rp->fp,
+                    "Failure in %s_reg: fpix comparison for index %d\n",
+                    rp->testname, rp->index);
+        }
+        fprintf(stderr, "Failure in %s_reg: fpix comparison for index %d\n",
+                rp->testname, rp->index);
+        rp->success = FALSE;
+    }
+    return 0;
+}
+
+
+/*!
+ *  regTestCompareParallel()
+ *
+ *      Input:  rp (regtest parameters)
+ *              func (makes a pixa, and optionally an fpixa, from pixs)
+ *              pixs (input to @func)
+ *              data (<optional> passed to @func)
+ *              nthreads (number of threads for the comparisons)
+ *              &pixa (<optional return> the reference results)
+ *      Return: 0 if OK, 1 on error (a failure in comparison is not an error)
+ *
+ *  Notes:
+ *      (1) This tests that @func gives the same results on several
+ *          threads, and with each of the vector kernels, as on one
+ *          thread without them.  @func returns a pixa, and returns
+ *          either an fpixa or null through its last argument.
+ *      (2) The reference is made on one thread with L_SIMD_NONE.  Then
+ *          @func is run on @nthreads threads for each mode from
+ *          L_SIMD_NONE to L_SIMD_NEON, and the count and every pix
+ *          and fpix of the results are compared with the reference.
+ *          A mode that is not supported runs the portable code again,
+ *          so that the number of comparisons, and the index of any
+ *          golden file written after this, are the same on all machines.
+ *      (3) On return, the number of threads is restored and the
+ *          vector kernels are chosen automatically (L_SIMD_AUTO).
+ *      (4) The reference pixa can be returned, for writing golden files.
+ */
+l_int32
+regTestCompareParallel(L_REGPARAMS  *rp,
+                       PIXA       *(*func)(PIX *, void *, FPIXA **),
+                       PIX          *pixs,
+                       void         *data,
+                       l_int32       nthreads,
+                       PIXA        **ppixa)
+{
+l_int32  i, j, n, nf, nsave;
+FPIX    *fpix1, *fpix2;
+FPIXA   *fpixa1, *fpixa2;
+PIX     *pix1, *pix2;
+PIXA    *pixa1, *pixa2;
+
+    PROCNAME("regTestCompareParallel");
+
+    if (ppixa) *ppixa = NULL;
+    if (!rp)
+        return ERROR_INT("rp not defined", procName, 1);
+    if (!func || !pixs) {
+        rp->success = FALSE;
+        return ERROR_INT("func and pixs not both defined", procName, 1);
+    }
+
+        /* The reference, on one thread without vector kernels */
+    nsave = l_getParallelThreads();
+    l_setParallelThreads(1);
+    l_setSimdMode(L_SIMD_NONE);
+    fpixa1 = NULL;
+    pixa1 = func(pixs, data, &fpixa1);
+    n = pixaGetCount(pixa1);
+    nf = (fpixa1) ? fpixaGetCount(fpixa1) : 0;
+
+        /* On @nthreads threads, with each of the vector kernels */
+    l_setParallelThreads(nthreads);
+    for (i = L_SIMD_NONE; i <= L_SIMD_NEON; i++) {
+        l_setSimdMode(l_simdSupported(i) ? i : L_SIMD_NONE);
+        fpixa2 = NULL;
+        pixa2 = func(pixs, data, &fpixa2);
+        regTestCompareValues(rp, n, pixaGetCount(pixa2), 0.0);
+        for (j = 0; j < n && j < pixaGetCount(pixa2); j++) {
+            pix1 = pixaGetPix(pixa1, j, L_CLONE);
+            pix2 = pixaGetPix(pixa2, j, L_CLONE);
+            regTestComparePix(rp, pix1, pix2);
+            pixDestroy(&pix1);
+            pixDestroy(&pix2);
+        }
+        if (nf > 0) {
+            regTestCompareValues(rp, nf,
+                                 (fpixa2) ? fpixaGetCount(fpixa2) : 0, 0.0);
+            for (j = 0; fpixa2 && j < nf && j < fpixaGetCount(fpixa2); j++) {
+                fpix1 = fpixaGetFPix(fpixa1, j, L_CLONE);
+                fpix2 = fpixaGetFPix(fpixa2, j, L_CLONE);
+                regTestCompareFPix(rp, fpix1, fpix2);
+                fpixDestroy(&fpix1);
+                fpixDestroy(&fpix2);
+            }
+        }
+        pixaDestroy(&pixa2);
+        fpixaDestroy(&fpixa2);
+    }
+    l_setParallelThreads(nsave);
+    l_setSimdMode(L_SIMD_AUTO);
+
+    fpixaDestroy(&fpixa1);
+    if (ppixa)
+        *ppixa = pixa1;
+    else
+        pixaDestroy(&pixa1);
+    return 0;
+}
+
+
+/*!
+ *  regTestMakeRandomPix()
+ *
+ *      Input:  w, h, d (size and depth of pix; d in {1,2,4,8,16,32})
+ *              seed (for the sequence of pixel values)
+ *      Return: pix, or null on error
+ *
+ *  Notes:
+ *      (1) This makes a pix of pseudo-random values, for tests that
+ *          need the same image on every run and on every machine.
+ *          It uses the linear congruential generator
+ *              seed = 1664525 * seed + 1013904223
+ *          which does not depend on the library's rand().
+ *      (2) At 32 bpp, the r, g and b components are the upper three
+ *          bytes of the seed; at other depths, the value is taken from
+ *          the bits starting at bit 8.
+ */
+PIX *
+regTestMakeRandomPix(l_int32   w,
+                     l_int32   h,
+                     l_int32   d,
+                     l_uint32  seed)
+{
+l_int32  i, j;
+PIX     *pix;
+
+    PROCNAME("regTestMakeRandomPix");
+
+    if (d != 1 && d != 2 && d != 4 && d != 8 && d != 16 && d != 32)
+        return (PIX *)ERROR_PTR("invalid depth", procName, NULL);
+    if ((pix = pixCreate(w, h, d)) == NULL)
+        return (PIX *)ERROR_PTR("pix not made", procName, NULL);
+
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            seed = 1664525 * seed + 1013904223;
+            pixSetPixel(pix, j, i, (d == 32) ? seed & 0xffffff00 :
+                                   (seed >> 8) & ((1 << d) - 1));
+        }
+    }
+    return pix;
+}
+
+
 /*!
  *  getRootNameFromArgv0()
  *
@@ -35,6 +35,9 @@
  *
  *           void     rasteropHipLow()
  *           void     shiftDataHorizontalLow()
+ *
+ *  The full words of each row are moved with rasteropWordsLow(), which
+ *  uses vector kernels when available, if the rows are long enough.
  */
 
 
@@ -43,6 +46,9 @@
 
 #define COMBINE_PARTIAL(d, s, m)     ( ((d) & ~(m)) | ((s) & (m)) )
 
+    /* Min number of words in a row for using rasteropWordsLow() */
+static const l_int32  MinSimdWords = 8;
+
 static const l_uint32 lmask32[] = {0x0,
     0x80000000, 0xc0000000, 0xe0000000, 0xf0000000,
     0xf8000000, 0xfc000000, 0xfe000000, 0xff000000,
@@ -174,6 +180,8 @@ l_int32    i, j;
     }
 
         /* is there a full dest word? */
+    pdfwfull = NULL;
+    psfwfull = NULL;
     if (fwpart2b == 1) {  /* not */
         fwfullb = 0;
         nfullw = 0;
@@ -245,7 +253,12 @@ l_int32    i, j;
     }
 
         /* Do the full words */
-    if (fwfullb) {
+    if (fwfullb && nfullw >= MinSimdWords && l_getSimdMode() != L_SIMD_NONE) {
+        rasteropWordsLow(pdfwfull, dirwpl, psfwfull, dirwpl, nfullw, vlimit,
+                         PIX_SRC, 0);
+        rasteropWordsLow(pdfwfull + vlimit * dirwpl, dirwpl, NULL, 0, nfullw,
+                         pixh - vlimit, PIX_CLR, 0);
+    } else if (fwfullb) {
         for (i = 0; i < vlimit; i++) {
             for (j = 0; j < nfullw; j++)
                 *(pdfwfull + j) = *(psfwfull + j);
@@ -369,6 +382,11 @@ l_uint32  *lined, *lines;
                          * progressing leftward. */
         firstdw = shift / 32;
         wpl = L_MIN(wpls, wpld - firstdw);
+        if (wpl <= 0) {  /* everything is shifted out */
+            for (j = 0; j < wpld; j++)
+                datad[j] = 0;
+            return;
+        }
         lined += firstdw + wpl - 1;
         lines += wpl - 1;
         rshift = shift & 31;
@@ -381,9 +399,18 @@ l_uint32  *lined, *lines;
                 *lined-- = 0;
         } else {
             lshift = 32 - rshift;
-            for (j = 1; j < wpl; j++) {
-                *lined-- = *(lines - 1) << lshift | *lines >> rshift;
-                lines--;
+            if (wpl > MinSimdWords && l_getSimdMode() != L_SIMD_NONE) {
+                    /* the dest follows the src, so this also
+                     * goes from right to left */
+                rasteropWordsLow(lined - wpl + 2, 0, lines - wpl + 1, 0,
+                                 wpl - 1, 1, PIX_SRC, lshift);
+                lined -= wpl - 1;
+                lines -= wpl - 1;
+            } else {
+                for (j = 1; j < wpl; j++) {
+                    *lined-- = *(lines - 1) << lshift | *lines >> rshift;
+                    lines--;
+                }
             }
             *lined = *lines >> rshift;  /* partial first */
 
@@ -397,6 +424,11 @@ l_uint32  *lined, *lines;
              * at left edge and progressing rightward. */
         firstdw = (-shift) / 32;
         wpl = L_MIN(wpls - firstdw, wpld);
+        if (wpl <= 0) {  /* everything is shifted out */
+            for (j = 0; j < wpld; j++)
+                datad[j] = 0;
+            return;
+        }
         lines += firstdw;
         lshift = (-shift) & 31;
         if (lshift == 0) {
@@ -408,9 +440,16 @@ l_uint32  *lined, *lines;
                 *lined++ = 0;
         } else {
             rshift = 32 - lshift;
-            for (j = 1; j < wpl; j++) {
-                *lined++ = *lines << lshift | *(lines + 1) >> rshift;
-                lines++;
+            if (wpl > MinSimdWords && l_getSimdMode() != L_SIMD_NONE) {
+                rasteropWordsLow(lined, 0, lines, 0, wpl - 1, 1,
+                                 PIX_SRC, lshift);
+                lined += wpl - 1;
+                lines += wpl - 1;
+            } else {
+                for (j = 1; j < wpl; j++) {
+                    *lined++ = *lines << lshift | *(lines + 1) >> rshift;
+                    lines++;
+                }
             }
             *lined = *lines << lshift;  /* partial last */
 
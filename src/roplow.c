@@ -38,10 +38,24 @@
  *           static void     rasteropVAlignedLow()
  *           static void     rasteropGeneralLow()
  *
+ *      Low level full-word rows
+ *           void            rasteropWordsLow()
+ *           static l_int32  ropUseSimd()
+ *           static l_uint32 ropWord()
+ *           static void     ropWordsGeneric()
+ *           static void     ropWordsSse2()
+ *           static void     ropWordsAvx2()
+ *           static void     ropWordsNeon()
+ *
+ *  The inner loops over the full 32-bit words of each row are run by
+ *  rasteropWordsLow() when a vector instruction set is selected; see
+ *  simd.c.  These kernels give bit-identical results to the word-at-a-time
+ *  loops, which are used when l_getSimdMode() returns L_SIMD_NONE.
  */
 
 #include <string.h>
 #include "allheaders.h"
+#include "simd.h"
 
 #define COMBINE_PARTIAL(d, s, m)     ( ((d) & ~(m)) | ((s) & (m)) )
 
@@ -71,6 +85,30 @@ static void rasteropGeneralLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
                                l_int32 op, l_uint32 *datas, l_int32 swpl,
                                l_int32 sx, l_int32 sy);
 
+static l_int32 ropUseSimd(l_int32 nwords);
+static l_uint32 ropWord(l_uint32 sword, l_uint32 dword, l_int32 op);
+static void ropWordsGeneric(l_uint32 *datad, l_int32 dwpl, l_uint32 *datas,
+                            l_int32 swpl, l_int32 nwords, l_int32 nrows,
+                            l_int32 op, l_int32 shift);
+#if L_HAVE_SSE2
+static void ropWordsSse2(l_uint32 *datad, l_int32 dwpl, l_uint32 *datas,
+                         l_int32 swpl, l_int32 nwords, l_int32 nrows,
+                         l_int32 op, l_int32 shift);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static void ropWordsAvx2(l_uint32 *datad, l_int32 dwpl, l_uint32 *datas,
+                         l_int32 swpl, l_int32 nwords, l_int32 nrows,
+                         l_int32 op, l_int32 shift) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static void ropWordsNeon(l_uint32 *datad, l_int32 dwpl, l_uint32 *datas,
+                         l_int32 swpl, l_int32 nwords, l_int32 nrows,
+                         l_int32 op, l_int32 shift);
+#endif  /* L_HAVE_NEON */
+
+    /* Min number of full words in a row for using the vector kernels */
+static const l_int32  MinSimdWords = 8;
+
 
 static const l_uint32 lmask32[] = {0x0,
     0x80000000, 0xc0000000, 0xe0000000, 0xf0000000,
@@ -220,6 +258,16 @@ l_int32    i, j;
         lwmask = lmask32[lwbits];
     pfword = datad + dwpl * dy + (dx >> 5);
 
+        /* Use a vector kernel for the full words if possible */
+    if (ropUseSimd(nfullw) &&
+        (op == PIX_CLR || op == PIX_SET || op == PIX_NOT(PIX_DST))) {
+        rasteropWordsLow(pfword, dwpl, NULL, 0, nfullw, dh, op, 0);
+        for (i = 0; lwbits && i < dh; i++) {
+            lined = pfword + i * dwpl + nfullw;
+            *lined = COMBINE_PARTIAL(*lined, ropWord(0, *lined, op), lwmask);
+        }
+        return;
+    }
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -325,6 +373,7 @@ l_int32    i, j;
     }
 
         /* is there a full dest word? */
+    pdfwfull = NULL;
     if (dfwpart2b == 1) {  /* not */
         dfwfullb = 0;
         dnfullw = 0;
@@ -354,6 +403,13 @@ l_int32    i, j;
             pdlwpart = datad + dwpl * dy + (dx >> 5) + dnfullw;
     }
 
+        /* Use a vector kernel for the full words if possible */
+    if (dfwfullb && ropUseSimd(dnfullw) &&
+        (op == PIX_CLR || op == PIX_SET || op == PIX_NOT(PIX_DST))) {
+        rasteropWordsLow(pdfwfull, dwpl, NULL, 0, dnfullw, dh, op, 0);
+        dfwfullb = 0;
+    }
+
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -627,6 +683,18 @@ l_int32    i, j;
     psfword = datas + swpl * sy + (sx >> 5);
     pdfword = datad + dwpl * dy + (dx >> 5);
 
+        /* Use a vector kernel for the full words if possible */
+    if (ropUseSimd(nfullw)) {
+        rasteropWordsLow(pdfword, dwpl, psfword, swpl, nfullw, dh, op, 0);
+        for (i = 0; lwbits && i < dh; i++) {
+            lines = psfword + i * swpl + nfullw;
+            lined = pdfword + i * dwpl + nfullw;
+            *lined = COMBINE_PARTIAL(*lined, ropWord(*lines, *lined, op),
+                                     lwmask);
+        }
+        return;
+    }
+
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
      *--------------------------------------------------------*/
@@ -876,6 +944,8 @@ l_int32    i, j;
     }
 
         /* is there a full dest word? */
+    pdfwfull = NULL;
+    psfwfull = NULL;
     if (dfwpart2b == 1) {  /* not */
         dfwfullb = 0;
         dnfullw = 0;
@@ -911,6 +981,12 @@ l_int32    i, j;
         }
     }
 
+        /* Use a vector kernel for the full words if possible */
+    if (dfwfullb && ropUseSimd(dnfullw)) {
+        rasteropWordsLow(pdfwfull, dwpl, psfwfull, swpl, dnfullw, dh, op, 0);
+        dfwfullb = 0;
+    }
+
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -1454,6 +1530,8 @@ l_int32    i, j;
     }
 
         /* is there a full dest word? */
+    pdfwfull = NULL;
+    psfwfull = NULL;
     if (dfwpart2b == 1) {  /* not */
         dfwfullb = 0;
         dnfullw = 0;
@@ -1483,6 +1561,14 @@ l_int32    i, j;
             slwaddb = 1;   /* must rshift in next src word by srightshift */
     }
 
+        /* Use a vector kernel for the full words if possible.
+         * Here, 0 < sleftshift < 32. */
+    if (dfwfullb && ropUseSimd(dnfullw)) {
+        rasteropWordsLow(pdfwfull, dwpl, psfwfull, swpl, dnfullw, dh,
+                         op, sleftshift);
+        dfwfullb = 0;
+    }
+
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -2116,3 +2202,405 @@ l_int32    i, j;
 
     return;
 }
+
+
+
+/*--------------------------------------------------------------------*
+ *                     Low-level full-word rows                       *
+ *--------------------------------------------------------------------*/
+/*!
+ *  rasteropWordsLow()
+ *
+ *      Input:  datad  (ptr to first dest word)
+ *              dwpl   (wpl of dest; can be negative)
+ *              datas  (ptr to first src word; can be null if @op
+ *                      does not use the src)
+ *              swpl   (wpl of src; can be negative)
+ *              nwords (number of dest words in each row)
+ *              nrows  (number of rows)
+ *              op     (op code)
+ *              shift  (0 if the src words are aligned with the dest;
+ *                      otherwise, the left shift, in [1 ... 31], of
+ *                      src word j that aligns it with dest word j)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This applies @op to a rectangle of full dest words.
+ *          With @shift > 0, the src word for dest word j is composed as
+ *              (datas[j] << shift) | (datas[j + 1] >> (32 - shift))
+ *          so @nwords + 1 src words are read in each row.
+ *      (2) As with memmove(), the src and dest can be in the same row:
+ *          if the dest follows the src in memory, the words are done
+ *          in reverse order.
+ *      (3) This uses the vector kernel selected by l_getSimdMode().
+ */
+void
+rasteropWordsLow(l_uint32  *datad,
+                 l_int32    dwpl,
+                 l_uint32  *datas,
+                 l_int32    swpl,
+                 l_int32    nwords,
+                 l_int32    nrows,
+                 l_int32    op,
+                 l_int32    shift)
+{
+    if (nwords <= 0 || nrows <= 0 || op == PIX_DST)
+        return;
+    switch (l_getSimdMode())
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        ropWordsAvx2(datad, dwpl, datas, swpl, nwords, nrows, op, shift);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        ropWordsSse2(datad, dwpl, datas, swpl, nwords, nrows, op, shift);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        ropWordsNeon(datad, dwpl, datas, swpl, nwords, nrows, op, shift);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        ropWordsGeneric(datad, dwpl, datas, swpl, nwords, nrows, op, shift);
+        break;
+    }
+}
+
+
+/*!
+ *  ropUseSimd()
+ *
+ *      Input:  nwords (number of full words in each row)
+ *      Return: 1 if the rows should be done with rasteropWordsLow()
+ */
+static l_int32
+ropUseSimd(l_int32  nwords)
+{
+    return (nwords >= MinSimdWords && l_getSimdMode() != L_SIMD_NONE);
+}
+
+
+/*!
+ *  ropWord()
+ *
+ *      Input:  sword, dword (src and dest words)
+ *              op (op code)
+ *      Return: result of @op on the words
+ *
+ *  Notes:
+ *      (1) Each of the 16 ops is either one of the 8 with an even code,
+ *          or the complement of one of them.  The vector kernels use the
+ *          same decomposition.
+ */
+static l_uint32
+ropWord(l_uint32  sword,
+        l_uint32  dword,
+        l_int32   op)
+{
+l_uint32  inv;
+
+    inv = (op & 1) ? 0xffffffff : 0;
+    switch ((op & 1) ? PIX_NOT(op) : op)
+    {
+    case PIX_CLR:
+        return inv;
+    case PIX_DST:
+        return dword ^ inv;
+    case PIX_SRC:
+        return sword ^ inv;
+    case PIX_SRC & PIX_DST:
+        return (sword & dword) ^ inv;
+    case PIX_SRC | PIX_DST:
+        return (sword | dword) ^ inv;
+    case PIX_SRC ^ PIX_DST:
+        return (sword ^ dword) ^ inv;
+    case PIX_SRC & PIX_NOT(PIX_DST):
+        return (sword & ~dword) ^ inv;
+    default:  /* PIX_NOT(PIX_SRC) & PIX_DST */
+        return (~sword & dword) ^ inv;
+    }
+}
+
+
+/*!
+ *  ropWordsGeneric()
+ *
+ *      Input:  see rasteropWordsLow()
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Portable version, used for L_SIMD_NONE.
+ */
+static void
+ropWordsGeneric(l_uint32  *datad,
+                l_int32    dwpl,
+                l_uint32  *datas,
+                l_int32    swpl,
+                l_int32    nwords,
+                l_int32    nrows,
+                l_int32    op,
+                l_int32    shift)
+{
+l_int32    i, j, k, backward;
+l_uint32   sword;
+l_uint32  *lined, *lines;
+
+    backward = (datas && datad > datas);
+    sword = 0;
+    for (i = 0; i < nrows; i++) {
+        lined = datad + i * dwpl;
+        lines = (datas) ? datas + i * swpl : NULL;
+        for (k = 0; k < nwords; k++) {
+            j = (backward) ? nwords - 1 - k : k;
+            if (lines) {
+                sword = lines[j];
+                if (shift)
+                    sword = (sword << shift) | (lines[j + 1] >> (32 - shift));
+            }
+            lined[j] = ropWord(sword, lined[j], op);
+        }
+    }
+}
+
+
+    /* Loop over the rows for the vector kernels.  VEXPR is a function
+     * of the src vector vs and the dest vector vd, and SEXPR is the same
+     * function of the src word sw and dest word dw.  The result is
+     * complemented with vinv (or inv).  USESRC is 0 for the ops that
+     * do not use the src.  In each row, the vectors are done from the
+     * left, or from the right if backward is set, and the leftover words
+     * at the right end are done one at a time, before the vectors if
+     * backward is set and after them otherwise.  All loads for a vector
+     * are done before it is stored, for in-place use.
+     * The ISA-specific macros VWORDS, VLOAD(p), VSTORE(p, v), VXOR(a, b)
+     * and VSHIFTED(p) must be defined; VSHIFTED(p) composes the src
+     * words starting at p that are aligned with the dest. */
+#define ROP_VEC_TAIL(USESRC, SEXPR)                                      \
+    for (k = 0; k < nleft; k++) {                                        \
+        j = (backward) ? nwords - 1 - k : nvec + k;                      \
+        if (USESRC) {                                                    \
+            sw = lines[j];                                               \
+            if (shift)                                                   \
+                sw = (sw << shift) | (lines[j + 1] >> (32 - shift));     \
+        }                                                                \
+        dw = lined[j];                                                   \
+        lined[j] = (SEXPR) ^ inv;                                        \
+    }
+
+#define ROP_VEC_LOOP(USESRC, VEXPR, SEXPR)                               \
+    for (i = 0; i < nrows; i++) {                                        \
+        lined = datad + i * dwpl;                                        \
+        lines = (USESRC) ? datas + i * swpl : NULL;                      \
+        if (backward)                                                    \
+            ROP_VEC_TAIL(USESRC, SEXPR);                                 \
+        pd = (backward) ? lined + nvec - VWORDS : lined;                 \
+        ps = (backward) ? lines + nvec - VWORDS : lines;                 \
+        if (!(USESRC) || shift == 0) {                                   \
+            for (k = 0; k < nvec; k += VWORDS, pd += step, ps += step) { \
+                if (USESRC) vs = VLOAD(ps);                              \
+                vd = VLOAD(pd);                                          \
+                VSTORE(pd, VXOR(VEXPR, vinv));                           \
+            }                                                            \
+        } else {                                                         \
+            for (k = 0; k < nvec; k += VWORDS, pd += step, ps += step) { \
+                vs = VSHIFTED(ps);                                       \
+                vd = VLOAD(pd);                                          \
+                VSTORE(pd, VXOR(VEXPR, vinv));                           \
+            }                                                            \
+        }                                                                \
+        if (!backward)                                                   \
+            ROP_VEC_TAIL(USESRC, SEXPR);                                 \
+    }
+
+    /* Select the loop for the op, after removing the complement.
+     * VAND(a, b), VOR(a, b) and VANDNOT(a, b) (= a & ~b) must be
+     * defined, in addition to those used by ROP_VEC_LOOP. */
+#define ROP_VEC_SWITCH                                                   \
+    backward = (datas && datad > datas);                                 \
+    nvec = nwords - (nwords % VWORDS);                                   \
+    nleft = nwords - nvec;                                               \
+    step = (backward) ? -VWORDS : VWORDS;                                \
+    inv = (op & 1) ? 0xffffffff : 0;                                     \
+    sw = 0;                                                              \
+    switch ((op & 1) ? PIX_NOT(op) : op)                                 \
+    {                                                                    \
+    case PIX_CLR:                                                        \
+        ROP_VEC_LOOP(0, vzero, 0);                                       \
+        break;                                                           \
+    case PIX_DST:                                                        \
+        ROP_VEC_LOOP(0, vd, dw);                                         \
+        break;                                                           \
+    case PIX_SRC:                                                        \
+        ROP_VEC_LOOP(1, vs, sw);                                         \
+        break;                                                           \
+    case PIX_SRC & PIX_DST:                                              \
+        ROP_VEC_LOOP(1, VAND(vs, vd), sw & dw);                          \
+        break;                                                           \
+    case PIX_SRC | PIX_DST:                                              \
+        ROP_VEC_LOOP(1, VOR(vs, vd), sw | dw);                           \
+        break;                                                           \
+    case PIX_SRC ^ PIX_DST:                                              \
+        ROP_VEC_LOOP(1, VXOR(vs, vd), sw ^ dw);                          \
+        break;                                                           \
+    case PIX_SRC & PIX_NOT(PIX_DST):                                     \
+        ROP_VEC_LOOP(1, VANDNOT(vs, vd), sw & ~dw);                      \
+        break;                                                           \
+    default:  /* PIX_NOT(PIX_SRC) & PIX_DST */                           \
+        ROP_VEC_LOOP(1, VANDNOT(vd, vs), ~sw & dw);                      \
+        break;                                                           \
+    }
+
+
+#if L_HAVE_SSE2
+/*!
+ *  ropWordsSse2()
+ *
+ *      Input:  see rasteropWordsLow()
+ *      Return: void
+ */
+static void
+ropWordsSse2(l_uint32  *datad,
+             l_int32    dwpl,
+             l_uint32  *datas,
+             l_int32    swpl,
+             l_int32    nwords,
+             l_int32    nrows,
+             l_int32    op,
+             l_int32    shift)
+{
+l_int32    i, j, k, nvec, nleft, step, backward;
+l_uint32   sw, dw, inv;
+l_uint32  *lined, *lines, *pd, *ps;
+__m128i    vs, vd, vinv, vzero, vlshift, vrshift;
+
+    vzero = _mm_setzero_si128();
+    vinv = (op & 1) ? _mm_set1_epi32(-1) : vzero;
+    vlshift = _mm_cvtsi32_si128(shift);
+    vrshift = _mm_cvtsi32_si128(32 - shift);
+    vs = vzero;
+
+#define VWORDS           4
+#define VLOAD(p)         _mm_loadu_si128((const __m128i *)(p))
+#define VSTORE(p, v)     _mm_storeu_si128((__m128i *)(p), (v))
+#define VAND(a, b)       _mm_and_si128((a), (b))
+#define VOR(a, b)        _mm_or_si128((a), (b))
+#define VXOR(a, b)       _mm_xor_si128((a), (b))
+#define VANDNOT(a, b)    _mm_andnot_si128((b), (a))
+#define VSHIFTED(p)      VOR(_mm_sll_epi32(VLOAD(p), vlshift),           \
+                             _mm_srl_epi32(VLOAD((p) + 1), vrshift))
+    ROP_VEC_SWITCH
+#undef VWORDS
+#undef VLOAD
+#undef VSTORE
+#undef VAND
+#undef VOR
+#undef VXOR
+#undef VANDNOT
+#undef VSHIFTED
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+/*!
+ *  ropWordsAvx2()
+ *
+ *      Input:  see rasteropWordsLow()
+ *      Return: void
+ */
+static void
+ropWordsAvx2(l_uint32  *datad,
+             l_int32    dwpl,
+             l_uint32  *datas,
+             l_int32    swpl,
+             l_int32    nwords,
+             l_int32    nrows,
+             l_int32    op,
+             l_int32    shift)
+{
+l_int32    i, j, k, nvec, nleft, step, backward;
+l_uint32   sw, dw, inv;
+l_uint32  *lined, *lines, *pd, *ps;
+__m128i    vlshift, vrshift;
+__m256i    vs, vd, vinv, vzero;
+
+    vzero = _mm256_setzero_si256();
+    vinv = (op & 1) ? _mm256_set1_epi32(-1) : vzero;
+    vlshift = _mm_cvtsi32_si128(shift);
+    vrshift = _mm_cvtsi32_si128(32 - shift);
+    vs = vzero;
+
+#define VWORDS           8
+#define VLOAD(p)         _mm256_loadu_si256((const __m256i *)(p))
+#define VSTORE(p, v)     _mm256_storeu_si256((__m256i *)(p), (v))
+#define VAND(a, b)       _mm256_and_si256((a), (b))
+#define VOR(a, b)        _mm256_or_si256((a), (b))
+#define VXOR(a, b)       _mm256_xor_si256((a), (b))
+#define VANDNOT(a, b)    _mm256_andnot_si256((b), (a))
+#define VSHIFTED(p)      VOR(_mm256_sll_epi32(VLOAD(p), vlshift),        \
+                             _mm256_srl_epi32(VLOAD((p) + 1), vrshift))
+    ROP_VEC_SWITCH
+#undef VWORDS
+#undef VLOAD
+#undef VSTORE
+#undef VAND
+#undef VOR
+#undef VXOR
+#undef VANDNOT
+#undef VSHIFTED
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+/*!
+ *  ropWordsNeon()
+ *
+ *      Input:  see rasteropWordsLow()
+ *      Return: void
+ */
+static void
+ropWordsNeon(l_uint32  *datad,
+             l_int32    dwpl,
+             l_uint32  *datas,
+             l_int32    swpl,
+             l_int32    nwords,
+             l_int32    nrows,
+             l_int32    op,
+             l_int32    shift)
+{
+l_int32     i, j, k, nvec, nleft, step, backward;
+l_uint32    sw, dw, inv;
+l_uint32   *lined, *lines, *pd, *ps;
+int32x4_t   vlshift, vrshift;
+uint32x4_t  vs, vd, vinv, vzero;
+
+    vzero = vdupq_n_u32(0);
+    vinv = (op & 1) ? vdupq_n_u32(0xffffffff) : vzero;
+    vlshift = vdupq_n_s32(shift);
+    vrshift = vdupq_n_s32(shift - 32);  /* negative: right shift */
+    vs = vzero;
+
+#define VWORDS           4
+#define VLOAD(p)         vld1q_u32(p)
+#define VSTORE(p, v)     vst1q_u32((p), (v))
+#define VAND(a, b)       vandq_u32((a), (b))
+#define VOR(a, b)        vorrq_u32((a), (b))
+#define VXOR(a, b)       veorq_u32((a), (b))
+#define VANDNOT(a, b)    vbicq_u32((a), (b))
+#define VSHIFTED(p)      VOR(vshlq_u32(VLOAD(p), vlshift),               \
+                             vshlq_u32(VLOAD((p) + 1), vrshift))
+    ROP_VEC_SWITCH
+#undef VWORDS
+#undef VLOAD
+#undef VSTORE
+#undef VAND
+#undef VOR
+#undef VXOR
+#undef VANDNOT
+#undef VSHIFTED
+}
+#endif  /* L_HAVE_NEON */
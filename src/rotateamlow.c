@@ -25,6 +25,7 @@
  *====================================================================*/
 
 
+
 /*
  *  rotateamlow.c
  *
@@ -45,11 +46,73 @@
  *          Fast RGB color rotation about center:
  *               void    rotateAMColorFastLow()
  *
+ *          Rotation on bands of lines
+ *               static l_int32    rotateAMBands()
+ *               static l_int32    rotateAMBand()
+ *               static void       rotateAMColorLine()
+ *               static void       rotateAMGrayLine()
+ *               static void       rotateAMColorFastLine()
+ *               static l_int32    rotateAMColorLineSse2()
+ *               static l_int32    rotateAMColorLineAvx2()
+ *               static l_int32    rotateAMGrayLineAvx2()
+ *
+ *      The destination lines are divided into bands, which are rotated
+ *      in parallel (see l_setParallelThreads()).  Each line is made
+ *      independently from the source, which is not changed.
+ *
+ *      For the area mapped rotations, the source location of each
+ *      dest pixel is found in units of 1/16 pixel, and the dest pixel
+ *      is interpolated from the 4 source pixels about that location.
+ *      The vector kernels find the locations of 4 or 8 adjacent dest
+ *      pixels at once, with the same float arithmetic as the scalar
+ *      code, and interpolate the color components or gray values in
+ *      16 bit lanes, so they give exactly the same result.
  */
 
 #include <string.h>
 #include <math.h>   /* required for sin and tan */
 #include "allheaders.h"
+#include "simd.h"
+
+    /* Smallest band of dest lines given to a thread */
+static const l_int32  MinRotateAMBandHeight = 16;
+
+    /* Parameters for rotation of each band of dest lines */
+struct RotateAMParams
+{
+    l_uint32    *datad;       /* dest, of the same size as the source      */
+    l_int32      wpld;
+    l_uint32    *datas;       /* source                                    */
+    l_int32      wpls;
+    l_int32      w;           /* image size                                */
+    l_int32      h;
+    l_int32      d;           /* depth: 8 or 32                            */
+    l_int32      fast;        /* 1 for rotateAMColorFastLow()              */
+    l_int32      xcen;        /* center of rotation; 0 for the UL corner   */
+    l_int32      ycen;
+    l_float32    sina;        /* sin and cos of the angle, scaled by the   */
+    l_float32    cosa;        /*   number of subpixels in each direction   */
+    l_uint32     fillval;     /* brought in from outside the image         */
+    l_int32      nbands;      /* number of bands                           */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct RotateAMParams  ROTATEAM_PARAMS;
+
+static l_int32 rotateAMBands(ROTATEAM_PARAMS *params);
+static l_int32 rotateAMBand(void *data, l_int32 index);
+static void rotateAMColorLine(ROTATEAM_PARAMS *params, l_int32 i);
+static void rotateAMGrayLine(ROTATEAM_PARAMS *params, l_int32 i);
+static void rotateAMColorFastLine(ROTATEAM_PARAMS *params, l_int32 i);
+#if L_HAVE_SSE2
+static l_int32 rotateAMColorLineSse2(l_uint32 *lined, ROTATEAM_PARAMS *params,
+                                     l_float32 rx, l_float32 ry);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 rotateAMColorLineAvx2(l_uint32 *lined, ROTATEAM_PARAMS *params,
+                                     l_float32 rx, l_float32 ry) L_TARGET_AVX2;
+static l_int32 rotateAMGrayLineAvx2(l_uint32 *lined, ROTATEAM_PARAMS *params,
+                                    l_float32 rx, l_float32 ry) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
 
 
 /*------------------------------------------------------------------*
@@ -65,65 +128,22 @@ rotateAMColorLow(l_uint32  *datad,
                  l_float32  angle,
                  l_uint32   colorval)
 {
-l_int32    i, j, xcen, ycen, wm2, hm2;
-l_int32    xdif, ydif, xpm, ypm, xp, yp, xf, yf;
-l_int32    rval, gval, bval;
-l_uint32   word00, word01, word10, word11;
-l_uint32  *lines, *lined;
-l_float32  sina, cosa;
-
-    xcen = w / 2;
-    wm2 = w - 2;
-    ycen = h / 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        ydif = ycen - i;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            xpm = (l_int32)(-xdif * cosa - ydif * sina);
-            ypm = (l_int32)(-ydif * cosa + xdif * sina);
-            xp = xcen + (xpm >> 4);
-            yp = ycen + (ypm >> 4);
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
-
-                /* if off the edge, write input colorval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                *(lined + j) = colorval;
-                continue;
-            }
-
-            lines = datas + yp * wpls;
-
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   *(lined + j) = *(lines + xp);
-                 * which is faster but gives lousy results!
-                 */
-            word00 = *(lines + xp);
-            word10 = *(lines + xp + 1);
-            word01 = *(lines + wpls + xp);
-            word11 = *(lines + wpls + xp + 1);
-            rval = ((16 - xf) * (16 - yf) * ((word00 >> L_RED_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_RED_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_RED_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_RED_SHIFT) & 0xff) + 128) / 256;
-            gval = ((16 - xf) * (16 - yf) * ((word00 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_GREEN_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_GREEN_SHIFT) & 0xff) + 128) / 256;
-            bval = ((16 - xf) * (16 - yf) * ((word00 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_BLUE_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_BLUE_SHIFT) & 0xff) + 128) / 256;
-            composeRGBPixel(rval, gval, bval, lined + j);
-        }
-    }
+ROTATEAM_PARAMS  params;
 
+    memset(&params, 0, sizeof(ROTATEAM_PARAMS));
+    params.datad = datad;
+    params.wpld = wpld;
+    params.datas = datas;
+    params.wpls = wpls;
+    params.w = w;
+    params.h = h;
+    params.d = 32;
+    params.xcen = w / 2;
+    params.ycen = h / 2;
+    params.sina = 16. * sin(angle);
+    params.cosa = 16. * cos(angle);
+    params.fillval = colorval;
+    rotateAMBands(&params);
     return;
 }
 
@@ -141,54 +161,22 @@ rotateAMGrayLow(l_uint32  *datad,
                 l_float32  angle,
                 l_uint8    grayval)
 {
-l_int32    i, j, xcen, ycen, wm2, hm2;
-l_int32    xdif, ydif, xpm, ypm, xp, yp, xf, yf;
-l_int32    v00, v01, v10, v11;
-l_uint8    val;
-l_uint32  *lines, *lined;
-l_float32  sina, cosa;
-
-    xcen = w / 2;
-    wm2 = w - 2;
-    ycen = h / 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        ydif = ycen - i;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            xpm = (l_int32)(-xdif * cosa - ydif * sina);
-            ypm = (l_int32)(-ydif * cosa + xdif * sina);
-            xp = xcen + (xpm >> 4);
-            yp = ycen + (ypm >> 4);
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
-
-                /* if off the edge, write input grayval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                SET_DATA_BYTE(lined, j, grayval);
-                continue;
-            }
-
-            lines = datas + yp * wpls;
-
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!
-                 */
-            v00 = (16 - xf) * (16 - yf) * GET_DATA_BYTE(lines, xp);
-            v10 = xf * (16 - yf) * GET_DATA_BYTE(lines, xp + 1);
-            v01 = (16 - xf) * yf * GET_DATA_BYTE(lines + wpls, xp);
-            v11 = xf * yf * GET_DATA_BYTE(lines + wpls, xp + 1);
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
-            SET_DATA_BYTE(lined, j, val);
-        }
-    }
+ROTATEAM_PARAMS  params;
 
+    memset(&params, 0, sizeof(ROTATEAM_PARAMS));
+    params.datad = datad;
+    params.wpld = wpld;
+    params.datas = datas;
+    params.wpls = wpls;
+    params.w = w;
+    params.h = h;
+    params.d = 8;
+    params.xcen = w / 2;
+    params.ycen = h / 2;
+    params.sina = 16. * sin(angle);
+    params.cosa = 16. * cos(angle);
+    params.fillval = grayval;
+    rotateAMBands(&params);
     return;
 }
 
@@ -206,66 +194,24 @@ rotateAMColorCornerLow(l_uint32  *datad,
                        l_float32  angle,
                        l_uint32   colorval)
 {
-l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm, xp, yp, xf, yf;
-l_int32    rval, gval, bval;
-l_uint32   word00, word01, word10, word11;
-l_uint32  *lines, *lined;
-l_float32  sina, cosa;
-
-    wm2 = w - 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xpm = (l_int32)(j * cosa + i * sina);
-            ypm = (l_int32)(i * cosa - j * sina);
-            xp = xpm >> 4;
-            yp = ypm >> 4;
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
-
-                /* if off the edge, write input colorval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                *(lined + j) = colorval;
-                continue;
-            }
-
-            lines = datas + yp * wpls;
-
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   *(lined + j) = *(lines + xp);
-                 * which is faster but gives lousy results!
-                 */
-            word00 = *(lines + xp);
-            word10 = *(lines + xp + 1);
-            word01 = *(lines + wpls + xp);
-            word11 = *(lines + wpls + xp + 1);
-            rval = ((16 - xf) * (16 - yf) * ((word00 >> L_RED_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_RED_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_RED_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_RED_SHIFT) & 0xff) + 128) / 256;
-            gval = ((16 - xf) * (16 - yf) * ((word00 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_GREEN_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_GREEN_SHIFT) & 0xff) + 128) / 256;
-            bval = ((16 - xf) * (16 - yf) * ((word00 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_BLUE_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_BLUE_SHIFT) & 0xff) + 128) / 256;
-            composeRGBPixel(rval, gval, bval, lined + j);
-        }
-    }
+ROTATEAM_PARAMS  params;
 
+    memset(&params, 0, sizeof(ROTATEAM_PARAMS));
+    params.datad = datad;
+    params.wpld = wpld;
+    params.datas = datas;
+    params.wpls = wpls;
+    params.w = w;
+    params.h = h;
+    params.d = 32;
+    params.sina = 16. * sin(angle);
+    params.cosa = 16. * cos(angle);
+    params.fillval = colorval;
+    rotateAMBands(&params);
     return;
 }
 
 
-
 /*------------------------------------------------------------------*
  *            8 bpp grayscale rotation about the UL corner          *
  *------------------------------------------------------------------*/
@@ -279,50 +225,20 @@ rotateAMGrayCornerLow(l_uint32  *datad,
                       l_float32  angle,
                       l_uint8    grayval)
 {
-l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm, xp, yp, xf, yf;
-l_int32    v00, v01, v10, v11;
-l_uint8    val;
-l_uint32  *lines, *lined;
-l_float32  sina, cosa;
-
-    wm2 = w - 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xpm = (l_int32)(j * cosa + i * sina);
-            ypm = (l_int32)(i * cosa - j * sina);
-            xp = xpm >> 4;
-            yp = ypm >> 4;
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
-
-                /* if off the edge, write input grayval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                SET_DATA_BYTE(lined, j, grayval);
-                continue;
-            }
-
-            lines = datas + yp * wpls;
-
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!
-                 */
-            v00 = (16 - xf) * (16 - yf) * GET_DATA_BYTE(lines, xp);
-            v10 = xf * (16 - yf) * GET_DATA_BYTE(lines, xp + 1);
-            v01 = (16 - xf) * yf * GET_DATA_BYTE(lines + wpls, xp);
-            v11 = xf * yf * GET_DATA_BYTE(lines + wpls, xp + 1);
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
-            SET_DATA_BYTE(lined, j, val);
-        }
-    }
+ROTATEAM_PARAMS  params;
 
+    memset(&params, 0, sizeof(ROTATEAM_PARAMS));
+    params.datad = datad;
+    params.wpld = wpld;
+    params.datas = datas;
+    params.wpls = wpls;
+    params.w = w;
+    params.h = h;
+    params.d = 8;
+    params.sina = 16. * sin(angle);
+    params.cosa = 16. * cos(angle);
+    params.fillval = grayval;
+    rotateAMBands(&params);
     return;
 }
 
@@ -410,266 +326,858 @@ rotateAMColorFastLow(l_uint32  *datad,
                      l_float32  angle,
                      l_uint32   colorval)
 {
-l_int32    i, j, xcen, ycen, wm2, hm2;
+ROTATEAM_PARAMS  params;
+
+    memset(&params, 0, sizeof(ROTATEAM_PARAMS));
+    params.datad = datad;
+    params.wpld = wpld;
+    params.datas = datas;
+    params.wpls = wpls;
+    params.w = w;
+    params.h = h;
+    params.d = 32;
+    params.fast = 1;
+    params.xcen = w / 2;
+    params.ycen = h / 2;
+    params.sina = 4. * sin(angle);
+    params.cosa = 4. * cos(angle);
+    params.fillval = colorval;
+    rotateAMBands(&params);
+    return;
+}
+
+
+/*------------------------------------------------------------------*
+ *                   Rotation on bands of lines                     *
+ *------------------------------------------------------------------*/
+/*!
+ *  rotateAMBands()
+ *
+ *      Input:  params (ROTATEAM_PARAMS, with all but nbands and simd set)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The dest is divided into one band of lines for each thread,
+ *          each with at least MinRotateAMBandHeight lines, and the
+ *          bands are rotated in parallel.
+ */
+static l_int32
+rotateAMBands(ROTATEAM_PARAMS  *params)
+{
+l_int32  nbands;
+
+    PROCNAME("rotateAMBands");
+
+    nbands = L_MIN(l_getParallelThreads(), params->h / MinRotateAMBandHeight);
+    params->nbands = L_MAX(1, nbands);
+    params->simd = l_getSimdMode();
+    if (l_parallelRun(params->nbands, params->nbands, rotateAMBand, params))
+        return ERROR_INT("bands not rotated", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  rotateAMBand()
+ *
+ *      Input:  data (ROTATEAM_PARAMS)
+ *              index (of the band of dest lines)
+ *      Return: 0 (always)
+ */
+static l_int32
+rotateAMBand(void    *data,
+             l_int32  index)
+{
+l_int32           i, y0, y1;
+ROTATEAM_PARAMS  *params;
+
+    params = (ROTATEAM_PARAMS *)data;
+    y0 = (params->h * index) / params->nbands;
+    y1 = (params->h * (index + 1)) / params->nbands;
+    for (i = y0; i < y1; i++) {
+        if (params->fast)
+            rotateAMColorFastLine(params, i);
+        else if (params->d == 32)
+            rotateAMColorLine(params, i);
+        else
+            rotateAMGrayLine(params, i);
+    }
+    return 0;
+}
+
+
+/*!
+ *  rotateAMColorLine()
+ *
+ *      Input:  params (ROTATEAM_PARAMS)
+ *              i (dest line)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) For dest pixel (j, i), with u = j - xcen and v = i - ycen,
+ *          the source location in subpixels is
+ *              xpm = u * cosa + v * sina
+ *              ypm = v * cosa - u * sina
+ *          relative to the center of rotation.  The products with v
+ *          are the same for the whole line.  The sums are made in
+ *          the same order as in the original expressions
+ *          (-xdif * cosa - ydif * sina, etc.), so the truncated
+ *          values do not depend on how the pixels are grouped.
+ */
+static void
+rotateAMColorLine(ROTATEAM_PARAMS  *params,
+                  l_int32           i)
+{
+l_int32    j, jstart, w, wm2, hm2, wpls, xcen, ycen;
+l_int32    u, xpm, ypm, xp, yp, xf, yf;
+l_int32    rval, gval, bval;
+l_uint32   word00, word01, word10, word11;
+l_uint32  *lines, *lined;
+l_float32  sina, cosa, rx, ry;
+
+    w = params->w;
+    wm2 = w - 2;
+    hm2 = params->h - 2;
+    wpls = params->wpls;
+    xcen = params->xcen;
+    ycen = params->ycen;
+    sina = params->sina;
+    cosa = params->cosa;
+    rx = (l_float32)(i - ycen) * sina;
+    ry = (l_float32)(i - ycen) * cosa;
+    lined = params->datad + i * params->wpld;
+
+    jstart = 0;
+    switch (params->simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = rotateAMColorLineAvx2(lined, params, rx, ry);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        jstart = rotateAMColorLineSse2(lined, params, rx, ry);
+        break;
+#endif  /* L_HAVE_SSE2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        u = j - xcen;
+        xpm = (l_int32)(u * cosa + rx);
+        ypm = (l_int32)(ry - u * sina);
+        xp = xcen + (xpm >> 4);
+        yp = ycen + (ypm >> 4);
+        xf = xpm & 0x0f;
+        yf = ypm & 0x0f;
+
+            /* if off the edge, write input colorval */
+        if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
+            *(lined + j) = params->fillval;
+            continue;
+        }
+
+        lines = params->datas + yp * wpls;
+
+            /* do area weighting.  Without this, we would
+             * simply do:
+             *   *(lined + j) = *(lines + xp);
+             * which is faster but gives lousy results!
+             */
+        word00 = *(lines + xp);
+        word10 = *(lines + xp + 1);
+        word01 = *(lines + wpls + xp);
+        word11 = *(lines + wpls + xp + 1);
+        rval = ((16 - xf) * (16 - yf) * ((word00 >> L_RED_SHIFT) & 0xff) +
+                xf * (16 - yf) * ((word10 >> L_RED_SHIFT) & 0xff) +
+                (16 - xf) * yf * ((word01 >> L_RED_SHIFT) & 0xff) +
+                xf * yf * ((word11 >> L_RED_SHIFT) & 0xff) + 128) / 256;
+        gval = ((16 - xf) * (16 - yf) * ((word00 >> L_GREEN_SHIFT) & 0xff) +
+                xf * (16 - yf) * ((word10 >> L_GREEN_SHIFT) & 0xff) +
+                (16 - xf) * yf * ((word01 >> L_GREEN_SHIFT) & 0xff) +
+                xf * yf * ((word11 >> L_GREEN_SHIFT) & 0xff) + 128) / 256;
+        bval = ((16 - xf) * (16 - yf) * ((word00 >> L_BLUE_SHIFT) & 0xff) +
+                xf * (16 - yf) * ((word10 >> L_BLUE_SHIFT) & 0xff) +
+                (16 - xf) * yf * ((word01 >> L_BLUE_SHIFT) & 0xff) +
+                xf * yf * ((word11 >> L_BLUE_SHIFT) & 0xff) + 128) / 256;
+        composeRGBPixel(rval, gval, bval, lined + j);
+    }
+}
+
+
+/*!
+ *  rotateAMGrayLine()
+ *
+ *      Input:  params (ROTATEAM_PARAMS)
+ *              i (dest line)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) See rotateAMColorLine().
+ */
+static void
+rotateAMGrayLine(ROTATEAM_PARAMS  *params,
+                 l_int32           i)
+{
+l_int32    j, jstart, w, wm2, hm2, wpls, xcen, ycen;
+l_int32    u, xpm, ypm, xp, yp, xf, yf;
+l_int32    v00, v01, v10, v11;
+l_uint8    val;
+l_uint32  *lines, *lined;
+l_float32  sina, cosa, rx, ry;
+
+    w = params->w;
+    wm2 = w - 2;
+    hm2 = params->h - 2;
+    wpls = params->wpls;
+    xcen = params->xcen;
+    ycen = params->ycen;
+    sina = params->sina;
+    cosa = params->cosa;
+    rx = (l_float32)(i - ycen) * sina;
+    ry = (l_float32)(i - ycen) * cosa;
+    lined = params->datad + i * params->wpld;
+
+    jstart = 0;
+    switch (params->simd)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        jstart = rotateAMGrayLineAvx2(lined, params, rx, ry);
+        break;
+#endif  /* L_HAVE_AVX2 */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < w; j++) {
+        u = j - xcen;
+        xpm = (l_int32)(u * cosa + rx);
+        ypm = (l_int32)(ry - u * sina);
+        xp = xcen + (xpm >> 4);
+        yp = ycen + (ypm >> 4);
+        xf = xpm & 0x0f;
+        yf = ypm & 0x0f;
+
+            /* if off the edge, write input grayval */
+        if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
+            SET_DATA_BYTE(lined, j, params->fillval);
+            continue;
+        }
+
+        lines = params->datas + yp * wpls;
+
+            /* do area weighting.  Without this, we would
+             * simply do:
+             *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
+             * which is faster but gives lousy results!
+             */
+        v00 = (16 - xf) * (16 - yf) * GET_DATA_BYTE(lines, xp);
+        v10 = xf * (16 - yf) * GET_DATA_BYTE(lines, xp + 1);
+        v01 = (16 - xf) * yf * GET_DATA_BYTE(lines + wpls, xp);
+        v11 = xf * yf * GET_DATA_BYTE(lines + wpls, xp + 1);
+        val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
+        SET_DATA_BYTE(lined, j, val);
+    }
+}
+
+
+/*!
+ *  rotateAMColorFastLine()
+ *
+ *      Input:  params (ROTATEAM_PARAMS)
+ *              i (dest line)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) See rotateAMColorFastLow().
+ */
+static void
+rotateAMColorFastLine(ROTATEAM_PARAMS  *params,
+                      l_int32           i)
+{
+l_int32    j, w, xcen, ycen, wm2, hm2, wpls;
 l_int32    xdif, ydif, xpm, ypm, xp, yp, xf, yf;
-l_uint32   word1, word2, word3, word4, red, blue, green;
-l_uint32  *pword, *lines, *lined;
+l_uint32   colorval, word1, word2, word3, word4, red, blue, green;
+l_uint32  *datas, *pword, *lines, *lined;
 l_float32  sina, cosa;
 
-    xcen = w / 2;
+    w = params->w;
+    xcen = params->xcen;
+    ycen = params->ycen;
     wm2 = w - 2;
-    ycen = h / 2;
-    hm2 = h - 2;
-    sina = 4. * sin(angle);
-    cosa = 4. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        ydif = ycen - i;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            xpm = (l_int32)(-xdif * cosa - ydif * sina);
-            ypm = (l_int32)(-ydif * cosa + xdif * sina);
-            xp = xcen + (xpm >> 2);
-            yp = ycen + (ypm >> 2);
-            xf = xpm & 0x03;
-            yf = ypm & 0x03;
-
-                /* if off the edge, write input grayval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                *(lined + j) = colorval;
-                continue;
-            }
+    hm2 = params->h - 2;
+    datas = params->datas;
+    wpls = params->wpls;
+    sina = params->sina;
+    cosa = params->cosa;
+    colorval = params->fillval;
+
+    ydif = ycen - i;
+    lined = params->datad + i * params->wpld;
+    for (j = 0; j < w; j++) {
+        xdif = xcen - j;
+        xpm = (l_int32)(-xdif * cosa - ydif * sina);
+        ypm = (l_int32)(-ydif * cosa + xdif * sina);
+        xp = xcen + (xpm >> 2);
+        yp = ycen + (ypm >> 2);
+        xf = xpm & 0x03;
+        yf = ypm & 0x03;
+
+            /* if off the edge, write input grayval */
+        if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
+            *(lined + j) = colorval;
+            continue;
+        }
+
+        lines = datas + yp * wpls;
+        pword = lines + xp;
+
+        switch (xf + 4 * yf)
+        {
+        case 0:
+            *(lined + j) = *pword;
+            break;
+        case 1:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            red = 3 * (word1 >> 24) + (word2 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) +
+                        ((word2 >> 16) & 0xff);
+            blue = 3 * ((word1 >> 8) & 0xff) +
+                        ((word2 >> 8) & 0xff);
+            *(lined + j) = ((red << 22) & 0xff000000) |
+                           ((green << 14) & 0x00ff0000) |
+                           ((blue << 6) & 0x0000ff00);
+            break;
+        case 2:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            red = (word1 >> 24) + (word2 >> 24);
+            green = ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff);
+            *(lined + j) = ((red << 23) & 0xff000000) |
+                           ((green << 15) & 0x00ff0000) |
+                           ((blue << 7) & 0x0000ff00);
+            break;
+        case 3:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            red = (word1 >> 24) + 3 * (word2 >> 24);
+            green = ((word1 >> 16) & 0xff) +
+                      3 * ((word2 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) +
+                      3 * ((word2 >> 8) & 0xff);
+            *(lined + j) = ((red << 22) & 0xff000000) |
+                           ((green << 14) & 0x00ff0000) |
+                           ((blue << 6) & 0x0000ff00);
+            break;
+        case 4:
+            word1 = *pword;
+            word3 = *(pword + wpls);
+            red = 3 * (word1 >> 24) + (word3 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) +
+                        ((word3 >> 16) & 0xff);
+            blue = 3 * ((word1 >> 8) & 0xff) +
+                        ((word3 >> 8) & 0xff);
+            *(lined + j) = ((red << 22) & 0xff000000) |
+                           ((green << 14) & 0x00ff0000) |
+                           ((blue << 6) & 0x0000ff00);
+            break;
+        case 5:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = 9 * (word1 >> 24) + 3 * (word2 >> 24) +
+                  3 * (word3 >> 24) + (word4 >> 24);
+            green = 9 * ((word1 >> 16) & 0xff) +
+                    3 * ((word2 >> 16) & 0xff) +
+                    3 * ((word3 >> 16) & 0xff) +
+                    ((word4 >> 16) & 0xff);
+            blue = 9 * ((word1 >> 8) & 0xff) +
+                   3 * ((word2 >> 8) & 0xff) +
+                   3 * ((word3 >> 8) & 0xff) +
+                   ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 20) & 0xff000000) |
+                           ((green << 12) & 0x00ff0000) |
+                           ((blue << 4) & 0x0000ff00);
+            break;
+        case 6:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = 3 * (word1 >> 24) +  3 * (word2 >> 24) +
+                  (word3 >> 24) + (word4 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) +
+                    3 * ((word2 >> 16) & 0xff) +
+                    ((word3 >> 16) & 0xff) +
+                    ((word4 >> 16) & 0xff);
+            blue = 3 * ((word1 >> 8) & 0xff) +
+                   3 * ((word2 >> 8) & 0xff) +
+                   ((word3 >> 8) & 0xff) +
+                   ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 21) & 0xff000000) |
+                           ((green << 13) & 0x00ff0000) |
+                           ((blue << 5) & 0x0000ff00);
+            break;
+        case 7:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = 3 * (word1 >> 24) + 9 * (word2 >> 24) +
+                  (word3 >> 24) + 3 * (word4 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) +
+                    9 * ((word2 >> 16) & 0xff) +
+                    ((word3 >> 16) & 0xff) +
+                    3 * ((word4 >> 16) & 0xff);
+            blue = 3 * ((word1 >> 8) & 0xff) +
+                   9 * ((word2 >> 8) & 0xff) +
+                     ((word3 >> 8) & 0xff) +
+                     3 * ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 20) & 0xff000000) |
+                           ((green << 12) & 0x00ff0000) |
+                           ((blue << 4) & 0x0000ff00);
+            break;
+        case 8:
+            word1 = *pword;
+            word3 = *(pword + wpls);
+            red = (word1 >> 24) + (word3 >> 24);
+            green = ((word1 >> 16) & 0xff) + ((word3 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + ((word3 >> 8) & 0xff);
+            *(lined + j) = ((red << 23) & 0xff000000) |
+                           ((green << 15) & 0x00ff0000) |
+                           ((blue << 7) & 0x0000ff00);
+            break;
+        case 9:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = 3 * (word1 >> 24) + (word2 >> 24) +
+                  3 * (word3 >> 24) + (word4 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
+                    3 * ((word3 >> 16) & 0xff) + ((word4 >> 16) & 0xff);
+            blue = 3 * ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
+                   3 * ((word3 >> 8) & 0xff) + ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 21) & 0xff000000) |
+                           ((green << 13) & 0x00ff0000) |
+                           ((blue << 5) & 0x0000ff00);
+            break;
+        case 10:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = (word1 >> 24) + (word2 >> 24) +
+                  (word3 >> 24) + (word4 >> 24);
+            green = ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
+                    ((word3 >> 16) & 0xff) + ((word4 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
+                   ((word3 >> 8) & 0xff) + ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 22) & 0xff000000) |
+                           ((green << 14) & 0x00ff0000) |
+                           ((blue << 6) & 0x0000ff00);
+            break;
+        case 11:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = (word1 >> 24) + 3 * (word2 >> 24) +
+                  (word3 >> 24) + 3 * (word4 >> 24);
+            green = ((word1 >> 16) & 0xff) + 3 * ((word2 >> 16) & 0xff) +
+                    ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + 3 * ((word2 >> 8) & 0xff) +
+                   ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 21) & 0xff000000) |
+                           ((green << 13) & 0x00ff0000) |
+                           ((blue << 5) & 0x0000ff00);
+            break;
+        case 12:
+            word1 = *pword;
+            word3 = *(pword + wpls);
+            red = (word1 >> 24) + 3 * (word3 >> 24);
+            green = ((word1 >> 16) & 0xff) +
+                      3 * ((word3 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) +
+                      3 * ((word3 >> 8) & 0xff);
+            *(lined + j) = ((red << 22) & 0xff000000) |
+                           ((green << 14) & 0x00ff0000) |
+                           ((blue << 6) & 0x0000ff00);
+            break;
+        case 13:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = 3 * (word1 >> 24) + (word2 >> 24) +
+                  9 * (word3 >> 24) + 3 * (word4 >> 24);
+            green = 3 * ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
+                    9 * ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
+            blue = 3 *((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
+                   9 * ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 20) & 0xff000000) |
+                           ((green << 12) & 0x00ff0000) |
+                           ((blue << 4) & 0x0000ff00);
+            break;
+        case 14:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = (word1 >> 24) + (word2 >> 24) +
+                  3 * (word3 >> 24) + 3 * (word4 >> 24);
+            green = ((word1 >> 16) & 0xff) +((word2 >> 16) & 0xff) +
+                    3 * ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
+                   3 * ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 21) & 0xff000000) |
+                           ((green << 13) & 0x00ff0000) |
+                           ((blue << 5) & 0x0000ff00);
+            break;
+        case 15:
+            word1 = *pword;
+            word2 = *(pword + 1);
+            word3 = *(pword + wpls);
+            word4 = *(pword + wpls + 1);
+            red = (word1 >> 24) + 3 * (word2 >> 24) +
+                  3 * (word3 >> 24) + 9 * (word4 >> 24);
+            green = ((word1 >> 16) & 0xff) + 3 * ((word2 >> 16) & 0xff) +
+                    3 * ((word3 >> 16) & 0xff) + 9 * ((word4 >> 16) & 0xff);
+            blue = ((word1 >> 8) & 0xff) + 3 * ((word2 >> 8) & 0xff) +
+                   3 * ((word3 >> 8) & 0xff) + 9 * ((word4 >> 8) & 0xff);
+            *(lined + j) = ((red << 20) & 0xff000000) |
+                           ((green << 12) & 0x00ff0000) |
+                           ((blue << 4) & 0x0000ff00);
+            break;
+        default:
+            fprintf(stderr, "shouldn't get here\n");
+            break;
+        }
+    }
+}
+
+
+    /* Each of the vector kernels below returns the number of dest
+     * pixels it has made at the start of the line; the rest are made
+     * by the caller.  The source locations are found with a multiply
+     * and an add (not fused) in float, and truncated, as in the
+     * scalar code.  The weighted sums of the 4 source pixels are at
+     * most 255 * 256 + 128, so they are made in 16 bit lanes, with the
+     * red and green (or blue and alpha) components of a 32 bpp pixel
+     * in the two halves of a 32 bit lane.  Source pixels outside
+     * the image are not fetched; the fill value is put in their place.
+     * There is no SSE2 kernel for 8 bpp, because without a gather
+     * the bytes are fetched one at a time, and that is no faster
+     * than the scalar code. */
+#if L_HAVE_SSE2
+static l_int32
+rotateAMColorLineSse2(l_uint32         *lined,
+                      ROTATEAM_PARAMS  *params,
+                      l_float32         rx,
+                      l_float32         ry)
+{
+l_int32    j, k, n, wpls;
+l_int32    xp[4], yp[4], out[4];
+l_uint32   w00[4], w10[4], w01[4], w11[4];
+l_uint32  *lines;
+__m128     vuf, vsin, vcos, vrx, vry;
+__m128i    vu, vramp, vxcen, vycen, vwm2, vhm2, vxpm, vypm, vxp, vyp, vout;
+__m128i    vxf, vyf, vxf1, vyf1, va, vb, vc, vd, vmask, vround, vfill;
+__m128i    v15, v16, vzero, vs00, vs10, vs01, vs11, veven, vodd;
 
-            lines = datas + yp * wpls;
-            pword = lines + xp;
-
-            switch (xf + 4 * yf)
-            {
-            case 0:
-                *(lined + j) = *pword;
-                break;
-            case 1:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                red = 3 * (word1 >> 24) + (word2 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) +
-                            ((word2 >> 16) & 0xff);
-                blue = 3 * ((word1 >> 8) & 0xff) +
-                            ((word2 >> 8) & 0xff);
-                *(lined + j) = ((red << 22) & 0xff000000) |
-                               ((green << 14) & 0x00ff0000) |
-                               ((blue << 6) & 0x0000ff00);
-                break;
-            case 2:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                red = (word1 >> 24) + (word2 >> 24);
-                green = ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff);
-                *(lined + j) = ((red << 23) & 0xff000000) |
-                               ((green << 15) & 0x00ff0000) |
-                               ((blue << 7) & 0x0000ff00);
-                break;
-            case 3:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                red = (word1 >> 24) + 3 * (word2 >> 24);
-                green = ((word1 >> 16) & 0xff) +
-                          3 * ((word2 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) +
-                          3 * ((word2 >> 8) & 0xff);
-                *(lined + j) = ((red << 22) & 0xff000000) |
-                               ((green << 14) & 0x00ff0000) |
-                               ((blue << 6) & 0x0000ff00);
-                break;
-            case 4:
-                word1 = *pword;
-                word3 = *(pword + wpls);
-                red = 3 * (word1 >> 24) + (word3 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) +
-                            ((word3 >> 16) & 0xff);
-                blue = 3 * ((word1 >> 8) & 0xff) +
-                            ((word3 >> 8) & 0xff);
-                *(lined + j) = ((red << 22) & 0xff000000) |
-                               ((green << 14) & 0x00ff0000) |
-                               ((blue << 6) & 0x0000ff00);
-                break;
-            case 5:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = 9 * (word1 >> 24) + 3 * (word2 >> 24) +
-                      3 * (word3 >> 24) + (word4 >> 24);
-                green = 9 * ((word1 >> 16) & 0xff) +
-                        3 * ((word2 >> 16) & 0xff) +
-                        3 * ((word3 >> 16) & 0xff) +
-                        ((word4 >> 16) & 0xff);
-                blue = 9 * ((word1 >> 8) & 0xff) +
-                       3 * ((word2 >> 8) & 0xff) +
-                       3 * ((word3 >> 8) & 0xff) +
-                       ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 20) & 0xff000000) |
-                               ((green << 12) & 0x00ff0000) |
-                               ((blue << 4) & 0x0000ff00);
-                break;
-            case 6:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = 3 * (word1 >> 24) +  3 * (word2 >> 24) +
-                      (word3 >> 24) + (word4 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) +
-                        3 * ((word2 >> 16) & 0xff) +
-                        ((word3 >> 16) & 0xff) +
-                        ((word4 >> 16) & 0xff);
-                blue = 3 * ((word1 >> 8) & 0xff) +
-                       3 * ((word2 >> 8) & 0xff) +
-                       ((word3 >> 8) & 0xff) +
-                       ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 21) & 0xff000000) |
-                               ((green << 13) & 0x00ff0000) |
-                               ((blue << 5) & 0x0000ff00);
-                break;
-            case 7:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = 3 * (word1 >> 24) + 9 * (word2 >> 24) +
-                      (word3 >> 24) + 3 * (word4 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) +
-                        9 * ((word2 >> 16) & 0xff) +
-                        ((word3 >> 16) & 0xff) +
-                        3 * ((word4 >> 16) & 0xff);
-                blue = 3 * ((word1 >> 8) & 0xff) +
-                       9 * ((word2 >> 8) & 0xff) +
-                         ((word3 >> 8) & 0xff) +
-                         3 * ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 20) & 0xff000000) |
-                               ((green << 12) & 0x00ff0000) |
-                               ((blue << 4) & 0x0000ff00);
-                break;
-            case 8:
-                word1 = *pword;
-                word3 = *(pword + wpls);
-                red = (word1 >> 24) + (word3 >> 24);
-                green = ((word1 >> 16) & 0xff) + ((word3 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + ((word3 >> 8) & 0xff);
-                *(lined + j) = ((red << 23) & 0xff000000) |
-                               ((green << 15) & 0x00ff0000) |
-                               ((blue << 7) & 0x0000ff00);
-                break;
-            case 9:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = 3 * (word1 >> 24) + (word2 >> 24) +
-                      3 * (word3 >> 24) + (word4 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
-                        3 * ((word3 >> 16) & 0xff) + ((word4 >> 16) & 0xff);
-                blue = 3 * ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
-                       3 * ((word3 >> 8) & 0xff) + ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 21) & 0xff000000) |
-                               ((green << 13) & 0x00ff0000) |
-                               ((blue << 5) & 0x0000ff00);
-                break;
-            case 10:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = (word1 >> 24) + (word2 >> 24) +
-                      (word3 >> 24) + (word4 >> 24);
-                green = ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
-                        ((word3 >> 16) & 0xff) + ((word4 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
-                       ((word3 >> 8) & 0xff) + ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 22) & 0xff000000) |
-                               ((green << 14) & 0x00ff0000) |
-                               ((blue << 6) & 0x0000ff00);
-                break;
-            case 11:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = (word1 >> 24) + 3 * (word2 >> 24) +
-                      (word3 >> 24) + 3 * (word4 >> 24);
-                green = ((word1 >> 16) & 0xff) + 3 * ((word2 >> 16) & 0xff) +
-                        ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + 3 * ((word2 >> 8) & 0xff) +
-                       ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 21) & 0xff000000) |
-                               ((green << 13) & 0x00ff0000) |
-                               ((blue << 5) & 0x0000ff00);
-                break;
-            case 12:
-                word1 = *pword;
-                word3 = *(pword + wpls);
-                red = (word1 >> 24) + 3 * (word3 >> 24);
-                green = ((word1 >> 16) & 0xff) +
-                          3 * ((word3 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) +
-                          3 * ((word3 >> 8) & 0xff);
-                *(lined + j) = ((red << 22) & 0xff000000) |
-                               ((green << 14) & 0x00ff0000) |
-                               ((blue << 6) & 0x0000ff00);
-                break;
-            case 13:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = 3 * (word1 >> 24) + (word2 >> 24) +
-                      9 * (word3 >> 24) + 3 * (word4 >> 24);
-                green = 3 * ((word1 >> 16) & 0xff) + ((word2 >> 16) & 0xff) +
-                        9 * ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
-                blue = 3 *((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
-                       9 * ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 20) & 0xff000000) |
-                               ((green << 12) & 0x00ff0000) |
-                               ((blue << 4) & 0x0000ff00);
-                break;
-            case 14:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = (word1 >> 24) + (word2 >> 24) +
-                      3 * (word3 >> 24) + 3 * (word4 >> 24);
-                green = ((word1 >> 16) & 0xff) +((word2 >> 16) & 0xff) +
-                        3 * ((word3 >> 16) & 0xff) + 3 * ((word4 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + ((word2 >> 8) & 0xff) +
-                       3 * ((word3 >> 8) & 0xff) + 3 * ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 21) & 0xff000000) |
-                               ((green << 13) & 0x00ff0000) |
-                               ((blue << 5) & 0x0000ff00);
-                break;
-            case 15:
-                word1 = *pword;
-                word2 = *(pword + 1);
-                word3 = *(pword + wpls);
-                word4 = *(pword + wpls + 1);
-                red = (word1 >> 24) + 3 * (word2 >> 24) +
-                      3 * (word3 >> 24) + 9 * (word4 >> 24);
-                green = ((word1 >> 16) & 0xff) + 3 * ((word2 >> 16) & 0xff) +
-                        3 * ((word3 >> 16) & 0xff) + 9 * ((word4 >> 16) & 0xff);
-                blue = ((word1 >> 8) & 0xff) + 3 * ((word2 >> 8) & 0xff) +
-                       3 * ((word3 >> 8) & 0xff) + 9 * ((word4 >> 8) & 0xff);
-                *(lined + j) = ((red << 20) & 0xff000000) |
-                               ((green << 12) & 0x00ff0000) |
-                               ((blue << 4) & 0x0000ff00);
-                break;
-            default:
-                fprintf(stderr, "shouldn't get here\n");
-                break;
+    if (params->w < 2 || params->h < 2)
+        return 0;
+    n = params->w & ~3;
+    wpls = params->wpls;
+    vsin = _mm_set1_ps(params->sina);
+    vcos = _mm_set1_ps(params->cosa);
+    vrx = _mm_set1_ps(rx);
+    vry = _mm_set1_ps(ry);
+    vramp = _mm_setr_epi32(0, 1, 2, 3);
+    vxcen = _mm_set1_epi32(params->xcen);
+    vycen = _mm_set1_epi32(params->ycen);
+    vwm2 = _mm_set1_epi32(params->w - 2);
+    vhm2 = _mm_set1_epi32(params->h - 2);
+    v15 = _mm_set1_epi32(15);
+    v16 = _mm_set1_epi32(16);
+    vzero = _mm_setzero_si128();
+    vmask = _mm_set1_epi32(0x00ff00ff);
+    vround = _mm_set1_epi32(0x00800080);
+    vfill = _mm_set1_epi32((l_int32)params->fillval);
+    for (j = 0; j < n; j += 4) {
+        vu = _mm_add_epi32(_mm_set1_epi32(j - params->xcen), vramp);
+        vuf = _mm_cvtepi32_ps(vu);
+        vxpm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(vuf, vcos), vrx));
+        vypm = _mm_cvttps_epi32(_mm_sub_ps(vry, _mm_mul_ps(vuf, vsin)));
+        vxp = _mm_add_epi32(vxcen, _mm_srai_epi32(vxpm, 4));
+        vyp = _mm_add_epi32(vycen, _mm_srai_epi32(vypm, 4));
+        vout = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(vxp, vzero),
+                                         _mm_cmplt_epi32(vyp, vzero)),
+                            _mm_or_si128(_mm_cmpgt_epi32(vxp, vwm2),
+                                         _mm_cmpgt_epi32(vyp, vhm2)));
+        _mm_storeu_si128((__m128i *)xp, vxp);
+        _mm_storeu_si128((__m128i *)yp, vyp);
+        _mm_storeu_si128((__m128i *)out, vout);
+        for (k = 0; k < 4; k++) {
+            if (out[k]) {
+                w00[k] = w10[k] = w01[k] = w11[k] = 0;
+                continue;
             }
+            lines = params->datas + yp[k] * wpls + xp[k];
+            w00[k] = lines[0];
+            w10[k] = lines[1];
+            w01[k] = lines[wpls];
+            w11[k] = lines[wpls + 1];
         }
+        vs00 = _mm_loadu_si128((__m128i *)w00);
+        vs10 = _mm_loadu_si128((__m128i *)w10);
+        vs01 = _mm_loadu_si128((__m128i *)w01);
+        vs11 = _mm_loadu_si128((__m128i *)w11);
+
+            /* Weights, in both halves of each lane */
+        vxf = _mm_and_si128(vxpm, v15);
+        vyf = _mm_and_si128(vypm, v15);
+        vxf1 = _mm_sub_epi32(v16, vxf);
+        vyf1 = _mm_sub_epi32(v16, vyf);
+        va = _mm_mullo_epi16(vxf1, vyf1);
+        vb = _mm_mullo_epi16(vxf, vyf1);
+        vc = _mm_mullo_epi16(vxf1, vyf);
+        vd = _mm_mullo_epi16(vxf, vyf);
+        va = _mm_or_si128(va, _mm_slli_epi32(va, 16));
+        vb = _mm_or_si128(vb, _mm_slli_epi32(vb, 16));
+        vc = _mm_or_si128(vc, _mm_slli_epi32(vc, 16));
+        vd = _mm_or_si128(vd, _mm_slli_epi32(vd, 16));
+
+        veven = _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(vs00, vmask), va),
+                          _mm_mullo_epi16(_mm_and_si128(vs10, vmask), vb)),
+            _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(vs01, vmask), vc),
+                          _mm_mullo_epi16(_mm_and_si128(vs11, vmask), vd)));
+        vs00 = _mm_and_si128(_mm_srli_epi32(vs00, 8), vmask);
+        vs10 = _mm_and_si128(_mm_srli_epi32(vs10, 8), vmask);
+        vs01 = _mm_and_si128(_mm_srli_epi32(vs01, 8), vmask);
+        vs11 = _mm_and_si128(_mm_srli_epi32(vs11, 8), vmask);
+        vodd = _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(vs00, va),
+                          _mm_mullo_epi16(vs10, vb)),
+            _mm_add_epi16(_mm_mullo_epi16(vs01, vc),
+                          _mm_mullo_epi16(vs11, vd)));
+        veven = _mm_srli_epi16(_mm_add_epi16(veven, vround), 8);
+        vodd = _mm_srli_epi16(_mm_add_epi16(vodd, vround), 8);
+        vs00 = _mm_or_si128(veven, _mm_slli_epi32(vodd, 8));
+        vs00 = _mm_and_si128(vs00,
+                             _mm_set1_epi32(~(0xffU << L_ALPHA_SHIFT)));
+        vs00 = _mm_or_si128(_mm_andnot_si128(vout, vs00),
+                            _mm_and_si128(vout, vfill));
+        _mm_storeu_si128((__m128i *)(lined + j), vs00);
     }
+    return n;
+}
+#endif  /* L_HAVE_SSE2 */
 
-    return;
+#if L_HAVE_AVX2
+static l_int32
+rotateAMColorLineAvx2(l_uint32         *lined,
+                      ROTATEAM_PARAMS  *params,
+                      l_float32         rx,
+                      l_float32         ry)
+{
+l_int32        j, n;
+const int     *pdata;
+__m256         vuf, vsin, vcos, vrx, vry;
+__m256i        vu, vramp, vxcen, vycen, vwm2, vhm2, vxpm, vypm, vxp, vyp;
+__m256i        vout, vin, vidx, vxf, vyf, vxf1, vyf1, va, vb, vc, vd;
+__m256i        vmask, vround, vfill, v15, v16, vzero, vones, vwpls;
+__m256i        vs00, vs10, vs01, vs11, veven, vodd;
+
+    if (params->w < 2 || params->h < 2)
+        return 0;
+    n = params->w & ~7;
+    pdata = (const int *)params->datas;
+    vwpls = _mm256_set1_epi32(params->wpls);
+    vsin = _mm256_set1_ps(params->sina);
+    vcos = _mm256_set1_ps(params->cosa);
+    vrx = _mm256_set1_ps(rx);
+    vry = _mm256_set1_ps(ry);
+    vramp = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    vxcen = _mm256_set1_epi32(params->xcen);
+    vycen = _mm256_set1_epi32(params->ycen);
+    vwm2 = _mm256_set1_epi32(params->w - 2);
+    vhm2 = _mm256_set1_epi32(params->h - 2);
+    v15 = _mm256_set1_epi32(15);
+    v16 = _mm256_set1_epi32(16);
+    vzero = _mm256_setzero_si256();
+    vones = _mm256_set1_epi32(-1);
+    vmask = _mm256_set1_epi32(0x00ff00ff);
+    vround = _mm256_set1_epi32(0x00800080);
+    vfill = _mm256_set1_epi32((l_int32)params->fillval);
+    for (j = 0; j < n; j += 8) {
+        vu = _mm256_add_epi32(_mm256_set1_epi32(j - params->xcen), vramp);
+        vuf = _mm256_cvtepi32_ps(vu);
+        vxpm = _mm256_cvttps_epi32(
+                   _mm256_add_ps(_mm256_mul_ps(vuf, vcos), vrx));
+        vypm = _mm256_cvttps_epi32(
+                   _mm256_sub_ps(vry, _mm256_mul_ps(vuf, vsin)));
+        vxp = _mm256_add_epi32(vxcen, _mm256_srai_epi32(vxpm, 4));
+        vyp = _mm256_add_epi32(vycen, _mm256_srai_epi32(vypm, 4));
+        vout = _mm256_or_si256(
+                   _mm256_or_si256(_mm256_cmpgt_epi32(vzero, vxp),
+                                   _mm256_cmpgt_epi32(vzero, vyp)),
+                   _mm256_or_si256(_mm256_cmpgt_epi32(vxp, vwm2),
+                                   _mm256_cmpgt_epi32(vyp, vhm2)));
+        vin = _mm256_xor_si256(vout, vones);
+        vidx = _mm256_add_epi32(_mm256_mullo_epi32(vyp, vwpls), vxp);
+        vs00 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx, vin, 4);
+        vs10 = _mm256_mask_i32gather_epi32(vzero, pdata + 1, vidx, vin, 4);
+        vidx = _mm256_add_epi32(vidx, vwpls);
+        vs01 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx, vin, 4);
+        vs11 = _mm256_mask_i32gather_epi32(vzero, pdata + 1, vidx, vin, 4);
+
+        vxf = _mm256_and_si256(vxpm, v15);
+        vyf = _mm256_and_si256(vypm, v15);
+        vxf1 = _mm256_sub_epi32(v16, vxf);
+        vyf1 = _mm256_sub_epi32(v16, vyf);
+        va = _mm256_mullo_epi16(vxf1, vyf1);
+        vb = _mm256_mullo_epi16(vxf, vyf1);
+        vc = _mm256_mullo_epi16(vxf1, vyf);
+        vd = _mm256_mullo_epi16(vxf, vyf);
+        va = _mm256_or_si256(va, _mm256_slli_epi32(va, 16));
+        vb = _mm256_or_si256(vb, _mm256_slli_epi32(vb, 16));
+        vc = _mm256_or_si256(vc, _mm256_slli_epi32(vc, 16));
+        vd = _mm256_or_si256(vd, _mm256_slli_epi32(vd, 16));
+
+        veven = _mm256_add_epi16(
+            _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_and_si256(vs00, vmask), va),
+                _mm256_mullo_epi16(_mm256_and_si256(vs10, vmask), vb)),
+            _mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_and_si256(vs01, vmask), vc),
+                _mm256_mullo_epi16(_mm256_and_si256(vs11, vmask), vd)));
+        vs00 = _mm256_and_si256(_mm256_srli_epi32(vs00, 8), vmask);
+        vs10 = _mm256_and_si256(_mm256_srli_epi32(vs10, 8), vmask);
+        vs01 = _mm256_and_si256(_mm256_srli_epi32(vs01, 8), vmask);
+        vs11 = _mm256_and_si256(_mm256_srli_epi32(vs11, 8), vmask);
+        vodd = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(vs00, va),
+                             _mm256_mullo_epi16(vs10, vb)),
+            _mm256_add_epi16(_mm256_mullo_epi16(vs01, vc),
+                             _mm256_mullo_epi16(vs11, vd)));
+        veven = _mm256_srli_epi16(_mm256_add_epi16(veven, vround), 8);
+        vodd = _mm256_srli_epi16(_mm256_add_epi16(vodd, vround), 8);
+        vs00 = _mm256_or_si256(veven, _mm256_slli_epi32(vodd, 8));
+        vs00 = _mm256_and_si256(vs00,
+                   _mm256_set1_epi32(~(0xffU << L_ALPHA_SHIFT)));
+        vs00 = _mm256_blendv_epi8(vs00, vfill, vout);
+        _mm256_storeu_si256((__m256i *)(lined + j), vs00);
+    }
+    return n;
+}
+
+
+static l_int32
+rotateAMGrayLineAvx2(l_uint32         *lined,
+                     ROTATEAM_PARAMS  *params,
+                     l_float32         rx,
+                     l_float32         ry)
+{
+l_int32        j, n;
+const int     *pdata;
+__m256         vuf, vsin, vcos, vrx, vry;
+__m256i        vu, vramp, vxcen, vycen, vwm2, vhm2, vxpm, vypm, vxp, vyp;
+__m256i        vout, vin, vidx0, vidx1, vsh0, vsh1, vxf, vyf, vxf1, vyf1;
+__m256i        vround, vfill, vbyte, v1, v3, v15, v16, vzero, vones, vwpls;
+__m256i        vp00, vp10, vp01, vp11, vsum, vshuf;
+
+    if (params->w < 2 || params->h < 2)
+        return 0;
+    n = params->w & ~7;
+    pdata = (const int *)params->datas;
+    vwpls = _mm256_set1_epi32(params->wpls);
+    vsin = _mm256_set1_ps(params->sina);
+    vcos = _mm256_set1_ps(params->cosa);
+    vrx = _mm256_set1_ps(rx);
+    vry = _mm256_set1_ps(ry);
+    vramp = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    vxcen = _mm256_set1_epi32(params->xcen);
+    vycen = _mm256_set1_epi32(params->ycen);
+    vwm2 = _mm256_set1_epi32(params->w - 2);
+    vhm2 = _mm256_set1_epi32(params->h - 2);
+    v1 = _mm256_set1_epi32(1);
+    v3 = _mm256_set1_epi32(3);
+    v15 = _mm256_set1_epi32(15);
+    v16 = _mm256_set1_epi32(16);
+    vzero = _mm256_setzero_si256();
+    vones = _mm256_set1_epi32(-1);
+    vbyte = _mm256_set1_epi32(0xff);
+    vround = _mm256_set1_epi32(128);
+    vfill = _mm256_set1_epi32((l_int32)params->fillval);
+
+        /* Gathers the low bytes of 4 lanes into a word, with the
+         * first pixel in the MSB, in each half */
+    vshuf = _mm256_setr_epi8(12, 8, 4, 0, -1, -1, -1, -1,
+                             -1, -1, -1, -1, -1, -1, -1, -1,
+                             12, 8, 4, 0, -1, -1, -1, -1,
+                             -1, -1, -1, -1, -1, -1, -1, -1);
+    for (j = 0; j < n; j += 8) {
+        vu = _mm256_add_epi32(_mm256_set1_epi32(j - params->xcen), vramp);
+        vuf = _mm256_cvtepi32_ps(vu);
+        vxpm = _mm256_cvttps_epi32(
+                   _mm256_add_ps(_mm256_mul_ps(vuf, vcos), vrx));
+        vypm = _mm256_cvttps_epi32(
+                   _mm256_sub_ps(vry, _mm256_mul_ps(vuf, vsin)));
+        vxp = _mm256_add_epi32(vxcen, _mm256_srai_epi32(vxpm, 4));
+        vyp = _mm256_add_epi32(vycen, _mm256_srai_epi32(vypm, 4));
+        vout = _mm256_or_si256(
+                   _mm256_or_si256(_mm256_cmpgt_epi32(vzero, vxp),
+                                   _mm256_cmpgt_epi32(vzero, vyp)),
+                   _mm256_or_si256(_mm256_cmpgt_epi32(vxp, vwm2),
+                                   _mm256_cmpgt_epi32(vyp, vhm2)));
+        vin = _mm256_xor_si256(vout, vones);
+
+            /* Words holding pixels xp and xp + 1, and the shifts
+             * that bring them to the low byte */
+        vidx0 = _mm256_mullo_epi32(vyp, vwpls);
+        vidx1 = _mm256_add_epi32(vidx0,
+                    _mm256_srli_epi32(_mm256_add_epi32(vxp, v1), 2));
+        vidx0 = _mm256_add_epi32(vidx0, _mm256_srli_epi32(vxp, 2));
+        vsh0 = _mm256_slli_epi32(
+                   _mm256_sub_epi32(v3, _mm256_and_si256(vxp, v3)), 3);
+        vsh1 = _mm256_slli_epi32(_mm256_sub_epi32(v3,
+                   _mm256_and_si256(_mm256_add_epi32(vxp, v1), v3)), 3);
+        vp00 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx0, vin, 4);
+        vp10 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx1, vin, 4);
+        vidx0 = _mm256_add_epi32(vidx0, vwpls);
+        vidx1 = _mm256_add_epi32(vidx1, vwpls);
+        vp01 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx0, vin, 4);
+        vp11 = _mm256_mask_i32gather_epi32(vzero, pdata, vidx1, vin, 4);
+        vp00 = _mm256_and_si256(_mm256_srlv_epi32(vp00, vsh0), vbyte);
+        vp10 = _mm256_and_si256(_mm256_srlv_epi32(vp10, vsh1), vbyte);
+        vp01 = _mm256_and_si256(_mm256_srlv_epi32(vp01, vsh0), vbyte);
+        vp11 = _mm256_and_si256(_mm256_srlv_epi32(vp11, vsh1), vbyte);
+
+        vxf = _mm256_and_si256(vxpm, v15);
+        vyf = _mm256_and_si256(vypm, v15);
+        vxf1 = _mm256_sub_epi32(v16, vxf);
+        vyf1 = _mm256_sub_epi32(v16, vyf);
+        vsum = _mm256_add_epi32(
+            _mm256_add_epi32(
+                _mm256_mullo_epi16(vp00, _mm256_mullo_epi16(vxf1, vyf1)),
+                _mm256_mullo_epi16(vp10, _mm256_mullo_epi16(vxf, vyf1))),
+            _mm256_add_epi32(
+                _mm256_mullo_epi16(vp01, _mm256_mullo_epi16(vxf1, vyf)),
+                _mm256_mullo_epi16(vp11, _mm256_mullo_epi16(vxf, vyf))));
+        vsum = _mm256_srli_epi32(_mm256_add_epi32(vsum, vround), 8);
+        vsum = _mm256_blendv_epi8(vsum, vfill, vout);
+        vsum = _mm256_shuffle_epi8(vsum, vshuf);
+        lined[j >> 2] = (l_uint32)_mm256_extract_epi32(vsum, 0);
+        lined[(j >> 2) + 1] = (l_uint32)_mm256_extract_epi32(vsum, 4);
+    }
+    return n;
 }
+#endif  /* L_HAVE_AVX2 */
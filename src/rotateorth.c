@@ -36,6 +36,16 @@
  *      90-degree rotation (both directions)
  *            PIX             *pixRotate90()
  *
+ *      90-degree rotation on blocks of pixels
+ *            static l_int32   rotate90Parts()
+ *            static l_int32   rotate90Part()
+ *            static void      rotate90Rect()
+ *            static void      transposeWords()
+ *            static l_int32   rotate90RectSse2()
+ *            static void      transposeSse2()
+ *            static l_int32   rotate90RectAvx2()
+ *            static l_int32   rotate90RectNeon()
+ *
  *      Left-right flip
  *            PIX             *pixFlipLR()
  *
@@ -50,6 +60,47 @@
 
 #include <string.h>
 #include "allheaders.h"
+#include "simd.h"
+
+    /* Source words across a column of blocks, as one 64-byte cache
+     * line from each source line; also the smallest part of the
+     * source words given to a thread */
+static const l_int32  Rotate90ChunkWords = 16;
+
+    /* Parameters for 90 degree rotation of each part of the image */
+struct Rotate90Params
+{
+    l_uint32    *datas;       /* source                                    */
+    l_int32      wpls;
+    l_uint32    *datad;       /* dest                                      */
+    l_int32      wpld;
+    l_int32      wd;          /* dest size; the source is hd x wd          */
+    l_int32      hd;
+    l_int32      d;           /* depth                                     */
+    l_int32      cw;          /* 1 for clockwise, 0 for counter-clockwise  */
+    l_int32      nparts;      /* number of parts                           */
+    l_int32      simd;        /* simd mode                                 */
+};
+typedef struct Rotate90Params  ROTATE90_PARAMS;
+
+static l_int32 rotate90Parts(ROTATE90_PARAMS *params);
+static l_int32 rotate90Part(void *data, l_int32 index);
+static void rotate90Rect(ROTATE90_PARAMS *params, l_int32 k0, l_int32 k1,
+                         l_int32 g0, l_int32 g1);
+static void transposeWords(l_uint32 *a, l_int32 d);
+#if L_HAVE_SSE2
+static l_int32 rotate90RectSse2(ROTATE90_PARAMS *params, l_int32 k0,
+                                l_int32 k1, l_int32 *pgdone);
+static void transposeSse2(__m128i *a, l_int32 d);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 rotate90RectAvx2(ROTATE90_PARAMS *params, l_int32 k0,
+                                l_int32 k1, l_int32 *pgdone) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 rotate90RectNeon(ROTATE90_PARAMS *params, l_int32 k0,
+                                l_int32 k1, l_int32 *pgdone);
+#endif  /* L_HAVE_NEON */
 
 static l_uint8 *makeReverseByteTab1(void);
 static l_uint8 *makeReverseByteTab2(void);
@@ -152,16 +203,20 @@ l_int32  d;
  *      (1) This does a 90 degree rotation of the image about the center,
  *          either cw or ccw, returning a new pix.
  *      (2) The direction must be either 1 (cw) or -1 (ccw).
+ *      (3) Rather than walking the dest pixels, which strides down
+ *          the columns of the source, the source is transposed in
+ *          square blocks of one word on each of 32/d source lines.
+ *          This reads and writes whole words for all depths, and
+ *          keeps both the source and dest lines of a block in cache.
+ *          See rotate90Part() for details.
  */
 PIX *
 pixRotate90(PIX     *pixs,
             l_int32  direction)
 {
-l_int32    wd, hd, d, wpls, wpld;
-l_int32    i, j, k, m, iend, nswords;
-l_uint32   val, word;
-l_uint32  *lines, *datas, *lined, *datad;
-PIX       *pixd;
+l_int32          wd, hd, d;
+PIX             *pixd;
+ROTATE90_PARAMS  params;
 
     PROCNAME("pixRotate90");
 
@@ -174,197 +229,532 @@ PIX       *pixd;
     if (direction != 1 && direction != -1)
         return (PIX *)ERROR_PTR("invalid direction", procName, NULL);
 
-    if ((pixd = pixCreate(wd, hd, d)) == NULL)
+    if ((pixd = pixCreateNoInit(wd, hd, d)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     pixCopyColormap(pixd, pixs);
     pixCopyResolution(pixd, pixs);
     pixCopyInputFormat(pixd, pixs);
 
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
+    memset(&params, 0, sizeof(ROTATE90_PARAMS));
+    params.datas = pixGetData(pixs);
+    params.wpls = pixGetWpl(pixs);
+    params.datad = pixGetData(pixd);
+    params.wpld = pixGetWpl(pixd);
+    params.wd = wd;
+    params.hd = hd;
+    params.d = d;
+    params.cw = (direction == 1) ? 1 : 0;
+    if (rotate90Parts(&params)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("pixd not rotated", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*------------------------------------------------------------------*
+ *               90 degree rotation on blocks of pixels             *
+ *------------------------------------------------------------------*/
+/*!
+ *  rotate90Parts()
+ *
+ *      Input:  params (ROTATE90_PARAMS, with all but nparts and simd set)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The words on the source lines are divided into one part
+ *          for each thread, each with at least Rotate90ChunkWords
+ *          words, and the parts are rotated in parallel.  The source
+ *          columns in each part go to a separate set of dest lines.
+ */
+static l_int32
+rotate90Parts(ROTATE90_PARAMS  *params)
+{
+l_int32  nswords, nparts;
+
+    PROCNAME("rotate90Parts");
+
+    nswords = (params->hd * params->d + 31) / 32;
+    nparts = L_MIN(l_getParallelThreads(), nswords / Rotate90ChunkWords);
+    params->nparts = L_MAX(1, nparts);
+    params->simd = l_getSimdMode();
+    if (l_parallelRun(params->nparts, params->nparts, rotate90Part, params))
+        return ERROR_INT("parts not rotated", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  rotate90Part()
+ *
+ *      Input:  data (ROTATE90_PARAMS)
+ *              index (of the part of the source words)
+ *      Return: 0 (always)
+ *
+ *  Notes:
+ *      (1) The source has wd lines of hd pixels.  Going clockwise,
+ *          dest line i comes from source column i, and dest column j
+ *          from source line wd - 1 - j.  Going counter-clockwise,
+ *          dest line i comes from source column hd - 1 - i, and
+ *          dest column j from source line j.
+ *      (2) With n = 32 / d pixels in a word, word k on the n source
+ *          lines that go to dest word g (dest columns n * g to
+ *          n * g + n - 1) make a block of n x n pixels.  Transposed,
+ *          it is word g on the n dest lines that come from source
+ *          columns n * k to n * k + n - 1.  Every dest word, including
+ *          the padding at the end of each line, is written once.
+ *      (3) The source words are taken in columns of Rotate90ChunkWords,
+ *          and each column goes down all of the dest words.  Each
+ *          source line is then read in whole cache lines, and only
+ *          the dest lines for one column of words are written at
+ *          a time.
+ *      (4) The vector kernels transpose larger blocks, of 16 or 32
+ *          bytes on each line, for 8, 16 and 32 bpp.  The blocks they
+ *          do not cover are done here one word at a time.
+ */
+static l_int32
+rotate90Part(void    *data,
+             l_int32  index)
+{
+l_int32           k0, k1, kc, kend, kdone, gdone, nswords;
+ROTATE90_PARAMS  *params;
 
-    if (direction == 1) {  /* clockwise */
-        switch (d)
+    params = (ROTATE90_PARAMS *)data;
+    nswords = (params->hd * params->d + 31) / 32;
+    k0 = (nswords * index) / params->nparts;
+    k1 = (nswords * (index + 1)) / params->nparts;
+    for (kc = k0; kc < k1; kc += Rotate90ChunkWords) {
+        kend = L_MIN(kc + Rotate90ChunkWords, k1);
+        kdone = gdone = 0;
+        switch (params->simd)
         {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[i];
-                        lines -= wpls;
-                    }
-                }
-                break;
-            case 16:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_TWO_BYTES(lines, i)))
-                            SET_DATA_TWO_BYTES(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
-            case 4:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_QBIT(lines, i)))
-                            SET_DATA_QBIT(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
-            case 2:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_DIBIT(lines, i)))
-                            SET_DATA_DIBIT(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined += 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, j);
-                                lined += wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, j);
-                        lined += wpld;
-                    }
-                }
-                break;
-            default:
-                pixDestroy(&pixd);
-                L_ERROR("illegal depth: %d\n", procName, d);
-                break;
+#if L_HAVE_AVX2
+        case L_SIMD_AVX2:
+            if (params->d == 32)
+                kdone = rotate90RectAvx2(params, kc, kend, &gdone);
+            else
+                kdone = rotate90RectSse2(params, kc, kend, &gdone);
+            break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+        case L_SIMD_SSE2:
+            kdone = rotate90RectSse2(params, kc, kend, &gdone);
+            break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+        case L_SIMD_NEON:
+            kdone = rotate90RectNeon(params, kc, kend, &gdone);
+            break;
+#endif  /* L_HAVE_NEON */
+        default:
+            break;
         }
-    } else  {     /* direction counter-clockwise */
-        switch (d)
-        {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[hd - 1 - i];
-                        lines += wpls;
-                    }
-                }
-                break;
-            case 16:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_TWO_BYTES(lines, hd - 1 - i)))
-                            SET_DATA_TWO_BYTES(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, hd - 1 - i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
-            case 4:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_QBIT(lines, hd - 1 - i)))
-                            SET_DATA_QBIT(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
-            case 2:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_DIBIT(lines, hd - 1 - i)))
-                            SET_DATA_DIBIT(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad + (hd - 1) * wpld;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined -= 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, wd - 1 - j);
-                                lined -= wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, wd - 1 - j);
-                        lined -= wpld;
+        rotate90Rect(params, kc, kc + kdone, gdone, params->wpld);
+        rotate90Rect(params, kc + kdone, kend, 0, params->wpld);
+    }
+    return 0;
+}
+
+
+/*!
+ *  rotate90Rect()
+ *
+ *      Input:  params (ROTATE90_PARAMS)
+ *              k0, k1 (range of source words)
+ *              g0, g1 (range of dest words)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This rotates the blocks of one word on each line described
+ *          in rotate90Part().  Source lines beyond the dest width
+ *          give 0 in the padding of the dest words.
+ */
+static void
+rotate90Rect(ROTATE90_PARAMS  *params,
+             l_int32           k0,
+             l_int32           k1,
+             l_int32           g0,
+             l_int32           g1)
+{
+l_int32    i, j, k, g, n, d, cw, wd, hd, wpls, wpld, col;
+l_uint32   any;
+l_uint32   a[32];
+l_uint32  *datas, *datad, *lines;
+l_uint32  *rows[32];
+
+    datas = params->datas;
+    wpls = params->wpls;
+    datad = params->datad;
+    wpld = params->wpld;
+    wd = params->wd;
+    hd = params->hd;
+    d = params->d;
+    cw = params->cw;
+
+    if (d == 32) {
+        for (g = g0; g < g1; g++) {
+            lines = datas + wpls * (cw ? wd - 1 - g : g);
+            if (cw) {
+                for (k = k0; k < k1; k++)
+                    datad[wpld * k + g] = lines[k];
+            } else {
+                for (k = k0; k < k1; k++)
+                    datad[wpld * (hd - 1 - k) + g] = lines[k];
+            }
+        }
+        return;
+    }
+
+    n = 32 / d;
+    for (g = g0; g < g1; g++) {
+        for (i = 0; i < n; i++) {
+            j = n * g + i;
+            if (j < wd)
+                rows[i] = datas + wpls * (cw ? wd - 1 - j : j);
+            else
+                rows[i] = NULL;
+        }
+        for (k = k0; k < k1; k++) {
+            any = 0;
+            for (i = 0; i < n; i++) {
+                a[i] = (rows[i]) ? rows[i][k] : 0;
+                any |= a[i];
+            }
+            if (any)
+                transposeWords(a, d);
+            for (i = 0; i < n; i++) {
+                col = n * k + i;
+                if (col >= hd)
+                    break;
+                datad[wpld * (cw ? col : hd - 1 - col) + g] = a[i];
+            }
+        }
+    }
+}
+
+
+/*!
+ *  transposeWords()
+ *
+ *      Input:  a (array of n = 32/d words, one from each of n lines)
+ *              d (depth: 1, 2, 4, 8 or 16)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This transposes the n x n block of pixels in place, so
+ *          that pixel j of word i goes to pixel i of word j.  As for
+ *          GET_DATA_BIT() etc., pixel 0 is in the MSB of the word.
+ *      (2) The two off-diagonal quadrants of the block are swapped,
+ *          then those within each quadrant, and so on, down to single
+ *          pixels.  For d = 1, this is the 32 x 32 bit matrix
+ *          transpose in "Hacker's Delight", section 7-3.
+ */
+static void
+transposeWords(l_uint32  *a,
+               l_int32    d)
+{
+l_int32   j, k, n, shift;
+l_uint32  mask, t;
+
+    n = 32 / d;
+    mask = 0x0000ffff;
+    for (shift = 16; shift >= d; shift >>= 1, mask ^= mask << shift) {
+        j = shift / d;  /* lines between the swapped quadrants */
+        for (k = 0; k < n; k = (k + j + 1) & ~j) {
+            t = (a[k] ^ (a[k + j] >> shift)) & mask;
+            a[k] ^= t;
+            a[k + j] ^= t << shift;
+        }
+    }
+}
+
+
+#if L_HAVE_SSE2
+/*!
+ *  rotate90RectSse2()
+ *
+ *      Input:  params (ROTATE90_PARAMS)
+ *              k0, k1 (range of source words)
+ *              &gdone (<return> dest words done on each line)
+ *      Return: number of source words done, from k0
+ *
+ *  Notes:
+ *      (1) For 8, 16 and 32 bpp, this transposes blocks of 4 words,
+ *          or m = 128 / d pixels, on each of m lines.
+ *      (2) Pixel j of a word is at element j ^ (32/d - 1) in memory.
+ *          The source lines are taken in the same order, so that the
+ *          transposed pixels are in the order of the dest words.
+ *      (3) Only whole blocks are done, for which all of the source
+ *          columns and all of the dest columns are in the image.
+ */
+static l_int32
+rotate90RectSse2(ROTATE90_PARAMS  *params,
+                 l_int32           k0,
+                 l_int32           k1,
+                 l_int32          *pgdone)
+{
+l_int32    i, j, k, g, n, m, x, d, cw, wd, hd, wpls, wpld;
+l_int32    kend, gend, col;
+l_uint32  *datas, *datad;
+l_uint32  *rows[16];
+__m128i    a[16];
+
+    *pgdone = 0;
+    d = params->d;
+    if (d < 8)
+        return 0;
+    datas = params->datas;
+    wpls = params->wpls;
+    datad = params->datad;
+    wpld = params->wpld;
+    wd = params->wd;
+    hd = params->hd;
+    cw = params->cw;
+    n = 32 / d;  /* pixels in a word */
+    m = 4 * n;  /* pixels in a block line, and lines in a block */
+    x = n - 1;
+    kend = k0 + 4 * ((L_MIN(k1, hd / n) - k0) / 4);
+    gend = 4 * (wd / m);
+    if (kend <= k0 || gend == 0)
+        return 0;
+
+    for (g = 0; g < gend; g += 4) {
+        for (i = 0; i < m; i++) {
+            j = n * g + (i ^ x);
+            rows[i] = datas + wpls * (cw ? wd - 1 - j : j);
+        }
+        for (k = k0; k < kend; k += 4) {
+            for (i = 0; i < m; i++)
+                a[i] = _mm_loadu_si128((__m128i *)(rows[i] + k));
+            transposeSse2(a, d);
+            for (i = 0; i < m; i++) {
+                col = n * k + (i ^ x);
+                if (!cw)
+                    col = hd - 1 - col;
+                _mm_storeu_si128((__m128i *)(datad + wpld * col + g), a[i]);
+            }
+        }
+    }
+
+    *pgdone = gend;
+    return kend - k0;
+}
+
+
+/*!
+ *  transposeSse2()
+ *
+ *      Input:  a (array of m = 128/d vectors, one from each of m lines)
+ *              d (depth: 8, 16 or 32)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This transposes the m x m block of d-bit elements in place.
+ *          Each pass interleaves vector i with vector i + m/2, and
+ *          log2(m) passes complete the transpose.
+ */
+static void
+transposeSse2(__m128i  *a,
+              l_int32   d)
+{
+l_int32  i, r;
+__m128i  b[16];
+
+    if (d == 8) {
+        for (r = 0; r < 2; r++) {
+            for (i = 0; i < 8; i++) {
+                b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+                b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+            }
+            for (i = 0; i < 8; i++) {
+                a[2 * i] = _mm_unpacklo_epi8(b[i], b[i + 8]);
+                a[2 * i + 1] = _mm_unpackhi_epi8(b[i], b[i + 8]);
+            }
+        }
+    } else if (d == 16) {
+        for (r = 0; r < 3; r++) {
+            for (i = 0; i < 4; i++) {
+                b[2 * i] = _mm_unpacklo_epi16(a[i], a[i + 4]);
+                b[2 * i + 1] = _mm_unpackhi_epi16(a[i], a[i + 4]);
+            }
+            for (i = 0; i < 8; i++)
+                a[i] = b[i];
+        }
+    } else {  /* d == 32 */
+        b[0] = _mm_unpacklo_epi32(a[0], a[2]);
+        b[1] = _mm_unpackhi_epi32(a[0], a[2]);
+        b[2] = _mm_unpacklo_epi32(a[1], a[3]);
+        b[3] = _mm_unpackhi_epi32(a[1], a[3]);
+        a[0] = _mm_unpacklo_epi32(b[0], b[2]);
+        a[1] = _mm_unpackhi_epi32(b[0], b[2]);
+        a[2] = _mm_unpacklo_epi32(b[1], b[3]);
+        a[3] = _mm_unpackhi_epi32(b[1], b[3]);
+    }
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+/*!
+ *  rotate90RectAvx2()
+ *
+ *      Input:  params (ROTATE90_PARAMS)
+ *              k0, k1 (range of source words)
+ *              &gdone (<return> dest words done on each line)
+ *      Return: number of source words done, from k0
+ *
+ *  Notes:
+ *      (1) For 32 bpp, this transposes blocks of 8 x 8 pixels.
+ *          See rotate90RectSse2().
+ */
+static l_int32
+rotate90RectAvx2(ROTATE90_PARAMS  *params,
+                 l_int32           k0,
+                 l_int32           k1,
+                 l_int32          *pgdone)
+{
+l_int32    i, j, k, g, cw, wd, hd, wpls, wpld, kend, gend, col;
+l_uint32  *datas, *datad;
+l_uint32  *rows[8];
+__m256i    a[8], b[8];
+
+    *pgdone = 0;
+    datas = params->datas;
+    wpls = params->wpls;
+    datad = params->datad;
+    wpld = params->wpld;
+    wd = params->wd;
+    hd = params->hd;
+    cw = params->cw;
+    kend = k0 + 8 * ((L_MIN(k1, hd) - k0) / 8);
+    gend = 8 * (wd / 8);
+    if (kend <= k0 || gend == 0)
+        return 0;
+
+    for (g = 0; g < gend; g += 8) {
+        for (i = 0; i < 8; i++) {
+            j = g + i;
+            rows[i] = datas + wpls * (cw ? wd - 1 - j : j);
+        }
+        for (k = k0; k < kend; k += 8) {
+            for (i = 0; i < 8; i++)
+                a[i] = _mm256_loadu_si256((__m256i *)(rows[i] + k));
+            for (i = 0; i < 8; i += 2) {
+                b[i] = _mm256_unpacklo_epi32(a[i], a[i + 1]);
+                b[i + 1] = _mm256_unpackhi_epi32(a[i], a[i + 1]);
+            }
+            for (i = 0; i < 8; i += 4) {
+                a[i] = _mm256_unpacklo_epi64(b[i], b[i + 2]);
+                a[i + 1] = _mm256_unpackhi_epi64(b[i], b[i + 2]);
+                a[i + 2] = _mm256_unpacklo_epi64(b[i + 1], b[i + 3]);
+                a[i + 3] = _mm256_unpackhi_epi64(b[i + 1], b[i + 3]);
+            }
+            for (i = 0; i < 4; i++) {
+                b[i] = _mm256_permute2x128_si256(a[i], a[i + 4], 0x20);
+                b[i + 4] = _mm256_permute2x128_si256(a[i], a[i + 4], 0x31);
+            }
+            for (i = 0; i < 8; i++) {
+                col = (cw) ? k + i : hd - 1 - k - i;
+                _mm256_storeu_si256((__m256i *)(datad + wpld * col + g),
+                                    b[i]);
+            }
+        }
+    }
+
+    *pgdone = gend;
+    return kend - k0;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+/*!
+ *  rotate90RectNeon()
+ *
+ *      Input:  params (ROTATE90_PARAMS)
+ *              k0, k1 (range of source words)
+ *              &gdone (<return> dest words done on each line)
+ *      Return: number of source words done, from k0
+ *
+ *  Notes:
+ *      (1) See rotate90RectSse2().
+ */
+static l_int32
+rotate90RectNeon(ROTATE90_PARAMS  *params,
+                 l_int32           k0,
+                 l_int32           k1,
+                 l_int32          *pgdone)
+{
+l_int32       i, j, k, g, r, n, m, x, half, d, cw, wd, hd, wpls, wpld;
+l_int32       kend, gend, col;
+l_uint32     *datas, *datad;
+l_uint32     *rows[16];
+uint8x16x2_t  z8;
+uint16x8x2_t  z16;
+uint32x4x2_t  z32;
+uint32x4_t    a[16], b[16];
+
+    *pgdone = 0;
+    d = params->d;
+    if (d < 8)
+        return 0;
+    datas = params->datas;
+    wpls = params->wpls;
+    datad = params->datad;
+    wpld = params->wpld;
+    wd = params->wd;
+    hd = params->hd;
+    cw = params->cw;
+    n = 32 / d;
+    m = 4 * n;
+    x = n - 1;
+    half = m / 2;
+    kend = k0 + 4 * ((L_MIN(k1, hd / n) - k0) / 4);
+    gend = 4 * (wd / m);
+    if (kend <= k0 || gend == 0)
+        return 0;
+
+    for (g = 0; g < gend; g += 4) {
+        for (i = 0; i < m; i++) {
+            j = n * g + (i ^ x);
+            rows[i] = datas + wpls * (cw ? wd - 1 - j : j);
+        }
+        for (k = k0; k < kend; k += 4) {
+            for (i = 0; i < m; i++)
+                a[i] = vld1q_u32(rows[i] + k);
+            for (r = 1; r < m; r *= 2) {
+                for (i = 0; i < half; i++) {
+                    if (d == 8) {
+                        z8 = vzipq_u8(vreinterpretq_u8_u32(a[i]),
+                                      vreinterpretq_u8_u32(a[i + half]));
+                        b[2 * i] = vreinterpretq_u32_u8(z8.val[0]);
+                        b[2 * i + 1] = vreinterpretq_u32_u8(z8.val[1]);
+                    } else if (d == 16) {
+                        z16 = vzipq_u16(vreinterpretq_u16_u32(a[i]),
+                                        vreinterpretq_u16_u32(a[i + half]));
+                        b[2 * i] = vreinterpretq_u32_u16(z16.val[0]);
+                        b[2 * i + 1] = vreinterpretq_u32_u16(z16.val[1]);
+                    } else {
+                        z32 = vzipq_u32(a[i], a[i + half]);
+                        b[2 * i] = z32.val[0];
+                        b[2 * i + 1] = z32.val[1];
                     }
                 }
-                break;
-            default:
-                pixDestroy(&pixd);
-                L_ERROR("illegal depth: %d\n", procName, d);
-                break;
+                memcpy(a, b, m * sizeof(uint32x4_t));
+            }
+            for (i = 0; i < m; i++) {
+                col = n * k + (i ^ x);
+                if (!cw)
+                    col = hd - 1 - col;
+                vst1q_u32(datad + wpld * col + g, a[i]);
+            }
         }
     }
 
-    return pixd;
+    *pgdone = gend;
+    return kend - k0;
 }
+#endif  /* L_HAVE_NEON */
 
 
 /*------------------------------------------------------------------*
@@ -361,8 +361,8 @@ SARRAY  *sa;
     if ((sa = *psa) == NULL)
         return;
 
-    sarrayChangeRefcount(sa, -1);
-    if (sarrayGetRefcount(sa) <= 0) {
+        /* Decrement the ref count.  If it is 0, destroy the sarray. */
+    if (--sa->refcount <= 0) {
         if (sa->array) {
             for (i = 0; i < sa->n; i++) {
                 if (sa->array[i])
@@ -90,16 +90,86 @@
  *         Grayscale mipmap
  *                  l_int32    scaleMipmapLow()
  *
+ *         Table-driven general LI and area map scaling (static)
+ *                  l_int32    scaleLITableLow()
+ *                  l_int32    scaleAreaMapTableLow()
+ *                  void       scaleGrayLIHorizLow()
+ *                  void       scaleColorLIHorizLow()
+ *                  void       scaleLIVertLow()
+ *                  void       scaleAccumLineLow()
+ *
+ *  When a vector instruction set is selected (see simd.c), the
+ *  general LI and area map functions (scaleColorLILow(), etc.) are
+ *  done by the table-driven versions.  These compute the src pixel
+ *  locations and fractions for each dest column once, and then do
+ *  the interpolation separably: a horizontal pass that is done once
+ *  for each src line that is needed, and a vertical pass on 8, 16 or
+ *  32 dest pixels (or color components) at a time.  The sums are the
+ *  same as in the pixel-by-pixel code, so the results are identical.
  */
 
 #include <string.h>
 #include "allheaders.h"
+#include "simd.h"
 
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_OVERFLOW   0
 #define  DEBUG_UNROLLING  0
 #endif  /* ~NO_CONSOLE_IO */
 
+    /* Location in memory of byte @n of a raster line, as used by
+     * GET_DATA_BYTE() */
+#ifdef  L_BIG_ENDIAN
+#define  SCALE_BYTE_INDEX(n)   (n)
+#else
+#define  SCALE_BYTE_INDEX(n)   ((n) ^ 3)
+#endif  /* L_BIG_ENDIAN */
+
+static l_int32 scaleLITableLow(l_uint32 *datad, l_int32 wd, l_int32 hd,
+                               l_int32 wpld, l_uint32 *datas, l_int32 ws,
+                               l_int32 hs, l_int32 wpls, l_int32 d);
+static l_int32 scaleAreaMapTableLow(l_uint32 *datad, l_int32 wd, l_int32 hd,
+                                    l_int32 wpld, l_uint32 *datas,
+                                    l_int32 ws, l_int32 hs, l_int32 wpls,
+                                    l_int32 d);
+static void scaleGrayLIHorizLow(l_uint16 *hline, l_uint32 *lines,
+                                l_int32 *xp, l_int32 *x1, l_uint16 *xf,
+                                l_int32 wd);
+static void scaleColorLIHorizLow(l_uint16 *hline, l_uint32 *lines,
+                                 l_int32 *xp, l_int32 *x1, l_uint16 *xf,
+                                 l_int32 wd, l_int32 mode);
+static void scaleLIVertLow(l_uint8 *lined, l_uint16 *h0, l_uint16 *h1,
+                           l_int32 n, l_int32 yf, l_int32 mode);
+static void scaleAccumLineLow(l_uint32 *acc, l_uint8 *lines, l_int32 n,
+                              l_int32 wt, l_int32 mode);
+#if L_HAVE_SSE2
+static l_int32 scaleColorLIHorizSse2(l_uint16 *hline, l_uint32 *lines,
+                                     l_int32 *xp, l_int32 *x1, l_uint16 *xf,
+                                     l_int32 wd);
+static l_int32 scaleLIVertSse2(l_uint8 *lined, l_uint16 *h0, l_uint16 *h1,
+                               l_int32 n, l_int32 yf);
+static l_int32 scaleAccumLineSse2(l_uint32 *acc, l_uint8 *lines, l_int32 n,
+                                  l_int32 wt);
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_AVX2
+static l_int32 scaleLIVertAvx2(l_uint8 *lined, l_uint16 *h0, l_uint16 *h1,
+                               l_int32 n, l_int32 yf) L_TARGET_AVX2;
+static l_int32 scaleAccumLineAvx2(l_uint32 *acc, l_uint8 *lines, l_int32 n,
+                                  l_int32 wt) L_TARGET_AVX2;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_NEON
+static l_int32 scaleColorLIHorizNeon(l_uint16 *hline, l_uint32 *lines,
+                                     l_int32 *xp, l_int32 *x1, l_uint16 *xf,
+                                     l_int32 wd);
+static l_int32 scaleLIVertNeon(l_uint8 *lined, l_uint16 *h0, l_uint16 *h1,
+                               l_int32 n, l_int32 yf);
+static l_int32 scaleAccumLineNeon(l_uint32 *acc, l_uint8 *lines, l_int32 n,
+                                  l_int32 wt);
+#endif  /* L_HAVE_NEON */
+
+    /* Min dest width for using the table-driven functions */
+static const l_int32  MinSimdWidth = 16;
+
 
 /*------------------------------------------------------------------*
  *            General linear interpolated color scaling             *
@@ -134,6 +204,10 @@ l_uint32   pixels1, pixels2, pixels3, pixels4, pixel;
 l_uint32  *lines, *lined;
 l_float32  scx, scy;
 
+        /* Use the vector kernels if selected */
+    if (scaleLITableLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 32) == 0)
+        return;
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -237,6 +311,10 @@ l_uint8    val;
 l_uint32  *lines, *lined;
 l_float32  scx, scy;
 
+        /* Use the vector kernels if selected */
+    if (scaleLITableLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 8) == 0)
+        return;
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1283,6 +1361,11 @@ l_uint32   pixel00, pixel10, pixel01, pixel11, pixel;
 l_uint32  *lines, *lined;
 l_float32  scx, scy;
 
+        /* Use the vector kernels if selected */
+    if (scaleAreaMapTableLow(datad, wd, hd, wpld, datas, ws, hs, wpls,
+                              32) == 0)
+        return;
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1438,6 +1521,11 @@ l_int32    val;
 l_uint32  *lines, *lined;
 l_float32  scx, scy;
 
+        /* Use the vector kernels if selected */
+    if (scaleAreaMapTableLow(datad, wd, hd, wpld, datas, ws, hs, wpls,
+                              8) == 0)
+        return;
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -2447,3 +2535,738 @@ l_float32  ratio, w1, w2;
     LEPT_FREE(scol);
     return 0;
 }
+
+
+/*------------------------------------------------------------------*
+ *        Table-driven general LI and area map scaling              *
+ *------------------------------------------------------------------*/
+/*!
+ *  scaleLITableLow()
+ *
+ *      Input:  datad, wd, hd, wpld (dest)
+ *              datas, ws, hs, wpls (src)
+ *              d (8 or 32 bpp)
+ *      Return: 0 if the scaling has been done; 1 if it should be
+ *              done with the pixel-by-pixel code
+ *
+ *  Notes:
+ *      (1) This gives the same result as scaleGrayLILow() and
+ *          scaleColorLILow().  It is used when a vector instruction
+ *          set is selected.
+ *      (2) The value at each dest pixel is
+ *              ((16 - yf) * h(yp) + yf * h(yp + 1) + 128) / 256
+ *          where h(y) = (16 - xf) * s(y, xp) + xf * s(y, xp + 1),
+ *          and the src coordinates are clipped to the image.
+ *          h() is found for one src line at a time, and it is kept
+ *          for the next dest line, which often uses the same src
+ *          lines.  Then the vertical interpolation is done on all the
+ *          bytes of the dest line.  For 8 bpp, h() is stored in the
+ *          same byte order as the dest line, so that the padding
+ *          bytes at the end of the line (which are set to 0) are
+ *          the only ones out of order.
+ *      (3) h() is at most 16 * 255, and the sum at most 256 * 255, so
+ *          everything fits in 16 bits.
+ */
+static l_int32
+scaleLITableLow(l_uint32  *datad,
+                l_int32    wd,
+                l_int32    hd,
+                l_int32    wpld,
+                l_uint32  *datas,
+                l_int32    ws,
+                l_int32    hs,
+                l_int32    wpls,
+                l_int32    d)
+{
+l_int32    i, j, mode, nlanes, xpm, ypm, yp, y1, yf, row0, row1;
+l_int32   *xp, *x1;
+l_uint16  *xf, *hbuf0, *hbuf1, *htmp;
+l_uint32  *lines, *lined;
+l_float32  scx, scy;
+
+    if ((mode = l_getSimdMode()) == L_SIMD_NONE || wd < MinSimdWidth)
+        return 1;
+
+    nlanes = (d == 8) ? 4 * ((wd + 3) / 4) : 4 * wd;
+    xp = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    x1 = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xf = (l_uint16 *)LEPT_CALLOC(wd, sizeof(l_uint16));
+    hbuf0 = (l_uint16 *)LEPT_CALLOC(nlanes, sizeof(l_uint16));
+    hbuf1 = (l_uint16 *)LEPT_CALLOC(nlanes, sizeof(l_uint16));
+    if (!xp || !x1 || !xf || !hbuf0 || !hbuf1) {
+        LEPT_FREE(xp);
+        LEPT_FREE(x1);
+        LEPT_FREE(xf);
+        LEPT_FREE(hbuf0);
+        LEPT_FREE(hbuf1);
+        return 1;
+    }
+
+        /* The src locations are found exactly as in scaleGrayLILow() */
+    scx = 16. * (l_float32)ws / (l_float32)wd;
+    scy = 16. * (l_float32)hs / (l_float32)hd;
+    for (j = 0; j < wd; j++) {
+        xpm = (l_int32)(scx * (l_float32)j);
+        xp[j] = xpm >> 4;
+        xf[j] = xpm & 0x0f;
+        x1[j] = L_MIN(xp[j] + 1, ws - 1);
+    }
+
+    row0 = row1 = -1;  /* src lines in hbuf0 and hbuf1 */
+    for (i = 0; i < hd; i++) {
+        ypm = (l_int32)(scy * (l_float32)i);
+        yp = ypm >> 4;
+        yf = ypm & 0x0f;
+        y1 = L_MIN(yp + 1, hs - 1);
+        if (row0 != yp) {
+            if (row1 == yp) {  /* reuse */
+                htmp = hbuf0;
+                hbuf0 = hbuf1;
+                hbuf1 = htmp;
+                row1 = row0;
+            } else {
+                lines = datas + yp * wpls;
+                if (d == 8)
+                    scaleGrayLIHorizLow(hbuf0, lines, xp, x1, xf, wd);
+                else
+                    scaleColorLIHorizLow(hbuf0, lines, xp, x1, xf, wd, mode);
+            }
+            row0 = yp;
+        }
+        if (row1 != y1) {
+            lines = datas + y1 * wpls;
+            if (d == 8)
+                scaleGrayLIHorizLow(hbuf1, lines, xp, x1, xf, wd);
+            else
+                scaleColorLIHorizLow(hbuf1, lines, xp, x1, xf, wd, mode);
+            row1 = y1;
+        }
+
+        lined = datad + i * wpld;
+        scaleLIVertLow((l_uint8 *)lined, hbuf0, hbuf1, nlanes, yf, mode);
+        if (d == 32) {  /* the alpha byte is 0 */
+            for (j = 0; j < wd; j++)
+                lined[j] &= ~(0xff << L_ALPHA_SHIFT);
+        }
+    }
+
+    LEPT_FREE(xp);
+    LEPT_FREE(x1);
+    LEPT_FREE(xf);
+    LEPT_FREE(hbuf0);
+    LEPT_FREE(hbuf1);
+    return 0;
+}
+
+
+/*!
+ *  scaleAreaMapTableLow()
+ *
+ *      Input:  datad, wd, hd, wpld (dest)
+ *              datas, ws, hs, wpls (src)
+ *              d (8 or 32 bpp)
+ *      Return: 0 if the scaling has been done; 1 if it should be
+ *              done with the pixel-by-pixel code
+ *
+ *  Notes:
+ *      (1) This gives the same result as scaleGrayAreaMapLow() and
+ *          scaleColorAreaMapLow().  It is used when a vector
+ *          instruction set is selected.
+ *      (2) In those functions, the weight of each src pixel in the
+ *          sum for a dest pixel is the product of a horizontal and a
+ *          vertical weight, each of which is (16 - fraction) for the
+ *          first src pixel, the fraction for the last one, and 16
+ *          for those between.  (When the first and last are the same,
+ *          the two weights are added.)  So for each dest line, the src
+ *          lines it covers are added with their vertical weights into
+ *          @acc, on all bytes of the line at once.  Then, using
+ *          cumulative sums of @acc, the sum for each dest pixel takes
+ *          a fixed number of operations.  The cumulative sums may
+ *          wrap around, but the differences are correct.
+ *      (3) The integer division by the area is done by multiplying by
+ *          the reciprocal.  The quotient is an average of 8 bit values,
+ *          so it is <= 255, the error of the product is less than 1e-12, and
+ *          if the quotient is not an integer, it differs from the
+ *          nearest integer by at least 1 / area, which is much larger
+ *          than 1e-10.  So adding 1e-10 before truncating gives
+ *          exactly the integer quotient.
+ */
+static l_int32
+scaleAreaMapTableLow(l_uint32  *datad,
+                     l_int32    wd,
+                     l_int32    hd,
+                     l_int32    wpld,
+                     l_uint32  *datas,
+                     l_int32    ws,
+                     l_int32    hs,
+                     l_int32    wpls,
+                     l_int32    d)
+{
+l_int32     i, j, k, x, mode, nlanes, wm2, hm2, xu, xl, xuf, xlf, delx;
+l_int32     yu, yl, yup, yuf, ylp, ylf, dely, a, b, val, rval, gval, bval;
+l_int32     ir, ig, ib;
+l_int32    *xup, *xlp, *wl, *wr;
+l_uint32    sum;
+l_uint32   *acc, *csum, *lines, *lined;
+l_float32   scx, scy;
+l_float64   ry, r;
+l_float64  *rx;
+
+    if ((mode = l_getSimdMode()) == L_SIMD_NONE || wd < MinSimdWidth)
+        return 1;
+
+    nlanes = (d == 8) ? 4 * ((ws + 3) / 4) : 4 * ws;
+    xup = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    xlp = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    wl = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    wr = (l_int32 *)LEPT_CALLOC(wd, sizeof(l_int32));
+    rx = (l_float64 *)LEPT_CALLOC(wd, sizeof(l_float64));
+    acc = (l_uint32 *)LEPT_CALLOC(nlanes, sizeof(l_uint32));
+    csum = (l_uint32 *)LEPT_CALLOC(nlanes + 4, sizeof(l_uint32));
+    if (!xup || !xlp || !wl || !wr || !rx || !acc || !csum) {
+        LEPT_FREE(xup);
+        LEPT_FREE(xlp);
+        LEPT_FREE(wl);
+        LEPT_FREE(wr);
+        LEPT_FREE(rx);
+        LEPT_FREE(acc);
+        LEPT_FREE(csum);
+        return 1;
+    }
+
+        /* The src locations are found exactly as in scaleGrayAreaMapLow() */
+    scx = 16. * (l_float32)ws / (l_float32)wd;
+    scy = 16. * (l_float32)hs / (l_float32)hd;
+    wm2 = ws - 2;
+    hm2 = hs - 2;
+    for (j = 0; j < wd; j++) {
+        xu = (l_int32)(scx * j);
+        xl = (l_int32)(scx * (j + 1.0));
+        xup[j] = xu >> 4;
+        xuf = xu & 0x0f;
+        xlp[j] = xl >> 4;
+        xlf = xl & 0x0f;
+        delx = xlp[j] - xup[j];
+        wl[j] = 16 - xuf;
+        wr[j] = xlf;
+        rx[j] = 1.0 / ((16 - xuf) + 16 * (delx - 1) + xlf);
+    }
+
+        /* Memory location of each component in a 32 bpp pixel */
+    ir = SCALE_BYTE_INDEX(0);
+    ig = SCALE_BYTE_INDEX(1);
+    ib = SCALE_BYTE_INDEX(2);
+
+    for (i = 0; i < hd; i++) {
+        yu = (l_int32)(scy * i);
+        yl = (l_int32)(scy * (i + 1.0));
+        yup = yu >> 4;
+        yuf = yu & 0x0f;
+        ylp = yl >> 4;
+        ylf = yl & 0x0f;
+        dely = ylp - yup;
+        lined = datad + i * wpld;
+        lines = datas + yup * wpls;
+
+            /* If near the bottom, just use src pixel values */
+        if (ylp > hm2) {
+            for (j = 0; j < wd; j++) {
+                if (d == 8)
+                    SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup[j]));
+                else
+                    lined[j] = lines[xup[j]];
+            }
+            continue;
+        }
+
+            /* Sum the src lines with their vertical weights */
+        memset(acc, 0, 4 * nlanes);
+        scaleAccumLineLow(acc, (l_uint8 *)lines, nlanes, 16 - yuf, mode);
+        for (k = 1; k < dely; k++)
+            scaleAccumLineLow(acc, (l_uint8 *)(lines + k * wpls), nlanes,
+                              16, mode);
+        if (ylf > 0)
+            scaleAccumLineLow(acc, (l_uint8 *)(lines + dely * wpls), nlanes,
+                              ylf, mode);
+
+            /* Cumulative sums along the line: csum[x] is the sum over
+             * the pixels to the left of x, for each component */
+        if (d == 8) {
+            csum[0] = 0;
+            for (x = 0; x < ws; x++)
+                csum[x + 1] = csum[x] + acc[SCALE_BYTE_INDEX(x)];
+        } else {
+            csum[0] = csum[1] = csum[2] = csum[3] = 0;
+            for (x = 0; x < 4 * ws; x++)
+                csum[x + 4] = csum[x] + acc[x];
+        }
+
+        ry = 1.0 / ((16 - yuf) + 16 * (dely - 1) + ylf);
+        for (j = 0; j < wd; j++) {
+            a = xup[j];
+            b = xlp[j];
+            if (b > wm2) {  /* near the right side */
+                if (d == 8)
+                    SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, a));
+                else
+                    lined[j] = lines[a];
+                continue;
+            }
+
+            r = rx[j] * ry;
+            if (d == 8) {
+                sum = wl[j] * acc[SCALE_BYTE_INDEX(a)] +
+                      wr[j] * acc[SCALE_BYTE_INDEX(b)];
+                if (b > a + 1)
+                    sum += 16 * (csum[b] - csum[a + 1]);
+                val = (l_int32)((sum + 128) * r + 1.0e-10);
+                SET_DATA_BYTE(lined, j, val);
+            } else {
+                sum = wl[j] * acc[4 * a + ir] + wr[j] * acc[4 * b + ir];
+                if (b > a + 1)
+                    sum += 16 * (csum[4 * b + ir] - csum[4 * a + 4 + ir]);
+                rval = (l_int32)((sum + 128) * r + 1.0e-10);
+                sum = wl[j] * acc[4 * a + ig] + wr[j] * acc[4 * b + ig];
+                if (b > a + 1)
+                    sum += 16 * (csum[4 * b + ig] - csum[4 * a + 4 + ig]);
+                gval = (l_int32)((sum + 128) * r + 1.0e-10);
+                sum = wl[j] * acc[4 * a + ib] + wr[j] * acc[4 * b + ib];
+                if (b > a + 1)
+                    sum += 16 * (csum[4 * b + ib] - csum[4 * a + 4 + ib]);
+                bval = (l_int32)((sum + 128) * r + 1.0e-10);
+                composeRGBPixel(rval, gval, bval, lined + j);
+            }
+        }
+    }
+
+    LEPT_FREE(xup);
+    LEPT_FREE(xlp);
+    LEPT_FREE(wl);
+    LEPT_FREE(wr);
+    LEPT_FREE(rx);
+    LEPT_FREE(acc);
+    LEPT_FREE(csum);
+    return 0;
+}
+
+
+/*!
+ *  scaleGrayLIHorizLow()
+ *
+ *      Input:  hline (horizontally interpolated values, in the byte
+ *                     order of an 8 bpp raster line)
+ *              lines (src line)
+ *              xp, x1, xf (tables of the two src pixels and the
+ *                          fraction for each dest pixel)
+ *              wd (dest width)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Each value is (16 - xf) * s(xp) + xf * s(x1), computed
+ *          as 16 * s(xp) + xf * (s(x1) - s(xp)).
+ */
+static void
+scaleGrayLIHorizLow(l_uint16  *hline,
+                    l_uint32  *lines,
+                    l_int32   *xp,
+                    l_int32   *x1,
+                    l_uint16  *xf,
+                    l_int32    wd)
+{
+l_int32  j, v0, v1;
+
+    for (j = 0; j < wd; j++) {
+        v0 = GET_DATA_BYTE(lines, xp[j]);
+        v1 = GET_DATA_BYTE(lines, x1[j]);
+        hline[SCALE_BYTE_INDEX(j)] = (v0 << 4) + xf[j] * (v1 - v0);
+    }
+    return;
+}
+
+
+/*!
+ *  scaleColorLIHorizLow()
+ *
+ *      Input:  hline (horizontally interpolated values, 4 per pixel
+ *                     in the byte order of a 32 bpp raster line)
+ *              lines, xp, x1, xf, wd (see scaleGrayLIHorizLow())
+ *              mode (simd mode)
+ *      Return: void
+ */
+static void
+scaleColorLIHorizLow(l_uint16  *hline,
+                     l_uint32  *lines,
+                     l_int32   *xp,
+                     l_int32   *x1,
+                     l_uint16  *xf,
+                     l_int32    wd,
+                     l_int32    mode)
+{
+l_int32   j, k, jstart, f;
+l_uint8  *p0, *p1;
+
+    jstart = 0;
+    switch (mode)
+    {
+#if L_HAVE_SSE2
+    case L_SIMD_AVX2:
+    case L_SIMD_SSE2:
+        jstart = scaleColorLIHorizSse2(hline, lines, xp, x1, xf, wd);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        jstart = scaleColorLIHorizNeon(hline, lines, xp, x1, xf, wd);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+    for (j = jstart; j < wd; j++) {
+        p0 = (l_uint8 *)(lines + xp[j]);
+        p1 = (l_uint8 *)(lines + x1[j]);
+        f = xf[j];
+        for (k = 0; k < 4; k++)
+            hline[4 * j + k] = (p0[k] << 4) + f * (p1[k] - p0[k]);
+    }
+    return;
+}
+
+
+/*!
+ *  scaleLIVertLow()
+ *
+ *      Input:  lined (dest bytes)
+ *              h0, h1 (horizontally interpolated values from the
+ *                      two src lines)
+ *              n (number of bytes)
+ *              yf (fraction, 0 ... 15)
+ *              mode (simd mode)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Each byte is ((16 - yf) * h0 + yf * h1 + 128) / 256,
+ *          computed as (16 * h0 + yf * (h1 - h0) + 128) / 256.
+ *          The intermediate values may be negative, but the result
+ *          is between 128 and 65408, so unsigned 16-bit arithmetic
+ *          gives the right answer.
+ */
+static void
+scaleLIVertLow(l_uint8   *lined,
+               l_uint16  *h0,
+               l_uint16  *h1,
+               l_int32    n,
+               l_int32    yf,
+               l_int32    mode)
+{
+l_int32  k, kstart;
+
+    kstart = 0;
+    switch (mode)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        kstart = scaleLIVertAvx2(lined, h0, h1, n, yf);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        kstart = scaleLIVertSse2(lined, h0, h1, n, yf);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        kstart = scaleLIVertNeon(lined, h0, h1, n, yf);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+    for (k = kstart; k < n; k++)
+        lined[k] = ((h0[k] << 4) + yf * (h1[k] - h0[k]) + 128) >> 8;
+    return;
+}
+
+
+/*!
+ *  scaleAccumLineLow()
+ *
+ *      Input:  acc (accumulated sums, one for each byte)
+ *              lines (src bytes)
+ *              n (number of bytes)
+ *              wt (weight, 1 ... 16)
+ *              mode (simd mode)
+ *      Return: void
+ */
+static void
+scaleAccumLineLow(l_uint32  *acc,
+                  l_uint8   *lines,
+                  l_int32    n,
+                  l_int32    wt,
+                  l_int32    mode)
+{
+l_int32  k, kstart;
+
+    kstart = 0;
+    switch (mode)
+    {
+#if L_HAVE_AVX2
+    case L_SIMD_AVX2:
+        kstart = scaleAccumLineAvx2(acc, lines, n, wt);
+        break;
+#endif  /* L_HAVE_AVX2 */
+#if L_HAVE_SSE2
+    case L_SIMD_SSE2:
+        kstart = scaleAccumLineSse2(acc, lines, n, wt);
+        break;
+#endif  /* L_HAVE_SSE2 */
+#if L_HAVE_NEON
+    case L_SIMD_NEON:
+        kstart = scaleAccumLineNeon(acc, lines, n, wt);
+        break;
+#endif  /* L_HAVE_NEON */
+    default:
+        break;
+    }
+
+    for (k = kstart; k < n; k++)
+        acc[k] += wt * lines[k];
+    return;
+}
+
+
+    /* Each of the vector kernels below returns the number of
+     * pixels or bytes it has done; the rest are done by the caller. */
+#if L_HAVE_SSE2
+static l_int32
+scaleColorLIHorizSse2(l_uint16  *hline,
+                      l_uint32  *lines,
+                      l_int32   *xp,
+                      l_int32   *x1,
+                      l_uint16  *xf,
+                      l_int32    wd)
+{
+l_int32  j;
+__m128i  zero, v0, v1, f;
+
+    zero = _mm_setzero_si128();
+    for (j = 0; j + 2 <= wd; j += 2) {
+        v0 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(lines[xp[j]]),
+                                _mm_cvtsi32_si128(lines[xp[j + 1]]));
+        v1 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(lines[x1[j]]),
+                                _mm_cvtsi32_si128(lines[x1[j + 1]]));
+        v0 = _mm_unpacklo_epi8(v0, zero);
+        v1 = _mm_unpacklo_epi8(v1, zero);
+        f = _mm_unpacklo_epi64(_mm_set1_epi16(xf[j]),
+                               _mm_set1_epi16(xf[j + 1]));
+        v1 = _mm_add_epi16(_mm_slli_epi16(v0, 4),
+                           _mm_mullo_epi16(f, _mm_sub_epi16(v1, v0)));
+        _mm_storeu_si128((__m128i *)(hline + 4 * j), v1);
+    }
+    return j;
+}
+
+
+static l_int32
+scaleLIVertSse2(l_uint8   *lined,
+                l_uint16  *h0,
+                l_uint16  *h1,
+                l_int32    n,
+                l_int32    yf)
+{
+l_int32  k;
+__m128i  f, c128, a0, a1, b0, b1;
+
+    f = _mm_set1_epi16(yf);
+    c128 = _mm_set1_epi16(128);
+    for (k = 0; k + 16 <= n; k += 16) {
+        a0 = _mm_loadu_si128((const __m128i *)(h0 + k));
+        a1 = _mm_loadu_si128((const __m128i *)(h0 + k + 8));
+        b0 = _mm_loadu_si128((const __m128i *)(h1 + k));
+        b1 = _mm_loadu_si128((const __m128i *)(h1 + k + 8));
+        a0 = _mm_add_epi16(_mm_slli_epi16(a0, 4),
+                           _mm_mullo_epi16(f, _mm_sub_epi16(b0, a0)));
+        a1 = _mm_add_epi16(_mm_slli_epi16(a1, 4),
+                           _mm_mullo_epi16(f, _mm_sub_epi16(b1, a1)));
+        a0 = _mm_srli_epi16(_mm_add_epi16(a0, c128), 8);
+        a1 = _mm_srli_epi16(_mm_add_epi16(a1, c128), 8);
+        _mm_storeu_si128((__m128i *)(lined + k), _mm_packus_epi16(a0, a1));
+    }
+    return k;
+}
+
+
+static l_int32
+scaleAccumLineSse2(l_uint32  *acc,
+                   l_uint8   *lines,
+                   l_int32    n,
+                   l_int32    wt)
+{
+l_int32   k;
+__m128i   zero, w, v, lo, hi;
+__m128i  *pacc;
+
+    zero = _mm_setzero_si128();
+    w = _mm_set1_epi16(wt);
+    for (k = 0; k + 16 <= n; k += 16) {
+        v = _mm_loadu_si128((const __m128i *)(lines + k));
+        lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), w);
+        hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), w);
+        pacc = (__m128i *)(acc + k);
+        _mm_storeu_si128(pacc, _mm_add_epi32(_mm_loadu_si128(pacc),
+                                             _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(pacc + 1,
+                         _mm_add_epi32(_mm_loadu_si128(pacc + 1),
+                                       _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(pacc + 2,
+                         _mm_add_epi32(_mm_loadu_si128(pacc + 2),
+                                       _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(pacc + 3,
+                         _mm_add_epi32(_mm_loadu_si128(pacc + 3),
+                                       _mm_unpackhi_epi16(hi, zero)));
+    }
+    return k;
+}
+#endif  /* L_HAVE_SSE2 */
+
+
+#if L_HAVE_AVX2
+static l_int32
+scaleLIVertAvx2(l_uint8   *lined,
+                l_uint16  *h0,
+                l_uint16  *h1,
+                l_int32    n,
+                l_int32    yf)
+{
+l_int32  k;
+__m256i  f, c128, a0, a1, b0, b1;
+
+    f = _mm256_set1_epi16(yf);
+    c128 = _mm256_set1_epi16(128);
+    for (k = 0; k + 32 <= n; k += 32) {
+        a0 = _mm256_loadu_si256((const __m256i *)(h0 + k));
+        a1 = _mm256_loadu_si256((const __m256i *)(h0 + k + 16));
+        b0 = _mm256_loadu_si256((const __m256i *)(h1 + k));
+        b1 = _mm256_loadu_si256((const __m256i *)(h1 + k + 16));
+        a0 = _mm256_add_epi16(_mm256_slli_epi16(a0, 4),
+                              _mm256_mullo_epi16(f, _mm256_sub_epi16(b0, a0)));
+        a1 = _mm256_add_epi16(_mm256_slli_epi16(a1, 4),
+                              _mm256_mullo_epi16(f, _mm256_sub_epi16(b1, a1)));
+        a0 = _mm256_srli_epi16(_mm256_add_epi16(a0, c128), 8);
+        a1 = _mm256_srli_epi16(_mm256_add_epi16(a1, c128), 8);
+            /* The pack works within 128-bit lanes; restore the order */
+        a0 = _mm256_permute4x64_epi64(_mm256_packus_epi16(a0, a1), 0xd8);
+        _mm256_storeu_si256((__m256i *)(lined + k), a0);
+    }
+    return k;
+}
+
+
+static l_int32
+scaleAccumLineAvx2(l_uint32  *acc,
+                   l_uint8   *lines,
+                   l_int32    n,
+                   l_int32    wt)
+{
+l_int32   k;
+__m256i   w, v;
+__m256i  *pacc;
+
+    w = _mm256_set1_epi16(wt);
+    for (k = 0; k + 16 <= n; k += 16) {
+        v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(lines + k)));
+        v = _mm256_mullo_epi16(v, w);
+        pacc = (__m256i *)(acc + k);
+        _mm256_storeu_si256(pacc, _mm256_add_epi32(_mm256_loadu_si256(pacc),
+                            _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v))));
+        _mm256_storeu_si256(pacc + 1,
+                            _mm256_add_epi32(_mm256_loadu_si256(pacc + 1),
+                            _mm256_cvtepu16_epi32(
+                                _mm256_extracti128_si256(v, 1))));
+    }
+    return k;
+}
+#endif  /* L_HAVE_AVX2 */
+
+
+#if L_HAVE_NEON
+static l_int32
+scaleColorLIHorizNeon(l_uint16  *hline,
+                      l_uint32  *lines,
+                      l_int32   *xp,
+                      l_int32   *x1,
+                      l_uint16  *xf,
+                      l_int32    wd)
+{
+l_int32     j;
+uint16x8_t  v0, v1, f;
+
+    for (j = 0; j + 2 <= wd; j += 2) {
+        v0 = vmovl_u8(vreinterpret_u8_u32(
+                 vset_lane_u32(lines[xp[j + 1]],
+                               vdup_n_u32(lines[xp[j]]), 1)));
+        v1 = vmovl_u8(vreinterpret_u8_u32(
+                 vset_lane_u32(lines[x1[j + 1]],
+                               vdup_n_u32(lines[x1[j]]), 1)));
+        f = vcombine_u16(vdup_n_u16(xf[j]), vdup_n_u16(xf[j + 1]));
+        v1 = vaddq_u16(vshlq_n_u16(v0, 4), vmulq_u16(f, vsubq_u16(v1, v0)));
+        vst1q_u16(hline + 4 * j, v1);
+    }
+    return j;
+}
+
+
+static l_int32
+scaleLIVertNeon(l_uint8   *lined,
+                l_uint16  *h0,
+                l_uint16  *h1,
+                l_int32    n,
+                l_int32    yf)
+{
+l_int32     k;
+uint16x8_t  f, a0, a1, b0, b1;
+
+    f = vdupq_n_u16(yf);
+    for (k = 0; k + 16 <= n; k += 16) {
+        a0 = vld1q_u16(h0 + k);
+        a1 = vld1q_u16(h0 + k + 8);
+        b0 = vld1q_u16(h1 + k);
+        b1 = vld1q_u16(h1 + k + 8);
+        a0 = vaddq_u16(vshlq_n_u16(a0, 4), vmulq_u16(f, vsubq_u16(b0, a0)));
+        a1 = vaddq_u16(vshlq_n_u16(a1, 4), vmulq_u16(f, vsubq_u16(b1, a1)));
+        a0 = vaddq_u16(a0, vdupq_n_u16(128));
+        a1 = vaddq_u16(a1, vdupq_n_u16(128));
+        vst1q_u8(lined + k, vcombine_u8(vshrn_n_u16(a0, 8),
+                                        vshrn_n_u16(a1, 8)));
+    }
+    return k;
+}
+
+
+static l_int32
+scaleAccumLineNeon(l_uint32  *acc,
+                   l_uint8   *lines,
+                   l_int32    n,
+                   l_int32    wt)
+{
+l_int32     k;
+uint8x16_t  v;
+uint16x8_t  lo, hi;
+
+    for (k = 0; k + 16 <= n; k += 16) {
+        v = vld1q_u8(lines + k);
+        lo = vmulq_n_u16(vmovl_u8(vget_low_u8(v)), wt);
+        hi = vmulq_n_u16(vmovl_u8(vget_high_u8(v)), wt);
+        vst1q_u32(acc + k, vaddw_u16(vld1q_u32(acc + k), vget_low_u16(lo)));
+        vst1q_u32(acc + k + 4,
+                  vaddw_u16(vld1q_u32(acc + k + 4), vget_high_u16(lo)));
+        vst1q_u32(acc + k + 8,
+                  vaddw_u16(vld1q_u32(acc + k + 8), vget_low_u16(hi)));
+        vst1q_u32(acc + k + 12,
+                  vaddw_u16(vld1q_u32(acc + k + 12), vget_high_u16(hi)));
+    }
+    return k;
+}
+#endif  /* L_HAVE_NEON */
@@ -46,8 +46,23 @@
  *           PIX      *pixHShearLI()
  *           PIX      *pixVShearLI()
  *
- *    Static helper
+ *    Bands of a shear
+ *           l_int32  *makeShearBands()
+ *
+ *    Static helpers
+ *      static l_int32    shearBands()
+ *      static l_int32   *shearGetBands()
+ *      static l_int32    shearPart()
+ *      static void       shearCopyBits()
  *      static l_float32  normalizeAngleForShear()
+ *
+ *    The shears that use rasterop move bands of full lines (horizontal
+ *    shear) or of full columns (vertical shear), each by a different
+ *    amount.  The lines are divided into parts that are sheared in
+ *    parallel (see l_setParallelThreads()).  To keep the memory access
+ *    sequential, a vertical shear with wide bands of columns is done
+ *    a line at a time: each dest line is assembled from the pieces of
+ *    the source lines that are shifted into it.
  */
 
 #include <string.h>
@@ -57,6 +72,30 @@
     /* Shear angle must not get too close to -pi/2 or pi/2 */
 static const l_float32   MIN_DIFF_FROM_HALF_PI = 0.04;
 
+    /* Smallest part of the lines given to a thread */
+static const l_int32  MinShearPartHeight = 16;
+
+    /* Parameters for the shear of each part of the lines */
+struct ShearParams
+{
+    PIX         *pixd;
+    PIX         *pixs;        /* null for in-place horizontal shear        */
+    l_int32      vertical;    /* 1 for vertical shear; 0 for horizontal    */
+    l_int32      rowwise;     /* 1 to make the vertical shear by lines     */
+    l_int32     *bands;       /* start, size and shift of each band        */
+    l_int32      nbands;      /* number of bands                           */
+    l_int32      incolor;     /* L_BRING_IN_WHITE, L_BRING_IN_BLACK        */
+    l_int32      nparts;      /* number of parts of the lines              */
+};
+typedef struct ShearParams  SHEAR_PARAMS;
+
+static l_int32 shearBands(PIX *pixd, PIX *pixs, l_int32 loc, l_float32 radang,
+                          l_int32 incolor, l_int32 vertical);
+static l_int32 *shearGetBands(l_int32 size, l_int32 loc, l_float32 radang,
+                              l_int32 *pnbands);
+static l_int32 shearPart(void *data, l_int32 index);
+static void shearCopyBits(l_uint32 *lined, l_uint32 *lines, l_int32 bit0,
+                          l_int32 bit1);
 static l_float32 normalizeAngleForShear(l_float32 radang, l_float32 mindif);
 
 
@@ -112,10 +151,6 @@ pixHShear(PIX       *pixd,
           l_float32  radang,
           l_int32    incolor)
 {
-l_int32    sign, w, h;
-l_int32    y, yincr, inityincr, hshift;
-l_float32  tanangle, invangle;
-
     PROCNAME("pixHShear");
 
     if (!pixs)
@@ -145,40 +180,7 @@ l_float32  tanangle, invangle;
 
         /* Initialize to value of incoming pixels */
     pixSetBlackOrWhite(pixd, incolor);
-
-    pixGetDimensions(pixs, &w, &h, NULL);
-    sign = L_SIGN(radang);
-    tanangle = tan(radang);
-    invangle = L_ABS(1. / tanangle);
-    inityincr = (l_int32)(invangle / 2.);
-    yincr = (l_int32)invangle;
-    pixRasterop(pixd, 0, yloc - inityincr, w, 2 * inityincr, PIX_SRC,
-                pixs, 0, yloc - inityincr);
-
-    for (hshift = 1, y = yloc + inityincr; y < h; hshift++) {
-        yincr = (l_int32)(invangle * (hshift + 0.5) + 0.5) - (y - yloc);
-        if (h - y < yincr)  /* reduce for last one if req'd */
-            yincr = h - y;
-        pixRasterop(pixd, -sign*hshift, y, w, yincr, PIX_SRC, pixs, 0, y);
-#if DEBUG
-        fprintf(stderr, "y = %d, hshift = %d, yincr = %d\n", y, hshift, yincr);
-#endif /* DEBUG */
-        y += yincr;
-    }
-
-    for (hshift = -1, y = yloc - inityincr; y > 0; hshift--) {
-        yincr = (y - yloc) - (l_int32)(invangle * (hshift - 0.5) + 0.5);
-        if (y < yincr)  /* reduce for last one if req'd */
-            yincr = y;
-        pixRasterop(pixd, -sign*hshift, y - yincr, w, yincr, PIX_SRC,
-            pixs, 0, y - yincr);
-#if DEBUG
-        fprintf(stderr, "y = %d, hshift = %d, yincr = %d\n",
-                y - yincr, hshift, yincr);
-#endif /* DEBUG */
-        y -= yincr;
-    }
-
+    shearBands(pixd, pixs, yloc, radang, incolor, 0);
     return pixd;
 }
 
@@ -227,10 +229,6 @@ pixVShear(PIX       *pixd,
           l_float32  radang,
           l_int32    incolor)
 {
-l_int32    sign, w, h;
-l_int32    x, xincr, initxincr, vshift;
-l_float32  tanangle, invangle;
-
     PROCNAME("pixVShear");
 
     if (!pixs)
@@ -260,40 +258,7 @@ l_float32  tanangle, invangle;
 
         /* Initialize to value of incoming pixels */
     pixSetBlackOrWhite(pixd, incolor);
-
-    pixGetDimensions(pixs, &w, &h, NULL);
-    sign = L_SIGN(radang);
-    tanangle = tan(radang);
-    invangle = L_ABS(1. / tanangle);
-    initxincr = (l_int32)(invangle / 2.);
-    xincr = (l_int32)invangle;
-    pixRasterop(pixd, xloc - initxincr, 0, 2 * initxincr, h, PIX_SRC,
-                pixs, xloc - initxincr, 0);
-
-    for (vshift = 1, x = xloc + initxincr; x < w; vshift++) {
-        xincr = (l_int32)(invangle * (vshift + 0.5) + 0.5) - (x - xloc);
-        if (w - x < xincr)  /* reduce for last one if req'd */
-            xincr = w - x;
-        pixRasterop(pixd, x, sign*vshift, xincr, h, PIX_SRC, pixs, x, 0);
-#if DEBUG
-        fprintf(stderr, "x = %d, vshift = %d, xincr = %d\n", x, vshift, xincr);
-#endif /* DEBUG */
-        x += xincr;
-    }
-
-    for (vshift = -1, x = xloc - initxincr; x > 0; vshift--) {
-        xincr = (x - xloc) - (l_int32)(invangle * (vshift - 0.5) + 0.5);
-        if (x < xincr)  /* reduce for last one if req'd */
-            xincr = x;
-        pixRasterop(pixd, x - xincr, sign*vshift, xincr, h, PIX_SRC,
-            pixs, x - xincr, 0);
-#if DEBUG
-        fprintf(stderr, "x = %d, vshift = %d, xincr = %d\n",
-                x - xincr, vshift, xincr);
-#endif /* DEBUG */
-        x -= xincr;
-    }
-
+    shearBands(pixd, pixs, xloc, radang, incolor, 1);
     return pixd;
 }
 
@@ -445,10 +410,6 @@ pixHShearIP(PIX       *pixs,
             l_float32  radang,
             l_int32    incolor)
 {
-l_int32    sign, w, h;
-l_int32    y, yincr, inityincr, hshift;
-l_float32  tanangle, invangle;
-
     PROCNAME("pixHShearIP");
 
     if (!pixs)
@@ -463,35 +424,7 @@ l_float32  tanangle, invangle;
     if (radang == 0.0 || tan(radang) == 0.0)
         return 0;
 
-    sign = L_SIGN(radang);
-    pixGetDimensions(pixs, &w, &h, NULL);
-    tanangle = tan(radang);
-    invangle = L_ABS(1. / tanangle);
-    inityincr = (l_int32)(invangle / 2.);
-    yincr = (l_int32)invangle;
-
-    if (inityincr > 0)
-        pixRasteropHip(pixs, yloc - inityincr, 2 * inityincr, 0, incolor);
-
-    for (hshift = 1, y = yloc + inityincr; y < h; hshift++) {
-        yincr = (l_int32)(invangle * (hshift + 0.5) + 0.5) - (y - yloc);
-        if (yincr == 0) continue;
-        if (h - y < yincr)  /* reduce for last one if req'd */
-            yincr = h - y;
-        pixRasteropHip(pixs, y, yincr, -sign*hshift, incolor);
-        y += yincr;
-    }
-
-    for (hshift = -1, y = yloc - inityincr; y > 0; hshift--) {
-        yincr = (y - yloc) - (l_int32)(invangle * (hshift - 0.5) + 0.5);
-        if (yincr == 0) continue;
-        if (y < yincr)  /* reduce for last one if req'd */
-            yincr = y;
-        pixRasteropHip(pixs, y - yincr, yincr, -sign*hshift, incolor);
-        y -= yincr;
-    }
-
-    return 0;
+    return shearBands(pixs, NULL, yloc, radang, incolor, 0);
 }
 
 
@@ -518,10 +451,6 @@ pixVShearIP(PIX       *pixs,
             l_float32  radang,
             l_int32    incolor)
 {
-l_int32    sign, w, h;
-l_int32    x, xincr, initxincr, vshift;
-l_float32  tanangle, invangle;
-
     PROCNAME("pixVShearIP");
 
     if (!pixs)
@@ -536,35 +465,7 @@ l_float32  tanangle, invangle;
     if (radang == 0.0 || tan(radang) == 0.0)
         return 0;
 
-    sign = L_SIGN(radang);
-    pixGetDimensions(pixs, &w, &h, NULL);
-    tanangle = tan(radang);
-    invangle = L_ABS(1. / tanangle);
-    initxincr = (l_int32)(invangle / 2.);
-    xincr = (l_int32)invangle;
-
-    if (initxincr > 0)
-        pixRasteropVip(pixs, xloc - initxincr, 2 * initxincr, 0, incolor);
-
-    for (vshift = 1, x = xloc + initxincr; x < w; vshift++) {
-        xincr = (l_int32)(invangle * (vshift + 0.5) + 0.5) - (x - xloc);
-        if (xincr == 0) continue;
-        if (w - x < xincr)  /* reduce for last one if req'd */
-            xincr = w - x;
-        pixRasteropVip(pixs, x, xincr, sign*vshift, incolor);
-        x += xincr;
-    }
-
-    for (vshift = -1, x = xloc - initxincr; x > 0; vshift--) {
-        xincr = (x - xloc) - (l_int32)(invangle * (vshift - 0.5) + 0.5);
-        if (xincr == 0) continue;
-        if (x < xincr)  /* reduce for last one if req'd */
-            xincr = x;
-        pixRasteropVip(pixs, x - xincr, xincr, sign*vshift, incolor);
-        x -= xincr;
-    }
-
-    return 0;
+    return shearBands(pixs, NULL, xloc, radang, incolor, 1);
 }
 
 
@@ -791,6 +692,357 @@ PIX       *pix, *pixd;
 }
 
 
+/*-------------------------------------------------------------------------*
+ *                             Bands of a shear                            *
+ *-------------------------------------------------------------------------*/
+/*!
+ *  makeShearBands()
+ *
+ *      Input:  size (number of lines, for horizontal shear, or columns,
+ *                    for vertical shear)
+ *              loc (location of the invariant line)
+ *              radang (shear angle, in radians)
+ *              vertical (1 for vertical shear; 0 for horizontal)
+ *              &nbands (<return> number of bands)
+ *      Return: array of 3 * nbands values, or null on error
+ *
+ *  Notes:
+ *      (1) This gives the bands of lines or columns that are shifted
+ *          by the rasterop shears, such as pixVShear(), as the start,
+ *          size and shift of each band.  A vertical shear moves the
+ *          pixels of the columns in a band by +shift in y; a horizontal
+ *          shear moves the pixels of the lines in a band by +shift in x.
+ *      (2) The angle is normalized as in the shears.  If there is no
+ *          shear, there is a single band with no shift.
+ *      (3) Bands of size 0 and bands that are entirely outside the
+ *          image are omitted.  Bands that are partly outside the image
+ *          are not clipped.  The bands are not in order.
+ *      (4) This allows the result of a shear to be found without
+ *          making it; see pixFindDifferentialSquareSums().
+ */
+l_int32 *
+makeShearBands(l_int32    size,
+               l_int32    loc,
+               l_float32  radang,
+               l_int32    vertical,
+               l_int32   *pnbands)
+{
+l_int32   i, sign;
+l_int32  *bands;
+
+    PROCNAME("makeShearBands");
+
+    if (!pnbands)
+        return (l_int32 *)ERROR_PTR("&nbands not defined", procName, NULL);
+    *pnbands = 0;
+    if (size <= 0)
+        return (l_int32 *)ERROR_PTR("size must be > 0", procName, NULL);
+
+    radang = normalizeAngleForShear(radang, MIN_DIFF_FROM_HALF_PI);
+    if (radang == 0.0 || tan(radang) == 0.0) {
+        if ((bands = (l_int32 *)LEPT_CALLOC(3, sizeof(l_int32))) == NULL)
+            return (l_int32 *)ERROR_PTR("bands not made", procName, NULL);
+        bands[1] = size;
+        *pnbands = 1;
+        return bands;
+    }
+
+    if ((bands = shearGetBands(size, loc, radang, pnbands)) == NULL)
+        return (l_int32 *)ERROR_PTR("bands not made", procName, NULL);
+    sign = (vertical) ? L_SIGN(radang) : -L_SIGN(radang);
+    for (i = 0; i < *pnbands; i++)
+        bands[3 * i + 2] *= sign;
+    return bands;
+}
+
+
+/*-------------------------------------------------------------------------*
+ *                  Shear of bands, on parts of the lines                  *
+ *-------------------------------------------------------------------------*/
+/*!
+ *  shearBands()
+ *
+ *      Input:  pixd (initialized to the incoming pixels if pixs is
+ *                    given; otherwise, the image to be sheared in place)
+ *              pixs (<optional> source, of the same size as pixd; null
+ *                    for in-place horizontal shear)
+ *              loc (location of the invariant line)
+ *              radang (normalized angle, not 0.0)
+ *              incolor (L_BRING_IN_WHITE, L_BRING_IN_BLACK)
+ *              vertical (1 for vertical shear; 0 for horizontal)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The lines of pixd are divided into one part for each thread,
+ *          each with at least MinShearPartHeight lines.  The result is
+ *          the same as that of shifting the full bands one after the
+ *          other with rasterop.
+ *      (2) For horizontal shear, the bands of lines in each part are
+ *          shifted with rasterop.
+ *      (3) For vertical shear, if the bands of columns are wide (at
+ *          least 2 words, on average), each line in a part is made
+ *          from the source lines shifted into it, so that memory is
+ *          accessed in raster order.  Lines of pixd that come from
+ *          outside the source are left as they are.  If done in place,
+ *          a copy of the source is made first.
+ *      (4) Narrow bands of columns are shifted with rasterop, on each
+ *          part of the lines, or in place on all lines at once.  For
+ *          a small image depth, there are few words in each line of
+ *          a band, and this is faster than assembling the lines.
+ */
+static l_int32
+shearBands(PIX       *pixd,
+           PIX       *pixs,
+           l_int32    loc,
+           l_float32  radang,
+           l_int32    incolor,
+           l_int32    vertical)
+{
+l_int32       i, w, h, d, nparts, ret;
+l_int32      *bands;
+PIX          *pixt;
+SHEAR_PARAMS  params;
+
+    PROCNAME("shearBands");
+
+    pixGetDimensions(pixd, &w, &h, &d);
+    bands = makeShearBands((vertical) ? w : h, loc, radang, vertical,
+                           &params.nbands);
+    if (!bands)
+        return ERROR_INT("bands not made", procName, 1);
+
+    params.pixd = pixd;
+    params.pixs = pixs;
+    params.vertical = vertical;
+    params.rowwise = (vertical && w * d >= 64 * params.nbands);
+    params.bands = bands;
+    params.incolor = incolor;
+
+        /* In-place vertical shear of narrow bands of columns */
+    pixt = NULL;
+    if (vertical && !pixs && !params.rowwise) {
+        for (i = 0; i < params.nbands; i++) {
+            if (bands[3 * i + 2] != 0)
+                pixRasteropVip(pixd, bands[3 * i], bands[3 * i + 1],
+                               bands[3 * i + 2], incolor);
+        }
+        LEPT_FREE(bands);
+        return 0;
+    }
+
+        /* For an in-place vertical shear of wide bands, the sheared
+         * lines are assembled from a copy of the source */
+    if (vertical && !pixs) {
+        if ((pixt = pixCopy(NULL, pixd)) == NULL) {
+            LEPT_FREE(bands);
+            return ERROR_INT("pixt not made", procName, 1);
+        }
+        pixSetBlackOrWhite(pixd, incolor);
+        params.pixs = pixt;
+    }
+
+    nparts = L_MIN(l_getParallelThreads(), h / MinShearPartHeight);
+    params.nparts = L_MAX(1, nparts);
+    ret = l_parallelRun(params.nparts, params.nparts, shearPart, &params);
+    pixDestroy(&pixt);
+    LEPT_FREE(bands);
+    if (ret)
+        return ERROR_INT("parts not sheared", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  shearGetBands()
+ *
+ *      Input:  size (number of lines, for horizontal shear, or columns,
+ *                    for vertical shear)
+ *              loc (location of the invariant line)
+ *              radang (normalized angle, not 0.0)
+ *              &nbands (<return> number of bands)
+ *      Return: array of 3 * nbands values, or null on error
+ *
+ *  Notes:
+ *      (1) For each band of lines or columns that is to be shifted
+ *          by the same amount, this gives its start, its size and the
+ *          shift.  The shift is positive for bands beyond loc; it is
+ *          multiplied by the sign of radang, and also by -1 for a
+ *          horizontal shear, in makeShearBands().
+ *      (2) Bands of size 0 and bands that are entirely outside the
+ *          image are omitted.  Bands that are partly outside the image
+ *          are not clipped.
+ */
+static l_int32 *
+shearGetBands(l_int32    size,
+              l_int32    loc,
+              l_float32  radang,
+              l_int32   *pnbands)
+{
+l_int32    n, x, incr, initincr, shift;
+l_int32   *bands;
+l_float32  tanangle, invangle;
+
+    PROCNAME("shearGetBands");
+
+    *pnbands = 0;
+    if ((bands = (l_int32 *)LEPT_CALLOC(3 * (size + 2), sizeof(l_int32)))
+        == NULL)
+        return (l_int32 *)ERROR_PTR("bands not made", procName, NULL);
+
+    tanangle = tan(radang);
+    invangle = L_ABS(1. / tanangle);
+    initincr = (l_int32)(invangle / 2.);
+    n = 0;
+    if (initincr > 0 && loc - initincr < size && loc + initincr > 0) {
+        bands[0] = loc - initincr;
+        bands[1] = 2 * initincr;
+        bands[2] = 0;
+        n = 1;
+    }
+
+    for (shift = 1, x = loc + initincr; x < size; shift++) {
+        incr = (l_int32)(invangle * (shift + 0.5) + 0.5) - (x - loc);
+        if (size - x < incr)  /* reduce for last one if req'd */
+            incr = size - x;
+        if (incr > 0 && x + incr > 0) {
+            bands[3 * n] = x;
+            bands[3 * n + 1] = incr;
+            bands[3 * n + 2] = shift;
+            n++;
+        }
+#if DEBUG
+        fprintf(stderr, "x = %d, shift = %d, incr = %d\n", x, shift, incr);
+#endif /* DEBUG */
+        x += incr;
+    }
+
+    for (shift = -1, x = loc - initincr; x > 0; shift--) {
+        incr = (x - loc) - (l_int32)(invangle * (shift - 0.5) + 0.5);
+        if (x < incr)  /* reduce for last one if req'd */
+            incr = x;
+        if (incr > 0 && x - incr < size) {
+            bands[3 * n] = x - incr;
+            bands[3 * n + 1] = incr;
+            bands[3 * n + 2] = shift;
+            n++;
+        }
+#if DEBUG
+        fprintf(stderr, "x = %d, shift = %d, incr = %d\n",
+                x - incr, shift, incr);
+#endif /* DEBUG */
+        x -= incr;
+    }
+
+    *pnbands = n;
+    return bands;
+}
+
+
+/*!
+ *  shearPart()
+ *
+ *      Input:  data (SHEAR_PARAMS)
+ *              index (of the part of the lines)
+ *      Return: 0 if OK, 1 on error
+ */
+static l_int32
+shearPart(void    *data,
+          l_int32  index)
+{
+l_int32       i, k, w, h, d, wpl, y0, y1, start, size, shift, ys;
+l_int32       bit0, bit1;
+l_int32      *bands;
+l_uint32     *datad, *datas, *lined;
+SHEAR_PARAMS *params;
+
+    params = (SHEAR_PARAMS *)data;
+    pixGetDimensions(params->pixd, &w, &h, &d);
+    y0 = (h * index) / params->nparts;
+    y1 = (h * (index + 1)) / params->nparts;
+    bands = params->bands;
+
+    if (!params->vertical) {
+        for (k = 0; k < params->nbands; k++) {
+            start = L_MAX(y0, bands[3 * k]);
+            size = L_MIN(y1, bands[3 * k] + bands[3 * k + 1]) - start;
+            shift = bands[3 * k + 2];
+            if (size <= 0)
+                continue;
+            if (!params->pixs) {
+                if (pixRasteropHip(params->pixd, start, size, shift,
+                                   params->incolor))
+                    return 1;
+            } else {
+                pixRasterop(params->pixd, shift, start, w, size, PIX_SRC,
+                            params->pixs, 0, start);
+            }
+        }
+        return 0;
+    }
+
+        /* Narrow bands: rasterop each band in the part */
+    if (!params->rowwise) {
+        for (k = 0; k < params->nbands; k++) {
+            pixRasterop(params->pixd, bands[3 * k], y0, bands[3 * k + 1],
+                        y1 - y0, PIX_SRC, params->pixs, bands[3 * k],
+                        y0 - bands[3 * k + 2]);
+        }
+        return 0;
+    }
+
+        /* Wide bands: assemble each line of the part */
+    datad = pixGetData(params->pixd);
+    datas = pixGetData(params->pixs);
+    wpl = pixGetWpl(params->pixd);
+    for (i = y0; i < y1; i++) {
+        lined = datad + i * wpl;
+        for (k = 0; k < params->nbands; k++) {
+            ys = i - bands[3 * k + 2];
+            if (ys < 0 || ys >= h)
+                continue;
+            bit0 = L_MAX(0, bands[3 * k]) * d;
+            bit1 = L_MIN(w, bands[3 * k] + bands[3 * k + 1]) * d;
+            shearCopyBits(lined, datas + ys * wpl, bit0, bit1);
+        }
+    }
+    return 0;
+}
+
+
+/*!
+ *  shearCopyBits()
+ *
+ *      Input:  lined (dest line)
+ *              lines (source line)
+ *              bit0, bit1 (copy bits in [bit0, bit1) of the line)
+ *      Return: void
+ */
+static void
+shearCopyBits(l_uint32  *lined,
+              l_uint32  *lines,
+              l_int32    bit0,
+              l_int32    bit1)
+{
+l_int32   w0, w1;
+l_uint32  lmask, rmask;
+
+    w0 = bit0 >> 5;
+    w1 = (bit1 - 1) >> 5;
+    lmask = 0xffffffff >> (bit0 & 31);
+    rmask = 0xffffffff << (31 - ((bit1 - 1) & 31));
+    if (w0 == w1) {
+        lmask &= rmask;
+        lined[w0] = (lined[w0] & ~lmask) | (lines[w0] & lmask);
+        return;
+    }
+    lined[w0] = (lined[w0] & ~lmask) | (lines[w0] & lmask);
+    if (w1 > w0 + 1)
+        memcpy(lined + w0 + 1, lines + w0 + 1,
+               sizeof(l_uint32) * (w1 - w0 - 1));
+    lined[w1] = (lined[w1] & ~rmask) | (lines[w1] & rmask);
+}
+
+
 /*-------------------------------------------------------------------------*
  *                           Angle normalization                           *
  *-------------------------------------------------------------------------*/
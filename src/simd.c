@@ -0,0 +1,150 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  simd.c
+ *
+ *      Selecting the vector instruction set
+ *          l_int32    l_simdSupported()
+ *          l_int32    l_setSimdMode()
+ *          l_int32    l_getSimdMode()
+ *          static l_int32  simdBestMode()
+ *
+ *  Low-level functions that have vector kernels (for example, the
+ *  full-word loops of the rasterops in roplow.c) call l_getSimdMode()
+ *  to decide which kernel to run.  By default this is the best
+ *  instruction set that is both compiled in (see simd.h) and supported
+ *  by the processor.  Every kernel produces exactly the same output
+ *  as the portable C code, so the mode only affects speed.
+ *
+ *  l_setSimdMode() overrides the default for the whole process.  It
+ *  is intended for testing and timing, e.g., for checking that each
+ *  kernel gives the same result as L_SIMD_NONE.
+ */
+
+#include "allheaders.h"
+#include "simd.h"
+
+    /* Current mode; -1 until it is first requested or set */
+static l_int32  var_SIMD_MODE = -1;
+
+static l_int32 simdBestMode(void);
+
+
+/*!
+ *  l_simdSupported()
+ *
+ *      Input:  mode (L_SIMD_NONE, L_SIMD_SSE2, L_SIMD_AVX2, L_SIMD_NEON)
+ *      Return: 1 if the kernels for @mode are compiled in and the
+ *              processor can run them; 0 otherwise
+ *
+ *  Notes:
+ *      (1) L_SIMD_NONE is always supported.
+ */
+l_int32
+l_simdSupported(l_int32  mode)
+{
+    switch (mode)
+    {
+    case L_SIMD_NONE:
+        return 1;
+    case L_SIMD_SSE2:
+        return L_HAVE_SSE2;
+    case L_SIMD_AVX2:
+#if L_HAVE_AVX2
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2")) ? 1 : 0;
+#else
+        return 0;
+#endif  /* L_HAVE_AVX2 */
+    case L_SIMD_NEON:
+        return L_HAVE_NEON;
+    default:
+        return 0;
+    }
+}
+
+
+/*!
+ *  l_setSimdMode()
+ *
+ *      Input:  mode (L_SIMD_NONE, L_SIMD_SSE2, L_SIMD_AVX2, L_SIMD_NEON,
+ *                    or L_SIMD_AUTO for the best supported)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This sets the instruction set used by all vector kernels.
+ *          It is an error to request one that is not supported;
+ *          the mode is then left unchanged.
+ *      (2) This is not synchronized with operations running in other
+ *          threads.  Set it before starting them.
+ */
+l_int32
+l_setSimdMode(l_int32  mode)
+{
+    PROCNAME("l_setSimdMode");
+
+    if (mode == L_SIMD_AUTO) {
+        var_SIMD_MODE = simdBestMode();
+        return 0;
+    }
+    if (!l_simdSupported(mode))
+        return ERROR_INT("mode not supported", procName, 1);
+    var_SIMD_MODE = mode;
+    return 0;
+}
+
+
+/*!
+ *  l_getSimdMode()
+ *
+ *      Return: mode (L_SIMD_NONE, L_SIMD_SSE2, L_SIMD_AVX2 or L_SIMD_NEON)
+ */
+l_int32
+l_getSimdMode(void)
+{
+    if (var_SIMD_MODE < 0)
+        var_SIMD_MODE = simdBestMode();
+    return var_SIMD_MODE;
+}
+
+
+/*!
+ *  simdBestMode()
+ *
+ *      Return: the best supported mode
+ */
+static l_int32
+simdBestMode(void)
+{
+    if (l_simdSupported(L_SIMD_AVX2))
+        return L_SIMD_AVX2;
+    if (l_simdSupported(L_SIMD_SSE2))
+        return L_SIMD_SSE2;
+    if (l_simdSupported(L_SIMD_NEON))
+        return L_SIMD_NEON;
+    return L_SIMD_NONE;
+}
@@ -0,0 +1,82 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+#ifndef  LEPTONICA_SIMD_H
+#define  LEPTONICA_SIMD_H
+
+/*
+ *  simd.h
+ *
+ *      Compile-time availability of the vector instruction sets used by
+ *      the low-level image operations.  This header is only included by
+ *      the files that contain vector kernels; it is not in allheaders.h
+ *      because it pulls in the compiler intrinsics headers.
+ *
+ *      A kernel for instruction set XXX is compiled if L_HAVE_XXX is 1.
+ *      It is then only called if l_getSimdMode() selects it, which in
+ *      turn requires that the processor supports it (see simd.c).
+ *
+ *      SSE2 and NEON are part of the base instruction set on x86-64 and
+ *      aarch64, respectively, and are used when the compiler targets
+ *      them.  AVX2 kernels are compiled with a function attribute,
+ *      so the rest of the library does not require AVX2.  They are
+ *      only available with gcc 4.9 or later and clang 3.8 or later.
+ *
+ *      All vector kernels are disabled by compiling with L_USE_SIMD = 0;
+ *      see environ.h.
+ */
+
+#if L_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || \
+                   (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define  L_HAVE_SSE2   1
+#else
+#define  L_HAVE_SSE2   0
+#endif
+
+    /* clang defines __GNUC__ as 4.2, so it is checked separately */
+#if L_USE_SIMD && L_HAVE_SSE2 && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    ((defined(__clang__) && \
+      ((__clang_major__ > 3) || \
+       (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+     (!defined(__clang__) && defined(__GNUC__) && \
+      ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#include <immintrin.h>
+#define  L_HAVE_AVX2   1
+#define  L_TARGET_AVX2   __attribute__((target("avx2")))
+#else
+#define  L_HAVE_AVX2   0
+#endif
+
+#if L_USE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define  L_HAVE_NEON   1
+#else
+#define  L_HAVE_NEON   0
+#endif
+
+#endif  /* LEPTONICA_SIMD_H */
@@ -46,6 +46,13 @@
  *
  *      Differential square sum function for scoring
  *          l_int32    pixFindDifferentialSquareSum()
+ *          NUMA      *pixFindDifferentialSquareSums()
+ *
+ *      Scoring of vertical shears without making them
+ *          static SKEW_SCORER  *skewScorerCreate()
+ *          static void          skewScorerDestroy()
+ *          static l_int32       skewScorerRun()
+ *          static l_int32       skewScoreAngle()
  *
  *      Measures of variance of row sums
  *          l_int32    pixFindNormalizedSquareSum()
@@ -82,6 +89,16 @@
  *      with the raster lines.  It also works well in multicolumn
  *      pages where the textlines do not line up across columns.
  *
+ *      The sheared images are not actually made.  The row sums of
+ *      the image sheared by any angle are sums over the bands of
+ *      columns that the shear moves together, each taken from a
+ *      different source row.  The foreground pixels in each word of
+ *      the image are counted once, and the row sums for each angle
+ *      are accumulated from these counts, or from the parts of words
+ *      at the edges of the bands.  The scores are exactly those of
+ *      pixFindDifferentialSquareSum() on the sheared image, and the
+ *      angles of a sweep are scored in parallel.
+ *
  *      The method is fast, accurate to within an angle (in radians)
  *      of approximately the inverse width in pixels of the image,
  *      and will work on a surprisingly small amount of text data
@@ -95,6 +112,29 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Data of a 1 bpp image, from which the differential square sum
+     * of the image after any vertical shear is found */
+struct SkewScorer
+{
+    PIX         *pix;         /* clone of the image                        */
+    l_uint32    *data;
+    l_int32      w;           /* image size                                */
+    l_int32      h;
+    l_int32      wpl;
+    l_int32      loc;         /* x location of the invariant column        */
+    l_uint8     *counts;      /* fg pixels in each word that is entirely   */
+                              /* within the image                          */
+    l_float32   *radangs;     /* shear angles being scored                 */
+    l_float32   *scores;      /* their differential square sums            */
+};
+typedef struct SkewScorer  SKEW_SCORER;
+
+static SKEW_SCORER *skewScorerCreate(PIX *pixs, l_int32 pivot);
+static void skewScorerDestroy(SKEW_SCORER **pscorer);
+static l_int32 skewScorerRun(SKEW_SCORER *scorer, l_float32 *radangs,
+                             l_int32 nangles, l_float32 *scores);
+static l_int32 skewScoreAngle(void *data, l_int32 index);
+
     /* Default sweep angle parameters for pixFindSkew() */
 static const l_float32  DEFAULT_SWEEP_RANGE = 7.;    /* degrees */
 static const l_float32  DEFAULT_SWEEP_DELTA = 1.;    /* degrees */
@@ -361,11 +401,13 @@ pixFindSkewSweep(PIX        *pixs,
                  l_float32   sweeprange,
                  l_float32   sweepdelta)
 {
-l_int32    ret, bzero, i, nangles;
-l_float32  deg2rad, theta;
-l_float32  sum, maxscore, maxangle;
-NUMA      *natheta, *nascore;
-PIX       *pix, *pixt;
+l_int32       ret, bzero, i, nangles;
+l_float32     deg2rad, theta;
+l_float32     sum, maxscore, maxangle;
+l_float32    *radangs, *scores;
+NUMA         *natheta, *nascore;
+PIX          *pix;
+SKEW_SCORER  *scorer;
 
     PROCNAME("pixFindSkewSweep");
 
@@ -401,25 +443,32 @@ PIX       *pix, *pixt;
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
-    pixt = pixCreateTemplate(pix);
+    radangs = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scorer = skewScorerCreate(pix, L_SHEAR_ABOUT_CORNER);
 
-    if (!pix || !pixt) {
-        ret = ERROR_INT("pix and pixt not both made", procName, 1);
+    if (!scorer) {
+        ret = ERROR_INT("scorer not made", procName, 1);
         goto cleanup;
     }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+    if (!natheta || !nascore || !radangs || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
 
+        /* Get the scores of pix sheared about the UL corner */
     for (i = 0; i < nangles; i++) {
         theta = -sweeprange + i * sweepdelta;   /* degrees */
+        radangs[i] = deg2rad * theta;
+    }
+    if (skewScorerRun(scorer, radangs, nangles, scores)) {
+        ret = ERROR_INT("scores not found", procName, 1);
+        goto cleanup;
+    }
 
-            /* Shear pix about the UL corner and put the result in pixt */
-        pixVShearCorner(pixt, pix, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt, &sum);
+    for (i = 0; i < nangles; i++) {
+        theta = -sweeprange + i * sweepdelta;   /* degrees */
+        sum = scores[i];
 
 #if  DEBUG_PRINT_SCORES
         L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
@@ -463,7 +512,9 @@ PIX       *pix, *pixt;
 
 cleanup:
     pixDestroy(&pix);
-    pixDestroy(&pixt);
+    skewScorerDestroy(&scorer);
+    LEPT_FREE(radangs);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -608,17 +659,20 @@ pixFindSkewSweepAndSearchScorePivot(PIX        *pixs,
                                     l_float32   minbsdelta,
                                     l_int32     pivot)
 {
-l_int32    ret, bzero, i, nangles, n, ratio, maxindex, minloc;
-l_int32    width, height;
-l_float32  deg2rad, theta, delta;
-l_float32  sum, maxscore, maxangle;
-l_float32  centerangle, leftcenterangle, rightcenterangle;
-l_float32  lefttemp, righttemp;
-l_float32  bsearchscore[5];
-l_float32  minscore, minthresh;
-l_float32  rangeleft;
-NUMA      *natheta, *nascore;
-PIX       *pixsw, *pixsch, *pixt1, *pixt2;
+l_int32       ret, bzero, i, nangles, n, ratio, maxindex, minloc;
+l_int32       width, height;
+l_float32     deg2rad, theta, delta;
+l_float32     sum, maxscore, maxangle;
+l_float32     centerangle, leftcenterangle, rightcenterangle;
+l_float32     lefttemp, righttemp;
+l_float32     bsearchscore[5];
+l_float32     minscore, minthresh;
+l_float32     rangeleft;
+l_float32     radang3[3], score3[3];
+l_float32    *radangs, *scores;
+NUMA         *natheta, *nascore;
+PIX          *pixsw, *pixsch;
+SKEW_SCORER  *scorer1, *scorer2;
 
     PROCNAME("pixFindSkewSweepAndSearchScorePivot");
 
@@ -670,42 +724,49 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
             pixsw = pixReduceRankBinaryCascade(pixsch, 1, 2, 2, 0);
     }
 
-    pixt1 = pixCreateTemplate(pixsw);
+        /* The scores for the sweep are found on pixsw, and those
+         * for the binary search on pixsch */
+    scorer1 = skewScorerCreate(pixsw, pivot);
     if (ratio == 1)
-        pixt2 = pixClone(pixt1);
+        scorer2 = NULL;
     else
-        pixt2 = pixCreateTemplate(pixsch);
+        scorer2 = skewScorerCreate(pixsch, pivot);
 
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
+    radangs = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
 
     if (!pixsch || !pixsw) {
         ret = ERROR_INT("pixsch and pixsw not both made", procName, 1);
         goto cleanup;
     }
-    if (!pixt1 || !pixt2) {
-        ret = ERROR_INT("pixt1 and pixt2 not both made", procName, 1);
+    if (!scorer1 || (ratio != 1 && !scorer2)) {
+        ret = ERROR_INT("scorers not both made", procName, 1);
         goto cleanup;
     }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+    if (!natheta || !nascore || !radangs || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
+    if (ratio == 1)
+        scorer2 = scorer1;
 
         /* Do sweep */
     rangeleft = sweepcenter - sweeprange;
     for (i = 0; i < nangles; i++) {
         theta = rangeleft + i * sweepdelta;   /* degrees */
+        radangs[i] = deg2rad * theta;
+    }
+    if (skewScorerRun(scorer1, radangs, nangles, scores)) {
+        ret = ERROR_INT("sweep scores not found", procName, 1);
+        goto cleanup;
+    }
 
-            /* Shear pix and put the result in pixt1 */
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt1, &sum);
+    for (i = 0; i < nangles; i++) {
+        theta = rangeleft + i * sweepdelta;   /* degrees */
+        sum = scores[i];
 
 #if  DEBUG_PRINT_SCORES
         L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
@@ -753,25 +814,16 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
         /* Do binary search to find skew angle.
          * First, set up initial three points. */
     centerangle = maxangle;
-    if (pivot == L_SHEAR_ABOUT_CORNER) {
-        pixVShearCorner(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
-    } else {
-        pixVShearCenter(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
+    radang3[0] = deg2rad * centerangle;
+    radang3[1] = deg2rad * (centerangle - sweepdelta);
+    radang3[2] = deg2rad * (centerangle + sweepdelta);
+    if (skewScorerRun(scorer2, radang3, 3, score3)) {
+        ret = ERROR_INT("search scores not found", procName, 1);
+        goto cleanup;
     }
+    bsearchscore[2] = score3[0];
+    bsearchscore[0] = score3[1];
+    bsearchscore[4] = score3[2];
 
     numaAddNumber(nascore, bsearchscore[2]);
     numaAddNumber(natheta, centerangle);
@@ -784,27 +836,19 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
     delta = 0.5 * sweepdelta;
     while (delta >= minbsdelta)
     {
-            /* Get the left intermediate score */
+            /* Get the left and right intermediate scores */
         leftcenterangle = centerangle - delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[1]);
+        rightcenterangle = centerangle + delta;
+        radang3[0] = deg2rad * leftcenterangle;
+        radang3[1] = deg2rad * rightcenterangle;
+        if (skewScorerRun(scorer2, radang3, 2, score3)) {
+            ret = ERROR_INT("search scores not found", procName, 1);
+            goto cleanup;
+        }
+        bsearchscore[1] = score3[0];
+        bsearchscore[3] = score3[1];
         numaAddNumber(nascore, bsearchscore[1]);
         numaAddNumber(natheta, leftcenterangle);
-
-            /* Get the right intermediate score */
-        rightcenterangle = centerangle + delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[3]);
         numaAddNumber(nascore, bsearchscore[3]);
         numaAddNumber(natheta, rightcenterangle);
 
@@ -898,8 +942,11 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
 cleanup:
     pixDestroy(&pixsw);
     pixDestroy(&pixsch);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
+    if (scorer2 != scorer1)
+        skewScorerDestroy(&scorer2);
+    skewScorerDestroy(&scorer1);
+    LEPT_FREE(radangs);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -1084,6 +1131,286 @@ NUMA      *na;
 }
 
 
+/*!
+ *  pixFindDifferentialSquareSums()
+ *
+ *      Input:  pixs (1 bpp)
+ *              naangle (vertical shear angles, in degrees)
+ *              pivot (L_SHEAR_ABOUT_CORNER, L_SHEAR_ABOUT_CENTER)
+ *      Return: nascore (differential square sum for each angle),
+ *              or null on error
+ *
+ *  Notes:
+ *      (1) For each angle, this gives the same score as
+ *          pixFindDifferentialSquareSum() on the image made by
+ *          pixVShearCorner() or pixVShearCenter() with L_BRING_IN_WHITE.
+ *          The sheared images are not made, and the angles are scored
+ *          in parallel; see l_setParallelThreads().
+ */
+NUMA *
+pixFindDifferentialSquareSums(PIX      *pixs,
+                              NUMA     *naangle,
+                              l_int32   pivot)
+{
+l_int32       i, n;
+l_float32     deg2rad, angle;
+l_float32    *radangs, *scores;
+NUMA         *nascore;
+SKEW_SCORER  *scorer;
+
+    PROCNAME("pixFindDifferentialSquareSums");
+
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (NUMA *)ERROR_PTR("pixs not defined or not 1 bpp",
+                                 procName, NULL);
+    if (!naangle)
+        return (NUMA *)ERROR_PTR("naangle not defined", procName, NULL);
+    if (pivot != L_SHEAR_ABOUT_CORNER && pivot != L_SHEAR_ABOUT_CENTER)
+        return (NUMA *)ERROR_PTR("invalid pivot", procName, NULL);
+    if ((n = numaGetCount(naangle)) == 0)
+        return (NUMA *)ERROR_PTR("no angles", procName, NULL);
+
+    deg2rad = 3.1415926535 / 180.;
+    radangs = (l_float32 *)LEPT_CALLOC(n, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(n, sizeof(l_float32));
+    scorer = skewScorerCreate(pixs, pivot);
+    nascore = NULL;
+    if (!radangs || !scores || !scorer) {
+        L_ERROR("arrays and scorer not all made\n", procName);
+        goto cleanup;
+    }
+
+    for (i = 0; i < n; i++) {
+        numaGetFValue(naangle, i, &angle);
+        radangs[i] = deg2rad * angle;
+    }
+    if (skewScorerRun(scorer, radangs, n, scores)) {
+        L_ERROR("scores not found\n", procName);
+        goto cleanup;
+    }
+    nascore = numaCreate(n);
+    for (i = 0; i < n; i++)
+        numaAddNumber(nascore, scores[i]);
+
+cleanup:
+    skewScorerDestroy(&scorer);
+    LEPT_FREE(radangs);
+    LEPT_FREE(scores);
+    return nascore;
+}
+
+
+/*----------------------------------------------------------------*
+ *          Scoring of vertical shears without making them        *
+ *----------------------------------------------------------------*/
+/*!
+ *  skewScorerCreate()
+ *
+ *      Input:  pixs (1 bpp)
+ *              pivot (L_SHEAR_ABOUT_CORNER, L_SHEAR_ABOUT_CENTER)
+ *      Return: scorer, or null on error
+ *
+ *  Notes:
+ *      (1) This counts the fg pixels in each word of pixs, once for
+ *          all of the angles to be scored.
+ */
+static SKEW_SCORER *
+skewScorerCreate(PIX     *pixs,
+                 l_int32  pivot)
+{
+l_int32       i, j, fullwords;
+l_uint32      word;
+l_uint32     *line;
+l_uint8      *count;
+SKEW_SCORER  *scorer;
+
+    PROCNAME("skewScorerCreate");
+
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (SKEW_SCORER *)ERROR_PTR("pixs not defined or not 1 bpp",
+                                        procName, NULL);
+
+    if ((scorer = (SKEW_SCORER *)LEPT_CALLOC(1, sizeof(SKEW_SCORER)))
+        == NULL)
+        return (SKEW_SCORER *)ERROR_PTR("scorer not made", procName, NULL);
+    scorer->pix = pixClone(pixs);
+    scorer->data = pixGetData(pixs);
+    pixGetDimensions(pixs, &scorer->w, &scorer->h, NULL);
+    scorer->wpl = pixGetWpl(pixs);
+    scorer->loc = (pivot == L_SHEAR_ABOUT_CORNER) ? 0 : scorer->w / 2;
+    scorer->counts = (l_uint8 *)LEPT_CALLOC(scorer->h * scorer->wpl,
+                                            sizeof(l_uint8));
+    if (!scorer->counts) {
+        skewScorerDestroy(&scorer);
+        return (SKEW_SCORER *)ERROR_PTR("counts not made", procName, NULL);
+    }
+
+    fullwords = scorer->w >> 5;
+    for (i = 0; i < scorer->h; i++) {
+        line = scorer->data + i * scorer->wpl;
+        count = scorer->counts + i * scorer->wpl;
+        for (j = 0; j < fullwords; j++) {
+            if ((word = line[j]) == 0)
+                continue;
+            word -= (word >> 1) & 0x55555555;
+            word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+            word = (word + (word >> 4)) & 0x0f0f0f0f;
+            count[j] = (word * 0x01010101) >> 24;
+        }
+    }
+    return scorer;
+}
+
+
+/*!
+ *  skewScorerDestroy()
+ *
+ *      Input:  &scorer (<will be set to null before returning>)
+ *      Return: void
+ */
+static void
+skewScorerDestroy(SKEW_SCORER  **pscorer)
+{
+SKEW_SCORER  *scorer;
+
+    if (pscorer == NULL || (scorer = *pscorer) == NULL)
+        return;
+    pixDestroy(&scorer->pix);
+    LEPT_FREE(scorer->counts);
+    LEPT_FREE(scorer);
+    *pscorer = NULL;
+}
+
+
+/*!
+ *  skewScorerRun()
+ *
+ *      Input:  scorer
+ *              radangs (array of vertical shear angles, in radians)
+ *              nangles (number of angles)
+ *              scores (array of nangles; <return> differential
+ *                      square sum for each angle)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The angles are scored in parallel.
+ */
+static l_int32
+skewScorerRun(SKEW_SCORER  *scorer,
+              l_float32    *radangs,
+              l_int32       nangles,
+              l_float32    *scores)
+{
+    PROCNAME("skewScorerRun");
+
+    scorer->radangs = radangs;
+    scorer->scores = scores;
+    if (l_parallelRun(nangles, 0, skewScoreAngle, scorer))
+        return ERROR_INT("angles not all scored", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  skewScoreAngle()
+ *
+ *      Input:  data (SKEW_SCORER)
+ *              index (of the angle)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The shear moves each band of columns given by
+ *          makeShearBands() down by its shift, bringing in white
+ *          pixels.  Row i of the sheared image therefore has the fg
+ *          pixels of row i - shift of the image in each band.
+ *      (2) Each band is taken one word column at a time, with a mask
+ *          for the words that are not entirely within the band, and
+ *          the fg pixels are counted with a parallel bit count.  The
+ *          counts of the words that are entirely within the band are
+ *          made once by skewScorerCreate().
+ *      (3) The score is then found from the row sums exactly as in
+ *          pixFindDifferentialSquareSum().
+ */
+static l_int32
+skewScoreAngle(void    *data,
+               l_int32  index)
+{
+l_int32       i, k, y, y0, y1, w, h, wpl, nbands, shift, start, end;
+l_int32       bit0, bit1, skiph, skip, nskip;
+l_int32      *bands, *rowsum;
+l_uint8      *counts;
+l_uint32      word, mask;
+l_uint32     *datas;
+l_float32     val1, val2, diff, sum;
+SKEW_SCORER  *scorer;
+
+    PROCNAME("skewScoreAngle");
+
+    scorer = (SKEW_SCORER *)data;
+    w = scorer->w;
+    h = scorer->h;
+    wpl = scorer->wpl;
+    datas = scorer->data;
+    counts = scorer->counts;
+    scorer->scores[index] = 0.0;
+    if ((bands = makeShearBands(w, scorer->loc, scorer->radangs[index], 1,
+                                &nbands)) == NULL)
+        return ERROR_INT("bands not made", procName, 1);
+    if ((rowsum = (l_int32 *)LEPT_CALLOC(h, sizeof(l_int32))) == NULL) {
+        LEPT_FREE(bands);
+        return ERROR_INT("rowsum not made", procName, 1);
+    }
+
+        /* Accumulate the row sums of the sheared image, from each
+         * band clipped to the image */
+    for (i = 0; i < nbands; i++) {
+        start = L_MAX(0, bands[3 * i]);
+        end = L_MIN(w, bands[3 * i] + bands[3 * i + 1]);
+        shift = bands[3 * i + 2];
+        y0 = L_MAX(0, -shift);
+        y1 = L_MIN(h, h - shift);
+        for (k = start >> 5; k < (end + 31) >> 5; k++) {
+            bit0 = L_MAX(start - 32 * k, 0);
+            bit1 = L_MIN(end - 32 * k, 32);
+            if (bit0 == 0 && bit1 == 32) {
+                for (y = y0; y < y1; y++)
+                    rowsum[y + shift] += counts[y * wpl + k];
+                continue;
+            }
+            mask = 0xffffffff >> bit0;
+            if (bit1 < 32)
+                mask &= ~(0xffffffff >> bit1);
+            for (y = y0; y < y1; y++) {
+                if ((word = datas[y * wpl + k] & mask) == 0)
+                    continue;
+                word -= (word >> 1) & 0x55555555;
+                word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+                word = (word + (word >> 4)) & 0x0f0f0f0f;
+                rowsum[y + shift] += (word * 0x01010101) >> 24;
+            }
+        }
+    }
+
+        /* Sum the squares of differential row sums, omitting the
+         * same rows at top and bottom */
+    skiph = (l_int32)(0.05 * w);
+    skip = L_MIN(h / 10, skiph);
+    nskip = L_MAX(skip / 2, 1);
+    sum = 0.0;
+    for (i = nskip; i < h - nskip; i++) {
+        val1 = (l_float32)rowsum[i - 1];
+        val2 = (l_float32)rowsum[i];
+        diff = val2 - val1;
+        sum += diff * diff;
+    }
+    scorer->scores[index] = sum;
+
+    LEPT_FREE(bands);
+    LEPT_FREE(rowsum);
+    return 0;
+}
+
+
 /*----------------------------------------------------------------*
  *                        Normalized square sum                   *
  *----------------------------------------------------------------*/
@@ -334,6 +334,8 @@ pixWriteMemSpix(l_uint8  **pdata,
  *            rdatasize (4 bytes) -- size of serialized raster data
  *                                   = 4 * wpl * h
  *            rdata     (rdatasize)
+ *      (2) A view is serialized from a copy, so that only its own
+ *          pixels are written.
  */
 l_int32
 pixSerializeToMemory(PIX        *pixs,
@@ -345,6 +347,7 @@ l_int32    w, h, d, wpl, rdatasize, ncolors, nbytes, index;
 l_uint8   *cdata;  /* data in colormap array (4 bytes/color table entry) */
 l_uint32  *data;
 l_uint32  *rdata;  /* data in pix raster */
+PIX       *pixt;
 PIXCMAP   *cmap;
 
     PROCNAME("pixSerializeToMemory");
@@ -356,6 +359,14 @@ PIXCMAP   *cmap;
     if (!pixs)
         return ERROR_INT("pixs not defined", procName, 1);
 
+    if (pixIsView(pixs)) {
+        if ((pixt = pixCopy(NULL, pixs)) == NULL)
+            return ERROR_INT("pixt not made", procName, 1);
+        index = pixSerializeToMemory(pixt, pdata, pnbytes);
+        pixDestroy(&pixt);
+        return index;
+    }
+
     pixGetDimensions(pixs, &w, &h, &d);
     wpl = pixGetWpl(pixs);
     rdata = pixGetData(pixs);
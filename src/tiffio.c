@@ -44,12 +44,15 @@
  *             l_int32    pixWriteTiffCustom()   [ special top level ]
  *             l_int32    pixWriteStreamTiff()
  *      static l_int32    pixWriteToTiffStream()
+ *      static l_int32    writeTiffHeader()
  *      static l_int32    writeCustomTiffTags()
  *
  *     Reading and writing multipage tiff
  *             PIXA       pixaReadMultipageTiff()
  *             l_int32    writeMultipageTiff()  [ special top level ]
  *             l_int32    writeMultipageTiffSA()
+ *      static l_int32    encodeMultipageTiffPage()
+ *      static l_int32    writeEncodedTiffPage()
  *
  *     Information about tiff file
  *             l_int32    fprintTiffInfo()
@@ -65,6 +68,17 @@
  *
  *     Extraction of tiff g4 data:
  *             l_int32    extractG4DataFromFile()
+ *             l_int32    extractG4DataFromMem()
+ *
+ *     Band reading and writing (see bandio.c)
+ *             l_int32    tiffBandReaderOpen()
+ *             l_int32    tiffBandReaderRead()
+ *             void       tiffBandReaderClose()
+ *             l_int32    tiffBandWriterOpen()
+ *             l_int32    tiffBandWriterWrite()
+ *             l_int32    tiffBandWriterClose()
+ *      static l_int32    tiffDecodeChunk()
+ *      static void       tiffSetRawRow()
  *
  *     Open tiff stream from file stream
  *      static TIFF      *fopenTiff()
@@ -106,6 +120,10 @@
 static const l_int32  DEFAULT_RESOLUTION = 300;   /* ppi */
 static const l_int32  MAX_PAGES_IN_TIFF_FILE = 3000;  /* should be enough */
 
+    /* Number of pages per thread that are encoded before they are
+     * written out, in writeMultipageTiffSA() */
+static const l_int32  MULTIPAGE_BATCH_FACTOR = 4;
+
 
     /* All functions with TIFF interfaces are static. */
 static PIX      *pixReadFromTiffStream(TIFF *tif);
@@ -115,6 +133,8 @@ static l_int32   tiffReadHeaderTiff(TIFF *tif, l_int32 *pwidth,
                                     l_int32 *pheight, l_int32 *pbps,
                                     l_int32 *pspp, l_int32 *pres,
                                     l_int32 *pcmap, l_int32 *pformat);
+static l_int32   writeTiffHeader(TIFF *tif, PIX *pix, l_int32 h,
+                                 l_int32 comptype);
 static l_int32   writeCustomTiffTags(TIFF *tif, NUMA *natags,
                                      SARRAY *savals, SARRAY  *satypes,
                                      NUMA *nasizes);
@@ -127,10 +147,57 @@ static TIFF     *openTiff(const char *filename, const char *modestring);
     /* Static helper for tiff compression type */
 static l_int32   getTiffCompressedFormat(l_uint16 tiffcomp);
 
+    /* Static helpers for multipage writing */
+static l_int32   encodeMultipageTiffPage(void *data, l_int32 i);
+static l_int32   writeEncodedTiffPage(TIFF *tif, PIX *pixh, l_int32 comptype,
+                                      l_uint8 *data, size_t size);
+
+    /* Static helpers for band reading */
+static l_int32   tiffDecodeChunk(L_BANDREADER *br, l_int32 yc);
+static void      tiffSetRawRow(l_uint8 *rawline, l_uint32 *line,
+                               l_int32 nbytes, l_int32 d);
+
     /* Static function for memory I/O */
 static TIFF     *fopenTiffMemstream(const char *filename, const char *operation,
                                     l_uint8 **pdata, size_t *pdatasize);
 
+    /* Input to encodeMultipageTiffPage().  Each call reads and encodes
+     * one page into memory, so that pages can be encoded in parallel.
+     * Only the header of each image is kept in pixh, to be written
+     * with the encoded data when the pages are written out in order. */
+struct MultipageTiffParams
+{
+    SARRAY      *sa;         /* full path names of the images           */
+    l_int32      first;      /* index in sa of the first page in batch  */
+    PIX        **pixh;       /* image header (no data) for each page    */
+    l_int32     *comptype;   /* compression used for each page          */
+    l_uint8    **data;       /* tiff encoded page                       */
+    size_t      *size;       /* size of the encoded page                */
+};
+typedef struct MultipageTiffParams  MULTIPAGE_TIFF_PARAMS;
+
+    /* Decoder and encoder state that is kept between band reads and
+     * writes, in the codec field of the L_BANDREADER and L_BANDWRITER.
+     * For color and tiled images, a strip or a row of tiles is decoded
+     * into pixc, whose first row is image row yc. */
+struct tiff_band_reader {
+    TIFF      *tif;
+    l_int32    invert;     /* photometry requires inversion           */
+    l_int32    tiffbpl;    /* bytes in a tiff scanline                */
+    l_int32    tw;         /* tile width; 0 if not tiled              */
+    l_int32    chunkh;     /* rows decoded at a time; 0 for scanlines */
+    l_int32    yc;         /* first image row in pixc; -1 if none     */
+    l_uint8   *rawbuf;     /* raw scanlines, for spp = 1              */
+    l_uint8   *tilebuf;    /* one raw tile, for spp = 1               */
+    l_uint32  *rgbabuf;    /* one rgba strip or tile, for color       */
+    PIX       *pixc;       /* decoded strip or row of tiles           */
+};
+
+struct tiff_band_writer {
+    TIFF      *tif;
+    l_uint8   *linebuf;    /* one scanline to be encoded              */
+};
+
     /* This structure defines a transform to be performed on a TIFF image
      * (note that the same transformation can be represented in
      * several different ways using this structure since
@@ -818,14 +885,9 @@ pixWriteToTiffStream(TIFF    *tif,
                      NUMA    *nasizes)
 {
 l_uint8   *linebuf, *data;
-l_uint16   redmap[256], greenmap[256], bluemap[256];
-l_int32    w, h, d, i, j, k, wpl, bpl, tiffbpl, ncolors, cmapsize;
-l_int32   *rmap, *gmap, *bmap;
-l_int32    xres, yres;
+l_int32    w, h, d, i, j, k, wpl, bpl, tiffbpl;
 l_uint32  *line, *ppixel;
 PIX       *pixt;
-PIXCMAP   *cmap;
-char      *text;
 
     PROCNAME("pixWriteToTiffStream");
 
@@ -835,12 +897,107 @@ char      *text;
         return ERROR_INT( "pix not defined", procName, 1 );
 
     pixGetDimensions(pix, &w, &h, &d);
+    if (writeTiffHeader(tif, pix, h, comptype))
+        return ERROR_INT("header not written", procName, 1);
+
+        /* This is a no-op if arrays are NULL */
+    writeCustomTiffTags(tif, natags, savals, satypes, nasizes);
+
+        /* ------------- Write out the image data -------------  */
+    tiffbpl = TIFFScanlineSize(tif);
+    wpl = pixGetWpl(pix);
+    bpl = 4 * wpl;
+    if (tiffbpl > bpl)
+        fprintf(stderr, "Big trouble: tiffbpl = %d, bpl = %d\n", tiffbpl, bpl);
+    if ((linebuf = (l_uint8 *)LEPT_CALLOC(1, bpl)) == NULL)
+        return ERROR_INT("calloc fail for linebuf", procName, 1);
+
+        /* Use single strip for image */
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, h);
+
+    if (d != 24 && d != 32) {
+        if (d == 16)
+            pixt = pixEndianTwoByteSwapNew(pix);
+        else
+            pixt = pixEndianByteSwapNew(pix);
+        data = (l_uint8 *)pixGetData(pixt);
+        bpl = 4 * pixGetWpl(pixt);  /* less than for pix if it is a view */
+        for (i = 0; i < h; i++, data += bpl) {
+            memcpy((char *)linebuf, (char *)data, tiffbpl);
+            if (TIFFWriteScanline(tif, linebuf, i, 0) < 0)
+                break;
+        }
+        pixDestroy(&pixt);
+    } else if (d == 24) {  /* See note 4 above: special case of 24 bpp rgb */
+        for (i = 0; i < h; i++) {
+            line = pixGetData(pix) + i * wpl;
+            if (TIFFWriteScanline(tif, (l_uint8 *)line, i, 0) < 0)
+                break;
+        }
+    } else {  /* standard 32 bpp rgb */
+        for (i = 0; i < h; i++) {
+            line = pixGetData(pix) + i * wpl;
+            for (j = 0, k = 0, ppixel = line; j < w; j++) {
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
+                ppixel++;
+            }
+            if (TIFFWriteScanline(tif, linebuf, i, 0) < 0)
+                break;
+        }
+    }
+
+/*    TIFFWriteDirectory(tif); */
+    LEPT_FREE(linebuf);
+
+    return 0;
+}
+
+
+/*!
+ *  writeTiffHeader()
+ *
+ *      Input:  tif (data structure, opened to a file)
+ *              pix (gives the width, depth, colormap, resolution and text)
+ *              h (image height to be written in the header)
+ *              comptype (IFF_TIFF, IFF_TIFF_RLE, IFF_TIFF_PACKBITS,
+ *                        IFF_TIFF_G3, IFF_TIFF_G4,
+ *                        IFF_TIFF_LZW, IFF_TIFF_ZIP)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This sets all the tags of the image directory except for
+ *          the custom tags and the rows per strip.  The height is
+ *          given separately so that the band writer can use the first
+ *          band of the image for @pix.
+ */
+static l_int32
+writeTiffHeader(TIFF    *tif,
+                PIX     *pix,
+                l_int32  h,
+                l_int32  comptype)
+{
+l_uint16   redmap[256], greenmap[256], bluemap[256];
+l_int32    w, d, i, ncolors, cmapsize;
+l_int32   *rmap, *gmap, *bmap;
+l_int32    xres, yres;
+PIXCMAP   *cmap;
+char      *text;
+
+    PROCNAME("writeTiffHeader");
+
+    if (!tif)
+        return ERROR_INT("tif stream not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+
+    pixGetDimensions(pix, &w, NULL, &d);
     xres = pixGetXRes(pix);
     yres = pixGetYRes(pix);
     if (xres == 0) xres = DEFAULT_RESOLUTION;
     if (yres == 0) yres = DEFAULT_RESOLUTION;
 
-        /* ------------------ Write out the header -------------  */
     TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, (l_uint32)RESUNIT_INCH);
     TIFFSetField(tif, TIFFTAG_XRESOLUTION, (l_float64)xres);
     TIFFSetField(tif, TIFFTAG_YRESOLUTION, (l_float64)yres);
@@ -914,56 +1071,6 @@ char      *text;
         TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
     }
 
-        /* This is a no-op if arrays are NULL */
-    writeCustomTiffTags(tif, natags, savals, satypes, nasizes);
-
-        /* ------------- Write out the image data -------------  */
-    tiffbpl = TIFFScanlineSize(tif);
-    wpl = pixGetWpl(pix);
-    bpl = 4 * wpl;
-    if (tiffbpl > bpl)
-        fprintf(stderr, "Big trouble: tiffbpl = %d, bpl = %d\n", tiffbpl, bpl);
-    if ((linebuf = (l_uint8 *)LEPT_CALLOC(1, bpl)) == NULL)
-        return ERROR_INT("calloc fail for linebuf", procName, 1);
-
-        /* Use single strip for image */
-    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, h);
-
-    if (d != 24 && d != 32) {
-        if (d == 16)
-            pixt = pixEndianTwoByteSwapNew(pix);
-        else
-            pixt = pixEndianByteSwapNew(pix);
-        data = (l_uint8 *)pixGetData(pixt);
-        for (i = 0; i < h; i++, data += bpl) {
-            memcpy((char *)linebuf, (char *)data, tiffbpl);
-            if (TIFFWriteScanline(tif, linebuf, i, 0) < 0)
-                break;
-        }
-        pixDestroy(&pixt);
-    } else if (d == 24) {  /* See note 4 above: special case of 24 bpp rgb */
-        for (i = 0; i < h; i++) {
-            line = pixGetData(pix) + i * wpl;
-            if (TIFFWriteScanline(tif, (l_uint8 *)line, i, 0) < 0)
-                break;
-        }
-    } else {  /* standard 32 bpp rgb */
-        for (i = 0; i < h; i++) {
-            line = pixGetData(pix) + i * wpl;
-            for (j = 0, k = 0, ppixel = line; j < w; j++) {
-                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
-                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
-                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
-                ppixel++;
-            }
-            if (TIFFWriteScanline(tif, linebuf, i, 0) < 0)
-                break;
-        }
-    }
-
-/*    TIFFWriteDirectory(tif); */
-    LEPT_FREE(linebuf);
-
     return 0;
 }
 
@@ -1152,6 +1259,10 @@ PIXA    *pixa;
  *          encoded 'g4'.  The rest are encoded as 'zip' (flate encoding).
  *          Because it is lossless, this is an expensive method for
  *          saving most rgb images.
+ *      (4) The images are read and encoded in parallel if more than
+ *          one thread has been set with l_setParallelThreads().  The
+ *          pages are written in order, a batch at a time, so that only
+ *          a few encoded pages are held in memory.
  */
 l_int32
 writeMultipageTiff(const char  *dirin,
@@ -1191,10 +1302,9 @@ l_int32
 writeMultipageTiffSA(SARRAY      *sa,
                      const char  *fileout)
 {
-char        *fname;
-const char  *op;
-l_int32      i, nfiles, firstfile, format;
-PIX         *pix, *pixt;
+l_int32                 i, j, nfiles, nbatch, npages, ret;
+TIFF                   *tif;
+MULTIPAGE_TIFF_PARAMS   params;
 
     PROCNAME("writeMultipageTiffSA");
 
@@ -1204,39 +1314,202 @@ PIX         *pix, *pixt;
         return ERROR_INT("fileout not defined", procName, 1);
 
     nfiles = sarrayGetCount(sa);
-    firstfile = TRUE;
-    for (i = 0; i < nfiles; i++) {
-        op = (firstfile) ? "w" : "a";
-        fname = sarrayGetString(sa, i, L_NOCOPY);
-        findFileFormat(fname, &format);
-        if (format == IFF_UNKNOWN) {
-            L_INFO("format of %s not known\n", procName, fname);
-            continue;
-        }
+    nbatch = MULTIPAGE_BATCH_FACTOR * l_getParallelThreads();
+    nbatch = L_MIN(nbatch, nfiles);
+    if (nbatch == 0)
+        return 0;
+    params.sa = sa;
+    params.pixh = (PIX **)LEPT_CALLOC(nbatch, sizeof(PIX *));
+    params.comptype = (l_int32 *)LEPT_CALLOC(nbatch, sizeof(l_int32));
+    params.data = (l_uint8 **)LEPT_CALLOC(nbatch, sizeof(l_uint8 *));
+    params.size = (size_t *)LEPT_CALLOC(nbatch, sizeof(size_t));
+    if (!params.pixh || !params.comptype || !params.data || !params.size) {
+        LEPT_FREE(params.pixh);
+        LEPT_FREE(params.comptype);
+        LEPT_FREE(params.data);
+        LEPT_FREE(params.size);
+        return ERROR_INT("batch arrays not made", procName, 1);
+    }
 
-        if ((pix = pixRead(fname)) == NULL) {
-            L_WARNING("pix not made for file: %s\n", procName, fname);
-            continue;
-        }
-        if (pixGetDepth(pix) == 1) {
-            pixWriteTiff(fileout, pix, IFF_TIFF_G4, op);
-        } else {
-            if (pixGetColormap(pix)) {
-                pixt = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
-            } else {
-                pixt = pixClone(pix);
+        /* Encode a batch of pages in parallel, and then write them out
+         * in order.  The output file is opened when the first page
+         * is available. */
+    tif = NULL;
+    ret = 0;
+    for (i = 0; i < nfiles; i += nbatch) {
+        npages = L_MIN(nbatch, nfiles - i);
+        params.first = i;
+        l_parallelRun(npages, 0, encodeMultipageTiffPage, &params);
+        for (j = 0; j < npages; j++) {
+            if (params.data[j] && !ret) {
+                if (!tif && (tif = openTiff(fileout, "w")) == NULL) {
+                    L_ERROR("tif not opened for %s\n", procName, fileout);
+                    ret = 1;
+                }
+                if (tif && writeEncodedTiffPage(tif, params.pixh[j],
+                                                params.comptype[j],
+                                                params.data[j],
+                                                params.size[j])) {
+                    L_ERROR("page %d not written\n", procName, i + j);
+                    ret = 1;
+                }
             }
-            pixWriteTiff(fileout, pixt, IFF_TIFF_ZIP, op);
-            pixDestroy(&pixt);
+            pixDestroy(&params.pixh[j]);
+            LEPT_FREE(params.data[j]);
+            params.data[j] = NULL;
         }
-        firstfile = FALSE;
-        pixDestroy(&pix);
     }
+    if (tif)
+        TIFFClose(tif);
+
+    LEPT_FREE(params.pixh);
+    LEPT_FREE(params.comptype);
+    LEPT_FREE(params.data);
+    LEPT_FREE(params.size);
+    return ret;
+}
 
+
+/*!
+ *  encodeMultipageTiffPage()
+ *
+ *      Input:  data (MULTIPAGE_TIFF_PARAMS)
+ *              i (index of the page in the batch)
+ *      Return: 0 always; a page that can't be made is left null
+ *
+ *  Notes:
+ *      (1) This reads the image file for the page, removes any
+ *          colormap if not 1 bpp, and tiff encodes it in memory with
+ *          g4 (1 bpp) or zip (all others).
+ *      (2) If the file can't be read or encoded, the page is skipped,
+ *          leaving params->data[i] null.
+ */
+static l_int32
+encodeMultipageTiffPage(void    *data,
+                        l_int32  i)
+{
+char                   *fname;
+l_int32                 w, h, d, format, comptype, ret;
+PIX                    *pix, *pixt;
+MULTIPAGE_TIFF_PARAMS  *params;
+
+    PROCNAME("encodeMultipageTiffPage");
+
+    params = (MULTIPAGE_TIFF_PARAMS *)data;
+    params->data[i] = NULL;
+    params->pixh[i] = NULL;
+    fname = sarrayGetString(params->sa, params->first + i, L_NOCOPY);
+    findFileFormat(fname, &format);
+    if (format == IFF_UNKNOWN) {
+        L_INFO("format of %s not known\n", procName, fname);
+        return 0;
+    }
+
+    if ((pix = pixRead(fname)) == NULL) {
+        L_WARNING("pix not made for file: %s\n", procName, fname);
+        return 0;
+    }
+    if (pixGetDepth(pix) == 1) {
+        comptype = IFF_TIFF_G4;
+        pixt = pixClone(pix);
+    } else {
+        comptype = IFF_TIFF_ZIP;
+        if (pixGetColormap(pix))
+            pixt = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
+        else
+            pixt = pixClone(pix);
+    }
+    pixDestroy(&pix);
+
+    ret = pixWriteMemTiff(&params->data[i], &params->size[i], pixt,
+                          comptype);
+    if (!ret) {
+        pixGetDimensions(pixt, &w, &h, &d);
+        params->pixh[i] = pixCreateHeader(w, h, d);
+        pixCopyResolution(params->pixh[i], pixt);
+        pixCopyText(params->pixh[i], pixt);
+        pixCopyColormap(params->pixh[i], pixt);
+        params->comptype[i] = comptype;
+    } else {
+        L_ERROR("page for %s not encoded\n", procName, fname);
+        LEPT_FREE(params->data[i]);
+        params->data[i] = NULL;
+    }
+    pixDestroy(&pixt);
     return 0;
 }
 
 
+/*!
+ *  writeEncodedTiffPage()
+ *
+ *      Input:  tif (output stream)
+ *              pixh (header of the image, without data)
+ *              comptype (tiff compression used for the page)
+ *              data (tiff file in memory with the encoded page)
+ *              size (of data)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This adds a page to @tif with the same header as
+ *          pixWriteTiff() would write for the image.  The compressed
+ *          strips are copied from @data without being decoded.
+ */
+static l_int32
+writeEncodedTiffPage(TIFF     *tif,
+                     PIX      *pixh,
+                     l_int32   comptype,
+                     l_uint8  *data,
+                     size_t    size)
+{
+l_uint8   *buf;
+l_int32    ret;
+l_uint32   rowsperstrip;
+tstrip_t   strip, nstrips;
+tsize_t    nbytes, bufsize;
+TIFF      *tifs;
+
+    PROCNAME("writeEncodedTiffPage");
+
+    if ((tifs = fopenTiffMemstream("tifferror", "r", &data, &size)) == NULL)
+        return ERROR_INT("encoded page not opened", procName, 1);
+    if (writeTiffHeader(tif, pixh, pixGetHeight(pixh), comptype)) {
+        TIFFClose(tifs);
+        return ERROR_INT("header not written", procName, 1);
+    }
+    TIFFGetFieldDefaulted(tifs, TIFFTAG_ROWSPERSTRIP, &rowsperstrip);
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rowsperstrip);
+
+    ret = 0;
+    buf = NULL;
+    bufsize = 0;
+    nstrips = TIFFNumberOfStrips(tifs);
+    for (strip = 0; strip < nstrips && !ret; strip++) {
+        nbytes = TIFFRawStripSize(tifs, strip);
+        if (nbytes <= 0) {
+            ret = ERROR_INT("invalid strip size", procName, 1);
+            break;
+        }
+        if (nbytes > bufsize) {
+            LEPT_FREE(buf);
+            bufsize = nbytes;
+            if ((buf = (l_uint8 *)LEPT_CALLOC(bufsize, 1)) == NULL) {
+                ret = ERROR_INT("buf not made", procName, 1);
+                break;
+            }
+        }
+        if (TIFFReadRawStrip(tifs, strip, buf, nbytes) != nbytes ||
+            TIFFWriteRawStrip(tif, strip, buf, nbytes) != nbytes)
+            ret = ERROR_INT("strip not copied", procName, 1);
+    }
+    LEPT_FREE(buf);
+    TIFFClose(tifs);
+    if (!ret && !TIFFWriteDirectory(tif))
+        ret = ERROR_INT("page directory not written", procName, 1);
+    return ret;
+}
+
+
 /*--------------------------------------------------------------*
  *                    Print info to stream                      *
  *--------------------------------------------------------------*/
@@ -1751,13 +2024,9 @@ extractG4DataFromFile(const char  *filein,
                       l_int32     *pminisblack)
 {
 l_uint8  *inarray, *data;
-l_uint16  minisblack, comptype;  /* accessors require l_uint16 */
 l_int32   istiff;
-l_uint32  w, h, rowsperstrip;  /* accessors require l_uint32 */
-l_uint32  diroff;
-size_t    fbytes, nbytes;
+size_t    fbytes, offset, nbytes;
 FILE     *fpin;
-TIFF     *tif;
 
     PROCNAME("extractG4DataFromFile");
 
@@ -1779,15 +2048,92 @@ TIFF     *tif;
 
     if ((inarray = l_binaryRead(filein, &fbytes)) == NULL)
         return ERROR_INT("inarray not made", procName, 1);
+    if (extractG4DataFromMem(inarray, fbytes, &offset, &nbytes,
+                             pw, ph, pminisblack, NULL)) {
+        LEPT_FREE(inarray);
+        return ERROR_INT("g4 data not found", procName, 1);
+    }
+
+    if ((data = (l_uint8 *)LEPT_CALLOC(nbytes, sizeof(l_uint8))) == NULL) {
+        LEPT_FREE(inarray);
+        return ERROR_INT("data not allocated", procName, 1);
+    }
+    memcpy(data, inarray + offset, nbytes);
+    *pdata = data;
+    *pnbytes = nbytes;
+    LEPT_FREE(inarray);
+    return 0;
+}
+
+
+/*!
+ *  extractG4DataFromMem()
+ *
+ *      Input:  cdata (const; tiff g4 encoded)
+ *              size (of cdata)
+ *              &offset (<return> location of the ccitt g4 encoded
+ *                       stream in cdata)
+ *              &nbytes (<return> size of the ccitt g4 encoded stream)
+ *              &w (<return optional> image width)
+ *              &h (<return optional> image height)
+ *              &minisblack (<return optional> boolean)
+ *              &res (<return optional> resolution in x direction,
+ *                    in ppi; 0 if unknown)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The g4 stream is not copied: it is the @nbytes bytes starting
+ *          at @offset in @cdata.  This lets a caller that has written
+ *          the tiff to memory take the stream without another buffer.
+ *      (2) The stream is the block of bytes in the tiff data after the
+ *          8 byte header and before the directory, as it is written
+ *          by libtiff for a single strip.
+ */
+l_int32
+extractG4DataFromMem(const l_uint8  *cdata,
+                     size_t          size,
+                     size_t         *poffset,
+                     size_t         *pnbytes,
+                     l_int32        *pw,
+                     l_int32        *ph,
+                     l_int32        *pminisblack,
+                     l_int32        *pres)
+{
+l_uint8  *data;
+l_uint16  minisblack, comptype;  /* accessors require l_uint16 */
+l_int32   xres, yres;
+l_uint32  w, h, rowsperstrip;  /* accessors require l_uint32 */
+l_uint32  diroff;
+size_t    datasize;
+TIFF     *tif;
+
+    PROCNAME("extractG4DataFromMem");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pminisblack) *pminisblack = 0;
+    if (pres) *pres = 0;
+    if (!poffset || !pnbytes)
+        return ERROR_INT("&offset and &nbytes not both defined", procName, 1);
+    *poffset = 0;
+    *pnbytes = 0;
+    if (!cdata)
+        return ERROR_INT("cdata not defined", procName, 1);
+    if (size < 8 ||
+        !((cdata[0] == 0x4d && cdata[1] == 0x4d) ||
+          (cdata[0] == 0x49 && cdata[1] == 0x49)))
+        return ERROR_INT("cdata not tiff", procName, 1);
 
         /* Get metadata about the image */
-    if ((tif = openTiff(filein, "rb")) == NULL)
-        return ERROR_INT("tif not open for read", procName, 1);
+    data = (l_uint8 *)cdata;  /* we're really not going to change this */
+    datasize = size;
+    if ((tif = fopenTiffMemstream("tifferror", "r", &data, &datasize))
+        == NULL)
+        return ERROR_INT("tiff stream not opened", procName, 1);
     TIFFGetField(tif, TIFFTAG_COMPRESSION, &comptype);
     if (comptype != COMPRESSION_CCITTFAX4) {
-        LEPT_FREE(inarray);
         TIFFClose(tif);
-        return ERROR_INT("filein is not g4 compressed", procName, 1);
+        return ERROR_INT("cdata is not g4 compressed", procName, 1);
     }
 
     TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
@@ -1796,42 +2142,511 @@ TIFF     *tif;
     if (h != rowsperstrip)
         L_WARNING("more than 1 strip\n", procName);
     TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &minisblack);  /* for 1 bpp */
+    getTiffStreamResolution(tif, &xres, &yres);
 /*    TIFFPrintDirectory(tif, stderr, 0); */
     TIFFClose(tif);
     if (pw) *pw = (l_int32)w;
     if (ph) *ph = (l_int32)h;
     if (pminisblack) *pminisblack = (l_int32)minisblack;
+    if (pres) *pres = xres;
 
         /* The header has 8 bytes: the first 2 are the magic number,
          * the next 2 are the version, and the last 4 are the
          * offset to the first directory.  That's what we want here.
          * We have to test the byte order before decoding 4 bytes! */
-    if (inarray[0] == 0x4d) {  /* big-endian */
-        diroff = (inarray[4] << 24) | (inarray[5] << 16) |
-                 (inarray[6] << 8) | inarray[7];
-    } else  {   /* inarray[0] == 0x49 :  little-endian */
-        diroff = (inarray[7] << 24) | (inarray[6] << 16) |
-                 (inarray[5] << 8) | inarray[4];
+    if (cdata[0] == 0x4d) {  /* big-endian */
+        diroff = (cdata[4] << 24) | (cdata[5] << 16) |
+                 (cdata[6] << 8) | cdata[7];
+    } else  {   /* cdata[0] == 0x49 :  little-endian */
+        diroff = (cdata[7] << 24) | (cdata[6] << 16) |
+                 (cdata[5] << 8) | cdata[4];
     }
 /*    fprintf(stderr, " diroff = %d, %x\n", diroff, diroff); */
+    if (diroff <= 8 || diroff > size)
+        return ERROR_INT("invalid directory offset", procName, 1);
 
-        /* Extract the ccittg4 encoded data from the tiff file.
-         * We skip the 8 byte header and take nbytes of data,
+        /* The ccittg4 encoded data follows the 8 byte header,
          * up to the beginning of the directory (at diroff)  */
-    nbytes = diroff - 8;
-    *pnbytes = nbytes;
-    if ((data = (l_uint8 *)LEPT_CALLOC(nbytes, sizeof(l_uint8))) == NULL) {
-        LEPT_FREE(inarray);
-        return ERROR_INT("data not allocated", procName, 1);
+    *poffset = 8;
+    *pnbytes = diroff - 8;
+    return 0;
+}
+
+
+/*--------------------------------------------------------------*
+ *                  Band reading and writing                    *
+ *--------------------------------------------------------------*/
+/*!
+ *  tiffBandReaderOpen()
+ *
+ *      Input:  br (band reader, with the stream at the start of the file)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandReaderCreate().  It reads the tiff
+ *          directory of the first image and sets the image parameters
+ *          in @br.
+ *      (2) The decoded rows are the same as in pixReadFromTiffStream().
+ *          Images with spp = 1 are read by scanline if stored in strips,
+ *          and a row of tiles at a time if tiled.  Color images are read
+ *          a strip or a row of tiles at a time, using the rgba interface.
+ *      (3) Images with an orientation other than ORIENTATION_TOPLEFT
+ *          are not supported; they must be read with pixRead().
+ */
+l_int32
+tiffBandReaderOpen(L_BANDREADER  *br)
+{
+l_uint16                 spp, bps, photometry, tiffcomp, orientation;
+l_uint16                *redmap, *greenmap, *bluemap;
+l_int32                  i, d, ncolors, xres, yres;
+l_uint32                 w, h, tw, th, rowsperstrip;
+PIXCMAP                 *cmap;
+struct tiff_band_reader  *tbr;
+
+    PROCNAME("tiffBandReaderOpen");
+
+    if (!br || !br->fp)
+        return ERROR_INT("br or stream not defined", procName, 1);
+
+    if ((tbr = (struct tiff_band_reader *)LEPT_CALLOC(1,
+               sizeof(struct tiff_band_reader))) == NULL)
+        return ERROR_INT("tbr not made", procName, 1);
+    br->codec = (void *)tbr;
+    if ((tbr->tif = fopenTiff(br->fp, "r")) == NULL)
+        return ERROR_INT("tif not opened", procName, 1);
+
+    TIFFGetFieldDefaulted(tbr->tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    TIFFGetFieldDefaulted(tbr->tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    if (spp == 1)
+        d = bps;
+    else if (spp == 3 || spp == 4)
+        d = 32;
+    else
+        return ERROR_INT("spp not in set {1,3,4}", procName, 1);
+    if (d != 1 && d != 2 && d != 4 && d != 8 && d != 16 && d != 32)
+        return ERROR_INT("invalid depth", procName, 1);
+    if (TIFFGetField(tbr->tif, TIFFTAG_ORIENTATION, &orientation) &&
+        orientation != ORIENTATION_TOPLEFT)
+        return ERROR_INT("orientation not topleft; use pixRead()",
+                         procName, 1);
+    TIFFGetField(tbr->tif, TIFFTAG_IMAGEWIDTH, &w);
+    TIFFGetField(tbr->tif, TIFFTAG_IMAGELENGTH, &h);
+    br->w = w;
+    br->h = h;
+    br->d = d;
+    br->spp = (spp == 1) ? 1 : 3;
+    TIFFGetFieldDefaulted(tbr->tif, TIFFTAG_COMPRESSION, &tiffcomp);
+    br->format = getTiffCompressedFormat(tiffcomp);
+    if (getTiffStreamResolution(tbr->tif, &xres, &yres) == 0) {
+        br->xres = xres;
+        br->yres = yres;
+    }
+
+    if (TIFFGetField(tbr->tif, TIFFTAG_COLORMAP, &redmap, &greenmap,
+                     &bluemap)) {
+        if (bps > 8)
+            return ERROR_INT("invalid bps; > 8", procName, 1);
+        cmap = pixcmapCreate(bps);
+        ncolors = 1 << bps;
+        for (i = 0; i < ncolors; i++)
+            pixcmapAddColor(cmap, redmap[i] >> 8, greenmap[i] >> 8,
+                            bluemap[i] >> 8);
+        br->cmap = cmap;
+    } else {
+        if (!TIFFGetField(tbr->tif, TIFFTAG_PHOTOMETRIC, &photometry)) {
+            if (tiffcomp == COMPRESSION_CCITTFAX3 ||
+                tiffcomp == COMPRESSION_CCITTFAX4 ||
+                tiffcomp == COMPRESSION_CCITTRLE ||
+                tiffcomp == COMPRESSION_CCITTRLEW) {
+                photometry = PHOTOMETRIC_MINISWHITE;
+            } else {
+                photometry = PHOTOMETRIC_MINISBLACK;
+            }
+        }
+        if ((d == 1 && photometry == PHOTOMETRIC_MINISBLACK) ||
+            (d == 8 && photometry == PHOTOMETRIC_MINISWHITE))
+            tbr->invert = 1;
+    }
+
+        /* Set up the buffers for the raw or rgba data */
+    tbr->tiffbpl = TIFFScanlineSize(tbr->tif);
+    if (TIFFIsTiled(tbr->tif)) {
+        TIFFGetField(tbr->tif, TIFFTAG_TILEWIDTH, &tw);
+        TIFFGetField(tbr->tif, TIFFTAG_TILELENGTH, &th);
+        tbr->tw = tw;
+        tbr->chunkh = th;
+        if (spp == 1) {
+            tbr->tilebuf = (l_uint8 *)LEPT_CALLOC(TIFFTileSize(tbr->tif), 1);
+            tbr->rawbuf = (l_uint8 *)LEPT_CALLOC((size_t)th * tbr->tiffbpl,
+                                                 1);
+            if (!tbr->tilebuf || !tbr->rawbuf)
+                return ERROR_INT("tile buffers not made", procName, 1);
+        } else {
+            if ((tbr->rgbabuf = (l_uint32 *)LEPT_CALLOC((size_t)tw * th,
+                                             sizeof(l_uint32))) == NULL)
+                return ERROR_INT("rgba buffer not made", procName, 1);
+        }
+    } else if (spp == 1) {  /* read by scanline */
+        if ((tbr->rawbuf = (l_uint8 *)LEPT_CALLOC(tbr->tiffbpl + 1, 1))
+            == NULL)
+            return ERROR_INT("rawbuf not made", procName, 1);
+    } else {
+        TIFFGetFieldDefaulted(tbr->tif, TIFFTAG_ROWSPERSTRIP, &rowsperstrip);
+        tbr->chunkh = L_MIN(rowsperstrip, h);
+        if ((tbr->rgbabuf = (l_uint32 *)LEPT_CALLOC((size_t)w * tbr->chunkh,
+                                                    sizeof(l_uint32))) == NULL)
+            return ERROR_INT("rgba buffer not made", procName, 1);
+    }
+    if (tbr->chunkh > 0) {
+        if ((tbr->pixc = pixCreate(w, tbr->chunkh, d)) == NULL)
+            return ERROR_INT("pixc not made", procName, 1);
+        tbr->yc = -1;  /* nothing decoded yet */
+    }
+    return 0;
+}
+
+
+/*!
+ *  tiffBandReaderRead()
+ *
+ *      Input:  br
+ *              pixd (band to receive the rows)
+ *              y (first row in pixd to be written)
+ *              nrows (number of rows to decode)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+tiffBandReaderRead(L_BANDREADER  *br,
+                   PIX           *pixd,
+                   l_int32        y,
+                   l_int32        nrows)
+{
+l_int32                  i, n, row, yc, wpl;
+l_uint32                *line;
+struct tiff_band_reader  *tbr;
+
+    PROCNAME("tiffBandReaderRead");
+
+    if (!br || !br->codec)
+        return ERROR_INT("br or codec not defined", procName, 1);
+    if (!pixd)
+        return ERROR_INT("pixd not defined", procName, 1);
+
+    tbr = (struct tiff_band_reader *)br->codec;
+    row = br->nread;  /* image row for pixd row y */
+    if (tbr->chunkh == 0) {  /* spp == 1, in strips */
+        wpl = pixGetWpl(pixd);
+        for (i = 0; i < nrows; i++, row++) {
+            if (TIFFReadScanline(tbr->tif, tbr->rawbuf, row, 0) < 0)
+                return ERROR_INT("line read fail", procName, 1);
+            line = pixGetData(pixd) + (y + i) * wpl;
+            tiffSetRawRow(tbr->rawbuf, line, tbr->tiffbpl, br->d);
+        }
+    } else {  /* copy from the decoded strip or row of tiles */
+        for (i = 0; i < nrows; i += n, row += n) {
+            yc = (row / tbr->chunkh) * tbr->chunkh;
+            if (yc != tbr->yc) {
+                if (tiffDecodeChunk(br, yc))
+                    return ERROR_INT("chunk not decoded", procName, 1);
+            }
+            n = L_MIN(nrows - i, yc + tbr->chunkh - row);
+            pixRasterop(pixd, 0, y + i, br->w, n, PIX_SRC, tbr->pixc,
+                        0, row - yc);
+        }
     }
-    *pdata = data;
-    memcpy(data, inarray + 8, nbytes);
-    LEPT_FREE(inarray);
 
+    if (tbr->invert)
+        pixRasterop(pixd, 0, y, br->w, nrows, PIX_NOT(PIX_DST), NULL, 0, 0);
     return 0;
 }
 
 
+/*!
+ *  tiffBandReaderClose()
+ *
+ *      Input:  br
+ *      Return: void
+ */
+void
+tiffBandReaderClose(L_BANDREADER  *br)
+{
+struct tiff_band_reader  *tbr;
+
+    if (!br || !br->codec)
+        return;
+
+    tbr = (struct tiff_band_reader *)br->codec;
+    if (tbr->tif)
+        TIFFCleanup(tbr->tif);
+    LEPT_FREE(tbr->rawbuf);
+    LEPT_FREE(tbr->tilebuf);
+    LEPT_FREE(tbr->rgbabuf);
+    pixDestroy(&tbr->pixc);
+    LEPT_FREE(tbr);
+    br->codec = NULL;
+    return;
+}
+
+
+/*!
+ *  tiffBandWriterOpen()
+ *
+ *      Input:  bw (band writer)
+ *              pixs (first band of the image)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This is called by bandWriterWrite() for the first band.
+ *          It writes the tiff header, using the height and compression
+ *          in @bw and the width, depth, colormap, resolution and text
+ *          of @pixs.
+ *      (2) Unlike pixWriteStreamTiff(), which uses a single strip,
+ *          the image is written in strips of the default size, so
+ *          that it can also be read back in bounded memory.
+ */
+l_int32
+tiffBandWriterOpen(L_BANDWRITER  *bw,
+                   PIX           *pixs)
+{
+l_int32                  comptype, tiffbpl;
+struct tiff_band_writer  *tbw;
+
+    PROCNAME("tiffBandWriterOpen");
+
+    if (!bw || !bw->fp)
+        return ERROR_INT("bw or stream not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    comptype = bw->format;
+    if (pixGetDepth(pixs) != 1 && comptype != IFF_TIFF &&
+        comptype != IFF_TIFF_LZW && comptype != IFF_TIFF_ZIP) {
+        L_WARNING("invalid compression type for bpp > 1\n", procName);
+        comptype = IFF_TIFF_ZIP;
+    }
+
+    if ((tbw = (struct tiff_band_writer *)LEPT_CALLOC(1,
+               sizeof(struct tiff_band_writer))) == NULL)
+        return ERROR_INT("tbw not made", procName, 1);
+    bw->codec = (void *)tbw;
+    if ((tbw->tif = fopenTiff(bw->fp, "w")) == NULL)
+        return ERROR_INT("tif not opened", procName, 1);
+    if (writeTiffHeader(tbw->tif, pixs, bw->h, comptype))
+        return ERROR_INT("header not written", procName, 1);
+    TIFFSetField(tbw->tif, TIFFTAG_ROWSPERSTRIP,
+                 TIFFDefaultStripSize(tbw->tif, 0));
+
+    tiffbpl = TIFFScanlineSize(tbw->tif);
+    tiffbpl = L_MAX(tiffbpl, 4 * pixGetWpl(pixs));
+    if ((tbw->linebuf = (l_uint8 *)LEPT_CALLOC(tiffbpl, 1)) == NULL)
+        return ERROR_INT("linebuf not made", procName, 1);
+    return 0;
+}
+
+
+/*!
+ *  tiffBandWriterWrite()
+ *
+ *      Input:  bw
+ *              pixs (band to be encoded)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+tiffBandWriterWrite(L_BANDWRITER  *bw,
+                    PIX           *pixs)
+{
+l_int32                  i, j, k, w, h, d, wpl, nbytes;
+l_uint8                 *linebuf;
+l_uint16                *sampbuf;
+l_uint32                *data, *line, *ppixel;
+struct tiff_band_writer  *tbw;
+
+    PROCNAME("tiffBandWriterWrite");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+
+    tbw = (struct tiff_band_writer *)bw->codec;
+    pixGetDimensions(pixs, &w, &h, &d);
+    linebuf = tbw->linebuf;
+    sampbuf = (l_uint16 *)linebuf;
+    nbytes = (w * d + 7) / 8;
+    wpl = pixGetWpl(pixs);
+    data = pixGetData(pixs);
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        if (d == 32) {
+            for (j = 0, k = 0, ppixel = line; j < w; j++, ppixel++) {
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
+                linebuf[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
+            }
+        } else if (d == 16) {  /* tiff samples are in native byte order */
+            for (j = 0; j < w; j++)
+                sampbuf[j] = GET_DATA_TWO_BYTES(line, j);
+        } else {
+            for (j = 0; j < nbytes; j++)
+                linebuf[j] = GET_DATA_BYTE(line, j);
+        }
+        if (TIFFWriteScanline(tbw->tif, linebuf, bw->nwritten + i, 0) < 0)
+            return ERROR_INT("line write fail", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ *  tiffBandWriterClose()
+ *
+ *      Input:  bw
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This flushes the tiff data to the stream.  It returns 1
+ *          if not all rows have been written.
+ */
+l_int32
+tiffBandWriterClose(L_BANDWRITER  *bw)
+{
+struct tiff_band_writer  *tbw;
+
+    PROCNAME("tiffBandWriterClose");
+
+    if (!bw || !bw->codec)
+        return ERROR_INT("bw or codec not defined", procName, 1);
+
+    tbw = (struct tiff_band_writer *)bw->codec;
+    if (tbw->tif)
+        TIFFCleanup(tbw->tif);
+    LEPT_FREE(tbw->linebuf);
+    LEPT_FREE(tbw);
+    bw->codec = NULL;
+    return (bw->nwritten == bw->h) ? 0 : 1;
+}
+
+
+/*!
+ *  tiffDecodeChunk()
+ *
+ *      Input:  br
+ *              yc (first image row of the strip or row of tiles)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This decodes a strip of a color image, or a row of tiles,
+ *          into the pixc buffer of the band reader.  The rgba data
+ *          from libtiff has its origin at the lower left corner of
+ *          each strip or tile.
+ */
+static l_int32
+tiffDecodeChunk(L_BANDREADER  *br,
+                l_int32        yc)
+{
+l_int32                  i, j, x, nrows, ncols, wpl, offset, nbytes;
+l_int32                  rval, gval, bval;
+l_uint32                 tiffword;
+l_uint32                *line, *ppixel, *rgbaline;
+struct tiff_band_reader  *tbr;
+
+    PROCNAME("tiffDecodeChunk");
+
+    tbr = (struct tiff_band_reader *)br->codec;
+    nrows = L_MIN(tbr->chunkh, br->h - yc);
+    wpl = pixGetWpl(tbr->pixc);
+    tbr->yc = -1;
+
+    if (tbr->tw == 0) {  /* color, in strips */
+        if (!TIFFReadRGBAStrip(tbr->tif, yc, (uint32 *)tbr->rgbabuf))
+            return ERROR_INT("rgba strip not read", procName, 1);
+        for (i = 0; i < nrows; i++) {
+            line = pixGetData(tbr->pixc) + i * wpl;
+            rgbaline = tbr->rgbabuf + (nrows - 1 - i) * br->w;
+            for (j = 0, ppixel = line; j < br->w; j++, ppixel++) {
+                tiffword = rgbaline[j];
+                rval = TIFFGetR(tiffword);
+                gval = TIFFGetG(tiffword);
+                bval = TIFFGetB(tiffword);
+                composeRGBPixel(rval, gval, bval, ppixel);
+            }
+        }
+    } else if (br->d == 32) {  /* color, tiled */
+        for (x = 0; x < br->w; x += tbr->tw) {
+            if (!TIFFReadRGBATile(tbr->tif, x, yc, (uint32 *)tbr->rgbabuf))
+                return ERROR_INT("rgba tile not read", procName, 1);
+            ncols = L_MIN(tbr->tw, br->w - x);
+            for (i = 0; i < nrows; i++) {
+                line = pixGetData(tbr->pixc) + i * wpl;
+                rgbaline = tbr->rgbabuf + (tbr->chunkh - 1 - i) * tbr->tw;
+                for (j = 0, ppixel = line + x; j < ncols; j++, ppixel++) {
+                    tiffword = rgbaline[j];
+                    rval = TIFFGetR(tiffword);
+                    gval = TIFFGetG(tiffword);
+                    bval = TIFFGetB(tiffword);
+                    composeRGBPixel(rval, gval, bval, ppixel);
+                }
+            }
+        }
+    } else {  /* spp == 1, tiled; the tile width is a multiple of 16 */
+        for (x = 0; x < br->w; x += tbr->tw) {
+            if (TIFFReadTile(tbr->tif, tbr->tilebuf, x, yc, 0, 0) < 0)
+                return ERROR_INT("tile not read", procName, 1);
+            offset = x * br->d / 8;
+            nbytes = L_MIN(TIFFTileRowSize(tbr->tif), tbr->tiffbpl - offset);
+            for (i = 0; i < nrows; i++) {
+                memcpy(tbr->rawbuf + i * tbr->tiffbpl + offset,
+                       tbr->tilebuf + i * TIFFTileRowSize(tbr->tif), nbytes);
+            }
+        }
+        for (i = 0; i < nrows; i++) {
+            line = pixGetData(tbr->pixc) + i * wpl;
+            tiffSetRawRow(tbr->rawbuf + i * tbr->tiffbpl, line, tbr->tiffbpl,
+                          br->d);
+        }
+    }
+
+    tbr->yc = yc;
+    return 0;
+}
+
+
+/*!
+ *  tiffSetRawRow()
+ *
+ *      Input:  rawline (one row of tiff data, with spp = 1)
+ *              line (of the pix)
+ *              nbytes (in the tiff row)
+ *              d (depth)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Samples of up to 8 bits are packed MSB first in the tiff row,
+ *          and 16 bit samples are in native byte order.  This puts them
+ *          in the pix line without any dependence on the byte order
+ *          of the machine.
+ */
+static void
+tiffSetRawRow(l_uint8   *rawline,
+              l_uint32  *line,
+              l_int32    nbytes,
+              l_int32    d)
+{
+l_int32    j;
+l_uint16  *samples;
+
+    if (d == 16) {
+        samples = (l_uint16 *)rawline;
+        for (j = 0; j < nbytes / 2; j++)
+            SET_DATA_TWO_BYTES(line, j, samples[j]);
+    } else {
+        for (j = 0; j < nbytes; j++)
+            SET_DATA_BYTE(line, j, rawline[j]);
+    }
+    return;
+}
+
+
 /*--------------------------------------------------------------*
  *               Open tiff stream from file stream              *
  *--------------------------------------------------------------*/
@@ -166,6 +166,16 @@ l_int32 extractG4DataFromFile(const char *filein, l_uint8 **pdata,
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 extractG4DataFromMem(const l_uint8 *cdata, size_t size,
+                             size_t *poffset, size_t *pnbytes, l_int32 *pw,
+                             l_int32 *ph, l_int32 *pminisblack,
+                             l_int32 *pres)
+{
+    return ERROR_INT("function not present", "extractG4DataFromMem", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 PIX * pixReadMemTiff(const l_uint8 *cdata, size_t size, l_int32 n)
 {
     return (PIX *)ERROR_PTR("function not present", "pixReadMemTiff", NULL);
@@ -188,6 +198,50 @@ l_int32 pixWriteMemTiffCustom(l_uint8 **pdata, size_t *psize, PIX *pix,
     return ERROR_INT("function not present", "pixWriteMemTiffCustom", 1);
 }
 
+/* ----------------------------------------------------------------------*/
+
+l_int32 tiffBandReaderOpen(L_BANDREADER *br)
+{
+    return ERROR_INT("function not present", "tiffBandReaderOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 tiffBandReaderRead(L_BANDREADER *br, PIX *pixd, l_int32 y,
+                           l_int32 nrows)
+{
+    return ERROR_INT("function not present", "tiffBandReaderRead", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+void tiffBandReaderClose(L_BANDREADER *br)
+{
+    L_ERROR("function not present\n", "tiffBandReaderClose");
+    return;
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 tiffBandWriterOpen(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "tiffBandWriterOpen", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 tiffBandWriterWrite(L_BANDWRITER *bw, PIX *pixs)
+{
+    return ERROR_INT("function not present", "tiffBandWriterWrite", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 tiffBandWriterClose(L_BANDWRITER *bw)
+{
+    return ERROR_INT("function not present", "tiffBandWriterClose", 1);
+}
+
 /* --------------------------------------------*/
 #endif  /* !HAVE_LIBTIFF */
 /* --------------------------------------------*/
@@ -182,6 +182,10 @@
  *         lept_fopen(), lept_fclose(), lept_calloc() and lept_free().
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
 #include <string.h>
 #include <time.h>
 #ifdef _MSC_VER
@@ -205,6 +209,14 @@
 #include <math.h>
 #include <stddef.h>
 
+#if HAVE_LIBPTHREAD
+#include <pthread.h>
+    /* Protects the temp file counter */
+static pthread_mutex_t  temp_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif  /* HAVE_LIBPTHREAD */
+
+    /* Counter that makes temp filenames unique within a process */
+static l_int32  var_TEMP_INDEX = 0;
 
     /* Global for controlling message output at runtime */
 LEPT_DLL l_int32  LeptMsgSeverity = DEFAULT_SEVERITY;
@@ -3036,7 +3048,10 @@ size_t  len;
  *      (3) Specifying the root directory (@dir == "/") is invalid.
  *      (4) Specifying a @tail containing '/' is invalid.
  *      (5) The most general form (@usetime = @usepid = 1) is:
- *              <dir>/<usec>_<pid>_<tail>
+ *              <dir>/<usec>_<pid>_<index>_<tail>
+ *          where <index> is a counter that is incremented on each
+ *          such call, so that names generated by different threads
+ *          in the same microsecond are distinct.
  *          When @usetime = 1, @usepid = 0, the output filename is:
  *              <dir>/<usec>_<tail>
  *          When @usepid = 0, @usepid = 1, the output filename is:
@@ -3069,7 +3084,7 @@ genTempFilename(const char  *dir,
 {
 char     buf[256];
 char    *newpath;
-l_int32  i, buflen, usec, pid, emptytail;
+l_int32  i, buflen, usec, pid, index, emptytail;
 
     PROCNAME("genTempFilename");
 
@@ -3083,15 +3098,26 @@ l_int32  i, buflen, usec, pid, emptytail;
     if (!usetime && !usepid && (!tail || emptytail))
         return (char *)ERROR_PTR("name can't be a directory", procName, NULL);
 
-    if (usepid) pid = getpid();
+    pid = (usepid) ? getpid() : 0;
     buflen = sizeof(buf);
     for (i = 0; i < buflen; i++)
         buf[i] = 0;
     l_getCurrentTime(NULL, &usec);
 
+    index = 0;
+    if (usetime && usepid) {
+#if HAVE_LIBPTHREAD
+        pthread_mutex_lock(&temp_mutex);
+#endif  /* HAVE_LIBPTHREAD */
+        index = var_TEMP_INDEX++;
+#if HAVE_LIBPTHREAD
+        pthread_mutex_unlock(&temp_mutex);
+#endif  /* HAVE_LIBPTHREAD */
+    }
+
     newpath = genPathname(dir, NULL);
     if (usetime && usepid)
-        snprintf(buf, buflen, "%s/%d_%d_", newpath, usec, pid);
+        snprintf(buf, buflen, "%s/%d_%d_%d_", newpath, usec, pid, index);
     else if (usetime)
         snprintf(buf, buflen, "%s/%d_", newpath, usec);
     else if (usepid)